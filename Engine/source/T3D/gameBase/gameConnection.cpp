@@ -38,6 +38,8 @@
 #include "T3D/gameBase/gameConnectionEvents.h"
 #include "console/engineAPI.h"
 #include "math/mTransform.h"
+#include "core/stream/stringCoder.h"
+#include "sim/netBlob.h"
 
 #ifdef TORQUE_HIFI_NET
    #include "T3D/gameBase/hifi/hifiMoveList.h"
@@ -50,9 +52,18 @@
 
 #define ControlRequestTime 5000
 
-const U32 GameConnection::CurrentProtocolVersion = 12;
+const U32 GameConnection::CurrentProtocolVersion = 15;
 const U32 GameConnection::MinRequiredProtocolVersion = 12;
 
+/// First protocol version that negotiates ghost delta compression.
+static const U32 GhostDeltaProtocolVersion = 13;
+
+/// First protocol version that negotiates a string dictionary.
+static const U32 StringDictionaryProtocolVersion = 14;
+
+/// First protocol version that negotiates blob transfers.
+static const U32 BlobTransferProtocolVersion = 15;
+
 //----------------------------------------------------------------------------
 
 IMPLEMENT_CONOBJECT(GameConnection);
@@ -170,6 +181,7 @@ IMPLEMENT_CALLBACK( GameConnection, onFlash, void, (bool state), (state),
 GameConnection::GameConnection()
 {
    mLagging = false;
+   mServerTickAck = 0;
    mControlObject = NULL;
    mCameraObject = NULL;
 
@@ -353,6 +365,12 @@ void GameConnection::writeConnectAccept(BitStream *stream)
 {
    Parent::writeConnectAccept(stream);
    stream->write(getProtocolVersion());
+   if(getProtocolVersion() >= GhostDeltaProtocolVersion)
+      stream->writeFlag(isGhostDeltaCompressed());
+   if(getProtocolVersion() >= StringDictionaryProtocolVersion)
+      stream->writeFlag(getStringDictionary() != NULL);
+   if(getProtocolVersion() >= BlobTransferProtocolVersion)
+      stream->writeFlag(isBlobTransferEnabled());
 }
 
 bool GameConnection::readConnectAccept(BitStream *stream, const char **errorString)
@@ -367,6 +385,21 @@ bool GameConnection::readConnectAccept(BitStream *stream, const char **errorStri
       *errorString = "CHR_PROTOCOL"; // this should never happen unless someone is faking us out.
       return false;
    }
+   setGhostDeltaCompression(protocolVersion >= GhostDeltaProtocolVersion && stream->readFlag());
+
+   // The server only says yes if it has the dictionary we offered.
+   setStringDictionary(NULL);
+   if(protocolVersion >= StringDictionaryProtocolVersion && stream->readFlag())
+   {
+      const StringDictionary *dict = loadStringDictionary();
+      if(!dict)
+      {
+         *errorString = "CHR_PROTOCOL";
+         return false;
+      }
+      setStringDictionary(dict);
+   }
+   setBlobTransfer(protocolVersion >= BlobTransferProtocolVersion && stream->readFlag());
    return true;
 }
 
@@ -381,6 +414,14 @@ void GameConnection::writeConnectRequest(BitStream *stream)
    stream->write(mConnectArgc);
    for(U32 i = 0; i < mConnectArgc; i++)
       stream->writeString(mConnectArgv[i]);
+
+   stream->writeFlag(smGhostDeltaCompression);
+
+   // Offer our string dictionary, if we have one.
+   const StringDictionary *dict = loadStringDictionary();
+   stream->write(dict ? dict->getCRC() : U32(0));
+
+   stream->writeFlag(smBlobTransfer);
 }
 
 bool GameConnection::readConnectRequest(BitStream *stream, const char **errorString)
@@ -438,6 +479,25 @@ bool GameConnection::readConnectRequest(BitStream *stream, const char **errorStr
       mConnectArgv[i] = dStrdup(argString);
       connectArgv[i + 3] = mConnectArgv[i];
    }
+
+   // Older clients don't know about ghost deltas, and there's no
+   // bandwidth to save on a local connection.
+   if(getProtocolVersion() >= GhostDeltaProtocolVersion)
+      setGhostDeltaCompression(stream->readFlag() && smGhostDeltaCompression && !isLocalConnection());
+
+   // Use the client's string dictionary if it is the same as ours.
+   if(getProtocolVersion() >= StringDictionaryProtocolVersion)
+   {
+      U32 crc = 0;
+      stream->read(&crc);
+      const StringDictionary *dict = loadStringDictionary();
+      if(dict && crc == dict->getCRC() && !isLocalConnection())
+         setStringDictionary(dict);
+   }
+
+   // Local clients get the datablocks and ghost always objects directly.
+   if(getProtocolVersion() >= BlobTransferProtocolVersion)
+      setBlobTransfer(stream->readFlag() && smBlobTransfer && !isLocalConnection());
    connectArgv[0] = "onConnectRequest";
    char buffer[256];
    Net::addressToString(getNetAddress(), buffer);
@@ -1098,6 +1158,7 @@ void GameConnection::readPacket(BitStream *bstream)
    else
    {
       mMoveList->serverReadMovePacket(bstream);
+      mMoveList->setClientViewTick(mServerTickAck);
 
       mCameraPos = bstream->readFlag() ? 1.0f : 0.0f;
       if (bstream->readFlag())
@@ -1182,6 +1243,7 @@ void GameConnection::writePacket(BitStream *bstream, PacketNotify *note)
    }
    else
    {
+      gnote->serverTick = ServerProcessList::get()->getTotalTicks();
       mMoveList->serverWriteMovePacket(bstream);
 
       // get the ghost index of the control object, and write out
@@ -1221,9 +1283,15 @@ void GameConnection::writePacket(BitStream *bstream, PacketNotify *note)
 #ifdef TORQUE_NET_STATS
             U32 beginSize = bstream->getBitPosition();
 #endif
-            mControlObject->writePacketData(this, bstream);
+            {
+               PacketWriteLock lock(mControlObject->isThreadSafePack());
+               mControlObject->writePacketData(this, bstream);
+            }
 #ifdef TORQUE_NET_STATS
-            mControlObject->getClassRep()->updateNetStatWriteData(bstream->getBitPosition() - beginSize);
+            {
+               PacketWriteLock lock;
+               mControlObject->getClassRep()->updateNetStatWriteData(bstream->getBitPosition() - beginSize);
+            }
 #endif
             mControlForceMismatch = false;
          }
@@ -1247,6 +1315,7 @@ void GameConnection::writePacket(BitStream *bstream, PacketNotify *note)
          if (bstream->writeFlag(gIndex != -1))
          {
             bstream->writeInt(gIndex, NetConnection::GhostIdBitSize);
+            PacketWriteLock lock(mCameraObject->isThreadSafePack());
             mCameraObject->writePacketData(this, bstream);
          }
       }
@@ -1300,6 +1369,12 @@ GameConnection::GamePacketNotify::GamePacketNotify()
 {
    // need to fill in empty notifes for demo start block
    cameraFov = 0;
+   serverTick = 0;
+}
+
+U32 GameConnection::getClientViewTick() const
+{
+   return mMoveList->getClientViewTick();
 }
 
 NetConnection::PacketNotify *GameConnection::allocNotify()
@@ -1312,8 +1387,13 @@ void GameConnection::packetReceived(PacketNotify *note)
    //record the time so we can tell if we're lagging...
    mLastPacketTime = Sim::getCurrentTime();
 
-   // If we wanted to do something special, we grab our note like this:
-   //GamePacketNotify *gnote = (GamePacketNotify *) note;
+   // The moves that come with this packet were made looking at the
+   // server's state as of this tick.
+   if (!isConnectionToServer())
+   {
+      GamePacketNotify *gnote = (GamePacketNotify *) note;
+      mServerTickAck = gnote->serverTick;
+   }
 
    Parent::packetReceived(note);
 }
@@ -1512,6 +1592,91 @@ void GameConnection::handleConnectionMessage(U32 message, U32 sequence, U32 ghos
    Parent::handleConnectionMessage(message, sequence, ghostCount);
 }
 
+/// The datablock blob last built by sendDataBlockBlob().  Packing a datablock
+/// doesn't depend on the connection, so every client of the same datablock
+/// sequence gets this one until a datablock is added, removed or modified.
+static StrongRefPtr<NetBlob> sDataBlockBlob;
+static U32 sDataBlockBlobSequence = 0;
+static U32 sDataBlockBlobCount = 0;
+static U32 sDataBlockBlobClassGroup = 0;
+static S32 sDataBlockBlobNextKey = -1;
+static S32 sDataBlockBlobMaxKey = 0;
+
+bool GameConnection::sendDataBlockBlob()
+{
+   SimDataBlockGroup *group = Sim::getDataBlockGroup();
+   const U32 count = group->size();
+
+   if(!sDataBlockBlob ||
+      sDataBlockBlobSequence != getDataBlockSequence() ||
+      sDataBlockBlobCount != count ||
+      sDataBlockBlobClassGroup != getNetClassGroup() ||
+      sDataBlockBlobNextKey != SimDataBlock::getNextModifiedKey())
+   {
+      PROFILE_SCOPE(GameConnection_packDataBlockBlob);
+
+      ResizeBitStream stream(Net::MaxPacketDataSize);
+      S32 maxKey = 0;
+      for(U32 i = 0; i < count; i++)
+      {
+         SimDataBlock *block = (SimDataBlock *) (*group)[i];
+         if(block->getModifiedKey() > maxKey)
+            maxKey = block->getModifiedKey();
+
+         stream.writeFlag(true);
+         SimDataBlockEvent event(block, i, count, getDataBlockSequence());
+         event.packDataBlock(this, &stream);
+         stream.validate();
+      }
+      stream.writeFlag(false);
+
+      sDataBlockBlob = NetBlob::create(stream.getBuffer(), stream.getPosition());
+      sDataBlockBlobSequence = getDataBlockSequence();
+      sDataBlockBlobCount = count;
+      sDataBlockBlobClassGroup = getNetClassGroup();
+      sDataBlockBlobNextKey = SimDataBlock::getNextModifiedKey();
+      sDataBlockBlobMaxKey = maxKey;
+   }
+
+   if(!sDataBlockBlob)
+   {
+      Con::warnf("GameConnection::sendDataBlockBlob - datablocks too large for a blob, sending them as events.");
+      return false;
+   }
+
+   const S32 maxKey = getMax(getDataBlockModifiedKey(), sDataBlockBlobMaxKey);
+   setMaxDataBlockModifiedKey(maxKey);
+   setDataBlockModifiedKey(maxKey);
+
+   sendBlob(BlobDataBlocks, getDataBlockSequence(), sDataBlockBlob);
+   return true;
+}
+
+void GameConnection::onBlobReceived(U32 type, U32 sequence, BitStream *stream)
+{
+   if(type != BlobDataBlocks)
+   {
+      Parent::onBlobReceived(type, sequence, stream);
+      return;
+   }
+
+   if(!isConnectionToServer())
+   {
+      setLastError("Invalid packet. (unexpected datablocks)");
+      return;
+   }
+
+   while(stream->readFlag())
+   {
+      SimDataBlockEvent event;
+      event.unpackDataBlock(this, stream);
+      if(mErrorBuffer.isNotEmpty())
+         return;
+      event.process(this);
+   }
+   handleConnectionMessage(DataBlocksDone, sequence, 0);
+}
+
 //----------------------------------------------------------------------------
 
 DefineEngineMethod( GameConnection, transmitDataBlocks, void, (S32 sequence),,
@@ -1634,6 +1799,11 @@ DefineEngineMethod( GameConnection, transmitDataBlocks, void, (S32 sequence),,
             return;
         }
 
+        // Send them all in one blob if the client can take it.  If they
+        // don't fit in one, fall back to the events.
+        if (object->isBlobTransferEnabled() && object->sendDataBlockBlob())
+            return;
+
         // Set the maximum datablock modified key value.
         object->setMaxDataBlockModifiedKey(iKey);
 
@@ -1735,6 +1905,17 @@ DefineEngineMethod( GameConnection, getControlObject, GameBase*, (),,
    return object->getControlObject();
 }
 
+DefineEngineMethod( GameConnection, getClientViewTick, S32, (),,
+   "@brief On the server, returns the server tick the client was looking at when it "
+   "sent the move being processed.\n\n"
+   "Pass it to containerRayCastRewound() to test a shot against where things were "
+   "when the client fired.\n\n"
+   "@return The tick, or 0 if it isn't known.\n\n"
+   "@see containerRayCastRewound()\n\n")
+{
+   return object->getClientViewTick();
+}
+
 DefineEngineMethod( GameConnection, isAIControlled, bool, (),,
    "@brief Returns true if this connection is AI controlled.\n\n"
    "@see AIConnection")
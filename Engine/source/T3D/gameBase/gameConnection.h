@@ -159,6 +159,7 @@ protected:
    struct GamePacketNotify : public NetConnection::PacketNotify
    {
       S32 cameraFov;
+      U32 serverTick;   ///< Server tick the packet was written after.
       GamePacketNotify();
    };
    PacketNotify *allocNotify();
@@ -179,6 +180,9 @@ protected:
    S32         mLastPacketTime;
    bool        mLagging;
 
+   /// Latest server tick the client has acknowledged a packet from.
+   U32         mServerTickAck;
+
    /// @name Flashing
    ////
    /// Note, these variables are not networked, they are for the local connection only.
@@ -211,6 +215,7 @@ protected:
    void ghostPreRead(NetObject *, bool newGhost);
    
    virtual void onEndGhosting();
+   virtual void onBlobReceived(U32 type, U32 sequence, BitStream *stream);
 
 public:
 
@@ -246,6 +251,12 @@ public:
    void setControlObject(GameBase *);
    GameBase* getControlObject() {  return  mControlObject; }
    const GameBase* getControlObject() const {  return  mControlObject; }
+
+   /// On the server, return the server tick the client had heard about
+   /// when it sent the move being processed, which is roughly what it was
+   /// looking at.  0 if not known.
+   /// @see SceneContainer::castRayRewound
+   U32 getClientViewTick() const;
    
    void setCameraObject(GameBase *);
    GameBase* getCameraObject();
@@ -283,6 +294,17 @@ public:
    /// Set the datablock sequence number.
    void setDataBlockSequence(U32 seq) { mDataBlockSequence = seq; }
 
+   /// Send every datablock in one blob instead of as events.
+   ///
+   /// All of them are sent, not just the ones the client hasn't seen, so
+   /// that every client gets the same blob and can keep it from one
+   /// connect to the next.  The blob is packed once and shared by all
+   /// clients of a datablock sequence.
+   ///
+   /// @return False if the datablocks don't fit in a blob, in which case
+   ///   nothing was sent and they have to go out as events.
+   bool sendDataBlockBlob();
+
    /// @}
 
    /// @name Fade control
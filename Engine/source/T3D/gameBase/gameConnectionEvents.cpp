@@ -143,77 +143,86 @@ void SimDataBlockEvent::pack(NetConnection *conn, BitStream *bstream)
       if(obj->getModifiedKey() > gc->getMaxDataBlockModifiedKey())
          gc->setMaxDataBlockModifiedKey(obj->getModifiedKey());
 
-      AssertFatal(obj,
-                  "SimDataBlockEvent:: Data blocks cannot be deleted");
-      bstream->writeInt(id - DataBlockObjectIdFirst,DataBlockObjectIdBitSize);
+      packDataBlock(conn, bstream);
+   }
+}
 
-      S32 classId = obj->getClassId(conn->getNetClassGroup());
-      bstream->writeClassId(classId, NetClassTypeDataBlock, conn->getNetClassGroup());
-      bstream->writeInt(mIndex, DataBlockObjectIdBitSize);
-      bstream->writeInt(mTotal, DataBlockObjectIdBitSize + 1);
-      obj->packData(bstream);
+void SimDataBlockEvent::packDataBlock(NetConnection *conn, BitStream *bstream)
+{
+   SimDataBlock* obj;
+   Sim::findObject(id,obj);
+   AssertFatal(obj,
+               "SimDataBlockEvent:: Data blocks cannot be deleted");
+   bstream->writeInt(id - DataBlockObjectIdFirst,DataBlockObjectIdBitSize);
+
+   S32 classId = obj->getClassId(conn->getNetClassGroup());
+   bstream->writeClassId(classId, NetClassTypeDataBlock, conn->getNetClassGroup());
+   bstream->writeInt(mIndex, DataBlockObjectIdBitSize);
+   bstream->writeInt(mTotal, DataBlockObjectIdBitSize + 1);
+   obj->packData(bstream);
 #ifdef TORQUE_DEBUG_NET
-      bstream->writeInt(classId ^ DebugChecksum, 32);
+   bstream->writeInt(classId ^ DebugChecksum, 32);
 #endif
-   }
 }
 
 void SimDataBlockEvent::unpack(NetConnection *cptr, BitStream *bstream)
 {
    if(bstream->readFlag())
+      unpackDataBlock(cptr, bstream);
+}
+
+void SimDataBlockEvent::unpackDataBlock(NetConnection *cptr, BitStream *bstream)
+{
+   mProcess = true;
+   id = bstream->readInt(DataBlockObjectIdBitSize) + DataBlockObjectIdFirst;
+   S32 classId = bstream->readClassId(NetClassTypeDataBlock, cptr->getNetClassGroup());
+   mIndex = bstream->readInt(DataBlockObjectIdBitSize);
+   mTotal = bstream->readInt(DataBlockObjectIdBitSize + 1);
+   
+   SimObject* ptr;
+   if( Sim::findObject( id, ptr ) )
    {
-      mProcess = true;
-      id = bstream->readInt(DataBlockObjectIdBitSize) + DataBlockObjectIdFirst;
-      S32 classId = bstream->readClassId(NetClassTypeDataBlock, cptr->getNetClassGroup());
-      mIndex = bstream->readInt(DataBlockObjectIdBitSize);
-      mTotal = bstream->readInt(DataBlockObjectIdBitSize + 1);
+      // An object with the given ID already exists.  Make sure it has the right class.
       
-      SimObject* ptr;
-      if( Sim::findObject( id, ptr ) )
+      AbstractClassRep* classRep = AbstractClassRep::findClassRep( cptr->getNetClassGroup(), NetClassTypeDataBlock, classId );
+      if( classRep && dStrcmp( classRep->getClassName(), ptr->getClassName() ) != 0 )
       {
-         // An object with the given ID already exists.  Make sure it has the right class.
-         
-         AbstractClassRep* classRep = AbstractClassRep::findClassRep( cptr->getNetClassGroup(), NetClassTypeDataBlock, classId );
-         if( classRep && dStrcmp( classRep->getClassName(), ptr->getClassName() ) != 0 )
-         {
-            Con::warnf( "A '%s' datablock with id: %d already existed. "
-                        "Clobbering it with new '%s' datablock from server.",
-                        ptr->getClassName(), id, classRep->getClassName() );
-            ptr->deleteObject();
-            ptr = NULL;
-         }
+         Con::warnf( "A '%s' datablock with id: %d already existed. "
+                     "Clobbering it with new '%s' datablock from server.",
+                     ptr->getClassName(), id, classRep->getClassName() );
+         ptr->deleteObject();
+         ptr = NULL;
       }
+   }
+   
+   if( !ptr )
+      ptr = ( SimObject* ) ConsoleObject::create( cptr->getNetClassGroup(), NetClassTypeDataBlock, classId );
       
-      if( !ptr )
-         ptr = ( SimObject* ) ConsoleObject::create( cptr->getNetClassGroup(), NetClassTypeDataBlock, classId );
-         
-      mObj = dynamic_cast< SimDataBlock* >( ptr );
-      if( mObj != NULL )
-      {
-         #ifdef DEBUG_SPEW
-         Con::printf(" - SimDataBlockEvent: unpacking event of type: %s", mObj->getClassName());
-         #endif
-         
-         mObj->unpackData( bstream );
-      }
-      else
-      {
-         #ifdef DEBUG_SPEW
-         Con::printf(" - SimDataBlockEvent: INVALID PACKET!  Could not create class with classID: %d", classId);
-         #endif
-         
-         delete ptr;
-         cptr->setLastError("Invalid packet in SimDataBlockEvent::unpack()");
-      }
+   mObj = dynamic_cast< SimDataBlock* >( ptr );
+   if( mObj != NULL )
+   {
+      #ifdef DEBUG_SPEW
+      Con::printf(" - SimDataBlockEvent: unpacking event of type: %s", mObj->getClassName());
+      #endif
+      
+      mObj->unpackData( bstream );
+   }
+   else
+   {
+      #ifdef DEBUG_SPEW
+      Con::printf(" - SimDataBlockEvent: INVALID PACKET!  Could not create class with classID: %d", classId);
+      #endif
+      
+      delete ptr;
+      cptr->setLastError("Invalid packet in SimDataBlockEvent::unpack()");
+   }
 
 #ifdef TORQUE_DEBUG_NET
-      U32 checksum = bstream->readInt(32);
-      AssertISV( (checksum ^ DebugChecksum) == (U32)classId,
-         avar("unpack did not match pack for event of class %s.",
-            mObj->getClassName()) );
+   U32 checksum = bstream->readInt(32);
+   AssertISV( (checksum ^ DebugChecksum) == (U32)classId,
+      avar("unpack did not match pack for event of class %s.",
+         mObj->getClassName()) );
 #endif
-
-   }
 }
 
 void SimDataBlockEvent::write(NetConnection *cptr, BitStream *bstream)
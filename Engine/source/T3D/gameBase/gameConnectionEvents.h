@@ -93,6 +93,13 @@ class SimDataBlockEvent : public NetEvent
       void unpack(NetConnection *cptr, BitStream *bstream);
       void process(NetConnection*);
       void notifyDelivered(NetConnection *, bool);
+
+      /// Write the datablock without the flag pack() puts in front, so
+      /// that many can be put in one stream for a blob.
+      void packDataBlock(NetConnection *conn, BitStream *bstream);
+
+      /// Read a datablock written by packDataBlock().
+      void unpackDataBlock(NetConnection *cptr, BitStream *bstream);
       
       #ifdef TORQUE_DEBUG_NET
       const char *getDebugName();
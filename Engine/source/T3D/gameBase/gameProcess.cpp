@@ -26,6 +26,7 @@
 #include "T3D/gameBase/gameBase.h"
 #include "T3D/gameBase/gameConnection.h"
 #include "T3D/gameBase/moveList.h"
+#include "scene/sceneContainer.h"
 
 //----------------------------------------------------------------------------
 
@@ -173,6 +174,10 @@ void ServerProcessList::advanceObjects()
 
    Parent::advanceObjects();
 
+   // Remember where everything ended up, for rewound queries against
+   // what clients saw.  Packets written from now on carry this tick.
+   gServerContainer.recordHistory( getTotalTicks() );
+
    #ifdef TORQUE_DEBUG_NET_MOVES
    Con::printf("---------");
    #endif
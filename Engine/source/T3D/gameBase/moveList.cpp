@@ -36,6 +36,7 @@ void MoveList::reset()
    mLastClientMove = 0;
    mFirstMoveIndex = 0;
    mMoveVec.clear();
+   mClientViews.clear();
 }
 
 bool MoveList::getNextMove(Move &curMove)
@@ -221,3 +222,30 @@ void MoveList::readDemoStartBlock(BitStream *stream)
       pushMove(mv);
    }
 }
+
+void MoveList::setClientViewTick(U32 tick)
+{
+   // Forget the views of moves that have been processed.
+   U32 nextMove = mLastMoveAck - mMoveVec.size();
+   while (mClientViews.size() && mClientViews.first().moveEnd <= nextMove)
+      mClientViews.pop_front();
+
+   U32 lastEnd = mClientViews.size() ? mClientViews.last().moveEnd : nextMove;
+   if (mLastMoveAck == lastEnd)
+      return;
+
+   ClientView view;
+   view.moveEnd = mLastMoveAck;
+   view.tick = tick;
+   mClientViews.push_back(view);
+}
+
+U32 MoveList::getClientViewTick() const
+{
+   U32 nextMove = mLastMoveAck - mMoveVec.size();
+   for (U32 i = 0; i < mClientViews.size(); i++)
+      if (mClientViews[i].moveEnd > nextMove)
+         return mClientViews[i].tick;
+
+   return mClientViews.size() ? mClientViews.last().tick : 0;
+}
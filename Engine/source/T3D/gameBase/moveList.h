@@ -95,6 +95,22 @@ public:
 
    void ackMoves( U32 count );
 
+   /// @name Client View
+   /// The server remembers which of its ticks the client had last heard
+   /// about when it sent each move, which is what the client was looking
+   /// at when it made the move.
+   /// @{
+
+   /// Note that the moves read since the last call were sent by a client
+   /// that had heard about server ticks up to the given one.
+   void setClientViewTick( U32 tick );
+
+   /// Return the server tick the client had heard about up to when it sent
+   /// the next move to be processed, or 0 if that isn't known.
+   U32 getClientViewTick() const;
+
+   /// @}
+
 protected:
 
    bool getNextMove( Move &curMove );
@@ -117,6 +133,18 @@ protected:
    GameConnection *mConnection;
 
    Vector<Move> mMoveVec;
+
+   struct ClientView
+   {
+      /// Index just past the last move sent with this view.
+      U32 moveEnd;
+
+      /// Server tick the client had heard about.
+      U32 tick;
+   };
+
+   /// Views of the pending moves, oldest first.
+   Vector<ClientView> mClientViews;
 };
 
 #endif // _MOVELIST_H_
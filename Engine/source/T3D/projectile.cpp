@@ -33,6 +33,8 @@
 #include "core/stream/bitStream.h"
 #include "T3D/fx/explosion.h"
 #include "T3D/shapeBase.h"
+#include "T3D/gameBase/gameConnection.h"
+#include "T3D/gameBase/gameProcess.h"
 #include "ts/tsShapeInstance.h"
 #include "sfx/sfxTrack.h"
 #include "sfx/sfxSource.h"
@@ -174,6 +176,7 @@ ProjectileData::ProjectileData()
    maintainSeq = -1;
 
    gravityMod = 1.0;
+   lagCompensation = false;
    bounceElasticity = 0.999f;
    bounceFriction = 0.3f;
 
@@ -277,6 +280,13 @@ void ProjectileData::initPersistFields()
       "A value of 1.0 will assume \"normal\" influence upon it.\n"
       "The magnitude of gravity is assumed to be 9.81 m/s/s\n\n"
       "@note ProjectileData::isBallistic must be true for this to have any affect.");
+   addField("lagCompensation", TypeBool, Offset(lagCompensation, ProjectileData),
+      "@brief Test hits against where the firing client saw its targets.\n\n"
+      "If the projectile is fired by an object a client controls, the server tests its "
+      "path against shapes where they were when the client fired, up to about a second "
+      "back, instead of where they are now.  This lets players with high latency hit "
+      "what they aimed at.\n\n"
+      "@note This value is never transmitted to the client.");
 
    Parent::initPersistFields();
 }
@@ -558,6 +568,7 @@ Projectile::Projectile()
    mSourceObjectId( -1 ),
    mSourceObjectSlot( -1 ),
    mCurrTick( 0 ),
+   mViewLagTicks( 0 ),
    mParticleEmitter( NULL ),
    mParticleWaterEmitter( NULL ),
    mSound( NULL ),
@@ -568,7 +579,7 @@ Projectile::Projectile()
    mFadeValue( 1.0f )
 {
    // Todo: ScopeAlways?
-   mNetFlags.set(Ghostable);
+   mNetFlags.set(Ghostable | ThreadSafePack);
    mTypeMask |= ProjectileObjectType | LightObjectType | DynamicShapeObjectType;
 
    mLight = LightManager::createLightInfo();
@@ -722,6 +733,17 @@ bool Projectile::onAdd()
       // If we're on the server, we need to inherit some of our parent's velocity
       //
       mCurrTick = 0;
+
+      // Remember how far the firing client's view lagged behind the server,
+      // so our path can be tested against what it saw.
+      GameConnection* client = mSourceObject.isValid() ? mSourceObject->getControllingClient() : NULL;
+      if ( mDataBlock->lagCompensation && client )
+      {
+         U32 tick = ServerProcessList::get()->getTotalTicks();
+         U32 viewTick = client->getClientViewTick();
+         if ( viewTick && viewTick < tick )
+            mViewLagTicks = getMin( tick - viewTick, U32( SceneContainer::HistoryLength ) );
+      }
    }
    else
    {
@@ -1100,6 +1122,8 @@ void Projectile::simulate( F32 dt )
 
    if ( mPhysicsWorld )
       hit = mPhysicsWorld->castRay( oldPosition, newPosition, &rInfo, Point3F( newPosition - oldPosition) * mDataBlock->impactForce );            
+   else if ( mViewLagTicks )
+      hit = getContainer()->castRayRewound(ServerProcessList::get()->getTotalTicks() - mViewLagTicks, oldPosition, newPosition, csmDynamicCollisionMask | csmStaticCollisionMask, &rInfo);
    else 
       hit = getContainer()->castRay(oldPosition, newPosition, csmDynamicCollisionMask | csmStaticCollisionMask, &rInfo);
 
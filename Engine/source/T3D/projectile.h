@@ -92,6 +92,9 @@ public:
    /// Should this projectile fall/rise different than a default object?
    F32 gravityMod;
 
+   /// Should hits be tested against where the firing client saw its targets?
+   bool lagCompensation;
+
    /// How long the projectile should exist before deleting itself
    U32 lifetime;     // all times are internally represented as ticks
    /// How long it should not detonate on impact
@@ -250,6 +253,7 @@ protected:
    // Time related variables common to all projectiles, managed by processTick
    U32 mCurrTick;                         ///< Current time in ticks
    SimObjectPtr<ShapeBase> mSourceObject; ///< Actual pointer to the source object, times out after SourceIdTimeoutTicks
+   U32 mViewLagTicks;                     ///< How far behind the server the firing client's view was, on the server
 
    // Rendering related variables
    TSShapeInstance* mProjectileShape;
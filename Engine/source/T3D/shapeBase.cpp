@@ -914,6 +914,15 @@ ShapeBase::ShapeBase()
 {
    mTypeMask |= ShapeBaseObjectType | LightObjectType;   
 
+   // packUpdate() and writePacketData() only read object state, so packets
+   // may be written on worker threads.  Subclasses that break this must
+   // clear the flag.
+   mNetFlags.set( ThreadSafePack );
+
+   // Keep a history on the server so shots can be tested against where
+   // the shooter saw us.
+   mKeepHistory = true;
+
    S32 i;
 
    for (i = 0; i < MaxSoundThreads; i++) {
@@ -39,6 +39,7 @@
 #include "gfx/gfxTransformSaver.h"
 #include "ts/tsRenderState.h"
 #include "collision/boxConvex.h"
+#include "collision/concretePolyList.h"
 #include "T3D/physics/physicsPlugin.h"
 #include "T3D/physics/physicsBody.h"
 #include "T3D/physics/physicsCollision.h"
@@ -287,6 +288,7 @@ bool TSStatic::_createShape()
    // Cleanup before we create.
    mCollisionDetails.clear();
    mLOSDetails.clear();
+   mOcclusionMesh.clear();
    SAFE_DELETE( mPhysicsRep );
    SAFE_DELETE( mShapeInstance );
    mAmbientThread = NULL;
@@ -326,6 +328,9 @@ bool TSStatic::_createShape()
 
    prepCollision();
 
+   if ( isClientObject() )
+      _buildOcclusionMesh();
+
    // Find the "ambient" animation if it exists
    S32 ambientSeq = mShape->findSequence("ambient");
 
@@ -338,6 +343,39 @@ bool TSStatic::_createShape()
    return true;
 }
 
+void TSStatic::_buildOcclusionMesh()
+{
+   mOcclusionMesh.clear();
+
+   // Detail meshes starting with "Occlusion" are used to
+   // occlude other objects.  Like collision meshes, they
+   // should be given a negative size so they don't render,
+   // and they must lie within the opaque visible geometry.
+
+   S32 occlusionDetail = -1;
+   for ( U32 i = 0; i < mShape->details.size(); i++ )
+   {
+      const String &name = mShape->names[ mShape->details[i].nameIndex ];
+      if ( dStrStartsWith( name, "Occlusion" ) )
+      {
+         occlusionDetail = i;
+         break;
+      }
+   }
+
+   if ( occlusionDetail == -1 )
+      return;
+
+   ConcretePolyList polyList;
+   polyList.setTransform( &MatrixF::Identity, Point3F::One );
+   mShapeInstance->buildPolyList( &polyList, occlusionDetail );
+   polyList.triangulate();
+
+   mOcclusionMesh.reserve( polyList.mIndexList.size() );
+   for ( U32 i = 0; i < polyList.mIndexList.size(); i++ )
+      mOcclusionMesh.push_back( polyList.mVertexList[ polyList.mIndexList[i] ] );
+}
+
 void TSStatic::prepCollision()
 {
    // Let the client know that the collision was updated
@@ -568,6 +606,26 @@ void TSStatic::_renderNormals( ObjectRenderInst *ri, SceneRenderState *state, Ba
    mShapeInstance->renderDebugNormals( mRenderNormalScalar, dl );
 }
 
+void TSStatic::buildOcclusionMesh( Vector<Point3F> &outTriangles )
+{
+   const U32 numPoints = mOcclusionMesh.size();
+   if ( !numPoints )
+      return;
+
+   const MatrixF &mat = getRenderTransform();
+
+   const U32 first = outTriangles.size();
+   outTriangles.setSize( first + numPoints );
+
+   for ( U32 i = 0; i < numPoints; i++ )
+   {
+      Point3F &point = outTriangles[ first + i ];
+      point = mOcclusionMesh[i];
+      point.convolve( mObjScale );
+      mat.mulP( point );
+   }
+}
+
 void TSStatic::onScaleChanged()
 {
    Parent::onScaleChanged();
@@ -120,6 +120,9 @@ protected:
    void buildConvex(const Box3F& box, Convex* convex);
    
    bool _createShape();
+
+   /// Fill in #mOcclusionMesh from the shape's occlusion detail, if it has one.
+   void _buildOcclusionMesh();
    
    void _updatePhysics();
 
@@ -146,6 +149,11 @@ protected:
    Vector<S32> mLOSDetails;
    TSShapeInstance *mShapeInstance;
 
+   /// Object space triangles of the detail named "Occlusion", which the
+   /// shape occludes other objects with.  Only built on the client.
+   /// @see buildOcclusionMesh
+   Vector<Point3F> mOcclusionMesh;
+
    NetStringHandle   mSkinNameHandle;
    String            mAppliedSkinName;
 
@@ -197,6 +205,7 @@ public:
    void onScaleChanged();
    void prepRenderImage( SceneRenderState *state );
    void inspectPostApply();
+   void buildOcclusionMesh( Vector<Point3F> &outTriangles );
 
    /// The type of mesh data use for collision queries.
    MeshType getCollisionType() const { return mCollisionType; }
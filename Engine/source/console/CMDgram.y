@@ -25,7 +25,6 @@ extern int serrors;
 #undef YY_ARGS
 #define YY_ARGS(x)   x
 
-int CMDlex();
 void CMDerror(char *, ...);
 
 #ifdef alloca
@@ -41,6 +40,15 @@ struct Token
 };
 
 %}
+
+/* The parser keeps its state on the stack so that scripts can be parsed
+   on several threads at once.  See CMDscan.l for the scanner side. */
+%define api.pure full
+
+%code provides {
+int CMDlex(YYSTYPE *lvalp);
+}
+
 %{
         /* Reserved Word Definitions */
 %}
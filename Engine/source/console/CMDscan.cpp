@@ -2,6 +2,8 @@
 
 #line 3 "CMDscan.cpp"
 
+#include "platform/platform.h"
+
 #define  YY_INT_ALIGNED short int
 
 /* A lexical scanner generated by flex */
@@ -414,9 +416,9 @@ typedef struct yy_buffer_state *YY_BUFFER_STATE;
 typedef size_t yy_size_t;
 #endif
 
-extern int yyleng;
+extern TORQUE_THREAD_LOCAL int yyleng;
 
-extern FILE *yyin, *yyout;
+extern TORQUE_THREAD_LOCAL FILE *yyin, *yyout;
 
 #define EOB_ACT_CONTINUE_SCAN 0
 #define EOB_ACT_END_OF_FILE 1
@@ -506,9 +508,9 @@ struct yy_buffer_state
 #endif /* !YY_STRUCT_YY_BUFFER_STATE */
 
 /* Stack of input buffers. */
-static size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
-static size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
-static YY_BUFFER_STATE * yy_buffer_stack = NULL; /**< Stack as an array. */
+static TORQUE_THREAD_LOCAL size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
+static TORQUE_THREAD_LOCAL size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
+static TORQUE_THREAD_LOCAL YY_BUFFER_STATE * yy_buffer_stack = NULL; /**< Stack as an array. */
 
 /* We provide macros for accessing buffer states in case in the
  * future we want to put the buffer states in a more general
@@ -525,19 +527,19 @@ static YY_BUFFER_STATE * yy_buffer_stack = NULL; /**< Stack as an array. */
 #define YY_CURRENT_BUFFER_LVALUE (yy_buffer_stack)[(yy_buffer_stack_top)]
 
 /* yy_hold_char holds the character lost when yytext is formed. */
-static char yy_hold_char;
-static int yy_n_chars;		/* number of characters read into yy_ch_buf */
-int yyleng;
+static TORQUE_THREAD_LOCAL char yy_hold_char;
+static TORQUE_THREAD_LOCAL int yy_n_chars;		/* number of characters read into yy_ch_buf */
+TORQUE_THREAD_LOCAL int yyleng;
 
 /* Points to current character in buffer. */
-static char *yy_c_buf_p = NULL;
-static int yy_init = 0;		/* whether we need to initialize */
-static int yy_start = 0;	/* start state number */
+static TORQUE_THREAD_LOCAL char *yy_c_buf_p = NULL;
+static TORQUE_THREAD_LOCAL int yy_init = 0;		/* whether we need to initialize */
+static TORQUE_THREAD_LOCAL int yy_start = 0;	/* start state number */
 
 /* Flag which is used to allow yywrap()'s to do buffer switches
  * instead of setting up a fresh yyin.  A bit of a hack ...
  */
-static int yy_did_buffer_switch_on_eof;
+static TORQUE_THREAD_LOCAL int yy_did_buffer_switch_on_eof;
 
 void yyrestart ( FILE *input_file  );
 void yy_switch_to_buffer ( YY_BUFFER_STATE new_buffer  );
@@ -584,14 +586,14 @@ void yyfree ( void *  );
 /* Begin user sect3 */
 typedef flex_uint8_t YY_CHAR;
 
-FILE *yyin = NULL, *yyout = NULL;
+TORQUE_THREAD_LOCAL FILE *yyin = NULL, *yyout = NULL;
 
 typedef int yy_state_type;
 
-extern int yylineno;
-int yylineno = 1;
+extern TORQUE_THREAD_LOCAL int yylineno;
+TORQUE_THREAD_LOCAL int yylineno = 1;
 
-extern char *yytext;
+extern TORQUE_THREAD_LOCAL char *yytext;
 #ifdef yytext_ptr
 #undef yytext_ptr
 #endif
@@ -861,11 +863,11 @@ static const flex_int16_t yy_chk[449] =
       232,  232,  232,  232,  232,  232,  232,  232
     } ;
 
-static yy_state_type yy_last_accepting_state;
-static char *yy_last_accepting_cpos;
+static TORQUE_THREAD_LOCAL yy_state_type yy_last_accepting_state;
+static TORQUE_THREAD_LOCAL char *yy_last_accepting_cpos;
 
-extern int yy_flex_debug;
-int yy_flex_debug = 0;
+extern TORQUE_THREAD_LOCAL int yy_flex_debug;
+TORQUE_THREAD_LOCAL int yy_flex_debug = 0;
 
 /* The intent behind this definition is that it'll catch
  * any uses of REJECT which flex missed.
@@ -874,11 +876,17 @@ int yy_flex_debug = 0;
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
-char *yytext;
+TORQUE_THREAD_LOCAL char *yytext;
 #line 1 "CMDscan.l"
 #line 2 "CMDscan.l"
 
 // flex --nounput -o CMDscan.cpp -P CMD CMDscan.l
+//
+// Scripts can be compiled on several threads at once, so all scanner state
+// is TORQUE_THREAD_LOCAL.  flex offers no way to ask for that short of
+// %option reentrant, so after regenerating CMDscan.cpp the globals flex
+// declares itself (yy_buffer_stack, yy_c_buf_p, yytext and friends) have to
+// be marked TORQUE_THREAD_LOCAL again by hand.
 
 #define YYLMAX 4096
 #define YY_NO_UNISTD_H
@@ -910,6 +918,10 @@ inline Token< T > MakeToken( T value, U32 lineNumber )
 
 #include "console/cmdgram.h"
 
+// The parser is pure and hands CMDlex() the value to fill in for each token.
+// The rules below fill in this per-thread one, which CMDlex() then copies.
+static TORQUE_THREAD_LOCAL YYSTYPE CMDlval;
+
 using namespace Compiler;
 
 #define YY_NEVER_INTERACTIVE 1
@@ -951,7 +963,7 @@ inline int isatty(int) { return 0; }
    }
    
 // General helper stuff.
-static int lineIndex;
+static TORQUE_THREAD_LOCAL int lineIndex;
 
 // File state
 void CMDSetScanBuffer(const char *sb, const char *fn);
@@ -2675,9 +2687,9 @@ void yyfree (void * ptr )
 #line 223 "CMDscan.l"
 
 
-static const char *scanBuffer;
-static const char *fileName;
-static int scanIndex;
+static TORQUE_THREAD_LOCAL const char *scanBuffer;
+static TORQUE_THREAD_LOCAL const char *fileName;
+static TORQUE_THREAD_LOCAL int scanIndex;
 
 const char * CMDGetCurrentFile()
 {
@@ -2695,6 +2707,11 @@ void CMDerror(char *format, ...)
 {
    Compiler::gSyntaxError = true;
 
+   // Scripts that fail to compile on a worker thread are compiled again by
+   // exec() on the main thread, so leave the error report to that.
+   if(!Con::isMainThread())
+      return;
+
    const int BUFMAX = 1024;
    char tempBuf[BUFMAX];
    va_list args;
@@ -2796,6 +2813,13 @@ int CMDwrap()
    return 1;
 }
 
+int CMDlex(YYSTYPE *lvalp)
+{
+   int token = CMDlex();
+   *lvalp = CMDlval;
+   return token;
+}
+
 static int Sc_ScanVar()
 {
    // Truncate the temp buffer...
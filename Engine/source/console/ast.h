@@ -28,6 +28,11 @@ class Namespace;
 class SimObject;
 class SimGroup;
 
+namespace Compiler
+{
+   struct CompilerLocalTable;
+}
+
 /// Enable this #define if you are seeing the message "precompile size mismatch" in the console.
 /// This will help track down which node type is causing the error. It could be
 /// due to incorrect compiler optimization.
@@ -128,6 +133,7 @@ struct ExprNode : StmtNode
 struct ReturnStmtNode : StmtNode
 {
    ExprNode *expr;
+   TypeReq subType;
 
    static ReturnStmtNode *alloc( S32 lineNumber, ExprNode *expr );
    U32 precompileStmt(U32 loopCount);
@@ -568,6 +574,7 @@ struct FunctionDeclStmtNode : StmtNode
    StringTableEntry package;
    U32 endOffset;
    U32 argc;
+   Compiler::CompilerLocalTable *locals;
 
    static FunctionDeclStmtNode *alloc( S32 lineNumber, StringTableEntry fnName, StringTableEntry nameSpace, VarNode *args, StmtNode *stmts );
    U32 precompileStmt(U32 loopCount);
@@ -576,7 +583,7 @@ struct FunctionDeclStmtNode : StmtNode
    DBG_STMT_TYPE(FunctionDeclStmtNode);
 };
 
-extern StmtNode *gStatementList;
+extern TORQUE_THREAD_LOCAL StmtNode *gStatementList;
 extern void createFunction(const char *fnName, VarNode *args, StmtNode *statements);
 extern ExprEvalState gEvalState;
 extern bool lookupFunction(const char *fnName, VarNode **args, StmtNode **statements);
@@ -425,5 +425,6 @@ FunctionDeclStmtNode *FunctionDeclStmtNode::alloc( S32 lineNumber, StringTableEn
    ret->stmts = stmts;
    ret->nameSpace = nameSpace;
    ret->package = NULL;
+   ret->locals = NULL;
    return ret;
 }
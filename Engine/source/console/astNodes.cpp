@@ -169,6 +169,25 @@ static U32 conversionOp(TypeReq src, TypeReq dst)
    return OP_INVALID;
 }
 
+/// Emit the two words selecting a plain (non-array) variable as the
+/// current variable.  Locals of a function go by their frame slot.
+static U32 compileSetCurVar(U32 *codeStream, U32 ip, StringTableEntry varName, bool create)
+{
+   S32 slot = getLocalSlot(varName);
+   if(slot >= 0)
+   {
+      codeStream[ip++] = create ? OP_SETCURVAR_LOCAL_CREATE : OP_SETCURVAR_LOCAL;
+      codeStream[ip++] = slot;
+   }
+   else
+   {
+      codeStream[ip++] = create ? OP_SETCURVAR_CREATE : OP_SETCURVAR;
+      codeStream[ip] = STEtoU32(varName, ip);
+      ip++;
+   }
+   return ip;
+}
+
 //------------------------------------------------------------
 
 U32 BreakStmtNode::precompileStmt(U32 loopCount)
@@ -178,7 +197,7 @@ U32 BreakStmtNode::precompileStmt(U32 loopCount)
       addBreakCount();
       return 2;
    }
-   Con::warnf(ConsoleLogEntry::General, "%s (%d): break outside of loop... ignoring.", dbgFileName, dbgLineNumber);
+   diagnosticf(ConsoleLogEntry::Warning, "%s (%d): break outside of loop... ignoring.", dbgFileName, dbgLineNumber);
    return 0;
 }
 
@@ -202,7 +221,7 @@ U32 ContinueStmtNode::precompileStmt(U32 loopCount)
       addBreakCount();
       return 2;
    }
-   Con::warnf(ConsoleLogEntry::General, "%s (%d): continue outside of loop... ignoring.", dbgFileName, dbgLineNumber);
+   diagnosticf(ConsoleLogEntry::Warning, "%s (%d): continue outside of loop... ignoring.", dbgFileName, dbgLineNumber);
    return 0;
 }
 
@@ -236,7 +255,15 @@ U32 ExprNode::compileStmt(U32 *codeStream, U32 ip, U32, U32)
 U32 ReturnStmtNode::precompileStmt(U32)
 {
    addBreakCount();
-   return 1 + (expr ? expr->precompile(TypeReqString) : 0);
+   if(!expr)
+      return 1;
+
+   // Numbers are returned as-is; the caller decides whether it needs them
+   // as a string.
+   subType = expr->getPreferredType();
+   if(subType == TypeReqNone)
+      subType = TypeReqString;
+   return 1 + expr->precompile(subType);
 }
 
 U32 ReturnStmtNode::compileStmt(U32 *codeStream, U32 ip, U32, U32)
@@ -246,8 +273,19 @@ U32 ReturnStmtNode::compileStmt(U32 *codeStream, U32 ip, U32, U32)
       codeStream[ip++] = OP_RETURN_VOID;
    else
    {
-      ip = expr->compile(codeStream, ip, TypeReqString);
-      codeStream[ip++] = OP_RETURN;
+      ip = expr->compile(codeStream, ip, subType);
+      switch(subType)
+      {
+      case TypeReqUInt:
+         codeStream[ip++] = OP_RETURN_UINT;
+         break;
+      case TypeReqFloat:
+         codeStream[ip++] = OP_RETURN_FLT;
+         break;
+      default:
+         codeStream[ip++] = OP_RETURN;
+         break;
+      }
    }
    return ip;
 }
@@ -756,7 +794,7 @@ U32 CommaCatExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
 
    // But we're paranoid, so accept (but whine) if we get an oddity...
    if(type == TypeReqUInt || type == TypeReqFloat)
-      Con::warnf(ConsoleLogEntry::General, "%s (%d): converting comma string to a number... probably wrong.", dbgFileName, dbgLineNumber);
+      diagnosticf(ConsoleLogEntry::Warning, "%s (%d): converting comma string to a number... probably wrong.", dbgFileName, dbgLineNumber);
    if(type == TypeReqUInt)
       codeStream[ip++] = OP_STR_TO_UINT;
    else if(type == TypeReqFloat)
@@ -844,10 +882,13 @@ U32 VarNode::precompile(TypeReq type)
    // OP_SETCURVAR
    // varName
    // OP_LOADVAR (type)
+   // (OP_SETCURVAR_LOCAL slot for locals with a frame slot)
    if(type == TypeReqNone)
       return 0;
 
    precompileIdent(varName);
+   if(!arrayIndex)
+      precompileLocal(varName);
    return (arrayIndex ? arrayIndex->precompile(TypeReqString) + 6 : 3);
 }
 
@@ -856,16 +897,18 @@ U32 VarNode::compile(U32 *codeStream, U32 ip, TypeReq type)
    if(type == TypeReqNone)
       return ip;
 
-   codeStream[ip++] = arrayIndex ? OP_LOADIMMED_IDENT : OP_SETCURVAR;
-   codeStream[ip] = STEtoU32(varName, ip);
-   ip++;
    if(arrayIndex)
    {
+      codeStream[ip++] = OP_LOADIMMED_IDENT;
+      codeStream[ip] = STEtoU32(varName, ip);
+      ip++;
       codeStream[ip++] = OP_ADVANCE_STR;
       ip = arrayIndex->compile(codeStream, ip, TypeReqString);
       codeStream[ip++] = OP_REWIND_STR;
       codeStream[ip++] = OP_SETCURVAR_ARRAY;
    }
+   else
+      ip = compileSetCurVar(codeStream, ip, varName, false);
    switch(type)
    {
    case TypeReqUInt:
@@ -1102,6 +1145,7 @@ U32 AssignExprNode::precompile(TypeReq type)
    // eval expr
    // OP_SETCURVAR_CREATE
    // varname
+   // (OP_SETCURVAR_LOCAL_CREATE slot for locals with a frame slot)
    // OP_SAVEVAR
    const U32 addSize = (type != subType ? 1 : 0);
    const U32 retSize = expr->precompile(subType);
@@ -1112,6 +1156,8 @@ U32 AssignExprNode::precompile(TypeReq type)
 #endif
 
    precompileIdent(varName);
+   if(!arrayIndex)
+      precompileLocal(varName);
 
    return retSize + addSize + (arrayIndex ? arrayIndex->precompile(TypeReqString) + (subType == TypeReqString ? 8 : 6 ) : 3);
 }
@@ -1135,11 +1181,7 @@ U32 AssignExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
          codeStream[ip++] = OP_TERMINATE_REWIND_STR;
    }
    else
-   {
-      codeStream[ip++] = OP_SETCURVAR_CREATE;
-      codeStream[ip] = STEtoU32(varName, ip);
-      ip++;
-   }
+      ip = compileSetCurVar(codeStream, ip, varName, true);
    switch(subType)
    {
    case TypeReqString:
@@ -1229,6 +1271,7 @@ U32 AssignOpExprNode::precompile(TypeReq type)
    // else
    // OP_SETCURVAR_CREATE
    // varName
+   // (OP_SETCURVAR_LOCAL_CREATE slot for locals with a frame slot)
 
    // OP_LOADVAR_FLT or UINT
    // operand
@@ -1237,6 +1280,8 @@ U32 AssignOpExprNode::precompile(TypeReq type)
    // conversion OP if necessary.
    getAssignOpTypeOp(op, subType, operand);
    precompileIdent(varName);
+   if(!arrayIndex)
+      precompileLocal(varName);
    U32 size = expr->precompile(subType);
    if(type != subType)
       size++;
@@ -1253,11 +1298,7 @@ U32 AssignOpExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
 {
    ip = expr->compile(codeStream, ip, subType);
    if(!arrayIndex)
-   {
-      codeStream[ip++] = OP_SETCURVAR_CREATE;
-      codeStream[ip] = STEtoU32(varName, ip);
-      ip++;
-   }
+      ip = compileSetCurVar(codeStream, ip, varName, true);
    else
    {
       codeStream[ip++] = OP_LOADIMMED_IDENT;
@@ -1331,16 +1372,37 @@ TypeReq TTagExprNode::getPreferredType()
 
 //------------------------------------------------------------
 
+/// Return the variable node for a plain, non-array variable argument, which
+/// can be pushed with its current type through OP_PUSH_VAR.
+static VarNode *getPlainVarArg(ExprNode *arg)
+{
+   VarNode *var = dynamic_cast<VarNode *>(arg);
+   return (var && !var->arrayIndex) ? var : NULL;
+}
+
+/// Return the type an argument expression is best evaluated as before it
+/// is pushed.  Numbers are pushed without being formatted.
+static TypeReq getArgPushType(ExprNode *arg)
+{
+   TypeReq type = arg->getPreferredType();
+   if(type == TypeReqUInt || type == TypeReqFloat)
+      return type;
+   return TypeReqString;
+}
+
 U32 FuncCallExprNode::precompile(TypeReq type)
 {
    // OP_PUSH_FRAME
    // arg OP_PUSH arg OP_PUSH arg OP_PUSH
    // eval all the args, then call the function.
+   // (numeric args use OP_PUSH_UINT/OP_PUSH_FLT, plain variables
+   // OP_SETCURVAR varName OP_PUSH_VAR)
 
    // OP_CALLFUNC
    // function
    // namespace
    // isDot
+   // call site (lookup cache index)
 
    U32 size = 0;
    if(type != TypeReqString)
@@ -1348,8 +1410,17 @@ U32 FuncCallExprNode::precompile(TypeReq type)
    precompileIdent(funcName);
    precompileIdent(nameSpace);
    for(ExprNode *walk = args; walk; walk = (ExprNode *) walk->getNext())
-      size += walk->precompile(TypeReqString) + 1;
-   return size + 5;
+   {
+      if(VarNode *var = getPlainVarArg(walk))
+      {
+         precompileIdent(var->varName);
+         precompileLocal(var->varName);
+         size += 3;
+      }
+      else
+         size += walk->precompile(getArgPushType(walk)) + 1;
+   }
+   return size + 6;
 }
 
 U32 FuncCallExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
@@ -1357,8 +1428,27 @@ U32 FuncCallExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
    codeStream[ip++] = OP_PUSH_FRAME;
    for(ExprNode *walk = args; walk; walk = (ExprNode *) walk->getNext())
    {
-      ip = walk->compile(codeStream, ip, TypeReqString);
-      codeStream[ip++] = OP_PUSH;
+      if(VarNode *var = getPlainVarArg(walk))
+      {
+         ip = compileSetCurVar(codeStream, ip, var->varName, false);
+         codeStream[ip++] = OP_PUSH_VAR;
+         continue;
+      }
+
+      const TypeReq argType = getArgPushType(walk);
+      ip = walk->compile(codeStream, ip, argType);
+      switch(argType)
+      {
+      case TypeReqUInt:
+         codeStream[ip++] = OP_PUSH_UINT;
+         break;
+      case TypeReqFloat:
+         codeStream[ip++] = OP_PUSH_FLT;
+         break;
+      default:
+         codeStream[ip++] = OP_PUSH;
+         break;
+      }
    }
    if(callType == MethodCall || callType == ParentCall)
       codeStream[ip++] = OP_CALLFUNC;
@@ -1370,6 +1460,7 @@ U32 FuncCallExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
    codeStream[ip] = STEtoU32(nameSpace, ip);
    ip++;
    codeStream[ip++] = callType;
+   codeStream[ip++] = CodeBlock::smCallSiteCount++;
    if(type != TypeReqString)
       codeStream[ip++] = conversionOp(TypeReqString, type);
    return ip;
@@ -1824,7 +1915,8 @@ U32 FunctionDeclStmtNode::precompileStmt(U32)
    // hasBody?
    // func end ip
    // argc
-   // ident array[argc]
+   // local count
+   // ident array[local count] (arguments first)
    // code
    // OP_RETURN_VOID
    setCurrentStringTable(&getFunctionStringTable());
@@ -1839,16 +1931,28 @@ U32 FunctionDeclStmtNode::precompileStmt(U32)
    precompileIdent(fnName);
    precompileIdent(nameSpace);
    precompileIdent(package);
+
+   getLocalTable().reset();
+   for(VarNode *walk = args; walk; walk = (VarNode *)((StmtNode*)walk)->getNext())
+   {
+      precompileIdent(walk->varName);
+      getLocalTable().add(walk->varName, true);
+   }
    
    U32 subSize = precompileBlock(stmts, 0);
    CodeBlock::smInFunction = false;
 
+   // Keep the slots for the compile pass.
+   locals = (CompilerLocalTable *) consoleAlloc(sizeof(CompilerLocalTable));
+   *locals = getLocalTable();
+   getLocalTable().reset();
+
    addBreakCount();
 
    setCurrentStringTable(&getGlobalStringTable());
    setCurrentFloatTable(&getGlobalFloatTable());
 
-   endOffset = argc + subSize + 8;
+   endOffset = locals->count + subSize + 9;
    return endOffset;
 }
 
@@ -1865,13 +1969,16 @@ U32 FunctionDeclStmtNode::compileStmt(U32 *codeStream, U32 ip, U32, U32)
    codeStream[ip++] = U32( bool(stmts != NULL) ? 1 : 0 ) + U32( dbgLineNumber << 1 );
    codeStream[ip++] = start + endOffset;
    codeStream[ip++] = argc;
-   for(VarNode *walk = args; walk; walk = (VarNode *)((StmtNode*)walk)->getNext())
+   codeStream[ip++] = locals->count;
+   for(CompilerLocalTable::Entry *walk = locals->list; walk; walk = walk->next)
    {
-      codeStream[ip] = STEtoU32(walk->varName, ip);
+      codeStream[ip] = STEtoU32(walk->name, ip);
       ip++;
    }
    CodeBlock::smInFunction = true;
+   getLocalTable() = *locals;
    ip = compileBlock(stmts, codeStream, ip, 0, 0); 
+   getLocalTable().reset();
 
    // Add break so breakpoint can be set at closing brace or
    // in empty function.
@@ -55,7 +55,7 @@
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -70,8 +70,6 @@
 #define yyerror         CMDerror
 #define yydebug         CMDdebug
 #define yynerrs         CMDnerrs
-#define yylval          CMDlval
-#define yychar          CMDchar
 
 /* First part of user prologue.  */
 #line 1 "CMDgram.y"
@@ -102,7 +100,6 @@ extern int serrors;
 #undef YY_ARGS
 #define YY_ARGS(x)   x
 
-int CMDlex();
 void CMDerror(char *, ...);
 
 #ifdef alloca
@@ -117,17 +114,17 @@ struct Token
    U32 lineNumber;
 };
 
-#line 44 "CMDgram.y"
+#line 52 "CMDgram.y"
 
         /* Reserved Word Definitions */
-#line 55 "CMDgram.y"
+#line 63 "CMDgram.y"
 
         /* Constants and Identifier Definitions */
-#line 69 "CMDgram.y"
+#line 77 "CMDgram.y"
 
         /* Operator Definitions */
 
-#line 131 "cmdgram.cpp"
+#line 128 "cmdgram.cpp"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -688,23 +685,23 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,   161,   161,   167,   168,   173,   175,   177,   182,   187,
-     189,   195,   196,   201,   202,   203,   204,   205,   206,   207,
-     209,   211,   213,   215,   217,   219,   221,   226,   228,   234,
-     235,   240,   242,   247,   252,   254,   256,   258,   260,   262,
-     268,   269,   275,   276,   282,   283,   289,   290,   292,   294,
-     299,   301,   306,   308,   313,   315,   320,   322,   324,   329,
-     331,   336,   338,   343,   345,   350,   352,   354,   356,   358,
-     360,   362,   364,   369,   371,   376,   381,   383,   385,   387,
-     389,   391,   393,   395,   397,   399,   401,   403,   405,   407,
-     409,   411,   413,   415,   417,   419,   421,   423,   425,   427,
-     429,   431,   433,   435,   437,   439,   441,   443,   445,   447,
-     449,   451,   453,   455,   457,   462,   464,   469,   471,   476,
-     478,   483,   485,   487,   489,   491,   493,   495,   497,   499,
-     501,   503,   505,   510,   512,   514,   516,   518,   520,   522,
-     524,   526,   528,   533,   535,   537,   542,   544,   550,   551,
-     556,   558,   564,   565,   570,   572,   577,   579,   581,   583,
-     585,   590,   592
+       0,   169,   169,   175,   176,   181,   183,   185,   190,   195,
+     197,   203,   204,   209,   210,   211,   212,   213,   214,   215,
+     217,   219,   221,   223,   225,   227,   229,   234,   236,   242,
+     243,   248,   250,   255,   260,   262,   264,   266,   268,   270,
+     276,   277,   283,   284,   290,   291,   297,   298,   300,   302,
+     307,   309,   314,   316,   321,   323,   328,   330,   332,   337,
+     339,   344,   346,   351,   353,   358,   360,   362,   364,   366,
+     368,   370,   372,   377,   379,   384,   389,   391,   393,   395,
+     397,   399,   401,   403,   405,   407,   409,   411,   413,   415,
+     417,   419,   421,   423,   425,   427,   429,   431,   433,   435,
+     437,   439,   441,   443,   445,   447,   449,   451,   453,   455,
+     457,   459,   461,   463,   465,   470,   472,   477,   479,   484,
+     486,   491,   493,   495,   497,   499,   501,   503,   505,   507,
+     509,   511,   513,   518,   520,   522,   524,   526,   528,   530,
+     532,   534,   536,   541,   543,   545,   550,   552,   558,   559,
+     564,   566,   572,   573,   578,   580,   585,   587,   589,   591,
+     593,   598,   600
 };
 #endif
 
@@ -1747,13 +1744,6 @@ yydestruct (const char *yymsg,
 }
 
 
-/* Lookahead token kind.  */
-int yychar;
-
-/* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
-/* Number of syntax errors so far.  */
-int yynerrs;
 
 
 
@@ -1765,6 +1755,19 @@ int yynerrs;
 int
 yyparse (void)
 {
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
+
     yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
     int yyerrstatus = 0;
@@ -1917,7 +1920,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token\n"));
-      yychar = yylex ();
+      yychar = yylex (&yylval);
     }
 
   if (yychar <= YYEOF)
@@ -2005,937 +2008,937 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* start: decl_list  */
-#line 162 "CMDgram.y"
+#line 170 "CMDgram.y"
       { }
-#line 2011 "cmdgram.cpp"
+#line 2014 "cmdgram.cpp"
     break;
 
   case 3: /* decl_list: %empty  */
-#line 167 "CMDgram.y"
+#line 175 "CMDgram.y"
       { (yyval.stmt) = nil; }
-#line 2017 "cmdgram.cpp"
+#line 2020 "cmdgram.cpp"
     break;
 
   case 4: /* decl_list: decl_list decl  */
-#line 169 "CMDgram.y"
+#line 177 "CMDgram.y"
       { if(!gStatementList) { gStatementList = (yyvsp[0].stmt); } else { gStatementList->append((yyvsp[0].stmt)); } }
-#line 2023 "cmdgram.cpp"
+#line 2026 "cmdgram.cpp"
     break;
 
   case 5: /* decl: stmt  */
-#line 174 "CMDgram.y"
+#line 182 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[0].stmt); }
-#line 2029 "cmdgram.cpp"
+#line 2032 "cmdgram.cpp"
     break;
 
   case 6: /* decl: fn_decl_stmt  */
-#line 176 "CMDgram.y"
+#line 184 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[0].stmt); }
-#line 2035 "cmdgram.cpp"
+#line 2038 "cmdgram.cpp"
     break;
 
   case 7: /* decl: package_decl  */
-#line 178 "CMDgram.y"
+#line 186 "CMDgram.y"
      { (yyval.stmt) = (yyvsp[0].stmt); }
-#line 2041 "cmdgram.cpp"
+#line 2044 "cmdgram.cpp"
     break;
 
   case 8: /* package_decl: rwPACKAGE IDENT '{' fn_decl_list '}' ';'  */
-#line 183 "CMDgram.y"
+#line 191 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[-2].stmt); for(StmtNode *walk = ((yyvsp[-2].stmt));walk;walk = walk->getNext() ) walk->setPackage((yyvsp[-4].s).value); }
-#line 2047 "cmdgram.cpp"
+#line 2050 "cmdgram.cpp"
     break;
 
   case 9: /* fn_decl_list: fn_decl_stmt  */
-#line 188 "CMDgram.y"
+#line 196 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[0].stmt); }
-#line 2053 "cmdgram.cpp"
+#line 2056 "cmdgram.cpp"
     break;
 
   case 10: /* fn_decl_list: fn_decl_list fn_decl_stmt  */
-#line 190 "CMDgram.y"
+#line 198 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[-1].stmt); ((yyvsp[-1].stmt))->append((yyvsp[0].stmt));  }
-#line 2059 "cmdgram.cpp"
+#line 2062 "cmdgram.cpp"
     break;
 
   case 11: /* statement_list: %empty  */
-#line 195 "CMDgram.y"
+#line 203 "CMDgram.y"
       { (yyval.stmt) = nil; }
-#line 2065 "cmdgram.cpp"
+#line 2068 "cmdgram.cpp"
     break;
 
   case 12: /* statement_list: statement_list stmt  */
-#line 197 "CMDgram.y"
+#line 205 "CMDgram.y"
       { if(!(yyvsp[-1].stmt)) { (yyval.stmt) = (yyvsp[0].stmt); } else { ((yyvsp[-1].stmt))->append((yyvsp[0].stmt)); (yyval.stmt) = (yyvsp[-1].stmt); } }
-#line 2071 "cmdgram.cpp"
+#line 2074 "cmdgram.cpp"
     break;
 
   case 19: /* stmt: rwBREAK ';'  */
-#line 208 "CMDgram.y"
+#line 216 "CMDgram.y"
       { (yyval.stmt) = BreakStmtNode::alloc( (yyvsp[-1].i).lineNumber ); }
-#line 2077 "cmdgram.cpp"
+#line 2080 "cmdgram.cpp"
     break;
 
   case 20: /* stmt: rwCONTINUE ';'  */
-#line 210 "CMDgram.y"
+#line 218 "CMDgram.y"
       { (yyval.stmt) = ContinueStmtNode::alloc( (yyvsp[-1].i).lineNumber ); }
-#line 2083 "cmdgram.cpp"
+#line 2086 "cmdgram.cpp"
     break;
 
   case 21: /* stmt: rwRETURN ';'  */
-#line 212 "CMDgram.y"
+#line 220 "CMDgram.y"
       { (yyval.stmt) = ReturnStmtNode::alloc( (yyvsp[-1].i).lineNumber, NULL ); }
-#line 2089 "cmdgram.cpp"
+#line 2092 "cmdgram.cpp"
     break;
 
   case 22: /* stmt: rwRETURN expr ';'  */
-#line 214 "CMDgram.y"
+#line 222 "CMDgram.y"
       { (yyval.stmt) = ReturnStmtNode::alloc( (yyvsp[-2].i).lineNumber, (yyvsp[-1].expr) ); }
-#line 2095 "cmdgram.cpp"
+#line 2098 "cmdgram.cpp"
     break;
 
   case 23: /* stmt: expression_stmt ';'  */
-#line 216 "CMDgram.y"
+#line 224 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[-1].stmt); }
-#line 2101 "cmdgram.cpp"
+#line 2104 "cmdgram.cpp"
     break;
 
   case 24: /* stmt: TTAG '=' expr ';'  */
-#line 218 "CMDgram.y"
+#line 226 "CMDgram.y"
       { (yyval.stmt) = TTagSetStmtNode::alloc( (yyvsp[-3].s).lineNumber, (yyvsp[-3].s).value, (yyvsp[-1].expr), NULL ); }
-#line 2107 "cmdgram.cpp"
+#line 2110 "cmdgram.cpp"
     break;
 
   case 25: /* stmt: TTAG '=' expr ',' expr ';'  */
-#line 220 "CMDgram.y"
+#line 228 "CMDgram.y"
       { (yyval.stmt) = TTagSetStmtNode::alloc( (yyvsp[-5].s).lineNumber, (yyvsp[-5].s).value, (yyvsp[-3].expr), (yyvsp[-1].expr) ); }
-#line 2113 "cmdgram.cpp"
+#line 2116 "cmdgram.cpp"
     break;
 
   case 26: /* stmt: DOCBLOCK  */
-#line 222 "CMDgram.y"
+#line 230 "CMDgram.y"
       { (yyval.stmt) = StrConstNode::alloc( (yyvsp[0].str).lineNumber, (yyvsp[0].str).value, false, true ); }
-#line 2119 "cmdgram.cpp"
+#line 2122 "cmdgram.cpp"
     break;
 
   case 27: /* fn_decl_stmt: rwDEFINE IDENT '(' var_list_decl ')' '{' statement_list '}'  */
-#line 227 "CMDgram.y"
+#line 235 "CMDgram.y"
       { (yyval.stmt) = FunctionDeclStmtNode::alloc( (yyvsp[-7].i).lineNumber, (yyvsp[-6].s).value, NULL, (yyvsp[-4].var), (yyvsp[-1].stmt) ); }
-#line 2125 "cmdgram.cpp"
+#line 2128 "cmdgram.cpp"
     break;
 
   case 28: /* fn_decl_stmt: rwDEFINE IDENT opCOLONCOLON IDENT '(' var_list_decl ')' '{' statement_list '}'  */
-#line 229 "CMDgram.y"
+#line 237 "CMDgram.y"
      { (yyval.stmt) = FunctionDeclStmtNode::alloc( (yyvsp[-9].i).lineNumber, (yyvsp[-6].s).value, (yyvsp[-8].s).value, (yyvsp[-4].var), (yyvsp[-1].stmt) ); }
-#line 2131 "cmdgram.cpp"
+#line 2134 "cmdgram.cpp"
     break;
 
   case 29: /* var_list_decl: %empty  */
-#line 234 "CMDgram.y"
+#line 242 "CMDgram.y"
      { (yyval.var) = NULL; }
-#line 2137 "cmdgram.cpp"
+#line 2140 "cmdgram.cpp"
     break;
 
   case 30: /* var_list_decl: var_list  */
-#line 236 "CMDgram.y"
+#line 244 "CMDgram.y"
      { (yyval.var) = (yyvsp[0].var); }
-#line 2143 "cmdgram.cpp"
+#line 2146 "cmdgram.cpp"
     break;
 
   case 31: /* var_list: VAR  */
-#line 241 "CMDgram.y"
+#line 249 "CMDgram.y"
       { (yyval.var) = VarNode::alloc( (yyvsp[0].s).lineNumber, (yyvsp[0].s).value, NULL ); }
-#line 2149 "cmdgram.cpp"
+#line 2152 "cmdgram.cpp"
     break;
 
   case 32: /* var_list: var_list ',' VAR  */
-#line 243 "CMDgram.y"
+#line 251 "CMDgram.y"
       { (yyval.var) = (yyvsp[-2].var); ((StmtNode*)((yyvsp[-2].var)))->append((StmtNode*)VarNode::alloc( (yyvsp[0].s).lineNumber, (yyvsp[0].s).value, NULL ) ); }
-#line 2155 "cmdgram.cpp"
+#line 2158 "cmdgram.cpp"
     break;
 
   case 33: /* datablock_decl: rwDATABLOCK class_name_expr '(' expr parent_block ')' '{' slot_assign_list_opt '}' ';'  */
-#line 248 "CMDgram.y"
+#line 256 "CMDgram.y"
       { (yyval.stmt) = ObjectDeclNode::alloc( (yyvsp[-9].i).lineNumber, (yyvsp[-8].expr), (yyvsp[-6].expr), NULL, (yyvsp[-5].s).value, (yyvsp[-2].slist), NULL, true, false, false); }
-#line 2161 "cmdgram.cpp"
+#line 2164 "cmdgram.cpp"
     break;
 
   case 34: /* object_decl: rwDECLARE class_name_expr '(' object_name parent_block object_args ')' '{' object_declare_block '}'  */
-#line 253 "CMDgram.y"
+#line 261 "CMDgram.y"
       { (yyval.od) = ObjectDeclNode::alloc( (yyvsp[-9].i).lineNumber, (yyvsp[-8].expr), (yyvsp[-6].expr), (yyvsp[-4].expr), (yyvsp[-5].s).value, (yyvsp[-1].odcl).slots, (yyvsp[-1].odcl).decls, false, false, false); }
-#line 2167 "cmdgram.cpp"
+#line 2170 "cmdgram.cpp"
     break;
 
   case 35: /* object_decl: rwDECLARE class_name_expr '(' object_name parent_block object_args ')'  */
-#line 255 "CMDgram.y"
+#line 263 "CMDgram.y"
       { (yyval.od) = ObjectDeclNode::alloc( (yyvsp[-6].i).lineNumber, (yyvsp[-5].expr), (yyvsp[-3].expr), (yyvsp[-1].expr), (yyvsp[-2].s).value, NULL, NULL, false, false, false); }
-#line 2173 "cmdgram.cpp"
+#line 2176 "cmdgram.cpp"
     break;
 
   case 36: /* object_decl: rwDECLARE class_name_expr '(' '[' object_name ']' parent_block object_args ')' '{' object_declare_block '}'  */
-#line 257 "CMDgram.y"
+#line 265 "CMDgram.y"
       { (yyval.od) = ObjectDeclNode::alloc( (yyvsp[-11].i).lineNumber, (yyvsp[-10].expr), (yyvsp[-7].expr), (yyvsp[-4].expr), (yyvsp[-5].s).value, (yyvsp[-1].odcl).slots, (yyvsp[-1].odcl).decls, false, true, false); }
-#line 2179 "cmdgram.cpp"
+#line 2182 "cmdgram.cpp"
     break;
 
   case 37: /* object_decl: rwDECLARE class_name_expr '(' '[' object_name ']' parent_block object_args ')'  */
-#line 259 "CMDgram.y"
+#line 267 "CMDgram.y"
       { (yyval.od) = ObjectDeclNode::alloc( (yyvsp[-8].i).lineNumber, (yyvsp[-7].expr), (yyvsp[-4].expr), (yyvsp[-1].expr), (yyvsp[-2].s).value, NULL, NULL, false, true, false); }
-#line 2185 "cmdgram.cpp"
+#line 2188 "cmdgram.cpp"
     break;
 
   case 38: /* object_decl: rwDECLARESINGLETON class_name_expr '(' object_name parent_block object_args ')' '{' object_declare_block '}'  */
-#line 261 "CMDgram.y"
+#line 269 "CMDgram.y"
       { (yyval.od) = ObjectDeclNode::alloc( (yyvsp[-9].i).lineNumber, (yyvsp[-8].expr), (yyvsp[-6].expr), (yyvsp[-4].expr), (yyvsp[-5].s).value, (yyvsp[-1].odcl).slots, (yyvsp[-1].odcl).decls, false, false, true); }
-#line 2191 "cmdgram.cpp"
+#line 2194 "cmdgram.cpp"
     break;
 
   case 39: /* object_decl: rwDECLARESINGLETON class_name_expr '(' object_name parent_block object_args ')'  */
-#line 263 "CMDgram.y"
+#line 271 "CMDgram.y"
       { (yyval.od) = ObjectDeclNode::alloc( (yyvsp[-6].i).lineNumber, (yyvsp[-5].expr), (yyvsp[-3].expr), (yyvsp[-1].expr), (yyvsp[-2].s).value, NULL, NULL, false, false, true); }
-#line 2197 "cmdgram.cpp"
+#line 2200 "cmdgram.cpp"
     break;
 
   case 40: /* parent_block: %empty  */
-#line 268 "CMDgram.y"
+#line 276 "CMDgram.y"
       { (yyval.s).value = NULL; }
-#line 2203 "cmdgram.cpp"
+#line 2206 "cmdgram.cpp"
     break;
 
   case 41: /* parent_block: ':' IDENT  */
-#line 270 "CMDgram.y"
+#line 278 "CMDgram.y"
       { (yyval.s) = (yyvsp[0].s); }
-#line 2209 "cmdgram.cpp"
+#line 2212 "cmdgram.cpp"
     break;
 
   case 42: /* object_name: %empty  */
-#line 275 "CMDgram.y"
+#line 283 "CMDgram.y"
       { (yyval.expr) = StrConstNode::alloc( CodeBlock::smCurrentParser->getCurrentLine(), "", false); }
-#line 2215 "cmdgram.cpp"
+#line 2218 "cmdgram.cpp"
     break;
 
   case 43: /* object_name: expr  */
-#line 277 "CMDgram.y"
+#line 285 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr); }
-#line 2221 "cmdgram.cpp"
+#line 2224 "cmdgram.cpp"
     break;
 
   case 44: /* object_args: %empty  */
-#line 282 "CMDgram.y"
+#line 290 "CMDgram.y"
       { (yyval.expr) = NULL; }
-#line 2227 "cmdgram.cpp"
+#line 2230 "cmdgram.cpp"
     break;
 
   case 45: /* object_args: ',' expr_list  */
-#line 284 "CMDgram.y"
+#line 292 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr); }
-#line 2233 "cmdgram.cpp"
+#line 2236 "cmdgram.cpp"
     break;
 
   case 46: /* object_declare_block: %empty  */
-#line 289 "CMDgram.y"
+#line 297 "CMDgram.y"
       { (yyval.odcl).slots = NULL; (yyval.odcl).decls = NULL; }
-#line 2239 "cmdgram.cpp"
+#line 2242 "cmdgram.cpp"
     break;
 
   case 47: /* object_declare_block: slot_assign_list  */
-#line 291 "CMDgram.y"
+#line 299 "CMDgram.y"
       { (yyval.odcl).slots = (yyvsp[0].slist); (yyval.odcl).decls = NULL; }
-#line 2245 "cmdgram.cpp"
+#line 2248 "cmdgram.cpp"
     break;
 
   case 48: /* object_declare_block: object_decl_list  */
-#line 293 "CMDgram.y"
+#line 301 "CMDgram.y"
       { (yyval.odcl).slots = NULL; (yyval.odcl).decls = (yyvsp[0].od); }
-#line 2251 "cmdgram.cpp"
+#line 2254 "cmdgram.cpp"
     break;
 
   case 49: /* object_declare_block: slot_assign_list object_decl_list  */
-#line 295 "CMDgram.y"
+#line 303 "CMDgram.y"
       { (yyval.odcl).slots = (yyvsp[-1].slist); (yyval.odcl).decls = (yyvsp[0].od); }
-#line 2257 "cmdgram.cpp"
+#line 2260 "cmdgram.cpp"
     break;
 
   case 50: /* object_decl_list: object_decl ';'  */
-#line 300 "CMDgram.y"
+#line 308 "CMDgram.y"
       { (yyval.od) = (yyvsp[-1].od); }
-#line 2263 "cmdgram.cpp"
+#line 2266 "cmdgram.cpp"
     break;
 
   case 51: /* object_decl_list: object_decl_list object_decl ';'  */
-#line 302 "CMDgram.y"
+#line 310 "CMDgram.y"
       { (yyvsp[-2].od)->append((yyvsp[-1].od)); (yyval.od) = (yyvsp[-2].od); }
-#line 2269 "cmdgram.cpp"
+#line 2272 "cmdgram.cpp"
     break;
 
   case 52: /* stmt_block: '{' statement_list '}'  */
-#line 307 "CMDgram.y"
+#line 315 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[-1].stmt); }
-#line 2275 "cmdgram.cpp"
+#line 2278 "cmdgram.cpp"
     break;
 
   case 53: /* stmt_block: stmt  */
-#line 309 "CMDgram.y"
+#line 317 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[0].stmt); }
-#line 2281 "cmdgram.cpp"
+#line 2284 "cmdgram.cpp"
     break;
 
   case 54: /* switch_stmt: rwSWITCH '(' expr ')' '{' case_block '}'  */
-#line 314 "CMDgram.y"
+#line 322 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[-1].ifnode); (yyvsp[-1].ifnode)->propagateSwitchExpr((yyvsp[-4].expr), false); }
-#line 2287 "cmdgram.cpp"
+#line 2290 "cmdgram.cpp"
     break;
 
   case 55: /* switch_stmt: rwSWITCHSTR '(' expr ')' '{' case_block '}'  */
-#line 316 "CMDgram.y"
+#line 324 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[-1].ifnode); (yyvsp[-1].ifnode)->propagateSwitchExpr((yyvsp[-4].expr), true); }
-#line 2293 "cmdgram.cpp"
+#line 2296 "cmdgram.cpp"
     break;
 
   case 56: /* case_block: rwCASE case_expr ':' statement_list  */
-#line 321 "CMDgram.y"
+#line 329 "CMDgram.y"
       { (yyval.ifnode) = IfStmtNode::alloc( (yyvsp[-3].i).lineNumber, (yyvsp[-2].expr), (yyvsp[0].stmt), NULL, false); }
-#line 2299 "cmdgram.cpp"
+#line 2302 "cmdgram.cpp"
     break;
 
   case 57: /* case_block: rwCASE case_expr ':' statement_list rwDEFAULT ':' statement_list  */
-#line 323 "CMDgram.y"
+#line 331 "CMDgram.y"
       { (yyval.ifnode) = IfStmtNode::alloc( (yyvsp[-6].i).lineNumber, (yyvsp[-5].expr), (yyvsp[-3].stmt), (yyvsp[0].stmt), false); }
-#line 2305 "cmdgram.cpp"
+#line 2308 "cmdgram.cpp"
     break;
 
   case 58: /* case_block: rwCASE case_expr ':' statement_list case_block  */
-#line 325 "CMDgram.y"
+#line 333 "CMDgram.y"
       { (yyval.ifnode) = IfStmtNode::alloc( (yyvsp[-4].i).lineNumber, (yyvsp[-3].expr), (yyvsp[-1].stmt), (yyvsp[0].ifnode), true); }
-#line 2311 "cmdgram.cpp"
+#line 2314 "cmdgram.cpp"
     break;
 
   case 59: /* case_expr: expr  */
-#line 330 "CMDgram.y"
+#line 338 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr);}
-#line 2317 "cmdgram.cpp"
+#line 2320 "cmdgram.cpp"
     break;
 
   case 60: /* case_expr: case_expr rwCASEOR expr  */
-#line 332 "CMDgram.y"
+#line 340 "CMDgram.y"
       { ((yyvsp[-2].expr))->append((yyvsp[0].expr)); (yyval.expr)=(yyvsp[-2].expr); }
-#line 2323 "cmdgram.cpp"
+#line 2326 "cmdgram.cpp"
     break;
 
   case 61: /* if_stmt: rwIF '(' expr ')' stmt_block  */
-#line 337 "CMDgram.y"
+#line 345 "CMDgram.y"
       { (yyval.stmt) = IfStmtNode::alloc((yyvsp[-4].i).lineNumber, (yyvsp[-2].expr), (yyvsp[0].stmt), NULL, false); }
-#line 2329 "cmdgram.cpp"
+#line 2332 "cmdgram.cpp"
     break;
 
   case 62: /* if_stmt: rwIF '(' expr ')' stmt_block rwELSE stmt_block  */
-#line 339 "CMDgram.y"
+#line 347 "CMDgram.y"
       { (yyval.stmt) = IfStmtNode::alloc((yyvsp[-6].i).lineNumber, (yyvsp[-4].expr), (yyvsp[-2].stmt), (yyvsp[0].stmt), false); }
-#line 2335 "cmdgram.cpp"
+#line 2338 "cmdgram.cpp"
     break;
 
   case 63: /* while_stmt: rwWHILE '(' expr ')' stmt_block  */
-#line 344 "CMDgram.y"
+#line 352 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-4].i).lineNumber, nil, (yyvsp[-2].expr), nil, (yyvsp[0].stmt), false); }
-#line 2341 "cmdgram.cpp"
+#line 2344 "cmdgram.cpp"
     break;
 
   case 64: /* while_stmt: rwDO stmt_block rwWHILE '(' expr ')'  */
-#line 346 "CMDgram.y"
+#line 354 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-3].i).lineNumber, nil, (yyvsp[-1].expr), nil, (yyvsp[-4].stmt), true); }
-#line 2347 "cmdgram.cpp"
+#line 2350 "cmdgram.cpp"
     break;
 
   case 65: /* for_stmt: rwFOR '(' expr ';' expr ';' expr ')' stmt_block  */
-#line 351 "CMDgram.y"
+#line 359 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-8].i).lineNumber, (yyvsp[-6].expr), (yyvsp[-4].expr), (yyvsp[-2].expr), (yyvsp[0].stmt), false); }
-#line 2353 "cmdgram.cpp"
+#line 2356 "cmdgram.cpp"
     break;
 
   case 66: /* for_stmt: rwFOR '(' expr ';' expr ';' ')' stmt_block  */
-#line 353 "CMDgram.y"
+#line 361 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-7].i).lineNumber, (yyvsp[-5].expr), (yyvsp[-3].expr), NULL, (yyvsp[0].stmt), false); }
-#line 2359 "cmdgram.cpp"
+#line 2362 "cmdgram.cpp"
     break;
 
   case 67: /* for_stmt: rwFOR '(' expr ';' ';' expr ')' stmt_block  */
-#line 355 "CMDgram.y"
+#line 363 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-7].i).lineNumber, (yyvsp[-5].expr), NULL, (yyvsp[-2].expr), (yyvsp[0].stmt), false); }
-#line 2365 "cmdgram.cpp"
+#line 2368 "cmdgram.cpp"
     break;
 
   case 68: /* for_stmt: rwFOR '(' expr ';' ';' ')' stmt_block  */
-#line 357 "CMDgram.y"
+#line 365 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-6].i).lineNumber, (yyvsp[-4].expr), NULL, NULL, (yyvsp[0].stmt), false); }
-#line 2371 "cmdgram.cpp"
+#line 2374 "cmdgram.cpp"
     break;
 
   case 69: /* for_stmt: rwFOR '(' ';' expr ';' expr ')' stmt_block  */
-#line 359 "CMDgram.y"
+#line 367 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-7].i).lineNumber, NULL, (yyvsp[-4].expr), (yyvsp[-2].expr), (yyvsp[0].stmt), false); }
-#line 2377 "cmdgram.cpp"
+#line 2380 "cmdgram.cpp"
     break;
 
   case 70: /* for_stmt: rwFOR '(' ';' expr ';' ')' stmt_block  */
-#line 361 "CMDgram.y"
+#line 369 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-6].i).lineNumber, NULL, (yyvsp[-3].expr), NULL, (yyvsp[0].stmt), false); }
-#line 2383 "cmdgram.cpp"
+#line 2386 "cmdgram.cpp"
     break;
 
   case 71: /* for_stmt: rwFOR '(' ';' ';' expr ')' stmt_block  */
-#line 363 "CMDgram.y"
+#line 371 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-6].i).lineNumber, NULL, NULL, (yyvsp[-2].expr), (yyvsp[0].stmt), false); }
-#line 2389 "cmdgram.cpp"
+#line 2392 "cmdgram.cpp"
     break;
 
   case 72: /* for_stmt: rwFOR '(' ';' ';' ')' stmt_block  */
-#line 365 "CMDgram.y"
+#line 373 "CMDgram.y"
       { (yyval.stmt) = LoopStmtNode::alloc((yyvsp[-5].i).lineNumber, NULL, NULL, NULL, (yyvsp[0].stmt), false); }
-#line 2395 "cmdgram.cpp"
+#line 2398 "cmdgram.cpp"
     break;
 
   case 73: /* foreach_stmt: rwFOREACH '(' VAR rwIN expr ')' stmt_block  */
-#line 370 "CMDgram.y"
+#line 378 "CMDgram.y"
       { (yyval.stmt) = IterStmtNode::alloc( (yyvsp[-6].i).lineNumber, (yyvsp[-4].s).value, (yyvsp[-2].expr), (yyvsp[0].stmt), false ); }
-#line 2401 "cmdgram.cpp"
+#line 2404 "cmdgram.cpp"
     break;
 
   case 74: /* foreach_stmt: rwFOREACHSTR '(' VAR rwIN expr ')' stmt_block  */
-#line 372 "CMDgram.y"
+#line 380 "CMDgram.y"
       { (yyval.stmt) = IterStmtNode::alloc( (yyvsp[-6].i).lineNumber, (yyvsp[-4].s).value, (yyvsp[-2].expr), (yyvsp[0].stmt), true ); }
-#line 2407 "cmdgram.cpp"
+#line 2410 "cmdgram.cpp"
     break;
 
   case 75: /* expression_stmt: stmt_expr  */
-#line 377 "CMDgram.y"
+#line 385 "CMDgram.y"
       { (yyval.stmt) = (yyvsp[0].expr); }
-#line 2413 "cmdgram.cpp"
+#line 2416 "cmdgram.cpp"
     break;
 
   case 76: /* expr: stmt_expr  */
-#line 382 "CMDgram.y"
+#line 390 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr); }
-#line 2419 "cmdgram.cpp"
+#line 2422 "cmdgram.cpp"
     break;
 
   case 77: /* expr: '(' expr ')'  */
-#line 384 "CMDgram.y"
+#line 392 "CMDgram.y"
       { (yyval.expr) = (yyvsp[-1].expr); }
-#line 2425 "cmdgram.cpp"
+#line 2428 "cmdgram.cpp"
     break;
 
   case 78: /* expr: expr '^' expr  */
-#line 386 "CMDgram.y"
+#line 394 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2431 "cmdgram.cpp"
+#line 2434 "cmdgram.cpp"
     break;
 
   case 79: /* expr: expr '%' expr  */
-#line 388 "CMDgram.y"
+#line 396 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2437 "cmdgram.cpp"
+#line 2440 "cmdgram.cpp"
     break;
 
   case 80: /* expr: expr '&' expr  */
-#line 390 "CMDgram.y"
+#line 398 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2443 "cmdgram.cpp"
+#line 2446 "cmdgram.cpp"
     break;
 
   case 81: /* expr: expr '|' expr  */
-#line 392 "CMDgram.y"
+#line 400 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2449 "cmdgram.cpp"
+#line 2452 "cmdgram.cpp"
     break;
 
   case 82: /* expr: expr '+' expr  */
-#line 394 "CMDgram.y"
+#line 402 "CMDgram.y"
       { (yyval.expr) = FloatBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2455 "cmdgram.cpp"
+#line 2458 "cmdgram.cpp"
     break;
 
   case 83: /* expr: expr '-' expr  */
-#line 396 "CMDgram.y"
+#line 404 "CMDgram.y"
       { (yyval.expr) = FloatBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2461 "cmdgram.cpp"
+#line 2464 "cmdgram.cpp"
     break;
 
   case 84: /* expr: expr '*' expr  */
-#line 398 "CMDgram.y"
+#line 406 "CMDgram.y"
       { (yyval.expr) = FloatBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2467 "cmdgram.cpp"
+#line 2470 "cmdgram.cpp"
     break;
 
   case 85: /* expr: expr '/' expr  */
-#line 400 "CMDgram.y"
+#line 408 "CMDgram.y"
       { (yyval.expr) = FloatBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2473 "cmdgram.cpp"
+#line 2476 "cmdgram.cpp"
     break;
 
   case 86: /* expr: '-' expr  */
-#line 402 "CMDgram.y"
+#line 410 "CMDgram.y"
       { (yyval.expr) = FloatUnaryExprNode::alloc( (yyvsp[-1].i).lineNumber, (yyvsp[-1].i).value, (yyvsp[0].expr)); }
-#line 2479 "cmdgram.cpp"
+#line 2482 "cmdgram.cpp"
     break;
 
   case 87: /* expr: '*' expr  */
-#line 404 "CMDgram.y"
+#line 412 "CMDgram.y"
       { (yyval.expr) = TTagDerefNode::alloc( (yyvsp[-1].i).lineNumber, (yyvsp[0].expr) ); }
-#line 2485 "cmdgram.cpp"
+#line 2488 "cmdgram.cpp"
     break;
 
   case 88: /* expr: TTAG  */
-#line 406 "CMDgram.y"
+#line 414 "CMDgram.y"
       { (yyval.expr) = TTagExprNode::alloc( (yyvsp[0].s).lineNumber, (yyvsp[0].s).value ); }
-#line 2491 "cmdgram.cpp"
+#line 2494 "cmdgram.cpp"
     break;
 
   case 89: /* expr: expr '?' expr ':' expr  */
-#line 408 "CMDgram.y"
+#line 416 "CMDgram.y"
       { (yyval.expr) = ConditionalExprNode::alloc( (yyvsp[-4].expr)->dbgLineNumber, (yyvsp[-4].expr), (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2497 "cmdgram.cpp"
+#line 2500 "cmdgram.cpp"
     break;
 
   case 90: /* expr: expr '<' expr  */
-#line 410 "CMDgram.y"
+#line 418 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2503 "cmdgram.cpp"
+#line 2506 "cmdgram.cpp"
     break;
 
   case 91: /* expr: expr '>' expr  */
-#line 412 "CMDgram.y"
+#line 420 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2509 "cmdgram.cpp"
+#line 2512 "cmdgram.cpp"
     break;
 
   case 92: /* expr: expr opGE expr  */
-#line 414 "CMDgram.y"
+#line 422 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2515 "cmdgram.cpp"
+#line 2518 "cmdgram.cpp"
     break;
 
   case 93: /* expr: expr opLE expr  */
-#line 416 "CMDgram.y"
+#line 424 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2521 "cmdgram.cpp"
+#line 2524 "cmdgram.cpp"
     break;
 
   case 94: /* expr: expr opEQ expr  */
-#line 418 "CMDgram.y"
+#line 426 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2527 "cmdgram.cpp"
+#line 2530 "cmdgram.cpp"
     break;
 
   case 95: /* expr: expr opNE expr  */
-#line 420 "CMDgram.y"
+#line 428 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2533 "cmdgram.cpp"
+#line 2536 "cmdgram.cpp"
     break;
 
   case 96: /* expr: expr opOR expr  */
-#line 422 "CMDgram.y"
+#line 430 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2539 "cmdgram.cpp"
+#line 2542 "cmdgram.cpp"
     break;
 
   case 97: /* expr: expr opSHL expr  */
-#line 424 "CMDgram.y"
+#line 432 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2545 "cmdgram.cpp"
+#line 2548 "cmdgram.cpp"
     break;
 
   case 98: /* expr: expr opSHR expr  */
-#line 426 "CMDgram.y"
+#line 434 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2551 "cmdgram.cpp"
+#line 2554 "cmdgram.cpp"
     break;
 
   case 99: /* expr: expr opAND expr  */
-#line 428 "CMDgram.y"
+#line 436 "CMDgram.y"
       { (yyval.expr) = IntBinaryExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-1].i).value, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2557 "cmdgram.cpp"
+#line 2560 "cmdgram.cpp"
     break;
 
   case 100: /* expr: expr opSTREQ expr  */
-#line 430 "CMDgram.y"
+#line 438 "CMDgram.y"
       { (yyval.expr) = StreqExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-2].expr), (yyvsp[0].expr), true); }
-#line 2563 "cmdgram.cpp"
+#line 2566 "cmdgram.cpp"
     break;
 
   case 101: /* expr: expr opSTRNE expr  */
-#line 432 "CMDgram.y"
+#line 440 "CMDgram.y"
       { (yyval.expr) = StreqExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-2].expr), (yyvsp[0].expr), false); }
-#line 2569 "cmdgram.cpp"
+#line 2572 "cmdgram.cpp"
     break;
 
   case 102: /* expr: expr '@' expr  */
-#line 434 "CMDgram.y"
+#line 442 "CMDgram.y"
       { (yyval.expr) = StrcatExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-2].expr), (yyvsp[0].expr), (yyvsp[-1].i).value); }
-#line 2575 "cmdgram.cpp"
+#line 2578 "cmdgram.cpp"
     break;
 
   case 103: /* expr: '!' expr  */
-#line 436 "CMDgram.y"
+#line 444 "CMDgram.y"
       { (yyval.expr) = IntUnaryExprNode::alloc((yyvsp[-1].i).lineNumber, (yyvsp[-1].i).value, (yyvsp[0].expr)); }
-#line 2581 "cmdgram.cpp"
+#line 2584 "cmdgram.cpp"
     break;
 
   case 104: /* expr: '~' expr  */
-#line 438 "CMDgram.y"
+#line 446 "CMDgram.y"
       { (yyval.expr) = IntUnaryExprNode::alloc((yyvsp[-1].i).lineNumber, (yyvsp[-1].i).value, (yyvsp[0].expr)); }
-#line 2587 "cmdgram.cpp"
+#line 2590 "cmdgram.cpp"
     break;
 
   case 105: /* expr: TAGATOM  */
-#line 440 "CMDgram.y"
+#line 448 "CMDgram.y"
       { (yyval.expr) = StrConstNode::alloc( (yyvsp[0].str).lineNumber, (yyvsp[0].str).value, true); }
-#line 2593 "cmdgram.cpp"
+#line 2596 "cmdgram.cpp"
     break;
 
   case 106: /* expr: FLTCONST  */
-#line 442 "CMDgram.y"
+#line 450 "CMDgram.y"
       { (yyval.expr) = FloatNode::alloc( (yyvsp[0].f).lineNumber, (yyvsp[0].f).value ); }
-#line 2599 "cmdgram.cpp"
+#line 2602 "cmdgram.cpp"
     break;
 
   case 107: /* expr: INTCONST  */
-#line 444 "CMDgram.y"
+#line 452 "CMDgram.y"
       { (yyval.expr) = IntNode::alloc( (yyvsp[0].i).lineNumber, (yyvsp[0].i).value ); }
-#line 2605 "cmdgram.cpp"
+#line 2608 "cmdgram.cpp"
     break;
 
   case 108: /* expr: rwBREAK  */
-#line 446 "CMDgram.y"
+#line 454 "CMDgram.y"
       { (yyval.expr) = ConstantNode::alloc( (yyvsp[0].i).lineNumber, StringTable->insert("break")); }
-#line 2611 "cmdgram.cpp"
+#line 2614 "cmdgram.cpp"
     break;
 
   case 109: /* expr: slot_acc  */
-#line 448 "CMDgram.y"
+#line 456 "CMDgram.y"
       { (yyval.expr) = SlotAccessNode::alloc( (yyvsp[0].slot).lineNumber, (yyvsp[0].slot).object, (yyvsp[0].slot).array, (yyvsp[0].slot).slotName ); }
-#line 2617 "cmdgram.cpp"
+#line 2620 "cmdgram.cpp"
     break;
 
   case 110: /* expr: intslot_acc  */
-#line 450 "CMDgram.y"
+#line 458 "CMDgram.y"
       { (yyval.expr) = InternalSlotAccessNode::alloc( (yyvsp[0].intslot).lineNumber, (yyvsp[0].intslot).object, (yyvsp[0].intslot).slotExpr, (yyvsp[0].intslot).recurse); }
-#line 2623 "cmdgram.cpp"
+#line 2626 "cmdgram.cpp"
     break;
 
   case 111: /* expr: IDENT  */
-#line 452 "CMDgram.y"
+#line 460 "CMDgram.y"
       { (yyval.expr) = ConstantNode::alloc( (yyvsp[0].s).lineNumber, (yyvsp[0].s).value ); }
-#line 2629 "cmdgram.cpp"
+#line 2632 "cmdgram.cpp"
     break;
 
   case 112: /* expr: STRATOM  */
-#line 454 "CMDgram.y"
+#line 462 "CMDgram.y"
       { (yyval.expr) = StrConstNode::alloc( (yyvsp[0].str).lineNumber, (yyvsp[0].str).value, false); }
-#line 2635 "cmdgram.cpp"
+#line 2638 "cmdgram.cpp"
     break;
 
   case 113: /* expr: VAR  */
-#line 456 "CMDgram.y"
+#line 464 "CMDgram.y"
       { (yyval.expr) = (ExprNode*)VarNode::alloc( (yyvsp[0].s).lineNumber, (yyvsp[0].s).value, NULL); }
-#line 2641 "cmdgram.cpp"
+#line 2644 "cmdgram.cpp"
     break;
 
   case 114: /* expr: VAR '[' aidx_expr ']'  */
-#line 458 "CMDgram.y"
+#line 466 "CMDgram.y"
       { (yyval.expr) = (ExprNode*)VarNode::alloc( (yyvsp[-3].s).lineNumber, (yyvsp[-3].s).value, (yyvsp[-1].expr) ); }
-#line 2647 "cmdgram.cpp"
+#line 2650 "cmdgram.cpp"
     break;
 
   case 115: /* slot_acc: expr '.' IDENT  */
-#line 463 "CMDgram.y"
+#line 471 "CMDgram.y"
       { (yyval.slot).lineNumber = (yyvsp[-2].expr)->dbgLineNumber; (yyval.slot).object = (yyvsp[-2].expr); (yyval.slot).slotName = (yyvsp[0].s).value; (yyval.slot).array = NULL; }
-#line 2653 "cmdgram.cpp"
+#line 2656 "cmdgram.cpp"
     break;
 
   case 116: /* slot_acc: expr '.' IDENT '[' aidx_expr ']'  */
-#line 465 "CMDgram.y"
+#line 473 "CMDgram.y"
       { (yyval.slot).lineNumber = (yyvsp[-5].expr)->dbgLineNumber; (yyval.slot).object = (yyvsp[-5].expr); (yyval.slot).slotName = (yyvsp[-3].s).value; (yyval.slot).array = (yyvsp[-1].expr); }
-#line 2659 "cmdgram.cpp"
+#line 2662 "cmdgram.cpp"
     break;
 
   case 117: /* intslot_acc: expr opINTNAME class_name_expr  */
-#line 470 "CMDgram.y"
+#line 478 "CMDgram.y"
      { (yyval.intslot).lineNumber = (yyvsp[-2].expr)->dbgLineNumber; (yyval.intslot).object = (yyvsp[-2].expr); (yyval.intslot).slotExpr = (yyvsp[0].expr); (yyval.intslot).recurse = false; }
-#line 2665 "cmdgram.cpp"
+#line 2668 "cmdgram.cpp"
     break;
 
   case 118: /* intslot_acc: expr opINTNAMER class_name_expr  */
-#line 472 "CMDgram.y"
+#line 480 "CMDgram.y"
      { (yyval.intslot).lineNumber = (yyvsp[-2].expr)->dbgLineNumber; (yyval.intslot).object = (yyvsp[-2].expr); (yyval.intslot).slotExpr = (yyvsp[0].expr); (yyval.intslot).recurse = true; }
-#line 2671 "cmdgram.cpp"
+#line 2674 "cmdgram.cpp"
     break;
 
   case 119: /* class_name_expr: IDENT  */
-#line 477 "CMDgram.y"
+#line 485 "CMDgram.y"
       { (yyval.expr) = ConstantNode::alloc( (yyvsp[0].s).lineNumber, (yyvsp[0].s).value ); }
-#line 2677 "cmdgram.cpp"
+#line 2680 "cmdgram.cpp"
     break;
 
   case 120: /* class_name_expr: '(' expr ')'  */
-#line 479 "CMDgram.y"
+#line 487 "CMDgram.y"
       { (yyval.expr) = (yyvsp[-1].expr); }
-#line 2683 "cmdgram.cpp"
+#line 2686 "cmdgram.cpp"
     break;
 
   case 121: /* assign_op_struct: opPLUSPLUS  */
-#line 484 "CMDgram.y"
+#line 492 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[0].i).lineNumber; (yyval.asn).token = '+'; (yyval.asn).expr = FloatNode::alloc( (yyvsp[0].i).lineNumber, 1 ); }
-#line 2689 "cmdgram.cpp"
+#line 2692 "cmdgram.cpp"
     break;
 
   case 122: /* assign_op_struct: opMINUSMINUS  */
-#line 486 "CMDgram.y"
+#line 494 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[0].i).lineNumber; (yyval.asn).token = '-'; (yyval.asn).expr = FloatNode::alloc( (yyvsp[0].i).lineNumber, 1 ); }
-#line 2695 "cmdgram.cpp"
+#line 2698 "cmdgram.cpp"
     break;
 
   case 123: /* assign_op_struct: opPLASN expr  */
-#line 488 "CMDgram.y"
+#line 496 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = '+'; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2701 "cmdgram.cpp"
+#line 2704 "cmdgram.cpp"
     break;
 
   case 124: /* assign_op_struct: opMIASN expr  */
-#line 490 "CMDgram.y"
+#line 498 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = '-'; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2707 "cmdgram.cpp"
+#line 2710 "cmdgram.cpp"
     break;
 
   case 125: /* assign_op_struct: opMLASN expr  */
-#line 492 "CMDgram.y"
+#line 500 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = '*'; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2713 "cmdgram.cpp"
+#line 2716 "cmdgram.cpp"
     break;
 
   case 126: /* assign_op_struct: opDVASN expr  */
-#line 494 "CMDgram.y"
+#line 502 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = '/'; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2719 "cmdgram.cpp"
+#line 2722 "cmdgram.cpp"
     break;
 
   case 127: /* assign_op_struct: opMODASN expr  */
-#line 496 "CMDgram.y"
+#line 504 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = '%'; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2725 "cmdgram.cpp"
+#line 2728 "cmdgram.cpp"
     break;
 
   case 128: /* assign_op_struct: opANDASN expr  */
-#line 498 "CMDgram.y"
+#line 506 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = '&'; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2731 "cmdgram.cpp"
+#line 2734 "cmdgram.cpp"
     break;
 
   case 129: /* assign_op_struct: opXORASN expr  */
-#line 500 "CMDgram.y"
+#line 508 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = '^'; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2737 "cmdgram.cpp"
+#line 2740 "cmdgram.cpp"
     break;
 
   case 130: /* assign_op_struct: opORASN expr  */
-#line 502 "CMDgram.y"
+#line 510 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = '|'; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2743 "cmdgram.cpp"
+#line 2746 "cmdgram.cpp"
     break;
 
   case 131: /* assign_op_struct: opSLASN expr  */
-#line 504 "CMDgram.y"
+#line 512 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = opSHL; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2749 "cmdgram.cpp"
+#line 2752 "cmdgram.cpp"
     break;
 
   case 132: /* assign_op_struct: opSRASN expr  */
-#line 506 "CMDgram.y"
+#line 514 "CMDgram.y"
       { (yyval.asn).lineNumber = (yyvsp[-1].i).lineNumber; (yyval.asn).token = opSHR; (yyval.asn).expr = (yyvsp[0].expr); }
-#line 2755 "cmdgram.cpp"
+#line 2758 "cmdgram.cpp"
     break;
 
   case 133: /* stmt_expr: funcall_expr  */
-#line 511 "CMDgram.y"
+#line 519 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr); }
-#line 2761 "cmdgram.cpp"
+#line 2764 "cmdgram.cpp"
     break;
 
   case 134: /* stmt_expr: assert_expr  */
-#line 513 "CMDgram.y"
+#line 521 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr); }
-#line 2767 "cmdgram.cpp"
+#line 2770 "cmdgram.cpp"
     break;
 
   case 135: /* stmt_expr: object_decl  */
-#line 515 "CMDgram.y"
+#line 523 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].od); }
-#line 2773 "cmdgram.cpp"
+#line 2776 "cmdgram.cpp"
     break;
 
   case 136: /* stmt_expr: VAR '=' expr  */
-#line 517 "CMDgram.y"
+#line 525 "CMDgram.y"
       { (yyval.expr) = AssignExprNode::alloc( (yyvsp[-2].s).lineNumber, (yyvsp[-2].s).value, NULL, (yyvsp[0].expr)); }
-#line 2779 "cmdgram.cpp"
+#line 2782 "cmdgram.cpp"
     break;
 
   case 137: /* stmt_expr: VAR '[' aidx_expr ']' '=' expr  */
-#line 519 "CMDgram.y"
+#line 527 "CMDgram.y"
       { (yyval.expr) = AssignExprNode::alloc( (yyvsp[-5].s).lineNumber, (yyvsp[-5].s).value, (yyvsp[-3].expr), (yyvsp[0].expr)); }
-#line 2785 "cmdgram.cpp"
+#line 2788 "cmdgram.cpp"
     break;
 
   case 138: /* stmt_expr: VAR assign_op_struct  */
-#line 521 "CMDgram.y"
+#line 529 "CMDgram.y"
       { (yyval.expr) = AssignOpExprNode::alloc( (yyvsp[-1].s).lineNumber, (yyvsp[-1].s).value, NULL, (yyvsp[0].asn).expr, (yyvsp[0].asn).token); }
-#line 2791 "cmdgram.cpp"
+#line 2794 "cmdgram.cpp"
     break;
 
   case 139: /* stmt_expr: VAR '[' aidx_expr ']' assign_op_struct  */
-#line 523 "CMDgram.y"
+#line 531 "CMDgram.y"
       { (yyval.expr) = AssignOpExprNode::alloc( (yyvsp[-4].s).lineNumber, (yyvsp[-4].s).value, (yyvsp[-2].expr), (yyvsp[0].asn).expr, (yyvsp[0].asn).token); }
-#line 2797 "cmdgram.cpp"
+#line 2800 "cmdgram.cpp"
     break;
 
   case 140: /* stmt_expr: slot_acc assign_op_struct  */
-#line 525 "CMDgram.y"
+#line 533 "CMDgram.y"
       { (yyval.expr) = SlotAssignOpNode::alloc( (yyvsp[-1].slot).lineNumber, (yyvsp[-1].slot).object, (yyvsp[-1].slot).slotName, (yyvsp[-1].slot).array, (yyvsp[0].asn).token, (yyvsp[0].asn).expr); }
-#line 2803 "cmdgram.cpp"
+#line 2806 "cmdgram.cpp"
     break;
 
   case 141: /* stmt_expr: slot_acc '=' expr  */
-#line 527 "CMDgram.y"
+#line 535 "CMDgram.y"
       { (yyval.expr) = SlotAssignNode::alloc( (yyvsp[-2].slot).lineNumber, (yyvsp[-2].slot).object, (yyvsp[-2].slot).array, (yyvsp[-2].slot).slotName, (yyvsp[0].expr)); }
-#line 2809 "cmdgram.cpp"
+#line 2812 "cmdgram.cpp"
     break;
 
   case 142: /* stmt_expr: slot_acc '=' '{' expr_list '}'  */
-#line 529 "CMDgram.y"
+#line 537 "CMDgram.y"
       { (yyval.expr) = SlotAssignNode::alloc( (yyvsp[-4].slot).lineNumber, (yyvsp[-4].slot).object, (yyvsp[-4].slot).array, (yyvsp[-4].slot).slotName, (yyvsp[-1].expr)); }
-#line 2815 "cmdgram.cpp"
+#line 2818 "cmdgram.cpp"
     break;
 
   case 143: /* funcall_expr: IDENT '(' expr_list_decl ')'  */
-#line 534 "CMDgram.y"
+#line 542 "CMDgram.y"
      { (yyval.expr) = FuncCallExprNode::alloc( (yyvsp[-3].s).lineNumber, (yyvsp[-3].s).value, NULL, (yyvsp[-1].expr), false); }
-#line 2821 "cmdgram.cpp"
+#line 2824 "cmdgram.cpp"
     break;
 
   case 144: /* funcall_expr: IDENT opCOLONCOLON IDENT '(' expr_list_decl ')'  */
-#line 536 "CMDgram.y"
+#line 544 "CMDgram.y"
      { (yyval.expr) = FuncCallExprNode::alloc( (yyvsp[-5].s).lineNumber, (yyvsp[-3].s).value, (yyvsp[-5].s).value, (yyvsp[-1].expr), false); }
-#line 2827 "cmdgram.cpp"
+#line 2830 "cmdgram.cpp"
     break;
 
   case 145: /* funcall_expr: expr '.' IDENT '(' expr_list_decl ')'  */
-#line 538 "CMDgram.y"
+#line 546 "CMDgram.y"
       { (yyvsp[-5].expr)->append((yyvsp[-1].expr)); (yyval.expr) = FuncCallExprNode::alloc( (yyvsp[-5].expr)->dbgLineNumber, (yyvsp[-3].s).value, NULL, (yyvsp[-5].expr), true); }
-#line 2833 "cmdgram.cpp"
+#line 2836 "cmdgram.cpp"
     break;
 
   case 146: /* assert_expr: rwASSERT '(' expr ')'  */
-#line 543 "CMDgram.y"
+#line 551 "CMDgram.y"
       { (yyval.expr) = AssertCallExprNode::alloc( (yyvsp[-3].i).lineNumber, (yyvsp[-1].expr), NULL ); }
-#line 2839 "cmdgram.cpp"
+#line 2842 "cmdgram.cpp"
     break;
 
   case 147: /* assert_expr: rwASSERT '(' expr ',' STRATOM ')'  */
-#line 545 "CMDgram.y"
+#line 553 "CMDgram.y"
       { (yyval.expr) = AssertCallExprNode::alloc( (yyvsp[-5].i).lineNumber, (yyvsp[-3].expr), (yyvsp[-1].str).value ); }
-#line 2845 "cmdgram.cpp"
+#line 2848 "cmdgram.cpp"
     break;
 
   case 148: /* expr_list_decl: %empty  */
-#line 550 "CMDgram.y"
+#line 558 "CMDgram.y"
       { (yyval.expr) = NULL; }
-#line 2851 "cmdgram.cpp"
+#line 2854 "cmdgram.cpp"
     break;
 
   case 149: /* expr_list_decl: expr_list  */
-#line 552 "CMDgram.y"
+#line 560 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr); }
-#line 2857 "cmdgram.cpp"
+#line 2860 "cmdgram.cpp"
     break;
 
   case 150: /* expr_list: expr  */
-#line 557 "CMDgram.y"
+#line 565 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr); }
-#line 2863 "cmdgram.cpp"
+#line 2866 "cmdgram.cpp"
     break;
 
   case 151: /* expr_list: expr_list ',' expr  */
-#line 559 "CMDgram.y"
+#line 567 "CMDgram.y"
       { ((yyvsp[-2].expr))->append((yyvsp[0].expr)); (yyval.expr) = (yyvsp[-2].expr); }
-#line 2869 "cmdgram.cpp"
+#line 2872 "cmdgram.cpp"
     break;
 
   case 152: /* slot_assign_list_opt: %empty  */
-#line 564 "CMDgram.y"
+#line 572 "CMDgram.y"
       { (yyval.slist) = NULL; }
-#line 2875 "cmdgram.cpp"
+#line 2878 "cmdgram.cpp"
     break;
 
   case 153: /* slot_assign_list_opt: slot_assign_list  */
-#line 566 "CMDgram.y"
+#line 574 "CMDgram.y"
       { (yyval.slist) = (yyvsp[0].slist); }
-#line 2881 "cmdgram.cpp"
+#line 2884 "cmdgram.cpp"
     break;
 
   case 154: /* slot_assign_list: slot_assign  */
-#line 571 "CMDgram.y"
+#line 579 "CMDgram.y"
       { (yyval.slist) = (yyvsp[0].slist); }
-#line 2887 "cmdgram.cpp"
+#line 2890 "cmdgram.cpp"
     break;
 
   case 155: /* slot_assign_list: slot_assign_list slot_assign  */
-#line 573 "CMDgram.y"
+#line 581 "CMDgram.y"
       { (yyvsp[-1].slist)->append((yyvsp[0].slist)); (yyval.slist) = (yyvsp[-1].slist); }
-#line 2893 "cmdgram.cpp"
+#line 2896 "cmdgram.cpp"
     break;
 
   case 156: /* slot_assign: IDENT '=' expr ';'  */
-#line 578 "CMDgram.y"
+#line 586 "CMDgram.y"
       { (yyval.slist) = SlotAssignNode::alloc( (yyvsp[-3].s).lineNumber, NULL, NULL, (yyvsp[-3].s).value, (yyvsp[-1].expr)); }
-#line 2899 "cmdgram.cpp"
+#line 2902 "cmdgram.cpp"
     break;
 
   case 157: /* slot_assign: TYPEIDENT IDENT '=' expr ';'  */
-#line 580 "CMDgram.y"
+#line 588 "CMDgram.y"
       { (yyval.slist) = SlotAssignNode::alloc( (yyvsp[-4].i).lineNumber, NULL, NULL, (yyvsp[-3].s).value, (yyvsp[-1].expr), (yyvsp[-4].i).value); }
-#line 2905 "cmdgram.cpp"
+#line 2908 "cmdgram.cpp"
     break;
 
   case 158: /* slot_assign: rwDATABLOCK '=' expr ';'  */
-#line 582 "CMDgram.y"
+#line 590 "CMDgram.y"
       { (yyval.slist) = SlotAssignNode::alloc( (yyvsp[-3].i).lineNumber, NULL, NULL, StringTable->insert("datablock"), (yyvsp[-1].expr)); }
-#line 2911 "cmdgram.cpp"
+#line 2914 "cmdgram.cpp"
     break;
 
   case 159: /* slot_assign: IDENT '[' aidx_expr ']' '=' expr ';'  */
-#line 584 "CMDgram.y"
+#line 592 "CMDgram.y"
       { (yyval.slist) = SlotAssignNode::alloc( (yyvsp[-6].s).lineNumber, NULL, (yyvsp[-4].expr), (yyvsp[-6].s).value, (yyvsp[-1].expr)); }
-#line 2917 "cmdgram.cpp"
+#line 2920 "cmdgram.cpp"
     break;
 
   case 160: /* slot_assign: TYPEIDENT IDENT '[' aidx_expr ']' '=' expr ';'  */
-#line 586 "CMDgram.y"
+#line 594 "CMDgram.y"
       { (yyval.slist) = SlotAssignNode::alloc( (yyvsp[-7].i).lineNumber, NULL, (yyvsp[-4].expr), (yyvsp[-6].s).value, (yyvsp[-1].expr), (yyvsp[-7].i).value); }
-#line 2923 "cmdgram.cpp"
+#line 2926 "cmdgram.cpp"
     break;
 
   case 161: /* aidx_expr: expr  */
-#line 591 "CMDgram.y"
+#line 599 "CMDgram.y"
       { (yyval.expr) = (yyvsp[0].expr); }
-#line 2929 "cmdgram.cpp"
+#line 2932 "cmdgram.cpp"
     break;
 
   case 162: /* aidx_expr: aidx_expr ',' expr  */
-#line 593 "CMDgram.y"
+#line 601 "CMDgram.y"
       { (yyval.expr) = CommaCatExprNode::alloc( (yyvsp[-2].expr)->dbgLineNumber, (yyvsp[-2].expr), (yyvsp[0].expr)); }
-#line 2935 "cmdgram.cpp"
+#line 2938 "cmdgram.cpp"
     break;
 
 
-#line 2939 "cmdgram.cpp"
+#line 2942 "cmdgram.cpp"
 
       default: break;
     }
@@ -3128,6 +3131,6 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 595 "CMDgram.y"
+#line 603 "CMDgram.y"
 
 
@@ -134,7 +134,7 @@ extern int CMDdebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 82 "CMDgram.y"
+#line 90 "CMDgram.y"
 
    Token< char >           c;
    Token< int >            i;
@@ -161,10 +161,15 @@ typedef union YYSTYPE YYSTYPE;
 #endif
 
 
-extern YYSTYPE CMDlval;
 
 
 int CMDparse (void);
 
+/* "%code provides" blocks.  */
+#line 48 "CMDgram.y"
+
+int CMDlex(YYSTYPE *lvalp);
+
+#line 174 "cmdgram.h"
 
 #endif /* !YY_CMD_CMDGRAM_H_INCLUDED  */
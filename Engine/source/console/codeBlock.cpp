@@ -29,14 +29,16 @@
 #include "core/strings/stringFunctions.h"
 #include "core/stringTable.h"
 #include "core/stream/fileStream.h"
+#include "core/crc.h"
 
 using namespace Compiler;
 
-bool           CodeBlock::smInFunction = false;
-U32            CodeBlock::smBreakLineCount = 0;
-CodeBlock *    CodeBlock::smCodeBlockList = NULL;
-CodeBlock *    CodeBlock::smCurrentCodeBlock = NULL;
-ConsoleParser *CodeBlock::smCurrentParser = NULL;
+TORQUE_THREAD_LOCAL bool           CodeBlock::smInFunction = false;
+TORQUE_THREAD_LOCAL U32            CodeBlock::smBreakLineCount = 0;
+TORQUE_THREAD_LOCAL U32            CodeBlock::smCallSiteCount = 0;
+CodeBlock *                        CodeBlock::smCodeBlockList = NULL;
+CodeBlock *                        CodeBlock::smCurrentCodeBlock = NULL;
+TORQUE_THREAD_LOCAL ConsoleParser *CodeBlock::smCurrentParser = NULL;
 
 //-------------------------------------------------------------------------
 
@@ -51,6 +53,8 @@ CodeBlock::CodeBlock()
    lineBreakPairs = NULL;
    breakList = NULL;
    breakListSize = 0;
+   callSiteCount = 0;
+   callSiteCaches = NULL;
 
    refCount = 0;
    code = NULL;
@@ -76,6 +80,7 @@ CodeBlock::~CodeBlock()
    delete[] functionFloats;
    delete[] code;
    delete[] breakList;
+   delete[] callSiteCaches;
 }
 
 //-------------------------------------------------------------------------
@@ -406,6 +411,7 @@ bool CodeBlock::read(StringTableEntry fileName, Stream &st)
    U32 codeSize;
    st.read(&codeSize);
    st.read(&lineBreakPairCount);
+   st.read(&callSiteCount);
 
    U32 totSize = codeSize + lineBreakPairCount * 2;
    code = new U32[totSize];
@@ -450,10 +456,18 @@ bool CodeBlock::read(StringTableEntry fileName, Stream &st)
    if(lineBreakPairCount)
       calcBreakList();
 
+   if(callSiteCount)
+      callSiteCaches = new Namespace::CallSiteCache[callSiteCount];
+
    return true;
 }
 
 
+U32 CodeBlock::getSourceCRC(const char *script)
+{
+   return CRC::calculateCRC(script, dStrlen(script));
+}
+
 bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, const char *inScript, bool overrideNoDso)
 {
    // This will return true, but return value is ignored
@@ -492,6 +506,7 @@ bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, con
    if(!st.open(codeFileName, Torque::FS::File::Write)) 
       return false;
    st.write(U32(Con::DSOVersion));
+   st.write(getSourceCRC(inScript));
 
    // Reset all our value tables...
    resetTables();
@@ -518,6 +533,7 @@ bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, con
    getFunctionFloatTable().write(st);
 
    smBreakLineCount = 0;
+   smCallSiteCount = 0;
    U32 lastIp;
    if(gStatementList)
       lastIp = compileBlock(gStatementList, code, 0, 0, 0);
@@ -525,12 +541,13 @@ bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, con
       lastIp = 0;
 
    if(lastIp != codeSize - 1)
-      Con::errorf(ConsoleLogEntry::General, "CodeBlock::compile - precompile size mismatch, a precompile/compile function pair is probably mismatched.");
+      diagnosticf(ConsoleLogEntry::Error, "CodeBlock::compile - precompile size mismatch, a precompile/compile function pair is probably mismatched.");
 
    code[lastIp++] = OP_RETURN;
    U32 totSize = codeSize + smBreakLineCount * 2;
    st.write(codeSize);
    st.write(lineBreakPairCount);
+   st.write(smCallSiteCount);
 
    // Write out our bytecode, doing a bit of compression for low numbers.
    U32 i;   
@@ -637,8 +654,13 @@ const char *CodeBlock::compileExec(StringTableEntry fileName, const char *inStri
    lineBreakPairs = code + codeSize;
 
    smBreakLineCount = 0;
+   smCallSiteCount = 0;
    U32 lastIp = compileBlock(gStatementList, code, 0, 0, 0);
    code[lastIp++] = OP_RETURN;
+
+   callSiteCount = smCallSiteCount;
+   if(callSiteCount)
+      callSiteCaches = new Namespace::CallSiteCache[callSiteCount];
    
    consoleAllocReset();
 
@@ -646,7 +668,7 @@ const char *CodeBlock::compileExec(StringTableEntry fileName, const char *inStri
       calcBreakList();
 
    if(lastIp != codeSize)
-      Con::warnf(ConsoleLogEntry::General, "precompile size mismatch, precompile: %d compile: %d", codeSize, lastIp);
+      diagnosticf(ConsoleLogEntry::Warning, "precompile size mismatch, precompile: %d compile: %d", codeSize, lastIp);
 
    return exec(0, fileName, NULL, 0, 0, noCalls, NULL, setFrame);
 }
@@ -674,7 +696,7 @@ String CodeBlock::getFunctionArgs( U32 ip )
    U32 fnArgc = code[ ip + 5 ];
    for( U32 i = 0; i < fnArgc; ++ i )
    {
-      StringTableEntry var = U32toSTE( code[ ip + i + 6 ] );
+      StringTableEntry var = U32toSTE( code[ ip + i + 7 ] );
       
       if( i != 0 )
          str.append( ", " );
@@ -708,13 +730,14 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             bool hasBody = bool(code[ip+3]);
             U32 newIp = code[ ip + 4 ];
             U32 argc = code[ ip + 5 ];
+            U32 localCount = code[ ip + 6 ];
             
-            Con::printf( "%i: OP_FUNC_DECL name=%s nspace=%s package=%s hasbody=%i newip=%i argc=%i",
-               ip - 1, fnName, fnNamespace, fnPackage, hasBody, newIp, argc );
+            Con::printf( "%i: OP_FUNC_DECL name=%s nspace=%s package=%s hasbody=%i newip=%i argc=%i locals=%i",
+               ip - 1, fnName, fnNamespace, fnPackage, hasBody, newIp, argc, localCount );
                
-            // Skip args.
+            // Skip locals.
                            
-            ip += 6 + argc;
+            ip += 7 + localCount;
             break;
          }
             
@@ -823,6 +846,26 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             break;
          }
 
+         case OP_RETURN_UINT:
+         {
+            Con::printf( "%i: OP_RETURN_UINT", ip - 1 );
+
+            if( upToReturn )
+               return;
+
+            break;
+         }
+
+         case OP_RETURN_FLT:
+         {
+            Con::printf( "%i: OP_RETURN_FLT", ip - 1 );
+
+            if( upToReturn )
+               return;
+
+            break;
+         }
+
          case OP_CMPEQ:
          {
             Con::printf( "%i: OP_CMPEQ", ip - 1 );
@@ -984,6 +1027,20 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             Con::printf( "%i: OP_SETCURVAR_ARRAY_CREATE", ip - 1 );
             break;
          }
+
+         case OP_SETCURVAR_LOCAL:
+         {
+            Con::printf( "%i: OP_SETCURVAR_LOCAL slot=%i", ip - 1, code[ ip ] );
+            ++ ip;
+            break;
+         }
+
+         case OP_SETCURVAR_LOCAL_CREATE:
+         {
+            Con::printf( "%i: OP_SETCURVAR_LOCAL_CREATE slot=%i", ip - 1, code[ ip ] );
+            ++ ip;
+            break;
+         }
          
          case OP_LOADVAR_UINT:
          {
@@ -1205,11 +1262,13 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             StringTableEntry fnName      = U32toSTE(code[ip]);
             U32 callType = code[ip+2];
 
-            Con::printf( "%i: OP_CALLFUNC_RESOLVE name=%s nspace=%s callType=%s", ip - 1, fnName, fnNamespace,
+            U32 callSite = code[ip+3];
+
+            Con::printf( "%i: OP_CALLFUNC_RESOLVE name=%s nspace=%s callType=%s site=%i", ip - 1, fnName, fnNamespace,
                callType == FuncCallExprNode::FunctionCall ? "FunctionCall"
-                  : callType == FuncCallExprNode::MethodCall ? "MethodCall" : "ParentCall" );
+                  : callType == FuncCallExprNode::MethodCall ? "MethodCall" : "ParentCall", callSite );
             
-            ip += 3;
+            ip += 4;
             break;
          }
          
@@ -1219,11 +1278,13 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             StringTableEntry fnName      = U32toSTE(code[ip]);
             U32 callType = code[ip+2];
 
-            Con::printf( "%i: OP_CALLFUNC name=%s nspace=%s callType=%s", ip - 1, fnName, fnNamespace,
+            U32 callSite = code[ip+3];
+
+            Con::printf( "%i: OP_CALLFUNC name=%s nspace=%s callType=%s site=%i", ip - 1, fnName, fnNamespace,
                callType == FuncCallExprNode::FunctionCall ? "FunctionCall"
-                  : callType == FuncCallExprNode::MethodCall ? "MethodCall" : "ParentCall" );
+                  : callType == FuncCallExprNode::MethodCall ? "MethodCall" : "ParentCall", callSite );
             
-            ip += 3;
+            ip += 4;
             break;
          }
 
@@ -1277,6 +1338,24 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             break;
          }
 
+         case OP_PUSH_UINT:
+         {
+            Con::printf( "%i: OP_PUSH_UINT", ip - 1 );
+            break;
+         }
+
+         case OP_PUSH_FLT:
+         {
+            Con::printf( "%i: OP_PUSH_FLT", ip - 1 );
+            break;
+         }
+
+         case OP_PUSH_VAR:
+         {
+            Con::printf( "%i: OP_PUSH_VAR", ip - 1 );
+            break;
+         }
+
          case OP_PUSH_FRAME:
          {
             Con::printf( "%i: OP_PUSH_FRAME", ip - 1 );
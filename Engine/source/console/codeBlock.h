@@ -25,8 +25,10 @@
 
 #include "console/compiler.h"
 #include "console/consoleParser.h"
+#include "console/consoleInternal.h"
 
 class Stream;
+struct ConsoleValue;
 
 /// Core TorqueScript code management class.
 ///
@@ -38,9 +40,14 @@ private:
    static CodeBlock* smCurrentCodeBlock;
    
 public:
-   static U32                       smBreakLineCount;
-   static bool                      smInFunction;
-   static Compiler::ConsoleParser * smCurrentParser;
+   /// @name Compiler State
+   /// Kept per thread so that scripts can be compiled on worker threads.
+   /// @{
+   static TORQUE_THREAD_LOCAL U32                        smBreakLineCount;
+   static TORQUE_THREAD_LOCAL U32                        smCallSiteCount;
+   static TORQUE_THREAD_LOCAL bool                       smInFunction;
+   static TORQUE_THREAD_LOCAL Compiler::ConsoleParser *  smCurrentParser;
+   /// @}
 
    static CodeBlock* getCurrentBlock()
    {
@@ -76,6 +83,11 @@ public:
    U32 codeSize;
    U32 *code;
 
+   /// One lookup cache per OP_CALLFUNC/OP_CALLFUNC_RESOLVE, indexed by
+   /// the call site operand the compiler gives each of them.
+   U32 callSiteCount;
+   Namespace::CallSiteCache *callSiteCaches;
+
    U32 refCount;
    U32 lineBreakPairCount;
    U32 *lineBreakPairs;
@@ -107,6 +119,11 @@ public:
    /// 
    String getFunctionArgs( U32 offset );
 
+   /// Return the hash of @a script that compile() stores in the DSO header,
+   /// so a DSO can be matched to its source by content rather than by
+   /// modification time.
+   static U32 getSourceCRC(const char *script);
+
    bool read(StringTableEntry fileName, Stream &st);
    bool compile(const char *dsoName, StringTableEntry fileName, const char *script, bool overrideNoDso = false);
 
@@ -146,9 +163,16 @@ public:
    /// -1 a new frame is created. If the index is out of range the
    /// top stack frame is used.
    /// @param packageName The code package name or null.
+   /// @param argValues Optional typed values matching argv. Numeric entries
+   /// are assigned to the parameters directly and their argv strings are
+   /// not read.
+   /// @param returnValue Optional place to return a numeric result without
+   /// formatting it. If the function returns a number, its type is set and
+   /// the returned string is empty; otherwise its type is TypeString.
    const char *exec(U32 offset, const char *fnName, Namespace *ns, U32 argc, 
       const char **argv, bool noCalls, StringTableEntry packageName, 
-      S32 setFrame = -1);
+      S32 setFrame = -1, const ConsoleValue *argValues = NULL,
+      ConsoleValue *returnValue = NULL);
 };
 
 #endif
\ No newline at end of file
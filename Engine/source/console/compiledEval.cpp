@@ -244,6 +244,18 @@ inline void ExprEvalState::setCurVarNameCreate(StringTableEntry name)
    }
 }
 
+inline void ExprEvalState::setCurVarLocal(U32 slot)
+{
+   currentVariable = getCurrentFrame().getLocal(slot);
+   if(gWarnUndefinedScriptVariables && currentVariable->isUnset())
+	   Con::warnf(ConsoleLogEntry::Script, "Variable referenced before assignment: %s", currentVariable->name);
+}
+
+inline void ExprEvalState::setCurVarLocalCreate(U32 slot)
+{
+   currentVariable = getCurrentFrame().getLocal(slot);
+}
+
 //------------------------------------------------------------
 
 inline S32 ExprEvalState::getIntVariable()
@@ -401,7 +413,66 @@ static void setFieldComponent( SimObject* object, StringTableEntry field, const
    }
 }
 
-const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNamespace, U32 argc, const char **argv, bool noCalls, StringTableEntry packageName, S32 setFrame)
+// On compilers with "labels as values" the opcode handlers are dispatched
+// with computed gotos: each handler jumps straight to the handler of the next
+// instruction through sDispatchTable instead of going back around to a single
+// switch, which gives the branch predictor a separate history per opcode.
+// The switch stays as the fallback on other compilers.
+#if defined( __GNUC__ ) && !defined( TORQUE_DISABLE_COMPUTED_GOTO )
+#  define TORQUE_COMPUTED_GOTO
+#endif
+
+#ifdef TORQUE_COMPUTED_GOTO
+#  define VM_CASE( op ) case op: _label_##op
+#  define VM_DISPATCH() goto *sDispatchTable[ instruction <= OP_INVALID ? instruction : OP_INVALID ]
+#  define VM_NEXT() { instruction = code[ ip ++ ]; nsEntry = NULL; VM_DISPATCH(); }
+#else
+#  define VM_CASE( op ) case op
+#  define VM_NEXT() break
+#endif
+
+/// Hand an integer call result to the instruction following the call.  If
+/// that instruction would only convert the string result back to a number,
+/// it is skipped and the number pushed directly; otherwise the result is
+/// formatted onto the string stack.  Returns the new ip.
+static inline U32 pushIntCallResult(const U32 *code, U32 ip, S64 result)
+{
+   switch(code[ip])
+   {
+      case OP_STR_TO_UINT:
+         intStack[++_UINT] = result;
+         return ip + 1;
+      case OP_STR_TO_FLT:
+         floatStack[++_FLT] = result;
+         return ip + 1;
+      case OP_STR_TO_NONE:
+         return ip + 1;
+      default:
+         STR.setIntValue(result);
+         return ip;
+   }
+}
+
+/// @see pushIntCallResult
+static inline U32 pushFloatCallResult(const U32 *code, U32 ip, F64 result)
+{
+   switch(code[ip])
+   {
+      case OP_STR_TO_UINT:
+         intStack[++_UINT] = (S64)result;
+         return ip + 1;
+      case OP_STR_TO_FLT:
+         floatStack[++_FLT] = result;
+         return ip + 1;
+      case OP_STR_TO_NONE:
+         return ip + 1;
+      default:
+         STR.setFloatValue(result);
+         return ip;
+   }
+}
+
+const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNamespace, U32 argc, const char **argv, bool noCalls, StringTableEntry packageName, S32 setFrame, const ConsoleValue *argValues, ConsoleValue *returnValue)
 {
 #ifdef TORQUE_DEBUG
    U32 stackStart = STR.mStartStackSize;
@@ -419,6 +490,8 @@ const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNam
    STR.clearFunctionOffset();
    StringTableEntry thisFunctionName = NULL;
    bool popFrame = false;
+   if(returnValue)
+      returnValue->type = ConsoleValue::TypeString;
    if(argv)
    {
       // assume this points into a function decl:
@@ -427,6 +500,9 @@ const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNam
       argc = getMin(argc-1, fnArgc); // argv[0] is func name
       if(gEvalState.traceOn)
       {
+         if(argValues)
+            StringStack::formatArgs(argc + 1, argv, argValues);
+
          traceBuffer[0] = 0;
          dStrcat(traceBuffer, "Entering ");
          if(packageName)
@@ -454,15 +530,20 @@ const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNam
          dStrcat(traceBuffer, ")");
          Con::printf("%s", traceBuffer);
       }
-      gEvalState.pushFrame(thisFunctionName, thisNamespace);
+      // Arguments take the first slots of the frame.
+      gEvalState.pushFrame(thisFunctionName, thisNamespace, code[ip + 6], &code[ip + 7]);
       popFrame = true;
       for(i = 0; i < argc; i++)
       {
-         StringTableEntry var = U32toSTE(code[ip + i + 6]);
-         gEvalState.setCurVarNameCreate(var);
-         gEvalState.setStringVariable(argv[i+1]);
+         gEvalState.setCurVarLocalCreate(i);
+         if(!argValues || argValues[i+1].type == ConsoleValue::TypeString)
+            gEvalState.setStringVariable(argv[i+1]);
+         else if(argValues[i+1].type == ConsoleValue::TypeInt)
+            gEvalState.setIntVariable(argValues[i+1].ival);
+         else
+            gEvalState.setFloatVariable(argValues[i+1].fval);
       }
-      ip = ip + fnArgc + 6;
+      ip = ip + code[ip + 6] + 7;
       curFloatTable = functionFloats;
       curStringTable = functionStrings;
       curStringTableLen = functionStringsMaxLen;
@@ -531,6 +612,7 @@ const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNam
 
    U32 callArgc;
    const char **callArgv;
+   ConsoleValue *callArgValues;
 
    static char curFieldArray[256];
    static char prevFieldArray[256];
@@ -549,14 +631,123 @@ const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNam
    static S32 VAL_BUFFER_SIZE = 1024;
    FrameTemp<char> valBuffer( VAL_BUFFER_SIZE );
 
+#ifdef TORQUE_COMPUTED_GOTO
+   // Must list a label for every opcode, in CompiledInstructions order.
+   static const void* const sDispatchTable[] =
+   {
+      &&_label_OP_FUNC_DECL,
+      &&_label_OP_CREATE_OBJECT,
+      &&_label_OP_ADD_OBJECT,
+      &&_label_OP_END_OBJECT,
+      &&_label_OP_FINISH_OBJECT,
+      &&_label_OP_JMPIFFNOT,
+      &&_label_OP_JMPIFNOT,
+      &&_label_OP_JMPIFF,
+      &&_label_OP_JMPIF,
+      &&_label_OP_JMPIFNOT_NP,
+      &&_label_OP_JMPIF_NP,
+      &&_label_OP_JMP,
+      &&_label_OP_RETURN,
+      &&_label_OP_RETURN_VOID,
+      &&_label_OP_RETURN_UINT,
+      &&_label_OP_RETURN_FLT,
+      &&_label_OP_CMPEQ,
+      &&_label_OP_CMPGR,
+      &&_label_OP_CMPGE,
+      &&_label_OP_CMPLT,
+      &&_label_OP_CMPLE,
+      &&_label_OP_CMPNE,
+      &&_label_OP_XOR,
+      &&_label_OP_MOD,
+      &&_label_OP_BITAND,
+      &&_label_OP_BITOR,
+      &&_label_OP_NOT,
+      &&_label_OP_NOTF,
+      &&_label_OP_ONESCOMPLEMENT,
+      &&_label_OP_SHR,
+      &&_label_OP_SHL,
+      &&_label_OP_AND,
+      &&_label_OP_OR,
+      &&_label_OP_ADD,
+      &&_label_OP_SUB,
+      &&_label_OP_MUL,
+      &&_label_OP_DIV,
+      &&_label_OP_NEG,
+      &&_label_OP_SETCURVAR,
+      &&_label_OP_SETCURVAR_CREATE,
+      &&_label_OP_SETCURVAR_ARRAY,
+      &&_label_OP_SETCURVAR_ARRAY_CREATE,
+      &&_label_OP_SETCURVAR_LOCAL,
+      &&_label_OP_SETCURVAR_LOCAL_CREATE,
+      &&_label_OP_LOADVAR_UINT,
+      &&_label_OP_LOADVAR_FLT,
+      &&_label_OP_LOADVAR_STR,
+      &&_label_OP_SAVEVAR_UINT,
+      &&_label_OP_SAVEVAR_FLT,
+      &&_label_OP_SAVEVAR_STR,
+      &&_label_OP_SETCUROBJECT,
+      &&_label_OP_SETCUROBJECT_NEW,
+      &&_label_OP_SETCUROBJECT_INTERNAL,
+      &&_label_OP_SETCURFIELD,
+      &&_label_OP_SETCURFIELD_ARRAY,
+      &&_label_OP_SETCURFIELD_TYPE,
+      &&_label_OP_LOADFIELD_UINT,
+      &&_label_OP_LOADFIELD_FLT,
+      &&_label_OP_LOADFIELD_STR,
+      &&_label_OP_SAVEFIELD_UINT,
+      &&_label_OP_SAVEFIELD_FLT,
+      &&_label_OP_SAVEFIELD_STR,
+      &&_label_OP_STR_TO_UINT,
+      &&_label_OP_STR_TO_FLT,
+      &&_label_OP_STR_TO_NONE,
+      &&_label_OP_FLT_TO_UINT,
+      &&_label_OP_FLT_TO_STR,
+      &&_label_OP_FLT_TO_NONE,
+      &&_label_OP_UINT_TO_FLT,
+      &&_label_OP_UINT_TO_STR,
+      &&_label_OP_UINT_TO_NONE,
+      &&_label_OP_LOADIMMED_UINT,
+      &&_label_OP_LOADIMMED_FLT,
+      &&_label_OP_TAG_TO_STR,
+      &&_label_OP_LOADIMMED_STR,
+      &&_label_OP_DOCBLOCK_STR,
+      &&_label_OP_LOADIMMED_IDENT,
+      &&_label_OP_CALLFUNC_RESOLVE,
+      &&_label_OP_CALLFUNC,
+      &&_label_OP_ADVANCE_STR,
+      &&_label_OP_ADVANCE_STR_APPENDCHAR,
+      &&_label_OP_ADVANCE_STR_COMMA,
+      &&_label_OP_ADVANCE_STR_NUL,
+      &&_label_OP_REWIND_STR,
+      &&_label_OP_TERMINATE_REWIND_STR,
+      &&_label_OP_COMPARE_STR,
+      &&_label_OP_PUSH,
+      &&_label_OP_PUSH_UINT,
+      &&_label_OP_PUSH_FLT,
+      &&_label_OP_PUSH_VAR,
+      &&_label_OP_PUSH_FRAME,
+      &&_label_OP_ASSERT,
+      &&_label_OP_BREAK,
+      &&_label_OP_ITER_BEGIN,
+      &&_label_OP_ITER_BEGIN_STR,
+      &&_label_OP_ITER,
+      &&_label_OP_ITER_END,
+      &&_label_OP_INVALID
+   };
+   typedef char DispatchTableSizeCheck[ sizeof( sDispatchTable ) / sizeof( sDispatchTable[ 0 ] ) == OP_INVALID + 1 ? 1 : -1 ];
+#endif
+
    for(;;)
    {
       U32 instruction = code[ip++];
       nsEntry = NULL;
 breakContinue:
+#ifdef TORQUE_COMPUTED_GOTO
+      VM_DISPATCH();
+#endif
       switch(instruction)
       {
-         case OP_FUNC_DECL:
+         VM_CASE(OP_FUNC_DECL):
             if(!noCalls)
             {
                fnName       = U32toSTE(code[ip]);
@@ -587,9 +778,9 @@ breakContinue:
                //Con::printf("Adding function %s::%s (%d)", fnNamespace, fnName, ip);
             }
             ip = code[ip + 4];
-            break;
+            VM_NEXT();
 
-         case OP_CREATE_OBJECT:
+         VM_CASE(OP_CREATE_OBJECT):
          {
             // Read some useful info.
             objParent        = U32toSTE(code[ip    ]);
@@ -606,7 +797,7 @@ breakContinue:
             if(noCalls)
             {
                ip = failJump;
-               break;
+               VM_NEXT();
             }
 
             // Push the old info to the stack
@@ -638,7 +829,7 @@ breakContinue:
                   Con::errorf(ConsoleLogEntry::General, "%s: Cannot re-declare data block %s with a different class.", getFileLine(ip), objectName);
                   ip = failJump;
                   STR.popFrame();
-                  break;
+                  VM_NEXT();
                }
 
                // If there was one, set the currentNewObject and move on.
@@ -662,7 +853,7 @@ breakContinue:
                            getFileLine(ip), objectName, callArgv[1], obj->getClassName());
                         ip = failJump;
                         STR.popFrame();
-                        break;
+                        VM_NEXT();
                      }
 
                      // We're creating a singleton, so use the found object
@@ -714,7 +905,7 @@ breakContinue:
                               getFileLine(ip), newName.c_str() );
                            ip = failJump;
                            STR.popFrame();
-                           break;
+                           VM_NEXT();
                         }
                         else
                            objectName = StringTable->insert( newName );
@@ -725,7 +916,7 @@ breakContinue:
                            getFileLine(ip), objectName);
                         ip = failJump;
                         STR.popFrame();
-                        break;
+                        VM_NEXT();
                      }
                   }
                }
@@ -743,7 +934,7 @@ breakContinue:
                {
                   Con::errorf(ConsoleLogEntry::General, "%s: Unable to instantiate non-conobject class %s.", getFileLine(ip), callArgv[1]);
                   ip = failJump;
-                  break;
+                  VM_NEXT();
                }
 
                // Do special datablock init if appropros
@@ -761,7 +952,7 @@ breakContinue:
                      // Clean up...
                      delete object;
                      ip = failJump;
-                     break;
+                     VM_NEXT();
                   }
                }
 
@@ -774,7 +965,7 @@ breakContinue:
                   Con::errorf(ConsoleLogEntry::General, "%s: Unable to instantiate non-SimObject class %s.", getFileLine(ip), callArgv[1]);
                   delete object;
                   ip = failJump;
-                  break;
+                  VM_NEXT();
                }
 
                // Set the declaration line
@@ -805,7 +996,7 @@ breakContinue:
                      // Fail to create the object.
                      delete object;
                      ip = failJump;
-                     break;
+                     VM_NEXT();
                   }
                }
 
@@ -827,7 +1018,7 @@ breakContinue:
                   delete currentNewObject;
                   currentNewObject = NULL;
                   ip = failJump;
-                  break;
+                  VM_NEXT();
                }
 
                // If it's not a datablock, allow people to modify bits of it.
@@ -840,10 +1031,10 @@ breakContinue:
 
             // Advance the IP past the create info...
             ip += 6;
-            break;
+            VM_NEXT();
          }
 
-         case OP_ADD_OBJECT:
+         VM_CASE(OP_ADD_OBJECT):
          {
             // See OP_SETCURVAR for why we do this.
             curFNDocBlock = NULL;
@@ -877,7 +1068,7 @@ breakContinue:
                   Con::warnf(ConsoleLogEntry::General, "%s: Register object failed for object %s of class %s.", getFileLine(ip), currentNewObject->getName(), currentNewObject->getClassName());
                   delete currentNewObject;
                   ip = failJump;
-                  break;
+                  VM_NEXT();
                }
             }
 
@@ -892,7 +1083,7 @@ breakContinue:
                            currentNewObject->getName(), errorStr.c_str());
                dataBlock->deleteObject();
                ip = failJump;
-               break;
+               VM_NEXT();
             }
 
             // What group will we be added to, if any?
@@ -946,88 +1137,112 @@ breakContinue:
             else
                intStack[++_UINT] = currentNewObject->getId();
 
-            break;
+            VM_NEXT();
          }
 
-         case OP_END_OBJECT:
+         VM_CASE(OP_END_OBJECT):
          {
             // If we're not to be placed at the root, make sure we clean up
             // our group reference.
             bool placeAtRoot = code[ip++];
             if(!placeAtRoot)
                _UINT--;
-            break;
+            VM_NEXT();
          }
 
-         case OP_FINISH_OBJECT:
+         VM_CASE(OP_FINISH_OBJECT):
          {
             //Assert( objectCreationStackIndex >= 0 );
             // Restore the object info from the stack [7/9/2007 Black]
             currentNewObject = objectCreationStack[ --objectCreationStackIndex ].newObject;
             failJump = objectCreationStack[ objectCreationStackIndex ].failJump;
-            break;
+            VM_NEXT();
          }
 
-         case OP_JMPIFFNOT:
+         VM_CASE(OP_JMPIFFNOT):
             if(floatStack[_FLT--])
             {
                ip++;
-               break;
+               VM_NEXT();
             }
             ip = code[ip];
-            break;
-         case OP_JMPIFNOT:
+            VM_NEXT();
+         VM_CASE(OP_JMPIFNOT):
             if(intStack[_UINT--])
             {
                ip++;
-               break;
+               VM_NEXT();
             }
             ip = code[ip];
-            break;
-         case OP_JMPIFF:
+            VM_NEXT();
+         VM_CASE(OP_JMPIFF):
             if(!floatStack[_FLT--])
             {
                ip++;
-               break;
+               VM_NEXT();
             }
             ip = code[ip];
-            break;
-         case OP_JMPIF:
+            VM_NEXT();
+         VM_CASE(OP_JMPIF):
             if(!intStack[_UINT--])
             {
                ip ++;
-               break;
+               VM_NEXT();
             }
             ip = code[ip];
-            break;
-         case OP_JMPIFNOT_NP:
+            VM_NEXT();
+         VM_CASE(OP_JMPIFNOT_NP):
             if(intStack[_UINT])
             {
                _UINT--;
                ip++;
-               break;
+               VM_NEXT();
             }
             ip = code[ip];
-            break;
-         case OP_JMPIF_NP:
+            VM_NEXT();
+         VM_CASE(OP_JMPIF_NP):
             if(!intStack[_UINT])
             {
                _UINT--;
                ip++;
-               break;
+               VM_NEXT();
             }
             ip = code[ip];
-            break;
-         case OP_JMP:
+            VM_NEXT();
+         VM_CASE(OP_JMP):
             ip = code[ip];
-            break;
+            VM_NEXT();
             
+         VM_CASE(OP_RETURN_UINT):
+            // Only format the result if our caller can't take it as a number.
+            if(returnValue)
+            {
+               returnValue->setInt(intStack[_UINT]);
+               STR.setStringValue("");
+            }
+            else
+               STR.setIntValue(intStack[_UINT]);
+            _UINT--;
+            goto execReturn;
+
+         VM_CASE(OP_RETURN_FLT):
+            if(returnValue)
+            {
+               returnValue->setFloat(floatStack[_FLT]);
+               STR.setStringValue("");
+            }
+            else
+               STR.setFloatValue(floatStack[_FLT]);
+            _FLT--;
+            goto execReturn;
+
          // This fixes a bug when not explicitly returning a value.
-         case OP_RETURN_VOID:
+         VM_CASE(OP_RETURN_VOID):
       		STR.setStringValue("");
       		// We're falling thru here on purpose.
             
-         case OP_RETURN:
+         VM_CASE(OP_RETURN):
+         execReturn:
          
             if( iterDepth > 0 )
             {
@@ -1038,129 +1253,129 @@ breakContinue:
                   -- iterDepth;
                }
                
-               const char* returnValue = STR.getStringValue();
+               const char* returnString = STR.getStringValue();
                STR.rewind();
-               STR.setStringValue( returnValue ); // Not nice but works.
+               STR.setStringValue( returnString ); // Not nice but works.
             }
                
             goto execFinished;
             
-         case OP_CMPEQ:
+         VM_CASE(OP_CMPEQ):
             intStack[_UINT+1] = bool(floatStack[_FLT] == floatStack[_FLT-1]);
             _UINT++;
             _FLT -= 2;
-            break;
+            VM_NEXT();
 
-         case OP_CMPGR:
+         VM_CASE(OP_CMPGR):
             intStack[_UINT+1] = bool(floatStack[_FLT] > floatStack[_FLT-1]);
             _UINT++;
             _FLT -= 2;
-            break;
+            VM_NEXT();
 
-         case OP_CMPGE:
+         VM_CASE(OP_CMPGE):
             intStack[_UINT+1] = bool(floatStack[_FLT] >= floatStack[_FLT-1]);
             _UINT++;
             _FLT -= 2;
-            break;
+            VM_NEXT();
 
-         case OP_CMPLT:
+         VM_CASE(OP_CMPLT):
             intStack[_UINT+1] = bool(floatStack[_FLT] < floatStack[_FLT-1]);
             _UINT++;
             _FLT -= 2;
-            break;
+            VM_NEXT();
 
-         case OP_CMPLE:
+         VM_CASE(OP_CMPLE):
             intStack[_UINT+1] = bool(floatStack[_FLT] <= floatStack[_FLT-1]);
             _UINT++;
             _FLT -= 2;
-            break;
+            VM_NEXT();
 
-         case OP_CMPNE:
+         VM_CASE(OP_CMPNE):
             intStack[_UINT+1] = bool(floatStack[_FLT] != floatStack[_FLT-1]);
             _UINT++;
             _FLT -= 2;
-            break;
+            VM_NEXT();
 
-         case OP_XOR:
+         VM_CASE(OP_XOR):
             intStack[_UINT-1] = intStack[_UINT] ^ intStack[_UINT-1];
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_MOD:
+         VM_CASE(OP_MOD):
             if(  intStack[_UINT-1] != 0 )
                intStack[_UINT-1] = intStack[_UINT] % intStack[_UINT-1];
             else
                intStack[_UINT-1] = 0;
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_BITAND:
+         VM_CASE(OP_BITAND):
             intStack[_UINT-1] = intStack[_UINT] & intStack[_UINT-1];
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_BITOR:
+         VM_CASE(OP_BITOR):
             intStack[_UINT-1] = intStack[_UINT] | intStack[_UINT-1];
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_NOT:
+         VM_CASE(OP_NOT):
             intStack[_UINT] = !intStack[_UINT];
-            break;
+            VM_NEXT();
 
-         case OP_NOTF:
+         VM_CASE(OP_NOTF):
             intStack[_UINT+1] = !floatStack[_FLT];
             _FLT--;
             _UINT++;
-            break;
+            VM_NEXT();
 
-         case OP_ONESCOMPLEMENT:
+         VM_CASE(OP_ONESCOMPLEMENT):
             intStack[_UINT] = ~intStack[_UINT];
-            break;
+            VM_NEXT();
 
-         case OP_SHR:
+         VM_CASE(OP_SHR):
             intStack[_UINT-1] = intStack[_UINT] >> intStack[_UINT-1];
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_SHL:
+         VM_CASE(OP_SHL):
             intStack[_UINT-1] = intStack[_UINT] << intStack[_UINT-1];
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_AND:
+         VM_CASE(OP_AND):
             intStack[_UINT-1] = intStack[_UINT] && intStack[_UINT-1];
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_OR:
+         VM_CASE(OP_OR):
             intStack[_UINT-1] = intStack[_UINT] || intStack[_UINT-1];
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_ADD:
+         VM_CASE(OP_ADD):
             floatStack[_FLT-1] = floatStack[_FLT] + floatStack[_FLT-1];
             _FLT--;
-            break;
+            VM_NEXT();
 
-         case OP_SUB:
+         VM_CASE(OP_SUB):
             floatStack[_FLT-1] = floatStack[_FLT] - floatStack[_FLT-1];
             _FLT--;
-            break;
+            VM_NEXT();
 
-         case OP_MUL:
+         VM_CASE(OP_MUL):
             floatStack[_FLT-1] = floatStack[_FLT] * floatStack[_FLT-1];
             _FLT--;
-            break;
-         case OP_DIV:
+            VM_NEXT();
+         VM_CASE(OP_DIV):
             floatStack[_FLT-1] = floatStack[_FLT] / floatStack[_FLT-1];
             _FLT--;
-            break;
-         case OP_NEG:
+            VM_NEXT();
+         VM_CASE(OP_NEG):
             floatStack[_FLT] = -floatStack[_FLT];
-            break;
+            VM_NEXT();
 
-         case OP_SETCURVAR:
+         VM_CASE(OP_SETCURVAR):
             var = U32toSTE(code[ip]);
             ip++;
 
@@ -1178,9 +1393,9 @@ breakContinue:
             // won't inappropriately carry forward to following function decls.
             curFNDocBlock = NULL;
             curNSDocBlock = NULL;
-            break;
+            VM_NEXT();
 
-         case OP_SETCURVAR_CREATE:
+         VM_CASE(OP_SETCURVAR_CREATE):
             var = U32toSTE(code[ip]);
             ip++;
 
@@ -1194,9 +1409,9 @@ breakContinue:
             // See OP_SETCURVAR for why we do this.
             curFNDocBlock = NULL;
             curNSDocBlock = NULL;
-            break;
+            VM_NEXT();
 
-         case OP_SETCURVAR_ARRAY:
+         VM_CASE(OP_SETCURVAR_ARRAY):
             var = STR.getSTValue();
 
             // See OP_SETCURVAR
@@ -1209,9 +1424,9 @@ breakContinue:
             // See OP_SETCURVAR for why we do this.
             curFNDocBlock = NULL;
             curNSDocBlock = NULL;
-            break;
+            VM_NEXT();
 
-         case OP_SETCURVAR_ARRAY_CREATE:
+         VM_CASE(OP_SETCURVAR_ARRAY_CREATE):
             var = STR.getSTValue();
 
             // See OP_SETCURVAR
@@ -1224,36 +1439,62 @@ breakContinue:
             // See OP_SETCURVAR for why we do this.
             curFNDocBlock = NULL;
             curNSDocBlock = NULL;
-            break;
+            VM_NEXT();
 
-         case OP_LOADVAR_UINT:
+         VM_CASE(OP_SETCURVAR_LOCAL):
+            // See OP_SETCURVAR
+            prevField = NULL;
+            prevObject = NULL;
+            curObject = NULL;
+
+            gEvalState.setCurVarLocal(code[ip++]);
+
+            // See OP_SETCURVAR for why we do this.
+            curFNDocBlock = NULL;
+            curNSDocBlock = NULL;
+            VM_NEXT();
+
+         VM_CASE(OP_SETCURVAR_LOCAL_CREATE):
+            // See OP_SETCURVAR
+            prevField = NULL;
+            prevObject = NULL;
+            curObject = NULL;
+
+            gEvalState.setCurVarLocalCreate(code[ip++]);
+
+            // See OP_SETCURVAR for why we do this.
+            curFNDocBlock = NULL;
+            curNSDocBlock = NULL;
+            VM_NEXT();
+
+         VM_CASE(OP_LOADVAR_UINT):
             intStack[_UINT+1] = gEvalState.getIntVariable();
             _UINT++;
-            break;
+            VM_NEXT();
 
-         case OP_LOADVAR_FLT:
+         VM_CASE(OP_LOADVAR_FLT):
             floatStack[_FLT+1] = gEvalState.getFloatVariable();
             _FLT++;
-            break;
+            VM_NEXT();
 
-         case OP_LOADVAR_STR:
+         VM_CASE(OP_LOADVAR_STR):
             val = gEvalState.getStringVariable();
             STR.setStringValue(val);
-            break;
+            VM_NEXT();
 
-         case OP_SAVEVAR_UINT:
+         VM_CASE(OP_SAVEVAR_UINT):
             gEvalState.setIntVariable(intStack[_UINT]);
-            break;
+            VM_NEXT();
 
-         case OP_SAVEVAR_FLT:
+         VM_CASE(OP_SAVEVAR_FLT):
             gEvalState.setFloatVariable(floatStack[_FLT]);
-            break;
+            VM_NEXT();
 
-         case OP_SAVEVAR_STR:
+         VM_CASE(OP_SAVEVAR_STR):
             gEvalState.setStringVariable(STR.getStringValue());
-            break;
+            VM_NEXT();
 
-         case OP_SETCUROBJECT:
+         VM_CASE(OP_SETCUROBJECT):
             // Save the previous object for parsing vector fields.
             prevObject = curObject;
             val = STR.getStringValue();
@@ -1270,9 +1511,9 @@ breakContinue:
                }
             }
             curObject = Sim::findObject(val);
-            break;
+            VM_NEXT();
 
-         case OP_SETCUROBJECT_INTERNAL:
+         VM_CASE(OP_SETCUROBJECT_INTERNAL):
             ++ip; // To skip the recurse flag if the object wasn't found
             if(curObject)
             {
@@ -1291,32 +1532,32 @@ breakContinue:
                   intStack[_UINT] = 0;
                }
             }
-            break;
+            VM_NEXT();
 
-         case OP_SETCUROBJECT_NEW:
+         VM_CASE(OP_SETCUROBJECT_NEW):
             curObject = currentNewObject;
-            break;
+            VM_NEXT();
 
-         case OP_SETCURFIELD:
+         VM_CASE(OP_SETCURFIELD):
             // Save the previous field for parsing vector fields.
             prevField = curField;
             dStrcpy( prevFieldArray, curFieldArray );
             curField = U32toSTE(code[ip]);
             curFieldArray[0] = 0;
             ip++;
-            break;
+            VM_NEXT();
 
-         case OP_SETCURFIELD_ARRAY:
+         VM_CASE(OP_SETCURFIELD_ARRAY):
             dStrcpy(curFieldArray, STR.getStringValue());
-            break;
+            VM_NEXT();
 
-         case OP_SETCURFIELD_TYPE:
+         VM_CASE(OP_SETCURFIELD_TYPE):
             if(curObject)
                curObject->setDataFieldType(code[ip], curField, curFieldArray);
             ip++;
-            break;
+            VM_NEXT();
 
-         case OP_LOADFIELD_UINT:
+         VM_CASE(OP_LOADFIELD_UINT):
             if(curObject)
                intStack[_UINT+1] = U32(dAtoi(curObject->getDataField(curField, curFieldArray)));
             else
@@ -1327,9 +1568,9 @@ breakContinue:
                intStack[_UINT+1] = dAtoi( valBuffer );
             }
             _UINT++;
-            break;
+            VM_NEXT();
 
-         case OP_LOADFIELD_FLT:
+         VM_CASE(OP_LOADFIELD_FLT):
             if(curObject)
                floatStack[_FLT+1] = dAtof(curObject->getDataField(curField, curFieldArray));
             else
@@ -1340,9 +1581,9 @@ breakContinue:
                floatStack[_FLT+1] = dAtof( valBuffer );
             }
             _FLT++;
-            break;
+            VM_NEXT();
 
-         case OP_LOADFIELD_STR:
+         VM_CASE(OP_LOADFIELD_STR):
             if(curObject)
             {
                val = curObject->getDataField(curField, curFieldArray);
@@ -1355,9 +1596,9 @@ breakContinue:
                getFieldComponent( prevObject, prevField, prevFieldArray, curField, valBuffer );
                STR.setStringValue( valBuffer );
             }
-            break;
+            VM_NEXT();
 
-         case OP_SAVEFIELD_UINT:
+         VM_CASE(OP_SAVEFIELD_UINT):
             STR.setIntValue(intStack[_UINT]);
             if(curObject)
                curObject->setDataField(curField, curFieldArray, STR.getStringValue());
@@ -1368,9 +1609,9 @@ breakContinue:
                setFieldComponent( prevObject, prevField, prevFieldArray, curField );
                prevObject = NULL;
             }
-            break;
+            VM_NEXT();
 
-         case OP_SAVEFIELD_FLT:
+         VM_CASE(OP_SAVEFIELD_FLT):
             STR.setFloatValue(floatStack[_FLT]);
             if(curObject)
                curObject->setDataField(curField, curFieldArray, STR.getStringValue());
@@ -1381,9 +1622,9 @@ breakContinue:
                setFieldComponent( prevObject, prevField, prevFieldArray, curField );
                prevObject = NULL;
             }
-            break;
+            VM_NEXT();
 
-         case OP_SAVEFIELD_STR:
+         VM_CASE(OP_SAVEFIELD_STR):
             if(curObject)
                curObject->setDataField(curField, curFieldArray, STR.getStringValue());
             else
@@ -1393,64 +1634,64 @@ breakContinue:
                setFieldComponent( prevObject, prevField, prevFieldArray, curField );
                prevObject = NULL;
             }
-            break;
+            VM_NEXT();
 
-         case OP_STR_TO_UINT:
+         VM_CASE(OP_STR_TO_UINT):
             intStack[_UINT+1] = STR.getIntValue();
             _UINT++;
-            break;
+            VM_NEXT();
 
-         case OP_STR_TO_FLT:
+         VM_CASE(OP_STR_TO_FLT):
             floatStack[_FLT+1] = STR.getFloatValue();
             _FLT++;
-            break;
+            VM_NEXT();
 
-         case OP_STR_TO_NONE:
+         VM_CASE(OP_STR_TO_NONE):
             // This exists simply to deal with certain typecast situations.
-            break;
+            VM_NEXT();
 
-         case OP_FLT_TO_UINT:
+         VM_CASE(OP_FLT_TO_UINT):
             intStack[_UINT+1] = (S64)floatStack[_FLT];
             _FLT--;
             _UINT++;
-            break;
+            VM_NEXT();
 
-         case OP_FLT_TO_STR:
+         VM_CASE(OP_FLT_TO_STR):
             STR.setFloatValue(floatStack[_FLT]);
             _FLT--;
-            break;
+            VM_NEXT();
 
-         case OP_FLT_TO_NONE:
+         VM_CASE(OP_FLT_TO_NONE):
             _FLT--;
-            break;
+            VM_NEXT();
 
-         case OP_UINT_TO_FLT:
+         VM_CASE(OP_UINT_TO_FLT):
             floatStack[_FLT+1] = (F32)intStack[_UINT];
             _UINT--;
             _FLT++;
-            break;
+            VM_NEXT();
 
-         case OP_UINT_TO_STR:
+         VM_CASE(OP_UINT_TO_STR):
             STR.setIntValue(intStack[_UINT]);
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_UINT_TO_NONE:
+         VM_CASE(OP_UINT_TO_NONE):
             _UINT--;
-            break;
+            VM_NEXT();
 
-         case OP_LOADIMMED_UINT:
+         VM_CASE(OP_LOADIMMED_UINT):
             intStack[_UINT+1] = code[ip++];
             _UINT++;
-            break;
+            VM_NEXT();
 
-         case OP_LOADIMMED_FLT:
+         VM_CASE(OP_LOADIMMED_FLT):
             floatStack[_FLT+1] = curFloatTable[code[ip]];
             ip++;
             _FLT++;
-            break;
+            VM_NEXT();
             
-         case OP_TAG_TO_STR:
+         VM_CASE(OP_TAG_TO_STR):
             code[ip-1] = OP_LOADIMMED_STR;
             // it's possible the string has already been converted
             if(U8(curStringTable[code[ip]]) != StringTagPrefixByte)
@@ -1459,11 +1700,11 @@ breakContinue:
                dSprintf(curStringTable + code[ip] + 1, 7, "%d", id);
                *(curStringTable + code[ip]) = StringTagPrefixByte;
             }
-         case OP_LOADIMMED_STR:
+         VM_CASE(OP_LOADIMMED_STR):
             STR.setStringValue(curStringTable + code[ip++]);
-            break;
+            VM_NEXT();
 
-         case OP_DOCBLOCK_STR:
+         VM_CASE(OP_DOCBLOCK_STR):
             {
                // If the first word of the doc is '\class' or '@class', then this
                // is a namespace doc block, otherwise it is a function doc block.
@@ -1492,33 +1733,38 @@ breakContinue:
                   curFNDocBlock = docblock;
             }
 
-            break;
+            VM_NEXT();
 
-         case OP_LOADIMMED_IDENT:
+         VM_CASE(OP_LOADIMMED_IDENT):
             STR.setStringValue(U32toSTE(code[ip++]));
-            break;
+            VM_NEXT();
 
-         case OP_CALLFUNC_RESOLVE:
+         VM_CASE(OP_CALLFUNC_RESOLVE):
             // This deals with a function that is potentially living in a namespace.
             fnNamespace = U32toSTE(code[ip+1]);
             fnName      = U32toSTE(code[ip]);
 
-            // Try to look it up.
-            ns = Namespace::find(fnNamespace);
-            nsEntry = ns->lookup(fnName);
+            // Try to look it up.  The namespace a name resolves to never
+            // changes, so once the call site has seen it there is no need
+            // to walk the namespace list again.
+            {
+               Namespace::CallSiteCache &cache = callSiteCaches[code[ip+3]];
+               ns = cache.mNamespace ? cache.mNamespace : Namespace::find(fnNamespace);
+               nsEntry = ns->lookup(fnName, cache);
+            }
             if(!nsEntry)
             {
-               ip+= 3;
+               ip+= 4;
                Con::warnf(ConsoleLogEntry::General,
                   "%s: Unable to find function %s%s%s",
-                  getFileLine(ip-4), fnNamespace ? fnNamespace : "",
+                  getFileLine(ip-5), fnNamespace ? fnNamespace : "",
                   fnNamespace ? "::" : "", fnName);
                STR.popFrame();
-               break;
+               VM_NEXT();
             }
             // Now fall through to OP_CALLFUNC...
 
-         case OP_CALLFUNC:
+         VM_CASE(OP_CALLFUNC):
          {
             // This routingId is set when we query the object as to whether
             // it handles this method.  It is set to an enum from the table
@@ -1536,9 +1782,13 @@ breakContinue:
             }
 
             U32 callType = code[ip+2];
+            Namespace::CallSiteCache &callSiteCache = callSiteCaches[code[ip+3]];
+
+            ip += 4;
 
-            ip += 3;
-            STR.getArgcArgv(fnName, &callArgc, &callArgv);
+            // Numeric arguments stay unformatted until something needs them
+            // as strings; script functions take them as they are.
+            STR.getArgcArgv(fnName, &callArgc, &callArgv, &callArgValues);
 
             const char *componentReturnValue = "";
 
@@ -1548,35 +1798,44 @@ breakContinue:
                {
                   // We must not have come from OP_CALLFUNC_RESOLVE, so figure out
                   // our own entry.
-                  nsEntry = Namespace::global()->lookup( fnName );
+                  nsEntry = Namespace::global()->lookup( fnName, callSiteCache );
                }
                ns = NULL;
             }
             else if(callType == FuncCallExprNode::MethodCall)
             {
                saveObject = gEvalState.thisObject;
-               gEvalState.thisObject = Sim::findObject(callArgv[1]);
+               if(callArgValues[1].type == ConsoleValue::TypeInt)
+                  gEvalState.thisObject = Sim::findObject(SimObjectId(callArgValues[1].ival));
+               else
+               {
+                  StringStack::formatArgs(2, callArgv, callArgValues);
+                  gEvalState.thisObject = Sim::findObject(callArgv[1]);
+               }
                if(!gEvalState.thisObject)
                {
+                  StringStack::formatArgs(2, callArgv, callArgValues);
+
                   // Go back to the previous saved object.
                   gEvalState.thisObject = saveObject;
 
-                  Con::warnf(ConsoleLogEntry::General,"%s: Unable to find object: '%s' attempting to call function '%s'", getFileLine(ip-4), callArgv[1], fnName);
+                  Con::warnf(ConsoleLogEntry::General,"%s: Unable to find object: '%s' attempting to call function '%s'", getFileLine(ip-5), callArgv[1], fnName);
                   STR.popFrame();
-                  break;
+                  VM_NEXT();
                }
                
                bool handlesMethod = gEvalState.thisObject->handlesConsoleMethod(fnName,&routingId);
                if( handlesMethod && routingId == MethodOnComponent )
                {
                   ICallMethod *pComponent = dynamic_cast<ICallMethod *>( gEvalState.thisObject );
+                  StringStack::formatArgs(callArgc, callArgv, callArgValues);
                   if( pComponent )
                      componentReturnValue = pComponent->callMethodArgList( callArgc, callArgv, false );
                }
                
                ns = gEvalState.thisObject->getNamespace();
                if(ns)
-                  nsEntry = ns->lookup(fnName);
+                  nsEntry = ns->lookup(fnName, callSiteCache);
                else
                   nsEntry = NULL;
             }
@@ -1586,7 +1845,7 @@ breakContinue:
                {
                   ns = thisNamespace->mParent;
                   if(ns)
-                     nsEntry = ns->lookup(fnName);
+                     nsEntry = ns->lookup(fnName, callSiteCache);
                   else
                      nsEntry = NULL;
                }
@@ -1609,7 +1868,7 @@ breakContinue:
             {
                if(!noCalls && !( routingId == MethodOnComponent ) )
                {
-                  Con::warnf(ConsoleLogEntry::General,"%s: Unknown command %s.", getFileLine(ip-4), fnName);
+                  Con::warnf(ConsoleLogEntry::General,"%s: Unknown command %s.", getFileLine(ip-5), fnName);
                   if(callType == FuncCallExprNode::MethodCall)
                   {
                      Con::warnf(ConsoleLogEntry::General, "  Object %s(%d) %s",
@@ -1624,35 +1883,44 @@ breakContinue:
                else
                   STR.setStringValue( "" );
 
-               break;
+               VM_NEXT();
             }
             if(nsEntry->mType == Namespace::Entry::ConsoleFunctionType)
             {
                const char *ret = "";
+               ConsoleValue callReturnValue;
                if(nsEntry->mFunctionOffset)
-                  ret = nsEntry->mCode->exec(nsEntry->mFunctionOffset, fnName, nsEntry->mNamespace, callArgc, callArgv, false, nsEntry->mPackage);
+                  ret = nsEntry->mCode->exec(nsEntry->mFunctionOffset, fnName, nsEntry->mNamespace, callArgc, callArgv, false, nsEntry->mPackage, -1, callArgValues, &callReturnValue);
                
                STR.popFrame();
-               STR.setStringValue(ret);
+               if(callReturnValue.type == ConsoleValue::TypeInt)
+                  ip = pushIntCallResult(code, ip, callReturnValue.ival);
+               else if(callReturnValue.type == ConsoleValue::TypeFloat)
+                  ip = pushFloatCallResult(code, ip, callReturnValue.fval);
+               else
+                  STR.setStringValue(ret);
             }
             else
             {
+               // Engine functions only take strings.
+               StringStack::formatArgs(callArgc, callArgv, callArgValues);
+
                const char* nsName = ns? ns->mName: "";
 #ifndef TORQUE_DEBUG
                // [tom, 12/13/2006] This stops tools functions from working in the console,
                // which is useful behavior when debugging so I'm ifdefing this out for debug builds.
                if(nsEntry->mToolOnly && ! Con::isCurrentScriptToolScript())
                {
-                  Con::errorf(ConsoleLogEntry::Script, "%s: %s::%s - attempting to call tools only function from outside of tools.", getFileLine(ip-4), nsName, fnName);
+                  Con::errorf(ConsoleLogEntry::Script, "%s: %s::%s - attempting to call tools only function from outside of tools.", getFileLine(ip-5), nsName, fnName);
                }
                else
 #endif
                if((nsEntry->mMinArgs && S32(callArgc) < nsEntry->mMinArgs) || (nsEntry->mMaxArgs && S32(callArgc) > nsEntry->mMaxArgs))
                {
                   Con::warnf(ConsoleLogEntry::Script, "%s: %s::%s - wrong number of arguments (got %i, expected min %i and max %i).",
-                     getFileLine(ip-4), nsName, fnName,
+                     getFileLine(ip-5), nsName, fnName,
                      callArgc, nsEntry->mMinArgs, nsEntry->mMaxArgs);
-                  Con::warnf(ConsoleLogEntry::Script, "%s: usage: %s", getFileLine(ip-4), nsEntry->mUsage);
+                  Con::warnf(ConsoleLogEntry::Script, "%s: usage: %s", getFileLine(ip-5), nsEntry->mUsage);
                   STR.popFrame();
                }
                else
@@ -1673,50 +1941,20 @@ breakContinue:
                      {
                         S32 result = nsEntry->cb.mIntCallbackFunc(gEvalState.thisObject, callArgc, callArgv);
                         STR.popFrame();
-                        if(code[ip] == OP_STR_TO_UINT)
-                        {
-                           ip++;
-                           intStack[++_UINT] = result;
-                           break;
-                        }
-                        else if(code[ip] == OP_STR_TO_FLT)
-                        {
-                           ip++;
-                           floatStack[++_FLT] = result;
-                           break;
-                        }
-                        else if(code[ip] == OP_STR_TO_NONE)
-                           ip++;
-                        else
-                           STR.setIntValue(result);
+                        ip = pushIntCallResult(code, ip, result);
                         break;
                      }
                      case Namespace::Entry::FloatCallbackType:
                      {
                         F64 result = nsEntry->cb.mFloatCallbackFunc(gEvalState.thisObject, callArgc, callArgv);
                         STR.popFrame();
-                        if(code[ip] == OP_STR_TO_UINT)
-                        {
-                           ip++;
-                           intStack[++_UINT] = (S64)result;
-                           break;
-                        }
-                        else if(code[ip] == OP_STR_TO_FLT)
-                        {
-                           ip++;
-                           floatStack[++_FLT] = result;
-                           break;
-                        }
-                        else if(code[ip] == OP_STR_TO_NONE)
-                           ip++;
-                        else
-                           STR.setFloatValue(result);
+                        ip = pushFloatCallResult(code, ip, result);
                         break;
                      }
                      case Namespace::Entry::VoidCallbackType:
                         nsEntry->cb.mVoidCallbackFunc(gEvalState.thisObject, callArgc, callArgv);
                         if( code[ ip ] != OP_STR_TO_NONE && Con::getBoolVariable( "$Con::warnVoidAssignment", true ) )
-                           Con::warnf(ConsoleLogEntry::General, "%s: Call to %s in %s uses result of void function call.", getFileLine(ip-4), fnName, functionName);
+                           Con::warnf(ConsoleLogEntry::General, "%s: Call to %s in %s uses result of void function call.", getFileLine(ip-5), fnName, functionName);
                         
                         STR.popFrame();
                         STR.setStringValue("");
@@ -1725,22 +1963,7 @@ breakContinue:
                      {
                         bool result = nsEntry->cb.mBoolCallbackFunc(gEvalState.thisObject, callArgc, callArgv);
                         STR.popFrame();
-                        if(code[ip] == OP_STR_TO_UINT)
-                        {
-                           ip++;
-                           intStack[++_UINT] = result;
-                           break;
-                        }
-                        else if(code[ip] == OP_STR_TO_FLT)
-                        {
-                           ip++;
-                           floatStack[++_FLT] = result;
-                           break;
-                        }
-                        else if(code[ip] == OP_STR_TO_NONE)
-                           ip++;
-                        else
-                           STR.setIntValue(result);
+                        ip = pushIntCallResult(code, ip, result);
                         break;
                      }
                   }
@@ -1749,43 +1972,64 @@ breakContinue:
 
             if(callType == FuncCallExprNode::MethodCall)
                gEvalState.thisObject = saveObject;
-            break;
+            VM_NEXT();
          }
-         case OP_ADVANCE_STR:
+         VM_CASE(OP_ADVANCE_STR):
             STR.advance();
-            break;
-         case OP_ADVANCE_STR_APPENDCHAR:
+            VM_NEXT();
+         VM_CASE(OP_ADVANCE_STR_APPENDCHAR):
             STR.advanceChar(code[ip++]);
-            break;
+            VM_NEXT();
 
-         case OP_ADVANCE_STR_COMMA:
+         VM_CASE(OP_ADVANCE_STR_COMMA):
             STR.advanceChar('_');
-            break;
+            VM_NEXT();
 
-         case OP_ADVANCE_STR_NUL:
+         VM_CASE(OP_ADVANCE_STR_NUL):
             STR.advanceChar(0);
-            break;
+            VM_NEXT();
 
-         case OP_REWIND_STR:
+         VM_CASE(OP_REWIND_STR):
             STR.rewind();
-            break;
+            VM_NEXT();
 
-         case OP_TERMINATE_REWIND_STR:
+         VM_CASE(OP_TERMINATE_REWIND_STR):
             STR.rewindTerminate();
-            break;
+            VM_NEXT();
 
-         case OP_COMPARE_STR:
+         VM_CASE(OP_COMPARE_STR):
             intStack[++_UINT] = STR.compare();
-            break;
-         case OP_PUSH:
+            VM_NEXT();
+         VM_CASE(OP_PUSH):
             STR.push();
-            break;
+            VM_NEXT();
+
+         VM_CASE(OP_PUSH_UINT):
+            STR.pushInt(intStack[_UINT--]);
+            VM_NEXT();
+
+         VM_CASE(OP_PUSH_FLT):
+            STR.pushFloat(floatStack[_FLT--]);
+            VM_NEXT();
+
+         VM_CASE(OP_PUSH_VAR):
+            // Pass numeric variables on as numbers.
+            if(gEvalState.currentVariable && gEvalState.currentVariable->type == Dictionary::Entry::TypeInternalInt)
+               STR.pushInt(gEvalState.getIntVariable());
+            else if(gEvalState.currentVariable && gEvalState.currentVariable->type == Dictionary::Entry::TypeInternalFloat)
+               STR.pushFloat(gEvalState.getFloatVariable());
+            else
+            {
+               STR.setStringValue(gEvalState.getStringVariable());
+               STR.push();
+            }
+            VM_NEXT();
 
-         case OP_PUSH_FRAME:
+         VM_CASE(OP_PUSH_FRAME):
             STR.pushFrame();
-            break;
+            VM_NEXT();
 
-         case OP_ASSERT:
+         VM_CASE(OP_ASSERT):
          {
             if( !intStack[_UINT--] )
             {
@@ -1809,10 +2053,10 @@ breakContinue:
             }
 
             ip++;
-            break;
+            VM_NEXT();
          }
 
-         case OP_BREAK:
+         VM_CASE(OP_BREAK):
          {
             //append the ip and codeptr before managing the breakpoint!
             AssertFatal( gEvalState.getStackDepth() > 0, "Empty eval stack on break!");
@@ -1827,13 +2071,13 @@ breakContinue:
             goto breakContinue;
          }
          
-         case OP_ITER_BEGIN_STR:
+         VM_CASE(OP_ITER_BEGIN_STR):
          {
             iterStack[ _ITER ].mIsStringIter = true;
             /* fallthrough */
          }
          
-         case OP_ITER_BEGIN:
+         VM_CASE(OP_ITER_BEGIN):
          {
             StringTableEntry varName = U32toSTE( code[ ip ] );
             U32 failIp = code[ ip + 1 ];
@@ -1872,10 +2116,10 @@ breakContinue:
             STR.push();
             
             ip += 2;
-            break;
+            VM_NEXT();
          }
          
-         case OP_ITER:
+         VM_CASE(OP_ITER):
          {
             U32 breakIp = code[ ip ];
             IterStackRecord& iter = iterStack[ _ITER - 1 ];
@@ -1935,10 +2179,10 @@ breakContinue:
             }
             
             ++ ip;
-            break;
+            VM_NEXT();
          }
          
-         case OP_ITER_END:
+         VM_CASE(OP_ITER_END):
          {
             -- _ITER;
             -- iterDepth;
@@ -1946,10 +2190,10 @@ breakContinue:
             STR.rewind();
             
             iterStack[ _ITER ].mIsStringIter = false;
-            break;
+            VM_NEXT();
          }
          
-         case OP_INVALID:
+         VM_CASE(OP_INVALID):
 
          default:
             // error!
@@ -1968,6 +2212,11 @@ execFinished:
    {
       if(gEvalState.traceOn)
       {
+         if(returnValue && returnValue->type == ConsoleValue::TypeInt)
+            STR.setIntValue(returnValue->ival);
+         else if(returnValue && returnValue->type == ConsoleValue::TypeFloat)
+            STR.setFloatValue(returnValue->fval);
+
          traceBuffer[0] = 0;
          dStrcat(traceBuffer, "Leaving ");
 
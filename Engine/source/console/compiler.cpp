@@ -32,6 +32,7 @@
 #include "console/consoleInternal.h"
 #include "core/stream/fileStream.h"
 #include "console/compiler.h"
+#include "console/codeBlock.h"
 
 #include "console/simBase.h"
 
@@ -49,7 +50,7 @@ namespace Compiler
          return 0;
       else if(file)
       {
-         Con::warnf(ConsoleLogEntry::General, "%s (%d): string always evaluates to 0.", file, line);
+         diagnosticf(ConsoleLogEntry::Warning, "%s (%d): string always evaluates to 0.", file, line);
          return 0;
       }
       return 0;
@@ -57,17 +58,96 @@ namespace Compiler
 
    //------------------------------------------------------------
 
-   CompilerStringTable *gCurrentStringTable, gGlobalStringTable, gFunctionStringTable;
-   CompilerFloatTable  *gCurrentFloatTable,  gGlobalFloatTable,  gFunctionFloatTable;
-   DataChunker          gConsoleAllocator;
-   CompilerIdentTable   gIdentTable;
-   CodeBlock           *gCurBreakBlock;
+   /// The tables and allocator the compiler fills in while it turns a script
+   /// into bytecode.  Each thread that compiles gets its own so that scripts
+   /// can be compiled on worker threads.
+   struct CompilerState
+   {
+      CompilerStringTable *currentStringTable, globalStringTable, functionStringTable;
+      CompilerFloatTable  *currentFloatTable,  globalFloatTable,  functionFloatTable;
+      DataChunker          consoleAllocator;
+      CompilerIdentTable   identTable;
+      CompilerLocalTable   localTable;
+      CodeBlock           *curBreakBlock;
+      Vector<Diagnostic>   diagnostics;
+
+      CompilerState()
+         : currentStringTable( &globalStringTable ),
+           currentFloatTable( &globalFloatTable ),
+           curBreakBlock( NULL )
+      {
+         globalStringTable.reset();
+         functionStringTable.reset();
+         globalFloatTable.reset();
+         functionFloatTable.reset();
+         identTable.reset();
+         localTable.reset();
+      }
+   };
+
+   static TORQUE_THREAD_LOCAL CompilerState *gState;
+
+   static inline CompilerState &getState()
+   {
+      if(!gState)
+         gState = new CompilerState;
+      return *gState;
+   }
+
+   void freeThreadState()
+   {
+      delete gState;
+      gState = NULL;
+   }
+
+   void diagnosticf(ConsoleLogEntry::Level level, const char *fmt, ...)
+   {
+      char buffer[1024];
+      va_list args;
+      va_start(args, fmt);
+      dVsprintf(buffer, sizeof(buffer), fmt, args);
+      va_end(args);
+
+      if(!Con::isMainThread())
+      {
+         getState().diagnostics.increment();
+         Diagnostic &diagnostic = getState().diagnostics.last();
+         diagnostic.level = level;
+         diagnostic.message = buffer;
+         return;
+      }
+
+      if(level == ConsoleLogEntry::Error)
+         Con::errorf(ConsoleLogEntry::General, "%s", buffer);
+      else
+         Con::warnf(ConsoleLogEntry::General, "%s", buffer);
+   }
+
+   void takeDiagnostics(Vector<Diagnostic> &outDiagnostics)
+   {
+      if(!gState)
+         return;
+
+      outDiagnostics.merge(gState->diagnostics);
+      gState->diagnostics.clear();
+   }
+
+   void printDiagnostics(const Vector<Diagnostic> &diagnostics)
+   {
+      for(U32 i = 0; i < diagnostics.size(); i++)
+      {
+         if(diagnostics[i].level == ConsoleLogEntry::Error)
+            Con::errorf(ConsoleLogEntry::General, "%s", diagnostics[i].message.c_str());
+         else
+            Con::warnf(ConsoleLogEntry::General, "%s", diagnostics[i].message.c_str());
+      }
+   }
 
    //------------------------------------------------------------
 
 
-   CodeBlock *getBreakCodeBlock()         { return gCurBreakBlock; }
-   void setBreakCodeBlock(CodeBlock *cb)  { gCurBreakBlock = cb;   }
+   CodeBlock *getBreakCodeBlock()         { return getState().curBreakBlock; }
+   void setBreakCodeBlock(CodeBlock *cb)  { getState().curBreakBlock = cb;   }
 
    //------------------------------------------------------------
 
@@ -83,47 +163,63 @@ namespace Compiler
       return 0;
    }
 
-   U32 (*STEtoU32)(StringTableEntry ste, U32 ip) = evalSTEtoU32;
+   TORQUE_THREAD_LOCAL U32 (*STEtoU32)(StringTableEntry ste, U32 ip) = evalSTEtoU32;
 
    //------------------------------------------------------------
 
-   bool gSyntaxError = false;
+   TORQUE_THREAD_LOCAL bool gSyntaxError = false;
 
    //------------------------------------------------------------
 
-   CompilerStringTable *getCurrentStringTable()  { return gCurrentStringTable;  }
-   CompilerStringTable &getGlobalStringTable()   { return gGlobalStringTable;   }
-   CompilerStringTable &getFunctionStringTable() { return gFunctionStringTable; }
+   CompilerStringTable *getCurrentStringTable()  { return getState().currentStringTable;  }
+   CompilerStringTable &getGlobalStringTable()   { return getState().globalStringTable;   }
+   CompilerStringTable &getFunctionStringTable() { return getState().functionStringTable; }
 
-   void setCurrentStringTable (CompilerStringTable* cst) { gCurrentStringTable  = cst; }
+   void setCurrentStringTable (CompilerStringTable* cst) { getState().currentStringTable  = cst; }
 
-   CompilerFloatTable *getCurrentFloatTable()    { return gCurrentFloatTable;   }
-   CompilerFloatTable &getGlobalFloatTable()     { return gGlobalFloatTable;    }
-   CompilerFloatTable &getFunctionFloatTable()   { return gFunctionFloatTable; }
+   CompilerFloatTable *getCurrentFloatTable()    { return getState().currentFloatTable;   }
+   CompilerFloatTable &getGlobalFloatTable()     { return getState().globalFloatTable;    }
+   CompilerFloatTable &getFunctionFloatTable()   { return getState().functionFloatTable; }
 
-   void setCurrentFloatTable (CompilerFloatTable* cst) { gCurrentFloatTable  = cst; }
+   void setCurrentFloatTable (CompilerFloatTable* cst) { getState().currentFloatTable  = cst; }
 
-   CompilerIdentTable &getIdentTable() { return gIdentTable; }
+   CompilerIdentTable &getIdentTable() { return getState().identTable; }
+
+   CompilerLocalTable &getLocalTable() { return getState().localTable; }
 
    void precompileIdent(StringTableEntry ident)
    {
       if(ident)
-         gGlobalStringTable.add(ident);
+         getGlobalStringTable().add(ident);
+   }
+
+   void precompileLocal(StringTableEntry varName)
+   {
+      if(CodeBlock::smInFunction && varName[0] == '%')
+         getLocalTable().add(varName);
+   }
+
+   S32 getLocalSlot(StringTableEntry varName)
+   {
+      if(!CodeBlock::smInFunction || varName[0] != '%')
+         return -1;
+      return getLocalTable().lookup(varName);
    }
 
    void resetTables()
    {
-      setCurrentStringTable(&gGlobalStringTable);
-      setCurrentFloatTable(&gGlobalFloatTable);
+      setCurrentStringTable(&getGlobalStringTable());
+      setCurrentFloatTable(&getGlobalFloatTable());
       getGlobalFloatTable().reset();
       getGlobalStringTable().reset();
       getFunctionFloatTable().reset();
       getFunctionStringTable().reset();
       getIdentTable().reset();
+      getLocalTable().reset();
    }
 
-   void *consoleAlloc(U32 size) { return gConsoleAllocator.alloc(size);  }
-   void consoleAllocReset()     { gConsoleAllocator.freeBlocks(); }
+   void *consoleAlloc(U32 size) { return getState().consoleAllocator.alloc(size);  }
+   void consoleAllocReset()     { getState().consoleAllocator.freeBlocks(); }
 
 }
 
@@ -248,9 +344,45 @@ void CompilerIdentTable::reset()
    list = NULL;
 }
 
+//-------------------------------------------------------------------------
+
+U32 CompilerLocalTable::add(StringTableEntry name, bool isArgument)
+{
+   Entry **walk;
+   for(walk = &list; *walk; walk = &((*walk)->next))
+   {
+      if(!isArgument && (*walk)->name == name)
+         return (*walk)->slot;
+   }
+
+   Entry *newEntry = (Entry *) consoleAlloc(sizeof(Entry));
+   *walk = newEntry;
+   newEntry->name = name;
+   newEntry->slot = count++;
+   newEntry->next = NULL;
+   return newEntry->slot;
+}
+
+S32 CompilerLocalTable::lookup(StringTableEntry name)
+{
+   S32 slot = -1;
+   for(Entry *walk = list; walk; walk = walk->next)
+   {
+      if(walk->name == name)
+         slot = walk->slot;
+   }
+   return slot;
+}
+
+void CompilerLocalTable::reset()
+{
+   list = NULL;
+   count = 0;
+}
+
 void CompilerIdentTable::add(StringTableEntry ste, U32 ip)
 {
-   U32 index = gGlobalStringTable.add(ste, false);
+   U32 index = getGlobalStringTable().add(ste, false);
    Entry *newEntry = (Entry *) consoleAlloc(sizeof(Entry));
    newEntry->offset = index;
    newEntry->ip = ip;
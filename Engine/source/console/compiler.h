@@ -28,6 +28,9 @@ class Stream;
 class DataChunker;
 
 #include "platform/platform.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "core/util/str.h"
 #include "console/ast.h"
 #include "console/codeBlock.h"
 
@@ -54,6 +57,8 @@ namespace Compiler
       OP_RETURN,
       // fixes a bug when not explicitly returning a value
       OP_RETURN_VOID,
+      OP_RETURN_UINT,      ///< Return a number without formatting it.
+      OP_RETURN_FLT,
       OP_CMPEQ,
       OP_CMPGR,
       OP_CMPGE,
@@ -83,6 +88,8 @@ namespace Compiler
       OP_SETCURVAR_CREATE,
       OP_SETCURVAR_ARRAY,
       OP_SETCURVAR_ARRAY_CREATE,
+      OP_SETCURVAR_LOCAL,        ///< Select a local by its frame slot.
+      OP_SETCURVAR_LOCAL_CREATE,
 
       OP_LOADVAR_UINT,
       OP_LOADVAR_FLT,
@@ -137,6 +144,9 @@ namespace Compiler
       OP_COMPARE_STR,
 
       OP_PUSH,
+      OP_PUSH_UINT,        ///< Push a call argument without formatting it.
+      OP_PUSH_FLT,
+      OP_PUSH_VAR,         ///< Push the current variable with its own type.
       OP_PUSH_FRAME,
 
       OP_ASSERT,
@@ -218,12 +228,38 @@ namespace Compiler
 
    //------------------------------------------------------------
 
+   /// The locals of the function being compiled, each with its own slot
+   /// in the function's frame.  Arguments take the first slots.
+   struct CompilerLocalTable
+   {
+      struct Entry
+      {
+         StringTableEntry name;
+         U32 slot;
+         Entry *next;
+      };
+      Entry *list;
+      U32 count;
+
+      /// Give @a name a new slot unless it already has one.  Arguments
+      /// always get a new slot, so a repeated argument name refers to the
+      /// last one, as it does when arguments are assigned by name.
+      U32 add(StringTableEntry name, bool isArgument = false);
+
+      /// Return the slot of @a name, or -1 if it doesn't have one.
+      S32 lookup(StringTableEntry name);
+
+      void reset();
+   };
+
+   //------------------------------------------------------------
+
    inline StringTableEntry U32toSTE(U32 u)
    {
       return *((StringTableEntry *) &u);
    }
 
-   extern U32 (*STEtoU32)(StringTableEntry ste, U32 ip);
+   extern TORQUE_THREAD_LOCAL U32 (*STEtoU32)(StringTableEntry ste, U32 ip);
 
    U32 evalSTEtoU32(StringTableEntry ste, U32);
    U32 compileSTEtoU32(StringTableEntry ste, U32 ip);
@@ -242,8 +278,18 @@ namespace Compiler
 
    CompilerIdentTable &getIdentTable();
 
+   CompilerLocalTable &getLocalTable();
+
    void precompileIdent(StringTableEntry ident);
 
+   /// Reserve a frame slot for @a varName if it is a local of the
+   /// function being compiled.
+   void precompileLocal(StringTableEntry varName);
+
+   /// Return the frame slot reserved for @a varName by precompileLocal(),
+   /// or -1 if it has to be looked up by name.
+   S32 getLocalSlot(StringTableEntry varName);
+
    CodeBlock *getBreakCodeBlock();
    void setBreakCodeBlock(CodeBlock *cb);
 
@@ -254,7 +300,30 @@ namespace Compiler
    void *consoleAlloc(U32 size);
    void consoleAllocReset();
 
-   extern bool gSyntaxError;
+   /// Release the calling thread's compiler tables and allocator.  They are
+   /// created again the next time the thread compiles a script.
+   void freeThreadState();
+
+   /// A compile warning or error held back by diagnosticf().
+   struct Diagnostic
+   {
+      ConsoleLogEntry::Level level;
+      String message;
+   };
+
+   /// Report a warning or error found while compiling.  The console may only
+   /// be printed to from the main thread, so on other threads the message is
+   /// kept with the thread's compiler state until takeDiagnostics().
+   void diagnosticf(ConsoleLogEntry::Level level, const char *fmt, ...);
+
+   /// Move the messages diagnosticf() held back on the calling thread to the
+   /// end of @a outDiagnostics.  Call this before freeThreadState().
+   void takeDiagnostics(Vector<Diagnostic> &outDiagnostics);
+
+   /// Print messages collected by takeDiagnostics().  Main thread only.
+   void printDiagnostics(const Vector<Diagnostic> &diagnostics);
+
+   extern TORQUE_THREAD_LOCAL bool gSyntaxError;
 };
 
 #endif
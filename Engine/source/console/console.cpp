@@ -45,7 +45,7 @@ extern StringStack STR;
 
 ConsoleDocFragment* ConsoleDocFragment::smFirst;
 ExprEvalState gEvalState;
-StmtNode *gStatementList;
+TORQUE_THREAD_LOCAL StmtNode *gStatementList;
 ConsoleConstructor *ConsoleConstructor::first = NULL;
 bool gWarnUndefinedScriptVariables;
 
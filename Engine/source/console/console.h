@@ -182,7 +182,11 @@ namespace Con
       /// 09/12/07 - CAF - 43->44 remove newmsg operator
       /// 09/27/07 - RDB - 44->45 Patch from Andreas Kirsch: Added opcode to support correct void return
       /// 01/13/09 - TMS - 45->46 Added script assert
-      DSOVersion = 46,
+      /// 10/16/26 - JP  - 46->47 Typed call arguments and return values
+      /// 10/16/26 - JP  - 47->48 Call site lookup caches
+      /// 10/16/26 - JP  - 48->49 Locals in frame slots
+      /// 10/16/26 - JP  - 49->50 Source CRC in the header
+      DSOVersion = 50,
 
       MaxLineLength = 512,  ///< Maximum length of a line of console input.
       MaxDataTypes = 256    ///< Maximum number of registered data types.
@@ -34,6 +34,8 @@
 #include "platform/platformInput.h"
 #include "core/util/journal/journal.h"
 #include "core/util/uuid.h"
+#include "core/volume.h"
+#include "platform/threads/threadPool.h"
 
 #ifdef TORQUE_DEMO_PURCHASE
 #include "gui/core/guiCanvas.h"
@@ -1745,6 +1747,71 @@ DefineConsoleFunction( getDSOPath, const char*, ( const char* scriptFileName ),,
    return filename;
 }
 
+/// Build the name of the DSO in @a dsoPath that @a scriptFileName compiles to.
+static void getDSOFileName(const char *scriptFileName, StringTableEntry dsoPath, char *buffer, U32 bufferSize)
+{
+   // If the script file extension is '.ed.cs' then compile it to a different compiled extension
+   bool isEditorScript = false;
+   const char *ext = dStrrchr(scriptFileName, '.');
+   if( ext && dStricmp( ext, ".cs" ) == 0 )
+   {
+      const char* ext2 = ext - 3;
+      if( dStricmp( ext2, ".ed.cs" ) == 0 )
+         isEditorScript = true;
+   }
+   else if( ext && dStricmp( ext, ".gui" ) == 0 )
+   {
+      const char* ext2 = ext - 3;
+      if( dStricmp( ext2, ".ed.gui" ) == 0 )
+         isEditorScript = true;
+   }
+
+   const char *filenameOnly = dStrrchr(scriptFileName, '/');
+   if(filenameOnly)
+      ++filenameOnly;
+   else
+      filenameOnly = scriptFileName;
+
+   char pathAndFilename[1024];
+   Platform::makeFullPathName(filenameOnly, pathAndFilename, sizeof(pathAndFilename), dsoPath);
+
+   if( isEditorScript )
+      dStrcpyl(buffer, bufferSize, pathAndFilename, ".edso", NULL);
+   else
+      dStrcpyl(buffer, bufferSize, pathAndFilename, ".dso", NULL);
+}
+
+/// Open the DSO @a dsoFileName and check that it was written by this version
+/// of the compiler and, unless @a sourceCRC is NULL, that it was compiled from
+/// a script with that CRC.  Returns the stream positioned at the compiled code,
+/// or NULL if the DSO is missing or stale.
+static Stream *openCompiledScript(const char *dsoFileName, const U32 *sourceCRC, bool warnIfOld)
+{
+   Stream *stream = FileStream::createAndOpen( dsoFileName, Torque::FS::File::Read );
+   if(!stream)
+      return NULL;
+
+   U32 version;
+   stream->read(&version);
+   if(version != Con::DSOVersion)
+   {
+      if(warnIfOld)
+         Con::warnf("exec: Found an old DSO (%s, ver %d < %d), ignoring.", dsoFileName, version, Con::DSOVersion);
+      delete stream;
+      return NULL;
+   }
+
+   U32 crc;
+   stream->read(&crc);
+   if(sourceCRC && crc != *sourceCRC)
+   {
+      delete stream;
+      return NULL;
+   }
+
+   return stream;
+}
+
 //-----------------------------------------------------------------------------
 
 DefineEngineFunction( compile, bool, ( const char* fileName, bool overrideNoDSO ), ( false ),
@@ -1876,24 +1943,6 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
       return false;
    }
 
-   // Check Editor Extensions
-   bool isEditorScript = false;
-
-   // If the script file extension is '.ed.cs' then compile it to a different compiled extension
-   if( dStricmp( ext, ".cs" ) == 0 )
-   {
-      const char* ext2 = ext - 3;
-      if( dStricmp( ext2, ".ed.cs" ) == 0 )
-         isEditorScript = true;
-   }
-   else if( dStricmp( ext, ".gui" ) == 0 )
-   {
-      const char* ext2 = ext - 3;
-      if( dStricmp( ext2, ".ed.gui" ) == 0 )
-         isEditorScript = true;
-   }
-
-
    StringTableEntry scriptFileName = StringTable->insert(scriptFilenameBuffer);
 
    // Is this a file we should compile? (anything in the prefs path should not be compiled)
@@ -1951,10 +2000,8 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
 
    char nameBuffer[512];
    char* script = NULL;
-   U32 version;
 
    Stream *compiledStream = NULL;
-   Torque::Time scriptModifiedTime, dsoModifiedTime;
 
    // Check here for .edso
    bool edso = false;
@@ -1964,72 +2011,25 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
       dsoFile = scriptFile;
       scriptFile = NULL;
 
-      dsoModifiedTime = dsoFile->getModifiedTime();
       dStrcpy( nameBuffer, scriptFileName );
    }
 
    // If we're supposed to be compiling this file, check to see if there's a DSO
    if(compiled && !edso)
    {
-      const char *filenameOnly = dStrrchr(scriptFileName, '/');
-      if(filenameOnly)
-         ++filenameOnly;
-      else
-         filenameOnly = scriptFileName;
-
-      char pathAndFilename[1024];
-      Platform::makeFullPathName(filenameOnly, pathAndFilename, sizeof(pathAndFilename), dsoPath);
-
-      if( isEditorScript )
-         dStrcpyl(nameBuffer, sizeof(nameBuffer), pathAndFilename, ".edso", NULL);
-      else
-         dStrcpyl(nameBuffer, sizeof(nameBuffer), pathAndFilename, ".dso", NULL);
-
+      getDSOFileName(scriptFileName, dsoPath, nameBuffer, sizeof(nameBuffer));
       dsoFile = Torque::FS::GetFileNode(nameBuffer);
-
-      if(scriptFile != NULL)
-         scriptModifiedTime = scriptFile->getModifiedTime();
-      
-      if(dsoFile != NULL)
-         dsoModifiedTime = dsoFile->getModifiedTime();
-   }
-
-   // Let's do a sanity check to complain about DSOs in the future.
-   //
-   // MM:	This doesn't seem to be working correctly for now so let's just not issue
-   //		the warning until someone knows how to resolve it.
-   //
-   //if(compiled && rCom && rScr && Platform::compareFileTimes(comModifyTime, scrModifyTime) < 0)
-   //{
-      //Con::warnf("exec: Warning! Found a DSO from the future! (%s)", nameBuffer);
-   //}
-
-   // If we had a DSO, let's check to see if we should be reading from it.
-   if(compiled && dsoFile != NULL && (scriptFile == NULL|| (scriptModifiedTime - dsoModifiedTime) > Torque::Time(0)))
-   {
-      compiledStream = FileStream::createAndOpen( nameBuffer, Torque::FS::File::Read );
-      if (compiledStream)
-      {
-         // Check the version!
-         compiledStream->read(&version);
-         if(version != Con::DSOVersion)
-         {
-            Con::warnf("exec: Found an old DSO (%s, ver %d < %d), ignoring.", nameBuffer, version, Con::DSOVersion);
-            delete compiledStream;
-            compiledStream = NULL;
-         }
-      }
    }
 
    // If we're journalling, let's write some info out.
    if(journal && Journal::IsRecording())
       Journal::WriteString(scriptFileName);
 
-   if(scriptFile != NULL && !compiledStream)
+   // Read the source if we have it.  A DSO is only used if it was compiled
+   // from exactly this source, whatever the file times say.
+   U32 scriptCRC = 0;
+   if(scriptFile != NULL)
    {
-      // If we have source but no compiled version, then we need to compile
-      // (and journal as we do so, if that's required).
-
       void *data;
       U32 dataSize = 0;
       Torque::FS::ReadFile(scriptFileName, data, dataSize, true);
@@ -2060,39 +2060,43 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
          }
       }
 
+      scriptCRC = CodeBlock::getSourceCRC(script);
+   }
+   else
+   {
+      if(journal && Journal::IsRecording())
+         Journal::Write(bool(false));
+   }
+
+   // If we had a DSO, let's check to see if we should be reading from it.
+   if(compiled && dsoFile != NULL)
+      compiledStream = openCompiledScript(nameBuffer, script ? &scriptCRC : NULL, true);
+
 #ifndef TORQUE_NO_DSO_GENERATION
-      if(compiled)
-      {
-         // compile this baddie.
+   if(script && compiled && !compiledStream)
+   {
+      // If we have source but no compiled version, then we need to compile.
+
+      // compile this baddie.
 #ifdef TORQUE_DEBUG
-         Con::printf("Compiling %s...", scriptFileName);
+      Con::printf("Compiling %s...", scriptFileName);
 #endif   
 
-         CodeBlock *code = new CodeBlock();
-         code->compile(nameBuffer, scriptFileName, script);
-         delete code;
-         code = NULL;
+      CodeBlock *code = new CodeBlock();
+      code->compile(nameBuffer, scriptFileName, script);
+      delete code;
+      code = NULL;
 
-         compiledStream = FileStream::createAndOpen( nameBuffer, Torque::FS::File::Read );
-         if(compiledStream)
-         {
-            compiledStream->read(&version);
-         }
-         else
-         {
-            // We have to exit out here, as otherwise we get double error reports.
-            delete [] script;
-            execDepth--;
-            return false;
-         }
+      compiledStream = openCompiledScript(nameBuffer, &scriptCRC, false);
+      if(!compiledStream)
+      {
+         // We have to exit out here, as otherwise we get double error reports.
+         delete [] script;
+         execDepth--;
+         return false;
       }
-#endif
-   }
-   else
-   {
-      if(journal && Journal::IsRecording())
-         Journal::Write(bool(false));
    }
+#endif
 
    if(compiledStream)
    {
@@ -2139,6 +2143,133 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
    return ret;
 }
 
+//-----------------------------------------------------------------------------
+
+/// The scripts precompileScripts() brings up to date, handed to
+/// ThreadPool::parallelFor().
+struct ScriptCompileJob
+{
+   struct Script
+   {
+      StringTableEntry scriptFileName;
+      String dsoFileName;
+
+      /// Warnings from compiling on a worker, printed once all are done.
+      Vector< Compiler::Diagnostic > diagnostics;
+   };
+
+   Vector< Script > scripts;
+   volatile U32 numCompiled;
+};
+
+/// Bring the DSOs of scripts [begin, end) of the ScriptCompileJob in @a data
+/// up to date.
+static void compileScripts( U32 begin, U32 end, void* data )
+{
+   ScriptCompileJob* job = static_cast< ScriptCompileJob* >( data );
+   for( U32 i = begin; i < end; i ++ )
+   {
+      ScriptCompileJob::Script& entry = job->scripts[ i ];
+
+      void* fileData = NULL;
+      U32 dataSize = 0;
+      Torque::FS::ReadFile( entry.scriptFileName, fileData, dataSize, true );
+
+      if( fileData && dataSize )
+      {
+         const char* script = static_cast< const char* >( fileData );
+         U32 scriptCRC = CodeBlock::getSourceCRC( script );
+
+         Stream* compiledStream = openCompiledScript( entry.dsoFileName, &scriptCRC, false );
+         if( compiledStream )
+            delete compiledStream;
+         else
+         {
+            CodeBlock* code = new CodeBlock();
+            if( code->compile( entry.dsoFileName, entry.scriptFileName, script ) )
+               dFetchAndAdd( job->numCompiled, 1 );
+            delete code;
+         }
+      }
+      delete [] static_cast< char* >( fileData );
+
+      Compiler::takeDiagnostics( entry.diagnostics );
+   }
+
+   // The main thread takes part in the loop too; it keeps its compiler state.
+   if( !Con::isMainThread() )
+      Compiler::freeThreadState();
+}
+
+DefineEngineFunction( precompileScripts, S32, ( const char* path ), ( "" ),
+   "Compile every script file under the given directory on the global thread pool.\n\n"
+   "Each .cs and .gui file is read and hashed on a worker thread, or on the calling thread, which pitches in, "
+   "and compiled there unless its DSO was already compiled from the same source.  Nothing is executed; call this early during startup and the "
+   "exec() calls that follow, which still run one after another in the order they are made, will find "
+   "their DSOs up to date instead of compiling them one at a time.\n\n"
+   "@param path Directory to search recursively.  Defaults to the directory main.cs is in.\n"
+   "@return The number of scripts that were compiled.\n\n"
+   "@note Scripts that fail to compile are left without a DSO.  exec() compiles them again and reports the errors.  "
+   "Compiler warnings from worker threads are printed once every script is done.\n\n"
+   "@see compile\n"
+   "@see exec\n"
+   "@ingroup Scripting" )
+{
+#ifdef TORQUE_NO_DSO_GENERATION
+   return 0;
+#else
+   if( Con::getBoolVariable( "Scripts::ignoreDSOs" ) )
+      return 0;
+
+   if( path && path[ 0 ] )
+      Con::expandScriptFilename( scriptFilenameBuffer, sizeof( scriptFilenameBuffer ), path );
+   else
+      dStrcpy( scriptFilenameBuffer, Platform::getMainDotCsDir() );
+
+   Vector< String > fileNames;
+   Torque::FS::FindByPattern( Torque::Path( scriptFilenameBuffer ), "*.cs", true, fileNames );
+   Torque::FS::FindByPattern( Torque::Path( scriptFilenameBuffer ), "*.gui", true, fileNames );
+
+   StringTableEntry prefsPath = Platform::getPrefsPath();
+   U32 prefsPathLength = prefsPath ? dStrlen( prefsPath ) : 0;
+
+   ScriptCompileJob job;
+   job.numCompiled = 0;
+
+   for( U32 i = 0; i < fileNames.size(); i ++ )
+   {
+      // Skip whatever exec() would not compile to a DSO.
+      StringTableEntry scriptFileName = StringTable->insert( fileNames[ i ] );
+      if( Platform::isFullPath( Platform::stripBasePath( scriptFileName ) ) )
+         continue;
+      if( prefsPathLength && dStrnicmp( scriptFileName, prefsPath, prefsPathLength ) == 0 )
+         continue;
+
+      StringTableEntry dsoPath = getDSOPath( scriptFileName );
+      if( !dsoPath || !dsoPath[ 0 ] )
+         continue;
+
+      char dsoFileName[ 512 ];
+      getDSOFileName( scriptFileName, dsoPath, dsoFileName, sizeof( dsoFileName ) );
+
+      job.scripts.increment();
+      job.scripts.last().scriptFileName = scriptFileName;
+      job.scripts.last().dsoFileName = dsoFileName;
+   }
+
+   // Execution stays serial, so this thread helps out and only returns to
+   // whatever exec()s come next once every script is done.
+   ThreadPool::GLOBAL().parallelFor( job.scripts.size(), 1, &compileScripts, &job );
+
+   // exec() loads the DSOs without compiling again, so this is the only
+   // chance to report what the compiler found.
+   for( U32 i = 0; i < job.scripts.size(); i ++ )
+      Compiler::printDiagnostics( job.scripts[ i ].diagnostics );
+
+   return job.numCompiled;
+#endif
+}
+
 ConsoleFunction(eval, const char *, 2, 2, "eval(consoleString)")
 {
    TORQUE_UNUSED(argc);
@@ -131,6 +131,13 @@ void Dictionary::exportVariables(const char *varString, const char *fileName, bo
    const char *searchStr = varString;
    Vector<Entry *> sortList(__FILE__, __LINE__);
 
+   for(U32 i = 0; i < hashTable->localCount; i++)
+   {
+      Entry *local = getVisibleLocal(i);
+      if(local && FindMatch::isMatch((char *) searchStr, (char *) local->name))
+         sortList.push_back(local);
+   }
+
    for(S32 i = 0; i < hashTable->size;i ++)
    {
       Entry *walk = hashTable->data[i];
@@ -195,6 +202,13 @@ void Dictionary::exportVariables( const char *varString, Vector<String> *names,
    const char *searchStr = varString;
    Vector<Entry *> sortList(__FILE__, __LINE__);
 
+   for ( U32 i = 0; i < hashTable->localCount; i++ )
+   {
+      Entry *local = getVisibleLocal( i );
+      if ( local && FindMatch::isMatch( (char*)searchStr, (char*)local->name ) )
+         sortList.push_back( local );
+   }
+
    for ( S32 i = 0; i < hashTable->size; i++ )
    {
       Entry *walk = hashTable->data[i];
@@ -249,6 +263,13 @@ void Dictionary::deleteVariables(const char *varString)
 {
    const char *searchStr = varString;
 
+   for(U32 i = 0; i < hashTable->localCount; i++)
+   {
+      Entry *local = getVisibleLocal(i);
+      if(local && FindMatch::isMatch((char *) searchStr, (char *) local->name))
+         remove(local);
+   }
+
    for(S32 i = 0; i < hashTable->size; i++)
    {
       Entry *walk = hashTable->data[i];
@@ -267,8 +288,37 @@ S32 HashPointer(StringTableEntry ptr)
    return (S32)(((dsize_t)ptr) >> 2);
 }
 
+Dictionary::Entry *Dictionary::lookupLocal(StringTableEntry name)
+{
+   // Search backwards so a repeated argument name finds the last
+   // argument, matching what the compiler resolves it to.
+   for(U32 i = hashTable->localCount; i > 0; i--)
+   {
+      if(hashTable->locals[i - 1].name == name)
+         return &hashTable->locals[i - 1];
+   }
+   return NULL;
+}
+
+Dictionary::Entry *Dictionary::getVisibleLocal(U32 slot)
+{
+   Entry *local = &hashTable->locals[slot];
+   if(local->isUnset() || lookupLocal(local->name) != local)
+      return NULL;
+   return local;
+}
+
 Dictionary::Entry *Dictionary::lookup(StringTableEntry name)
 {
+   // A local that was never assigned doesn't exist yet as far as
+   // anyone looking it up by name is concerned.
+   if(hashTable->localCount)
+   {
+      Entry *local = lookupLocal(name);
+      if(local)
+         return local->isUnset() ? NULL : local;
+   }
+
    Entry *walk = hashTable->data[HashPointer(name) % hashTable->size];
    while(walk)
    {
@@ -285,6 +335,13 @@ Dictionary::Entry *Dictionary::add(StringTableEntry name)
 {
    // Try to find an existing match.
    
+   if( hashTable->localCount )
+   {
+      Entry* local = lookupLocal( name );
+      if( local )
+         return local;
+   }
+
    Entry* ret = lookup( name );
    if( ret )
       return ret;
@@ -340,6 +397,16 @@ Dictionary::Entry *Dictionary::add(StringTableEntry name)
 // deleteVariables() assumes remove() is a stable remove (will not reorder entries on remove)
 void Dictionary::remove(Dictionary::Entry *ent)
 {
+   // Frame slots can't be unlinked; removing one just takes it back to
+   // never having been assigned.
+   if(ent >= hashTable->locals && ent < hashTable->locals + hashTable->localCount)
+   {
+      StringTableEntry name = ent->name;
+      destructInPlace( ent );
+      constructInPlace( ent, name );
+      return;
+   }
+
    Entry **walk = &hashTable->data[HashPointer(ent->name) % hashTable->size];
    while(*walk != ent)
       walk = &((*walk)->nextEntry);
@@ -391,11 +458,30 @@ void Dictionary::setState(ExprEvalState *state, Dictionary* ref)
    hashTable = &ownHashTable;
 }
 
+void Dictionary::setLocals(U32 count, const U32 *names)
+{
+   AssertFatal( hashTable == &ownHashTable && !ownHashTable.localCount,
+      "Dictionary::setLocals - Frame already has locals!" );
+
+   if( count > ownHashTable.localCapacity )
+   {
+      dFree( ownHashTable.locals );
+      ownHashTable.locals = ( Entry* ) dMalloc( count * sizeof( Entry ) );
+      ownHashTable.localCapacity = count;
+   }
+
+   for( U32 i = 0; i < count; ++ i )
+      constructInPlace( &ownHashTable.locals[ i ], Compiler::U32toSTE( names[ i ] ) );
+
+   ownHashTable.localCount = count;
+}
+
 Dictionary::~Dictionary()
 {
    reset();
    if( ownHashTable.data )
       delete [] ownHashTable.data;
+   dFree( ownHashTable.locals );
 }
 
 void Dictionary::reset()
@@ -406,19 +492,28 @@ void Dictionary::reset()
       return;
    }
       
-   for( U32 i = 0; i < ownHashTable.size; ++ i )
+   for( U32 i = 0; i < ownHashTable.localCount; ++ i )
+      destructInPlace( &ownHashTable.locals[ i ] );
+   ownHashTable.localCount = 0;
+
+   // Most function frames keep all their variables in slots, so there's
+   // usually nothing in the table to clear.
+   if( ownHashTable.count )
    {
-      Entry* walk = ownHashTable.data[i];
-      while( walk )
+      for( U32 i = 0; i < ownHashTable.size; ++ i )
       {
-         Entry* temp = walk->nextEntry;
-         destructInPlace( walk );
-         walk = temp;
+         Entry* walk = ownHashTable.data[i];
+         while( walk )
+         {
+            Entry* temp = walk->nextEntry;
+            destructInPlace( walk );
+            walk = temp;
+         }
       }
-   }
 
-   dMemset( ownHashTable.data, 0, ownHashTable.size * sizeof( Entry* ) );
-   ownHashTable.mChunker.freeBlocks( true );
+      dMemset( ownHashTable.data, 0, ownHashTable.size * sizeof( Entry* ) );
+      ownHashTable.mChunker.freeBlocks( true );
+   }
    
    ownHashTable.count = 0;
    hashTable = NULL;
@@ -435,6 +530,13 @@ const char *Dictionary::tabComplete(const char *prevText, S32 baseLen, bool fFor
    S32 i;
 
    const char *bestMatch = NULL;
+   for(U32 slot = 0; slot < hashTable->localCount; slot++)
+   {
+      Entry *local = getVisibleLocal(slot);
+      if(local && canTabComplete(prevText, bestMatch, local->name, baseLen, fForward))
+         bestMatch = local->name;
+   }
+
    for(i = 0; i < hashTable->size; i++)
    {
       Entry *walk = hashTable->data[i];
@@ -634,7 +736,7 @@ void Dictionary::validate()
       "Dictionary::validate() - Dictionary not owner of own hashtable!" );
 }
 
-void ExprEvalState::pushFrame(StringTableEntry frameName, Namespace *ns)
+void ExprEvalState::pushFrame(StringTableEntry frameName, Namespace *ns, U32 localCount, const U32 *localNames)
 {   
    #ifdef DEBUG_SPEW
    validate();
@@ -654,6 +756,8 @@ void ExprEvalState::pushFrame(StringTableEntry frameName, Namespace *ns)
       
    Dictionary& newFrame = *( stack[ mStackDepth ] );
    newFrame.setState( this );
+   if( localCount )
+      newFrame.setLocals( localCount, localNames );
       
    newFrame.scopeName = frameName;
    newFrame.scopeNamespace = ns;
@@ -236,7 +236,35 @@ class Namespace
          unlinkClass( NULL );
       }
 
+      /// Inline cache for a single call site in compiled script.
+      ///
+      /// Remembers the result of the last lookup made from the site.  It stays
+      /// valid for as long as the same namespace is searched and mCacheSequence
+      /// has not moved; anything that can change what a lookup returns (defining
+      /// functions, linking classes, activating packages) goes through trashCache().
+      struct CallSiteCache
+      {
+         Namespace *mNamespace;
+         Entry *mEntry;
+         U32 mSequence;
+
+         CallSiteCache() : mNamespace( NULL ), mEntry( NULL ), mSequence( 0 ) {}
+      };
+
       Entry *lookup(StringTableEntry name);
+
+      /// Look up @a name, going through @a cache first.
+      Entry *lookup(StringTableEntry name, CallSiteCache &cache)
+      {
+         if(cache.mNamespace == this && cache.mSequence == mCacheSequence)
+            return cache.mEntry;
+
+         cache.mNamespace = this;
+         cache.mEntry = lookup(name);
+         cache.mSequence = mCacheSequence;
+         return cache.mEntry;
+      }
+
       Entry *lookupRecursive(StringTableEntry name);
       Entry *createLocalEntry(StringTableEntry name);
       void buildHashTable();
@@ -435,6 +463,14 @@ public:
       }
 
       void setStringValue(const char *value);
+
+      /// Whether nothing has been assigned yet.  Only meaningful for the
+      /// frame slots of locals, which exist before their first assignment.
+      bool isUnset() const
+      {
+         return type == TypeInternalString && sval == typeValueEmpty;
+      }
+
       friend class Dictionary;
    };
 
@@ -445,9 +481,16 @@ public:
         S32 count;
         Entry **data;
         FreeListChunker< Entry > mChunker;
+
+        /// Locals the compiler gave a frame slot.  They never go into
+        /// the hash table but are still found by name.
+        Entry *locals;
+        U32 localCount;
+        U32 localCapacity;
         
         HashTableData( Dictionary* owner )
-           : owner( owner ), size( 0 ), count( 0 ), data( NULL ) {}
+           : owner( owner ), size( 0 ), count( 0 ), data( NULL ),
+             locals( NULL ), localCount( 0 ), localCapacity( 0 ) {}
     };
 
     HashTableData* hashTable;
@@ -465,6 +508,24 @@ public:
     Entry *lookup(StringTableEntry name);
     Entry *add(StringTableEntry name);
     void setState(ExprEvalState *state, Dictionary* ref=NULL);
+
+    /// Set up the frame slots for a function's locals.
+    /// @param names The local names as found in the function's header.
+    void setLocals(U32 count, const U32 *names);
+
+    /// Return the frame slot named @a name, or NULL if there is none.
+    Entry *lookupLocal(StringTableEntry name);
+
+    Entry *getLocal(U32 slot)
+    {
+       return &hashTable->locals[slot];
+    }
+
+    /// Return frame slot @a slot if looking up its name would find it,
+    /// i.e. it has been assigned and no later argument of the same name
+    /// hides it.  NULL otherwise.
+    Entry *getVisibleLocal(U32 slot);
+
     void remove(Entry *);
     void reset();
 
@@ -537,6 +598,8 @@ public:
     
     void setCurVarName(StringTableEntry name);
     void setCurVarNameCreate(StringTableEntry name);
+    void setCurVarLocal(U32 slot);
+    void setCurVarLocalCreate(U32 slot);
     S32 getIntVariable();
     F64 getFloatVariable();
     const char *getStringVariable();
@@ -544,7 +607,7 @@ public:
     void setFloatVariable(F64 val);
     void setStringVariable(const char *str);
 
-    void pushFrame(StringTableEntry frameName, Namespace *ns);
+    void pushFrame(StringTableEntry frameName, Namespace *ns, U32 localCount = 0, const U32 *localNames = NULL);
     void popFrame();
 
     /// Puts a reference to an existing stack frame
@@ -22,6 +22,7 @@
 
 #include "console/simDictionary.h"
 #include "console/simBase.h"
+#include "platform/platformIntrinsics.h"
 
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
@@ -265,57 +266,177 @@ void SimManagerNameDictionary::remove(SimObject* obj)
 
 SimIdDictionary::SimIdDictionary()
 {
-   dMemset( table, 0, sizeof( table[ 0 ] ) * DefaultTableSize );
+   mTable = allocTable( DefaultTableSize );
+   mCount = 0;
+   mRemovedCount = 0;
+   mReaderCount = 0;
    mutex = Mutex::createMutex();
 }
 
 SimIdDictionary::~SimIdDictionary()
 {
+   dFree( mTable );
+   for( U32 i = 0; i < mRetiredTables.size(); i ++ )
+      dFree( mRetiredTables[ i ] );
    Mutex::destroyMutex(mutex);
 }
 
+SimIdDictionary::Table* SimIdDictionary::allocTable( U32 size )
+{
+   Table* table = ( Table* ) dMalloc( sizeof( Table ) + ( size - 1 ) * sizeof( Slot ) );
+   table->size = size;
+   table->mask = size - 1;
+   dMemset( table->slots, 0, size * sizeof( Slot ) );
+   return table;
+}
+
+void SimIdDictionary::rebuild( U32 size )
+{
+   Table* oldTable = mTable;
+   Table* table = allocTable( size );
+
+   // Start copying right after an empty slot so every probe sequence is
+   // copied in order; objects sharing an id keep their order that way.
+   U32 start = 0;
+   while( oldTable->slots[ start ].state != SlotEmpty )
+      start ++;
+
+   for( U32 i = 1; i <= oldTable->size; i ++ )
+   {
+      const Slot& oldSlot = oldTable->slots[ ( start + i ) & oldTable->mask ];
+      if( oldSlot.state != SlotUsed )
+         continue;
+
+      U32 index = oldSlot.id & table->mask;
+      while( table->slots[ index ].state != SlotEmpty )
+         index = ( index + 1 ) & table->mask;
+
+      table->slots[ index ].state = SlotUsed;
+      table->slots[ index ].id = oldSlot.id;
+      table->slots[ index ].object = oldSlot.object;
+   }
+
+   // The swap is a full barrier, so readers that see the new table
+   // also see its contents.
+   dCompareAndSwap( mTable, oldTable, table );
+   mRemovedCount = 0;
+
+   // A find() may still be probing the old table.
+   mRetiredTables.push_back( oldTable );
+}
+
+void SimIdDictionary::freeRetiredTables()
+{
+   // Readers pick up the table after announcing themselves, so once
+   // there are none, nobody can be looking at a retired table.
+   if( mRetiredTables.empty() || dAtomicRead( mReaderCount ) != 0 )
+      return;
+
+   for( U32 i = 0; i < mRetiredTables.size(); i ++ )
+      dFree( mRetiredTables[ i ] );
+   mRetiredTables.clear();
+}
+
 void SimIdDictionary::insert(SimObject* obj)
 {
    Mutex::lockMutex(mutex);
 
-   S32 idx = obj->getId() & TableBitMask;
-   obj->nextIdObject = table[idx];
-   AssertFatal( obj->nextIdObject != obj, "SimIdDictionary::insert - Creating Infinite Loop linking to self!" );
-   table[idx] = obj;
+   // Keep live and removed slots to at most half of the table so
+   // probe sequences stay short.
+   if( ( mCount + mRemovedCount + 1 ) * 2 > mTable->size )
+   {
+      U32 size = DefaultTableSize;
+      while( size < ( mCount + 1 ) * 4 )
+         size <<= 1;
+      rebuild( size );
+   }
+
+   Table* table = mTable;
+   const U32 id = obj->getId();
+
+   // If the id is already taken, the new object goes in front of the
+   // others so that find() returns the newest one, and each older one
+   // moves down a place.
+   SimObject* carry = obj;
+   U32 index = id & table->mask;
+   while( table->slots[ index ].state != SlotEmpty )
+   {
+      Slot& slot = table->slots[ index ];
+      if( slot.state == SlotUsed && slot.id == id )
+      {
+         AssertFatal( slot.object != obj, "SimIdDictionary::insert - Object inserted twice!" );
+         SimObject* older = slot.object;
+         slot.object = carry;
+         carry = older;
+      }
+      index = ( index + 1 ) & table->mask;
+   }
+
+   // Publish the id and object before the state so that a reader finding
+   // the slot in use also finds them.
+   Slot& slot = table->slots[ index ];
+   slot.id = id;
+   slot.object = carry;
+   dCompareAndSwap( slot.state, ( U32 ) SlotEmpty, ( U32 ) SlotUsed );
+
+   mCount ++;
+   freeRetiredTables();
 
    Mutex::unlockMutex(mutex);
 }
 
 SimObject* SimIdDictionary::find(S32 id)
 {
-   Mutex::lockMutex(mutex);
+   // Keeps writers from freeing the table under us; see freeRetiredTables().
+   dFetchAndAdd( mReaderCount, 1 );
 
-   S32 idx = id & TableBitMask;
-   SimObject *walk = table[idx];
-   while(walk)
+   Table* table = mTable;
+   SimObject* result = NULL;
+   for( U32 index = U32( id ) & table->mask; ; index = ( index + 1 ) & table->mask )
    {
-      if(walk->getId() == U32(id))
+      const Slot& slot = table->slots[ index ];
+      const U32 state = slot.state;
+      if( state == SlotEmpty )
+         break;
+
+      if( state == SlotUsed && slot.id == U32( id ) )
       {
-         Mutex::unlockMutex(mutex);
-         return walk;
+         // May have just been removed, in which case keep looking in case
+         // there is an older object with the same id.
+         result = slot.object;
+         if( result )
+            break;
       }
-      walk = walk->nextIdObject;
    }
 
-   Mutex::unlockMutex(mutex);
+   dFetchAndAdd( mReaderCount, U32( -1 ) );
 
-   return NULL;
+   return result;
 }
 
 void SimIdDictionary::remove(SimObject* obj)
 {
    Mutex::lockMutex(mutex);
 
-   SimObject **walk = &table[obj->getId() & TableBitMask];
-   while(*walk && *walk != obj)
-      walk = &((*walk)->nextIdObject);
-   if(*walk)
-      *walk = obj->nextIdObject;
+   Table* table = mTable;
+   const U32 id = obj->getId();
+   for( U32 index = id & table->mask; table->slots[ index ].state != SlotEmpty; index = ( index + 1 ) & table->mask )
+   {
+      Slot& slot = table->slots[ index ];
+      if( slot.state == SlotUsed && slot.id == id && slot.object == obj )
+      {
+         // The slot is not reused until the next rebuild so readers
+         // can never see it hold a different id.
+         slot.object = NULL;
+         slot.state = SlotRemoved;
+
+         mCount --;
+         mRemovedCount ++;
+         break;
+      }
+   }
+
+   freeRetiredTables();
 
    Mutex::unlockMutex(mutex);
 }
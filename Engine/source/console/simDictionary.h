@@ -32,6 +32,9 @@
 #ifndef _PLATFORMMUTEX_H_
 #include "platform/threads/mutex.h"
 #endif
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
 
 class SimObject;
 
@@ -89,22 +92,75 @@ public:
 ///
 /// Provides fast lookup for ID->object and
 /// for fast removal of an object given object*
+///
+/// This is an open addressing table that grows with the number of objects.
+/// find() never takes a lock and may be called from any thread; insert()
+/// and remove() are serialized among themselves.
+///
+/// Readers stay safe without locking because slots are never reused:
+/// a slot goes from empty to holding an object to removed, and only a
+/// rebuild into a fresh table clears out removed slots.  Tables replaced
+/// by a rebuild are freed once no find() is running.
+///
+/// The state of a slot is kept apart from its id so that every id,
+/// including RootGroupId, can be stored.
 class SimIdDictionary
 {
    enum
    {
       DefaultTableSize = 4096,
-      TableBitMask = 4095
    };
-   SimObject *table[DefaultTableSize];
+
+   enum SlotState
+   {
+      SlotEmpty,     ///< Slot has never been used.
+      SlotUsed,      ///< Slot holds an object.
+      SlotRemoved,   ///< Slot held an object that has since been removed.
+   };
+
+   struct Slot
+   {
+      volatile U32 state;
+      U32 id;
+      SimObject* volatile object;
+   };
+
+   /// A table and its slots, allocated as one block.
+   struct Table
+   {
+      U32 size;
+      U32 mask;
+      Slot slots[ 1 ];
+   };
+
+   Table* volatile mTable;
+
+   /// Number of objects in the table.
+   U32 mCount;
+
+   /// Number of removed slots in the table.
+   U32 mRemovedCount;
+
+   /// Number of find() calls in progress.
+   volatile U32 mReaderCount;
+
+   /// Tables replaced by a rebuild that a find() may still be looking at.
+   Vector< Table* > mRetiredTables;
 
    void *mutex;
 
+   static Table* allocTable( U32 size );
+   void rebuild( U32 size );
+   void freeRetiredTables();
+
 public:
    void insert(SimObject* obj);
    void remove(SimObject* obj);
    SimObject* find(S32 id);
 
+   /// Return the number of objects in the dictionary.
+   U32 size() const { return mCount; }
+
    SimIdDictionary();
    ~SimIdDictionary();
 };
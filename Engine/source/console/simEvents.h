@@ -54,7 +54,9 @@ class Semaphore;
 class SimEvent
 {
 public:
-   SimEvent *nextEvent;     ///< Linked list details - pointer to next item in the list.
+   U32 queueIndex;          ///< Position in the event queue's heap.
+   SimEvent *nextObjectEvent; ///< Next pending event on destObject.
+   SimEvent *prevObjectEvent; ///< Previous pending event on destObject.
    SimTime startTime;       ///< When the event was posted.
    SimTime time;            ///< When the event is scheduled to occur.
    U32 sequenceCount;       ///< Unique ID. These are assigned sequentially based on order
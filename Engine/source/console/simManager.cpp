@@ -35,6 +35,7 @@
 #include "platform/platformIntrinsics.h"
 #include "platform/profiler.h"
 #include "math/mMathFn.h"
+#include "core/util/tDictionary.h"
 
 extern ExprEvalState gEvalState;
 
@@ -58,9 +59,134 @@ SimTime gCurrentTime;
 SimTime gTargetTime;
 
 void *gEventQueueMutex;
-SimEvent *gEventQueue;
 U32 gEventSequence;
 
+/// Pending events, as a binary heap ordered by time.  Events due at the
+/// same time are ordered by sequence number, so they are dispatched in
+/// the order they were posted; Con::threadSafeExecute() relies on that.
+Vector<SimEvent*> gEventQueue;
+
+/// Pending events by sequence number, for cancelEvent() and friends.
+HashTable<U32, SimEvent*> gEventsBySequence;
+
+/// First pending event of each object that has any; the rest are linked
+/// through SimEvent::nextObjectEvent.
+HashTable<SimObject*, SimEvent*> gEventsByObject;
+
+//---------------------------------------------------------------------------
+// event queue heap
+
+static inline bool eventPrecedes(const SimEvent *a, const SimEvent *b)
+{
+   if(a->time != b->time)
+      return a->time < b->time;
+   return S32(a->sequenceCount - b->sequenceCount) < 0;
+}
+
+static inline void placeEvent(SimEvent *event, U32 index)
+{
+   gEventQueue[index] = event;
+   event->queueIndex = index;
+}
+
+static void siftEventUp(U32 index)
+{
+   SimEvent *event = gEventQueue[index];
+   while(index > 0)
+   {
+      U32 parent = (index - 1) / 2;
+      if(!eventPrecedes(event, gEventQueue[parent]))
+         break;
+      placeEvent(gEventQueue[parent], index);
+      index = parent;
+   }
+   placeEvent(event, index);
+}
+
+static void siftEventDown(U32 index)
+{
+   SimEvent *event = gEventQueue[index];
+   const U32 count = gEventQueue.size();
+   for(;;)
+   {
+      U32 child = index * 2 + 1;
+      if(child >= count)
+         break;
+      if(child + 1 < count && eventPrecedes(gEventQueue[child + 1], gEventQueue[child]))
+         child++;
+      if(!eventPrecedes(gEventQueue[child], event))
+         break;
+      placeEvent(gEventQueue[child], index);
+      index = child;
+   }
+   placeEvent(event, index);
+}
+
+static void queueEvent(SimEvent *event)
+{
+   gEventQueue.push_back(event);
+   siftEventUp(gEventQueue.size() - 1);
+
+   gEventsBySequence.insertUnique(event->sequenceCount, event);
+
+   HashTable<SimObject*, SimEvent*>::Iterator itr = gEventsByObject.find(event->destObject);
+   event->prevObjectEvent = NULL;
+   if(itr == gEventsByObject.end())
+   {
+      event->nextObjectEvent = NULL;
+      gEventsByObject.insertUnique(event->destObject, event);
+   }
+   else
+   {
+      event->nextObjectEvent = itr->value;
+      itr->value->prevObjectEvent = event;
+      itr->value = event;
+   }
+}
+
+static void removeQueuedEvent(SimEvent *event)
+{
+   U32 index = event->queueIndex;
+   SimEvent *last = gEventQueue.last();
+   gEventQueue.decrement();
+   if(last != event)
+   {
+      placeEvent(last, index);
+      if(index > 0 && eventPrecedes(last, gEventQueue[(index - 1) / 2]))
+         siftEventUp(index);
+      else
+         siftEventDown(index);
+   }
+
+   gEventsBySequence.erase(event->sequenceCount);
+}
+
+/// Take an event out of the queue without deleting it.
+static void unqueueEvent(SimEvent *event)
+{
+   removeQueuedEvent(event);
+
+   if(event->nextObjectEvent)
+      event->nextObjectEvent->prevObjectEvent = event->prevObjectEvent;
+   if(event->prevObjectEvent)
+      event->prevObjectEvent->nextObjectEvent = event->nextObjectEvent;
+   else
+   {
+      HashTable<SimObject*, SimEvent*>::Iterator itr = gEventsByObject.find(event->destObject);
+      if(event->nextObjectEvent)
+         itr->value = event->nextObjectEvent;
+      else
+         gEventsByObject.erase(itr);
+   }
+}
+
+static SimEvent *findEvent(U32 eventSequence)
+{
+   SimEvent *event = NULL;
+   gEventsBySequence.find(eventSequence, event);
+   return event;
+}
+
 //---------------------------------------------------------------------------
 // event queue init/shutdown
 
@@ -69,7 +195,6 @@ static void initEventQueue()
    gCurrentTime = 0;
    gTargetTime = 0;
    gEventSequence = 1;
-   gEventQueue = NULL;
    gEventQueueMutex = Mutex::createMutex();
 }
 
@@ -77,13 +202,11 @@ static void shutdownEventQueue()
 {
    // Delete all pending events
    Mutex::lockMutex(gEventQueueMutex);
-   SimEvent *walk = gEventQueue;
-   while(walk)
-   {
-      SimEvent *temp = walk->nextEvent;
-      delete walk;
-      walk = temp;
-   }
+   for(U32 i = 0; i < gEventQueue.size(); i++)
+      delete gEventQueue[i];
+   gEventQueue.clear();
+   gEventsBySequence.clear();
+   gEventsByObject.clear();
    Mutex::unlockMutex(gEventQueueMutex);
    Mutex::destroyMutex(gEventQueueMutex);
 }
@@ -115,19 +238,7 @@ U32 postEvent(SimObject *destObject, SimEvent* event,U32 time)
       return InvalidEventId;
    }
    event->sequenceCount = gEventSequence++;
-   SimEvent **walk = &gEventQueue;
-   SimEvent *current;
-   
-   while((current = *walk) != NULL && (current->time < event->time))
-      walk = &(current->nextEvent);
-   
-   // [tom, 6/24/2005] This ensures that SimEvents are dispatched in the same order that they are posted.
-   // This is needed to ensure Con::threadSafeExecute() executes script code in the correct order.
-   while((current = *walk) != NULL && (current->time == event->time))
-      walk = &(current->nextEvent);
-   
-   event->nextEvent = current;
-   *walk = event;
+   queueEvent(event);
 
    U32 seqCount = event->sequenceCount;
 
@@ -143,20 +254,11 @@ void cancelEvent(U32 eventSequence)
 {
    Mutex::lockMutex(gEventQueueMutex);
 
-   SimEvent **walk = &gEventQueue;
-   SimEvent *current;
-   
-   while((current = *walk) != NULL)
+   SimEvent *event = findEvent(eventSequence);
+   if(event)
    {
-      if(current->sequenceCount == eventSequence)
-      {
-         *walk = current->nextEvent;
-         delete current;
-         Mutex::unlockMutex(gEventQueueMutex);
-         return;
-      }
-      else
-         walk = &(current->nextEvent);
+      unqueueEvent(event);
+      delete event;
    }
 
    Mutex::unlockMutex(gEventQueueMutex);
@@ -166,19 +268,24 @@ void cancelPendingEvents(SimObject *obj)
 {
    Mutex::lockMutex(gEventQueueMutex);
 
-   SimEvent **walk = &gEventQueue;
-   SimEvent *current;
-   
-   while((current = *walk) != NULL)
+   HashTable<SimObject*, SimEvent*>::Iterator itr = gEventsByObject.find(obj);
+   if(itr != gEventsByObject.end())
    {
-      if(current->destObject == obj)
+      SimEvent *walk = itr->value;
+      gEventsByObject.erase(itr);
+
+      while(walk)
       {
-         *walk = current->nextEvent;
-         delete current;
+         SimEvent *next = walk->nextObjectEvent;
+
+         // The object's list is already gone, so only the heap and
+         // sequence lookup need updating.
+         removeQueuedEvent(walk);
+         delete walk;
+         walk = next;
       }
-      else
-         walk = &(current->nextEvent);
    }
+
    Mutex::unlockMutex(gEventQueueMutex);
 }
 
@@ -188,48 +295,48 @@ void cancelPendingEvents(SimObject *obj)
 bool isEventPending(U32 eventSequence)
 {
    Mutex::lockMutex(gEventQueueMutex);
-
-   for(SimEvent *walk = gEventQueue; walk; walk = walk->nextEvent)
-      if(walk->sequenceCount == eventSequence)
-      {
-         Mutex::unlockMutex(gEventQueueMutex);
-         return true;
-      }
+   bool pending = findEvent(eventSequence) != NULL;
    Mutex::unlockMutex(gEventQueueMutex);
-   return false;
+   return pending;
 }
 
 U32 getEventTimeLeft(U32 eventSequence)
 {
    Mutex::lockMutex(gEventQueueMutex);
 
-   for(SimEvent *walk = gEventQueue; walk; walk = walk->nextEvent)
-      if(walk->sequenceCount == eventSequence)
-      {
-         SimTime t = walk->time - getCurrentTime();
-         Mutex::unlockMutex(gEventQueueMutex);
-         return t;
-      }
+   SimTime t = 0;
+   if(SimEvent *event = findEvent(eventSequence))
+      t = event->time - getCurrentTime();
 
    Mutex::unlockMutex(gEventQueueMutex);
 
-   return 0;   
+   return t;   
 }
 
 U32 getScheduleDuration(U32 eventSequence)
 {
-   for(SimEvent *walk = gEventQueue; walk; walk = walk->nextEvent)
-      if(walk->sequenceCount == eventSequence)
-         return (walk->time-walk->startTime);
-   return 0;
+   Mutex::lockMutex(gEventQueueMutex);
+
+   SimTime t = 0;
+   if(SimEvent *event = findEvent(eventSequence))
+      t = event->time - event->startTime;
+
+   Mutex::unlockMutex(gEventQueueMutex);
+
+   return t;
 }
 
 U32 getTimeSinceStart(U32 eventSequence)
 {
-   for(SimEvent *walk = gEventQueue; walk; walk = walk->nextEvent)
-      if(walk->sequenceCount == eventSequence)
-         return (getCurrentTime()-walk->startTime);
-   return 0;
+   Mutex::lockMutex(gEventQueueMutex);
+
+   SimTime t = 0;
+   if(SimEvent *event = findEvent(eventSequence))
+      t = getCurrentTime() - event->startTime;
+
+   Mutex::unlockMutex(gEventQueueMutex);
+
+   return t;
 }
 
 //---------------------------------------------------------------------------
@@ -243,10 +350,10 @@ void advanceToTime(SimTime targetTime)
    Mutex::lockMutex(gEventQueueMutex);
 
    gTargetTime = targetTime;
-   while(gEventQueue && gEventQueue->time <= targetTime)
+   while(gEventQueue.size() && gEventQueue[0]->time <= targetTime)
    {
-      SimEvent *event = gEventQueue;
-      gEventQueue = gEventQueue->nextEvent;
+      SimEvent *event = gEventQueue[0];
+      unqueueEvent(event);
       AssertFatal(event->time >= gCurrentTime,
          "Sim::advanceToTime() - Event time is less than current time.");
       gCurrentTime = event->time;
@@ -68,7 +68,6 @@ SimObject::SimObject()
    mInternalName         = NULL;
    nextNameObject        = (SimObject*)-1;
    nextManagerNameObject = (SimObject*)-1;
-   nextIdObject          = NULL;
 
    mFilename             = NULL;
    mDeclarationLine      = -1;
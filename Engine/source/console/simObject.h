@@ -290,7 +290,6 @@ class SimObject: public ConsoleObject
       StringTableEntry mOriginalName;
       SimObject*       nextNameObject;
       SimObject*       nextManagerNameObject;
-      SimObject*       nextIdObject;
 
       /// SimGroup we're contained in, if any.
       SimGroup*   mGroup;
@@ -23,19 +23,48 @@
 #include "console/stringStack.h"
 
 void StringStack::getArgcArgv(StringTableEntry name, U32 *argc, const char ***in_argv, bool popStackFrame /* = false */)
+{
+   ConsoleValue *argValues;
+   getArgcArgv(name, argc, in_argv, &argValues);
+   formatArgs(*argc, *in_argv, argValues);
+
+   if(popStackFrame)
+      popFrame();
+}
+
+void StringStack::getArgcArgv(StringTableEntry name, U32 *argc, const char ***in_argv, ConsoleValue **in_argValues)
 {
    U32 startStack = mFrameOffsets[mNumFrames-1] + 1;
    U32 argCount   = getMin(mStartStackSize - startStack, (U32)MaxArgs - 1);
 
    *in_argv = mArgV;
+   *in_argValues = mArgValues;
    mArgV[0] = name;
+   mArgValues[0].type = ConsoleValue::TypeString;
    
    for(U32 i = 0; i < argCount; i++)
+   {
       mArgV[i+1] = mBuffer + mStartOffsets[startStack + i];
+      mArgValues[i+1] = mStartValues[startStack + i];
+   }
    argCount++;
    
    *argc = argCount;
+}
 
-   if(popStackFrame)
-      popFrame();
-}
\ No newline at end of file
+void StringStack::formatArgs(U32 argc, const char **argv, const ConsoleValue *argValues)
+{
+   for(U32 i = 1; i < argc; i++)
+   {
+      // A formatted number is never empty, so an empty slot is one that
+      // hasn't been filled in yet.
+      if(argValues[i].type == ConsoleValue::TypeString || argv[i][0])
+         continue;
+
+      char *slot = const_cast<char *>(argv[i]);
+      if(argValues[i].type == ConsoleValue::TypeInt)
+         dSprintf(slot, NumberSlotSize, "%d", S32(argValues[i].ival));
+      else
+         dSprintf(slot, NumberSlotSize, "%g", argValues[i].fval);
+   }
+}
@@ -36,6 +36,44 @@
 #endif
 
 
+/// A value as it is passed between functions by the interpreter.
+///
+/// Numbers pushed as function arguments or returned from script functions
+/// are carried in their native form, so that a call from script to script
+/// does not have to format them to a string and parse them back again.
+struct ConsoleValue
+{
+   enum Type
+   {
+      TypeString,    ///< The value lives in the matching string slot.
+      TypeInt,       ///< Integer (or SimObjectId) held in ival.
+      TypeFloat      ///< Float held in fval.
+   };
+
+   U32 type;
+
+   union
+   {
+      S64 ival;
+      F64 fval;
+   };
+
+   ConsoleValue() : type( TypeString ), ival( 0 ) {}
+
+   void setInt( S64 i )
+   {
+      type = TypeInt;
+      ival = i;
+   }
+
+   void setFloat( F64 f )
+   {
+      type = TypeFloat;
+      fval = f;
+   }
+};
+
+
 /// Core stack for interpreter operations.
 ///
 /// This class provides some powerful semantics for working with strings, and is
@@ -45,7 +83,8 @@ struct StringStack
    enum {
       MaxStackDepth = 1024,
       MaxArgs = 20,
-      ReturnBufferSpace = 512
+      ReturnBufferSpace = 512,
+      NumberSlotSize = 32
    };
    char *mBuffer;
    U32   mBufferSize;
@@ -53,6 +92,11 @@ struct StringStack
    U32 mFrameOffsets[MaxStackDepth];
    U32 mStartOffsets[MaxStackDepth];
 
+   /// The typed value of each entry on the start stack.  Only entries pushed
+   /// with pushInt() or pushFloat() are anything other than a string.
+   ConsoleValue mStartValues[MaxStackDepth];
+   ConsoleValue mArgValues[MaxArgs];
+
    U32 mNumFrames;
    U32 mArgc;
 
@@ -191,6 +235,7 @@ struct StringStack
    ///       properly push the stack.
    void advance()
    {
+      mStartValues[mStartStackSize].type = ConsoleValue::TypeString;
       mStartOffsets[mStartStackSize++] = mStart;
       mStart += mLen;
       mLen = 0;
@@ -203,6 +248,7 @@ struct StringStack
    ///       properly push the stack.
    void advanceChar(char c)
    {
+      mStartValues[mStartStackSize].type = ConsoleValue::TypeString;
       mStartOffsets[mStartStackSize++] = mStart;
       mStart += mLen;
       mBuffer[mStart] = c;
@@ -217,6 +263,37 @@ struct StringStack
       advanceChar(0);
    }
 
+   /// Push an integer onto the stack without formatting it.
+   ///
+   /// Room for the string form is reserved, but it is only filled in by
+   /// formatArgs() when someone actually asks for the argument as a string.
+   void pushInt(S64 i)
+   {
+      mStartValues[mStartStackSize].setInt(i);
+      advanceNumberSlot();
+   }
+
+   /// Push a float onto the stack without formatting it.
+   ///
+   /// @see pushInt
+   void pushFloat(F64 v)
+   {
+      mStartValues[mStartStackSize].setFloat(v);
+      advanceNumberSlot();
+   }
+
+   /// Reserve an empty, fixed size string slot for a number pushed with
+   /// pushInt() or pushFloat().
+   void advanceNumberSlot()
+   {
+      validateBufferSize(mStart + NumberSlotSize + 2);
+      mStartOffsets[mStartStackSize++] = mStart;
+      mBuffer[mStart] = 0;
+      mStart += NumberSlotSize;
+      mBuffer[mStart] = 0;
+      mLen = 0;
+   }
+
    inline void setLen(U32 newlen)
    {
       mLen = newlen;
@@ -259,6 +336,7 @@ struct StringStack
    void pushFrame()
    {
       mFrameOffsets[mNumFrames++] = mStartStackSize;
+      mStartValues[mStartStackSize].type = ConsoleValue::TypeString;
       mStartOffsets[mStartStackSize++] = mStart;
       mStart += ReturnBufferSpace;
       validateBufferSize(0);
@@ -272,7 +350,21 @@ struct StringStack
    }
 
    /// Get the arguments for a function call from the stack.
+   ///
+   /// Numeric arguments are formatted into their string slots, so the returned
+   /// argv is always usable as-is.
    void getArgcArgv(StringTableEntry name, U32 *argc, const char ***in_argv, bool popStackFrame = false);
+
+   /// Get the arguments for a function call from the stack along with their
+   /// typed values.
+   ///
+   /// Numeric arguments are left unformatted; call formatArgs() before handing
+   /// argv to anything that reads the strings.
+   void getArgcArgv(StringTableEntry name, U32 *argc, const char ***in_argv, ConsoleValue **in_argValues);
+
+   /// Fill in the string slots of any numeric arguments returned by
+   /// getArgcArgv() that have not been formatted yet.
+   static void formatArgs(U32 argc, const char **argv, const ConsoleValue *argValues);
 };
 
 #endif
@@ -22,10 +22,13 @@
 
 #include "core/frameAllocator.h"
 #include "console/console.h"
+#include "core/strings/stringFunctions.h"
+#include "platform/threads/mutex.h"
+#include "platform/threads/thread.h"
 
-U8*   FrameAllocator::smBuffer = NULL;
-U32   FrameAllocator::smWaterMark = 0;
-U32   FrameAllocator::smHighWaterMark = 0;
+TORQUE_THREAD_LOCAL FrameAllocator::Arena* FrameAllocator::smArena = NULL;
+FrameAllocator::Arena* FrameAllocator::smArenaList = NULL;
+void* FrameAllocator::smArenaListMutex = NULL;
 
 #ifdef TORQUE_DEBUG
 U32   FrameAllocator::smMaxFrameAllocation = 0;
@@ -35,3 +38,131 @@ ConsoleFunction(getMaxFrameAllocation, S32, 1,1, "getMaxFrameAllocation();")
    return FrameAllocator::getMaxFrameAllocation();
 }
 #endif
+
+void FrameAllocator::init(const U32 frameSize)
+{
+#ifdef FRAMEALLOCATOR_DEBUG_GUARD
+   AssertISV( false, "FRAMEALLOCATOR_DEBUG_GUARD has been removed because it allows non-contiguous memory allocation by the FrameAllocator, and this is *not* ok." );
+#endif
+
+   AssertFatal(smArenaListMutex == NULL, "Error, already initialized");
+   smArenaListMutex = Mutex::createMutex();
+   initThread(frameSize, "Main");
+}
+
+void FrameAllocator::destroy()
+{
+   AssertFatal(smArenaListMutex != NULL, "Error, not initialized");
+
+   destroyThread();
+
+   AssertFatal(smArenaList == NULL, "FrameAllocator::destroy - threads still hold frame arenas");
+   Mutex::destroyMutex(smArenaListMutex);
+   smArenaListMutex = NULL;
+}
+
+void FrameAllocator::initThread(const U32 frameSize, const char* name)
+{
+   AssertFatal(smArena == NULL, "FrameAllocator::initThread - thread already has a frame arena");
+
+   Arena* arena = new Arena;
+   arena->mBuffer = new U8[frameSize];
+   arena->mWaterMark = 0;
+   arena->mHighWaterMark = frameSize;
+   arena->mMaxWaterMark = 0;
+   dStrncpy(arena->mName, name, Arena::MaxNameLength - 1);
+   arena->mName[Arena::MaxNameLength - 1] = '\0';
+
+   // Threads may come up before init() or after destroy(), e.g. the worker
+   // threads of the global ThreadPool.  They still get an arena; it just
+   // isn't listed for reporting.
+   if (smArenaListMutex)
+   {
+      Mutex::lockMutex(smArenaListMutex);
+      arena->mNext = smArenaList;
+      smArenaList = arena;
+      Mutex::unlockMutex(smArenaListMutex);
+      arena->mListed = true;
+   }
+   else
+   {
+      arena->mNext = NULL;
+      arena->mListed = false;
+   }
+
+   smArena = arena;
+}
+
+FrameAllocator::Arena* FrameAllocator::createDefaultArena()
+{
+   char name[Arena::MaxNameLength];
+   dSprintf(name, sizeof(name), "Thread %u", ThreadManager::getCurrentThreadId());
+   initThread(TORQUE_THREAD_FRAME_SIZE, name);
+   return smArena;
+}
+
+void FrameAllocator::destroyThread()
+{
+   Arena* arena = smArena;
+   AssertFatal(arena != NULL, "FrameAllocator::destroyThread - thread has no frame arena");
+
+   if (arena->mListed)
+   {
+      Mutex::lockMutex(smArenaListMutex);
+      for (Arena** walk = &smArenaList; *walk; walk = &(*walk)->mNext)
+      {
+         if (*walk == arena)
+         {
+            *walk = arena->mNext;
+            break;
+         }
+      }
+      Mutex::unlockMutex(smArenaListMutex);
+   }
+
+   smArena = NULL;
+   delete [] arena->mBuffer;
+   delete arena;
+}
+
+void FrameAllocator::reportArenaUsage(void (*report)(const char* line, void* userData), void* userData, bool reset)
+{
+   if (!smArenaListMutex)
+      return;
+
+   Mutex::lockMutex(smArenaListMutex);
+   for (Arena* walk = smArenaList; walk; walk = walk->mNext)
+   {
+      char buffer[256];
+      dSprintf(buffer, sizeof(buffer), "%10d %10d %6.2f%% %s",
+               walk->mHighWaterMark,
+               walk->mMaxWaterMark,
+               100.0f * F32(walk->mMaxWaterMark) / F32(walk->mHighWaterMark),
+               walk->mName);
+      report(buffer, userData);
+
+      // Racy against the owning thread, but worst case a peak is lost.
+      if (reset)
+         walk->mMaxWaterMark = walk->mWaterMark;
+   }
+   Mutex::unlockMutex(smArenaListMutex);
+}
+
+static void printArenaUsage(const char* line, void*)
+{
+   Con::printf("%s", line);
+}
+
+void FrameAllocator::dumpArenaUsage(bool reset)
+{
+   Con::printf("      Size       Peak   Usage  Thread");
+   reportArenaUsage(printArenaUsage, NULL, reset);
+}
+
+ConsoleFunction(dumpFrameAllocatorUsage, void, 1, 2, "( [bool reset] )\n"
+   "Print the size and peak usage of each thread's frame allocator arena.\n"
+   "@param reset If true, clear the recorded peaks afterwards.\n"
+   "@ingroup Debugging")
+{
+   FrameAllocator::dumpArenaUsage(argc > 1 && dAtob(argv[1]));
+}
@@ -35,6 +35,14 @@
 /// memory which is allocated and expected to be contiguous.
 #define FRAMEALLOCATOR_BYTE_ALIGNMENT 4
 
+/// Default size of the frame arena given to each ThreadPool worker thread and
+/// to other threads on their first frame allocation.  Worker arenas only hold
+/// scratch memory for a single work item, so they can be much smaller than the
+/// main thread's TORQUE_FRAME_SIZE; FrameTemps that do not fit go to the heap.
+#ifndef TORQUE_THREAD_FRAME_SIZE
+#  define TORQUE_THREAD_FRAME_SIZE  1 << 20
+#endif
+
 /// Temporary memory pool for per-frame allocations.
 ///
 /// In the course of rendering a frame, it is often necessary to allocate
@@ -51,91 +59,153 @@
 ///   // Free frameAllocator memory
 ///   FrameAllocator::setWaterMark(waterMark);
 /// @endcode
+///
+/// Each thread allocates from its own arena, so the FrameAllocator (and with it
+/// FrameAllocatorMarker and FrameTemp) may be used from any thread.  The main
+/// thread's arena is set up by init() and ThreadPool worker threads get one
+/// when they start.  Any other thread gets a TORQUE_THREAD_FRAME_SIZE arena on
+/// its first allocation, which Thread frees again when the thread exits.
 class FrameAllocator
 {
-   static U8*   smBuffer;
-   static U32   smHighWaterMark;
-   static U32   smWaterMark;
+  public:
+   /// A single thread's allocation buffer.
+   struct Arena
+   {
+      enum { MaxNameLength = 64 };
+
+      U8*   mBuffer;
+      U32   mWaterMark;
+      U32   mHighWaterMark;
+
+      /// Largest water mark reached since the last resetMaxWaterMarks().
+      U32   mMaxWaterMark;
+
+      char  mName[MaxNameLength];
+
+      /// Whether the arena is on the list used for reporting.
+      bool  mListed;
+      Arena* mNext;
+   };
+
+  private:
+   /// The calling thread's arena.
+   static TORQUE_THREAD_LOCAL Arena* smArena;
+
+   /// All live arenas, for reporting.
+   static Arena* smArenaList;
+   static void*  smArenaListMutex;
 
 #ifdef TORQUE_DEBUG
    static U32 smMaxFrameAllocation;
 #endif
 
+   /// Give a thread that never called initThread() a default arena.
+   static Arena* createDefaultArena();
+
+   static Arena* getArena()
+   {
+      Arena* arena = smArena;
+      if (!arena)
+         arena = createDefaultArena();
+      return arena;
+   }
+
   public:
-   inline static void init(const U32 frameSize);
-   inline static void destroy();
+   /// Set up the main thread's arena.
+   static void init(const U32 frameSize);
+   static void destroy();
+
+   /// Give the calling thread its own arena.
+   /// @param name Label used when reporting arena usage.
+   static void initThread(const U32 frameSize, const char* name);
+   static void destroyThread();
+
+   /// Return true if the calling thread has an arena.
+   static bool hasThreadArena() { return smArena != NULL; }
 
    inline static void* alloc(const U32 allocSize);
 
+   /// Return true if an allocation of @a allocSize bytes fits in what is left
+   /// of the calling thread's arena.
+   inline static bool canAlloc(const U32 allocSize);
+
    inline static void setWaterMark(const U32);
    inline static U32  getWaterMark();
    inline static U32  getHighWaterMark();
 
+   /// Return the largest water mark the calling thread's arena has reached.
+   inline static U32  getMaxWaterMark();
+
+   /// Print the size and peak usage of every arena to the console.  If
+   /// @a reset is true, the peaks are cleared afterwards.
+   static void dumpArenaUsage(bool reset = false);
+
+   /// Write the size and peak usage of every arena, one per line, to the
+   /// given callback.
+   static void reportArenaUsage(void (*report)(const char* line, void* userData), void* userData, bool reset);
+
 #ifdef TORQUE_DEBUG
    static U32 getMaxFrameAllocation() { return smMaxFrameAllocation; }
 #endif
 };
 
-void FrameAllocator::init(const U32 frameSize)
-{
-#ifdef FRAMEALLOCATOR_DEBUG_GUARD
-   AssertISV( false, "FRAMEALLOCATOR_DEBUG_GUARD has been removed because it allows non-contiguous memory allocation by the FrameAllocator, and this is *not* ok." );
-#endif
-
-   AssertFatal(smBuffer == NULL, "Error, already initialized");
-   smBuffer = new U8[frameSize];
-   smWaterMark = 0;
-   smHighWaterMark = frameSize;
-}
-
-void FrameAllocator::destroy()
-{
-   AssertFatal(smBuffer != NULL, "Error, not initialized");
-
-   delete [] smBuffer;
-   smBuffer = NULL;
-   smWaterMark = 0;
-   smHighWaterMark = 0;
-}
-
-
 void* FrameAllocator::alloc(const U32 allocSize)
 {
    U32 _allocSize = allocSize;
+   Arena* arena = getArena();
 
-   AssertFatal(smBuffer != NULL, "Error, no buffer!");
-   AssertFatal(smWaterMark + _allocSize <= smHighWaterMark, "Error alloc too large, increase frame size!");
-   smWaterMark = ( smWaterMark + ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ) & (~( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ));
+   AssertFatal(arena->mBuffer != NULL, "Error, no buffer!");
+   AssertFatal(arena->mWaterMark + _allocSize <= arena->mHighWaterMark, "Error alloc too large, increase frame size!");
+   U32 waterMark = ( arena->mWaterMark + ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ) & (~( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ));
 
    // Sanity check.
-   AssertFatal( !( smWaterMark & ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ), "Frame allocation is not on a specified byte boundry." );
+   AssertFatal( !( waterMark & ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ), "Frame allocation is not on a specified byte boundry." );
+
+   U8* p = &arena->mBuffer[waterMark];
+   waterMark += _allocSize;
+   arena->mWaterMark = waterMark;
 
-   U8* p = &smBuffer[smWaterMark];
-   smWaterMark += _allocSize;
+   if (waterMark > arena->mMaxWaterMark)
+   {
+      arena->mMaxWaterMark = waterMark;
 
 #ifdef TORQUE_DEBUG
-   if (smWaterMark > smMaxFrameAllocation)
-      smMaxFrameAllocation = smWaterMark;
+      if (waterMark > smMaxFrameAllocation)
+         smMaxFrameAllocation = waterMark;
 #endif
+   }
 
    return p;
 }
 
 
+bool FrameAllocator::canAlloc(const U32 allocSize)
+{
+   Arena* arena = getArena();
+   U32 waterMark = ( arena->mWaterMark + ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ) & (~( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ));
+   return ( waterMark <= arena->mHighWaterMark && allocSize <= arena->mHighWaterMark - waterMark );
+}
+
 void FrameAllocator::setWaterMark(const U32 waterMark)
 {
-   AssertFatal(waterMark < smHighWaterMark, "Error, invalid waterMark");
-   smWaterMark = waterMark;
+   Arena* arena = getArena();
+   AssertFatal(waterMark < arena->mHighWaterMark, "Error, invalid waterMark");
+   arena->mWaterMark = waterMark;
 }
 
 U32 FrameAllocator::getWaterMark()
 {
-   return smWaterMark;
+   return getArena()->mWaterMark;
 }
 
 U32 FrameAllocator::getHighWaterMark()
 {
-   return smHighWaterMark;
+   return getArena()->mHighWaterMark;
+}
+
+U32 FrameAllocator::getMaxWaterMark()
+{
+   return getArena()->mMaxWaterMark;
 }
 
 /// Helper class to deal with FrameAllocator usage.
@@ -203,6 +273,9 @@ public:
 /// @note It is important to note that this object is designed to just be a
 /// temporary array of a dynamic size. Some wierdness may occur if you try
 /// to perform crazy pointer stuff with it using regular operators on it.
+///
+/// @note If the allocation does not fit in what is left of the thread's
+/// arena, the memory comes from the heap instead.
 template<class T>
 class FrameTemp
 {
@@ -211,6 +284,29 @@ protected:
    T *mMemory;
    U32 mNumObjectsInMemory;
 
+   /// Whether #mMemory did not fit in the arena and was allocated on the heap.
+   bool mOnHeap;
+
+   void _allocate( const U32 count )
+   {
+      AssertFatal( count > 0, "Allocating a FrameTemp with less than one instance" );
+      const U32 size = sizeof( T ) * count;
+      mWaterMark = FrameAllocator::getWaterMark();
+      mOnHeap = !FrameAllocator::canAlloc( size );
+      if( mOnHeap )
+         mMemory = reinterpret_cast<T *>( dMalloc( size ) );
+      else
+         mMemory = reinterpret_cast<T *>( FrameAllocator::alloc( size ) );
+   }
+
+   void _free()
+   {
+      if( mOnHeap )
+         dFree( mMemory );
+      else
+         FrameAllocator::setWaterMark( mWaterMark );
+   }
+
 public:
    /// Constructor will store the FrameAllocator watermark and allocate the memory off
    /// of the FrameAllocator.
@@ -229,9 +325,7 @@ public:
    /// @param   count   The number of objects to allocate
    FrameTemp( const U32 count = 1 ) : mNumObjectsInMemory( count )
    {
-      AssertFatal( count > 0, "Allocating a FrameTemp with less than one instance" );
-      mWaterMark = FrameAllocator::getWaterMark();
-      mMemory = reinterpret_cast<T *>( FrameAllocator::alloc( sizeof( T ) * count ) );
+      _allocate( count );
 
       for( int i = 0; i < mNumObjectsInMemory; i++ )
          constructInPlace<T>( &mMemory[i] );
@@ -244,7 +338,7 @@ public:
       for( int i = 0; i < mNumObjectsInMemory; i++ )
          destructInPlace<T>( &mMemory[i] );
 
-      FrameAllocator::setWaterMark( mWaterMark );
+      _free();
    }
 
    /// NOTE: This will return the memory, NOT perform a ones-complement
@@ -289,16 +383,14 @@ public:
 // FrameTemp specializations for types with no constructor/destructor
 #define FRAME_TEMP_NC_SPEC(type) \
    template<> \
-   inline FrameTemp<type>::FrameTemp( const U32 count ) \
+   inline FrameTemp<type>::FrameTemp( const U32 count ) : mNumObjectsInMemory( count ) \
    { \
-      AssertFatal( count > 0, "Allocating a FrameTemp with less than one instance" ); \
-      mWaterMark = FrameAllocator::getWaterMark(); \
-      mMemory = reinterpret_cast<type *>( FrameAllocator::alloc( sizeof( type ) * count ) ); \
+      _allocate( count ); \
    } \
    template<>\
    inline FrameTemp<type>::~FrameTemp() \
    { \
-      FrameAllocator::setWaterMark( mWaterMark ); \
+      _free(); \
    } \
 
 FRAME_TEMP_NC_SPEC(char);
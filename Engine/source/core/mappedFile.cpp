@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/mappedFile.h"
+
+using namespace Torque;
+
+MappedFile::MappedFile()
+   : mData(NULL),
+     mSize(0),
+     mMapped(false),
+     mWritable(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+   close();
+}
+
+MappedFile *MappedFile::openForRead(const Path &path)
+{
+   FS::FileRef file = FS::OpenFile(path, FS::File::Read);
+   if(file == NULL)
+      return NULL;
+
+   MappedFile *mapped = new MappedFile;
+   mapped->mFile = file;
+   mapped->mSize = file->getSize();
+   if(!mapped->mSize)
+      return mapped;
+
+   mapped->mData = (U8 *) file->map(mapped->mSize);
+   if(mapped->mData)
+   {
+      mapped->mMapped = true;
+      return mapped;
+   }
+
+   // Can't map it, so read it all in.
+   mapped->mData = (U8 *) dMalloc(mapped->mSize);
+   if(file->read(mapped->mData, mapped->mSize) != mapped->mSize)
+   {
+      delete mapped;
+      return NULL;
+   }
+   return mapped;
+}
+
+MappedFile *MappedFile::create(const Path &path, U32 size)
+{
+   // ReadWrite doesn't truncate, so start from nothing.
+   if(FS::IsFile(path))
+      FS::Remove(path);
+
+   FS::CreatePath(path);
+   FS::FileRef file = FS::OpenFile(path, FS::File::ReadWrite);
+   if(file == NULL)
+      return NULL;
+
+   MappedFile *mapped = new MappedFile;
+   mapped->mFile = file;
+   mapped->mSize = size;
+   mapped->mWritable = true;
+   if(!size)
+      return mapped;
+
+   mapped->mData = (U8 *) file->map(size);
+   if(mapped->mData)
+      mapped->mMapped = true;
+   else
+      mapped->mData = (U8 *) dMalloc(size);
+   return mapped;
+}
+
+bool MappedFile::close()
+{
+   if(mFile == NULL)
+      return true;
+
+   bool ok = true;
+   if(mMapped)
+      mFile->unmap(mData, mSize);
+   else
+   {
+      // Write out what couldn't be mapped.
+      if(mWritable && mSize)
+      {
+         mFile->setPosition(0, FS::File::Begin);
+         ok = mFile->write(mData, mSize) == mSize;
+      }
+      dFree(mData);
+   }
+
+   mFile->close();
+   mFile = NULL;
+   mData = NULL;
+   mMapped = false;
+   return ok;
+}
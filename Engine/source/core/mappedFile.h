@@ -0,0 +1,68 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#ifndef _VOLUME_H_
+#include "core/volume.h"
+#endif
+
+/// The contents of a file, mapped into memory.
+///
+/// Files on file systems that can't be mapped, such as in-memory volumes,
+/// are read into a buffer instead, or for files being written, written out
+/// from one when they are closed.  Either way getData() points at the whole
+/// file.
+class MappedFile : public StrongRefBase
+{
+public:
+   /// Map a file to read it.  Returns NULL if it can't be opened.
+   static MappedFile *openForRead(const Torque::Path &path);
+
+   /// Create a file of the given size and map it to write it.  Returns NULL
+   /// if it can't be created.
+   static MappedFile *create(const Torque::Path &path, U32 size);
+
+   ~MappedFile();
+
+   U8 *getData() const { return mData; }
+   U32 getSize() const { return mSize; }
+
+   /// Whether the data is mapped from the file instead of copied.
+   bool isMapped() const { return mMapped; }
+
+   /// Unmap the file and close it.  Returns false if the data couldn't be
+   /// written out.
+   bool close();
+
+protected:
+   MappedFile();
+
+   Torque::FS::FileRef mFile;
+   U8 *mData;
+   U32 mSize;
+   bool mMapped;
+   bool mWritable;
+};
+
+#endif // _MAPPEDFILE_H_
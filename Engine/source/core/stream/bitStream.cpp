@@ -28,6 +28,7 @@
 #include "console/consoleObject.h"
 #include "platform/platformNet.h"
 #include "core/bitVector.h"
+#include "core/stream/stringCoder.h"
 
 
 static BitStream gPacketStream(NULL, 0);
@@ -138,6 +139,8 @@ class HuffmanProcessor
   public:
    HuffmanProcessor() : m_tablesBuilt(false) { }
 
+   void init() { if (m_tablesBuilt == false) buildTables(); }
+
    static HuffmanProcessor g_huffProcessor;
 
    bool readHuffBuffer(BitStream* pStream, char* out_pBuffer);
@@ -146,6 +149,11 @@ class HuffmanProcessor
 
 HuffmanProcessor HuffmanProcessor::g_huffProcessor;
 
+void BitStream::initHuffmanTables()
+{
+   HuffmanProcessor::g_huffProcessor.init();
+}
+
 void BitStream::setBuffer(void *bufPtr, S32 size, S32 maxSize)
 {
    dataPtr = (U8 *) bufPtr;
@@ -156,6 +164,7 @@ void BitStream::setBuffer(void *bufPtr, S32 size, S32 maxSize)
       maxSize = size;
    maxWriteBitNum = maxSize << 3;
    error = false;
+   mStringCoder = NULL;
    clearCompressionPoint();
 }
 
@@ -228,17 +237,27 @@ void BitStream::writeBits(S32 bitCount, const void *bitPtr)
    if(!bitCount)
       return;
 
-   if(bitCount + bitNum > maxWriteBitNum)
+   if(bitCount + bitNum > maxWriteBitNum && !_growForWrite(bitCount))
    {
       error = true;
       AssertFatal(false, "Out of range write");
       return;
    }
 
-   // [tom, 8/17/2006] This is probably a lot lamer then it needs to be. However,
-   // at least it doesnt clobber data or overrun the buffer like the old code did.
    const U8 *ptr = (U8 *)bitPtr;
 
+   // Move 32 bits at a time while the word around the write position is
+   // inside the buffer.
+   while(bitCount > 0 && _canWriteWord())
+   {
+      S32 count = getMin(bitCount, 32);
+      _writeWord(_gatherBits(ptr, count), count);
+      ptr += 4;
+      bitCount -= count;
+   }
+
+   // [tom, 8/17/2006] This is probably a lot lamer then it needs to be. However,
+   // at least it doesnt clobber data or overrun the buffer like the old code did.
    for(S32 srcBitNum = 0;srcBitNum < bitCount;srcBitNum++)
    {
       if((*(ptr + (srcBitNum >> 3)) & (1 << (srcBitNum & 0x7))) != 0)
@@ -262,22 +281,6 @@ bool BitStream::testBit(S32 bitCount)
    return (*(dataPtr + (bitCount >> 3)) & (1 << (bitCount & 0x7))) != 0;
 }
 
-bool BitStream::writeFlag(bool val)
-{
-   if(bitNum + 1 > maxWriteBitNum)
-   {
-      error = true;
-      AssertFatal(false, "Out of range write");
-      return false;
-   }
-   if(val)
-      *(dataPtr + (bitNum >> 3)) |= (1 << (bitNum & 0x7));
-   else
-      *(dataPtr + (bitNum >> 3)) &= ~(1 << (bitNum & 0x7));
-   bitNum++;
-   return (val);
-}
-
 void BitStream::readBits(S32 bitCount, void *bitPtr)
 {
    if(!bitCount)
@@ -289,11 +292,29 @@ void BitStream::readBits(S32 bitCount, void *bitPtr)
       AssertWarn(false, "Out of range read");
       return;
    }
+   U8 *ptr = (U8 *) bitPtr;
+
+   // Move 32 bits at a time while the word around the read position is
+   // inside the buffer.  Like the byte loop below, the last byte written
+   // also carries the stream bits that follow the requested ones.
+   while(bitCount > 0 && (bitNum >> 3) + 8 <= bufSize)
+   {
+      S32 count = getMin(bitCount, 32);
+      U32 word = U32(_peekWord());
+      bitNum += count;
+      for(S32 i = 0; i < count; i += 8)
+      {
+         *ptr++ = U8(word);
+         word >>= 8;
+      }
+      bitCount -= count;
+   }
+   if(!bitCount)
+      return;
+
    U8 *stPtr = dataPtr + (bitNum >> 3);
    S32 byteCount = (bitCount + 7) >> 3;
 
-   U8 *ptr = (U8 *) bitPtr;
-
    S32 downShift = bitNum & 0x7;
    S32 upShift = 8 - downShift;
 
@@ -322,24 +343,6 @@ bool BitStream::_write(U32 size, const void *dataPtr)
    return true;
 }
 
-S32 BitStream::readInt(S32 bitCount)
-{
-   S32 ret = 0;
-   readBits(bitCount, &ret);
-   ret = convertLEndianToHost(ret);
-   if(bitCount == 32)
-      return ret;
-   else
-      ret &= (1 << bitCount) - 1;
-   return ret;
-}
-
-void BitStream::writeInt(S32 val, S32 bitCount)
-{
-   val = convertHostToLEndian(val);
-   writeBits(bitCount, &val);
-}
-
 void BitStream::writeFloat(F32 f, S32 bitCount)
 {
    writeInt((S32)(f * ((1 << bitCount) - 1)), bitCount);
@@ -660,19 +663,27 @@ void InfiniteBitStream::writeToStream(Stream &s)
 
 void BitStream::readString(char buf[256])
 {
-   if(stringBuffer)
+   if(stringBuffer && readFlag())
    {
-      if(readFlag())
-      {
-         S32 offset = readInt(8);
+      S32 offset = readInt(8);
+      if(mStringCoder)
+         mStringCoder->readString(this, stringBuffer + offset);
+      else
          HuffmanProcessor::g_huffProcessor.readHuffBuffer(this, stringBuffer + offset);
-         dStrcpy(buf, stringBuffer);
-         return;
-      }
+      dStrcpy(buf, stringBuffer);
    }
-   HuffmanProcessor::g_huffProcessor.readHuffBuffer(this, buf);
-   if(stringBuffer)
-      dStrcpy(stringBuffer, buf);
+   else
+   {
+      if(mStringCoder)
+         mStringCoder->readString(this, buf);
+      else
+         HuffmanProcessor::g_huffProcessor.readHuffBuffer(this, buf);
+      if(stringBuffer)
+         dStrcpy(stringBuffer, buf);
+   }
+
+   if(StringCoder::isCapturing())
+      StringCoder::captureString(buf);
 }
 
 void BitStream::writeString(const char *string, S32 maxLen)
@@ -690,11 +701,14 @@ void BitStream::writeString(const char *string, S32 maxLen)
       if(writeFlag(j > 2))
       {
          writeInt(j, 8);
-         HuffmanProcessor::g_huffProcessor.writeHuffBuffer(this, string + j, maxLen - j);
-         return;
+         string += j;
+         maxLen -= j;
       }
    }
-   HuffmanProcessor::g_huffProcessor.writeHuffBuffer(this, string, maxLen);
+   if(mStringCoder)
+      mStringCoder->writeString(this, string, maxLen);
+   else
+      HuffmanProcessor::g_huffProcessor.writeHuffBuffer(this, string, maxLen);
 }
 
 void HuffmanProcessor::buildTables()
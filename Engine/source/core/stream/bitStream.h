@@ -42,6 +42,7 @@
 class Point3F;
 class MatrixF;
 class HuffmanProcessor;
+class StringCoder;
 class BitVector;
 class QuatF;
 
@@ -56,12 +57,50 @@ protected:
    S32  maxWriteBitNum;
    char *stringBuffer;
    Point3F mCompressPoint;
+   const StringCoder *mStringCoder;
 
    friend class HuffmanProcessor;
+
+   /// Called when a write of @a bitCount bits would run past the end of
+   /// the buffer.  Streams that can grow make room and return true, all
+   /// others return false and the write fails.
+   virtual bool _growForWrite(S32 bitCount) { return false; }
+
+   /// Returns true if the 64 bit word starting at the current byte lies
+   /// inside the writable part of the buffer, so up to 32 bits can be
+   /// written with _writeWord().
+   bool _canWriteWord() const { return (bitNum >> 3) + 8 <= (maxWriteBitNum >> 3); }
+
+   /// Returns true if up to 32 bits can be read with _readWord().
+   bool _canReadWord(S32 bitCount) const { return (bitNum >> 3) + 8 <= bufSize && bitNum + bitCount <= maxReadBitNum; }
+
+   /// Write the low @a bitCount bits (at most 32) of @a value at the current
+   /// position by updating the little endian 64 bit word holding them.  The
+   /// resulting bytes are exactly what writeBits() produces.
+   void _writeWord(U32 value, S32 bitCount);
+
+   /// Little endian 64 bit load and store of unaligned buffer bytes.
+   static U64 _loadWord(const U8 *ptr);
+   static void _storeWord(U8 *ptr, U64 word);
+
+   /// Returns the buffer contents from the current position on, at least
+   /// 57 bits of them, without moving the position.
+   U64 _peekWord() const;
+
+   /// Read @a bitCount bits (at most 32) from the current position.
+   U32 _readWord(S32 bitCount);
+
+   /// Gather the low @a bitCount bits (at most 32) of a little endian byte
+   /// buffer.  Only the bytes holding those bits are touched.
+   static U32 _gatherBits(const U8 *ptr, S32 bitCount);
 public:
    static BitStream *getPacketStream(U32 writeSize = 0);
    static void sendPacketStream(const NetAddress *addr);
 
+   /// Build the tables used to compress strings if they haven't been built yet.
+   /// Must be called on the main thread before streams are written concurrently.
+   static void initHuffmanTables();
+
    void setBuffer(void *bufPtr, S32 bufSize, S32 maxSize = 0);
    U8*  getBuffer() { return dataPtr; }
    U8*  getBytePtr();
@@ -87,6 +126,12 @@ public:
    void clear();
 
    void setStringBuffer(char buffer[256]);
+
+   /// Use the given coder for the strings in writeString() and readString()
+   /// in place of the built-in Huffman table.  NULL selects the built-in
+   /// table.  setBuffer() resets it to NULL.
+   void setStringCoder(const StringCoder *coder) { mStringCoder = coder; }
+   const StringCoder *getStringCoder() const { return mStringCoder; }
    void writeInt(S32 value, S32 bitCount);
    S32  readInt(S32 bitCount);
 
@@ -169,6 +214,7 @@ public:
 
    void clearCompressionPoint();
    void setCompressionPoint(const Point3F& p);
+   const Point3F& getCompressionPoint() const { return mCompressPoint; }
 
    // Matching calls to these compression methods must, of course,
    // have matching scale values.
@@ -219,9 +265,9 @@ public:
    ///
    void readQuat( QuatF *outQuat, U32 bitCount = 9 );
 
-   virtual void writeBits(S32 bitCount, const void *bitPtr);
-   virtual void readBits(S32 bitCount, void *bitPtr);
-   virtual bool writeFlag(bool val);
+   void writeBits(S32 bitCount, const void *bitPtr);
+   void readBits(S32 bitCount, void *bitPtr);
+   bool writeFlag(bool val);
    
    inline bool writeFlag(U32 val)
    {
@@ -233,7 +279,7 @@ public:
       return writeFlag(val != 0);
    }
 
-   virtual bool readFlag();
+   bool readFlag();
 
    void writeBits(const BitVector &bitvec);
    void readBits(BitVector *bitvec);
@@ -269,10 +315,17 @@ public:
 /// This class acts to provide an "infinitely extending" stream.
 ///
 /// Basically, it does what ResizeBitStream does, but it validates
-/// on every write op, so that you never have to worry about overwriting
-/// the buffer.
+/// whenever a write would run out of room, so that you never have to
+/// worry about overwriting the buffer.
 class InfiniteBitStream : public ResizeBitStream
 {
+protected:
+   virtual bool _growForWrite(S32 bitCount)
+   {
+      validate((bitCount >> 3) + 1); // Add a little safety.
+      return bitNum + bitCount <= maxWriteBitNum;
+   }
+
 public:
    InfiniteBitStream();
    ~InfiniteBitStream();
@@ -289,18 +342,6 @@ public:
    /// Write us out to a stream... Results in last byte getting padded!
    void writeToStream(Stream &s);
 
-   virtual void writeBits(S32 bitCount, const void *bitPtr)
-   {
-      validate((bitCount >> 3) + 1); // Add a little safety.
-      BitStream::writeBits(bitCount, bitPtr);
-   }
-
-   virtual bool writeFlag(bool val)
-   {
-      validate(1); // One bit will at most grow our buffer by a byte.
-      return BitStream::writeFlag(val);
-   }
-
    const U32 getCRC()
    {
       // This could be kinda inefficient - BJG
@@ -322,6 +363,95 @@ inline void BitStream::setCurPos(const U32 in_position)
    bitNum = S32(in_position);
 }
 
+inline void BitStream::_writeWord(U32 value, S32 bitCount)
+{
+   U8 *ptr = dataPtr + (bitNum >> 3);
+   S32 shift = bitNum & 0x7;
+   U64 mask = ((U64(1) << bitCount) - 1) << shift;
+
+   U64 word = _loadWord(ptr);
+   word = (word & ~mask) | ((U64(value) << shift) & mask);
+   _storeWord(ptr, word);
+
+   bitNum += bitCount;
+}
+
+inline U64 BitStream::_loadWord(const U8 *ptr)
+{
+   // Compilers turn these into a single (unaligned) load on little endian
+   // machines.
+   return U64(ptr[0])       | (U64(ptr[1]) << 8)  | (U64(ptr[2]) << 16) | (U64(ptr[3]) << 24) |
+         (U64(ptr[4]) << 32) | (U64(ptr[5]) << 40) | (U64(ptr[6]) << 48) | (U64(ptr[7]) << 56);
+}
+
+inline void BitStream::_storeWord(U8 *ptr, U64 word)
+{
+   ptr[0] = U8(word);       ptr[1] = U8(word >> 8);  ptr[2] = U8(word >> 16); ptr[3] = U8(word >> 24);
+   ptr[4] = U8(word >> 32); ptr[5] = U8(word >> 40); ptr[6] = U8(word >> 48); ptr[7] = U8(word >> 56);
+}
+
+inline U64 BitStream::_peekWord() const
+{
+   return _loadWord(dataPtr + (bitNum >> 3)) >> (bitNum & 0x7);
+}
+
+inline U32 BitStream::_readWord(S32 bitCount)
+{
+   U64 word = _peekWord();
+   bitNum += bitCount;
+   return U32(word & ((U64(1) << bitCount) - 1));
+}
+
+inline U32 BitStream::_gatherBits(const U8 *ptr, S32 bitCount)
+{
+   U32 ret = 0;
+   for(S32 i = 0; i < bitCount; i += 8)
+      ret |= U32(*ptr++) << i;
+   return ret;
+}
+
+inline void BitStream::writeInt(S32 val, S32 bitCount)
+{
+   if(_canWriteWord())
+      _writeWord(U32(val), bitCount);
+   else
+   {
+      val = convertHostToLEndian(val);
+      writeBits(bitCount, &val);
+   }
+}
+
+inline S32 BitStream::readInt(S32 bitCount)
+{
+   if(_canReadWord(bitCount))
+      return S32(_readWord(bitCount));
+
+   S32 ret = 0;
+   readBits(bitCount, &ret);
+   ret = convertLEndianToHost(ret);
+   if(bitCount == 32)
+      return ret;
+   else
+      ret &= (1 << bitCount) - 1;
+   return ret;
+}
+
+inline bool BitStream::writeFlag(bool val)
+{
+   if(bitNum + 1 > maxWriteBitNum && !_growForWrite(1))
+   {
+      error = true;
+      AssertFatal(false, "Out of range write");
+      return false;
+   }
+   if(val)
+      *(dataPtr + (bitNum >> 3)) |= (1 << (bitNum & 0x7));
+   else
+      *(dataPtr + (bitNum >> 3)) &= ~(1 << (bitNum & 0x7));
+   bitNum++;
+   return (val);
+}
+
 inline bool BitStream::readFlag()
 {
    if(bitNum > maxReadBitNum)
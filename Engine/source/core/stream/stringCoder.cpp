@@ -0,0 +1,597 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/stream/stringCoder.h"
+
+#include "core/stream/bitStream.h"
+#include "core/stream/fileStream.h"
+#include "core/strings/stringFunctions.h"
+#include "core/crc.h"
+#include "console/console.h"
+#include "console/engineAPI.h"
+
+bool StringCoder::smCapturing = false;
+Map<String, U32> StringCoder::smCaptured;
+
+void StringCoder::startCapture()
+{
+   smCaptured.clear();
+   smCapturing = true;
+}
+
+void StringCoder::stopCapture()
+{
+   smCapturing = false;
+}
+
+void StringCoder::captureString(const char *string)
+{
+   smCaptured[string]++;
+}
+
+//-----------------------------------------------------------------------------
+
+static const U32 StringDictionaryFileVersion = 1;
+
+/// Pairs seen fewer times than this in training don't become words.
+static const U32 MinWordCount = 4;
+
+StringDictionary::StringDictionary()
+{
+   mFreqs.setSize(256);
+   dMemset(mFreqs.address(), 0, mFreqs.memSize());
+   mCRC = 0;
+   build();
+}
+
+void StringDictionary::build()
+{
+   U32 numSymbols = 256 + mWords.size();
+   AssertFatal(mFreqs.size() == numSymbols, "StringDictionary::build - wrong number of frequencies.");
+
+   for(U32 i = 0; i < 256; i++)
+      mWordsByFirst[i].clear();
+   for(U32 i = 0; i < mWords.size(); i++)
+      mWordsByFirst[U8(mWords[i][0])].push_back(i);
+
+   mCRC = CRC::INITIAL_CRC_VALUE;
+   for(U32 i = 0; i < mWords.size(); i++)
+      mCRC = CRC::calculateCRC(mWords[i].c_str(), mWords[i].length() + 1, mCRC);
+   mCRC = CRC::calculateCRC(mFreqs.address(), mFreqs.memSize(), mCRC);
+
+   // Build the Huffman tree.  Symbols that were never seen still need a
+   // code, so everything gets one extra.  If the tree comes out too deep,
+   // flatten the weights and try again.
+
+   Vector<U32> weights(numSymbols);
+   for(U32 i = 0; i < numSymbols; i++)
+      weights.push_back(mFreqs[i] + 1);
+
+   for(;;)
+   {
+      struct Item
+      {
+         U32 weight;
+         S16 ref;
+      };
+
+      Vector<Item> items(numSymbols);
+      for(U32 i = 0; i < numSymbols; i++)
+      {
+         Item item = { weights[i], S16(-S32(i) - 1) };
+         items.push_back(item);
+      }
+
+      mNodes.clear();
+      while(items.size() > 1)
+      {
+         U32 min1 = 0, min2 = 1;
+         if(items[1].weight < items[0].weight)
+         {
+            min1 = 1;
+            min2 = 0;
+         }
+         for(U32 i = 2; i < items.size(); i++)
+         {
+            if(items[i].weight < items[min1].weight)
+            {
+               min2 = min1;
+               min1 = i;
+            }
+            else if(items[i].weight < items[min2].weight)
+               min2 = i;
+         }
+
+         Node node;
+         node.child[0] = items[min1].ref;
+         node.child[1] = items[min2].ref;
+         mNodes.push_back(node);
+
+         Item merged = { items[min1].weight + items[min2].weight, S16(mNodes.size() - 1) };
+         items[getMin(min1, min2)] = merged;
+         items.erase_fast(getMax(min1, min2));
+      }
+
+      // Walk the tree to hand out the codes.  The root is the last node.
+
+      struct Entry
+      {
+         S16 ref;
+         U32 code;
+         U32 depth;
+      };
+
+      Vector<Entry> stack;
+      Entry root = { S16(mNodes.size() - 1), 0, 0 };
+      stack.push_back(root);
+
+      U32 maxDepth = 0;
+      while(stack.size())
+      {
+         Entry entry = stack.last();
+         stack.pop_back();
+
+         if(entry.ref < 0)
+         {
+            U32 symbol = -(entry.ref + 1);
+            mCodes[symbol] = entry.code;
+            mCodeBits[symbol] = getMin(entry.depth, U32(255));
+            maxDepth = getMax(maxDepth, entry.depth);
+            continue;
+         }
+
+         for(U32 bit = 0; bit < 2; bit++)
+         {
+            Entry child = { mNodes[entry.ref].child[bit], entry.depth < 32 ? entry.code | (bit << entry.depth) : 0, entry.depth + 1 };
+            stack.push_back(child);
+         }
+      }
+
+      if(maxDepth <= MaxCodeBits)
+         break;
+
+      for(U32 i = 0; i < numSymbols; i++)
+         weights[i] = (weights[i] >> 1) + 1;
+   }
+}
+
+U32 StringDictionary::parse(const char *string, U32 len, U16 symbols[256]) const
+{
+   // Find the cheapest way to code each tail of the string, working back
+   // from the end.
+
+   U32 cost[256];
+   U16 choice[255];
+
+   cost[len] = 0;
+   for(S32 i = len - 1; i >= 0; i--)
+   {
+      U8 c = string[i];
+      cost[i] = cost[i + 1] + mCodeBits[c];
+      choice[i] = c;
+
+      const Vector<U16> &words = mWordsByFirst[c];
+      for(U32 j = 0; j < words.size(); j++)
+      {
+         const String &word = mWords[words[j]];
+         U32 wordLen = word.length();
+         if(wordLen > len - i || dMemcmp(word.c_str(), string + i, wordLen))
+            continue;
+
+         U32 wordCost = cost[i + wordLen] + mCodeBits[256 + words[j]];
+         if(wordCost < cost[i])
+         {
+            cost[i] = wordCost;
+            choice[i] = 256 + words[j];
+         }
+      }
+   }
+
+   U32 count = 0;
+   for(U32 i = 0; i < len; )
+   {
+      symbols[count++] = choice[i];
+      i += choice[i] < 256 ? 1 : mWords[choice[i] - 256].length();
+   }
+   return count;
+}
+
+void StringDictionary::writeString(BitStream *stream, const char *string, S32 maxLen) const
+{
+   if(!string)
+      string = "";
+
+   U32 len = getMin(S32(dStrlen(string)), getMin(maxLen, S32(255)));
+
+   U16 symbols[256];
+   U32 count = parse(string, len, symbols);
+
+   U32 bits = 0;
+   for(U32 i = 0; i < count; i++)
+      bits += mCodeBits[symbols[i]];
+
+   if(stream->writeFlag(bits < len * 8))
+   {
+      stream->writeInt(count, 8);
+      for(U32 i = 0; i < count; i++)
+         stream->writeInt(mCodes[symbols[i]], mCodeBits[symbols[i]]);
+   }
+   else
+   {
+      stream->writeInt(len, 8);
+      stream->write(len, string);
+   }
+}
+
+void StringDictionary::readString(BitStream *stream, char buf[256]) const
+{
+   U32 len = 0;
+   if(stream->readFlag())
+   {
+      U32 count = stream->readInt(8);
+      S32 root = mNodes.size() - 1;
+      for(U32 i = 0; i < count; i++)
+      {
+         S32 index = root;
+         while(index >= 0)
+            index = mNodes[index].child[stream->readFlag()];
+
+         U32 symbol = -(index + 1);
+         if(symbol < 256)
+         {
+            if(len < 255)
+               buf[len++] = symbol;
+         }
+         else
+         {
+            const String &word = mWords[symbol - 256];
+            U32 n = getMin(U32(word.length()), 255 - len);
+            dMemcpy(buf + len, word.c_str(), n);
+            len += n;
+         }
+      }
+   }
+   else
+   {
+      len = stream->readInt(8);
+      stream->read(len, buf);
+   }
+   buf[len] = '\0';
+}
+
+//-----------------------------------------------------------------------------
+
+StringDictionary *StringDictionary::train(const Map<String, U32> &strings, U32 maxWords)
+{
+   maxWords = getMin(maxWords, U32(MaxWords));
+
+   // Every distinct string as a list of symbols, weighted by how many
+   // times it was seen.
+
+   Vector< Vector<U16> > sequences;
+   Vector<U32> counts;
+   sequences.reserve(strings.size());
+   counts.reserve(strings.size());
+   for(Map<String, U32>::ConstIterator iter = strings.begin(); iter != strings.end(); ++iter)
+   {
+      const String &string = (*iter).key;
+      U32 len = getMin(string.length(), U32(255));
+      if(len < 2)
+         continue;
+
+      sequences.increment();
+      Vector<U16> &symbols = sequences.last();
+      symbols.setSize(len);
+      for(U32 i = 0; i < len; i++)
+         symbols[i] = U8(string[i]);
+      counts.push_back((*iter).value);
+   }
+
+   StringDictionary *dict = new StringDictionary;
+   Vector<String> &words = dict->mWords;
+   Vector<U32> pairCounts;
+   pairCounts.setSize(MaxSymbols * MaxSymbols);
+
+   // Keep making the most common pair of symbols into a new word.
+
+   while(words.size() < maxWords)
+   {
+      dMemset(pairCounts.address(), 0, pairCounts.memSize());
+      for(U32 i = 0; i < sequences.size(); i++)
+      {
+         const Vector<U16> &symbols = sequences[i];
+         for(U32 j = 1; j < symbols.size(); j++)
+            pairCounts[symbols[j - 1] * MaxSymbols + symbols[j]] += counts[i];
+      }
+
+      U32 best = 0;
+      U32 bestCount = MinWordCount - 1;
+      for(U32 i = 0; i < pairCounts.size(); i++)
+      {
+         if(pairCounts[i] <= bestCount)
+            continue;
+
+         U32 first = i / MaxSymbols;
+         U32 second = i % MaxSymbols;
+         U32 len = (first < 256 ? 1 : words[first - 256].length()) + (second < 256 ? 1 : words[second - 256].length());
+         if(len > MaxWordLength)
+            continue;
+
+         best = i;
+         bestCount = pairCounts[i];
+      }
+      if(bestCount < MinWordCount)
+         break;
+
+      U16 first = best / MaxSymbols;
+      U16 second = best % MaxSymbols;
+      String word = first < 256 ? String::ToString("%c", first) : words[first - 256];
+      word += second < 256 ? String::ToString("%c", second) : words[second - 256];
+
+      U16 symbol = 256 + words.size();
+      words.push_back(word);
+
+      for(U32 i = 0; i < sequences.size(); i++)
+      {
+         Vector<U16> &symbols = sequences[i];
+         U32 out = 0;
+         for(U32 j = 0; j < symbols.size(); j++)
+         {
+            if(j + 1 < symbols.size() && symbols[j] == first && symbols[j + 1] == second)
+            {
+               symbols[out++] = symbol;
+               j++;
+            }
+            else
+               symbols[out++] = symbols[j];
+         }
+         symbols.setSize(out);
+      }
+   }
+
+   // Weigh the symbols by how often they came up in training, then again
+   // with the strings split the way writeString() will split them.
+
+   dict->mFreqs.setSize(256 + words.size());
+   dMemset(dict->mFreqs.address(), 0, dict->mFreqs.memSize());
+   for(U32 i = 0; i < sequences.size(); i++)
+   {
+      for(U32 j = 0; j < sequences[i].size(); j++)
+         dict->mFreqs[sequences[i][j]] += counts[i];
+   }
+   dict->build();
+
+   Vector<U32> freqs;
+   freqs.setSize(dict->mFreqs.size());
+   dMemset(freqs.address(), 0, freqs.memSize());
+   for(Map<String, U32>::ConstIterator iter = strings.begin(); iter != strings.end(); ++iter)
+   {
+      const String &string = (*iter).key;
+      U16 symbols[256];
+      U32 count = dict->parse(string.c_str(), getMin(string.length(), U32(255)), symbols);
+      for(U32 i = 0; i < count; i++)
+         freqs[symbols[i]] += (*iter).value;
+   }
+   dict->mFreqs = freqs;
+   dict->build();
+
+   return dict;
+}
+
+//-----------------------------------------------------------------------------
+
+bool StringDictionary::read(Stream &stream)
+{
+   U32 version;
+   U16 numWords;
+   if(!stream.read(&version) || version != StringDictionaryFileVersion)
+      return false;
+   if(!stream.read(&numWords) || numWords > MaxWords)
+      return false;
+
+   mWords.clear();
+   for(U32 i = 0; i < numWords; i++)
+   {
+      char word[256];
+      stream.readString(word);
+      U32 len = dStrlen(word);
+      if(len < 2 || len > MaxWordLength)
+         return false;
+      mWords.push_back(word);
+   }
+
+   mFreqs.setSize(256 + numWords);
+   for(U32 i = 0; i < mFreqs.size(); i++)
+   {
+      if(!stream.read(&mFreqs[i]))
+         return false;
+   }
+
+   build();
+   return stream.getStatus() == Stream::Ok || stream.getStatus() == Stream::EOS;
+}
+
+bool StringDictionary::write(Stream &stream) const
+{
+   stream.write(StringDictionaryFileVersion);
+   stream.write(U16(mWords.size()));
+   for(U32 i = 0; i < mWords.size(); i++)
+      stream.writeString(mWords[i]);
+   for(U32 i = 0; i < mFreqs.size(); i++)
+      stream.write(mFreqs[i]);
+   return stream.getStatus() == Stream::Ok || stream.getStatus() == Stream::EOS;
+}
+
+StringDictionary *StringDictionary::load(const char *fileName)
+{
+   FileStream *stream = FileStream::createAndOpen(fileName, Torque::FS::File::Read);
+   if(!stream)
+      return NULL;
+
+   StringDictionary *dict = new StringDictionary;
+   if(!dict->read(*stream))
+   {
+      Con::errorf("StringDictionary::load - failed to read %s", fileName);
+      SAFE_DELETE(dict);
+   }
+   delete stream;
+   return dict;
+}
+
+//-----------------------------------------------------------------------------
+
+DefineEngineFunction( startStringCapture, void, (),,
+   "@brief Start counting the strings read from the network.\n\n"
+
+   "Every string read with BitStream::readString() is counted until stopStringCapture() is "
+   "called.  Play back a recorded demo while capturing to collect the strings a game sends, "
+   "then use trainStringDictionary() and reportStringCompression() on them.  Clears the "
+   "strings captured before.\n\n"
+
+   "@see $pref::Net::StringDictionary\n\n"
+   "@ingroup Networking" )
+{
+   StringCoder::startCapture();
+}
+
+DefineEngineFunction( stopStringCapture, void, (),,
+   "@brief Stop counting the strings read from the network.\n\n"
+
+   "The strings captured so far are kept for trainStringDictionary() and "
+   "reportStringCompression().\n\n"
+
+   "@ingroup Networking" )
+{
+   StringCoder::stopCapture();
+}
+
+DefineEngineFunction( trainStringDictionary, bool, ( const char* fileName, S32 maxWords ), ( StringDictionary::MaxWords ),
+   "@brief Train a string dictionary on the captured strings and save it.\n\n"
+
+   "@param fileName File to save the dictionary to.\n"
+   "@param maxWords Most words to put in the dictionary, up to 256.\n"
+   "@return True if the dictionary was saved.\n\n"
+
+   "@see startStringCapture()\n"
+   "@ingroup Networking" )
+{
+   const Map<String, U32> &strings = StringCoder::getCapturedStrings();
+   if(strings.isEmpty())
+   {
+      Con::errorf("trainStringDictionary - no strings captured.");
+      return false;
+   }
+
+   StringDictionary *dict = StringDictionary::train(strings, getMax(maxWords, 0));
+
+   char path[1024];
+   Con::expandScriptFilename(path, sizeof(path), fileName);
+   FileStream *stream = FileStream::createAndOpen(path, Torque::FS::File::Write);
+   bool ok = stream && dict->write(*stream);
+   delete stream;
+
+   if(ok)
+      Con::printf("Saved string dictionary with %d words to %s.", dict->getNumWords(), path);
+   else
+      Con::errorf("trainStringDictionary - could not write %s.", path);
+
+   delete dict;
+   return ok;
+}
+
+DefineEngineFunction( reportStringCompression, void, ( const char* dictionaryFile ), ( "" ),
+   "@brief Print how well the captured strings compress.\n\n"
+
+   "Prints the size of the captured strings as plain bytes, with the built-in Huffman table "
+   "and, if a dictionary file is given, with that dictionary.  Sizes include the bits that "
+   "writeString() adds for the length.\n\n"
+
+   "@param dictionaryFile A dictionary saved by trainStringDictionary().\n\n"
+
+   "@tsexample\n"
+   "// Measure a dictionary on the strings in a recorded demo.\n"
+   "startStringCapture();\n"
+   "playDemo( \"demos/test.rec\" );\n"
+   "// ... once the demo has finished:\n"
+   "stopStringCapture();\n"
+   "reportStringCompression( \"core/strings.dict\" );\n"
+   "@endtsexample\n\n"
+
+   "@ingroup Networking" )
+{
+   const Map<String, U32> &strings = StringCoder::getCapturedStrings();
+
+   StringDictionary *dict = NULL;
+   if(dictionaryFile[0])
+   {
+      char path[1024];
+      Con::expandScriptFilename(path, sizeof(path), dictionaryFile);
+      dict = StringDictionary::load(path);
+      if(!dict)
+      {
+         Con::errorf("reportStringCompression - could not load %s.", path);
+         return;
+      }
+   }
+
+   U64 total = 0;
+   U64 rawBits = 0;
+   U64 huffBits = 0;
+   U64 dictBits = 0;
+
+   U8 buffer[512];
+   for(Map<String, U32>::ConstIterator iter = strings.begin(); iter != strings.end(); ++iter)
+   {
+      const String &string = (*iter).key;
+      U32 count = (*iter).value;
+      total += count;
+      rawBits += U64(count) * (getMin(string.length(), U32(255)) + 1) * 8;
+
+      BitStream stream(buffer, sizeof(buffer));
+      stream.writeString(string);
+      huffBits += U64(count) * stream.getCurPos();
+
+      if(dict)
+      {
+         stream.setBuffer(buffer, sizeof(buffer));
+         stream.setStringCoder(dict);
+         stream.writeString(string);
+         dictBits += U64(count) * stream.getCurPos();
+      }
+   }
+
+   if(!rawBits)
+   {
+      Con::printf("No strings captured.");
+      SAFE_DELETE(dict);
+      return;
+   }
+
+   Con::printf("%d strings, %d distinct", U32(total), strings.size());
+   Con::printf("  Plain:    %d bytes", U32(rawBits / 8));
+   Con::printf("  Huffman:  %d bytes (%.1f%%)", U32(huffBits / 8), 100.0 * F64(huffBits) / F64(rawBits));
+   if(dict)
+      Con::printf("  %d words: %d bytes (%.1f%%)", dict->getNumWords(), U32(dictBits / 8), 100.0 * F64(dictBits) / F64(rawBits));
+
+   delete dict;
+}
@@ -0,0 +1,148 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _STRINGCODER_H_
+#define _STRINGCODER_H_
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+#ifndef _TORQUE_STRING_H_
+#include "core/util/str.h"
+#endif
+#ifndef _TDICTIONARY_H_
+#include "core/util/tDictionary.h"
+#endif
+
+class BitStream;
+class Stream;
+
+/// Codes the strings written with BitStream::writeString().
+///
+/// By default, BitStream codes strings with a fixed Huffman table.  A
+/// different coder can be set on a stream with BitStream::setStringCoder().
+/// Both ends of a stream must use the same coder.  Coders must be safe to
+/// use from several threads at once.
+class StringCoder
+{
+public:
+   virtual ~StringCoder() {}
+
+   /// Write at most maxLen characters of string.
+   virtual void writeString(BitStream *stream, const char *string, S32 maxLen) const = 0;
+
+   /// Read a string written by writeString().
+   virtual void readString(BitStream *stream, char buf[256]) const = 0;
+
+   /// @name Capture
+   ///
+   /// While capturing, every string read by BitStream::readString() is
+   /// counted.  Used to train a StringDictionary and to measure how well
+   /// the coders do, for instance on the strings in a recorded demo.
+   /// @{
+
+   /// Start capturing, clearing what was captured before.
+   static void startCapture();
+
+   /// Stop capturing.  What was captured is kept.
+   static void stopCapture();
+
+   static bool isCapturing() { return smCapturing; }
+   static void captureString(const char *string);
+
+   /// The strings captured and how many times each was seen.
+   static const Map<String, U32> &getCapturedStrings() { return smCaptured; }
+
+   /// @}
+
+protected:
+   static bool smCapturing;
+   static Map<String, U32> smCaptured;
+};
+
+/// A StringCoder trained on the strings a game actually sends.
+///
+/// The dictionary holds up to MaxWords words, built by repeatedly joining the
+/// pair of symbols that occurs most often in the training strings.  Strings
+/// are coded as a mix of bytes and words, picked to give the fewest bits,
+/// with a Huffman code built from how often each symbol was used in
+/// training.  Datablock names, file paths and command names that show up
+/// over and over end up costing a few bits each.
+class StringDictionary : public StringCoder
+{
+public:
+   enum Constants
+   {
+      MaxWords = 256,
+      MaxSymbols = 256 + MaxWords,
+      MaxWordLength = 32,
+      MaxCodeBits = 24,
+   };
+
+   StringDictionary();
+
+   /// Train a dictionary with at most maxWords words on the given strings.
+   static StringDictionary *train(const Map<String, U32> &strings, U32 maxWords = MaxWords);
+
+   /// Load a dictionary saved with write().  Returns NULL on failure.
+   static StringDictionary *load(const char *fileName);
+
+   bool read(Stream &stream);
+   bool write(Stream &stream) const;
+
+   /// CRC of the words and frequencies.  Two dictionaries with the same
+   /// CRC code strings the same way.
+   U32 getCRC() const { return mCRC; }
+
+   U32 getNumWords() const { return mWords.size(); }
+
+   // StringCoder.
+   void writeString(BitStream *stream, const char *string, S32 maxLen) const;
+   void readString(BitStream *stream, char buf[256]) const;
+
+protected:
+   struct Node
+   {
+      S16 child[2];     ///< Node index, or -(symbol + 1) for a leaf.
+   };
+
+   Vector<String> mWords;
+   Vector<U32> mFreqs;        ///< Weight of each symbol, bytes first.
+
+   U32 mCodes[MaxSymbols];
+   U8 mCodeBits[MaxSymbols];
+   Vector<Node> mNodes;
+
+   /// Words indexed by their first byte.
+   Vector<U16> mWordsByFirst[256];
+
+   U32 mCRC;
+
+   /// Build the codes and lookup tables from mWords and mFreqs.
+   void build();
+
+   /// Split string into the symbols that code it in the fewest bits.
+   /// Returns the number of symbols.
+   U32 parse(const char *string, U32 len, U16 symbols[256]) const;
+};
+
+#endif // _STRINGCODER_H_
@@ -22,9 +22,18 @@
 
 #include "core/strings/stringFunctions.h"
 #include "core/stringTable.h"
+#include "platform/platformIntrinsics.h"
+#include "platform/threads/mutex.h"
+
+// Probe sixteen slots at a time with SSE2 where the compiler targets it,
+// otherwise eight at a time packed into a U64.
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#  define TORQUE_STRINGTABLE_SSE2
+#  include <emmintrin.h>
+#endif
 
 _StringTable *_gStringTable = NULL;
-const U32 _StringTable::csm_stInitSize = 29;
+const U32 _StringTable::csm_stInitSize = 4096;
 
 //---------------------------------------------------------------
 //
@@ -38,14 +47,111 @@ U8   sgHashTable[256];
 
 void initTolowerTable()
 {
-   for (U32 i = 0; i < 256; i++) {
-      U8 c = dTolower(i);
-      sgHashTable[i] = c * c;
-   }
+   for (U32 i = 0; i < 256; i++)
+      sgHashTable[i] = dTolower(i);
 
    sgInitTable = false;
 }
 
+enum
+{
+   EmptySlot = 0x80,
+
+#ifdef TORQUE_STRINGTABLE_SSE2
+   GroupSize = 16,
+#else
+   GroupSize = 8,
+#endif
+};
+
+inline U32 getSlotTag(U32 hash)
+{
+   return hash >> 25;
+}
+
+/// Spread the bits of a running FNV-1a hash over the whole word, as the low
+/// bits pick the group and the high bits make the tag.
+inline U32 finishHash(U32 hash)
+{
+   hash ^= hash >> 16;
+   hash *= 0x85EBCA6B;
+   hash ^= hash >> 13;
+   hash *= 0xC2B2AE35;
+   hash ^= hash >> 16;
+   return hash;
+}
+
+inline U32 getLowestBit(U32 mask)
+{
+#if defined( TORQUE_COMPILER_GCC )
+   return __builtin_ctz(mask);
+#else
+   U32 index = 0;
+   while (!(mask & 1))
+   {
+      mask >>= 1;
+      index++;
+   }
+   return index;
+#endif
+}
+
+#ifdef TORQUE_STRINGTABLE_SSE2
+
+/// Return a bit per slot in the group whose control byte equals tag.
+inline U32 matchGroup(const U8* control, U32 tag)
+{
+   __m128i group = _mm_loadu_si128((const __m128i*) control);
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) tag)));
+}
+
+/// Return a bit per empty slot in the group.
+inline U32 matchEmpty(const U8* control)
+{
+   return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) control));
+}
+
+#else
+
+/// Gather the high bit of each byte into the low eight bits.
+inline U32 packHighBits(U64 bits)
+{
+   return U32(((bits >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+inline U64 loadGroup(const U8* control)
+{
+   U64 group;
+   dMemcpy(&group, control, sizeof(group));
+   return group;
+}
+
+/// Return a bit per slot in the group whose control byte equals tag.  May
+/// report a few false positives, which the caller filters out anyway.
+inline U32 matchGroup(const U8* control, U32 tag)
+{
+   const U64 lsb = 0x0101010101010101ULL;
+   U64 x = loadGroup(control) ^ (lsb * tag);
+   return packHighBits((x - lsb) & ~x & (lsb << 7));
+}
+
+/// Return a bit per empty slot in the group.
+inline U32 matchEmpty(const U8* control)
+{
+   return packHighBits(loadGroup(control) & 0x8080808080808080ULL);
+}
+
+#endif
+
+/// Length of string, up to len.
+inline U32 getBoundedLength(const char* string, S32 len)
+{
+   U32 length = 0;
+   while (S32(length) < len && string[length])
+      length++;
+   return length;
+}
+
 } // namespace {}
 
 U32 _StringTable::hashString(const char* str)
@@ -55,13 +161,13 @@ U32 _StringTable::hashString(const char* str)
 
    if(!str) return -1;
 
-   U32 ret = 0;
-   char c;
+   U32 ret = 2166136261U;
+   U8 c;
    while((c = *str++) != 0) {
-      ret <<= 1;
-      ret ^= sgHashTable[static_cast<U32>(c)];
+      ret ^= sgHashTable[c];
+      ret *= 16777619U;
    }
-   return ret;
+   return finishHash(ret);
 }
 
 U32 _StringTable::hashStringn(const char* str, S32 len)
@@ -69,31 +175,108 @@ U32 _StringTable::hashStringn(const char* str, S32 len)
    if (sgInitTable)
       initTolowerTable();
 
-   U32 ret = 0;
-   char c;
+   U32 ret = 2166136261U;
+   U8 c;
    while((c = *str++) != 0 && len--) {
-      ret <<= 1;
-      ret ^= sgHashTable[static_cast<U32>(c)];
+      ret ^= sgHashTable[c];
+      ret *= 16777619U;
    }
-   return ret;
+   return finishHash(ret);
 }
 
 //--------------------------------------
-_StringTable::_StringTable()
+_StringTable::Table* _StringTable::createTable(const U32 size)
+{
+   AssertFatal(isPow2(size) && size >= GroupSize, "_StringTable::createTable - bad table size");
+
+   // Pad the control bytes so slots stay pointer aligned.
+   const U32 controlSize = (size + 15) & ~15;
+   U8* block = (U8*) dMalloc(sizeof(Table) + controlSize + size * sizeof(Node*));
+
+   Table* table = (Table*) block;
+   table->size = size;
+   table->groupMask = size / GroupSize - 1;
+   table->retired = NULL;
+   table->control = block + sizeof(Table);
+   table->slots = (Node* volatile*) (table->control + controlSize);
+
+   dMemset(table->control, EmptySlot, size);
+   dMemset((void*) table->slots, 0, size * sizeof(Node*));
+
+   return table;
+}
+
+//--------------------------------------
+U32 _StringTable::findEmptySlot(const Table* table, const U32 hash)
+{
+   // Groups are probed with a triangular step, which visits every group
+   // when the group count is a power of two.
+   U32 group = hash & table->groupMask;
+   for(U32 step = 1;; step++)
+   {
+      const U32 base = group * GroupSize;
+      const U32 empty = matchEmpty(&table->control[base]);
+      if(empty)
+         return base + getLowestBit(empty);
+      group = (group + step) & table->groupMask;
+   }
+}
+
+//--------------------------------------
+_StringTable::Node* _StringTable::find(const Table* table, const char* val, const U32 len, const U32 hash, const bool caseSens)
 {
-   buckets = (Node **) dMalloc(csm_stInitSize * sizeof(Node *));
-   for(U32 i = 0; i < csm_stInitSize; i++) {
-      buckets[i] = 0;
+   const U32 tag = getSlotTag(hash);
+   U32 group = hash & table->groupMask;
+   for(U32 step = 1;; step++)
+   {
+      const U8* control = &table->control[group * GroupSize];
+      U32 match = matchGroup(control, tag);
+      while(match)
+      {
+         const U32 slot = group * GroupSize + getLowestBit(match);
+         match &= match - 1;
+
+         // A writer may have set the control byte ahead of the slot
+         // becoming visible here; that string isn't in the table yet.
+         Node* node = table->slots[slot];
+         if(!node || node->hash != hash || node->length != len)
+            continue;
+
+         if(caseSens ? !dStrncmp(node->val, val, len) : !dStrnicmp(node->val, val, len))
+            return node;
+      }
+
+      // Strings are added at the first empty slot along the probe
+      // sequence, so an empty slot means there is nothing further on.
+      if(matchEmpty(control))
+         return NULL;
+
+      group = (group + step) & table->groupMask;
    }
+}
 
-   numBuckets = csm_stInitSize;
+//--------------------------------------
+_StringTable::_StringTable()
+{
+   mTable = createTable(csm_stInitSize);
+   firstNode = NULL;
+   lastNode = NULL;
    itemCount = 0;
+   mMutex = Mutex::createMutex();
 }
 
 //--------------------------------------
 _StringTable::~_StringTable()
 {
-   dFree(buckets);
+   Table* table = mTable;
+   while(table)
+   {
+      Table* retired = table->retired;
+      dFree(table);
+      table = retired;
+   }
+
+   Mutex::destroyMutex(mMutex);
 }
 
 
@@ -118,6 +301,45 @@ void _StringTable::destroy()
 }
 
 
+//--------------------------------------
+StringTableEntry _StringTable::insertLocked(const char* val, const U32 len, const U32 hash, const bool caseSens)
+{
+   Mutex::lockMutex(mMutex);
+
+   // Someone else may have added it since we looked.
+   Node* node = find(mTable, val, len, hash, caseSens);
+   if(!node)
+   {
+      // Keep at least one slot in eight free so probes stay short.
+      if((itemCount + 1) * 8 > mTable->size * 7)
+         resize(mTable->size);
+
+      node = (Node*) mempool.alloc(sizeof(Node) + len);
+      node->next = NULL;
+      node->hash = hash;
+      node->length = len;
+      dMemcpy(node->val, val, len);
+      node->val[len] = 0;
+
+      if(lastNode)
+         lastNode->next = node;
+      else
+         firstNode = node;
+      lastNode = node;
+
+      // Publish the node before its control byte; the atomic add is the
+      // barrier between the two stores.
+      Table* table = mTable;
+      const U32 slot = findEmptySlot(table, hash);
+      table->slots[slot] = node;
+      dFetchAndAdd(itemCount, 1);
+      table->control[slot] = getSlotTag(hash);
+   }
+
+   Mutex::unlockMutex(mMutex);
+   return node->val;
+}
+
 //--------------------------------------
 StringTableEntry _StringTable::insert(const char* _val, const bool caseSens)
 {
@@ -127,107 +349,68 @@ StringTableEntry _StringTable::insert(const char* _val, const bool caseSens)
       val = "";
    //-
 
-   Node **walk, *temp;
-   U32 key = hashString(val);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL)   {
-      if(caseSens && !dStrcmp(temp->val, val))
-         return temp->val;
-      else if(!caseSens && !dStricmp(temp->val, val))
-         return temp->val;
-      walk = &(temp->next);
-   }
-   char *ret = 0;
-   if(!*walk) {
-      *walk = (Node *) mempool.alloc(sizeof(Node));
-      (*walk)->next = 0;
-      (*walk)->val = (char *) mempool.alloc(dStrlen(val) + 1);
-      dStrcpy((*walk)->val, val);
-      ret = (*walk)->val;
-      itemCount ++;
-   }
-   if(itemCount > 2 * numBuckets) {
-      resize(4 * numBuckets - 1);
-   }
-   return ret;
+   const U32 len = dStrlen(val);
+   const U32 hash = hashStringn(val, len);
+   if(Node* node = find(mTable, val, len, hash, caseSens))
+      return node->val;
+
+   return insertLocked(val, len, hash, caseSens);
 }
 
 //--------------------------------------
 StringTableEntry _StringTable::insertn(const char* src, S32 len, const bool  caseSens)
 {
-   char val[256];
-   AssertFatal(len < 255, "Invalid string to insertn");
-   dStrncpy(val, src, len);
-   val[len] = 0;
-   return insert(val, caseSens);
+   const U32 length = getBoundedLength(src, len);
+   const U32 hash = hashStringn(src, length);
+   if(Node* node = find(mTable, src, length, hash, caseSens))
+      return node->val;
+
+   return insertLocked(src, length, hash, caseSens);
 }
 
 //--------------------------------------
 StringTableEntry _StringTable::lookup(const char* val, const bool  caseSens)
 {
-   Node **walk, *temp;
-   U32 key = hashString(val);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL)   {
-      if(caseSens && !dStrcmp(temp->val, val))
-            return temp->val;
-      else if(!caseSens && !dStricmp(temp->val, val))
-         return temp->val;
-      walk = &(temp->next);
-   }
-   return NULL;
+   const U32 len = dStrlen(val);
+   Node* node = find(mTable, val, len, hashStringn(val, len), caseSens);
+   return node ? node->val : NULL;
 }
 
 //--------------------------------------
 StringTableEntry _StringTable::lookupn(const char* val, S32 len, const bool  caseSens)
 {
-   Node **walk, *temp;
-   U32 key = hashStringn(val, len);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL) {
-      if(caseSens && !dStrncmp(temp->val, val, len) && temp->val[len] == 0)
-         return temp->val;
-      else if(!caseSens && !dStrnicmp(temp->val, val, len) && temp->val[len] == 0)
-         return temp->val;
-      walk = &(temp->next);
-   }
-   return NULL;
+   const U32 length = getBoundedLength(val, len);
+   Node* node = find(mTable, val, length, hashStringn(val, length), caseSens);
+   return node ? node->val : NULL;
 }
 
 //--------------------------------------
 void _StringTable::resize(const U32 newSize)
 {
-   Node *head = NULL, *walk, *temp;
-   U32 i;
-   // reverse individual bucket lists
-   // we do this because new strings are added at the end of bucket
-   // lists so that case sens strings are always after their
-   // corresponding case insens strings
+   // Called with the lock held from insert, but take it anyway for
+   // outside callers; it is recursive.
+   Mutex::lockMutex(mMutex);
+
+   U32 size = mTable->size;
+   while(size * 7 < newSize * 8 + 8)
+      size *= 2;
 
-   for(i = 0; i < numBuckets; i++) {
-      walk = buckets[i];
-      while(walk)
+   if(size != mTable->size)
+   {
+      // Re-add in insertion order so probe order still matches it.
+      Table* table = createTable(size);
+      for(Node* walk = firstNode; walk; walk = walk->next)
       {
-         temp = walk->next;
-         walk->next = head;
-         head = walk;
-         walk = temp;
+         const U32 slot = findEmptySlot(table, walk->hash);
+         table->slots[slot] = walk;
+         table->control[slot] = getSlotTag(walk->hash);
       }
+
+      // Lookups may still be walking the old table, so it is kept around.
+      table->retired = mTable;
+      Table* oldTable = mTable;
+      dCompareAndSwap(mTable, oldTable, table);
    }
-   buckets = (Node **) dRealloc(buckets, newSize * sizeof(Node));
-   for(i = 0; i < newSize; i++) {
-      buckets[i] = 0;
-   }
-   numBuckets = newSize;
-   walk = head;
-   while(walk) {
-      U32 key;
-      Node *temp = walk;
-
-      walk = walk->next;
-      key = hashString(temp->val);
-      temp->next = buckets[key % newSize];
-      buckets[key % newSize] = temp;
-   }
-}
 
+   Mutex::unlockMutex(mMutex);
+}
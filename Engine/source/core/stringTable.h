@@ -70,6 +70,9 @@
 ///  The scripting engine and the resource manager are the primary users of the
 ///  StringTable.
 ///
+/// Strings already in the table are found without taking a lock, so insert() and
+/// lookup() are cheap to call from any thread; only adding a new string locks.
+///
 /// @note Be aware that the StringTable NEVER DEALLOCATES memory, so be careful when you
 ///       add strings to it. If you carelessly add many strings, you will end up wasting
 ///       space.
@@ -79,20 +82,51 @@ private:
    /// @name Implementation details
    /// @{
 
-   /// This is internal to the _StringTable class.
+   /// This is internal to the _StringTable class.  Each string is stored
+   /// inline after its node, so a StringTableEntry points into the node and
+   /// never moves.
    struct Node
    {
-      char *val;
-      Node *next;
+      Node *next;       ///< Next node in insertion order.
+      U32   hash;
+      U32   length;
+      char  val[1];
+   };
+
+   /// Open addressed index over the nodes.
+   ///
+   /// Slots are probed in groups; each slot has a control byte holding
+   /// either EmptySlot or seven bits of the string's hash, so a whole group
+   /// can be matched against a hash at once without touching the nodes.
+   /// Slots are never removed, and a slot's node is written before its
+   /// control byte, which lets lookups run without taking the lock.
+   struct Table
+   {
+      U32   size;       ///< Number of slots, a power of two.
+      U32   groupMask;
+      Table *retired;   ///< Table this one replaced.  Kept alive for readers.
+      U8    *control;
+      Node * volatile *slots;
    };
 
-   Node**      buckets;
-   U32         numBuckets;
-   U32         itemCount;
+   Table * volatile mTable;
+   Node*       firstNode;
+   Node*       lastNode;
+   volatile U32 itemCount;
+   void*       mMutex;
    DataChunker mempool;
 
    StringTableEntry _EmptyString;
 
+   static Table* createTable(const U32 size);
+   static U32    findEmptySlot(const Table* table, const U32 hash);
+
+   /// Find the first node matching the given string in probe order, which is
+   /// also insertion order.
+   static Node*  find(const Table* table, const char* string, const U32 len, const U32 hash, const bool caseSens);
+
+   StringTableEntry insertLocked(const char* string, const U32 len, const U32 hash, const bool caseSens);
+
   protected:
    static const U32 csm_stInitSize;
 
@@ -34,6 +34,7 @@
 #define PROCESS_INPUT_ORDER 0.4f
 #define PROCESS_DEFAULT_ORDER 0.5f
 #define PROCESS_TIME_ORDER 0.75f
+#define PROCESS_NET_FLUSH_ORDER 0.78f   ///< After the simulation has run, before rendering.
 #define PROCESS_RENDER_ORDER 0.8f
 #define PROCESS_LAST_ORDER 1.0f
 
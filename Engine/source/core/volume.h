@@ -180,6 +180,17 @@ public:
 
    virtual U32 read(void* dst, U32 size) = 0;
    virtual U32 write(const void* src, U32 size) = 0;
+
+   /// Map the first size bytes of the open file into memory.
+   ///
+   /// If the file was opened ReadWrite, the memory can be written to and
+   /// the file is resized to size bytes first.  Returns NULL if this file
+   /// system can't map files, in which case read() and write() must be
+   /// used instead.
+   virtual void* map(U32 size) { return NULL; }
+
+   /// Release memory returned by map().
+   virtual void unmap(void* ptr, U32 size) {}
 };
 
 typedef WeakRefPtr<File> FilePtr;
@@ -1090,6 +1090,35 @@ void Interior::buildExportPolyList(OptimizedPolyList& polys, MatrixF* mat, Point
    polys.setTransform(&saveMat, saveScale);
 }
 
+void Interior::buildOcclusionMesh(Vector<Point3F>& outTriangles) const
+{
+   if (!mMaterialList)
+      return;
+
+   for (U32 i = 0; i < mSurfaces.size(); i++)
+   {
+      const Interior::Surface& surface = mSurfaces[i];
+
+      // Only surfaces that can't be seen through hide what is behind them.
+      BaseMatInstance *matInst = mMaterialList->getMaterialInst( surface.textureIndex );
+      if (!matInst)
+         continue;
+
+      Material* pMat = dynamic_cast<Material*>(matInst->getMaterial());
+      if (!pMat || pMat->isTranslucent() || pMat->mAlphaTest)
+         continue;
+
+      // Surfaces are stored as triangle strips.
+      const U32* strip = &mWindings[surface.windingStart];
+      for (U32 k = 2; k < surface.windingCount; k++)
+      {
+         outTriangles.push_back(mPoints[strip[k - 2]].point);
+         outTriangles.push_back(mPoints[strip[k - 1]].point);
+         outTriangles.push_back(mPoints[strip[k]].point);
+      }
+   }
+}
+
 
 struct TempProcSurface
 {
@@ -925,6 +925,12 @@ private:
    void purgeLODData();
 
    void buildExportPolyList(OptimizedPolyList& polys, MatrixF* mat = NULL, Point3F* scale = NULL);
+
+   /// Append the object space triangles of all surfaces with opaque materials
+   /// to @a outTriangles, three points per triangle.  Surfaces with translucent
+   /// or alpha-tested materials are left out.
+   /// @note The material instances must have been set up by prepForRendering().
+   void buildOcclusionMesh(Vector<Point3F>& outTriangles) const;
 };
 
 //------------------------------------------------------------------------------
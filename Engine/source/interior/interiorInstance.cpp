@@ -344,6 +344,10 @@ bool InteriorInstance::_loadInterior()
 
       // copy planar reflect list from top detail level - for now
       Interior* pInterior = mInteriorRes->getDetailLevel(0);
+
+      // Keep the opaque surfaces of the top detail level for occlusion culling.
+      mOcclusionMesh.clear();
+      pInterior->buildOcclusionMesh( mOcclusionMesh );
       if( pInterior->mReflectPlanes.size() )
       {
          for ( i = 0; i < pInterior->mReflectPlanes.size(); i++ )
@@ -426,6 +430,8 @@ void InteriorInstance::_unloadInterior()
          }         
          mPlaneReflectors.clear();
       }
+
+      mOcclusionMesh.clear();
    }
 }
 
@@ -825,6 +831,29 @@ void InteriorInstance::prepRenderImage( SceneRenderState* state )
 
 //-----------------------------------------------------------------------------
 
+void InteriorInstance::buildOcclusionMesh( Vector< Point3F >& outTriangles )
+{
+   const U32 numPoints = mOcclusionMesh.size();
+   if( !numPoints )
+      return;
+
+   const MatrixF& transform = getRenderTransform();
+   const Point3F& scale = getScale();
+
+   const U32 first = outTriangles.size();
+   outTriangles.setSize( first + numPoints );
+
+   for( U32 i = 0; i < numPoints; ++ i )
+   {
+      Point3F& point = outTriangles[ first + i ];
+      point = mOcclusionMesh[ i ];
+      point.convolve( scale );
+      transform.mulP( point );
+   }
+}
+
+//-----------------------------------------------------------------------------
+
 bool InteriorInstance::castRay(const Point3F& s, const Point3F& e, RayInfo* info)
 {
    info->object = this;
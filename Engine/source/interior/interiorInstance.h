@@ -139,6 +139,11 @@ class InteriorInstance : public SceneZoneSpace
       Vector< PlaneReflector > mPlaneReflectors;
       ReflectorDesc mReflectorDesc;
 
+      /// Object space triangles of the opaque surfaces of the highest detail
+      /// level.  Only built on the client.
+      /// @see buildOcclusionMesh
+      Vector< Point3F > mOcclusionMesh;
+
       U32 _calcDetailLevel( SceneRenderState* state, const Point3F& wsPoint );
       bool _loadInterior();
       void _unloadInterior();
@@ -236,6 +241,7 @@ class InteriorInstance : public SceneZoneSpace
       virtual bool castRay(const Point3F &start, const Point3F &end, RayInfo *info);
       virtual void buildConvex(const Box3F& box,Convex* convex);
       virtual void prepRenderImage( SceneRenderState *state );
+      virtual void buildOcclusionMesh( Vector< Point3F >& outTriangles );
 
       // SceneZoneSpace.
       virtual void traverseZones( SceneTraversalState* state );
@@ -29,6 +29,17 @@
 #include "platform/profiler.h"
 #include "platform/threads/mutex.h"
 #include "core/module.h"
+#include "platform/platformIntrinsics.h"
+#include "math/mMathFn.h"
+
+// When the memory manager is enabled (the shipped torqueConfig.h files define
+// TORQUE_DISABLE_MEMORY_MANAGER, so it is opt-in), small blocks come from a
+// size class allocator with per-thread caches unless TORQUE_DEBUG_GUARD is on, as guard checks and leak tracking need every block
+// to live in the tree allocator's pages.  Define TORQUE_MEMORY_TREE_ALLOCATOR
+// to use the tree allocator for everything.
+#if !defined(TORQUE_DISABLE_MEMORY_MANAGER) && !defined(TORQUE_DEBUG_GUARD) && !defined(TORQUE_MEMORY_TREE_ALLOCATOR)
+#  define TORQUE_MEMORY_SIZE_CLASSES
+#endif
 
 // If profile paths are enabled, disable profiling of the
 // memory manager as that would cause a cyclic dependency
@@ -1263,6 +1274,408 @@ static void checkUnusedAlloc(FreeHeader *header, U32 size)
 }
 #endif
 
+#ifdef TORQUE_MEMORY_SIZE_CLASSES
+
+//---------------------------------------------------------------------------
+// Size class allocator.
+//
+// Blocks up to MaxSizeClassSize are rounded up to one of NumSizeClasses sizes
+// and served from per-thread free lists.  A thread's list refills from, and
+// drains back to, a central free list for the class in batches, so only the
+// central lists need a lock and threads mostly don't see each other at all.
+// Larger blocks still go through the tree allocator.
+//
+// Each block keeps an AllocatedHeader so free() can tell the two apart and
+// getMemoryInfo() keeps working; the header's flags hold SizeClassFlag and
+// the block's class index.
+
+enum SizeClassConstants
+{
+   SizeClassFlag        = BIT(6),
+   SizeClassShift       = 24,
+   NumSizeClasses       = 32,
+   MaxSizeClassSize     = 8192,
+   SizeClassSpanSize    = 64 * 1024,
+   SizeClassBatchBytes  = 16 * 1024,
+   MaxSizeClassBatch    = 32,
+};
+
+struct SizeClassBlock
+{
+   SizeClassBlock* next;
+};
+
+/// Shared state for one size class.  Guarded by lock.
+struct SizeClassCentral
+{
+   volatile U32 lock;
+   SizeClassBlock* freeList;
+   U32 freeCount;
+
+   /// Next block to carve out of the current span.
+   U8* spanCursor;
+   U32 spanBlocksLeft;
+
+   U32 numSpans;
+   U32 numBlocks;
+
+   /// Alloc/free counts of blocks handled without a thread cache.
+   U32 numAllocs;
+   U32 numFrees;
+};
+
+/// A thread's private free lists.
+struct SizeClassThreadCache
+{
+   struct Bin
+   {
+      SizeClassBlock* freeList;
+      U32 freeCount;
+      U32 numAllocs;
+      U32 numFrees;
+   };
+
+   Bin bins[NumSizeClasses];
+   SizeClassThreadCache* next;
+};
+
+// All of this is zero-initialized, so it is usable by allocations made
+// during static construction.
+static SizeClassCentral gSizeClasses[NumSizeClasses];
+static SizeClassThreadCache* gThreadCacheList;
+static volatile U32 gThreadCacheListLock;
+static TORQUE_THREAD_LOCAL SizeClassThreadCache* gThreadCache;
+
+static void acquireSpinLock(volatile U32& lock)
+{
+   for(U32 spins = 0; !dTestAndSet(lock); spins++)
+      if(spins >= 64)
+         Platform::sleep(0);
+}
+
+static void releaseSpinLock(volatile U32& lock)
+{
+   dCompareAndSwap(lock, 1, 0);
+}
+
+/// Sizes go up in steps of 16 to 128 bytes, then in four steps per power of two.
+static inline U32 getSizeClass(dsize_t size)
+{
+   AssertFatal(size > 0 && size <= MaxSizeClassSize, "Memory::getSizeClass - size out of range");
+
+   const U32 last = U32(size) - 1;
+   if(last < 128)
+      return last >> 4;
+
+   const U32 log2 = getBinLog2(last);
+   return 8 + (log2 - 7) * 4 + (last >> (log2 - 2)) - 4;
+}
+
+static inline U32 getSizeClassSize(U32 sizeClass)
+{
+   if(sizeClass < 8)
+      return (sizeClass + 1) * 16;
+
+   const U32 log2 = 7 + (sizeClass - 8) / 4;
+   return (1 << log2) + ((sizeClass - 8) % 4 + 1) * (1 << (log2 - 2));
+}
+
+/// Number of blocks moved between a thread cache and the central list at once.
+static inline U32 getSizeClassBatch(U32 sizeClass)
+{
+   return mClamp(SizeClassBatchBytes / getSizeClassSize(sizeClass), 2, MaxSizeClassBatch);
+}
+
+/// Take up to count blocks off the central list, carving new ones as needed.
+/// Returns the number of blocks put on @a list.
+static U32 takeCentralBlocks(U32 sizeClass, U32 count, SizeClassBlock*& list)
+{
+   SizeClassCentral& central = gSizeClasses[sizeClass];
+   const U32 stride = sizeof(AllocatedHeader) + getSizeClassSize(sizeClass);
+
+   acquireSpinLock(central.lock);
+
+   U32 taken = 0;
+   while(taken < count && central.freeList)
+   {
+      SizeClassBlock* block = central.freeList;
+      central.freeList = block->next;
+      block->next = list;
+      list = block;
+      taken++;
+   }
+   central.freeCount -= taken;
+
+   while(taken < count)
+   {
+      if(!central.spanBlocksLeft)
+      {
+         U8* span = (U8*) dRealMalloc(SizeClassSpanSize + 15);
+         if(!span)
+         {
+            releaseSpinLock(central.lock);
+            memoryError();
+            return taken;
+         }
+
+         central.spanCursor = span + ((16 - (size_t(span) & 15)) & 15);
+         central.spanBlocksLeft = SizeClassSpanSize / stride;
+         central.numSpans++;
+      }
+
+      AllocatedHeader* header = (AllocatedHeader*) central.spanCursor;
+      central.spanCursor += stride;
+      central.spanBlocksLeft--;
+      central.numBlocks++;
+
+      header->next = NULL;
+      header->prev = NULL;
+      header->size = getSizeClassSize(sizeClass);
+      header->flags = SizeClassFlag | (sizeClass << SizeClassShift);
+
+      SizeClassBlock* block = (SizeClassBlock*) header->getUserPtr();
+      block->next = list;
+      list = block;
+      taken++;
+   }
+
+   releaseSpinLock(central.lock);
+   return taken;
+}
+
+/// Put a list of count blocks back on the central list.
+static void giveCentralBlocks(U32 sizeClass, SizeClassBlock* first, SizeClassBlock* last, U32 count)
+{
+   SizeClassCentral& central = gSizeClasses[sizeClass];
+
+   acquireSpinLock(central.lock);
+   last->next = central.freeList;
+   central.freeList = first;
+   central.freeCount += count;
+   releaseSpinLock(central.lock);
+}
+
+static SizeClassThreadCache* createThreadCache()
+{
+   SizeClassThreadCache* cache = (SizeClassThreadCache*) dRealMalloc(sizeof(SizeClassThreadCache));
+   if(!cache)
+      memoryError();
+   dMemset(cache, 0, sizeof(SizeClassThreadCache));
+
+   acquireSpinLock(gThreadCacheListLock);
+   cache->next = gThreadCacheList;
+   gThreadCacheList = cache;
+   releaseSpinLock(gThreadCacheListLock);
+
+   gThreadCache = cache;
+   return cache;
+}
+
+static void* allocSizeClass(dsize_t size, bool array)
+{
+   const U32 sizeClass = getSizeClass(size);
+
+   SizeClassThreadCache* cache = gThreadCache;
+   if(!cache)
+      cache = createThreadCache();
+
+   SizeClassThreadCache::Bin& bin = cache->bins[sizeClass];
+   if(!bin.freeList)
+      bin.freeCount += takeCentralBlocks(sizeClass, getSizeClassBatch(sizeClass), bin.freeList);
+
+   SizeClassBlock* block = bin.freeList;
+   bin.freeList = block->next;
+   bin.freeCount--;
+   bin.numAllocs++;
+
+   AllocatedHeader* header = ((AllocatedHeader*) block) - 1;
+   AssertFatal(!(header->flags & Allocated), "Memory::allocSizeClass - block on free list is allocated");
+   header->flags = Allocated | SizeClassFlag | (array ? Array : 0) | (sizeClass << SizeClassShift);
+
+#ifdef TORQUE_DEBUG
+   dMemset(block, 0xCF, header->size);
+#endif
+
+   return block;
+}
+
+static void freeSizeClass(void* mem, bool array)
+{
+   AllocatedHeader* header = ((AllocatedHeader*) mem) - 1;
+   AssertFatal(header->flags & Allocated, avar("Not an allocated block!"));
+   AssertFatal(((bool)((header->flags & Array)==Array))==array, avar("Array alloc mismatch. "));
+
+   const U32 sizeClass = header->flags >> SizeClassShift;
+   header->flags = SizeClassFlag | (sizeClass << SizeClassShift);
+
+#ifdef TORQUE_DEBUG
+   dMemset(mem, 0xCE, header->size);
+#endif
+
+   SizeClassBlock* block = (SizeClassBlock*) mem;
+   SizeClassThreadCache* cache = gThreadCache;
+   if(!cache)
+   {
+      // Freed on a thread that has already let go of its cache (e.g. while
+      // the thread object itself is being deleted).
+      block->next = NULL;
+      giveCentralBlocks(sizeClass, block, block, 1);
+      dFetchAndAdd(gSizeClasses[sizeClass].numFrees, 1);
+      return;
+   }
+
+   SizeClassThreadCache::Bin& bin = cache->bins[sizeClass];
+   block->next = bin.freeList;
+   bin.freeList = block;
+   bin.freeCount++;
+   bin.numFrees++;
+
+   // Hand a batch back once the thread is holding on to two.
+   const U32 batch = getSizeClassBatch(sizeClass);
+   if(bin.freeCount > batch * 2)
+   {
+      SizeClassBlock* first = bin.freeList;
+      SizeClassBlock* last = first;
+      for(U32 i = 1; i < batch; i++)
+         last = last->next;
+
+      bin.freeList = last->next;
+      bin.freeCount -= batch;
+      giveCentralBlocks(sizeClass, first, last, batch);
+   }
+}
+
+static void* alloc(dsize_t size, bool array, const char* fileName, const U32 line);
+static void free(void* mem, bool array);
+
+static void* reallocSizeClass(void* mem, dsize_t size, const char* fileName, const U32 line)
+{
+   AllocatedHeader* header = ((AllocatedHeader*) mem) - 1;
+   AssertFatal((header->flags & Allocated) == Allocated, "Bad block flags.");
+
+   // Stay put as long as the new size still maps to this class.
+   const U32 sizeClass = header->flags >> SizeClassShift;
+   if(size <= MaxSizeClassSize && getSizeClass(size) == sizeClass)
+      return mem;
+
+   void* ret = alloc(size, false, fileName, line);
+   dMemcpy(ret, mem, getMin(U32(size), U32(header->size)));
+   free(mem, false);
+   return ret;
+}
+
+static dsize_t getSizeClassMemoryUsed()
+{
+   U32 freeCount[NumSizeClasses];
+   for(U32 i = 0; i < NumSizeClasses; i++)
+      freeCount[i] = gSizeClasses[i].freeCount;
+
+   acquireSpinLock(gThreadCacheListLock);
+   for(SizeClassThreadCache* walk = gThreadCacheList; walk; walk = walk->next)
+      for(U32 i = 0; i < NumSizeClasses; i++)
+         freeCount[i] += walk->bins[i].freeCount;
+   releaseSpinLock(gThreadCacheListLock);
+
+   dsize_t size = 0;
+   for(U32 i = 0; i < NumSizeClasses; i++)
+      size += (gSizeClasses[i].numBlocks - freeCount[i]) * getSizeClassSize(i);
+
+   return size;
+}
+
+DefineEngineFunction( dumpMemorySizeClasses, void, (),,
+   "@brief Print usage statistics for each size class of the small block allocator.\n\n"
+   "Counts are sampled while other threads may be allocating, so they are approximate.\n"
+   "@note Only available when the memory manager is enabled and TORQUE_DEBUG_GUARD is off. "
+   "In torqueConfig.h, TORQUE_DISABLE_MEMORY_MANAGER must be undefined to use this function.\n\n"
+   "@ingroup Debugging")
+{
+   SizeClassThreadCache::Bin totals[NumSizeClasses];
+   dMemset(totals, 0, sizeof(totals));
+   U32 numThreads = 0;
+
+   acquireSpinLock(gThreadCacheListLock);
+   for(SizeClassThreadCache* walk = gThreadCacheList; walk; walk = walk->next)
+   {
+      for(U32 i = 0; i < NumSizeClasses; i++)
+      {
+         totals[i].freeCount += walk->bins[i].freeCount;
+         totals[i].numAllocs += walk->bins[i].numAllocs;
+         totals[i].numFrees += walk->bins[i].numFrees;
+      }
+      numThreads++;
+   }
+   releaseSpinLock(gThreadCacheListLock);
+
+   Con::printf("Size classes (%d thread caches):", numThreads);
+   Con::printf("   Size  Spans  Reserved     In Use   Cached  Central     Allocs      Frees");
+
+   U32 totalReserved = 0;
+   U32 totalUsed = 0;
+   for(U32 i = 0; i < NumSizeClasses; i++)
+   {
+      const SizeClassCentral& central = gSizeClasses[i];
+      const U32 size = getSizeClassSize(i);
+      const U32 inUse = central.numBlocks - central.freeCount - totals[i].freeCount;
+
+      Con::printf("%7d %6d %8dK %10d %8d %8d %10d %10d",
+                  size,
+                  central.numSpans,
+                  central.numSpans * SizeClassSpanSize / 1024,
+                  inUse,
+                  totals[i].freeCount,
+                  central.freeCount,
+                  totals[i].numAllocs + central.numAllocs,
+                  totals[i].numFrees + central.numFrees);
+
+      totalReserved += central.numSpans * SizeClassSpanSize;
+      totalUsed += inUse * size;
+   }
+
+   Con::printf("Total: %dK reserved, %dK in use", totalReserved / 1024, totalUsed / 1024);
+}
+
+#endif // TORQUE_MEMORY_SIZE_CLASSES
+
+void flushThreadCache()
+{
+#ifdef TORQUE_MEMORY_SIZE_CLASSES
+   SizeClassThreadCache* cache = gThreadCache;
+   if(!cache)
+      return;
+
+   gThreadCache = NULL;
+
+   acquireSpinLock(gThreadCacheListLock);
+   for(SizeClassThreadCache** walk = &gThreadCacheList; *walk; walk = &(*walk)->next)
+   {
+      if(*walk == cache)
+      {
+         *walk = cache->next;
+         break;
+      }
+   }
+   releaseSpinLock(gThreadCacheListLock);
+
+   for(U32 i = 0; i < NumSizeClasses; i++)
+   {
+      SizeClassThreadCache::Bin& bin = cache->bins[i];
+      dFetchAndAdd(gSizeClasses[i].numAllocs, bin.numAllocs);
+      dFetchAndAdd(gSizeClasses[i].numFrees, bin.numFrees);
+
+      if(!bin.freeList)
+         continue;
+
+      SizeClassBlock* last = bin.freeList;
+      while(last->next)
+         last = last->next;
+      giveCentralBlocks(i, bin.freeList, last, bin.freeCount);
+   }
+
+   dRealFree(cache);
+#endif
+}
+
 #if defined(TORQUE_MULTITHREAD) && !defined(TORQUE_DISABLE_MEMORY_MANAGER)
 static bool gReentrantGuard = false;
 #endif
@@ -1272,6 +1685,11 @@ static void* alloc(dsize_t size, bool array, const char* fileName, const U32 lin
 {
    AssertFatal(size < MaxAllocationAmount, "Memory::alloc - tried to allocate > MaxAllocationAmount!");
 
+#ifdef TORQUE_MEMORY_SIZE_CLASSES
+   if(size && size <= MaxSizeClassSize)
+      return allocSizeClass(size, array);
+#endif
+
 #ifdef TORQUE_MULTITHREAD
    if(!gMemMutex && !gReentrantGuard)
    {
@@ -1386,6 +1804,14 @@ static void free(void* mem, bool array)
    if (!mem)
       return;
 
+#ifdef TORQUE_MEMORY_SIZE_CLASSES
+   if((((AllocatedHeader *)mem) - 1)->flags & SizeClassFlag)
+   {
+      freeSizeClass(mem, array);
+      return;
+   }
+#endif
+
 #ifdef TORQUE_MULTITHREAD
    if(!gMemMutex)
       gMemMutex = Mutex::createMutex();
@@ -1472,6 +1898,11 @@ static void* realloc(void* mem, dsize_t size, const char* fileName, const U32 li
    if(!mem)
       return alloc(size, false, fileName, line);
 
+#ifdef TORQUE_MEMORY_SIZE_CLASSES
+   if((((AllocatedHeader *)mem) - 1)->flags & SizeClassFlag)
+      return reallocSizeClass(mem, size, fileName, line);
+#endif
+
 #ifdef TORQUE_MULTITHREAD
    if(!gMemMutex)
       gMemMutex = Mutex::createMutex();
@@ -1584,6 +2015,10 @@ dsize_t getMemoryUsed()
          }
    }
 
+#ifdef TORQUE_MEMORY_SIZE_CLASSES
+   size += getSizeClassMemoryUsed();
+#endif
+
    return size;
 }
 
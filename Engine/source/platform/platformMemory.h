@@ -54,6 +54,10 @@ namespace Memory
    dsize_t     getMemoryAllocated();
    void        getMemoryInfo( void* ptr, Info& info );
    void        validate();
+
+   /// Return the calling thread's cached free blocks to the shared pool.
+   /// Called by the platform layer when a thread exits.
+   void        flushThreadCache();
 }
 
 #endif // _TORQUE_PLATFORM_PLATFORMMEMORY_H_
@@ -77,6 +77,11 @@ typedef in_addr IN_ADDR;
 
 #define closesocket close
 
+// recvmmsg() and sendmmsg() are available.
+#if defined(MSG_WAITFORONE)
+#define TORQUE_NET_BATCHED_IO
+#endif
+
 #else
 
 #endif
@@ -116,6 +121,16 @@ static const char* strerror_wsa( int code )
 #include "console/console.h"
 #include "core/util/journal/process.h"
 #include "core/util/journal/journal.h"
+#include "platform/platformIntrinsics.h"
+#include "platform/threads/thread.h"
+#include "platform/threads/semaphore.h"
+#include "platform/threads/threadSafeSPSCQueue.h"
+
+#if !defined(TORQUE_USE_WINSOCK)
+// The network thread waits on the UDP port and a wake-up pipe with poll().
+#define TORQUE_NET_IO_THREAD
+#include <fcntl.h>
+#endif
 
 static Net::Error getLastError();
 static S32 defaultPort = 28000;
@@ -127,6 +142,267 @@ ConnectionAcceptedEvent Net::smConnectionAccept;
 ConnectionReceiveEvent  Net::smConnectionReceive;
 PacketReceiveEvent      Net::smPacketReceive;
 
+bool           Net::smBatchedIO = true;
+Net::IOStats   Net::smIOStats;
+
+enum
+{
+   RecvBatchSize = 32,  ///< Datagrams read from the UDP port per call.
+   SendQueueSize = 64,  ///< Datagrams queued before a flush is forced.
+};
+
+// Datagrams are read into these and handed out from there, so nothing is
+// allocated per frame.
+static U8 gRecvBuffers[RecvBatchSize][Net::MaxPacketDataSize];
+static sockaddr_in gRecvAddresses[RecvBatchSize];
+
+#if defined(TORQUE_NET_BATCHED_IO)
+static U8 gSendBuffers[SendQueueSize][Net::MaxPacketDataSize];
+static sockaddr_in gSendAddresses[SendQueueSize];
+static S32 gSendSizes[SendQueueSize];
+static U32 gSendQueueCount = 0;
+#endif
+
+bool Net::smIOThread = false;
+
+/// Arrival time of the packet being handed out by dispatchPacket().
+static U32 gPacketReceiveTime = 0;
+static bool gDispatchingPacket = false;
+
+#if defined(TORQUE_NET_IO_THREAD)
+
+/// A datagram on its way between the network thread and the main thread.
+struct NetIOPacket
+{
+   sockaddr_in address;
+   U32 time;      ///< Platform::getRealMilliseconds() on arrival.
+   S32 size;
+   U8 data[Net::MaxPacketDataSize];
+};
+
+/// Thread that owns the UDP port while it runs.
+///
+/// Incoming datagrams are read straight into the slots of mIncoming, and
+/// outgoing ones sent straight from the slots of mOutgoing, so neither side
+/// copies anything more than it would without the thread.
+class NetIOThread : public Thread
+{
+public:
+   typedef Thread Parent;
+
+   enum
+   {
+      QueueSize = 256,     ///< Datagrams buffered in each direction.
+      PollTimeout = 100,   ///< Milliseconds between checks for stop().
+      SendBurstSize = 16,  ///< Datagrams sent between checks for incoming ones.
+   };
+
+   typedef ThreadSafeSPSCQueue<NetIOPacket, QueueSize> PacketQueue;
+
+   /// Filled by the thread; drained by Net::process().
+   PacketQueue mIncoming;
+
+   /// Filled by Net::sendto(); drained by the thread.
+   PacketQueue mOutgoing;
+
+   NetIOThread(int socket)
+      : mSocket(socket),
+        mSenderWaiting(0),
+        mRoomToSend(0)
+   {
+      mWakePipe[0] = mWakePipe[1] = -1;
+      if(pipe(mWakePipe) == 0)
+      {
+         fcntl(mWakePipe[0], F_SETFL, O_NONBLOCK);
+         fcntl(mWakePipe[1], F_SETFL, O_NONBLOCK);
+      }
+   }
+
+   ~NetIOThread()
+   {
+      if(mWakePipe[0] != -1)
+      {
+         close(mWakePipe[0]);
+         close(mWakePipe[1]);
+      }
+   }
+
+   bool isValid() const { return mWakePipe[0] != -1; }
+
+   /// Get the thread out of poll(), to send what's been queued or to stop.
+   void wake()
+   {
+      U8 byte = 0;
+      write(mWakePipe[1], &byte, 1);
+   }
+
+   /// Return a free slot in mOutgoing, blocking until the thread has sent
+   /// something if the queue is full.  Only Net::sendto() may call this.
+   NetIOPacket *waitToSend()
+   {
+      NetIOPacket *packet;
+      while((packet = mOutgoing.beginPush()) == NULL)
+      {
+         // Check again after flagging that we're waiting, in case the
+         // thread made room in between and so won't signal us.
+         dCompareAndSwap(mSenderWaiting, 0, 1);
+         if((packet = mOutgoing.beginPush()) != NULL)
+         {
+            // A signal the thread sent anyway just makes the next wait
+            // loop once more.
+            dCompareAndSwap(mSenderWaiting, 1, 0);
+            break;
+         }
+
+         wake();
+         mRoomToSend.acquire();
+      }
+      return packet;
+   }
+
+   virtual void run(void *arg = 0)
+   {
+      _setName("NetIOThread");
+
+      pollfd fds[2];
+      fds[0].fd = mSocket;
+      fds[1].fd = mWakePipe[0];
+      fds[1].events = POLLIN;
+
+      while(!checkForStop())
+      {
+         // Send in bursts and check for incoming datagrams in between so
+         // that the socket's receive buffer doesn't overflow meanwhile.
+         bool moreToSend = sendQueued(SendBurstSize);
+
+         // Leave datagrams in the socket while the main thread catches up.
+         fds[0].events = mIncoming.beginPush() ? POLLIN : 0;
+         fds[0].revents = fds[1].revents = 0;
+
+         S32 timeout = PollTimeout;
+         if(moreToSend)
+            timeout = 0;
+         else if(!fds[0].events)
+            timeout = 1;
+
+         if(poll(fds, 2, timeout) <= 0)
+            continue;
+
+         if(fds[1].revents & POLLIN)
+         {
+            U8 buffer[64];
+            while(read(mWakePipe[0], buffer, sizeof(buffer)) > 0)
+               ;
+         }
+
+         if(fds[0].revents & POLLIN)
+            receive();
+      }
+
+      sendQueued(QueueSize);
+   }
+
+protected:
+   int mSocket;
+   int mWakePipe[2];
+
+   /// Set by waitToSend() when mOutgoing is full.
+   volatile U32 mSenderWaiting;
+
+   /// Signalled by sendQueued() when it has made room for a waiting sender.
+   Semaphore mRoomToSend;
+
+   void receive()
+   {
+      NetIOPacket *packet;
+      while((packet = mIncoming.beginPush()) != NULL)
+      {
+         socklen_t addrLen = sizeof(sockaddr_in);
+         packet->address.sin_family = AF_UNSPEC;
+
+         dFetchAndAdd(Net::smIOStats.recvCalls, 1);
+         packet->size = recvfrom(mSocket, (char *) packet->data, Net::MaxPacketDataSize, 0,
+            (PSOCKADDR) &packet->address, &addrLen);
+         if(packet->size == -1)
+            break;
+
+         dFetchAndAdd(Net::smIOStats.packetsReceived, 1);
+         packet->time = Platform::getRealMilliseconds();
+         mIncoming.endPush();
+      }
+   }
+
+   /// Send up to @a count queued datagrams.
+   /// @return true if there are more left.
+   bool sendQueued(U32 count)
+   {
+      NetIOPacket *packet;
+      for(; count && (packet = mOutgoing.front()) != NULL; count--)
+      {
+         dFetchAndAdd(Net::smIOStats.sendCalls, 1);
+         if(::sendto(mSocket, (const char *) packet->data, packet->size, 0,
+            (PSOCKADDR) &packet->address, sizeof(sockaddr_in)) != SOCKET_ERROR)
+            dFetchAndAdd(Net::smIOStats.packetsSent, 1);
+         mOutgoing.pop();
+
+         if(dCompareAndSwap(mSenderWaiting, 1, 0))
+            mRoomToSend.release();
+      }
+      return !mOutgoing.isEmpty();
+   }
+};
+
+static NetIOThread *gIOThread = NULL;
+
+static void startIOThread()
+{
+   if(Journal::IsRecording() || Journal::IsPlaying())
+      return;
+
+   NetIOThread *thread = new NetIOThread(udpSocket);
+   if(!thread->isValid())
+   {
+      Con::errorf("Net::openPort - could not create the network thread's wake-up pipe");
+      delete thread;
+      return;
+   }
+
+   gIOThread = thread;
+   gIOThread->start();
+}
+
+static void stopIOThread()
+{
+   if(!gIOThread)
+      return;
+
+   // Everything still queued for sending goes out before the thread stops.
+   gIOThread->stop();
+   gIOThread->wake();
+   gIOThread->join();
+
+   delete gIOThread;
+   gIOThread = NULL;
+}
+
+#endif // TORQUE_NET_IO_THREAD
+
+bool Net::isIOThreadRunning()
+{
+#if defined(TORQUE_NET_IO_THREAD)
+   return gIOThread != NULL;
+#else
+   return false;
+#endif
+}
+
+U32 Net::getPacketReceiveTime()
+{
+   if(gDispatchingPacket)
+      return gPacketReceiveTime;
+   return Platform::getVirtualMilliseconds();
+}
+
 // local enum for socket states for polled sockets
 enum SocketState
 {
@@ -210,6 +486,7 @@ bool Net::init()
    initCount++;
 
    Process::notify(&Net::process, PROCESS_NET_ORDER);
+   Process::notify(&Net::flushSends, PROCESS_NET_FLUSH_ORDER);
 
    return(true);
 }
@@ -217,6 +494,7 @@ bool Net::init()
 void Net::shutdown()
 {
    Process::remove(&Net::process);
+   Process::remove(&Net::flushSends);
 
    while (gPolledSockets.size() > 0)
       closeConnectTo(gPolledSockets[0]->fd);
@@ -254,34 +532,22 @@ Net::Error getLastError()
 #endif
 }
 
+// netNum holds the address bytes in network order, same as sin_addr, so the
+// conversions are plain copies.  These run for every packet.
+
 static void netToIPSocketAddress(const NetAddress *address, struct sockaddr_in *sockAddr)
 {
    dMemset(sockAddr, 0, sizeof(struct sockaddr_in));
    sockAddr->sin_family = AF_INET;
    sockAddr->sin_port = htons(address->port);
-   char tAddr[20];
-   dSprintf(tAddr, 20, "%d.%d.%d.%d", address->netNum[0],  address->netNum[1], address->netNum[2], address->netNum[3]);
-   //fprintf(stdout,"netToIPSocketAddress(): %s\n",tAddr);fflush(NULL);
-   sockAddr->sin_addr.s_addr = inet_addr(tAddr);
+   dMemcpy(&sockAddr->sin_addr.s_addr, address->netNum, 4);
 }
 
 static void IPSocketToNetAddress(const struct sockaddr_in *sockAddr,  NetAddress *address)
 {
    address->type = NetAddress::IPAddress;
    address->port = htons(sockAddr->sin_port);
-   char *tAddr;
-   tAddr = inet_ntoa(sockAddr->sin_addr);
-   //fprintf(stdout,"IPSocketToNetAddress(): %s\n",tAddr);fflush(NULL);
-   U8 nets[4];
-   nets[0] = atoi(strtok(tAddr, "."));
-   nets[1] = atoi(strtok(NULL, "."));
-   nets[2] = atoi(strtok(NULL, "."));
-   nets[3] = atoi(strtok(NULL, "."));
-   //fprintf(stdout,"0 = %d, 1 = %d, 2 = %d, 3 = %d\n", nets[0], nets[1],  nets[2], nets[3]);
-   address->netNum[0] = nets[0];
-   address->netNum[1] = nets[1];
-   address->netNum[2] = nets[2];
-   address->netNum[3] = nets[3];
+   dMemcpy(address->netNum, &sockAddr->sin_addr.s_addr, 4);
 }
 
 NetSocket Net::openListenPort(U16 port)
@@ -432,8 +698,7 @@ Net::Error Net::sendtoSocket(NetSocket socket, const U8 *buffer, int  bufferSize
 
 bool Net::openPort(S32 port, bool doBind)
 {
-   if(udpSocket != InvalidSocket)
-      ::closesocket(udpSocket);
+   closePort();
 
    udpSocket = socket(AF_INET, SOCK_DGRAM, 0);
 
@@ -455,7 +720,14 @@ bool Net::openPort(S32 port, bool doBind)
          error = setBlocking(udpSocket, false);
 
       if(error == NoError)
+      {
          Con::printf("UDP initialized on port %d", port);
+
+#if defined(TORQUE_NET_IO_THREAD)
+         if(smIOThread)
+            startIOThread();
+#endif
+      }
       else
       {
          ::closesocket(udpSocket);
@@ -479,7 +751,15 @@ NetSocket Net::getPort()
 void Net::closePort()
 {
    if(udpSocket != InvalidSocket)
+   {
+      // Don't lose what's still queued for the old port.
+#if defined(TORQUE_NET_IO_THREAD)
+      stopIOThread();
+#endif
+      flushSends();
       ::closesocket(udpSocket);
+      udpSocket = InvalidSocket;
+   }
 }
 
 Net::Error Net::sendto(const NetAddress *address, const U8 *buffer, S32  bufferSize)
@@ -487,66 +767,231 @@ Net::Error Net::sendto(const NetAddress *address, const U8 *buffer, S32  bufferS
    if(Journal::IsPlaying())
       return NoError;
 
-   if(address->type == NetAddress::IPAddress)
+   sockaddr_in ipAddr;
+   netToIPSocketAddress(address, &ipAddr);
+
+#if defined(TORQUE_NET_IO_THREAD)
+   if(gIOThread && bufferSize <= MaxPacketDataSize)
    {
-      sockaddr_in ipAddr;
-      netToIPSocketAddress(address, &ipAddr);
-      if(::sendto(udpSocket, (const char*)buffer, bufferSize, 0,
-         (sockaddr *) &ipAddr, sizeof(sockaddr_in)) == SOCKET_ERROR)
-         return getLastError();
-      else
-         return NoError;
+      // If the queue is full, wait for the thread to make room rather than
+      // sending from here, so packets stay in order.
+      NetIOPacket *packet = gIOThread->waitToSend();
+
+      packet->address = ipAddr;
+      packet->size = bufferSize;
+      dMemcpy(packet->data, buffer, bufferSize);
+      gIOThread->mOutgoing.endPush();
+      return NoError;
    }
-   else
+#endif
+
+#if defined(TORQUE_NET_BATCHED_IO)
+   if(smBatchedIO && udpSocket != InvalidSocket && bufferSize <= MaxPacketDataSize)
    {
-      SOCKADDR_IN ipAddr;
-      netToIPSocketAddress(address, &ipAddr);
-      if(::sendto(udpSocket, (const char*)buffer, bufferSize, 0,
-         (PSOCKADDR) &ipAddr, sizeof(SOCKADDR_IN)) == SOCKET_ERROR)
-         return getLastError();
-      else
-         return NoError;
+      if(gSendQueueCount == SendQueueSize)
+         flushSends();
+
+      U32 index = gSendQueueCount++;
+      dMemcpy(gSendBuffers[index], buffer, bufferSize);
+      gSendAddresses[index] = ipAddr;
+      gSendSizes[index] = bufferSize;
+      return NoError;
    }
+#endif
+
+   dFetchAndAdd(smIOStats.sendCalls, 1);
+   if(::sendto(udpSocket, (const char*)buffer, bufferSize, 0,
+      (PSOCKADDR) &ipAddr, sizeof(SOCKADDR_IN)) == SOCKET_ERROR)
+      return getLastError();
+
+   dFetchAndAdd(smIOStats.packetsSent, 1);
+   return NoError;
 }
 
-void Net::process()
+void Net::flushSends()
+{
+#if defined(TORQUE_NET_IO_THREAD)
+   if(gIOThread && !gIOThread->mOutgoing.isEmpty())
+      gIOThread->wake();
+#endif
+
+#if defined(TORQUE_NET_BATCHED_IO)
+   U32 count = gSendQueueCount;
+   gSendQueueCount = 0;
+   if(!count || udpSocket == InvalidSocket)
+      return;
+
+   mmsghdr msgs[SendQueueSize];
+   iovec iovs[SendQueueSize];
+   dMemset(msgs, 0, count * sizeof(mmsghdr));
+   for(U32 i = 0; i < count; i++)
+   {
+      iovs[i].iov_base = gSendBuffers[i];
+      iovs[i].iov_len = gSendSizes[i];
+      msgs[i].msg_hdr.msg_name = &gSendAddresses[i];
+      msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+   }
+
+   U32 sent = 0;
+   while(sent < count)
+   {
+      dFetchAndAdd(smIOStats.sendCalls, 1);
+      S32 result = sendmmsg(udpSocket, msgs + sent, count - sent, 0);
+      if(result > 0)
+      {
+         sent += result;
+         dFetchAndAdd(smIOStats.packetsSent, result);
+         continue;
+      }
+
+      if(errno == ENOSYS)
+      {
+         // Old kernel.  Send the rest one by one and don't batch again.
+         smBatchedIO = false;
+         for(; sent < count; sent++)
+            ::sendto(udpSocket, (const char*)gSendBuffers[sent], gSendSizes[sent], 0,
+               (PSOCKADDR) &gSendAddresses[sent], sizeof(sockaddr_in));
+         break;
+      }
+
+      // sendmmsg() stops at the first datagram that fails.  Drop that one,
+      // just like a failed sendto() would, and go on with the rest.
+      sent++;
+   }
+#endif
+}
+
+/// Hand a datagram read from the UDP port to Net::smPacketReceive.
+/// @param time Virtual time at which the datagram arrived.
+static void dispatchPacket(const sockaddr_in *sa, U8 *data, S32 size, U32 time)
 {
-   sockaddr sa;
-   sa.sa_family = AF_UNSPEC;
+   if(sa->sin_family != AF_INET || size <= 0)
+      return;
+
    NetAddress srcAddress;
-   RawData tmpBuffer;
-   tmpBuffer.alloc(MaxPacketDataSize);
+   IPSocketToNetAddress(sa, &srcAddress);
+
+   if(srcAddress.type == NetAddress::IPAddress &&
+      srcAddress.netNum[0] == 127 &&
+      srcAddress.netNum[1] == 0 &&
+      srcAddress.netNum[2] == 0 &&
+      srcAddress.netNum[3] == 1 &&
+      srcAddress.port == netPort)
+      return;
+
+   gPacketReceiveTime = time;
+   gDispatchingPacket = true;
+   Net::smPacketReceive.trigger(srcAddress, RawData((S8 *) data, size));
+   gDispatchingPacket = false;
+}
+
+#if defined(TORQUE_NET_BATCHED_IO)
+/// Read the UDP port with recvmmsg().  Returns false if the kernel doesn't
+/// support it.
+static bool receiveBatched()
+{
+   mmsghdr msgs[RecvBatchSize];
+   iovec iovs[RecvBatchSize];
+
+   for(;;)
+   {
+      dMemset(msgs, 0, sizeof(msgs));
+      for(U32 i = 0; i < RecvBatchSize; i++)
+      {
+         iovs[i].iov_base = gRecvBuffers[i];
+         iovs[i].iov_len = Net::MaxPacketDataSize;
+         msgs[i].msg_hdr.msg_name = &gRecvAddresses[i];
+         msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+         msgs[i].msg_hdr.msg_iov = &iovs[i];
+         msgs[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      dFetchAndAdd(Net::smIOStats.recvCalls, 1);
+      S32 count = recvmmsg(udpSocket, msgs, RecvBatchSize, MSG_DONTWAIT, NULL);
+      if(count == -1)
+         return errno != ENOSYS;
+
+      dFetchAndAdd(Net::smIOStats.packetsReceived, count);
+      U32 time = Platform::getVirtualMilliseconds();
+      for(S32 i = 0; i < count; i++)
+         dispatchPacket(&gRecvAddresses[i], gRecvBuffers[i], msgs[i].msg_len, time);
+
+      // A short batch means the socket has been drained.  Anything that
+      // arrived since will be picked up next frame.
+      if(count < RecvBatchSize || udpSocket == InvalidSocket)
+         return true;
+   }
+}
+#endif
+
+/// Read the UDP port one datagram at a time.
+static void receiveSingle()
+{
+   sockaddr_in *sa = &gRecvAddresses[0];
 
    for(;;)
    {
-      socklen_t addrLen = sizeof(sa);
+      sa->sin_family = AF_UNSPEC;
+      socklen_t addrLen = sizeof(sockaddr_in);
       S32 bytesRead = -1;
 
       if(udpSocket != InvalidSocket)
-         bytesRead = recvfrom(udpSocket, (char *) tmpBuffer.data, MaxPacketDataSize, 0, &sa, &addrLen);
+      {
+         dFetchAndAdd(Net::smIOStats.recvCalls, 1);
+         bytesRead = recvfrom(udpSocket, (char *) gRecvBuffers[0], Net::MaxPacketDataSize, 0, (PSOCKADDR) sa, &addrLen);
+      }
 
       if(bytesRead == -1)
          break;
 
-      if(sa.sa_family == AF_INET)
-         IPSocketToNetAddress((sockaddr_in *) &sa,  &srcAddress);
-      else
-         continue;
+      dFetchAndAdd(Net::smIOStats.packetsReceived, 1);
+      dispatchPacket(sa, gRecvBuffers[0], bytesRead, Platform::getVirtualMilliseconds());
+   }
+}
 
-      if(bytesRead <= 0)
-         continue;
+#if defined(TORQUE_NET_IO_THREAD)
+/// Hand out what the network thread has received.
+static void receiveFromIOThread()
+{
+   NetIOThread *thread = gIOThread;
+   NetIOThread::PacketQueue &queue = thread->mIncoming;
 
-      if(srcAddress.type == NetAddress::IPAddress &&
-         srcAddress.netNum[0] == 127 &&
-         srcAddress.netNum[1] == 0 &&
-         srcAddress.netNum[2] == 0 &&
-         srcAddress.netNum[3] == 1 &&
-         srcAddress.port == netPort)
-         continue;
+   // Only take what's there now so a flood can't keep us here.
+   U32 count = queue.size();
+
+   U32 realTime = Platform::getRealMilliseconds();
+   U32 virtualTime = Platform::getVirtualMilliseconds();
 
-      tmpBuffer.size = bytesRead;
+   for(U32 i = 0; i < count; i++)
+   {
+      NetIOPacket *packet = queue.front();
+      U32 age = realTime - packet->time;
+      dispatchPacket(&packet->address, packet->data, packet->size, virtualTime - age);
+
+      // A handler may have closed the port, which takes the thread down.
+      if(gIOThread != thread)
+         return;
+      queue.pop();
+   }
+}
+#endif
 
-      Net::smPacketReceive.trigger(srcAddress, tmpBuffer);
+void Net::process()
+{
+#if defined(TORQUE_NET_IO_THREAD)
+   if(gIOThread)
+      receiveFromIOThread();
+   else
+#endif
+   {
+#if defined(TORQUE_NET_BATCHED_IO)
+      if(smBatchedIO && udpSocket != InvalidSocket && !receiveBatched())
+         smBatchedIO = false;
+      if(!smBatchedIO)
+#endif
+         receiveSingle();
    }
 
    // process the polled sockets.  This blob of code performs functions
@@ -114,6 +114,61 @@ struct Net
    static void closePort();
    static Error sendto(const NetAddress *address, const U8 *buffer, S32 bufferSize);
 
+   /// @name Batched UDP
+   ///
+   /// Where the platform supports it (recvmmsg/sendmmsg on Linux), datagrams
+   /// on the UDP port are read in batches, and sendto() only queues them.
+   /// Queued datagrams go out with a single call in flushSends(), which runs
+   /// every frame right after the simulation.
+   /// @{
+
+   /// Read and send datagrams in batches if the platform supports it.
+   static bool smBatchedIO;
+
+   /// Send everything sendto() has queued.
+   static void flushSends();
+
+   /// Counts of system calls made on the UDP port and of the datagrams
+   /// that went through them.  The network thread counts its calls too, so
+   /// the counters are only ever updated with dFetchAndAdd().
+   struct IOStats
+   {
+      volatile U32 recvCalls;
+      volatile U32 packetsReceived;
+      volatile U32 sendCalls;
+      volatile U32 packetsSent;
+   };
+
+   static IOStats smIOStats;
+
+   /// @}
+
+   /// @name Network Thread
+   ///
+   /// Where supported (everywhere but Windows), a thread can take over the
+   /// UDP port.  It reads datagrams as soon as they arrive, notes the time,
+   /// and queues them for process() to hand out on the main thread.  Datagrams
+   /// passed to sendto() are queued the other way and sent by the thread.
+   /// This way a stall on the main thread doesn't hold packets up in the
+   /// socket or show up in measured ping.
+   ///
+   /// The thread is started by openPort() and stopped by closePort().  It is
+   /// not used while a journal is recorded or played back.
+   /// @{
+
+   /// Use a network thread for the UDP port.  Takes effect on openPort().
+   static bool smIOThread;
+
+   /// @return true if a network thread currently owns the UDP port.
+   static bool isIOThreadRunning();
+
+   /// @return the time, in virtual milliseconds, at which the packet that
+   ///   smPacketReceive is currently signalling arrived.  Outside of that,
+   ///   returns the current virtual time.
+   static U32 getPacketReceiveTime();
+
+   /// @}
+
    // Reliable net functions (TCP)
    // all incoming messages come in on the Connected* events
    static NetSocket openListenPort(U16 port);
@@ -141,10 +196,9 @@ struct Net
    static Error setBroadcast(NetSocket socket, bool broadcastEnable);
    static Error setBlocking(NetSocket socket, bool blockingIO);
 
-
-private:
+   /// Read everything pending on the UDP port and service the polled sockets.
+   /// Runs once a frame.
    static void process();
-
 };
 
 #endif
\ No newline at end of file
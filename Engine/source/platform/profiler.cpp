@@ -574,6 +574,13 @@ static void profilerDataDumpRecurseFile(ProfilerData *data, char *buffer, U32 bu
    buffer[bufferLen] = 0;
 }
 
+static void writeArenaUsage(const char* line, void* userData)
+{
+   FileStream* fws = reinterpret_cast<FileStream*>(userData);
+   fws->write(dStrlen(line), line);
+   fws->write(1, "\n");
+}
+
 void Profiler::dump()
 {
    bool enableSave = mEnabled;
@@ -616,6 +623,10 @@ void Profiler::dump()
       char depthBuffer[MaxStackDepth * 2 + 1];
       depthBuffer[0] = 0;
       profilerDataDumpRecurse(mCurrentProfilerData, depthBuffer, 0, totalTime);
+
+      Con::printf("");
+      Con::printf("Frame allocator high water marks -");
+      FrameAllocator::dumpArenaUsage(true);
       mEnabled = enableSave;
       mStackDepth--;
    }
@@ -656,6 +667,10 @@ void Profiler::dump()
       char depthBuffer[MaxStackDepth * 2 + 1];
       depthBuffer[0] = 0;
       profilerDataDumpRecurseFile(mCurrentProfilerData, depthBuffer, 0, totalTime, fws);
+
+      dStrcpy(buffer, "\nFrame allocator high water marks -\n      Size       Peak   Usage  Thread\n");
+      fws.write(dStrlen(buffer), buffer);
+      FrameAllocator::reportArenaUsage(writeArenaUsage, &fws, true);
       mEnabled = enableSave;
       mStackDepth--;
 
@@ -0,0 +1,138 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platformNet.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Loopback benchmark for the UDP port.
+//
+// Opens the UDP port and sends bursts of small datagrams to itself, reading
+// them back after each burst the way a server reads client packets once a
+// frame.  Net::process() drops datagrams coming from its own port before they
+// are handed out, but only after they have been read, so the counters still
+// cover them.  Runs unbatched, batched, and with the network thread, and
+// prints packets per second along with system calls per packet.
+
+CreateUnitTest( TestNetBatchedIO, "Platform/Net/BatchedIO" )
+{
+   enum
+   {
+      Port = 28999,
+      PacketSize = 64,
+      PacketsPerFrame = 16,
+      NumFrames = 4000,
+      Timeout = 2000,
+   };
+
+   void runFrames( const char* label, bool batched, bool ioThread )
+   {
+      Net::smBatchedIO = batched;
+      Net::smIOThread = ioThread;
+      if( !Net::openPort( Port ) )
+      {
+         UnitPrint( "Could not open the UDP port; skipping" );
+         return;
+      }
+
+      if( ioThread && !Net::isIOThreadRunning() )
+      {
+         UnitPrint( "No network thread on this platform; skipping" );
+         Net::closePort();
+         return;
+      }
+
+      dMemset( &Net::smIOStats, 0, sizeof( Net::smIOStats ) );
+
+      NetAddress address;
+      Net::stringToAddress( avar( "IP:127.0.0.1:%i", Port ), &address );
+
+      U8 packet[ PacketSize ];
+      dMemset( packet, 0xA5, sizeof( packet ) );
+
+      const U32 numPackets = NumFrames * PacketsPerFrame;
+      const Net::IOStats& stats = Net::smIOStats;
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 frame = 0; frame < NumFrames; ++ frame )
+      {
+         for( U32 i = 0; i < PacketsPerFrame; ++ i )
+            Net::sendto( &address, packet, sizeof( packet ) );
+         Net::flushSends();
+         Net::process();
+
+         // A real frame takes long enough for the network thread to
+         // get its turn; this one doesn't.
+         if( ioThread )
+            Platform::sleep( 0 );
+      }
+
+      // Pick up stragglers.  With the network thread, these may still be
+      // on their way.
+      while( stats.packetsReceived < numPackets && Platform::getRealMilliseconds() - start < Timeout + NumFrames )
+      {
+         Platform::sleep( 1 );
+         Net::process();
+      }
+      U32 elapsed = getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+
+      Net::closePort();
+
+      test( stats.packetsSent == numPackets, "Not all packets were sent" );
+
+      // The network thread sends and receives on its own schedule, so some
+      // datagrams may overflow the socket's receive buffer.  That only
+      // happens because we're talking to ourselves.
+      if( ioThread )
+         test( stats.packetsReceived >= numPackets * 0.99f, "Too many packets were lost" );
+      else
+         test( stats.packetsReceived == numPackets, "Not all packets came back" );
+
+      UnitPrint( avar( "%s: %.0f packets/sec, %.2f send calls/packet, %.2f receive calls/packet",
+         label,
+         F32( stats.packetsReceived ) * 1000.f / F32( elapsed ),
+         F32( stats.sendCalls ) / getMax( F32( stats.packetsSent ), 1.f ),
+         F32( stats.recvCalls ) / getMax( F32( stats.packetsReceived ), 1.f ) ) );
+   }
+
+   void run()
+   {
+      // Don't take the port away from a running game.
+      if( Net::getPort() != InvalidSocket )
+      {
+         UnitPrint( "UDP port is in use; skipping" );
+         return;
+      }
+
+      const bool savedBatchedIO = Net::smBatchedIO;
+      const bool savedIOThread = Net::smIOThread;
+
+      runFrames( "Unbatched     ", false, false );
+      runFrames( "Batched       ", true, false );
+      runFrames( "Network thread", false, true );
+
+      Net::smBatchedIO = savedBatchedIO;
+      Net::smIOThread = savedIOThread;
+   }
+};
@@ -82,4 +82,66 @@ CreateUnitTest( TestThreadPool, "Platform/ThreadPool/Simple" )
 
 Vector< U32 > TestThreadPool::results( __FILE__, __LINE__ );
 
+// Checks that parallelFor() and ParallelLoop cover every index exactly once
+// and that a cancelled loop skips what is left.
+
+CreateUnitTest( TestThreadPoolParallelLoop, "Platform/ThreadPool/ParallelLoop" )
+{
+   enum
+   {
+      NUM_VALUES = 100000,
+      CHUNK_SIZE = 64
+   };
+
+   static void count( U32 begin, U32 end, void* data )
+   {
+      volatile U32* counts = reinterpret_cast< volatile U32* >( data );
+      for( U32 i = begin; i < end; ++ i )
+         dFetchAndAdd( counts[ i ], 1 );
+   }
+
+   bool allCounted( const Vector< U32 >& counts, U32 expected )
+   {
+      for( U32 i = 0; i < counts.size(); ++ i )
+         if( counts[ i ] != expected )
+            return false;
+      return true;
+   }
+
+   void run()
+   {
+      ThreadPool* pool = &ThreadPool::GLOBAL();
+
+      Vector< U32 > counts;
+      counts.setSize( NUM_VALUES );
+      dMemset( counts.address(), 0, counts.memSize() );
+
+      pool->parallelFor( NUM_VALUES, CHUNK_SIZE, &count, counts.address() );
+      TEST( allCounted( counts, 1 ) );
+
+      pool->parallelFor( NUM_VALUES, 1, &count, counts.address() );
+      TEST( allCounted( counts, 2 ) );
+
+      pool->parallelFor( 0, CHUNK_SIZE, &count, counts.address() );
+      TEST( allCounted( counts, 2 ) );
+
+      // Waiting twice is fine.
+      ThreadSafeRef< ThreadPool::ParallelLoop > loop( new ThreadPool::ParallelLoop( NUM_VALUES, CHUNK_SIZE, &count, counts.address() ) );
+      loop->start( *pool );
+      loop->wait();
+      loop->wait();
+      TEST( loop->isDone() );
+      TEST( allCounted( counts, 3 ) );
+
+      // Cancelling a loop that was never started skips every index.
+      loop = new ThreadPool::ParallelLoop( NUM_VALUES, CHUNK_SIZE, &count, counts.address() );
+      loop->cancel();
+      TEST( loop->isDone() );
+      TEST( allCounted( counts, 3 ) );
+
+      // Let the items queued above run out before the counts go away.
+      pool->flushWorkItems();
+   }
+};
+
 #endif // !TORQUE_SHIPPING
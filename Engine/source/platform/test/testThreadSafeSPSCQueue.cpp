@@ -0,0 +1,156 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "platform/threads/threadSafeSPSCQueue.h"
+#include "platform/threads/thread.h"
+#include "console/console.h"
+
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+#define XTEST( t, x ) t->test( ( x ), "FAIL: " #x )
+
+
+// Test queue without concurrency.
+
+CreateUnitTest( TestThreadSafeSPSCQueueSerial, "Platform/ThreadSafeSPSCQueue/Serial" )
+{
+   void run()
+   {
+      ThreadSafeSPSCQueue< U32, 8 > queue;
+
+      TEST( queue.isEmpty() );
+      TEST( queue.front() == NULL );
+
+      // Go around the ring a few times.
+
+      U32 next = 0;
+      for( U32 round = 0; round < 5; ++ round )
+      {
+         U32 numPushed = 0;
+         while( queue.tryPush( next + numPushed ) )
+            ++ numPushed;
+
+         TEST( numPushed == 8 );
+         TEST( queue.size() == 8 );
+         TEST( queue.beginPush() == NULL );
+
+         for( U32 i = 0; i < numPushed; ++ i )
+         {
+            U32 value;
+            TEST( queue.tryPop( value ) && value == next + i );
+         }
+
+         TEST( queue.isEmpty() );
+         next += numPushed;
+      }
+   }
+};
+
+// Test queue with a producer thread and a consumer thread.
+
+CreateUnitTest( TestThreadSafeSPSCQueueConcurrent, "Platform/ThreadSafeSPSCQueue/Concurrent" )
+{
+   typedef TestThreadSafeSPSCQueueConcurrent TestType;
+
+   enum
+   {
+      DEFAULT_NUM_VALUES = 100000
+   };
+
+   struct Value
+   {
+      U32 mIndex;
+      U32 mCheck;
+   };
+
+   ThreadSafeSPSCQueue< Value, 64 > mQueue;
+   U32 mNumValues;
+
+   struct ProducerThread : public Thread
+   {
+      ProducerThread( TestType* test )
+         : Thread( 0, test ) {}
+
+      virtual void run( void* arg )
+      {
+         _setName( "ProducerThread" );
+         TestType* t = ( TestType* ) arg;
+
+         for( U32 i = 0; i < t->mNumValues; ++ i )
+         {
+            Value* slot;
+            while( ( slot = t->mQueue.beginPush() ) == NULL )
+               Platform::sleep( 0 );
+
+            slot->mIndex = i;
+            slot->mCheck = ~i;
+            t->mQueue.endPush();
+         }
+      }
+   };
+
+   struct ConsumerThread : public Thread
+   {
+      ConsumerThread( TestType* test )
+         : Thread( 0, test ) {}
+
+      virtual void run( void* arg )
+      {
+         _setName( "ConsumerThread" );
+         TestType* t = ( TestType* ) arg;
+
+         for( U32 i = 0; i < t->mNumValues; ++ i )
+         {
+            Value* slot;
+            while( ( slot = t->mQueue.front() ) == NULL )
+               Platform::sleep( 0 );
+
+            XTEST( t, slot->mIndex == i );
+            XTEST( t, slot->mCheck == ~i );
+            t->mQueue.pop();
+         }
+      }
+   };
+
+   void run()
+   {
+      mNumValues = Con::getIntVariable( "$testThreadSafeSPSCQueue::numValues", DEFAULT_NUM_VALUES );
+
+      ProducerThread pThread( this );
+      ConsumerThread cThread( this );
+
+      pThread.start();
+      cThread.start();
+
+      pThread.join();
+      cThread.join();
+
+      TEST( mQueue.isEmpty() );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -25,6 +25,7 @@
 #include "platform/platformCPUCount.h"
 #include "core/strings/stringFunctions.h"
 #include "core/util/tSingleton.h"
+#include "core/frameAllocator.h"
 
 
 //#define DEBUG_SPEW
@@ -230,14 +231,19 @@ inline ThreadPool::WorkerThread* ThreadPool::WorkerThread::getNext()
 
 void ThreadPool::WorkerThread::run( void* arg )
 {
-   #ifdef TORQUE_DEBUG
    {
-      // Set the thread's name for debugging.
       char buffer[ 2048 ];
       dSprintf( buffer, sizeof( buffer ), "ThreadPool(%s) WorkerThread %i", mPool->mName.c_str(), mIndex );
+
+      #ifdef TORQUE_DEBUG
+      // Set the thread's name for debugging.
       _setName( buffer );
+      #endif
+
+      // Give the thread its own frame arena so work items can use
+      // FrameTemp and FrameAllocatorMarker.
+      FrameAllocator::initThread( TORQUE_THREAD_FRAME_SIZE, buffer );
    }
-   #endif
 
    while( 1 )
    {
@@ -246,6 +252,7 @@ void ThreadPool::WorkerThread::run( void* arg )
 #ifdef DEBUG_SPEW
          Platform::outputDebugString( "[ThreadPool::WorkerThread] thread '%i' exits", getId() );
 #endif
+         FrameAllocator::destroyThread();
          dFetchAndAdd( mPool->mNumThreads, ( U32 ) -1 );
          return;
       }
@@ -466,3 +473,142 @@ void ThreadPool::processMainThreadWorkItems()
    }
    while( Platform::getRealMilliseconds() < timeLimit );
 }
+
+//=============================================================================
+//    ThreadPool::ParallelLoop.
+//=============================================================================
+
+struct ThreadPool::ParallelLoop::LoopWorkItem : public ThreadPool::WorkItem
+{
+   typedef ThreadPool::WorkItem Parent;
+
+   ThreadSafeRef< ParallelLoop > mLoop;
+
+   LoopWorkItem( ParallelLoop* loop )
+      : mLoop( loop ) {}
+
+protected:
+
+   virtual void execute()
+   {
+      mLoop->_run();
+   }
+};
+
+//--------------------------------------------------------------------------
+
+ThreadPool::ParallelLoop::ParallelLoop( U32 count, U32 chunkSize, ParallelLoopFunction function, void* data )
+   : mCount( count ),
+     mChunkSize( getMax( chunkSize, U32( 1 ) ) ),
+     mFunction( function ),
+     mData( data ),
+     mNext( 0 ),
+     mNumPending( count ),
+     mDone( 0 ),
+     mFinished( count == 0 )
+{
+}
+
+//--------------------------------------------------------------------------
+
+void ThreadPool::ParallelLoop::start( ThreadPool& pool, U32 maxItems )
+{
+   const U32 numItems = getMin( getMin( maxItems, getNumChunks() ), pool.getNumThreads() );
+   for( U32 i = 0; i < numItems; ++ i )
+   {
+      ThreadSafeRef< LoopWorkItem > item( new LoopWorkItem( this ) );
+      pool.queueWorkItem( item );
+   }
+}
+
+//--------------------------------------------------------------------------
+
+bool ThreadPool::ParallelLoop::_claim( U32& begin, U32& end )
+{
+   // dFetchAndAdd() doesn't hand back the old value, so claim the
+   // chunk with a compare-and-swap.
+   do
+   {
+      begin = dAtomicRead( mNext );
+      if( begin >= mCount )
+         return false;
+   }
+   while( !dCompareAndSwap( mNext, begin, begin + mChunkSize ) );
+
+   end = getMin( begin + mChunkSize, mCount );
+   return true;
+}
+
+//--------------------------------------------------------------------------
+
+void ThreadPool::ParallelLoop::_complete( U32 count )
+{
+   U32 pending;
+   do
+      pending = dAtomicRead( mNumPending );
+   while( !dCompareAndSwap( mNumPending, pending, pending - count ) );
+
+   if( pending == count )
+      mDone.release();
+}
+
+//--------------------------------------------------------------------------
+
+void ThreadPool::ParallelLoop::_run()
+{
+   U32 begin;
+   U32 end;
+   while( _claim( begin, end ) )
+   {
+      mFunction( begin, end, mData );
+      _complete( end - begin );
+   }
+}
+
+//--------------------------------------------------------------------------
+
+void ThreadPool::ParallelLoop::_finish()
+{
+   mDone.acquire();
+   mFinished = true;
+}
+
+//--------------------------------------------------------------------------
+
+void ThreadPool::ParallelLoop::wait()
+{
+   if( mFinished )
+      return;
+
+   _run();
+   _finish();
+}
+
+//--------------------------------------------------------------------------
+
+void ThreadPool::ParallelLoop::cancel()
+{
+   if( mFinished )
+      return;
+
+   U32 begin;
+   U32 end;
+   while( _claim( begin, end ) )
+      _complete( end - begin );
+
+   _finish();
+}
+
+//--------------------------------------------------------------------------
+
+void ThreadPool::parallelFor( U32 count, U32 chunkSize, ParallelLoopFunction function, void* data )
+{
+   ThreadSafeRef< ParallelLoop > loop( new ParallelLoop( count, chunkSize, function, data ) );
+
+   // This thread pitches in as well, so one item fewer than there are
+   // chunks will do.
+   if( loop->getNumChunks() > 1 )
+      loop->start( *this, loop->getNumChunks() - 1 );
+
+   loop->wait();
+}
@@ -233,6 +233,10 @@ class ThreadPool
 
       typedef ThreadSafeRef< WorkItem > WorkItemPtr;
       struct GlobalThreadPool;
+      class ParallelLoop;
+
+      /// Function run by a ParallelLoop on each chunk [begin, end) of its indices.
+      typedef void ( *ParallelLoopFunction )( U32 begin, U32 end, void* data );
       
    protected:
    
@@ -292,8 +296,18 @@ class ThreadPool
       /// Manually shutdown threads outside of static destructors.
       void shutdown();
 
+      /// Return the number of worker threads in this pool.
+      U32 getNumThreads() const { return mNumThreads; }
+
       ///
       void queueWorkItem( WorkItem* item );
+
+      /// Call @a function on chunks of @a chunkSize indices until it has
+      /// covered [0, count), spread over the worker threads of this pool and
+      /// the calling thread, and return once all chunks are done.
+      ///
+      /// @see ParallelLoop
+      void parallelFor( U32 count, U32 chunkSize, ParallelLoopFunction function, void* data );
       
       ///
       /// <em>For the global pool, it is very important to only ever call
@@ -395,4 +409,73 @@ inline ThreadPool& ThreadPool::GLOBAL()
    return *( GlobalThreadPool::instance() );
 }
 
+
+/// A loop over a range of indices that is spread over the worker threads of a
+/// pool.
+///
+/// The indices are claimed in chunks off a shared counter by the work items
+/// that start() queues and by the thread that calls wait(), so the loop
+/// finishes even if no worker gets to it.  wait() then blocks until the chunks
+/// claimed by workers are done.  Items that only get to run after all chunks
+/// have been claimed find nothing left to do.
+///
+/// The loop must be waited on or cancelled before whatever @a data points to
+/// goes away.
+class ThreadPool::ParallelLoop : public ThreadSafeRefCount< ParallelLoop >
+{
+   public:
+
+      ParallelLoop( U32 count, U32 chunkSize, ParallelLoopFunction function, void* data );
+
+      /// Queue work items on @a pool for up to @a maxItems worker threads.
+      void start( ThreadPool& pool, U32 maxItems = U32_MAX );
+
+      /// Run the chunks that are left on the calling thread and then wait for
+      /// the ones other threads are running.
+      void wait();
+
+      /// Skip the chunks that are left and wait for the ones other threads
+      /// are running.
+      void cancel();
+
+      /// Return the number of chunks the indices are split into.
+      U32 getNumChunks() const { return ( mCount + mChunkSize - 1 ) / mChunkSize; }
+
+      /// Return true if every chunk has been run or skipped.
+      bool isDone() const { return ( dAtomicRead( mNumPending ) == 0 ); }
+
+   protected:
+
+      struct LoopWorkItem;
+
+      U32 mCount;
+      U32 mChunkSize;
+      ParallelLoopFunction mFunction;
+      void* mData;
+
+      /// Index of the next chunk to claim.
+      volatile U32 mNext;
+
+      /// Number of indices not yet run or skipped.
+      mutable volatile U32 mNumPending;
+
+      /// Released once #mNumPending drops to zero.
+      Semaphore mDone;
+
+      /// Whether wait() or cancel() has returned.
+      bool mFinished;
+
+      /// Claim the next chunk.  Returns false if all have been claimed.
+      bool _claim( U32& begin, U32& end );
+
+      /// Mark @a count indices as done.
+      void _complete( U32 count );
+
+      /// Run chunks until all have been claimed.
+      void _run();
+
+      /// Wait for the chunks other threads have claimed.
+      void _finish();
+};
+
 #endif // !_THREADPOOL_H_
@@ -0,0 +1,163 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _THREADSAFESPSCQUEUE_H_
+#define _THREADSAFESPSCQUEUE_H_
+
+#ifndef _PLATFORM_H_
+#  include "platform/platform.h"
+#endif
+#ifndef _PLATFORMINTRINSICS_H_
+#  include "platform/platformIntrinsics.h"
+#endif
+
+
+/// Fixed-size, lock-free queue for one producer thread and one consumer thread.
+///
+/// Values live in a ring of preallocated slots.  The producer fills a slot
+/// in place and then publishes it; the consumer reads it in place and then
+/// releases it.  Nothing is allocated or copied beyond that, which makes the
+/// queue suitable for handing large buffers such as network packets between
+/// threads.
+///
+/// Only one thread may push and only one thread may pop at any time.
+///
+/// @param T Type of values; must have a default constructor.
+/// @param SIZE Number of slots; must be a power of two.
+template< typename T, U32 SIZE >
+class ThreadSafeSPSCQueue
+{
+   public:
+
+      typedef T ValueType;
+
+   protected:
+
+      enum
+      {
+         Mask = SIZE - 1,
+         CacheLineSize = 64
+      };
+
+      // The two counters only ever increase; slot indices are taken modulo
+      // SIZE.  Each sits on its own cache line so that the producer and the
+      // consumer don't invalidate each other's cache on every operation.
+
+      /// Number of values pushed so far.  Written by the producer only.
+      volatile U32 mNumPushed;
+      U8 mPad0[ CacheLineSize - sizeof( U32 ) ];
+
+      /// Number of values popped so far.  Written by the consumer only.
+      volatile U32 mNumPopped;
+      U8 mPad1[ CacheLineSize - sizeof( U32 ) ];
+
+      ValueType mSlots[ SIZE ];
+
+   public:
+
+      ThreadSafeSPSCQueue()
+         : mNumPushed( 0 ),
+           mNumPopped( 0 )
+      {
+         AssertFatal( ( SIZE & Mask ) == 0, "ThreadSafeSPSCQueue - size must be a power of two" );
+      }
+
+      /// @return true if the queue is empty.
+      bool isEmpty()
+      {
+         return ( dAtomicRead( mNumPushed ) == dAtomicRead( mNumPopped ) );
+      }
+
+      /// @return the number of values in the queue.
+      U32 size()
+      {
+         return ( dAtomicRead( mNumPushed ) - dAtomicRead( mNumPopped ) );
+      }
+
+      /// @name Producer
+      /// @{
+
+      /// Get the slot that the next value is to be written to.
+      /// @return the slot or NULL if the queue is full.
+      ValueType* beginPush()
+      {
+         if( mNumPushed - dAtomicRead( mNumPopped ) == SIZE )
+            return NULL;
+         return &mSlots[ mNumPushed & Mask ];
+      }
+
+      /// Make the slot returned by beginPush() visible to the consumer.
+      void endPush()
+      {
+         dFetchAndAdd( mNumPushed, 1 );
+      }
+
+      /// Append a copy of the given value.
+      /// @return false if the queue is full.
+      bool tryPush( const ValueType& value )
+      {
+         ValueType* slot = beginPush();
+         if( !slot )
+            return false;
+
+         *slot = value;
+         endPush();
+         return true;
+      }
+
+      /// @}
+
+      /// @name Consumer
+      /// @{
+
+      /// Get the oldest value in the queue without taking it.
+      /// @return the value or NULL if the queue is empty.
+      ValueType* front()
+      {
+         if( dAtomicRead( mNumPushed ) == mNumPopped )
+            return NULL;
+         return &mSlots[ mNumPopped & Mask ];
+      }
+
+      /// Release the slot returned by front() back to the producer.
+      void pop()
+      {
+         dFetchAndAdd( mNumPopped, 1 );
+      }
+
+      /// Take the oldest value from the queue.
+      /// @return false if the queue is empty.
+      bool tryPop( ValueType& outValue )
+      {
+         ValueType* slot = front();
+         if( !slot )
+            return false;
+
+         outValue = *slot;
+         pop();
+         return true;
+      }
+
+      /// @}
+};
+
+#endif // _THREADSAFESPSCQUEUE_H_
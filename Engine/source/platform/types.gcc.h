@@ -113,6 +113,8 @@ typedef unsigned long long  U64;
 #  error "GCC: Unsupported Target CPU"
 #endif
 
+#define TORQUE_THREAD_LOCAL __thread   ///< Per-thread static storage
+
 #ifndef Offset
 /// Offset macro:
 /// Calculates the location in memory of a given member x of class cls from the
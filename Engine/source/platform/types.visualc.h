@@ -74,6 +74,8 @@ typedef unsigned _int64 U64;
 #  define FN_CDECL __cdecl            ///< Calling convention
 #endif
 
+#define TORQUE_THREAD_LOCAL __declspec(thread)   ///< Per-thread static storage
+
 #define for if(false) {} else for   ///< Hack to work around Microsoft VC's non-C++ compliance on variable scoping
 
 // disable warning caused by memory layer
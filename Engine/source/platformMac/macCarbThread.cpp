@@ -24,6 +24,8 @@
 #include "platform/threads/thread.h"
 #include "platform/threads/semaphore.h"
 #include "platform/threads/mutex.h"
+#include "platform/platformMemory.h"
+#include "core/frameAllocator.h"
 #include <stdlib.h>
 
 class PlatformThreadData
@@ -58,6 +60,11 @@ static void *ThreadRunHandler(void * arg)
    
    ThreadManager::addThread(thread);
    thread->run(mData->mRunArg);
+
+   // Free the frame arena the thread got on its first frame allocation.
+   if( FrameAllocator::hasThreadArena() )
+      FrameAllocator::destroyThread();
+
    ThreadManager::removeThread(thread);
 
    bool autoDelete = thread->autoDelete;
@@ -68,6 +75,9 @@ static void *ThreadRunHandler(void * arg)
    
    if( autoDelete )
       delete thread;
+
+   // Hand back any memory this thread still has cached.
+   Memory::flushThreadCache();
       
    // return value for pthread lib's benefit
    return NULL;
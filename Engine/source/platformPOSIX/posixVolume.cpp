@@ -22,6 +22,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <sys/mman.h>
 
 #include "core/crc.h"
 #include "core/frameAllocator.h"
@@ -238,6 +239,7 @@ PosixFile::PosixFile(const Path& path,String name)
    _name = name;
    _status = Closed;
    _handle = 0;
+   _mode = Read;
 }
 
 PosixFile::~PosixFile()
@@ -337,6 +339,7 @@ bool PosixFile::open(AccessMode mode)
       return false;
    }
    
+   _mode = mode;
    _status = Open;
    return true;
 }
@@ -422,6 +425,35 @@ U32 PosixFile::write(const void* src, U32 size)
    return bytesWritten;
 }
 
+void* PosixFile::map(U32 size)
+{
+   if ((_status != Open && _status != EndOfFile) || !size)
+      return NULL;
+
+   // Only files opened for reading and writing can be mapped writable;
+   // mmap needs read access either way.
+   bool writable = _mode == ReadWrite;
+   if (!writable && _mode != Read)
+      return NULL;
+
+   fflush(_handle);
+   int fd = fileno(_handle);
+   if (writable && ftruncate(fd, size) != 0)
+   {
+      _updateStatus();
+      return NULL;
+   }
+
+   void* ptr = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+   return ptr != MAP_FAILED ? ptr : NULL;
+}
+
+void PosixFile::unmap(void* ptr, U32 size)
+{
+   if (ptr)
+      munmap(ptr, size);
+}
+
 void PosixFile::_updateStatus()
 {
    switch (errno)
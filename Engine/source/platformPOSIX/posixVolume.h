@@ -69,6 +69,7 @@ class PosixFile: public File
    String _name;
    FILE* _handle;
    Status _status;
+   AccessMode _mode;
 
    PosixFile(const Path& path,String name);
    bool _updateInfo();
@@ -90,6 +91,9 @@ public:
    U32 read(void* dst, U32 size);
    U32 write(const void* src, U32 size);
 
+   void* map(U32 size);
+   void unmap(void* ptr, U32 size);
+
 private:
    U32 calculateChecksum();
 };
@@ -25,6 +25,8 @@
 #include "platform/threads/semaphore.h"
 #include "platform/platformIntrinsics.h"
 #include "core/util/safeDelete.h"
+#include "platform/platformMemory.h"
+#include "core/frameAllocator.h"
 
 #include <process.h> // [tom, 4/20/2006] for _beginthread()
 
@@ -73,6 +75,11 @@ static unsigned int __stdcall ThreadRunHandler(void * arg)
 
    ThreadManager::addThread(mData->mThread);
    mData->mThread->run(mData->mRunArg);
+
+   // Free the frame arena the thread got on its first frame allocation.
+   if( FrameAllocator::hasThreadArena() )
+      FrameAllocator::destroyThread();
+
    ThreadManager::removeThread(mData->mThread);
 
    bool autoDelete = mData->mThread->autoDelete;
@@ -84,6 +91,9 @@ static unsigned int __stdcall ThreadRunHandler(void * arg)
    if( autoDelete )
       delete mData->mThread; // Safe as we own the data.
 
+   // Hand back any memory this thread still has cached.
+   Memory::flushThreadCache();
+
    _endthreadex( 0 );
    return 0;
 }
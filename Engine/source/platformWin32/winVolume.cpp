@@ -320,6 +320,7 @@ Win32File::Win32File(const Path& path,String name)
    mName = name;
    mStatus = Closed;
    mHandle = 0;
+   mMode = Read;
 }
 
 Win32File::~Win32File()
@@ -432,6 +433,7 @@ bool Win32File::open(AccessMode mode)
       return false;
    }
 
+   mMode = mode;
    mStatus = Open;
    return true;
 }
@@ -506,6 +508,40 @@ U32 Win32File::write(const void* src, U32 size)
    return bytesWritten;
 }
 
+void* Win32File::map(U32 size)
+{
+   if ((mStatus != Open && mStatus != EndOfFile) || !size)
+      return NULL;
+
+   bool writable = mMode == ReadWrite;
+   if (!writable && mMode != Read)
+      return NULL;
+
+   // The mapping grows the file, but doesn't shrink it.
+   if (writable && (::SetFilePointer((HANDLE)mHandle,size,0,FILE_BEGIN) == INVALID_SET_FILE_POINTER ||
+       !::SetEndOfFile((HANDLE)mHandle)))
+   {
+      _updateStatus();
+      return NULL;
+   }
+
+   HANDLE mapping = ::CreateFileMappingW((HANDLE)mHandle, NULL,
+               writable ? PAGE_READWRITE : PAGE_READONLY, 0, size, NULL);
+   if (!mapping)
+      return NULL;
+
+   // The view keeps the mapping object alive.
+   void* ptr = ::MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+   ::CloseHandle(mapping);
+   return ptr;
+}
+
+void Win32File::unmap(void* ptr, U32 size)
+{
+   if (ptr)
+      ::UnmapViewOfFile(ptr);
+}
+
 void Win32File::_updateStatus()
 {
    switch (::GetLastError())
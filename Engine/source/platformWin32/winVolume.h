@@ -78,6 +78,9 @@ public:
    U32 read(void* dst, U32 size);
    U32 write(const void* src, U32 size);
 
+   void* map(U32 size);
+   void unmap(void* ptr, U32 size);
+
 private:
    friend class Win32FileSystem;
 
@@ -87,6 +90,7 @@ private:
    String   mName;
    void     *mHandle;
    Status   mStatus;
+   AccessMode mMode;
 
    Win32File(const Path &path, String name);
 
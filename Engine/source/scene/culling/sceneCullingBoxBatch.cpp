@@ -0,0 +1,138 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/culling/sceneCullingBoxBatch.h"
+
+// Test four boxes at a time with SSE where the compiler targets it, and
+// one at a time otherwise.
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#  define TORQUE_CULLING_SSE
+#  include <xmmintrin.h>
+#endif
+
+
+namespace {
+
+   /// Distance from a plane beyond which PlaneF::whichSide() puts a point
+   /// on either side of it.
+   const F32 sSideEpsilon = 0.005f;
+
+   /// Return the mask of the boxes whose corners at @a x, @a y and @a z are
+   /// at least @a limit away from @a plane if FRONT is true, or at most
+   /// @a limit away if it is false.
+   template< bool FRONT >
+   inline U32 testCorners( const PlaneF& plane, const F32* x, const F32* y, const F32* z, F32 limit )
+   {
+      U32 mask = 0;
+
+#ifdef TORQUE_CULLING_SSE
+
+      const __m128 planeX = _mm_set1_ps( plane.x );
+      const __m128 planeY = _mm_set1_ps( plane.y );
+      const __m128 planeZ = _mm_set1_ps( plane.z );
+      const __m128 planeD = _mm_set1_ps( plane.d );
+      const __m128 limits = _mm_set1_ps( limit );
+
+      for( U32 i = 0; i < SceneCullingBoxBatch::Size; i += 4 )
+      {
+         // Same order of operations as PlaneF::distToPlane().
+         __m128 dist = _mm_add_ps( _mm_mul_ps( planeX, _mm_loadu_ps( x + i ) ),
+                                   _mm_mul_ps( planeY, _mm_loadu_ps( y + i ) ) );
+         dist = _mm_add_ps( dist, _mm_mul_ps( planeZ, _mm_loadu_ps( z + i ) ) );
+         dist = _mm_add_ps( dist, planeD );
+
+         const __m128 hit = FRONT ? _mm_cmpge_ps( dist, limits ) : _mm_cmple_ps( dist, limits );
+         mask |= U32( _mm_movemask_ps( hit ) ) << i;
+      }
+
+#else
+
+      for( U32 i = 0; i < SceneCullingBoxBatch::Size; ++ i )
+      {
+         const F32 dist = ( plane.x * x[ i ] + plane.y * y[ i ] + plane.z * z[ i ] ) + plane.d;
+         if( FRONT ? dist >= limit : dist <= limit )
+            mask |= U32( 1 ) << i;
+      }
+
+#endif
+
+      return mask;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneCullingBoxBatch::clear()
+{
+   dMemset( this, 0, sizeof( *this ) );
+}
+
+//-----------------------------------------------------------------------------
+
+U32 SceneCullingBoxBatch::testBack( const PlaneF& plane, U32 lanes ) const
+{
+   // A box is behind the plane if its corner furthest along the
+   // plane's normal is.
+
+   return lanes & testCorners< false >( plane,
+      plane.x > 0.0f ? mMaxX : mMinX,
+      plane.y > 0.0f ? mMaxY : mMinY,
+      plane.z > 0.0f ? mMaxZ : mMinZ,
+      - sSideEpsilon );
+}
+
+//-----------------------------------------------------------------------------
+
+U32 SceneCullingBoxBatch::testFront( const PlaneF& plane, U32 lanes ) const
+{
+   // A box is in front of the plane if its corner furthest against the
+   // plane's normal is.
+
+   return lanes & testCorners< true >( plane,
+      plane.x > 0.0f ? mMinX : mMaxX,
+      plane.y > 0.0f ? mMinY : mMaxY,
+      plane.z > 0.0f ? mMinZ : mMaxZ,
+      sSideEpsilon );
+}
+
+//-----------------------------------------------------------------------------
+
+U32 SceneCullingBoxBatch::testOutside( const PlaneF* planes, U32 numPlanes, U32 lanes ) const
+{
+   U32 outside = 0;
+   for( U32 i = 0; i < numPlanes && outside != lanes; ++ i )
+      outside |= testBack( planes[ i ], lanes );
+
+   return outside;
+}
+
+//-----------------------------------------------------------------------------
+
+U32 SceneCullingBoxBatch::testContained( const PlaneF* planes, U32 numPlanes, U32 lanes ) const
+{
+   U32 contained = lanes;
+   for( U32 i = 0; i < numPlanes && contained != 0; ++ i )
+      contained &= testFront( planes[ i ], contained );
+
+   return contained;
+}
@@ -0,0 +1,92 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _SCENECULLINGBOXBATCH_H_
+#define _SCENECULLINGBOXBATCH_H_
+
+#ifndef _MPLANE_H_
+#include "math/mPlane.h"
+#endif
+
+#ifndef _MBOX_H_
+#include "math/mBox.h"
+#endif
+
+
+/// A batch of axis-aligned boxes laid out as one array per coordinate.
+///
+/// Laying the boxes out like this lets them be tested against a plane all at
+/// once, using SSE where available.  The tests give the same answers as
+/// PlaneF::whichSide() does for each box on its own.
+///
+/// Results come back as masks with bit i set for box i.  The @a lanes
+/// argument of the tests is the mask of boxes to test; the other bits of the
+/// result are always clear.
+struct SceneCullingBoxBatch
+{
+   enum
+   {
+      /// Number of boxes in a batch.
+      Size = 8,
+
+      /// Mask of all the boxes of a full batch.
+      AllLanes = ( 1 << Size ) - 1,
+   };
+
+   F32 mMinX[ Size ];
+   F32 mMinY[ Size ];
+   F32 mMinZ[ Size ];
+   F32 mMaxX[ Size ];
+   F32 mMaxY[ Size ];
+   F32 mMaxZ[ Size ];
+
+   /// Clear all boxes of the batch to empty boxes at the origin.
+   void clear();
+
+   /// Store @a box as box number @a lane.
+   void set( U32 lane, const Box3F& box )
+   {
+      mMinX[ lane ] = box.minExtents.x;
+      mMinY[ lane ] = box.minExtents.y;
+      mMinZ[ lane ] = box.minExtents.z;
+      mMaxX[ lane ] = box.maxExtents.x;
+      mMaxY[ lane ] = box.maxExtents.y;
+      mMaxZ[ lane ] = box.maxExtents.z;
+   }
+
+   /// Return the mask of the boxes that lie behind @a plane.
+   U32 testBack( const PlaneF& plane, U32 lanes = AllLanes ) const;
+
+   /// Return the mask of the boxes that lie in front of @a plane.
+   U32 testFront( const PlaneF& plane, U32 lanes = AllLanes ) const;
+
+   /// Return the mask of the boxes that lie behind any of the given planes.
+   /// These are the boxes that PlaneSet::testPotentialIntersection() finds
+   /// to be outside.
+   U32 testOutside( const PlaneF* planes, U32 numPlanes, U32 lanes = AllLanes ) const;
+
+   /// Return the mask of the boxes that lie in front of all of the given
+   /// planes.  These are the boxes that PlaneSet::isContained() accepts.
+   U32 testContained( const PlaneF* planes, U32 numPlanes, U32 lanes = AllLanes ) const;
+};
+
+#endif // !_SCENECULLINGBOXBATCH_H_
@@ -31,6 +31,7 @@
 #include "terrain/terrData.h"
 #include "util/tempAlloc.h"
 #include "gfx/sim/debugDraw.h"
+#include "platform/threads/threadPool.h"
 
 
 extern bool gEditingMission;
@@ -38,6 +39,8 @@ extern bool gEditingMission;
 
 bool SceneCullingState::smDisableTerrainOcclusion = false;
 bool SceneCullingState::smDisableZoneCulling = false;
+bool SceneCullingState::smDisableOcclusionBuffer = false;
+U32 SceneCullingState::smParallelCullThreshold = 8192;
 U32 SceneCullingState::smMaxOccludersPerZone = 4;
 F32 SceneCullingState::smOccluderMinWidthPercentage = 0.1f;
 F32 SceneCullingState::smOccluderMinHeightPercentage = 0.1f;
@@ -84,6 +87,11 @@ SceneCullingState::SceneCullingState( SceneManager* sceneManager, const SceneCam
       SceneCullingVolume::Includer,
       PlaneSetF( planes, 4 )
    );
+
+   // Set up the occlusion buffer.  It only handles perspective views.
+
+   if( !smDisableOcclusionBuffer && !frustum.isOrtho() )
+      mOcclusionBuffer = new SceneOcclusionBuffer( frustum );
 }
 
 //-----------------------------------------------------------------------------
@@ -130,6 +138,14 @@ void SceneCullingState::addOccluder( SceneObject* object )
    if( silhouette.empty() || silhouette.size() < 3 )
       return;
 
+   // Rasterize the silhouette into the occlusion buffer.  Unlike the
+   // culling volume, this isn't subject to the size and per-zone limits
+   // on occluders.  Skip it if the camera is inside the occluder as the
+   // silhouette then doesn't cover what the occluder hides.
+
+   if( mOcclusionBuffer && !object->getWorldBox().isContained( getCameraState().getViewPosition() ) )
+      mOcclusionBuffer->addPolygon( silhouette.address(), silhouette.size() );
+
    // Generate the culling volume.
 
    SceneCullingVolume volume;
@@ -707,89 +723,510 @@ bool SceneCullingState::isOccluded( const SphereF& sphere, const U32* zones, U32
 
 //-----------------------------------------------------------------------------
 
+namespace {
+
+   /// Objects whose world boxes are tested against the same planes.
+   struct CullingBatch
+   {
+      SceneCullingBoxBatch boxes;
+
+      /// Zone whose culling volumes the boxes are tested against, or -1 to
+      /// test them against the root frustum.
+      S32 zone;
+
+      /// Number of boxes in the batch.
+      U32 numObjects;
+
+      /// Boxes in use before the test, boxes that passed it after.
+      U32 lanes;
+
+      /// Indices of the objects in the list being culled.
+      U32 objects[ SceneCullingBoxBatch::Size ];
+   };
+
+   /// Planes the batches are tested against.  These are fetched up front
+   /// so that the tests don't touch the frustum's lazily updated state.
+   struct CullingPlanes
+   {
+      const PlaneF* frustumPlanes;
+      U32 numFrustumPlanes;
+      PlaneF nearFarPlanes[ 2 ];
+   };
+
+   void testCullingBatches( const SceneCullingState* state, const CullingPlanes& planes,
+                            CullingBatch* batches, U32 begin, U32 end )
+   {
+      for( U32 i = begin; i < end; ++ i )
+      {
+         CullingBatch& batch = batches[ i ];
+
+         if( batch.zone == -1 )
+         {
+            batch.lanes &= ~batch.boxes.testOutside( planes.frustumPlanes, planes.numFrustumPlanes, batch.lanes );
+            continue;
+         }
+
+         // Same as _test() for objects in a single zone: near and far
+         // plane first, then the volumes of the zone.
+
+         const U32 lanes = batch.lanes & ~batch.boxes.testOutside( planes.nearFarPlanes, 2, batch.lanes );
+         batch.lanes = lanes ? state->getZoneState( batch.zone ).testVolumes( batch.boxes, lanes ) : 0;
+      }
+   }
+
+   /// Number of batches a thread pool thread claims at a time.
+   const U32 CullingChunkSize = 32;
+
+   /// Batches tested on the thread pool.
+   struct CullingJob
+   {
+      const SceneCullingState* state;
+      CullingPlanes planes;
+      CullingBatch* batches;
+   };
+
+   void testCullingJob( U32 begin, U32 end, void* data )
+   {
+      const CullingJob* job = reinterpret_cast< const CullingJob* >( data );
+      testCullingBatches( job->state, job->planes, job->batches, begin, end );
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+SceneCullingState::ObjectCullState SceneCullingState::_classifyObject( SceneObject* object, U32 cullOptions ) const
+{
+   // If we should respect editor overrides, test that now.
+
+   if( !( cullOptions & CullEditorOverrides ) &&
+       gEditingMission &&
+       ( ( object->isCullingDisabledInEditor() && object->isRenderEnabled() ) || object->isSelected() ) )
+      return ObjectVisible;
+
+   // If the object is render-disabled, it gets culled.  The only
+   // way around this is the editor override above.
+
+   if( !( cullOptions & DontCullRenderDisabled ) &&
+       !object->isRenderEnabled() )
+      return ObjectCulled;
+
+   // Global bounds objects are never culled.  Note that this means
+   // that if these objects are to respect zoning, they need to manually
+   // trigger the respective culling checks for whatever they want to
+   // batch.
+
+   if( object->isGlobalBounds() )
+      return ObjectVisible;
+
+   // If the object shouldn't be subjected to more fine-grained culling
+   // or if zone culling is disabled, just test against the root frustum.
+
+   if( !( object->getTypeMask() & CULLING_INCLUDE_TYPEMASK ) ||
+       ( object->getTypeMask() & CULLING_EXCLUDE_TYPEMASK ) ||
+       disableZoneCulling() )
+      return ObjectTestFrustum;
+
+   // Otherwise test the object against the culling volumes of
+   // the zones that it is assigned to.
+
+   return ObjectTestZones;
+}
+
+//-----------------------------------------------------------------------------
+
 U32 SceneCullingState::cullObjects( SceneObject** objects, U32 numObjects, U32 cullOptions ) const
 {
    PROFILE_SCOPE( SceneCullingState_cullObjects );
 
-   U32 numRemainingObjects = 0;
-
    // We test near and far planes separately in order to not do the tests
    // repeatedly, so fetch the planes now.
    const PlaneF& nearPlane = getFrustum().getPlanes()[ Frustum::PlaneNear ];
    const PlaneF& farPlane = getFrustum().getPlanes()[ Frustum::PlaneFar ];
 
+   // Lists too short to fill a batch are tested one object at a time.
+
+   if( numObjects < SceneCullingBoxBatch::Size )
+   {
+      U8 states[ SceneCullingBoxBatch::Size ];
+      for( U32 i = 0; i < numObjects; ++ i )
+      {
+         ObjectCullState state = _classifyObject( objects[ i ], cullOptions );
+         if( state == ObjectTestFrustum || state == ObjectTestZones )
+            state = _testObject( objects[ i ], state, nearPlane, farPlane );
+
+         states[ i ] = state;
+      }
+
+      return _removeCulledObjects( objects, numObjects, states );
+   }
+
+   TempAlloc< U8 > states( numObjects );
    for( U32 i = 0; i < numObjects; ++ i )
+      states[ i ] = _classifyObject( objects[ i ], cullOptions );
+
+   // If the occlusion buffer hasn't been filled yet, add the occluders
+   // and have the buffer rasterized while we do the plane tests.
+
+   if( mOcclusionBuffer && mOcclusionBuffer->isOpen() )
    {
-      SceneObject* object = objects[ i ];
-      bool isCulled = true;
+      if( !mDisableTerrainOcclusion )
+         _addTerrainOccluders();
 
-      // If we should respect editor overrides, test that now.
+      _addOccluderMeshes( objects, numObjects, states );
 
-      if( !( cullOptions & CullEditorOverrides ) &&
-          gEditingMission &&
-          ( ( object->isCullingDisabledInEditor() && object->isRenderEnabled() ) || object->isSelected() ) )
-      {
-         isCulled = false;
-      }
+      mOcclusionBuffer->beginRasterize();
+   }
 
-      // If the object is render-disabled, it gets culled.  The only
-      // way around this is the editor override above.
+   _testObjectsBatched( objects, numObjects, states, nearPlane, farPlane );
 
-      else if( !( cullOptions & DontCullRenderDisabled ) &&
-               !object->isRenderEnabled() )
-      {
-         isCulled = true;
-      }
+   if( mOcclusionBuffer )
+      _testOcclusion( objects, numObjects, states );
 
-      // Global bounds objects are never culled.  Note that this means
-      // that if these objects are to respect zoning, they need to manually
-      // trigger the respective culling checks for whatever they want to
-      // batch.
+   return _removeCulledObjects( objects, numObjects, states );
+}
 
-      else if( object->isGlobalBounds() )
-         isCulled = false;
+//-----------------------------------------------------------------------------
 
-      // If terrain occlusion checks are enabled, run them now.
+U32 SceneCullingState::_removeCulledObjects( SceneObject** objects, U32 numObjects, const U8* states ) const
+{
+   // Keep the objects that are visible.  Terrain occlusion is costly, so it
+   // is only tested for the objects that made it through the plane tests.
 
-      else if( !mDisableTerrainOcclusion &&
-               object->getWorldBox().minExtents.x > -1e5 &&
-               isOccludedByTerrain( object ) )
+   U32 numRemainingObjects = 0;
+   for( U32 i = 0; i < numObjects; ++ i )
+   {
+      SceneObject* object = objects[ i ];
+      bool isCulled = ( states[ i ] == ObjectCulled );
+
+      if( states[ i ] == ObjectPassedPlanes &&
+          !mDisableTerrainOcclusion &&
+          object->getWorldBox().minExtents.x > -1e5 &&
+          isOccludedByTerrain( object ) )
       {
          // Occluded by terrain.
          isCulled = true;
       }
 
-      // If the object shouldn't be subjected to more fine-grained culling
-      // or if zone culling is disabled, just test against the root frustum.
+      if( !isCulled )
+         objects[ numRemainingObjects ++ ] = object;
+   }
+
+   return numRemainingObjects;
+}
+
+//-----------------------------------------------------------------------------
+
+SceneCullingState::ObjectCullState SceneCullingState::_testObject( SceneObject* object, ObjectCullState state,
+                                                                   const PlaneF& nearPlane, const PlaneF& farPlane ) const
+{
+   if( state == ObjectTestFrustum )
+      return getFrustum().isCulled( object->getWorldBox() ) ? ObjectCulled : ObjectPassedPlanes;
+
+   // Go through the zones that the object is assigned to and
+   // test the object against the frustums of each of the zones.
+
+   CullingTestResult result = _test(
+      object->getWorldBox(),
+      SceneObject::ObjectZonesIterator( object ),
+      nearPlane,
+      farPlane
+   );
+
+   return ( result == SceneZoneCullingState::CullingTestPositiveByInclusion ) ? ObjectPassedPlanes : ObjectCulled;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneCullingState::_testObjectsBatched( SceneObject** objects, U32 numObjects, U8* states,
+                                             const PlaneF& nearPlane, const PlaneF& farPlane ) const
+{
+   // Batches are grouped by the zone their objects are tested in.  Group 0
+   // is tested against the root frustum and group N against zone N-1.
+
+   const U32 numGroups = mZoneStates.size() + 1;
+   TempAlloc< S32 > objectGroups( numObjects );
+   TempAlloc< U32 > groupSizes( numGroups );
+   dMemset( groupSizes.ptr, 0, numGroups * sizeof( U32 ) );
+
+   for( U32 i = 0; i < numObjects; ++ i )
+   {
+      S32 group = -1;
 
-      else if( !( object->getTypeMask() & CULLING_INCLUDE_TYPEMASK ) ||
-               ( object->getTypeMask() & CULLING_EXCLUDE_TYPEMASK ) ||
-               disableZoneCulling() )
+      if( states[ i ] == ObjectTestFrustum )
+         group = 0;
+      else if( states[ i ] == ObjectTestZones )
       {
-         isCulled = getFrustum().isCulled( object->getWorldBox() );
+         SceneObject::ObjectZonesIterator zoneIter( objects[ i ] );
+         if( !zoneIter.isValid() )
+            states[ i ] = ObjectCulled;
+         else
+         {
+            const U32 zone = *zoneIter;
+            ++ zoneIter;
+
+            // Only objects in a single zone are batched.  If the zone
+            // isn't visible, there's nothing to test.
+
+            if( zoneIter.isValid() )
+               states[ i ] = _testObject( objects[ i ], ObjectTestZones, nearPlane, farPlane );
+            else if( !getZoneState( zone ).hasIncluders() )
+               states[ i ] = ObjectCulled;
+            else
+               group = zone + 1;
+         }
       }
 
-      // Go through the zones that the object is assigned to and
-      // test the object against the frustums of each of the zones.
+      objectGroups[ i ] = group;
+      if( group != -1 )
+         groupSizes[ group ] ++;
+   }
 
-      else
-      {
-         CullingTestResult result = _test(
-            object->getWorldBox(),
-            SceneObject::ObjectZonesIterator( object ),
-            nearPlane,
-            farPlane
-         );
+   // Lay out the batches of each group one after the other.
+
+   TempAlloc< U32 > groupFirstBatch( numGroups );
+   U32 numBatches = 0;
+   for( U32 i = 0; i < numGroups; ++ i )
+   {
+      groupFirstBatch[ i ] = numBatches;
+      numBatches += ( groupSizes[ i ] + SceneCullingBoxBatch::Size - 1 ) / SceneCullingBoxBatch::Size;
+
+      // Sort the volumes of the zones now rather than on first use,
+      // which may be on a worker thread.
+
+      if( i > 0 && groupSizes[ i ] )
+         getZoneState( i - 1 ).getCullingVolumes();
+
+      groupSizes[ i ] = 0;
+   }
 
-         isCulled = ( result == SceneZoneCullingState::CullingTestNegative ||
-                      result == SceneZoneCullingState::CullingTestPositiveByOcclusion );
+   if( !numBatches )
+      return;
+
+   // Fill in the boxes.
+
+   TempAlloc< CullingBatch > batches( numBatches );
+   for( U32 i = 0; i < numObjects; ++ i )
+   {
+      const S32 group = objectGroups[ i ];
+      if( group == -1 )
+         continue;
+
+      const U32 slot = groupSizes[ group ] ++;
+      CullingBatch& batch = batches[ groupFirstBatch[ group ] + slot / SceneCullingBoxBatch::Size ];
+      const U32 lane = slot % SceneCullingBoxBatch::Size;
+
+      if( lane == 0 )
+      {
+         batch.boxes.clear();
+         batch.zone = group - 1;
+         batch.numObjects = 0;
+         batch.lanes = 0;
       }
 
-      if( !isCulled )
-         objects[ numRemainingObjects ++ ] = object;
+      batch.boxes.set( lane, objects[ i ]->getWorldBox() );
+      batch.objects[ lane ] = i;
+      batch.numObjects ++;
+      batch.lanes |= U32( 1 ) << lane;
    }
 
-   return numRemainingObjects;
+   // Test the batches.  Large lists are spread over the thread pool,
+   // with this thread pitching in.
+
+   CullingPlanes planes;
+   planes.frustumPlanes = getFrustum().getPlanes();
+   planes.numFrustumPlanes = getFrustum().getNumPlanes();
+   planes.nearFarPlanes[ 0 ] = nearPlane;
+   planes.nearFarPlanes[ 1 ] = farPlane;
+
+   ThreadPool& pool = ThreadPool::GLOBAL();
+
+   if( smParallelCullThreshold && numObjects >= smParallelCullThreshold &&
+       numBatches > CullingChunkSize && pool.getNumThreads() > 0 )
+   {
+      CullingJob job;
+      job.state = this;
+      job.planes = planes;
+      job.batches = batches;
+
+      pool.parallelFor( numBatches, CullingChunkSize, &testCullingJob, &job );
+   }
+   else
+      testCullingBatches( this, planes, batches, 0, numBatches );
+
+   // Read back the results.
+
+   for( U32 n = 0; n < numBatches; ++ n )
+   {
+      const CullingBatch& batch = batches[ n ];
+      for( U32 lane = 0; lane < batch.numObjects; ++ lane )
+         states[ batch.objects[ lane ] ] = ( batch.lanes & ( U32( 1 ) << lane ) ) ? ObjectPassedPlanes : ObjectCulled;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneCullingState::_addTerrainOccluders() const
+{
+   PROFILE_SCOPE( SceneCullingState_addTerrainOccluders );
+
+   // Everything below the surface of a terrain is hidden from a camera
+   // above it.  Approximate that space with a coarse grid of squares at
+   // the lowest height within each of them, joined by walls between
+   // neighboring squares.
+
+   const Vector< SceneObject* >& terrains = getSceneManager()->getContainer()->getTerrains();
+   const U32 numTerrains = terrains.size();
+
+   for( U32 terrainIdx = 0; terrainIdx < numTerrains; ++ terrainIdx )
+   {
+      TerrainBlock* terrain = dynamic_cast< TerrainBlock* >( terrains[ terrainIdx ] );
+      if( !terrain )
+         continue;
+
+      Resource< TerrainFile > file = terrain->getFile();
+      if( !file )
+         continue;
+
+      // Holes let the view through the surface.
+
+      const U32 blockSize = terrain->getBlockSize();
+      const U32 numLevels = getBinLog2( blockSize );
+
+      if( file->findSquare( numLevels, 0, 0 )->flags & ( TerrainSquare::Empty | TerrainSquare::HasEmpty ) )
+         continue;
+
+      // The camera must be above the surface and within the bounds of the
+      // terrain or it may see past the edges of the terrain.
+
+      Point3F localCamPos = getCameraState().getViewPosition();
+      terrain->getWorldTransform().mulP( localCamPos );
+
+      F32 height;
+      if( !terrain->getHeight( Point2F( localCamPos.x, localCamPos.y ), &height ) || height > localCamPos.z )
+         continue;
+
+      // Use at most 32 by 32 squares.
+
+      const U32 level = ( numLevels > 5 ) ? numLevels - 5 : 0;
+      const U32 numSquares = blockSize >> level;
+      const F32 squareSize = terrain->getSquareSize() * F32( 1 << level );
+      const MatrixF& transform = terrain->getTransform();
+
+      for( U32 y = 0; y < numSquares; ++ y )
+         for( U32 x = 0; x < numSquares; ++ x )
+         {
+            const F32 minX = F32( x ) * squareSize;
+            const F32 maxX = minX + squareSize;
+            const F32 minY = F32( y ) * squareSize;
+            const F32 maxY = minY + squareSize;
+            const F32 z = fixedToFloat( file->findSquare( level, x << level, y << level )->minHeight );
+
+            Point3F points[ 4 ];
+
+            points[ 0 ].set( minX, minY, z );
+            points[ 1 ].set( maxX, minY, z );
+            points[ 2 ].set( maxX, maxY, z );
+            points[ 3 ].set( minX, maxY, z );
+
+            for( U32 i = 0; i < 4; ++ i )
+               transform.mulP( points[ i ] );
+            mOcclusionBuffer->addPolygon( points, 4 );
+
+            // Walls towards the neighbors in x and y.
+
+            if( x + 1 < numSquares )
+            {
+               const F32 neighborZ = fixedToFloat( file->findSquare( level, ( x + 1 ) << level, y << level )->minHeight );
+               if( neighborZ != z )
+               {
+                  points[ 0 ].set( maxX, minY, z );
+                  points[ 1 ].set( maxX, maxY, z );
+                  points[ 2 ].set( maxX, maxY, neighborZ );
+                  points[ 3 ].set( maxX, minY, neighborZ );
+
+                  for( U32 i = 0; i < 4; ++ i )
+                     transform.mulP( points[ i ] );
+                  mOcclusionBuffer->addPolygon( points, 4 );
+               }
+            }
+
+            if( y + 1 < numSquares )
+            {
+               const F32 neighborZ = fixedToFloat( file->findSquare( level, x << level, ( y + 1 ) << level )->minHeight );
+               if( neighborZ != z )
+               {
+                  points[ 0 ].set( minX, maxY, z );
+                  points[ 1 ].set( maxX, maxY, z );
+                  points[ 2 ].set( maxX, maxY, neighborZ );
+                  points[ 3 ].set( minX, maxY, neighborZ );
+
+                  for( U32 i = 0; i < 4; ++ i )
+                     transform.mulP( points[ i ] );
+                  mOcclusionBuffer->addPolygon( points, 4 );
+               }
+            }
+         }
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneCullingState::_addOccluderMeshes( SceneObject** objects, U32 numObjects, const U8* states ) const
+{
+   PROFILE_SCOPE( SceneCullingState_addOccluderMeshes );
+
+   const Frustum& frustum = getFrustum();
+   const F32 minWidth = smOccluderMinWidthPercentage * F32( SceneOcclusionBuffer::Width );
+   const F32 minHeight = smOccluderMinHeightPercentage * F32( SceneOcclusionBuffer::Height );
+
+   Vector< Point3F > triangles;
+
+   for( U32 i = 0; i < numObjects; ++ i )
+   {
+      if( states[ i ] != ObjectTestFrustum && states[ i ] != ObjectTestZones )
+         continue;
+
+      SceneObject* object = objects[ i ];
+      if( !( object->getTypeMask() & StaticObjectType ) || object->isGlobalBounds() )
+         continue;
+
+      // Only take occluders that cover enough of the screen to be worth
+      // rasterizing.  Objects reaching up to the near plane are taken as
+      // they are likely to cover a lot of it.
+
+      const Box3F& worldBox = object->getWorldBox();
+
+      RectF rect;
+      F32 invDepth;
+      if( mOcclusionBuffer->projectBox( worldBox, rect, invDepth ) &&
+          ( rect.extent.x < minWidth || rect.extent.y < minHeight ) )
+         continue;
+
+      if( frustum.isCulled( worldBox ) )
+         continue;
+
+      triangles.clear();
+      object->buildOcclusionMesh( triangles );
+
+      if( triangles.size() >= 3 )
+         mOcclusionBuffer->addTriangles( triangles.address(), triangles.size() / 3 );
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneCullingState::_testOcclusion( SceneObject** objects, U32 numObjects, U8* states ) const
+{
+   PROFILE_SCOPE( SceneCullingState_testOcclusion );
+
+   mOcclusionBuffer->finishRasterize();
+   if( !mOcclusionBuffer->getNumTriangles() )
+      return;
+
+   for( U32 i = 0; i < numObjects; ++ i )
+      if( states[ i ] == ObjectPassedPlanes &&
+          mOcclusionBuffer->isOccluded( objects[ i ]->getWorldBox() ) )
+         states[ i ] = ObjectCulled;
 }
 
 //-----------------------------------------------------------------------------
@@ -931,4 +1368,7 @@ void SceneCullingState::debugRenderCullingVolumes() const
             drawer->drawPolyhedron( polyhedron, iter->isOccluder() ? occluderColor : includerColor );
       }
    }
+
+   if( mOcclusionBuffer )
+      mOcclusionBuffer->debugRender();
 }
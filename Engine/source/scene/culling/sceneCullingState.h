@@ -47,6 +47,10 @@
 #include "core/bitVector.h"
 #endif
 
+#ifndef _SCENEOCCLUSIONBUFFER_H_
+#include "scene/culling/sceneOcclusionBuffer.h"
+#endif
+
 
 class SceneObject;
 class SceneManager;
@@ -64,6 +68,14 @@ class SceneCullingState
       /// Whether to force zone culling to off by default.
       static bool smDisableZoneCulling;
 
+      /// Used to disable culling against the occlusion buffer.
+      static bool smDisableOcclusionBuffer;
+
+      /// Number of objects from which on cullObjects() spreads the plane tests
+      /// over the threads of the global thread pool.  0 keeps culling on the
+      /// calling thread.
+      static U32 smParallelCullThreshold;
+
       /// @name Occluder Restrictions
       /// Size restrictions on occlusion culling volumes.  Any occlusion volume
       /// that does not meet these minimum requirements is not accepted into the
@@ -126,6 +138,10 @@ class SceneCullingState
       /// frustum.
       bool mDisableZoneCulling;
 
+      /// Depth buffer that occluders are rasterized into, or NULL if the
+      /// occlusion buffer is disabled or the frustum is orthographic.
+      ThreadSafeRef< SceneOcclusionBuffer > mOcclusionBuffer;
+
    public:
 
       ///
@@ -163,6 +179,17 @@ class SceneCullingState
 
       /// Cull the given list of objects according to the current culling state.
       ///
+      /// The world boxes of the objects that need plane tests are gathered into
+      /// SceneCullingBoxBatch batches, grouped by the zone they are tested in, and
+      /// tested a batch at a time.  Terrain occlusion is only tested for the
+      /// objects that pass the plane tests.
+      ///
+      /// The first list of at least SceneCullingBoxBatch::Size objects also fills
+      /// the occlusion buffer with the terrains and with the occlusion meshes of
+      /// static objects in the list that cover enough of the screen.  The buffer
+      /// is rasterized on the thread pool while the plane tests run, and objects
+      /// that pass the plane tests are then tested against it.
+      ///
       /// @param object Array of objects.  This array will be modified in place.
       /// @param numObjects Number of objects in @a objects.
       /// @param cullOptions Combination of CullOptions.
@@ -207,6 +234,10 @@ class SceneCullingState
       /// Set whether isCulled() should do terrain occlusion checks or not.
       void setDisableTerrainOcclusion( bool value ) { mDisableTerrainOcclusion = value; }
 
+      /// Return the occlusion buffer of this culling state or NULL if it
+      /// doesn't have one.
+      SceneOcclusionBuffer* getOcclusionBuffer() const { return mOcclusionBuffer; }
+
       /// @}
 
       /// @name Zones
@@ -292,13 +323,60 @@ class SceneCullingState
       /// @}
 
       /// Queue debug visualizations of the culling volumes of all currently selected zones
-      /// (or, if no zone is selected, all volumes in the outdoor zone) to the debug drawer.
+      /// (or, if no zone is selected, all volumes in the outdoor zone) and of the tiles of
+      /// the occlusion buffer to the debug drawer.
       void debugRenderCullingVolumes() const;
 
    private:
 
       typedef SceneZoneCullingState::CullingTestResult CullingTestResult;
 
+      /// What cullObjects() has found out about an object so far.
+      enum ObjectCullState
+      {
+         /// The object is culled.
+         ObjectCulled,
+
+         /// The object is visible.
+         ObjectVisible,
+
+         /// The object has to be tested against the root frustum.
+         ObjectTestFrustum,
+
+         /// The object has to be tested against the culling volumes of its zones.
+         ObjectTestZones,
+
+         /// The object passed the plane tests but may still be occluded by terrain
+         /// or by what is in the occlusion buffer.
+         ObjectPassedPlanes,
+      };
+
+      /// Decide how cullObjects() has to test the given object.
+      ObjectCullState _classifyObject( SceneObject* object, U32 cullOptions ) const;
+
+      /// Test a single object that needs plane tests against the root frustum
+      /// or the volumes of its zones.
+      ObjectCullState _testObject( SceneObject* object, ObjectCullState state, const PlaneF& nearPlane, const PlaneF& farPlane ) const;
+
+      /// Test the objects that need plane tests in batches and update their
+      /// states.
+      void _testObjectsBatched( SceneObject** objects, U32 numObjects, U8* states, const PlaneF& nearPlane, const PlaneF& farPlane ) const;
+
+      /// Remove the objects that are culled from the list, testing the ones
+      /// that passed the plane tests for terrain occlusion.
+      U32 _removeCulledObjects( SceneObject** objects, U32 numObjects, const U8* states ) const;
+
+      /// Add the areas below the surfaces of the terrains to the occlusion buffer.
+      void _addTerrainOccluders() const;
+
+      /// Add the occlusion meshes of the static objects that still need plane
+      /// tests and cover enough of the screen to the occlusion buffer.
+      void _addOccluderMeshes( SceneObject** objects, U32 numObjects, const U8* states ) const;
+
+      /// Cull the objects that passed the plane tests but are hidden in the
+      /// occlusion buffer.
+      void _testOcclusion( SceneObject** objects, U32 numObjects, U8* states ) const;
+
       // Helper methods to avoid code duplication.
 
       template< bool OCCLUDERS_ONLY, typename T > CullingTestResult _test( const T& bounds, const U32* zones, U32 numZones ) const;
@@ -27,6 +27,10 @@
 #include "math/mPlaneSet.h"
 #endif
 
+#ifndef _SCENECULLINGBOXBATCH_H_
+#include "scene/culling/sceneCullingBoxBatch.h"
+#endif
+
 
 /// A volume used to include or exclude space in a scene.
 ///
@@ -124,6 +128,17 @@ class SceneCullingVolume
       /// Return true if the volume accepts the given sphere.
       bool test( const SphereF& sphere ) const { return _testBounds( sphere ); }
 
+      /// Return the mask of the boxes among @a lanes of @a batch that the
+      /// volume accepts.
+      U32 test( const SceneCullingBoxBatch& batch, U32 lanes ) const
+      {
+         const PlaneSetF& planes = getPlanes();
+         if( isOccluder() )
+            return batch.testContained( planes.getPlanes(), planes.getNumPlanes(), lanes );
+         else
+            return lanes & ~batch.testOutside( planes.getPlanes(), planes.getNumPlanes(), lanes );
+      }
+
       /// @}
 };
 
@@ -0,0 +1,539 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/culling/sceneOcclusionBuffer.h"
+
+#include "math/util/frustum.h"
+#include "math/mBox.h"
+#include "platform/threads/threadPool.h"
+#include "platform/profiler.h"
+#include "gfx/sim/debugDraw.h"
+
+// Rasterize four pixels at a time with SSE where the compiler targets it,
+// and one at a time otherwise.
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#  define TORQUE_OCCLUSION_SSE
+#  include <xmmintrin.h>
+#endif
+
+
+namespace {
+
+   /// An edge function of a triangle in pixel space.  It is positive on the
+   /// inner side of the edge.
+   struct TriangleEdge
+   {
+      F32 a;
+      F32 b;
+      F32 c;
+
+      void set( const Point3F& from, const Point3F& to )
+      {
+         a = from.y - to.y;
+         b = to.x - from.x;
+         c = from.x * to.y - from.y * to.x;
+      }
+
+      F32 eval( F32 x, F32 y ) const { return a * x + b * y + c; }
+   };
+}
+
+//-----------------------------------------------------------------------------
+
+SceneOcclusionBuffer::SceneOcclusionBuffer( const Frustum& frustum )
+   : mState( StateOpen ),
+     mViewToWorld( frustum.getTransform() ),
+     mNearDist( frustum.getNearDist() )
+{
+   AssertFatal( !frustum.isOrtho(), "SceneOcclusionBuffer::SceneOcclusionBuffer - Orthographic frustums are not supported" );
+
+   VECTOR_SET_ASSOCIATION( mTriangles );
+   VECTOR_SET_ASSOCIATION( mDepth );
+
+   mWorldToView = mViewToWorld;
+   mWorldToView.inverse();
+
+   // Map the near plane rectangle onto the buffer with the top edge at
+   // row 0.
+
+   const F32 nearWidth = frustum.getNearRight() - frustum.getNearLeft();
+   const F32 nearHeight = frustum.getNearTop() - frustum.getNearBottom();
+
+   mScaleX = mNearDist * F32( Width ) / nearWidth;
+   mOffsetX = - frustum.getNearLeft() * F32( Width ) / nearWidth;
+   mScaleY = - mNearDist * F32( Height ) / nearHeight;
+   mOffsetY = frustum.getNearTop() * F32( Height ) / nearHeight;
+
+   dMemset( mTileDepth, 0, sizeof( mTileDepth ) );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::addTriangles( const Point3F* points, U32 numTriangles )
+{
+   if( !isOpen() )
+      return;
+
+   const U32 numPoints = numTriangles * 3;
+   const U32 first = mTriangles.size();
+
+   mTriangles.setSize( first + numPoints );
+   dMemcpy( &mTriangles[ first ], points, numPoints * sizeof( Point3F ) );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::addPolygon( const Point3F* points, U32 numPoints )
+{
+   if( !isOpen() || numPoints < 3 )
+      return;
+
+   for( U32 i = 2; i < numPoints; ++ i )
+   {
+      mTriangles.push_back( points[ 0 ] );
+      mTriangles.push_back( points[ i - 1 ] );
+      mTriangles.push_back( points[ i ] );
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+SceneOcclusionBuffer::~SceneOcclusionBuffer()
+{
+   // Make sure no worker is still on it.
+   if( mRasterizeLoop != NULL )
+      mRasterizeLoop->cancel();
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::_rasterizeLoop( U32 begin, U32 end, void* data )
+{
+   SceneOcclusionBuffer* buffer = reinterpret_cast< SceneOcclusionBuffer* >( data );
+   buffer->_rasterize();
+   dCompareAndSwap( buffer->mState, StateRasterizing, StateDone );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::rasterize()
+{
+   AssertFatal( isOpen(), "SceneOcclusionBuffer::rasterize - Buffer has already been rasterized" );
+
+   mState = StateRasterizing;
+   _rasterizeLoop( 0, 1, this );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::beginRasterize()
+{
+   if( !dCompareAndSwap( mState, StateOpen, StateRasterizing ) )
+      return;
+
+   mRasterizeLoop = new ThreadPool::ParallelLoop( 1, 1, &_rasterizeLoop, this );
+   mRasterizeLoop->start( ThreadPool::GLOBAL() );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::finishRasterize()
+{
+   if( isOpen() )
+   {
+      rasterize();
+      return;
+   }
+
+   // Rasterizes the buffer here if no worker has started on it yet.
+   if( mRasterizeLoop != NULL )
+   {
+      mRasterizeLoop->wait();
+      mRasterizeLoop = NULL;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::_rasterize()
+{
+   PROFILE_SCOPE( SceneOcclusionBuffer_rasterize );
+
+   mDepth.setSize( Width * Height );
+   dMemset( mDepth.address(), 0, mDepth.memSize() );
+
+   const U32 numPoints = mTriangles.size();
+   for( U32 i = 0; i + 2 < numPoints; i += 3 )
+   {
+      Point3F points[ 3 ];
+
+      mWorldToView.mulP( mTriangles[ i ], &points[ 0 ] );
+      mWorldToView.mulP( mTriangles[ i + 1 ], &points[ 1 ] );
+      mWorldToView.mulP( mTriangles[ i + 2 ], &points[ 2 ] );
+
+      _clipAndRasterizeTriangle( points );
+   }
+
+   _updateTiles();
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::_clipAndRasterizeTriangle( const Point3F* points )
+{
+   // Clip against the near plane.  This leaves at most four points.
+
+   Point3F clipped[ 4 ];
+   U32 numClipped = 0;
+
+   for( U32 i = 0; i < 3; ++ i )
+   {
+      const Point3F& from = points[ i ];
+      const Point3F& to = points[ ( i + 1 ) % 3 ];
+
+      const bool fromInside = ( from.y >= mNearDist );
+      const bool toInside = ( to.y >= mNearDist );
+
+      if( fromInside )
+         clipped[ numClipped ++ ] = from;
+
+      if( fromInside != toInside )
+      {
+         const F32 t = ( mNearDist - from.y ) / ( to.y - from.y );
+         Point3F& point = clipped[ numClipped ++ ];
+         point = from + ( to - from ) * t;
+         point.y = mNearDist;
+      }
+   }
+
+   if( numClipped < 3 )
+      return;
+
+   // Project to pixels with the reciprocal depth in z.
+
+   for( U32 i = 0; i < numClipped; ++ i )
+   {
+      Point3F& point = clipped[ i ];
+      const F32 invDepth = 1.f / point.y;
+
+      point.set( point.x * invDepth * mScaleX + mOffsetX,
+                 point.z * invDepth * mScaleY + mOffsetY,
+                 invDepth );
+   }
+
+   _rasterizeTriangle( clipped[ 0 ], clipped[ 1 ], clipped[ 2 ] );
+   if( numClipped == 4 )
+      _rasterizeTriangle( clipped[ 0 ], clipped[ 2 ], clipped[ 3 ] );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::_rasterizeTriangle( const Point3F& v0, const Point3F& in1, const Point3F& in2 )
+{
+   // Wind the triangle so that its inside is on the positive side of
+   // its edges.
+
+   F32 area = ( in1.x - v0.x ) * ( in2.y - v0.y ) - ( in2.x - v0.x ) * ( in1.y - v0.y );
+   if( mFabs( area ) < 0.0001f )
+      return;
+
+   const bool flip = ( area < 0.f );
+   const Point3F& v1 = flip ? in2 : in1;
+   const Point3F& v2 = flip ? in1 : in2;
+   area = mFabs( area );
+
+   // Find the pixels the triangle may cover.
+
+   const F32 left = getMax( getMin( v0.x, getMin( v1.x, v2.x ) ), 0.f );
+   const F32 right = getMin( getMax( v0.x, getMax( v1.x, v2.x ) ), F32( Width - 1 ) );
+   const F32 top = getMax( getMin( v0.y, getMin( v1.y, v2.y ) ), 0.f );
+   const F32 bottom = getMin( getMax( v0.y, getMax( v1.y, v2.y ) ), F32( Height - 1 ) );
+
+   if( left > right || top > bottom )
+      return;
+
+   const S32 minX = S32( left );
+   const S32 maxX = S32( right );
+   const S32 minY = S32( top );
+   const S32 maxY = S32( bottom );
+
+   TriangleEdge edges[ 3 ];
+   edges[ 0 ].set( v0, v1 );
+   edges[ 1 ].set( v1, v2 );
+   edges[ 2 ].set( v2, v0 );
+
+   // Set up the reciprocal depth as a plane over the pixels and lower it
+   // by the most it changes across half a pixel, so that each pixel gets
+   // the farthest depth the triangle has over it.
+
+   const F32 dw1 = v1.z - v0.z;
+   const F32 dw2 = v2.z - v0.z;
+
+   const F32 depthA = ( dw1 * ( v2.y - v0.y ) - dw2 * ( v1.y - v0.y ) ) / area;
+   const F32 depthB = ( dw2 * ( v1.x - v0.x ) - dw1 * ( v2.x - v0.x ) ) / area;
+   const F32 depthC = v0.z - depthA * v0.x - depthB * v0.y - 0.5f * ( mFabs( depthA ) + mFabs( depthB ) );
+
+#ifdef TORQUE_OCCLUSION_SSE
+
+   // Walk the rows in groups of four pixels starting on a multiple of four.
+   // Since the width is a multiple of four, groups never cross rows.
+
+   const S32 startX = minX & ~3;
+   const F32 startCenterX = F32( startX ) + 0.5f;
+
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 laneOffsets = _mm_set_ps( 3.f, 2.f, 1.f, 0.f );
+
+   const __m128 edge0Lanes = _mm_mul_ps( _mm_set1_ps( edges[ 0 ].a ), laneOffsets );
+   const __m128 edge1Lanes = _mm_mul_ps( _mm_set1_ps( edges[ 1 ].a ), laneOffsets );
+   const __m128 edge2Lanes = _mm_mul_ps( _mm_set1_ps( edges[ 2 ].a ), laneOffsets );
+   const __m128 depthLanes = _mm_mul_ps( _mm_set1_ps( depthA ), laneOffsets );
+
+   const __m128 edge0Step = _mm_set1_ps( edges[ 0 ].a * 4.f );
+   const __m128 edge1Step = _mm_set1_ps( edges[ 1 ].a * 4.f );
+   const __m128 edge2Step = _mm_set1_ps( edges[ 2 ].a * 4.f );
+   const __m128 depthStep = _mm_set1_ps( depthA * 4.f );
+
+   for( S32 y = minY; y <= maxY; ++ y )
+   {
+      const F32 centerY = F32( y ) + 0.5f;
+      F32* row = &mDepth[ y * Width ];
+
+      __m128 edge0 = _mm_add_ps( _mm_set1_ps( edges[ 0 ].eval( startCenterX, centerY ) ), edge0Lanes );
+      __m128 edge1 = _mm_add_ps( _mm_set1_ps( edges[ 1 ].eval( startCenterX, centerY ) ), edge1Lanes );
+      __m128 edge2 = _mm_add_ps( _mm_set1_ps( edges[ 2 ].eval( startCenterX, centerY ) ), edge2Lanes );
+      __m128 depth = _mm_add_ps( _mm_set1_ps( depthA * startCenterX + depthB * centerY + depthC ), depthLanes );
+
+      for( S32 x = startX; x <= maxX; x += 4 )
+      {
+         const __m128 inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( edge0, zero ),
+                                                       _mm_cmpge_ps( edge1, zero ) ),
+                                           _mm_cmpge_ps( edge2, zero ) );
+
+         // Pixels outside get a depth of zero, which never wins.
+
+         if( _mm_movemask_ps( inside ) )
+            _mm_storeu_ps( row + x, _mm_max_ps( _mm_loadu_ps( row + x ), _mm_and_ps( inside, depth ) ) );
+
+         edge0 = _mm_add_ps( edge0, edge0Step );
+         edge1 = _mm_add_ps( edge1, edge1Step );
+         edge2 = _mm_add_ps( edge2, edge2Step );
+         depth = _mm_add_ps( depth, depthStep );
+      }
+   }
+
+#else
+
+   for( S32 y = minY; y <= maxY; ++ y )
+   {
+      const F32 centerY = F32( y ) + 0.5f;
+      F32* row = &mDepth[ y * Width ];
+
+      for( S32 x = minX; x <= maxX; ++ x )
+      {
+         const F32 centerX = F32( x ) + 0.5f;
+
+         if( edges[ 0 ].eval( centerX, centerY ) >= 0.f &&
+             edges[ 1 ].eval( centerX, centerY ) >= 0.f &&
+             edges[ 2 ].eval( centerX, centerY ) >= 0.f )
+            row[ x ] = getMax( row[ x ], depthA * centerX + depthB * centerY + depthC );
+      }
+   }
+
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::_updateTiles()
+{
+   for( U32 tileY = 0; tileY < TilesY; ++ tileY )
+      for( U32 tileX = 0; tileX < TilesX; ++ tileX )
+      {
+         const F32* pixels = &mDepth[ tileX * TileSize + tileY * TileSize * Width ];
+
+         F32 farthest = pixels[ 0 ];
+         for( U32 y = 0; y < TileSize; ++ y, pixels += Width )
+            for( U32 x = 0; x < TileSize; ++ x )
+               farthest = getMin( farthest, pixels[ x ] );
+
+         mTileDepth[ tileX + tileY * TilesX ] = farthest;
+      }
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneOcclusionBuffer::projectBox( const Box3F& box, RectF& outRect, F32& outNearestInvDepth ) const
+{
+   // Find the view space bounds of the box.
+
+   const Point3F center = box.getCenter();
+   const Point3F halfExtents = box.getExtents() * 0.5f;
+
+   Point3F viewCenter;
+   mWorldToView.mulP( center, &viewCenter );
+
+   Point3F viewHalfExtents;
+   for( U32 i = 0; i < 3; ++ i )
+      viewHalfExtents[ i ] = mFabs( mWorldToView( i, 0 ) ) * halfExtents.x +
+                             mFabs( mWorldToView( i, 1 ) ) * halfExtents.y +
+                             mFabs( mWorldToView( i, 2 ) ) * halfExtents.z;
+
+   const F32 nearest = viewCenter.y - viewHalfExtents.y;
+   if( nearest <= mNearDist )
+      return false;
+
+   const F32 farthest = viewCenter.y + viewHalfExtents.y;
+
+   // The extremes of x/y and z/y over the bounds are at their corners.
+
+   const F32 minX = viewCenter.x - viewHalfExtents.x;
+   const F32 maxX = viewCenter.x + viewHalfExtents.x;
+   const F32 minZ = viewCenter.z - viewHalfExtents.z;
+   const F32 maxZ = viewCenter.z + viewHalfExtents.z;
+
+   const F32 minRatioX = minX / ( minX < 0.f ? nearest : farthest );
+   const F32 maxRatioX = maxX / ( maxX > 0.f ? nearest : farthest );
+   const F32 minRatioZ = minZ / ( minZ < 0.f ? nearest : farthest );
+   const F32 maxRatioZ = maxZ / ( maxZ > 0.f ? nearest : farthest );
+
+   // Rows run downwards, so the top comes from the largest z.
+
+   const F32 left = minRatioX * mScaleX + mOffsetX;
+   const F32 right = maxRatioX * mScaleX + mOffsetX;
+   const F32 top = maxRatioZ * mScaleY + mOffsetY;
+   const F32 bottom = minRatioZ * mScaleY + mOffsetY;
+
+   outRect = RectF( left, top, right - left, bottom - top );
+   outNearestInvDepth = 1.f / nearest;
+
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneOcclusionBuffer::isOccluded( const Box3F& box ) const
+{
+   AssertFatal( isRasterized(), "SceneOcclusionBuffer::isOccluded - Buffer has not been rasterized" );
+
+   RectF rect;
+   F32 invDepth;
+   if( !projectBox( box, rect, invDepth ) )
+      return false;
+
+   // Leave boxes that are off screen to the frustum tests.
+
+   const F32 right = rect.point.x + rect.extent.x;
+   const F32 bottom = rect.point.y + rect.extent.y;
+
+   if( right < 0.f || bottom < 0.f || rect.point.x >= F32( Width ) || rect.point.y >= F32( Height ) )
+      return false;
+
+   // Every pixel the box touches, and the ring of pixels around them, must
+   // be covered by an occluder that is nearer than the box.  Tiles whose
+   // farthest occluder is nearer than the box need no further look.
+
+   const S32 minX = getMax( S32( getMax( rect.point.x, 0.f ) ) - 1, 0 );
+   const S32 maxX = getMin( S32( getMin( right, F32( Width - 1 ) ) ) + 1, S32( Width - 1 ) );
+   const S32 minY = getMax( S32( getMax( rect.point.y, 0.f ) ) - 1, 0 );
+   const S32 maxY = getMin( S32( getMin( bottom, F32( Height - 1 ) ) ) + 1, S32( Height - 1 ) );
+
+   for( S32 tileY = minY / TileSize; tileY <= maxY / TileSize; ++ tileY )
+      for( S32 tileX = minX / TileSize; tileX <= maxX / TileSize; ++ tileX )
+      {
+         if( mTileDepth[ tileX + tileY * TilesX ] > invDepth )
+            continue;
+
+         const S32 fromX = getMax( minX, tileX * TileSize );
+         const S32 toX = getMin( maxX, tileX * TileSize + TileSize - 1 );
+         const S32 fromY = getMax( minY, tileY * TileSize );
+         const S32 toY = getMin( maxY, tileY * TileSize + TileSize - 1 );
+
+         for( S32 y = fromY; y <= toY; ++ y )
+         {
+            const F32* row = &mDepth[ y * Width ];
+            for( S32 x = fromX; x <= toX; ++ x )
+               if( row[ x ] <= invDepth )
+                  return false;
+         }
+      }
+
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneOcclusionBuffer::debugRender() const
+{
+   if( !isRasterized() )
+      return;
+
+   const ColorF nearColor( 1.f, 1.f, 0.f );
+   const ColorF farColor( 0.f, 0.f, 1.f );
+
+   DebugDrawer* drawer = DebugDrawer::get();
+
+   // Find the depth range of the covered tiles to color them by.
+
+   F32 nearestDepth = F32_MAX;
+   F32 farthestDepth = 0.f;
+   for( U32 i = 0; i < TilesX * TilesY; ++ i )
+      if( mTileDepth[ i ] > 0.f )
+      {
+         nearestDepth = getMin( nearestDepth, 1.f / mTileDepth[ i ] );
+         farthestDepth = getMax( farthestDepth, 1.f / mTileDepth[ i ] );
+      }
+
+   for( U32 tileY = 0; tileY < TilesY; ++ tileY )
+      for( U32 tileX = 0; tileX < TilesX; ++ tileX )
+      {
+         const F32 invDepth = mTileDepth[ tileX + tileY * TilesX ];
+         if( invDepth <= 0.f )
+            continue;
+
+         // Put the corners of the tile back into the world at the
+         // tile's depth.
+
+         const F32 depth = 1.f / invDepth;
+         Point3F corners[ 4 ];
+
+         for( U32 i = 0; i < 4; ++ i )
+         {
+            const F32 x = F32( ( tileX + ( ( i == 1 || i == 2 ) ? 1 : 0 ) ) * TileSize );
+            const F32 y = F32( ( tileY + ( i >= 2 ? 1 : 0 ) ) * TileSize );
+
+            const Point3F viewPoint( ( x - mOffsetX ) / mScaleX * depth,
+                                     depth,
+                                     ( y - mOffsetY ) / mScaleY * depth );
+
+            mViewToWorld.mulP( viewPoint, &corners[ i ] );
+         }
+
+         const F32 t = ( farthestDepth > nearestDepth ) ? ( depth - nearestDepth ) / ( farthestDepth - nearestDepth ) : 0.f;
+         ColorF color;
+         color.interpolate( nearColor, farColor, t );
+
+         for( U32 i = 0; i < 4; ++ i )
+            drawer->drawLine( corners[ i ], corners[ ( i + 1 ) % 4 ], color );
+      }
+}
@@ -0,0 +1,231 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _SCENEOCCLUSIONBUFFER_H_
+#define _SCENEOCCLUSIONBUFFER_H_
+
+#ifndef _THREADPOOL_H_
+#include "platform/threads/threadPool.h"
+#endif
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+#ifndef _MMATRIX_H_
+#include "math/mMatrix.h"
+#endif
+
+#ifndef _MRECT_H_
+#include "math/mRect.h"
+#endif
+
+
+class Frustum;
+class Box3F;
+
+
+/// A low-resolution depth buffer that occluders are rasterized into on the
+/// CPU so that objects hidden behind them can be culled.
+///
+/// The buffer stores the reciprocal of the view depth, which interpolates
+/// linearly across the screen, with 0 meaning nothing has been drawn.
+/// A pixel is written if a triangle covers its center, and then with the
+/// farthest depth the triangle's plane has over the pixel.  Testing only
+/// accepts an object as occluded if the pixels around its screen rectangle
+/// are covered as well, so that objects peeking out from behind the edge of
+/// an occluder by less than a pixel aren't culled.  Testing centers rather
+/// than requiring full coverage keeps the pixels along the shared edges of
+/// an occluder mesh's triangles covered.
+///
+/// Rows of pixels are rasterized four at a time using SSE where available.
+/// After rasterization, the buffer keeps the farthest depth of each tile of
+/// #TileSize by #TileSize pixels so that isOccluded() can skip over whole
+/// tiles that are covered by occluders nearer than the object being tested.
+///
+/// Occluders are added on the main thread.  The buffer can then be
+/// rasterized on a worker thread while the main thread does other work;
+/// occluders added after rasterization has started are ignored.  Only
+/// perspective frustums are supported.
+class SceneOcclusionBuffer : public ThreadSafeRefCount< SceneOcclusionBuffer >
+{
+   public:
+
+      enum
+      {
+         /// Width of the buffer in pixels.  Must be a multiple of 4.
+         Width = 256,
+
+         /// Height of the buffer in pixels.
+         Height = 128,
+
+         /// Width and height of the tiles that the farthest depths are kept for.
+         TileSize = 8,
+
+         TilesX = Width / TileSize,
+         TilesY = Height / TileSize,
+      };
+
+   protected:
+
+      enum RasterizeState
+      {
+         /// Occluders can still be added.
+         StateOpen,
+
+         /// Rasterization has been queued or is running.
+         StateRasterizing,
+
+         /// The buffer is ready for testing.
+         StateDone,
+      };
+
+      /// Where the buffer is in its lifetime.  See RasterizeState.
+      mutable volatile U32 mState;
+
+      /// Rasterization queued by beginRasterize() until finishRasterize().
+      ThreadSafeRef< ThreadPool::ParallelLoop > mRasterizeLoop;
+
+      /// Transform from world space to view space.
+      MatrixF mWorldToView;
+
+      /// Transform from view space to world space.
+      MatrixF mViewToWorld;
+
+      /// Distance of the near plane.  Triangles are clipped against it.
+      F32 mNearDist;
+
+      /// @name Projection
+      /// A view space point at @a x, @a y, @a z ends up at pixel
+      /// ( x / y * mScaleX + mOffsetX, z / y * mScaleY + mOffsetY ).
+      /// @{
+
+      F32 mScaleX;
+      F32 mOffsetX;
+      F32 mScaleY;
+      F32 mOffsetY;
+
+      /// @}
+
+      /// World space occluder triangles, three points per triangle.
+      Vector< Point3F > mTriangles;
+
+      /// Reciprocal depth of every pixel, row by row.
+      Vector< F32 > mDepth;
+
+      /// Farthest reciprocal depth of every tile.
+      F32 mTileDepth[ TilesX * TilesY ];
+
+      /// Rasterize a triangle that has already been clipped against the
+      /// near plane.  The points are in pixels with the reciprocal depth in z.
+      void _rasterizeTriangle( const Point3F& v0, const Point3F& v1, const Point3F& v2 );
+
+      /// Clip a view space triangle against the near plane and rasterize
+      /// what is left of it.
+      void _clipAndRasterizeTriangle( const Point3F* points );
+
+      /// Fill in #mTileDepth from #mDepth.
+      void _updateTiles();
+
+      /// Rasterize all occluders and fill in the tiles.
+      void _rasterize();
+
+      /// Rasterize the buffer in @a data and mark it done.  Runs as a
+      /// ThreadPool::ParallelLoop of a single index.
+      static void _rasterizeLoop( U32 begin, U32 end, void* data );
+
+   public:
+
+      /// Create an empty buffer for the view of the given perspective
+      /// frustum.
+      SceneOcclusionBuffer( const Frustum& frustum );
+
+      ~SceneOcclusionBuffer();
+
+      /// Return true if occluders can still be added to the buffer.
+      bool isOpen() const { return ( dAtomicRead( mState ) == StateOpen ); }
+
+      /// Return true if the buffer has been rasterized and can be tested against.
+      bool isRasterized() const { return ( dAtomicRead( mState ) == StateDone ); }
+
+      /// Return the number of occluder triangles added to the buffer.
+      U32 getNumTriangles() const { return mTriangles.size() / 3; }
+
+      /// @name Occluders
+      /// @{
+
+      /// Add world space occluder triangles, three points per triangle.
+      /// The triangles must lie within opaque geometry.
+      void addTriangles( const Point3F* points, U32 numTriangles );
+
+      /// Add a world space convex polygon as an occluder.
+      void addPolygon( const Point3F* points, U32 numPoints );
+
+      /// @}
+
+      /// @name Rasterization
+      /// @{
+
+      /// Rasterize the buffer on the calling thread.
+      void rasterize();
+
+      /// Queue rasterization of the buffer on the global thread pool.  If
+      /// the pool has no threads, rasterization is left to finishRasterize().
+      void beginRasterize();
+
+      /// Wait for the rasterization queued by beginRasterize() to finish.
+      /// If no worker thread has started on it yet, the buffer is rasterized
+      /// on the calling thread instead.
+      void finishRasterize();
+
+      /// @}
+
+      /// @name Testing
+      /// @{
+
+      /// Compute the pixel rectangle that @a box covers and the reciprocal
+      /// of its nearest view depth.
+      ///
+      /// @return False if the box reaches up to or past the near plane, in
+      ///   which case the outputs are not set.
+      bool projectBox( const Box3F& box, RectF& outRect, F32& outNearestInvDepth ) const;
+
+      /// Return true if @a box is hidden behind the occluders in the buffer.
+      /// Boxes that reach up to the near plane are never occluded.
+      ///
+      /// @note The buffer must have been rasterized.
+      bool isOccluded( const Box3F& box ) const;
+
+      /// Return the farthest reciprocal depth of the pixels in the given tile.
+      F32 getTileDepth( U32 tileX, U32 tileY ) const { return mTileDepth[ tileX + tileY * TilesX ]; }
+
+      /// Return the reciprocal depth of the given pixel.
+      F32 getDepth( U32 x, U32 y ) const { return mDepth[ x + y * Width ]; }
+
+      /// @}
+
+      /// Queue the outlines of all tiles that are covered by occluders to the
+      /// debug drawer, at the farthest depth of each tile.
+      void debugRender() const;
+};
+
+#endif // !_SCENEOCCLUSIONBUFFER_H_
@@ -97,6 +97,31 @@ SceneZoneCullingState::CullingTestResult SceneZoneCullingState::testVolumes( con
 
 //-----------------------------------------------------------------------------
 
+U32 SceneZoneCullingState::testVolumes( const SceneCullingBoxBatch& batch, U32 lanes ) const
+{
+   if( !mHaveSortedVolumes )
+      _sortVolumes();
+
+   // Same as _testVolumes() but for all boxes at once.  Each box drops out
+   // at the first volume that accepts it.
+
+   U32 included = 0;
+   for( CullingVolumeLink* link = mCullingVolumes; link != NULL && lanes != 0; link = link->mNext )
+   {
+      const SceneCullingVolume& volume = link->mVolume;
+      const U32 accepted = volume.test( batch, lanes );
+
+      if( !volume.isOccluder() )
+         included |= accepted;
+
+      lanes &= ~accepted;
+   }
+
+   return included;
+}
+
+//-----------------------------------------------------------------------------
+
 void SceneZoneCullingState::_sortVolumes() const
 {
    // First do a pass to gather all occlusion volumes.  These must be put on the
@@ -158,6 +158,14 @@ class SceneZoneCullingState
       /// given sphere, i.e. whether they include or exclude the given sphere.
       CullingTestResult testVolumes( const SphereF& sphere, bool occludersOnly = false ) const;
 
+      /// Test the boxes among @a lanes of @a batch against the culling volumes
+      /// added to the zone.
+      ///
+      /// @return The mask of the boxes that tested CullingTestPositiveByInclusion.
+      ///   All other boxes tested CullingTestPositiveByOcclusion or
+      ///   CullingTestNegative.
+      U32 testVolumes( const SceneCullingBoxBatch& batch, U32 lanes ) const;
+
       /// Return true if the zone has more than one culling volume assigned to it.
       bool hasMultipleVolumes() const { return ( mCullingVolumes && mCullingVolumes->mNext ); }
 
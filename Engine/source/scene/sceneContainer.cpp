@@ -26,7 +26,9 @@
 #include "collision/extrudedPolyList.h"
 #include "collision/earlyOutPolyList.h"
 #include "scene/sceneObject.h"
+#include "scene/sceneContainerAABBTree.h"
 #include "platform/profiler.h"
+#include "platform/threads/thread.h"
 #include "console/engineAPI.h"
 #include "math/util/frustum.h"
 
@@ -41,11 +43,6 @@
 SceneContainer gServerContainer;
 SceneContainer gClientContainer;
 
-const U32 SceneContainer::csmNumBins = 16;
-const F32 SceneContainer::csmBinSize = 64;
-const F32 SceneContainer::csmTotalBinSize = SceneContainer::csmBinSize * SceneContainer::csmNumBins;
-const U32 SceneContainer::csmRefPoolBlockSize = 4096;
-
 // Statics used by buildPolyList methods
 static AbstractPolyList* sPolyList;
 static SphereF sBoundingSphere;
@@ -90,36 +87,22 @@ void SceneContainer::Link::linkAfter(SceneContainer::Link* ptr)
 
 SceneContainer::SceneContainer()
 {
-   mSearchInProgress = false;
-   mCurrSeqKey = 0;
+   mNumQueriesInProgress = 0;
+   mReadOnly = false;
+
+   mHistoryHead = 0;
+   mHistoryCount = 0;
 
    mEnd.next = mEnd.prev = &mStart;
    mStart.next = mStart.prev = &mEnd;
 
-   mBinArray = new SceneObjectRef[csmNumBins * csmNumBins];
-   for (U32 i = 0; i < csmNumBins; i++) 
-   {
-      U32 base = i * csmNumBins;
-      for (U32 j = 0; j < csmNumBins; j++) 
-      {
-         mBinArray[base + j].object    = NULL;
-         mBinArray[base + j].nextInBin = NULL;
-         mBinArray[base + j].prevInBin = NULL;
-         mBinArray[base + j].nextInObj = NULL;
-      }
-   }
-   mOverflowBin.object    = NULL;
-   mOverflowBin.nextInBin = NULL;
-   mOverflowBin.prevInBin = NULL;
-   mOverflowBin.nextInObj = NULL;
+   mIndex = new SceneContainerAABBTree;
 
-   VECTOR_SET_ASSOCIATION( mRefPoolBlocks );
+   VECTOR_SET_ASSOCIATION( mFreeQueryContexts );
    VECTOR_SET_ASSOCIATION( mSearchList );
    VECTOR_SET_ASSOCIATION( mWaterAndZones );
    VECTOR_SET_ASSOCIATION( mTerrains );
-
-   mFreeRefPool = NULL;
-   addRefPoolBlock();
+   VECTOR_SET_ASSOCIATION( mHistory );
 
    cleanupSearchVectors();
 }
@@ -128,28 +111,29 @@ SceneContainer::SceneContainer()
 
 SceneContainer::~SceneContainer()
 {
-   delete[] mBinArray;
+   for( U32 i = 0; i < mHistory.size(); ++ i )
+      delete mHistory[ i ];
 
-   for (U32 i = 0; i < mRefPoolBlocks.size(); i++)
+   for( Link* itr = mStart.next; itr != &mEnd; itr = itr->next )
    {
-      SceneObjectRef* pool = mRefPoolBlocks[i];
-      for (U32 j = 0; j < csmRefPoolBlockSize; j++)
-      {
-         // Depressingly, this can give weird results if its pointing at bad memory...
-         if(pool[j].object != NULL)
-            Con::warnf("Error, a %s (%x) isn't properly out of the bins!", pool[j].object->getClassName(), pool[j].object);
-
-         // If you're getting this it means that an object created didn't
-         // remove itself from its container before we destroyed the
-         // container. Typically you get this behavior from particle
-         // emitters, as they try to hang around until all their particles
-         // die. In general it's benign, though if you get it for things
-         // that aren't particle emitters it can be a bad sign!
-      }
+      SceneObject* object = static_cast< SceneObject* >( itr );
 
-      delete [] pool;
+      // Depressingly, this can give weird results if its pointing at bad memory...
+      Con::warnf( "Error, a %s (%x) isn't properly out of the container!", object->getClassName(), object );
+
+      // If you're getting this it means that an object created didn't
+      // remove itself from its container before we destroyed the
+      // container. Typically you get this behavior from particle
+      // emitters, as they try to hang around until all their particles
+      // die. In general it's benign, though if you get it for things
+      // that aren't particle emitters it can be a bad sign!
    }
-   mFreeRefPool = NULL;
+
+   AssertFatal( mNumQueriesInProgress == 0, "SceneContainer::~SceneContainer - Container destroyed during a query" );
+   for( U32 i = 0; i < mFreeQueryContexts.size(); ++ i )
+      delete mFreeQueryContexts[ i ];
+
+   delete mIndex;
 
    cleanupSearchVectors();
 }
@@ -159,10 +143,11 @@ SceneContainer::~SceneContainer()
 bool SceneContainer::addObject(SceneObject* obj)
 {
    AssertFatal(obj->mContainer == NULL, "Adding already added object.");
+   AssertFatal(!mReadOnly, "SceneContainer::addObject - Container is read-only");
    obj->mContainer = this;
    obj->linkAfter(&mStart);
 
-   insertIntoBins(obj);
+   obj->mContainerIndexProxy = mIndex->insert( obj, obj->getWorldBox(), obj->isGlobalBounds() );
 
    // Also insert water and physical zone types into the special vector.
    if ( obj->getTypeMask() & ( WaterObjectType | PhysicalZoneObjectType ) )
@@ -170,6 +155,9 @@ bool SceneContainer::addObject(SceneObject* obj)
    if( obj->getTypeMask() & TerrainObjectType )
       mTerrains.push_back( obj );
 
+   if( obj->mKeepHistory && obj->isServerObject() )
+      _addHistory( obj );
+
    return true;
 }
 
@@ -178,7 +166,9 @@ bool SceneContainer::addObject(SceneObject* obj)
 bool SceneContainer::removeObject(SceneObject* obj)
 {
    AssertFatal(obj->mContainer == this, "Trying to remove from wrong container.");
-   removeFromBins(obj);
+   AssertFatal(!mReadOnly, "SceneContainer::removeObject - Container is read-only");
+   mIndex->remove( obj->mContainerIndexProxy );
+   obj->mContainerIndexProxy = SceneContainerIndex::NullProxy;
 
    // Remove water and physical zone types from the special vector.
    if ( obj->getTypeMask() & ( WaterObjectType | PhysicalZoneObjectType ) )
@@ -196,6 +186,9 @@ bool SceneContainer::removeObject(SceneObject* obj)
          mTerrains.erase_fast(iter);
    }
 
+   if( obj->mContainerHistoryIndex != -1 )
+      _removeHistory( obj );
+
    obj->mContainer = 0;
    obj->unlink();
    return true;
@@ -203,215 +196,94 @@ bool SceneContainer::removeObject(SceneObject* obj)
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::addRefPoolBlock()
+void SceneContainer::setIndex( SceneContainerIndex* index )
 {
-   mRefPoolBlocks.push_back(new SceneObjectRef[csmRefPoolBlockSize]);
-   for (U32 i = 0; i < csmRefPoolBlockSize-1; i++)
+   AssertFatal( index != NULL, "SceneContainer::setIndex - No index" );
+   AssertFatal( mNumQueriesInProgress == 0 && !mReadOnly, "SceneContainer::setIndex - Cannot change the index during a query" );
+
+   for( Link* itr = mStart.next; itr != &mEnd; itr = itr->next )
    {
-      mRefPoolBlocks.last()[i].object    = NULL;
-      mRefPoolBlocks.last()[i].prevInBin = NULL;
-      mRefPoolBlocks.last()[i].nextInBin = NULL;
-      mRefPoolBlocks.last()[i].nextInObj = &(mRefPoolBlocks.last()[i+1]);
+      SceneObject* object = static_cast< SceneObject* >( itr );
+      mIndex->remove( object->mContainerIndexProxy );
+      object->mContainerIndexProxy = index->insert( object, object->getWorldBox(), object->isGlobalBounds() );
    }
-   mRefPoolBlocks.last()[csmRefPoolBlockSize-1].object    = NULL;
-   mRefPoolBlocks.last()[csmRefPoolBlockSize-1].prevInBin = NULL;
-   mRefPoolBlocks.last()[csmRefPoolBlockSize-1].nextInBin = NULL;
-   mRefPoolBlocks.last()[csmRefPoolBlockSize-1].nextInObj = mFreeRefPool;
 
-   mFreeRefPool = &(mRefPoolBlocks.last()[0]);
+   delete mIndex;
+   mIndex = index;
 }
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::insertIntoBins(SceneObject* obj)
+void SceneContainer::updateObject(SceneObject* obj)
 {
    AssertFatal(obj != NULL, "No object?");
-   AssertFatal(obj->mBinRefHead == NULL, "Error, already have a bin chain!");
-
-   // The first thing we do is find which bins are covered in x and y...
-   const Box3F* pWBox = &obj->getWorldBox();
-
-   U32 minX, maxX, minY, maxY;
-   getBinRange(pWBox->minExtents.x, pWBox->maxExtents.x, minX, maxX);
-   getBinRange(pWBox->minExtents.y, pWBox->maxExtents.y, minY, maxY);
-
-   // Store the current regions for later queries
-   obj->mBinMinX = minX;
-   obj->mBinMaxX = maxX;
-   obj->mBinMinY = minY;
-   obj->mBinMaxY = maxY;
-
-   // For huge objects, dump them into the overflow bin.  Otherwise, everything
-   //  goes into the grid...
-   if ((maxX - minX + 1) < csmNumBins || (maxY - minY + 1) < csmNumBins && !obj->isGlobalBounds())
-   {
-      SceneObjectRef** pCurrInsert = &obj->mBinRefHead;
-
-      for (U32 i = minY; i <= maxY; i++)
-      {
-         U32 insertY = i % csmNumBins;
-         U32 base    = insertY * csmNumBins;
-         for (U32 j = minX; j <= maxX; j++)
-         {
-            U32 insertX = j % csmNumBins;
-
-            SceneObjectRef* ref = allocateObjectRef();
-
-            ref->object    = obj;
-            ref->nextInBin = mBinArray[base + insertX].nextInBin;
-            ref->prevInBin = &mBinArray[base + insertX];
-            ref->nextInObj = NULL;
-
-            if (mBinArray[base + insertX].nextInBin)
-               mBinArray[base + insertX].nextInBin->prevInBin = ref;
-            mBinArray[base + insertX].nextInBin = ref;
-
-            *pCurrInsert = ref;
-            pCurrInsert  = &ref->nextInObj;
-         }
-      }
-   }
-   else
-   {
-      SceneObjectRef* ref = allocateObjectRef();
+   AssertFatal(obj->mContainer == this, "SceneContainer::updateObject - Object is in another container");
+   AssertFatal(!mReadOnly, "SceneContainer::updateObject - Container is read-only");
 
-      ref->object    = obj;
-      ref->nextInBin = mOverflowBin.nextInBin;
-      ref->prevInBin = &mOverflowBin;
-      ref->nextInObj = NULL;
-
-      if (mOverflowBin.nextInBin)
-         mOverflowBin.nextInBin->prevInBin = ref;
-      mOverflowBin.nextInBin = ref;
-
-      obj->mBinRefHead = ref;
-   }
+   PROFILE_SCOPE(SceneContainer_UpdateObject);
+   mIndex->update( obj->mContainerIndexProxy, obj->getWorldBox(), obj->isGlobalBounds() );
 }
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::insertIntoBins(SceneObject* obj,
-                               U32 minX, U32 maxX,
-                               U32 minY, U32 maxY)
+SceneQueryContext* SceneContainer::_beginQuery()
 {
-   PROFILE_START(InsertBins);
-   AssertFatal(obj != NULL, "No object?");
-
-   AssertFatal(obj->mBinRefHead == NULL, "Error, already have a bin chain!");
-   // Store the current regions for later queries
-   obj->mBinMinX = minX;
-   obj->mBinMaxX = maxX;
-   obj->mBinMinY = minY;
-   obj->mBinMaxY = maxY;
-
-   // For huge objects, dump them into the overflow bin.  Otherwise, everything
-   //  goes into the grid...
-   //
-   if ((maxX - minX + 1) < csmNumBins || (maxY - minY + 1) < csmNumBins && !obj->isGlobalBounds())
-   {
-      SceneObjectRef** pCurrInsert = &obj->mBinRefHead;
-
-      for (U32 i = minY; i <= maxY; i++)
-      {
-         U32 insertY = i % csmNumBins;
-         U32 base    = insertY * csmNumBins;
-         for (U32 j = minX; j <= maxX; j++)
-         {
-            U32 insertX = j % csmNumBins;
-
-            SceneObjectRef* ref = allocateObjectRef();
+   AssertFatal( ThreadManager::isMainThread(), "SceneContainer::_beginQuery - Queries without a context are for the main thread only" );
 
-            ref->object    = obj;
-            ref->nextInBin = mBinArray[base + insertX].nextInBin;
-            ref->prevInBin = &mBinArray[base + insertX];
-            ref->nextInObj = NULL;
+   mNumQueriesInProgress++;
+   if ( mFreeQueryContexts.empty() )
+      return new SceneQueryContext;
 
-            if (mBinArray[base + insertX].nextInBin)
-               mBinArray[base + insertX].nextInBin->prevInBin = ref;
-            mBinArray[base + insertX].nextInBin = ref;
-
-            *pCurrInsert = ref;
-            pCurrInsert  = &ref->nextInObj;
-         }
-      }
-   }
-   else
-   {
-      SceneObjectRef* ref = allocateObjectRef();
+   SceneQueryContext* context = mFreeQueryContexts.last();
+   mFreeQueryContexts.pop_back();
+   return context;
+}
 
-      ref->object    = obj;
-      ref->nextInBin = mOverflowBin.nextInBin;
-      ref->prevInBin = &mOverflowBin;
-      ref->nextInObj = NULL;
+//-----------------------------------------------------------------------------
 
-      if (mOverflowBin.nextInBin)
-         mOverflowBin.nextInBin->prevInBin = ref;
-      mOverflowBin.nextInBin = ref;
-      obj->mBinRefHead = ref;
-   }
-   PROFILE_END();
+void SceneContainer::_endQuery( SceneQueryContext* context )
+{
+   mNumQueriesInProgress--;
+   mFreeQueryContexts.push_back( context );
 }
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::removeFromBins(SceneObject* obj)
+void SceneContainer::_findObjects( SceneQueryContext& context, const Box3F& box, U32 mask, bool skipHistory )
 {
-   PROFILE_START(RemoveFromBins);
-   AssertFatal(obj != NULL, "No object?");
-
-   SceneObjectRef* chain = obj->mBinRefHead;
-   obj->mBinRefHead = NULL;
+   Vector< SceneObject* >& found = context.mObjects;
+   found.clear();
+   mIndex->findObjects( context, box, found );
 
-   while (chain)
+   // Weed out what the index returned in place.
+   U32 numFound = 0;
+   for ( U32 i = 0; i < found.size(); i++ )
    {
-      SceneObjectRef* trash = chain;
-      chain = chain->nextInObj;
-
-      AssertFatal(trash->prevInBin != NULL, "Error, must have a previous entry in the bin!");
-      if (trash->nextInBin)
-         trash->nextInBin->prevInBin = trash->prevInBin;
-      trash->prevInBin->nextInBin = trash->nextInBin;
+      SceneObject *object = found[i];
 
-      freeObjectRef(trash);
+      if ((object->getTypeMask() & mask) != 0 &&
+          object->isCollisionEnabled() &&
+          (!skipHistory || object->mContainerHistoryIndex == -1))
+      {
+         if ( object->isGlobalBounds() || object->getWorldBox().isOverlapped( box ) )
+            found[numFound++] = object;
+      }
    }
-   PROFILE_END();
+   found.setSize( numFound );
 }
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::checkBins(SceneObject* obj)
+void SceneContainer::findObjects(const Box3F& box, U32 mask, FindCallback callback, void *key)
 {
-   AssertFatal(obj != NULL, "No object?");
-
-   PROFILE_START(CheckBins);
-   if (obj->mBinRefHead == NULL)
-   {
-      insertIntoBins(obj);
-      PROFILE_END();
-      return;
-   }
-
-   // Otherwise, the object is already in the bins.  Let's see if it has strayed out of
-   //  the bins that it's currently in...
-   const Box3F* pWBox = &obj->getWorldBox();
-
-   U32 minX, maxX, minY, maxY;
-   getBinRange(pWBox->minExtents.x, pWBox->maxExtents.x, minX, maxX);
-   getBinRange(pWBox->minExtents.y, pWBox->maxExtents.y, minY, maxY);
-
-   if (obj->mBinMinX != minX || obj->mBinMaxX != maxX ||
-       obj->mBinMinY != minY || obj->mBinMaxY != maxY)
-   {
-      // We have to rebin the object
-      removeFromBins(obj);
-      insertIntoBins(obj, minX, maxX, minY, maxY);
-   }
-   PROFILE_END();
+   SceneQueryContext* context = _beginQuery();
+   findObjects( *context, box, mask, callback, key );
+   _endQuery( context );
 }
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::findObjects(const Box3F& box, U32 mask, FindCallback callback, void *key)
+void SceneContainer::findObjects(SceneQueryContext& context, const Box3F& box, U32 mask, FindCallback callback, void *key)
 {
    PROFILE_SCOPE(ContainerFindObjects_Box);
 
@@ -430,66 +302,23 @@ void SceneContainer::findObjects(const Box3F& box, U32 mask, FindCallback callba
       return;
    }
 
-   AssertFatal( !mSearchInProgress, "SceneContainer::findObjects - Container queries are not re-entrant" );
-   mSearchInProgress = true;
-
-   U32 minX, maxX, minY, maxY;
-   getBinRange(box.minExtents.x, box.maxExtents.x, minX, maxX);
-   getBinRange(box.minExtents.y, box.maxExtents.y, minY, maxY);
-   mCurrSeqKey++;
-   for (U32 i = minY; i <= maxY; i++)
-   {
-      U32 insertY = i % csmNumBins;
-      U32 base    = insertY * csmNumBins;
-      for (U32 j = minX; j <= maxX; j++)
-      {
-         U32 insertX = j % csmNumBins;
-
-         SceneObjectRef* chain = mBinArray[base + insertX].nextInBin;
-         while (chain)
-         {
-            if (chain->object->getContainerSeqKey() != mCurrSeqKey)
-            {
-               chain->object->setContainerSeqKey(mCurrSeqKey);
-
-               if ((chain->object->getTypeMask() & mask) != 0 &&
-                   chain->object->isCollisionEnabled())
-               {
-                  if (chain->object->getWorldBox().isOverlapped(box) || chain->object->isGlobalBounds())
-                  {
-                     (*callback)(chain->object,key);
-                  }
-               }
-            }
-            chain = chain->nextInBin;
-         }
-      }
-   }
-   SceneObjectRef* chain = mOverflowBin.nextInBin;
-   while (chain)
-   {
-      if (chain->object->getContainerSeqKey() != mCurrSeqKey)
-      {
-         chain->object->setContainerSeqKey(mCurrSeqKey);
+   _findObjects( context, box, mask );
+   for ( U32 i = 0; i < context.mObjects.size(); i++ )
+      (*callback)(context.mObjects[i],key);
+}
 
-         if ((chain->object->getTypeMask() & mask) != 0 &&
-             chain->object->isCollisionEnabled())
-         {
-            if (chain->object->getWorldBox().isOverlapped(box) || chain->object->isGlobalBounds())
-            {
-               (*callback)(chain->object,key);
-            }
-         }
-      }
-      chain = chain->nextInBin;
-   }
+//-----------------------------------------------------------------------------
 
-   mSearchInProgress = false;
+void SceneContainer::findObjects( const Frustum &frustum, U32 mask, FindCallback callback, void *key )
+{
+   SceneQueryContext* context = _beginQuery();
+   findObjects( *context, frustum, mask, callback, key );
+   _endQuery( context );
 }
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::findObjects( const Frustum &frustum, U32 mask, FindCallback callback, void *key )
+void SceneContainer::findObjects( SceneQueryContext& context, const Frustum &frustum, U32 mask, FindCallback callback, void *key )
 {
    PROFILE_SCOPE(ContainerFindObjects_Frustum);
 
@@ -508,72 +337,12 @@ void SceneContainer::findObjects( const Frustum &frustum, U32 mask, FindCallback
       return;
    }
 
-   AssertFatal( !mSearchInProgress, "SceneContainer::findObjects - Container queries are not re-entrant" );
-   mSearchInProgress = true;
-
-   U32 minX, maxX, minY, maxY;
-   getBinRange(searchBox.minExtents.x, searchBox.maxExtents.x, minX, maxX);
-   getBinRange(searchBox.minExtents.y, searchBox.maxExtents.y, minY, maxY);
-   mCurrSeqKey++;
-
-   for (U32 i = minY; i <= maxY; i++)
+   _findObjects( context, searchBox, mask );
+   for ( U32 i = 0; i < context.mObjects.size(); i++ )
    {
-      U32 insertY = i % csmNumBins;
-      U32 base    = insertY * csmNumBins;
-      for (U32 j = minX; j <= maxX; j++)
-      {
-         U32 insertX = j % csmNumBins;
-
-         SceneObjectRef* chain = mBinArray[base + insertX].nextInBin;
-         while (chain)
-         {
-            SceneObject *object = chain->object;
-
-            if (object->getContainerSeqKey() != mCurrSeqKey)
-            {
-               object->setContainerSeqKey(mCurrSeqKey);
-
-               if ((object->getTypeMask() & mask) != 0 &&
-                  object->isCollisionEnabled())
-               {
-                  const Box3F &worldBox = object->getWorldBox();
-                  if ( object->isGlobalBounds() || worldBox.isOverlapped(searchBox) )
-                  {
-                     if ( !frustum.isCulled( worldBox ) )
-                        (*callback)(chain->object,key);
-                  }
-               }
-            }
-            chain = chain->nextInBin;
-         }
-      }
+      if ( !frustum.isCulled( context.mObjects[i]->getWorldBox() ) )
+         (*callback)(context.mObjects[i],key);
    }
-
-   SceneObjectRef* chain = mOverflowBin.nextInBin;
-   while (chain)
-   {
-      SceneObject *object = chain->object;
-
-      if (object->getContainerSeqKey() != mCurrSeqKey)
-      {
-         object->setContainerSeqKey(mCurrSeqKey);
-
-         if ((object->getTypeMask() & mask) != 0 &&
-            object->isCollisionEnabled())
-         {
-            const Box3F &worldBox = object->getWorldBox();
-
-            if ( object->isGlobalBounds() || worldBox.isOverlapped(searchBox) )
-            {
-               if ( !frustum.isCulled( worldBox ) )
-                  (*callback)(object,key);
-            }
-         }
-      }
-      chain = chain->nextInBin;
-   }
-
-   mSearchInProgress = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -605,145 +374,51 @@ void SceneContainer::polyhedronFindObjects(const Polyhedron& polyhedron, U32 mas
       return;
    }
 
-   AssertFatal( !mSearchInProgress, "SceneContainer::polyhedronFindObjects - Container queries are not re-entrant" );
-   mSearchInProgress = true;
-
-   U32 minX, maxX, minY, maxY;
-   getBinRange(box.minExtents.x, box.maxExtents.x, minX, maxX);
-   getBinRange(box.minExtents.y, box.maxExtents.y, minY, maxY);
-   mCurrSeqKey++;
-   for (i = minY; i <= maxY; i++)
-   {
-      U32 insertY = i % csmNumBins;
-      U32 base    = insertY * csmNumBins;
-      for (U32 j = minX; j <= maxX; j++)
-      {
-         U32 insertX = j % csmNumBins;
-
-         SceneObjectRef* chain = mBinArray[base + insertX].nextInBin;
-         while (chain)
-         {
-            if (chain->object->getContainerSeqKey() != mCurrSeqKey)
-            {
-               chain->object->setContainerSeqKey(mCurrSeqKey);
-
-               if ((chain->object->getTypeMask() & mask) != 0 &&
-                   chain->object->isCollisionEnabled())
-               {
-                  if (chain->object->getWorldBox().isOverlapped(box) || chain->object->isGlobalBounds())
-                  {
-                     (*callback)(chain->object,key);
-                  }
-               }
-            }
-            chain = chain->nextInBin;
-         }
-      }
-   }
-   SceneObjectRef* chain = mOverflowBin.nextInBin;
-   while (chain)
-   {
-      if (chain->object->getContainerSeqKey() != mCurrSeqKey)
-      {
-         chain->object->setContainerSeqKey(mCurrSeqKey);
+   SceneQueryContext* context = _beginQuery();
+   _findObjects( *context, box, mask );
+   for ( i = 0; i < context->mObjects.size(); i++ )
+      (*callback)(context->mObjects[i],key);
+   _endQuery( context );
+}
 
-         if ((chain->object->getTypeMask() & mask) != 0 &&
-             chain->object->isCollisionEnabled())
-         {
-            if (chain->object->getWorldBox().isOverlapped(box) || chain->object->isGlobalBounds())
-            {
-               (*callback)(chain->object,key);
-            }
-         }
-      }
-      chain = chain->nextInBin;
-   }
+//-----------------------------------------------------------------------------
 
-   mSearchInProgress = false;
+void SceneContainer::findObjectList( const Box3F& searchBox, U32 mask, Vector<SceneObject*> *outFound )
+{
+   SceneQueryContext* context = _beginQuery();
+   findObjectList( *context, searchBox, mask, outFound );
+   _endQuery( context );
 }
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::findObjectList( const Box3F& searchBox, U32 mask, Vector<SceneObject*> *outFound )
+void SceneContainer::findObjectList( SceneQueryContext& context, const Box3F& searchBox, U32 mask, Vector<SceneObject*> *outFound )
 {
    PROFILE_SCOPE( Container_FindObjectList_Box );
 
-   AssertFatal( !mSearchInProgress, "SceneContainer::findObjectList - Container queries are not re-entrant" );
-   mSearchInProgress = true;
-
    // TODO: Optimize for water and zones?
 
-   U32 minX, maxX, minY, maxY;
-   getBinRange(searchBox.minExtents.x, searchBox.maxExtents.x, minX, maxX);
-   getBinRange(searchBox.minExtents.y, searchBox.maxExtents.y, minY, maxY);
-   mCurrSeqKey++;
-
-   for (U32 i = minY; i <= maxY; i++)
-   {
-      U32 insertY = i % csmNumBins;
-      U32 base    = insertY * csmNumBins;
-      for (U32 j = minX; j <= maxX; j++)
-      {
-         U32 insertX = j % csmNumBins;
-
-         SceneObjectRef* chain = mBinArray[base + insertX].nextInBin;
-         while (chain)
-         {
-            SceneObject *object = chain->object;
-
-            if (object->getContainerSeqKey() != mCurrSeqKey)
-            {
-               object->setContainerSeqKey(mCurrSeqKey);
-
-               if ((object->getTypeMask() & mask) != 0 &&
-                  object->isCollisionEnabled())
-               {
-                  const Box3F &worldBox = object->getWorldBox();
-                  if ( object->isGlobalBounds() || worldBox.isOverlapped( searchBox ) )
-                  {
-                     outFound->push_back( object );
-                  }
-               }
-            }
-            chain = chain->nextInBin;
-         }
-      }
-   }
-
-   SceneObjectRef* chain = mOverflowBin.nextInBin;
-   while (chain)
-   {
-      SceneObject *object = chain->object;
-
-      if (object->getContainerSeqKey() != mCurrSeqKey)
-      {
-         object->setContainerSeqKey(mCurrSeqKey);
-
-         if ((object->getTypeMask() & mask) != 0 &&
-            object->isCollisionEnabled())
-         {
-            const Box3F &worldBox = object->getWorldBox();
+   _findObjects( context, searchBox, mask );
+   outFound->merge( context.mObjects );
+}
 
-            if ( object->isGlobalBounds() || worldBox.isOverlapped( searchBox ) )
-            {
-               outFound->push_back( object );
-            }
-         }
-      }
-      chain = chain->nextInBin;
-   }
+//-----------------------------------------------------------------------------
 
-   mSearchInProgress = false;
+void SceneContainer::findObjectList( const Frustum &frustum, U32 mask, Vector<SceneObject*> *outFound )
+{
+   SceneQueryContext* context = _beginQuery();
+   findObjectList( *context, frustum, mask, outFound );
+   _endQuery( context );
 }
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::findObjectList( const Frustum &frustum, U32 mask, Vector<SceneObject*> *outFound )
+void SceneContainer::findObjectList( SceneQueryContext& context, const Frustum &frustum, U32 mask, Vector<SceneObject*> *outFound )
 {
    PROFILE_SCOPE( Container_FindObjectList_Frustum );
 
    // Do a box find first.
-   findObjectList( frustum.getBounds(), mask, outFound );
+   findObjectList( context, frustum.getBounds(), mask, outFound );
 
    // Now do the frustum testing.
    for ( U32 i=0; i < outFound->size(); )
@@ -816,11 +491,21 @@ void SceneContainer::_findSpecialObjects( const Vector< SceneObject* >& vector,
 //-----------------------------------------------------------------------------
 
 bool SceneContainer::castRay( const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback )
+{
+   SceneQueryContext* context = _beginQuery();
+   bool result = castRay( *context, start, end, mask, info, callback );
+   _endQuery( context );
+   return result;
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneContainer::castRay( SceneQueryContext& context, const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback )
 {
    AssertFatal( info->userData == NULL, "SceneContainer::castRay - RayInfo->userData cannot be used here!" );
 
    PROFILE_START( SceneContainer_CastRay );
-   bool result = _castRay( CollisionGeometry, start, end, mask, info, callback );
+   bool result = _castRay( context, CollisionGeometry, start, end, mask, info, callback );
    PROFILE_END();
    return result;
 }
@@ -828,49 +513,44 @@ bool SceneContainer::castRay( const Point3F& start, const Point3F& end, U32 mask
 //-----------------------------------------------------------------------------
 
 bool SceneContainer::castRayRendered( const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback )
+{
+   SceneQueryContext* context = _beginQuery();
+   bool result = castRayRendered( *context, start, end, mask, info, callback );
+   _endQuery( context );
+   return result;
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneContainer::castRayRendered( SceneQueryContext& context, const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback )
 {
    AssertFatal( info->userData == NULL, "SceneContainer::castRayRendered - RayInfo->userData cannot be used here!" );
 
    PROFILE_START( SceneContainer_CastRayRendered );
-   bool result = _castRay( RenderedGeometry, start, end, mask, info, callback );
+   bool result = _castRay( context, RenderedGeometry, start, end, mask, info, callback );
    PROFILE_END();
    return result;
 }
 
 //-----------------------------------------------------------------------------
 
-// DMMNOTE: There are still some optimizations to be done here.  In particular:
-//           - After checking the overflow bin, we can potentially shorten the line
-//             that we rasterize against the grid if there is a collision with say,
-//             the terrain.
-//           - The optimal grid size isn't necessarily what we have set here. possibly
-//             a resolution of 16 meters would give better results
-//           - The line rasterizer is pretty lame.  Unfortunately we can't use a
-//             simple bres. here, since we need to check every grid element that the line
-//             passes through, which bres does _not_ do for us.  Possibly there's a
-//             rasterizer for anti-aliased lines that will serve better than what
-//             we have below.
-
-bool SceneContainer::_castRay( U32 type, const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback )
+bool SceneContainer::_castRay( SceneQueryContext& context, U32 type, const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback, bool skipHistory )
 {
-   AssertFatal( !mSearchInProgress, "SceneContainer::_castRay - Container queries are not re-entrant" );
-   mSearchInProgress = true;
-
    F32 currentT = 2.0;
-   mCurrSeqKey++;
 
-   SceneObjectRef* chain = mOverflowBin.nextInBin;
-   while (chain)
+   Vector< SceneObject* >& found = context.mObjects;
+   found.clear();
+   mIndex->findObjects( context, start, end, found );
+
+   for ( U32 i = 0; i < found.size(); i++ )
    {
-      SceneObject* ptr = chain->object;
-      if (ptr->getContainerSeqKey() != mCurrSeqKey)
-      {
-         ptr->setContainerSeqKey(mCurrSeqKey);
+      SceneObject* ptr = found[i];
 
-         // In the overflow bin, the world box is always going to intersect the line,
-         //  so we can omit that test...
-         if ((ptr->getTypeMask() & mask) != 0 &&
-             ptr->isCollisionEnabled() == true)
+      if ((ptr->getTypeMask() & mask) != 0      &&
+          ptr->isCollisionEnabled() == true     &&
+          (!skipHistory || ptr->mContainerHistoryIndex == -1))
+      {
+         if (ptr->isGlobalBounds() || ptr->getWorldBox().collideLine(start, end))
          {
             Point3F xformedStart, xformedEnd;
             ptr->mWorldToObj.mulP(start, &xformedStart);
@@ -892,237 +572,137 @@ bool SceneContainer::_castRay( U32 type, const Point3F& start, const Point3F& en
                   *info = ri;
                   info->point.interpolate(start, end, info->t);
                   currentT = ri.t;
-						info->distance = (start - info->point).len();
+                  info->distance = (start - info->point).len();
                }
             }
          }
       }
-      chain = chain->nextInBin;
    }
 
-   // These are just for rasterizing the line against the grid.  We want the x coord
-   //  of the start to be <= the x coord of the end
-   Point3F normalStart, normalEnd;
-   if (start.x <= end.x)
+   // Bump the normal into worldspace if appropriate.
+   if(currentT != 2)
    {
-      normalStart = start;
-      normalEnd   = end;
+      PlaneF fakePlane;
+      fakePlane.x = info->normal.x;
+      fakePlane.y = info->normal.y;
+      fakePlane.z = info->normal.z;
+      fakePlane.d = 0;
+
+      PlaneF result;
+      mTransformPlane(info->object->getTransform(), info->object->getScale(), fakePlane, &result);
+      info->normal = result;
+
+      return true;
    }
    else
    {
-      normalStart = end;
-      normalEnd   = start;
+      // Do nothing and exit...
+      return false;
    }
+}
 
-   // Ok, let's scan the grids.  The simplest way to do this will be to scan across in
-   //  x, finding the y range for each affected bin...
-   U32 minX, maxX;
-   U32 minY, maxY;
-//if (normalStart.x == normalEnd.x)
-//   Con::printf("X start = %g, end = %g", normalStart.x, normalEnd.x);
-
-   getBinRange(normalStart.x, normalEnd.x, minX, maxX);
-   getBinRange(getMin(normalStart.y, normalEnd.y),
-               getMax(normalStart.y, normalEnd.y), minY, maxY);
-
-//if (normalStart.x == normalEnd.x && minX != maxX)
-//   Con::printf("X min = %d, max = %d", minX, maxX);
-//if (normalStart.y == normalEnd.y && minY != maxY)
-//   Con::printf("Y min = %d, max = %d", minY, maxY);
-
-   // We'll optimize the case that the line is contained in one bin row or column, which
-   //  will be quite a few lines.  No sense doing more work than we have to...
-   //
-   if ((mFabs(normalStart.x - normalEnd.x) < csmTotalBinSize && minX == maxX) ||
-       (mFabs(normalStart.y - normalEnd.y) < csmTotalBinSize && minY == maxY))
-   {
-      U32 count;
-      U32 incX, incY;
-      if (minX == maxX)
-      {
-         count = maxY - minY + 1;
-         incX  = 0;
-         incY  = 1;
-      }
-      else
-      {
-         count = maxX - minX + 1;
-         incX  = 1;
-         incY  = 0;
-      }
-
-      U32 x = minX;
-      U32 y = minY;
-      for (U32 i = 0; i < count; i++)
-      {
-         U32 checkX = x % csmNumBins;
-         U32 checkY = y % csmNumBins;
 
-         SceneObjectRef* chain = mBinArray[(checkY * csmNumBins) + checkX].nextInBin;
-         while (chain)
-         {
-            SceneObject* ptr = chain->object;
-            if (ptr->getContainerSeqKey() != mCurrSeqKey)
-            {
-               ptr->setContainerSeqKey(mCurrSeqKey);
+//-----------------------------------------------------------------------------
 
-               if ((ptr->getTypeMask() & mask) != 0      &&
-                   ptr->isCollisionEnabled() == true)
-               {
-                  if (ptr->getWorldBox().collideLine(start, end) || chain->object->isGlobalBounds())
-                  {
-                     Point3F xformedStart, xformedEnd;
-                     ptr->mWorldToObj.mulP(start, &xformedStart);
-                     ptr->mWorldToObj.mulP(end,   &xformedEnd);
-                     xformedStart.convolveInverse(ptr->mObjScale);
-                     xformedEnd.convolveInverse(ptr->mObjScale);
-
-                     RayInfo ri;
-                     ri.generateTexCoord  = info->generateTexCoord;
-                     bool result = false;
-                     if (type == CollisionGeometry)
-                        result = ptr->castRay(xformedStart, xformedEnd, &ri);
-                     else if (type == RenderedGeometry)
-                        result = ptr->castRayRendered(xformedStart, xformedEnd, &ri);
-                     if (result)
-                     {
-                        if( ri.t < currentT && ( !callback || callback( &ri ) ) )
-                        {
-                           *info = ri;
-                           info->point.interpolate(start, end, info->t);
-                           currentT = ri.t;
-						         info->distance = (start - info->point).len();
-                        }
-                     }
-                  }
-               }
-            }
-            chain = chain->nextInBin;
-         }
+U32 SceneContainer::castRays( U32 numRays, const Point3F* starts, const Point3F* ends, U32 mask, RayInfo* outInfos, CastRayCallback callback )
+{
+   SceneQueryContext* context = _beginQuery();
+   U32 numHits = castRays( *context, numRays, starts, ends, mask, outInfos, callback );
+   _endQuery( context );
+   return numHits;
+}
 
-         x += incX;
-         y += incY;
-      }
-   }
-   else
-   {
-      // Oh well, let's earn our keep.  We know that after the above conditional, we're
-      //  going to cross at least one boundary, so that simplifies our job...
+//-----------------------------------------------------------------------------
 
-      F32 currStartX = normalStart.x;
+U32 SceneContainer::castRays( SceneQueryContext& context, U32 numRays, const Point3F* starts, const Point3F* ends, U32 mask, RayInfo* outInfos, CastRayCallback callback )
+{
+   PROFILE_SCOPE( SceneContainer_CastRays );
 
-      AssertFatal(currStartX != normalEnd.x, "This is going to cause problems in SceneContainer::castRay");
-      while (currStartX != normalEnd.x)
-      {
-         F32 currEndX   = getMin(currStartX + csmTotalBinSize, normalEnd.x);
+   Vector< SceneObject* >& found = context.mObjects;
+   Vector< U32 >& foundMasks = context.mSegmentMasks;
 
-         F32 currStartT = (currStartX - normalStart.x) / (normalEnd.x - normalStart.x);
-         F32 currEndT   = (currEndX   - normalStart.x) / (normalEnd.x - normalStart.x);
+   U32 numHits = 0;
+   for ( U32 first = 0; first < numRays; first += SceneContainerIndex::MaxSegments )
+   {
+      const U32 count = getMin( numRays - first, U32( SceneContainerIndex::MaxSegments ) );
+      const Point3F* start = starts + first;
+      const Point3F* end = ends + first;
+      RayInfo* info = outInfos + first;
 
-         F32 y1 = normalStart.y + (normalEnd.y - normalStart.y) * currStartT;
-         F32 y2 = normalStart.y + (normalEnd.y - normalStart.y) * currEndT;
+      F32 currentT[ SceneContainerIndex::MaxSegments ];
+      for ( U32 i = 0; i < count; i++ )
+      {
+         AssertFatal( info[i].userData == NULL, "SceneContainer::castRays - RayInfo->userData cannot be used here!" );
+         currentT[i] = 2.0f;
+      }
 
-         U32 subMinX, subMaxX;
-         getBinRange(currStartX, currEndX, subMinX, subMaxX);
+      found.clear();
+      foundMasks.clear();
+      mIndex->findObjects( context, start, end, count, found, foundMasks );
 
-         F32 subStartX = currStartX;
-         F32 subEndX   = currStartX;
+      // Test each object against all the rays that may touch it while we
+      // have it at hand.
+      for ( U32 j = 0; j < found.size(); j++ )
+      {
+         SceneObject* ptr = found[j];
+         if ((ptr->getTypeMask() & mask) == 0 || !ptr->isCollisionEnabled())
+            continue;
 
-         if (currStartX < 0.0f)
-            subEndX -= mFmod(subEndX, csmBinSize);
-         else
-            subEndX += (csmBinSize - mFmod(subEndX, csmBinSize));
+         const Box3F& worldBox = ptr->getWorldBox();
+         const bool globalBounds = ptr->isGlobalBounds();
 
-         for (U32 currXBin = subMinX; currXBin <= subMaxX; currXBin++)
+         const U32 rays = foundMasks[j];
+         for ( U32 i = 0; i < count; i++ )
          {
-            U32 checkX = currXBin % csmNumBins;
+            if ( !( rays & ( U32( 1 ) << i ) ) )
+               continue;
 
-            F32 subStartT = (subStartX - currStartX) / (currEndX - currStartX);
-            F32 subEndT   = getMin(F32((subEndX   - currStartX) / (currEndX - currStartX)), 1.f);
+            // Nothing in the object can be closer than its box, so skip it
+            // if the ray already hit something in front of that.
+            F32 boxT;
+            Point3F boxNormal;
+            if ( !globalBounds &&
+                 ( !worldBox.collideLine( start[i], end[i], &boxT, &boxNormal ) || boxT >= currentT[i] ) )
+               continue;
 
-            F32 subY1 = y1 + (y2 - y1) * subStartT;
-            F32 subY2 = y1 + (y2 - y1) * subEndT;
-
-            U32 newMinY, newMaxY;
-            getBinRange(getMin(subY1, subY2), getMax(subY1, subY2), newMinY, newMaxY);
+            Point3F xformedStart, xformedEnd;
+            ptr->mWorldToObj.mulP(start[i], &xformedStart);
+            ptr->mWorldToObj.mulP(end[i],   &xformedEnd);
+            xformedStart.convolveInverse(ptr->mObjScale);
+            xformedEnd.convolveInverse(ptr->mObjScale);
 
-            for (U32 i = newMinY; i <= newMaxY; i++)
+            RayInfo ri;
+            ri.generateTexCoord = info[i].generateTexCoord;
+            if ( ptr->castRay(xformedStart, xformedEnd, &ri) &&
+                 ri.t < currentT[i] && ( !callback || callback( &ri ) ) )
             {
-               U32 checkY = i % csmNumBins;
-
-               SceneObjectRef* chain = mBinArray[(checkY * csmNumBins) + checkX].nextInBin;
-               while (chain)
-               {
-                  SceneObject* ptr = chain->object;
-                  if (ptr->getContainerSeqKey() != mCurrSeqKey)
-                  {
-                     ptr->setContainerSeqKey(mCurrSeqKey);
-
-                     if ((ptr->getTypeMask() & mask) != 0      &&
-                         ptr->isCollisionEnabled() == true)
-                     {
-                        if (ptr->getWorldBox().collideLine(start, end))
-                        {
-                           Point3F xformedStart, xformedEnd;
-                           ptr->mWorldToObj.mulP(start, &xformedStart);
-                           ptr->mWorldToObj.mulP(end,   &xformedEnd);
-                           xformedStart.convolveInverse(ptr->mObjScale);
-                           xformedEnd.convolveInverse(ptr->mObjScale);
-
-                           RayInfo ri;
-                           ri.generateTexCoord  = info->generateTexCoord;
-                           bool result = false;
-                           if (type == CollisionGeometry)
-                              result = ptr->castRay(xformedStart, xformedEnd, &ri);
-                           else if (type == RenderedGeometry)
-                              result = ptr->castRayRendered(xformedStart, xformedEnd, &ri);
-                           if (result)
-                           {
-                              if( ri.t < currentT && ( !callback || callback( &ri ) ) )
-                              {
-                                 *info = ri;
-                                 info->point.interpolate(start, end, info->t);
-                                 currentT = ri.t;
-								         info->distance = (start - info->point).len();
-                              }
-                           }
-                        }
-                     }
-                  }
-                  chain = chain->nextInBin;
-               }
+               info[i] = ri;
+               info[i].point.interpolate(start[i], end[i], ri.t);
+               info[i].distance = (start[i] - info[i].point).len();
+               currentT[i] = ri.t;
             }
-
-            subStartX = subEndX;
-            subEndX   = getMin(subEndX + csmBinSize, currEndX);
          }
-
-         currStartX = currEndX;
       }
-   }
-
-   mSearchInProgress = false;
 
-   // Bump the normal into worldspace if appropriate.
-   if(currentT != 2)
-   {
-      PlaneF fakePlane;
-      fakePlane.x = info->normal.x;
-      fakePlane.y = info->normal.y;
-      fakePlane.z = info->normal.z;
-      fakePlane.d = 0;
+      // Bump the normals into worldspace.
+      for ( U32 i = 0; i < count; i++ )
+      {
+         if ( currentT[i] == 2.0f )
+         {
+            info[i].object = NULL;
+            continue;
+         }
 
-      PlaneF result;
-      mTransformPlane(info->object->getTransform(), info->object->getScale(), fakePlane, &result);
-      info->normal = result;
+         PlaneF fakePlane( info[i].normal.x, info[i].normal.y, info[i].normal.z, 0.0f );
+         PlaneF result;
+         mTransformPlane(info[i].object->getTransform(), info[i].object->getScale(), fakePlane, &result);
+         info[i].normal = result;
 
-      return true;
-   }
-   else
-   {
-      // Do nothing and exit...
-      return false;
+         numHits++;
+      }
    }
+
+   return numHits;
 }
 
 //-----------------------------------------------------------------------------
@@ -1161,6 +741,222 @@ bool SceneContainer::collideBox(const Point3F &start, const Point3F &end, U32 ma
 
 //-----------------------------------------------------------------------------
 
+void SceneContainer::_addHistory( SceneObject* object )
+{
+   ObjectHistory* history = new ObjectHistory;
+   history->object = object;
+
+   // Until it has been recorded, the object has always been where it is now.
+   for( U32 i = 0; i < HistoryLength; ++ i )
+   {
+      history->states[ i ].worldToObj = object->mWorldToObj;
+      history->states[ i ].worldBox = object->getWorldBox();
+   }
+
+   object->mContainerHistoryIndex = mHistory.size();
+   mHistory.push_back( history );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::_removeHistory( SceneObject* object )
+{
+   S32 index = object->mContainerHistoryIndex;
+   ObjectHistory* history = mHistory[ index ];
+
+   mHistory[ index ] = mHistory.last();
+   mHistory[ index ]->object->mContainerHistoryIndex = index;
+   mHistory.pop_back();
+
+   object->mContainerHistoryIndex = -1;
+   delete history;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::recordHistory( U32 tick )
+{
+   PROFILE_SCOPE( SceneContainer_RecordHistory );
+
+   AssertFatal( !mReadOnly, "SceneContainer::recordHistory - Container is read-only" );
+   AssertFatal( !mHistoryCount || tick > mHistoryTicks[ mHistoryHead ],
+      "SceneContainer::recordHistory - Ticks must be recorded in order" );
+
+   mHistoryHead = ( mHistoryHead + 1 ) % HistoryLength;
+   mHistoryTicks[ mHistoryHead ] = tick;
+   if( mHistoryCount < HistoryLength )
+      mHistoryCount ++;
+
+   for( U32 i = 0; i < mHistory.size(); ++ i )
+   {
+      ObjectHistory* history = mHistory[ i ];
+      HistoryState& state = history->states[ mHistoryHead ];
+      state.worldToObj = history->object->mWorldToObj;
+      state.worldBox = history->object->getWorldBox();
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+U32 SceneContainer::getOldestHistoryTick() const
+{
+   if( !mHistoryCount )
+      return 0;
+
+   return mHistoryTicks[ ( mHistoryHead + HistoryLength - mHistoryCount + 1 ) % HistoryLength ];
+}
+
+//-----------------------------------------------------------------------------
+
+S32 SceneContainer::_findHistorySlot( U32 tick ) const
+{
+   if( !mHistoryCount || tick >= mHistoryTicks[ mHistoryHead ] )
+      return -1;
+
+   U32 slot = mHistoryHead;
+   for( U32 i = 1; i < mHistoryCount; ++ i )
+   {
+      slot = ( slot + HistoryLength - 1 ) % HistoryLength;
+      if( mHistoryTicks[ slot ] <= tick )
+         break;
+   }
+
+   return slot;
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneContainer::getHistoryState( SceneObject* object, U32 tick, MatrixF* worldToObj, Box3F* worldBox ) const
+{
+   if( object->mContainer != this || object->mContainerHistoryIndex == -1 )
+      return false;
+
+   S32 slot = _findHistorySlot( tick );
+   if( slot == -1 )
+   {
+      *worldToObj = object->mWorldToObj;
+      *worldBox = object->getWorldBox();
+   }
+   else
+   {
+      const HistoryState& state = mHistory[ object->mContainerHistoryIndex ]->states[ slot ];
+      *worldToObj = state.worldToObj;
+      *worldBox = state.worldBox;
+   }
+
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneContainer::castRayRewound( U32 tick, const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback )
+{
+   SceneQueryContext* context = _beginQuery();
+   bool result = castRayRewound( *context, tick, start, end, mask, info, callback );
+   _endQuery( context );
+   return result;
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneContainer::castRayRewound( SceneQueryContext& context, U32 tick, const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback )
+{
+   AssertFatal( info->userData == NULL, "SceneContainer::castRayRewound - RayInfo->userData cannot be used here!" );
+
+   S32 slot = _findHistorySlot( tick );
+   if( slot == -1 )
+      return castRay( context, start, end, mask, info, callback );
+
+   PROFILE_SCOPE( SceneContainer_CastRayRewound );
+
+   // Everything without a history is where it is now.
+   F32 currentT = 2.0f;
+   if( _castRay( context, CollisionGeometry, start, end, mask, info, callback, true ) )
+      currentT = info->t;
+
+   const HistoryState* hitState = NULL;
+   for( U32 i = 0; i < mHistory.size(); ++ i )
+   {
+      SceneObject* ptr = mHistory[ i ]->object;
+      const HistoryState& state = mHistory[ i ]->states[ slot ];
+
+      if( ( ptr->getTypeMask() & mask ) == 0 ||
+          !ptr->isCollisionEnabled() ||
+          !state.worldBox.collideLine( start, end ) )
+         continue;
+
+      Point3F xformedStart, xformedEnd;
+      state.worldToObj.mulP( start, &xformedStart );
+      state.worldToObj.mulP( end, &xformedEnd );
+      xformedStart.convolveInverse( ptr->mObjScale );
+      xformedEnd.convolveInverse( ptr->mObjScale );
+
+      RayInfo ri;
+      ri.generateTexCoord = info->generateTexCoord;
+      if( ptr->castRay( xformedStart, xformedEnd, &ri ) &&
+          ri.t < currentT && ( !callback || callback( &ri ) ) )
+      {
+         *info = ri;
+         info->point.interpolate( start, end, info->t );
+         currentT = ri.t;
+         info->distance = ( start - info->point ).len();
+         hitState = &state;
+      }
+   }
+
+   // Bump the normal into worldspace, as it was then.
+   if( hitState )
+   {
+      MatrixF objToWorld = hitState->worldToObj;
+      objToWorld.affineInverse();
+
+      PlaneF fakePlane( info->normal.x, info->normal.y, info->normal.z, 0.0f );
+      PlaneF result;
+      mTransformPlane( objToWorld, info->object->getScale(), fakePlane, &result );
+      info->normal = result;
+   }
+
+   return currentT != 2.0f;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::findObjectsRewound( U32 tick, const Box3F& box, U32 mask, FindCallback callback, void *key )
+{
+   SceneQueryContext* context = _beginQuery();
+   findObjectsRewound( *context, tick, box, mask, callback, key );
+   _endQuery( context );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::findObjectsRewound( SceneQueryContext& context, U32 tick, const Box3F& box, U32 mask, FindCallback callback, void *key )
+{
+   S32 slot = _findHistorySlot( tick );
+   if( slot == -1 )
+   {
+      findObjects( context, box, mask, callback, key );
+      return;
+   }
+
+   PROFILE_SCOPE( SceneContainer_FindObjectsRewound );
+
+   _findObjects( context, box, mask, true );
+   for( U32 i = 0; i < context.mObjects.size(); ++ i )
+      ( *callback )( context.mObjects[ i ], key );
+
+   for( U32 i = 0; i < mHistory.size(); ++ i )
+   {
+      SceneObject* ptr = mHistory[ i ]->object;
+      if( ( ptr->getTypeMask() & mask ) != 0 &&
+          ptr->isCollisionEnabled() &&
+          mHistory[ i ]->states[ slot ].worldBox.isOverlapped( box ) )
+         ( *callback )( ptr, key );
+   }
+}
+
+//-----------------------------------------------------------------------------
+
 static void buildCallback(SceneObject* object,void *key)
 {
    SceneContainer::CallbackInfo* info = reinterpret_cast<SceneContainer::CallbackInfo*>(key);
@@ -1370,75 +1166,6 @@ F32 SceneContainer::containerSearchCurrRadiusDist()
    return dist;
 }
 
-//-----------------------------------------------------------------------------
-
-void SceneContainer::getBinRange( const F32 min, const F32 max, U32& minBin, U32& maxBin )
-{
-   AssertFatal(max >= min, "Error, bad range! in getBinRange");
-
-   if ((max - min) >= (SceneContainer::csmTotalBinSize - SceneContainer::csmBinSize))
-   {
-      F32 minCoord = mFmod(min, SceneContainer::csmTotalBinSize);
-      if (minCoord < 0.0f) 
-      {
-         minCoord += SceneContainer::csmTotalBinSize;
-
-         // This is truly lame, but it can happen.  There must be a better way to
-         //  deal with this.
-         if (minCoord == SceneContainer::csmTotalBinSize)
-            minCoord = SceneContainer::csmTotalBinSize - 0.01;
-      }
-
-      AssertFatal(minCoord >= 0.0 && minCoord < SceneContainer::csmTotalBinSize, "Bad minCoord");
-
-      minBin = U32(minCoord / SceneContainer::csmBinSize);
-      AssertFatal(minBin < SceneContainer::csmNumBins, avar("Error, bad clipping! (%g, %d)", minCoord, minBin));
-
-      maxBin = minBin + (SceneContainer::csmNumBins - 1);
-      return;
-   }
-   else 
-   {
-
-      F32 minCoord = mFmod(min, SceneContainer::csmTotalBinSize);
-      
-      if (minCoord < 0.0f) 
-      {
-         minCoord += SceneContainer::csmTotalBinSize;
-
-         // This is truly lame, but it can happen.  There must be a better way to
-         //  deal with this.
-         if (minCoord == SceneContainer::csmTotalBinSize)
-            minCoord = SceneContainer::csmTotalBinSize - 0.01;
-      }
-      AssertFatal(minCoord >= 0.0 && minCoord < SceneContainer::csmTotalBinSize, "Bad minCoord");
-
-      F32 maxCoord = mFmod(max, SceneContainer::csmTotalBinSize);
-      if (maxCoord < 0.0f) {
-         maxCoord += SceneContainer::csmTotalBinSize;
-
-         // This is truly lame, but it can happen.  There must be a better way to
-         //  deal with this.
-         if (maxCoord == SceneContainer::csmTotalBinSize)
-            maxCoord = SceneContainer::csmTotalBinSize - 0.01;
-      }
-      AssertFatal(maxCoord >= 0.0 && maxCoord < SceneContainer::csmTotalBinSize, "Bad maxCoord");
-
-      minBin = U32(minCoord / SceneContainer::csmBinSize);
-      maxBin = U32(maxCoord / SceneContainer::csmBinSize);
-      AssertFatal(minBin < SceneContainer::csmNumBins, avar("Error, bad clipping(min)! (%g, %d)", maxCoord, minBin));
-      AssertFatal(minBin < SceneContainer::csmNumBins, avar("Error, bad clipping(max)! (%g, %d)", maxCoord, maxBin));
-
-      // MSVC6 seems to be generating some bad floating point code around
-      // here when full optimizations are on.  The min != max test should
-      // not be needed, but it clears up the VC issue.
-      if (min != max && minCoord > maxCoord)
-         maxBin += SceneContainer::csmNumBins;
-
-      AssertFatal(maxBin >= minBin, "Error, min should always be less than max!");
-   }
-}
-
 //=============================================================================
 //    Console API.
 //=============================================================================
@@ -1646,4 +1373,57 @@ DefineEngineFunction( containerRayCast, const char*,
    return(returnBuffer);
 }
 
+//-----------------------------------------------------------------------------
+
+DefineEngineFunction( containerRayCastRewound, const char*,
+   ( Point3F start, Point3F end, U32 mask, U32 tick, SceneObject *pExempt ), ( NULL ),
+   "@brief Cast a ray from start to end against the server container as it was on an "
+   "earlier tick.\n\n"
+
+   "Objects the server keeps a history for, such as shapes, are tested where they were "
+   "as of the given tick; everything else is tested where it is now.  Use it with "
+   "GameConnection::getClientViewTick() to test a client's shot against what the client "
+   "saw when it fired.\n"
+
+   "@param start An XYZ vector containing the tail position of the ray.\n"
+   "@param end An XYZ vector containing the head position of the ray\n"
+   "@param mask A bitmask corresponding to the type of objects to check for\n"
+   "@param tick The server tick to rewind to.\n"
+   "@param pExempt An optional ID for a single object that ignored for this raycast\n"
+
+   "@returns A string containing either null, if nothing was struck, or these fields:\n"
+   "<ul><li>The ID of the object that was struck.</li>"
+   "<li>The x, y, z position that it was struck.</li>"
+   "<li>The x, y, z of the normal of the face that was struck.</li></ul>" 
+
+   "@see containerRayCast\n"
+   "@ingroup Game")
+{
+   if (pExempt)
+      pExempt->disableCollision();
+
+   RayInfo rinfo;
+   S32 ret = 0;
+   if (gServerContainer.castRayRewound(tick, start, end, mask, &rinfo) == true)
+      ret = rinfo.object->getId();
+
+   if (pExempt)
+      pExempt->enableCollision();
+
+   char *returnBuffer = Con::getReturnBuffer(256);
+   if(ret)
+   {
+      dSprintf(returnBuffer, 256, "%d %g %g %g %g %g %g",
+               ret, rinfo.point.x, rinfo.point.y, rinfo.point.z,
+               rinfo.normal.x, rinfo.normal.y, rinfo.normal.z);
+   }
+   else
+   {
+      returnBuffer[0] = '0';
+      returnBuffer[1] = '\0';
+   }
+
+   return(returnBuffer);
+}
+
 ConsoleFunctionGroupEnd( Containers );
@@ -31,6 +31,10 @@
 #include "math/mSphere.h"
 #endif
 
+#ifndef _MMATRIX_H_
+#include "math/mMatrix.h"
+#endif
+
 #ifndef _TVECTOR_H_
 #include "core/util/tVector.h"
 #endif
@@ -43,6 +47,10 @@
 #include "console/simObject.h"
 #endif
 
+#ifndef _SCENECONTAINERINDEX_H_
+#include "scene/sceneContainerIndex.h"
+#endif
+
 
 /// @file
 /// SceneObject database.
@@ -76,9 +84,6 @@ class SceneObjectRefBase
 };
 
 
-/// Reference to a scene object.
-class SceneObjectRef : public SceneObjectRefBase< SceneObjectRef > {};
-
 
 /// A contextual hint passed to the polylist methods which
 /// allows it to return the appropriate geometry.
@@ -128,7 +133,20 @@ class SimpleQueryList
 
 /// Database for SceneObjects.
 ///
-/// ScenceContainer implements a grid-based spatial subdivision for the contents of a scene.
+/// SceneContainer keeps the contents of a scene in a SceneContainerIndex,
+/// which narrows queries down to the objects near the query volume, and does
+/// the exact tests against those itself.  By default the index is a
+/// SceneContainerAABBTree.
+///
+/// The queries that take a SceneQueryContext keep all their state in the
+/// context, so they can run from several threads at once, each with a
+/// context of its own, as long as nothing adds, removes or moves objects in
+/// the container until they are all done.  The castRay() methods of the
+/// objects the rays may hit must be safe to run in parallel as well.  Use
+/// setReadOnly() to catch changes to the container while such queries run.
+///
+/// The overloads without a context use contexts owned by the container and
+/// may only be used from the main thread.
 class SceneContainer
 {
       enum CastRayType
@@ -157,23 +175,29 @@ class SceneContainer
          void *key;
       };
 
+      enum
+      {
+         /// Number of ticks of history kept for objects that want one.
+         HistoryLength = 32,
+      };
+
    private:
 
       Link mStart;
       Link mEnd;
 
-      /// Container queries based on #mCurrSeqKey are are not re-entrant;
-      /// this is used to detect when it happens.
-      bool mSearchInProgress;
+      /// Spatial index of the objects in the container.
+      SceneContainerIndex* mIndex;
 
-      /// Current sequence key.
-      U32 mCurrSeqKey;
+      /// Contexts that are free for queries made without one.  Each of
+      /// these queries takes a context of its own, so they can nest.
+      Vector< SceneQueryContext* > mFreeQueryContexts;
 
-      SceneObjectRef* mFreeRefPool;
-      Vector< SceneObjectRef* > mRefPoolBlocks;
+      /// Number of queries made without a context that are running.
+      U32 mNumQueriesInProgress;
 
-      SceneObjectRef* mBinArray;
-      SceneObjectRef mOverflowBin;
+      /// If true, the objects in the container must not change.
+      bool mReadOnly;
 
       /// A vector that contains just the water and physical zone
       /// object types which is used to optimize searches.
@@ -182,10 +206,31 @@ class SceneContainer
       /// Vector that contains just the terrain objects in the container.
       Vector< SceneObject* > mTerrains;
 
-      static const U32 csmNumBins;
-      static const F32 csmBinSize;
-      static const F32 csmTotalBinSize;
-      static const U32 csmRefPoolBlockSize;
+      /// Where an object was as of a recorded tick.
+      struct HistoryState
+      {
+         MatrixF worldToObj;
+         Box3F worldBox;
+      };
+
+      /// The recorded states of one object, indexed like #mHistoryTicks.
+      struct ObjectHistory
+      {
+         SceneObject* object;
+         HistoryState states[ HistoryLength ];
+      };
+
+      /// Histories of the objects that keep one.
+      Vector< ObjectHistory* > mHistory;
+
+      /// Ring of the ticks recorded in the histories.
+      U32 mHistoryTicks[ HistoryLength ];
+
+      /// Slot in #mHistoryTicks of the last recorded tick.
+      U32 mHistoryHead;
+
+      /// Number of slots recorded so far, up to #HistoryLength.
+      U32 mHistoryCount;
 
    public:
 
@@ -198,6 +243,21 @@ class SceneContainer
       /// Return a vector containing all terrain objects in this container.
       const Vector< SceneObject* >& getTerrains() const { return mTerrains; }
 
+      /// Return the spatial index of the container.
+      SceneContainerIndex* getIndex() const { return mIndex; }
+
+      /// Replace the spatial index of the container.  The objects in the
+      /// container are moved to the new index, and the container takes
+      /// ownership of it.
+      void setIndex( SceneContainerIndex* index );
+
+      /// Mark the container as read-only while queries run in parallel.
+      /// Adding, removing or moving objects while it is read-only asserts.
+      void setReadOnly( bool readOnly ) { mReadOnly = readOnly; }
+
+      /// Return true if the container is marked as read-only.
+      bool isReadOnly() const { return mReadOnly; }
+
       /// @name Basic database operations
       /// @{
 
@@ -214,6 +274,10 @@ class SceneContainer
       void findObjects( const Box3F& box, U32 mask, FindCallback, void *key = NULL );
       void findObjects( const Frustum& frustum, U32 mask, FindCallback, void *key = NULL );
 
+      /// Like findObjects(), but with the query's state kept in @a context.
+      void findObjects( SceneQueryContext& context, const Box3F& box, U32 mask, FindCallback callback, void *key = NULL );
+      void findObjects( SceneQueryContext& context, const Frustum& frustum, U32 mask, FindCallback callback, void *key = NULL );
+
       void polyhedronFindObjects( const Polyhedron& polyhedron, U32 mask, FindCallback, void *key = NULL );
 
       /// Find all objects of the given type(s) and add them to the given vector.
@@ -227,6 +291,10 @@ class SceneContainer
       ///
       void findObjectList( const Frustum& frustum, U32 mask, Vector< SceneObject* >* outFound );
 
+      /// Like findObjectList(), but with the query's state kept in @a context.
+      void findObjectList( SceneQueryContext& context, const Box3F& box, U32 mask, Vector< SceneObject* >* outFound );
+      void findObjectList( SceneQueryContext& context, const Frustum& frustum, U32 mask, Vector< SceneObject* >* outFound );
+
       /// @}
 
       /// @name Line intersection
@@ -240,10 +308,74 @@ class SceneContainer
       /// Test against rendered geometry -- slow.
       bool castRayRendered( const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback = NULL );
 
+      /// Test a batch of rays against collision geometry.
+      ///
+      /// Gives the same results as calling castRay() for each ray, but walks
+      /// the index once per packet of rays and then tests each object found
+      /// against all the rays of the packet that may touch it in one go.
+      ///
+      /// @param numRays Number of rays.
+      /// @param starts Start points of the rays.
+      /// @param ends End points of the rays.
+      /// @param mask Object type mask (@see SimObjectTypes).
+      /// @param outInfos The result for each ray; rays that hit nothing get a
+      ///   NULL object.
+      /// @param callback Called to accept each hit, as for castRay().
+      /// @return The number of rays that hit something.
+      U32 castRays( U32 numRays, const Point3F* starts, const Point3F* ends, U32 mask, RayInfo* outInfos, CastRayCallback callback = NULL );
+
+      /// Like castRay(), but with the query's state kept in @a context.
+      bool castRay( SceneQueryContext& context, const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback = NULL );
+
+      /// Like castRayRendered(), but with the query's state kept in @a context.
+      bool castRayRendered( SceneQueryContext& context, const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback = NULL );
+
+      /// Like castRays(), but with the query's state kept in @a context.
+      U32 castRays( SceneQueryContext& context, U32 numRays, const Point3F* starts, const Point3F* ends, U32 mask, RayInfo* outInfos, CastRayCallback callback = NULL );
+
       bool collideBox(const Point3F &start, const Point3F &end, U32 mask, RayInfo* info);
 
       /// @}
 
+      /// @name Object history
+      ///
+      /// The container keeps a short history of where objects with
+      /// SceneObject::mKeepHistory set have been, so queries can be run
+      /// against the scene as it was on an earlier tick.  The server uses
+      /// this to test a client's shots against what the client saw, which
+      /// lags behind the server by the client's latency.
+      ///
+      /// Ticks older than the history are treated as the oldest one kept,
+      /// and ticks newer than the last one recorded as the present.
+      /// @{
+
+      /// Record where every object with a history is as of the given tick.
+      /// Ticks must be recorded in increasing order.
+      void recordHistory( U32 tick );
+
+      /// Return the oldest tick still in the history, or 0 if none is.
+      U32 getOldestHistoryTick() const;
+
+      /// Get where an object was as of the given tick.  Returns false if the
+      /// container isn't keeping a history for the object.
+      bool getHistoryState( SceneObject* object, U32 tick, MatrixF* worldToObj, Box3F* worldBox ) const;
+
+      /// Like castRay(), but with objects that have a history tested where
+      /// they were as of the given tick.
+      bool castRayRewound( U32 tick, const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback = NULL );
+
+      /// Like findObjects(), but with objects that have a history tested
+      /// where they were as of the given tick.
+      void findObjectsRewound( U32 tick, const Box3F& box, U32 mask, FindCallback callback, void *key = NULL );
+
+      /// Like castRayRewound(), but with the query's state kept in @a context.
+      bool castRayRewound( SceneQueryContext& context, U32 tick, const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback = NULL );
+
+      /// Like findObjectsRewound(), but with the query's state kept in @a context.
+      void findObjectsRewound( SceneQueryContext& context, U32 tick, const Box3F& box, U32 mask, FindCallback callback, void *key = NULL );
+
+      /// @}
+
       /// @name Poly list
       /// @{
 
@@ -263,17 +395,8 @@ class SceneContainer
       /// @param object A SceneObject.
       bool removeObject( SceneObject* object );
 
-      void addRefPoolBlock();
-      SceneObjectRef* allocateObjectRef();
-      void freeObjectRef(SceneObjectRef*);
-      void insertIntoBins( SceneObject* object );
-      void removeFromBins( SceneObject* object );
-
-      /// Make sure that we're not just sticking the object right back
-      /// where it came from.  The overloaded insertInto is so we don't calculate
-      /// the ranges twice.
-      void checkBins( SceneObject* object );
-      void insertIntoBins(SceneObject*, U32, U32, U32, U32);
+      /// Update the index for a change in the bounds of an object.
+      void updateObject( SceneObject* object );
 
       void initRadiusSearch(const Point3F& searchPoint,
          const F32      searchRadius,
@@ -292,13 +415,29 @@ class SceneContainer
 
       void cleanupSearchVectors();
 
-      /// Base cast ray code
-      bool _castRay( U32 type, const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback );
+      /// Take a context for a query made without one.
+      SceneQueryContext* _beginQuery();
+
+      /// Give back the context of a query made without one.
+      void _endQuery( SceneQueryContext* context );
+
+      /// Base cast ray code.  If @a skipHistory is true, objects with a
+      /// history are left out.
+      bool _castRay( SceneQueryContext& context, U32 type, const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback, bool skipHistory = false );
+
+      /// Put the objects of the given type(s) whose bounds overlap @a box
+      /// into the object list of @a context.  If @a skipHistory is true,
+      /// objects with a history are left out.
+      void _findObjects( SceneQueryContext& context, const Box3F& box, U32 mask, bool skipHistory = false );
 
       void _findSpecialObjects( const Vector< SceneObject* >& vector, U32 mask, FindCallback, void *key = NULL );
       void _findSpecialObjects( const Vector< SceneObject* >& vector, const Box3F &box, U32 mask, FindCallback callback, void *key = NULL );   
 
-      static void getBinRange( const F32 min, const F32 max, U32& minBin, U32& maxBin );
+      void _addHistory( SceneObject* object );
+      void _removeHistory( SceneObject* object );
+
+      /// Return the history slot holding the given tick, or -1 for the present.
+      S32 _findHistorySlot( U32 tick ) const;
 };
 
 //-----------------------------------------------------------------------------
@@ -306,30 +445,4 @@ class SceneContainer
 extern SceneContainer gServerContainer;
 extern SceneContainer gClientContainer;
 
-//-----------------------------------------------------------------------------
-
-inline void SceneContainer::freeObjectRef(SceneObjectRef* trash)
-{
-   trash->object = NULL;
-   trash->nextInBin = NULL;
-   trash->prevInBin = NULL;
-   trash->nextInObj = mFreeRefPool;
-   mFreeRefPool     = trash;
-}
-
-//-----------------------------------------------------------------------------
-
-inline SceneObjectRef* SceneContainer::allocateObjectRef()
-{
-   if( mFreeRefPool == NULL )
-      addRefPoolBlock();
-   AssertFatal( mFreeRefPool!=NULL, "Error, should always have a free reference here!" );
-
-   SceneObjectRef* ret = mFreeRefPool;
-   mFreeRefPool = mFreeRefPool->nextInObj;
-
-   ret->nextInObj = NULL;
-   return ret;
-}
-
 #endif // !_SCENECONTAINER_H_
\ No newline at end of file
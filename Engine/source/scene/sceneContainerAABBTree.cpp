@@ -0,0 +1,748 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneContainerAABBTree.h"
+
+#include "platform/profiler.h"
+
+// Test segment packets against node boxes four segments at a time with SSE
+// where the compiler targets it.
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#  define TORQUE_AABBTREE_SSE
+#  include <xmmintrin.h>
+#endif
+
+
+const F32 SceneContainerAABBTree::csmMargin = 1.0f;
+
+
+//-----------------------------------------------------------------------------
+
+static inline Box3F mergeBoxes( const Box3F& a, const Box3F& b )
+{
+   Box3F result( a );
+   result.minExtents.setMin( b.minExtents );
+   result.maxExtents.setMax( b.maxExtents );
+   return result;
+}
+
+//-----------------------------------------------------------------------------
+
+static inline F32 getSurfaceArea( const Box3F& box )
+{
+   const F32 x = box.len_x();
+   const F32 y = box.len_y();
+   const F32 z = box.len_z();
+   return 2.0f * ( x * y + y * z + z * x );
+}
+
+//-----------------------------------------------------------------------------
+
+static inline Box3F growBox( const Box3F& box, F32 margin )
+{
+   const Point3F grow( margin, margin, margin );
+   return Box3F( box.minExtents - grow, box.maxExtents + grow );
+}
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+   /// Segments of a packet laid out to be tested four at a time.
+   struct SegmentPacket
+   {
+      enum
+      {
+         MaxGroups = SceneContainerIndex::MaxSegments / 4,
+      };
+
+      F32 startX[ SceneContainerIndex::MaxSegments ];
+      F32 startY[ SceneContainerIndex::MaxSegments ];
+      F32 startZ[ SceneContainerIndex::MaxSegments ];
+
+      /// Inverse of the segment directions.  Axes a segment doesn't move
+      /// along get a huge value of the right sign rather than infinity so no
+      /// test produces a NaN.
+      F32 invDirX[ SceneContainerIndex::MaxSegments ];
+      F32 invDirY[ SceneContainerIndex::MaxSegments ];
+      F32 invDirZ[ SceneContainerIndex::MaxSegments ];
+
+      void set( U32 index, const Point3F& start, const Point3F& end )
+      {
+         startX[ index ] = start.x;
+         startY[ index ] = start.y;
+         startZ[ index ] = start.z;
+         invDirX[ index ] = getInverse( end.x - start.x );
+         invDirY[ index ] = getInverse( end.y - start.y );
+         invDirZ[ index ] = getInverse( end.z - start.z );
+      }
+
+      static F32 getInverse( F32 d )
+      {
+         if( mFabs( d ) < 1e-30f )
+            d = d < 0.0f ? -1e-30f : 1e-30f;
+         return 1.0f / d;
+      }
+
+      /// Return a bit for each of the four segments of the group that
+      /// touches @a box.
+      U32 testGroup( U32 group, const Box3F& box ) const
+      {
+         const U32 first = group * 4;
+
+#ifdef TORQUE_AABBTREE_SSE
+         __m128 start = _mm_loadu_ps( &startX[ first ] );
+         __m128 invDir = _mm_loadu_ps( &invDirX[ first ] );
+         __m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.minExtents.x ), start ), invDir );
+         __m128 t2 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.maxExtents.x ), start ), invDir );
+         __m128 tMin = _mm_max_ps( _mm_setzero_ps(), _mm_min_ps( t1, t2 ) );
+         __m128 tMax = _mm_min_ps( _mm_set1_ps( 1.0f ), _mm_max_ps( t1, t2 ) );
+
+         start = _mm_loadu_ps( &startY[ first ] );
+         invDir = _mm_loadu_ps( &invDirY[ first ] );
+         t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.minExtents.y ), start ), invDir );
+         t2 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.maxExtents.y ), start ), invDir );
+         tMin = _mm_max_ps( tMin, _mm_min_ps( t1, t2 ) );
+         tMax = _mm_min_ps( tMax, _mm_max_ps( t1, t2 ) );
+
+         start = _mm_loadu_ps( &startZ[ first ] );
+         invDir = _mm_loadu_ps( &invDirZ[ first ] );
+         t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.minExtents.z ), start ), invDir );
+         t2 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( box.maxExtents.z ), start ), invDir );
+         tMin = _mm_max_ps( tMin, _mm_min_ps( t1, t2 ) );
+         tMax = _mm_min_ps( tMax, _mm_max_ps( t1, t2 ) );
+
+         return _mm_movemask_ps( _mm_cmple_ps( tMin, tMax ) );
+#else
+         U32 result = 0;
+         for( U32 i = first; i < first + 4; ++ i )
+         {
+            F32 t1 = ( box.minExtents.x - startX[ i ] ) * invDirX[ i ];
+            F32 t2 = ( box.maxExtents.x - startX[ i ] ) * invDirX[ i ];
+            F32 tMin = getMax( 0.0f, getMin( t1, t2 ) );
+            F32 tMax = getMin( 1.0f, getMax( t1, t2 ) );
+
+            t1 = ( box.minExtents.y - startY[ i ] ) * invDirY[ i ];
+            t2 = ( box.maxExtents.y - startY[ i ] ) * invDirY[ i ];
+            tMin = getMax( tMin, getMin( t1, t2 ) );
+            tMax = getMin( tMax, getMax( t1, t2 ) );
+
+            t1 = ( box.minExtents.z - startZ[ i ] ) * invDirZ[ i ];
+            t2 = ( box.maxExtents.z - startZ[ i ] ) * invDirZ[ i ];
+            tMin = getMax( tMin, getMin( t1, t2 ) );
+            tMax = getMin( tMax, getMax( t1, t2 ) );
+
+            if( tMin <= tMax )
+               result |= 1 << ( i - first );
+         }
+         return result;
+#endif
+      }
+
+      /// Return the segments of @a mask that touch @a box.
+      U32 test( U32 mask, const Box3F& box ) const
+      {
+         U32 result = 0;
+         for( U32 group = 0; group < MaxGroups; ++ group )
+         {
+            if( ( mask >> ( group * 4 ) ) & 0xF )
+               result |= testGroup( group, box ) << ( group * 4 );
+         }
+         return result & mask;
+      }
+   };
+}
+
+//-----------------------------------------------------------------------------
+
+SceneContainerAABBTree::SceneContainerAABBTree()
+{
+   mRoot = NullNode;
+   mFreeNode = NullNode;
+
+   VECTOR_SET_ASSOCIATION( mNodes );
+   VECTOR_SET_ASSOCIATION( mGlobals );
+}
+
+//-----------------------------------------------------------------------------
+
+S32 SceneContainerAABBTree::_allocateNode()
+{
+   S32 node = mFreeNode;
+   if( node != NullNode )
+      mFreeNode = mNodes[ node ].parent;
+   else
+   {
+      node = mNodes.size();
+      mNodes.increment();
+   }
+
+   Node& n = mNodes[ node ];
+   n.object = NULL;
+   n.parent = NullNode;
+   n.child1 = NullNode;
+   n.child2 = NullNode;
+   n.height = 0;
+   n.global = false;
+
+   return node;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::_freeNode( S32 node )
+{
+   Node& n = mNodes[ node ];
+   n.object = NULL;
+   n.parent = mFreeNode;
+   n.height = -1;
+
+   mFreeNode = node;
+}
+
+//-----------------------------------------------------------------------------
+
+SceneContainerIndex::Proxy SceneContainerAABBTree::insert( SceneObject* object, const Box3F& worldBox, bool globalBounds )
+{
+   AssertFatal( object != NULL, "SceneContainerAABBTree::insert - No object" );
+
+   S32 node = _allocateNode();
+   mNodes[ node ].object = object;
+
+   if( globalBounds )
+   {
+      mNodes[ node ].box = worldBox;
+      mNodes[ node ].global = true;
+      mGlobals.push_back( node );
+   }
+   else
+   {
+      mNodes[ node ].box = growBox( worldBox, csmMargin );
+      _insertLeaf( node );
+   }
+
+   return node;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::remove( Proxy proxy )
+{
+   AssertFatal( proxy >= 0 && proxy < mNodes.size() && mNodes[ proxy ].object,
+      "SceneContainerAABBTree::remove - Invalid proxy" );
+
+   if( mNodes[ proxy ].global )
+      _removeGlobal( proxy );
+   else
+      _removeLeaf( proxy );
+
+   _freeNode( proxy );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::update( Proxy proxy, const Box3F& worldBox, bool globalBounds )
+{
+   PROFILE_SCOPE( SceneContainerAABBTree_Update );
+
+   AssertFatal( proxy >= 0 && proxy < mNodes.size() && mNodes[ proxy ].object,
+      "SceneContainerAABBTree::update - Invalid proxy" );
+
+   Node& node = mNodes[ proxy ];
+   if( node.global )
+   {
+      if( globalBounds )
+      {
+         node.box = worldBox;
+         return;
+      }
+
+      _removeGlobal( proxy );
+      node.global = false;
+   }
+   else
+   {
+      // Leave the leaf alone as long as the object is still inside it and
+      // the leaf hasn't become much too big for it.
+      if( !globalBounds && node.box.isContained( worldBox ) &&
+          growBox( worldBox, 4.0f * csmMargin ).isContained( node.box ) )
+         return;
+
+      _removeLeaf( proxy );
+   }
+
+   if( globalBounds )
+   {
+      mNodes[ proxy ].box = worldBox;
+      mNodes[ proxy ].global = true;
+      mGlobals.push_back( proxy );
+   }
+   else
+   {
+      mNodes[ proxy ].box = growBox( worldBox, csmMargin );
+      _insertLeaf( proxy );
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::_removeGlobal( S32 node )
+{
+   for( U32 i = 0; i < mGlobals.size(); ++ i )
+      if( mGlobals[ i ] == node )
+      {
+         mGlobals.erase_fast( i );
+         return;
+      }
+
+   AssertFatal( false, "SceneContainerAABBTree::_removeGlobal - Node not in global list" );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::_insertLeaf( S32 leaf )
+{
+   PROFILE_SCOPE( SceneContainerAABBTree_InsertLeaf );
+
+   if( mRoot == NullNode )
+   {
+      mRoot = leaf;
+      mNodes[ leaf ].parent = NullNode;
+      return;
+   }
+
+   // Walk down to the best sibling for the leaf, going by how much surface
+   // area each choice adds to the tree.
+
+   const Box3F leafBox = mNodes[ leaf ].box;
+   S32 index = mRoot;
+   while( !mNodes[ index ].isLeaf() )
+   {
+      const Node& node = mNodes[ index ];
+      const S32 child1 = node.child1;
+      const S32 child2 = node.child2;
+
+      const F32 area = getSurfaceArea( node.box );
+      const F32 combinedArea = getSurfaceArea( mergeBoxes( node.box, leafBox ) );
+
+      // Cost of making a new parent for this node and the leaf.
+      const F32 cost = 2.0f * combinedArea;
+
+      // Minimum cost of pushing the leaf further down.
+      const F32 inheritanceCost = 2.0f * ( combinedArea - area );
+
+      F32 cost1;
+      const Box3F box1 = mergeBoxes( leafBox, mNodes[ child1 ].box );
+      if( mNodes[ child1 ].isLeaf() )
+         cost1 = getSurfaceArea( box1 ) + inheritanceCost;
+      else
+         cost1 = getSurfaceArea( box1 ) - getSurfaceArea( mNodes[ child1 ].box ) + inheritanceCost;
+
+      F32 cost2;
+      const Box3F box2 = mergeBoxes( leafBox, mNodes[ child2 ].box );
+      if( mNodes[ child2 ].isLeaf() )
+         cost2 = getSurfaceArea( box2 ) + inheritanceCost;
+      else
+         cost2 = getSurfaceArea( box2 ) - getSurfaceArea( mNodes[ child2 ].box ) + inheritanceCost;
+
+      if( cost < cost1 && cost < cost2 )
+         break;
+
+      index = cost1 < cost2 ? child1 : child2;
+   }
+
+   const S32 sibling = index;
+
+   // Make a new parent for the sibling and the leaf.
+
+   const S32 oldParent = mNodes[ sibling ].parent;
+   const S32 newParent = _allocateNode();
+
+   Node& parent = mNodes[ newParent ];
+   parent.parent = oldParent;
+   parent.box = mergeBoxes( leafBox, mNodes[ sibling ].box );
+   parent.height = mNodes[ sibling ].height + 1;
+   parent.child1 = sibling;
+   parent.child2 = leaf;
+
+   mNodes[ sibling ].parent = newParent;
+   mNodes[ leaf ].parent = newParent;
+
+   if( oldParent != NullNode )
+   {
+      if( mNodes[ oldParent ].child1 == sibling )
+         mNodes[ oldParent ].child1 = newParent;
+      else
+         mNodes[ oldParent ].child2 = newParent;
+   }
+   else
+      mRoot = newParent;
+
+   _refit( oldParent );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::_removeLeaf( S32 leaf )
+{
+   PROFILE_SCOPE( SceneContainerAABBTree_RemoveLeaf );
+
+   if( leaf == mRoot )
+   {
+      mRoot = NullNode;
+      return;
+   }
+
+   // Put the leaf's sibling in place of their parent.
+
+   const S32 parent = mNodes[ leaf ].parent;
+   const S32 grandParent = mNodes[ parent ].parent;
+   const S32 sibling = mNodes[ parent ].child1 == leaf ? mNodes[ parent ].child2 : mNodes[ parent ].child1;
+
+   if( grandParent != NullNode )
+   {
+      if( mNodes[ grandParent ].child1 == parent )
+         mNodes[ grandParent ].child1 = sibling;
+      else
+         mNodes[ grandParent ].child2 = sibling;
+      mNodes[ sibling ].parent = grandParent;
+   }
+   else
+   {
+      mRoot = sibling;
+      mNodes[ sibling ].parent = NullNode;
+   }
+
+   _freeNode( parent );
+   _refit( grandParent );
+
+   mNodes[ leaf ].parent = NullNode;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::_refit( S32 index )
+{
+   while( index != NullNode )
+   {
+      index = _balance( index );
+
+      Node& node = mNodes[ index ];
+      const Node& child1 = mNodes[ node.child1 ];
+      const Node& child2 = mNodes[ node.child2 ];
+
+      node.height = 1 + getMax( child1.height, child2.height );
+      node.box = mergeBoxes( child1.box, child2.box );
+
+      index = node.parent;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+S32 SceneContainerAABBTree::_balance( S32 iA )
+{
+   Node* A = &mNodes[ iA ];
+   if( A->isLeaf() || A->height < 2 )
+      return iA;
+
+   const S32 iB = A->child1;
+   const S32 iC = A->child2;
+   Node* B = &mNodes[ iB ];
+   Node* C = &mNodes[ iC ];
+
+   const S32 balance = C->height - B->height;
+
+   // Rotate C up.
+   if( balance > 1 )
+   {
+      const S32 iF = C->child1;
+      const S32 iG = C->child2;
+      Node* F = &mNodes[ iF ];
+      Node* G = &mNodes[ iG ];
+
+      // Swap A and C.
+      C->child1 = iA;
+      C->parent = A->parent;
+      A->parent = iC;
+
+      // A's old parent should point to C.
+      if( C->parent != NullNode )
+      {
+         if( mNodes[ C->parent ].child1 == iA )
+            mNodes[ C->parent ].child1 = iC;
+         else
+            mNodes[ C->parent ].child2 = iC;
+      }
+      else
+         mRoot = iC;
+
+      // Rotate.
+      if( F->height > G->height )
+      {
+         C->child2 = iF;
+         A->child2 = iG;
+         G->parent = iA;
+         A->box = mergeBoxes( B->box, G->box );
+         C->box = mergeBoxes( A->box, F->box );
+
+         A->height = 1 + getMax( B->height, G->height );
+         C->height = 1 + getMax( A->height, F->height );
+      }
+      else
+      {
+         C->child2 = iG;
+         A->child2 = iF;
+         F->parent = iA;
+         A->box = mergeBoxes( B->box, F->box );
+         C->box = mergeBoxes( A->box, G->box );
+
+         A->height = 1 + getMax( B->height, F->height );
+         C->height = 1 + getMax( A->height, G->height );
+      }
+
+      return iC;
+   }
+
+   // Rotate B up.
+   if( balance < -1 )
+   {
+      const S32 iD = B->child1;
+      const S32 iE = B->child2;
+      Node* D = &mNodes[ iD ];
+      Node* E = &mNodes[ iE ];
+
+      // Swap A and B.
+      B->child1 = iA;
+      B->parent = A->parent;
+      A->parent = iB;
+
+      // A's old parent should point to B.
+      if( B->parent != NullNode )
+      {
+         if( mNodes[ B->parent ].child1 == iA )
+            mNodes[ B->parent ].child1 = iB;
+         else
+            mNodes[ B->parent ].child2 = iB;
+      }
+      else
+         mRoot = iB;
+
+      // Rotate.
+      if( D->height > E->height )
+      {
+         B->child2 = iD;
+         A->child1 = iE;
+         E->parent = iA;
+         A->box = mergeBoxes( C->box, E->box );
+         B->box = mergeBoxes( A->box, D->box );
+
+         A->height = 1 + getMax( C->height, E->height );
+         B->height = 1 + getMax( A->height, D->height );
+      }
+      else
+      {
+         B->child2 = iE;
+         A->child1 = iD;
+         D->parent = iA;
+         A->box = mergeBoxes( C->box, D->box );
+         B->box = mergeBoxes( A->box, E->box );
+
+         A->height = 1 + getMax( C->height, D->height );
+         B->height = 1 + getMax( A->height, E->height );
+      }
+
+      return iB;
+   }
+
+   return iA;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::findObjects( SceneQueryContext& context, const Box3F& box, Vector< SceneObject* >& outObjects )
+{
+   PROFILE_SCOPE( SceneContainerAABBTree_FindObjects_Box );
+
+   for( U32 i = 0; i < mGlobals.size(); ++ i )
+      outObjects.push_back( mNodes[ mGlobals[ i ] ].object );
+
+   if( mRoot == NullNode )
+      return;
+
+   S32 stack[ MaxStackDepth ];
+   U32 stackSize = 0;
+   stack[ stackSize ++ ] = mRoot;
+
+   while( stackSize )
+   {
+      const Node& node = mNodes[ stack[ -- stackSize ] ];
+      if( !node.box.isOverlapped( box ) )
+         continue;
+
+      if( node.isLeaf() )
+         outObjects.push_back( node.object );
+      else
+      {
+         AssertFatal( stackSize + 2 <= MaxStackDepth, "SceneContainerAABBTree::findObjects - Tree too deep" );
+         stack[ stackSize ++ ] = node.child1;
+         stack[ stackSize ++ ] = node.child2;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::findObjects( SceneQueryContext& context, const Point3F& start, const Point3F& end,
+                                          Vector< SceneObject* >& outObjects )
+{
+   PROFILE_SCOPE( SceneContainerAABBTree_FindObjects_Line );
+
+   for( U32 i = 0; i < mGlobals.size(); ++ i )
+      outObjects.push_back( mNodes[ mGlobals[ i ] ].object );
+
+   if( mRoot == NullNode )
+      return;
+
+   // Set up a slab test against the segment.  Axes the segment doesn't move
+   // along only need the start inside the slab.
+
+   const F32* s = &start.x;
+   const F32* e = &end.x;
+   F32 invDir[ 3 ];
+   bool parallel[ 3 ];
+   for( U32 i = 0; i < 3; ++ i )
+   {
+      const F32 d = e[ i ] - s[ i ];
+      parallel[ i ] = mFabs( d ) < 1e-12f;
+      invDir[ i ] = parallel[ i ] ? 0.0f : 1.0f / d;
+   }
+
+   Box3F segmentBox( start, start );
+   segmentBox.minExtents.setMin( end );
+   segmentBox.maxExtents.setMax( end );
+
+   S32 stack[ MaxStackDepth ];
+   U32 stackSize = 0;
+   stack[ stackSize ++ ] = mRoot;
+
+   while( stackSize )
+   {
+      const Node& node = mNodes[ stack[ -- stackSize ] ];
+      if( !node.box.isOverlapped( segmentBox ) )
+         continue;
+
+      const F32* bmin = &node.box.minExtents.x;
+      const F32* bmax = &node.box.maxExtents.x;
+
+      F32 tMin = 0.0f;
+      F32 tMax = 1.0f;
+      bool hit = true;
+      for( U32 i = 0; i < 3 && hit; ++ i )
+      {
+         if( parallel[ i ] )
+            continue;
+
+         F32 t1 = ( bmin[ i ] - s[ i ] ) * invDir[ i ];
+         F32 t2 = ( bmax[ i ] - s[ i ] ) * invDir[ i ];
+         tMin = getMax( tMin, getMin( t1, t2 ) );
+         tMax = getMin( tMax, getMax( t1, t2 ) );
+         hit = tMin <= tMax;
+      }
+
+      if( !hit )
+         continue;
+
+      if( node.isLeaf() )
+         outObjects.push_back( node.object );
+      else
+      {
+         AssertFatal( stackSize + 2 <= MaxStackDepth, "SceneContainerAABBTree::findObjects - Tree too deep" );
+         stack[ stackSize ++ ] = node.child1;
+         stack[ stackSize ++ ] = node.child2;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerAABBTree::findObjects( SceneQueryContext& context, const Point3F* starts, const Point3F* ends, U32 numSegments,
+                                          Vector< SceneObject* >& outObjects, Vector< U32 >& outSegmentMasks )
+{
+   PROFILE_SCOPE( SceneContainerAABBTree_FindObjects_Packet );
+
+   AssertFatal( numSegments <= MaxSegments, "SceneContainerAABBTree::findObjects - Too many segments" );
+   if( !numSegments )
+      return;
+
+   const U32 allSegments = numSegments == MaxSegments ? 0xFFFFFFFF : ( U32( 1 ) << numSegments ) - 1;
+
+   for( U32 i = 0; i < mGlobals.size(); ++ i )
+   {
+      outObjects.push_back( mNodes[ mGlobals[ i ] ].object );
+      outSegmentMasks.push_back( allSegments );
+   }
+
+   if( mRoot == NullNode )
+      return;
+
+   // Fill out the last group with copies of the first segment; the extra
+   // lanes are masked out.
+   SegmentPacket packet;
+   for( U32 i = 0; i < numSegments; ++ i )
+      packet.set( i, starts[ i ], ends[ i ] );
+   for( U32 i = numSegments; i % 4; ++ i )
+      packet.set( i, starts[ 0 ], ends[ 0 ] );
+
+   // Walk the tree once with all the segments, dropping each one from a
+   // subtree as soon as it misses the subtree's box.
+
+   S32 stack[ MaxStackDepth ];
+   U32 stackMasks[ MaxStackDepth ];
+   U32 stackSize = 0;
+   stack[ stackSize ] = mRoot;
+   stackMasks[ stackSize ++ ] = allSegments;
+
+   while( stackSize )
+   {
+      -- stackSize;
+      const Node& node = mNodes[ stack[ stackSize ] ];
+      const U32 mask = packet.test( stackMasks[ stackSize ], node.box );
+      if( !mask )
+         continue;
+
+      if( node.isLeaf() )
+      {
+         outObjects.push_back( node.object );
+         outSegmentMasks.push_back( mask );
+      }
+      else
+      {
+         AssertFatal( stackSize + 2 <= MaxStackDepth, "SceneContainerAABBTree::findObjects - Tree too deep" );
+         stack[ stackSize ] = node.child1;
+         stackMasks[ stackSize ++ ] = mask;
+         stack[ stackSize ] = node.child2;
+         stackMasks[ stackSize ++ ] = mask;
+      }
+   }
+}
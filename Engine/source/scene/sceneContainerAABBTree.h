@@ -0,0 +1,132 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _SCENECONTAINERAABBTREE_H_
+#define _SCENECONTAINERAABBTREE_H_
+
+#ifndef _SCENECONTAINERINDEX_H_
+   #include "scene/sceneContainerIndex.h"
+#endif
+
+
+/// Container index that keeps objects in a dynamic bounding volume tree.
+///
+/// Every object is a leaf of a binary tree of boxes that is kept balanced as
+/// objects come and go.  Leaves hold the object's world box grown by
+/// #csmMargin so that an object moving by small steps only needs its leaf
+/// refitted once it leaves the grown box.  New leaves go where they add the
+/// least surface area to the tree.
+///
+/// Queries only descend into the parts of the tree that touch the query
+/// volume, so their cost depends on what is near the query rather than on
+/// the size of the map.  Objects with global bounds are kept out of the tree
+/// and returned from every query.
+///
+/// Packets of segments are walked down the tree together, with each node's
+/// box tested against four segments at a time using SSE where available.
+///
+/// The walks keep their stacks on the stack and every object is in the tree
+/// only once, so queries don't need the visited set of their context.
+class SceneContainerAABBTree : public SceneContainerIndex
+{
+   public:
+
+      /// Amount by which the boxes of leaves are grown on each side.
+      static const F32 csmMargin;
+
+   protected:
+
+      enum
+      {
+         NullNode = -1,
+
+         /// Deepest tree the queries can walk.  A balanced tree is nowhere
+         /// near this deep.
+         MaxStackDepth = 256,
+      };
+
+      struct Node
+      {
+         /// Bounds of the node's children, or the grown bounds of the
+         /// leaf's object.
+         Box3F box;
+
+         /// Object of a leaf.
+         SceneObject* object;
+
+         /// Parent node, or the next free node if this one is free.
+         S32 parent;
+
+         S32 child1;
+         S32 child2;
+
+         /// Height of the node above the leaves, or -1 if it is free.
+         S32 height;
+
+         /// Whether the node is an object with global bounds, which is kept
+         /// in #mGlobals rather than in the tree.
+         bool global;
+
+         bool isLeaf() const { return child1 == NullNode; }
+      };
+
+      Vector< Node > mNodes;
+      S32 mRoot;
+      S32 mFreeNode;
+
+      /// Nodes of objects with global bounds.
+      Vector< S32 > mGlobals;
+
+      S32 _allocateNode();
+      void _freeNode( S32 node );
+
+      void _insertLeaf( S32 leaf );
+      void _removeLeaf( S32 leaf );
+
+      /// Rotate the subtree under @a node if it is out of balance and return
+      /// the new root of the subtree.
+      S32 _balance( S32 node );
+
+      /// Refit the boxes and heights from @a node up to the root.
+      void _refit( S32 node );
+
+      void _removeGlobal( S32 node );
+
+   public:
+
+      SceneContainerAABBTree();
+
+      /// Return the height of the tree; 0 if it has only a leaf or is empty.
+      S32 getHeight() const { return mRoot == NullNode ? 0 : mNodes[ mRoot ].height; }
+
+      // SceneContainerIndex.
+      virtual Proxy insert( SceneObject* object, const Box3F& worldBox, bool globalBounds );
+      virtual void remove( Proxy proxy );
+      virtual void update( Proxy proxy, const Box3F& worldBox, bool globalBounds );
+      virtual void findObjects( SceneQueryContext& context, const Box3F& box, Vector< SceneObject* >& outObjects );
+      virtual void findObjects( SceneQueryContext& context, const Point3F& start, const Point3F& end,
+                                Vector< SceneObject* >& outObjects );
+      virtual void findObjects( SceneQueryContext& context, const Point3F* starts, const Point3F* ends, U32 numSegments,
+                                Vector< SceneObject* >& outObjects, Vector< U32 >& outSegmentMasks );
+};
+
+#endif // !_SCENECONTAINERAABBTREE_H_
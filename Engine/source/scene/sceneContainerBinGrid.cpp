@@ -0,0 +1,502 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneContainerBinGrid.h"
+
+#include "platform/profiler.h"
+
+
+const U32 SceneContainerBinGrid::csmNumBins = 16;
+const F32 SceneContainerBinGrid::csmBinSize = 64;
+const F32 SceneContainerBinGrid::csmTotalBinSize = SceneContainerBinGrid::csmBinSize * SceneContainerBinGrid::csmNumBins;
+const U32 SceneContainerBinGrid::csmRefPoolBlockSize = 4096;
+
+
+//-----------------------------------------------------------------------------
+
+SceneContainerBinGrid::SceneContainerBinGrid()
+{
+   mFreeEntry = NullProxy;
+
+   mBinArray = new BinRef[csmNumBins * csmNumBins];
+   for (U32 i = 0; i < csmNumBins * csmNumBins; i++)
+   {
+      mBinArray[i].proxy       = NullProxy;
+      mBinArray[i].nextInBin   = NULL;
+      mBinArray[i].prevInBin   = NULL;
+      mBinArray[i].nextInProxy = NULL;
+   }
+   mOverflowBin.proxy       = NullProxy;
+   mOverflowBin.nextInBin   = NULL;
+   mOverflowBin.prevInBin   = NULL;
+   mOverflowBin.nextInProxy = NULL;
+
+   VECTOR_SET_ASSOCIATION( mEntries );
+   VECTOR_SET_ASSOCIATION( mRefPoolBlocks );
+
+   mFreeRefPool = NULL;
+   _addRefPoolBlock();
+}
+
+//-----------------------------------------------------------------------------
+
+SceneContainerBinGrid::~SceneContainerBinGrid()
+{
+   delete [] mBinArray;
+
+   for (U32 i = 0; i < mRefPoolBlocks.size(); i++)
+      delete [] mRefPoolBlocks[i];
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerBinGrid::_addRefPoolBlock()
+{
+   mRefPoolBlocks.push_back(new BinRef[csmRefPoolBlockSize]);
+
+   BinRef* block = mRefPoolBlocks.last();
+   for (U32 i = 0; i < csmRefPoolBlockSize; i++)
+   {
+      block[i].proxy       = NullProxy;
+      block[i].prevInBin   = NULL;
+      block[i].nextInBin   = NULL;
+      block[i].nextInProxy = i + 1 < csmRefPoolBlockSize ? &block[i + 1] : mFreeRefPool;
+   }
+
+   mFreeRefPool = &block[0];
+}
+
+//-----------------------------------------------------------------------------
+
+inline SceneContainerBinGrid::BinRef* SceneContainerBinGrid::_allocateRef()
+{
+   if (mFreeRefPool == NULL)
+      _addRefPoolBlock();
+
+   BinRef* ref = mFreeRefPool;
+   mFreeRefPool = mFreeRefPool->nextInProxy;
+   return ref;
+}
+
+//-----------------------------------------------------------------------------
+
+inline void SceneContainerBinGrid::_freeRef(BinRef* trash)
+{
+   trash->proxy       = NullProxy;
+   trash->nextInBin   = NULL;
+   trash->prevInBin   = NULL;
+   trash->nextInProxy = mFreeRefPool;
+   mFreeRefPool       = trash;
+}
+
+//-----------------------------------------------------------------------------
+
+SceneContainerIndex::Proxy SceneContainerBinGrid::insert(SceneObject* object, const Box3F& worldBox, bool globalBounds)
+{
+   AssertFatal(object != NULL, "No object?");
+
+   Proxy proxy = mFreeEntry;
+   if (proxy != NullProxy)
+      mFreeEntry = mEntries[proxy].nextFree;
+   else
+   {
+      proxy = mEntries.size();
+      mEntries.increment();
+   }
+
+   Entry& entry = mEntries[proxy];
+   entry.object   = object;
+   entry.refHead  = NULL;
+   entry.nextFree = NullProxy;
+
+   // The first thing we do is find which bins are covered in x and y...
+   U32 minX, maxX, minY, maxY;
+   getBinRange(worldBox.minExtents.x, worldBox.maxExtents.x, minX, maxX);
+   getBinRange(worldBox.minExtents.y, worldBox.maxExtents.y, minY, maxY);
+
+   // For huge objects, dump them into the overflow bin.  Otherwise, everything
+   //  goes into the grid...
+   bool overflow = globalBounds || ((maxX - minX + 1) >= csmNumBins && (maxY - minY + 1) >= csmNumBins);
+   _insertIntoBins(proxy, minX, maxX, minY, maxY, overflow);
+
+   return proxy;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerBinGrid::remove(Proxy proxy)
+{
+   _removeFromBins(proxy);
+
+   Entry& entry = mEntries[proxy];
+   entry.object   = NULL;
+   entry.nextFree = mFreeEntry;
+   mFreeEntry     = proxy;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerBinGrid::update(Proxy proxy, const Box3F& worldBox, bool globalBounds)
+{
+   PROFILE_SCOPE(SceneContainerBinGrid_Update);
+
+   // Let's see if the object has strayed out of the bins that it's currently
+   //  in...
+   U32 minX, maxX, minY, maxY;
+   getBinRange(worldBox.minExtents.x, worldBox.maxExtents.x, minX, maxX);
+   getBinRange(worldBox.minExtents.y, worldBox.maxExtents.y, minY, maxY);
+
+   bool overflow = globalBounds || ((maxX - minX + 1) >= csmNumBins && (maxY - minY + 1) >= csmNumBins);
+
+   const Entry& entry = mEntries[proxy];
+   bool inOverflow = entry.refHead->prevInBin == &mOverflowBin;
+   if (entry.minX != minX || entry.maxX != maxX ||
+       entry.minY != minY || entry.maxY != maxY || inOverflow != overflow)
+   {
+      // We have to rebin the object
+      _removeFromBins(proxy);
+      _insertIntoBins(proxy, minX, maxX, minY, maxY, overflow);
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerBinGrid::_insertIntoBins(Proxy proxy, U32 minX, U32 maxX, U32 minY, U32 maxY, bool overflow)
+{
+   PROFILE_SCOPE(SceneContainerBinGrid_InsertIntoBins);
+
+   Entry& entry = mEntries[proxy];
+   AssertFatal(entry.refHead == NULL, "Error, already have a bin chain!");
+
+   // Store the current regions for later queries
+   entry.minX = minX;
+   entry.maxX = maxX;
+   entry.minY = minY;
+   entry.maxY = maxY;
+
+   if (!overflow)
+   {
+      BinRef** pCurrInsert = &entry.refHead;
+
+      for (U32 i = minY; i <= maxY; i++)
+      {
+         U32 insertY = i % csmNumBins;
+         U32 base    = insertY * csmNumBins;
+         for (U32 j = minX; j <= maxX; j++)
+         {
+            U32 insertX = j % csmNumBins;
+
+            BinRef* ref = _allocateRef();
+
+            ref->proxy       = proxy;
+            ref->nextInBin   = mBinArray[base + insertX].nextInBin;
+            ref->prevInBin   = &mBinArray[base + insertX];
+            ref->nextInProxy = NULL;
+
+            if (mBinArray[base + insertX].nextInBin)
+               mBinArray[base + insertX].nextInBin->prevInBin = ref;
+            mBinArray[base + insertX].nextInBin = ref;
+
+            *pCurrInsert = ref;
+            pCurrInsert  = &ref->nextInProxy;
+         }
+      }
+   }
+   else
+   {
+      BinRef* ref = _allocateRef();
+
+      ref->proxy       = proxy;
+      ref->nextInBin   = mOverflowBin.nextInBin;
+      ref->prevInBin   = &mOverflowBin;
+      ref->nextInProxy = NULL;
+
+      if (mOverflowBin.nextInBin)
+         mOverflowBin.nextInBin->prevInBin = ref;
+      mOverflowBin.nextInBin = ref;
+
+      entry.refHead = ref;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerBinGrid::_removeFromBins(Proxy proxy)
+{
+   PROFILE_SCOPE(SceneContainerBinGrid_RemoveFromBins);
+
+   BinRef* chain = mEntries[proxy].refHead;
+   mEntries[proxy].refHead = NULL;
+
+   while (chain)
+   {
+      BinRef* trash = chain;
+      chain = chain->nextInProxy;
+
+      AssertFatal(trash->prevInBin != NULL, "Error, must have a previous entry in the bin!");
+      if (trash->nextInBin)
+         trash->nextInBin->prevInBin = trash->prevInBin;
+      trash->prevInBin->nextInBin = trash->nextInBin;
+
+      _freeRef(trash);
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+inline void SceneContainerBinGrid::_gather(SceneQueryContext& context, BinRef* chain, Vector<SceneObject*>& outObjects)
+{
+   while (chain)
+   {
+      if (context.visit(chain->proxy))
+         outObjects.push_back(mEntries[chain->proxy].object);
+      chain = chain->nextInBin;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerBinGrid::findObjects(SceneQueryContext& context, const Box3F& box, Vector<SceneObject*>& outObjects)
+{
+   PROFILE_SCOPE(SceneContainerBinGrid_FindObjects_Box);
+
+   U32 minX, maxX, minY, maxY;
+   getBinRange(box.minExtents.x, box.maxExtents.x, minX, maxX);
+   getBinRange(box.minExtents.y, box.maxExtents.y, minY, maxY);
+   context.beginVisit(mEntries.size());
+
+   for (U32 i = minY; i <= maxY; i++)
+   {
+      U32 insertY = i % csmNumBins;
+      U32 base    = insertY * csmNumBins;
+      for (U32 j = minX; j <= maxX; j++)
+      {
+         U32 insertX = j % csmNumBins;
+         _gather(context, mBinArray[base + insertX].nextInBin, outObjects);
+      }
+   }
+
+   _gather(context, mOverflowBin.nextInBin, outObjects);
+}
+
+//-----------------------------------------------------------------------------
+
+// DMMNOTE: There are still some optimizations to be done here.  In particular:
+//           - The optimal grid size isn't necessarily what we have set here. possibly
+//             a resolution of 16 meters would give better results
+//           - The line rasterizer is pretty lame.  Unfortunately we can't use a
+//             simple bres. here, since we need to check every grid element that the line
+//             passes through, which bres does _not_ do for us.  Possibly there's a
+//             rasterizer for anti-aliased lines that will serve better than what
+//             we have below.
+
+void SceneContainerBinGrid::findObjects(SceneQueryContext& context, const Point3F& start, const Point3F& end, Vector<SceneObject*>& outObjects)
+{
+   PROFILE_SCOPE(SceneContainerBinGrid_FindObjects_Line);
+
+   context.beginVisit(mEntries.size());
+
+   // In the overflow bin, the world box is always going to intersect the line.
+   _gather(context, mOverflowBin.nextInBin, outObjects);
+
+   // These are just for rasterizing the line against the grid.  We want the x coord
+   //  of the start to be <= the x coord of the end
+   Point3F normalStart, normalEnd;
+   if (start.x <= end.x)
+   {
+      normalStart = start;
+      normalEnd   = end;
+   }
+   else
+   {
+      normalStart = end;
+      normalEnd   = start;
+   }
+
+   // Ok, let's scan the grids.  The simplest way to do this will be to scan across in
+   //  x, finding the y range for each affected bin...
+   U32 minX, maxX;
+   U32 minY, maxY;
+   getBinRange(normalStart.x, normalEnd.x, minX, maxX);
+   getBinRange(getMin(normalStart.y, normalEnd.y),
+               getMax(normalStart.y, normalEnd.y), minY, maxY);
+
+   // We'll optimize the case that the line is contained in one bin row or column, which
+   //  will be quite a few lines.  No sense doing more work than we have to...
+   //
+   if ((mFabs(normalStart.x - normalEnd.x) < csmTotalBinSize && minX == maxX) ||
+       (mFabs(normalStart.y - normalEnd.y) < csmTotalBinSize && minY == maxY))
+   {
+      U32 count;
+      U32 incX, incY;
+      if (minX == maxX)
+      {
+         count = maxY - minY + 1;
+         incX  = 0;
+         incY  = 1;
+      }
+      else
+      {
+         count = maxX - minX + 1;
+         incX  = 1;
+         incY  = 0;
+      }
+
+      U32 x = minX;
+      U32 y = minY;
+      for (U32 i = 0; i < count; i++)
+      {
+         U32 checkX = x % csmNumBins;
+         U32 checkY = y % csmNumBins;
+
+         _gather(context, mBinArray[(checkY * csmNumBins) + checkX].nextInBin, outObjects);
+
+         x += incX;
+         y += incY;
+      }
+   }
+   else
+   {
+      // Oh well, let's earn our keep.  We know that after the above conditional, we're
+      //  going to cross at least one boundary, so that simplifies our job...
+
+      F32 currStartX = normalStart.x;
+
+      AssertFatal(currStartX != normalEnd.x, "This is going to cause problems in SceneContainerBinGrid::findObjects");
+      while (currStartX != normalEnd.x)
+      {
+         F32 currEndX   = getMin(currStartX + csmTotalBinSize, normalEnd.x);
+
+         F32 currStartT = (currStartX - normalStart.x) / (normalEnd.x - normalStart.x);
+         F32 currEndT   = (currEndX   - normalStart.x) / (normalEnd.x - normalStart.x);
+
+         F32 y1 = normalStart.y + (normalEnd.y - normalStart.y) * currStartT;
+         F32 y2 = normalStart.y + (normalEnd.y - normalStart.y) * currEndT;
+
+         U32 subMinX, subMaxX;
+         getBinRange(currStartX, currEndX, subMinX, subMaxX);
+
+         F32 subStartX = currStartX;
+         F32 subEndX   = currStartX;
+
+         if (currStartX < 0.0f)
+            subEndX -= mFmod(subEndX, csmBinSize);
+         else
+            subEndX += (csmBinSize - mFmod(subEndX, csmBinSize));
+
+         for (U32 currXBin = subMinX; currXBin <= subMaxX; currXBin++)
+         {
+            U32 checkX = currXBin % csmNumBins;
+
+            F32 subStartT = (subStartX - currStartX) / (currEndX - currStartX);
+            F32 subEndT   = getMin(F32((subEndX   - currStartX) / (currEndX - currStartX)), 1.f);
+
+            F32 subY1 = y1 + (y2 - y1) * subStartT;
+            F32 subY2 = y1 + (y2 - y1) * subEndT;
+
+            U32 newMinY, newMaxY;
+            getBinRange(getMin(subY1, subY2), getMax(subY1, subY2), newMinY, newMaxY);
+
+            for (U32 i = newMinY; i <= newMaxY; i++)
+            {
+               U32 checkY = i % csmNumBins;
+               _gather(context, mBinArray[(checkY * csmNumBins) + checkX].nextInBin, outObjects);
+            }
+
+            subStartX = subEndX;
+            subEndX   = getMin(subEndX + csmBinSize, currEndX);
+         }
+
+         currStartX = currEndX;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerBinGrid::getBinRange( const F32 min, const F32 max, U32& minBin, U32& maxBin )
+{
+   AssertFatal(max >= min, "Error, bad range! in getBinRange");
+
+   if ((max - min) >= (csmTotalBinSize - csmBinSize))
+   {
+      F32 minCoord = mFmod(min, csmTotalBinSize);
+      if (minCoord < 0.0f)
+      {
+         minCoord += csmTotalBinSize;
+
+         // This is truly lame, but it can happen.  There must be a better way to
+         //  deal with this.
+         if (minCoord == csmTotalBinSize)
+            minCoord = csmTotalBinSize - 0.01;
+      }
+
+      AssertFatal(minCoord >= 0.0 && minCoord < csmTotalBinSize, "Bad minCoord");
+
+      minBin = U32(minCoord / csmBinSize);
+      AssertFatal(minBin < csmNumBins, avar("Error, bad clipping! (%g, %d)", minCoord, minBin));
+
+      maxBin = minBin + (csmNumBins - 1);
+      return;
+   }
+   else
+   {
+
+      F32 minCoord = mFmod(min, csmTotalBinSize);
+
+      if (minCoord < 0.0f)
+      {
+         minCoord += csmTotalBinSize;
+
+         // This is truly lame, but it can happen.  There must be a better way to
+         //  deal with this.
+         if (minCoord == csmTotalBinSize)
+            minCoord = csmTotalBinSize - 0.01;
+      }
+      AssertFatal(minCoord >= 0.0 && minCoord < csmTotalBinSize, "Bad minCoord");
+
+      F32 maxCoord = mFmod(max, csmTotalBinSize);
+      if (maxCoord < 0.0f) {
+         maxCoord += csmTotalBinSize;
+
+         // This is truly lame, but it can happen.  There must be a better way to
+         //  deal with this.
+         if (maxCoord == csmTotalBinSize)
+            maxCoord = csmTotalBinSize - 0.01;
+      }
+      AssertFatal(maxCoord >= 0.0 && maxCoord < csmTotalBinSize, "Bad maxCoord");
+
+      minBin = U32(minCoord / csmBinSize);
+      maxBin = U32(maxCoord / csmBinSize);
+      AssertFatal(minBin < csmNumBins, avar("Error, bad clipping(min)! (%g, %d)", maxCoord, minBin));
+      AssertFatal(minBin < csmNumBins, avar("Error, bad clipping(max)! (%g, %d)", maxCoord, maxBin));
+
+      // MSVC6 seems to be generating some bad floating point code around
+      // here when full optimizations are on.  The min != max test should
+      // not be needed, but it clears up the VC issue.
+      if (min != max && minCoord > maxCoord)
+         maxBin += csmNumBins;
+
+      AssertFatal(maxBin >= minBin, "Error, min should always be less than max!");
+   }
+}
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _SCENECONTAINERBINGRID_H_
+#define _SCENECONTAINERBINGRID_H_
+
+#ifndef _SCENECONTAINERINDEX_H_
+   #include "scene/sceneContainerIndex.h"
+#endif
+
+
+/// Container index that hashes objects into a fixed grid of bins.
+///
+/// The grid is #csmNumBins by #csmNumBins bins of #csmBinSize units in x and
+/// y and wraps around, so objects that are a multiple of #csmTotalBinSize
+/// apart share bins.  Objects too large for the grid, and objects with global
+/// bounds, go into an overflow bin that every query looks at.
+///
+/// This was the only index containers had before SceneContainerAABBTree.  It
+/// is cheap to update and works well for small, dense scenes, but large maps
+/// alias many distant objects into each bin.
+class SceneContainerBinGrid : public SceneContainerIndex
+{
+   public:
+
+      static const U32 csmNumBins;
+      static const F32 csmBinSize;
+      static const F32 csmTotalBinSize;
+      static const U32 csmRefPoolBlockSize;
+
+   protected:
+
+      /// Link of an object into one bin.
+      struct BinRef
+      {
+         /// Object that is referenced in the link.
+         Proxy proxy;
+
+         /// Next link in chain of the bin.
+         BinRef* nextInBin;
+
+         /// Previous link in chain of the bin.
+         BinRef* prevInBin;
+
+         /// Next link in chain that is associated with #proxy.
+         BinRef* nextInProxy;
+      };
+
+      struct Entry
+      {
+         SceneObject* object;
+
+         /// Links of the object into its bins, or NULL if the entry is free.
+         BinRef* refHead;
+
+         /// Bins the object is in.
+         U32 minX;
+         U32 maxX;
+         U32 minY;
+         U32 maxY;
+
+         /// Next free entry, if this one is free.
+         Proxy nextFree;
+      };
+
+      Vector< Entry > mEntries;
+      Proxy mFreeEntry;
+
+      BinRef* mBinArray;
+      BinRef mOverflowBin;
+
+      BinRef* mFreeRefPool;
+      Vector< BinRef* > mRefPoolBlocks;
+
+      void _addRefPoolBlock();
+      BinRef* _allocateRef();
+      void _freeRef( BinRef* ref );
+
+      void _insertIntoBins( Proxy proxy, U32 minX, U32 maxX, U32 minY, U32 maxY, bool overflow );
+      void _removeFromBins( Proxy proxy );
+
+      /// Append the objects in a bin chain that haven't been returned yet by
+      /// the current query.  The visited set of @a context is used to return
+      /// each object only once even if it is in several of the bins a query
+      /// looks at.
+      void _gather( SceneQueryContext& context, BinRef* chain, Vector< SceneObject* >& outObjects );
+
+   public:
+
+      SceneContainerBinGrid();
+      virtual ~SceneContainerBinGrid();
+
+      /// Return the range of bins that the span from @a min to @a max covers.
+      /// @a maxBin may be past the end of the grid; take it modulo
+      /// #csmNumBins to get the actual bin.
+      static void getBinRange( const F32 min, const F32 max, U32& minBin, U32& maxBin );
+
+      // SceneContainerIndex.
+      virtual Proxy insert( SceneObject* object, const Box3F& worldBox, bool globalBounds );
+      virtual void remove( Proxy proxy );
+      virtual void update( Proxy proxy, const Box3F& worldBox, bool globalBounds );
+      virtual void findObjects( SceneQueryContext& context, const Box3F& box, Vector< SceneObject* >& outObjects );
+      virtual void findObjects( SceneQueryContext& context, const Point3F& start, const Point3F& end,
+                                Vector< SceneObject* >& outObjects );
+};
+
+#endif // !_SCENECONTAINERBINGRID_H_
@@ -0,0 +1,115 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneContainerIndex.h"
+
+#include "core/util/tVector.h"
+
+
+namespace {
+
+   struct SegmentCandidate
+   {
+      SceneObject* object;
+      U32 mask;
+   };
+
+   S32 QSORT_CALLBACK compareCandidates( const void* a, const void* b )
+   {
+      const SceneObject* objA = reinterpret_cast< const SegmentCandidate* >( a )->object;
+      const SceneObject* objB = reinterpret_cast< const SegmentCandidate* >( b )->object;
+      return objA < objB ? -1 : objA > objB ? 1 : 0;
+   }
+}
+
+//=============================================================================
+//    SceneQueryContext.
+//=============================================================================
+
+SceneQueryContext::SceneQueryContext()
+   : mVisitKey( 0 )
+{
+   VECTOR_SET_ASSOCIATION( mObjects );
+   VECTOR_SET_ASSOCIATION( mSegmentMasks );
+   VECTOR_SET_ASSOCIATION( mVisitKeys );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneQueryContext::beginVisit( U32 numProxies )
+{
+   // New proxies start out with a key that no visit uses.
+   const U32 oldSize = mVisitKeys.size();
+   if( oldSize < numProxies )
+   {
+      mVisitKeys.setSize( numProxies );
+      dMemset( mVisitKeys.address() + oldSize, 0, ( numProxies - oldSize ) * sizeof( U32 ) );
+   }
+
+   mVisitKey ++;
+   if( mVisitKey == 0 )
+   {
+      // The key wrapped around; forget all the old visits.
+      dMemset( mVisitKeys.address(), 0, mVisitKeys.size() * sizeof( U32 ) );
+      mVisitKey = 1;
+   }
+}
+
+//=============================================================================
+//    SceneContainerIndex.
+//=============================================================================
+
+void SceneContainerIndex::findObjects( SceneQueryContext& context, const Point3F* starts, const Point3F* ends, U32 numSegments,
+                                       Vector< SceneObject* >& outObjects, Vector< U32 >& outSegmentMasks )
+{
+   AssertFatal( numSegments <= MaxSegments, "SceneContainerIndex::findObjects - Too many segments" );
+
+   Vector< SegmentCandidate > candidates;
+   Vector< SceneObject* > found;
+
+   for( U32 i = 0; i < numSegments; ++ i )
+   {
+      found.clear();
+      findObjects( context, starts[ i ], ends[ i ], found );
+
+      for( U32 j = 0; j < found.size(); ++ j )
+      {
+         candidates.increment();
+         candidates.last().object = found[ j ];
+         candidates.last().mask = U32( 1 ) << i;
+      }
+   }
+
+   dQsort( candidates.address(), candidates.size(), sizeof( SegmentCandidate ), compareCandidates );
+
+   for( U32 i = 0; i < candidates.size(); )
+   {
+      SceneObject* object = candidates[ i ].object;
+      U32 mask = 0;
+      for( ; i < candidates.size() && candidates[ i ].object == object; ++ i )
+         mask |= candidates[ i ].mask;
+
+      outObjects.push_back( object );
+      outSegmentMasks.push_back( mask );
+   }
+}
@@ -0,0 +1,145 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _SCENECONTAINERINDEX_H_
+#define _SCENECONTAINERINDEX_H_
+
+#ifndef _MBOX_H_
+   #include "math/mBox.h"
+#endif
+
+#ifndef _TVECTOR_H_
+   #include "core/util/tVector.h"
+#endif
+
+
+class SceneObject;
+
+
+/// State of a single query of a SceneContainer and its index.
+///
+/// Queries keep everything they need while they run in a context rather
+/// than in the container or the index, so any number of them can run at
+/// once, on any thread, as long as each has a context of its own and the
+/// container isn't modified until they are done.  A context can be reused
+/// for one query after another and keeps its memory between them.
+class SceneQueryContext
+{
+   public:
+
+      /// Objects found by the current query.
+      Vector< SceneObject* > mObjects;
+
+      /// Segment masks of #mObjects for queries with packets of segments.
+      Vector< U32 > mSegmentMasks;
+
+   protected:
+
+      /// Key of the last visit of each proxy.
+      Vector< U32 > mVisitKeys;
+
+      /// Key of the current visit.
+      U32 mVisitKey;
+
+   public:
+
+      SceneQueryContext();
+
+      /// Start a new, empty visited set for proxies below @a numProxies.
+      void beginVisit( U32 numProxies );
+
+      /// Add @a proxy to the visited set and return true if it wasn't in it
+      /// yet.
+      bool visit( S32 proxy )
+      {
+         if( mVisitKeys[ proxy ] == mVisitKey )
+            return false;
+
+         mVisitKeys[ proxy ] = mVisitKey;
+         return true;
+      }
+};
+
+
+/// Spatial index that a SceneContainer uses to find objects by their bounds.
+///
+/// The index only knows objects by the world boxes it is given and never
+/// looks at the objects themselves.  Queries return every object whose
+/// indexed bounds may touch the query volume, each object once, and leave the
+/// exact tests to the container.
+///
+/// @see SceneContainer::setIndex
+class SceneContainerIndex
+{
+   public:
+
+      /// Handle of an object in the index.
+      typedef S32 Proxy;
+
+      enum
+      {
+         /// Handle of an object that isn't in the index.
+         NullProxy = -1,
+
+         /// Most segments a single query can take; one bit per segment of
+         /// a U32 mask.
+         MaxSegments = 32,
+      };
+
+      virtual ~SceneContainerIndex() {}
+
+      /// Add an object to the index.
+      ///
+      /// @param object Object to return from queries.
+      /// @param worldBox World space bounds of the object.
+      /// @param globalBounds If true, the object is returned from every query.
+      /// @return The handle of the object.
+      virtual Proxy insert( SceneObject* object, const Box3F& worldBox, bool globalBounds ) = 0;
+
+      /// Remove an object from the index.
+      virtual void remove( Proxy proxy ) = 0;
+
+      /// Note that the bounds of an object have changed.
+      virtual void update( Proxy proxy, const Box3F& worldBox, bool globalBounds ) = 0;
+
+      /// Append the objects whose bounds may overlap @a box to @a outObjects.
+      virtual void findObjects( SceneQueryContext& context, const Box3F& box, Vector< SceneObject* >& outObjects ) = 0;
+
+      /// Append the objects whose bounds may touch the line segment from
+      /// @a start to @a end to @a outObjects.
+      virtual void findObjects( SceneQueryContext& context, const Point3F& start, const Point3F& end,
+                                Vector< SceneObject* >& outObjects ) = 0;
+
+      /// Find the objects whose bounds may touch any of a packet of line
+      /// segments in one pass.
+      ///
+      /// For each object found, the object is appended to @a outObjects and
+      /// a mask with bit i set for each segment i that it may touch is
+      /// appended to @a outSegmentMasks.  The default runs a query per
+      /// segment and merges the results.
+      ///
+      /// @param numSegments Number of segments, up to #MaxSegments.
+      virtual void findObjects( SceneQueryContext& context, const Point3F* starts, const Point3F* ends, U32 numSegments,
+                                Vector< SceneObject* >& outObjects, Vector< U32 >& outSegmentMasks );
+};
+
+#endif // !_SCENECONTAINERINDEX_H_
@@ -69,10 +69,24 @@ MODULE_BEGIN( Scene )
          "If true, zone culling will be disabled and the scene contents will only be culled against the root frustum.\n\n"
          "@ingroup Rendering\n" );
 
+      Con::addVariable( "$Scene::disableOcclusionBuffer", TypeBool, &SceneCullingState::smDisableOcclusionBuffer,
+         "If true, objects will not be culled against the software depth buffer that occluders are rasterized "
+         "into for each view.\n\n"
+         "@ingroup Rendering\n" );
+
+      Con::addVariable( "$Scene::parallelCullThreshold", TypeS32, &SceneCullingState::smParallelCullThreshold,
+         "Number of objects from which on culling spreads the frustum and zone tests over the threads of the "
+         "global thread pool.  0 keeps culling on the main thread.\n\n"
+         "@ingroup Rendering" );
+
       Con::addVariable( "$Scene::renderBoundingBoxes", TypeBool, &SceneManager::smRenderBoundingBoxes,
          "If true, the bounding boxes of objects will be displayed.\n\n"
          "@ingroup Rendering" );
 
+      Con::addVariable( "$Scene::useScopeIndex", TypeBool, &SceneManager::smUseScopeIndex,
+         "If true, network scoping builds one index of the scene per tick and shares it across all client connections.\n\n"
+         "@ingroup Networking" );
+
       Con::addVariable( "$Scene::maxOccludersPerZone", TypeS32, &SceneCullingState::smMaxOccludersPerZone,
          "Maximum number of occluders that will be concurrently allowed into the scene culling state of any given zone.\n\n"
          "@ingroup Rendering" );
@@ -97,6 +111,7 @@ MODULE_END;
 
 bool SceneManager::smRenderBoundingBoxes;
 bool SceneManager::smLockDiffuseFrustum = false;
+bool SceneManager::smUseScopeIndex = true;
 SceneCameraState SceneManager::smLockedDiffuseCamera = SceneCameraState( RectI(), Frustum(), MatrixF(), MatrixF() );
 
 SceneManager* gClientSceneGraph = NULL;
@@ -481,6 +496,10 @@ void SceneManager::scopeScene( CameraScopeQuery* query, NetConnection* netConnec
    //
    // So, we perform a simple box query on the area covered by the camera query
    // and then scope in everything that is in range.
+   //
+   // Every connection runs this query each time it writes a packet.  Rather
+   // than walking the container's bins over and over, we snapshot the scene
+   // into a scope index once per tick and run all the queries against that.
    
    // Set up scoping info.
 
@@ -496,7 +515,15 @@ void SceneManager::scopeScene( CameraScopeQuery* query, NetConnection* netConnec
    Box3F area( query->visibleDistance );
    area.setCenter( query->pos );
 
-   getContainer()->findObjects( area, 0xFFFFFFFF, _scopeCallback, &info );
+   if( smUseScopeIndex )
+   {
+      if( !mScopeIndex.isValid() )
+         mScopeIndex.build( getContainer(), mClampF( mVisibleDistance * 0.25f, 16.f, 2048.f ) );
+
+      mScopeIndex.findObjects( area, _scopeCallback, &info );
+   }
+   else
+      getContainer()->findObjects( area, 0xFFFFFFFF, _scopeCallback, &info );
 }
 
 //-----------------------------------------------------------------------------
@@ -508,6 +535,7 @@ bool SceneManager::addObjectToScene( SceneObject* object )
    // Mark the object as belonging to us.
 
    object->mSceneManager = this;
+   mScopeIndex.invalidate();
 
    // Register with managers except its the root zone.
 
@@ -550,6 +578,7 @@ void SceneManager::removeObjectFromScene( SceneObject* obj )
    // Clear out the reference to us.
 
    obj->mSceneManager = NULL;
+   mScopeIndex.invalidate();
 }
 
 //-----------------------------------------------------------------------------
@@ -559,7 +588,9 @@ void SceneManager::notifyObjectDirty( SceneObject* object )
    // Update container state.
 
    if( object->mContainer )
-      object->mContainer->checkBins( object );
+      object->mContainer->updateObject( object );
+
+   mScopeIndex.invalidate();
 
    // Mark zoning state as dirty.
 
@@ -59,6 +59,10 @@
 #include "core/util/tSignal.h"
 #endif
 
+#ifndef _SCENESCOPEINDEX_H_
+#include "scene/sceneScopeIndex.h"
+#endif
+
 
 class LightManager;
 class SceneRootZone;
@@ -105,6 +109,10 @@ class SceneManager
       /// If true, render the AABBs of objects for debugging.
       static bool smRenderBoundingBoxes;
 
+      /// If true, scope queries for network connections share a single
+      /// SceneScopeIndex per tick rather than each querying the container.
+      static bool smUseScopeIndex;
+
    protected:
 
       /// Whether this is the client-side scene.
@@ -131,6 +139,10 @@ class SceneManager
 
       F32 mNearClip;
 
+      /// Snapshot of the scene shared by all connections scoped in a tick.
+      /// @see scopeScene
+      SceneScopeIndex mScopeIndex;
+
       FogData mFogData;
 
       WaterFogData mWaterFogData;
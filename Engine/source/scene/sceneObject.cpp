@@ -113,9 +113,9 @@ SceneObject::SceneObject()
    mRenderWorldBox = Box3F(Point3F(0, 0, 0), Point3F(0, 0, 0));
    mRenderWorldSphere = SphereF(Point3F(0, 0, 0), 0);
 
-   mContainerSeqKey = 0;
-
-   mBinRefHead = NULL;
+   mContainerIndexProxy = -1;
+   mContainerHistoryIndex = -1;
+   mKeepHistory = false;
 
    mSceneManager = NULL;
 
@@ -123,10 +123,6 @@ SceneObject::SceneObject()
    mZoneRefHead = NULL;
    mZoneRefDirty = false;
 
-   mBinMinX = 0xFFFFFFFF;
-   mBinMaxX = 0xFFFFFFFF;
-   mBinMinY = 0xFFFFFFFF;
-   mBinMaxY = 0xFFFFFFFF;
    mLightPlugin = NULL;
 
    mMount.object = NULL;
@@ -146,7 +142,7 @@ SceneObject::SceneObject()
 
 SceneObject::~SceneObject()
 {
-   AssertFatal( mZoneRefHead == NULL && mBinRefHead == NULL,
+   AssertFatal( mZoneRefHead == NULL && mContainerIndexProxy == -1,
       "SceneObject::~SceneObject - Object still linked in reference lists!");
    AssertFatal( !mSceneObjectLinks,
       "SceneObject::~SceneObject() - object is still linked to SceneTrackers" );
@@ -322,34 +322,27 @@ class SceneObject : public NetObject, private SceneContainer::Link, public Proce
 
       /// @name SceneContainer Interface
       ///
-      /// When objects are searched, we go through all the zones and ask them for
-      /// all of their objects. Because an object can exist in multiple zones, the
-      /// container sequence key is set to the id of the current search. Then, while
-      /// searching, we check to see if an object's sequence key is the same as the
-      /// current search key. If it is, it will NOT be added to the list of returns
-      /// since it has already been processed.
+      /// The container finds objects through its SceneContainerIndex, which
+      /// knows each object by the proxy it handed out when the object was
+      /// added.
       ///
       /// @{
 
       /// Container database that the object is assigned to.
       SceneContainer* mContainer;
 
-      /// SceneContainer sequence key.
-      U32 mContainerSeqKey;
+      /// Handle of the object in the index of #mContainer.
+      S32 mContainerIndexProxy;
 
-      ///
-      SceneObjectRef* mBinRefHead;
-
-      U32 mBinMinX;
-      U32 mBinMaxX;
-      U32 mBinMinY;
-      U32 mBinMaxY;
-
-      /// Returns the container sequence key.
-      U32 getContainerSeqKey() const { return mContainerSeqKey; }
+      /// Index of this object's history in #mContainer, or -1 if the
+      /// container isn't keeping one.
+      S32 mContainerHistoryIndex;
 
-      /// Sets the container sequence key.
-      void setContainerSeqKey( const U32 key ) { mContainerSeqKey = key;  }
+      /// If true, the server container keeps a history of where this
+      /// object has been, so it can be tested as it was on an earlier tick.
+      /// Must be set before the object is added to the container.
+      /// @see SceneContainer::castRayRewound
+      bool mKeepHistory;
 
       /// @}
 
@@ -559,6 +552,17 @@ class SceneObject : public NetObject, private SceneContainer::Link, public Proce
       ///   if method is not implemented.
       virtual void buildSilhouette( const SceneCameraState& cameraState, Vector< Point3F >& outPoints ) {}
 
+      /// Append world-space triangles that the object can be used to occlude other objects
+      /// with to the given list, three points per triangle.  This is used by the occlusion
+      /// buffer of SceneCullingState.
+      ///
+      /// The triangles must lie within the object's opaque rendered geometry.  They need not
+      /// cover all of it.
+      ///
+      /// @param outTriangles Vector to append the triangle points to.  Leave untouched if
+      ///   the object does not occlude.
+      virtual void buildOcclusionMesh( Vector< Point3F >& outTriangles ) {}
+
       /// Return true if the given point is contained by the object's (collision) shape.
       ///
       /// The default implementation will return true if the point is within the object's
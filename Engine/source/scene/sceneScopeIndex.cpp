@@ -0,0 +1,248 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneScopeIndex.h"
+
+#include "scene/sceneObject.h"
+#include "console/sim.h"
+#include "platform/profiler.h"
+
+
+//-----------------------------------------------------------------------------
+
+SceneScopeIndex::SceneScopeIndex()
+   : mNumLarge( 0 ),
+     mOrigin( 0.f, 0.f ),
+     mCellSize( 1.f ),
+     mNumCellsX( 0 ),
+     mNumCellsY( 0 ),
+     mIsValid( false ),
+     mBuildTime( 0 )
+{
+   VECTOR_SET_ASSOCIATION( mEntries );
+   VECTOR_SET_ASSOCIATION( mGathered );
+   VECTOR_SET_ASSOCIATION( mGatheredCells );
+   VECTOR_SET_ASSOCIATION( mCellStart );
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneScopeIndex::isValid() const
+{
+   return mIsValid && mBuildTime == Sim::getCurrentTime();
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneScopeIndex::_gatherCallback( SceneObject* object, void* key )
+{
+   SceneScopeIndex* index = reinterpret_cast< SceneScopeIndex* >( key );
+
+   index->mGathered.increment();
+   Entry& entry = index->mGathered.last();
+
+   entry.object = object;
+   entry.worldBox = object->getWorldBox();
+}
+
+//-----------------------------------------------------------------------------
+
+inline U32 SceneScopeIndex::_getCellX( F32 x ) const
+{
+   return U32( mClampF( ( x - mOrigin.x ) / mCellSize, 0.f, F32( mNumCellsX - 1 ) ) );
+}
+
+inline U32 SceneScopeIndex::_getCellY( F32 y ) const
+{
+   return U32( mClampF( ( y - mOrigin.y ) / mCellSize, 0.f, F32( mNumCellsY - 1 ) ) );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneScopeIndex::build( SceneContainer* container, F32 cellSize )
+{
+   PROFILE_SCOPE( SceneScopeIndex_build );
+
+   // Snapshot the candidates.  The container's object list only
+   // yields objects that have collision enabled just like its box
+   // queries do.
+
+   mGathered.clear();
+   container->findObjects( 0xFFFFFFFF, _gatherCallback, this );
+
+   const U32 numGathered = mGathered.size();
+
+   // Split off the objects that don't fit into a single cell
+   // and find the area covered by the rest.
+
+   mGatheredCells.setSize( numGathered );
+
+   Point2F minCenter( F32_MAX, F32_MAX );
+   Point2F maxCenter( -F32_MAX, -F32_MAX );
+   U32 numLarge = 0;
+
+   for( U32 i = 0; i < numGathered; ++ i )
+   {
+      const Entry& entry = mGathered[ i ];
+      const Box3F& box = entry.worldBox;
+
+      if( entry.object->isGlobalBounds() ||
+          box.len_x() > cellSize ||
+          box.len_y() > cellSize )
+      {
+         mGatheredCells[ i ] = U32_MAX;
+         numLarge ++;
+         continue;
+      }
+
+      const Point3F center = box.getCenter();
+      minCenter.setMin( Point2F( center.x, center.y ) );
+      maxCenter.setMax( Point2F( center.x, center.y ) );
+   }
+
+   // Lay out the grid.  If the scene is too spread out for the
+   // preferred cell size, grow the cells.  Objects stay small
+   // enough to fit as the cells only get larger.
+
+   const U32 numSmall = numGathered - numLarge;
+   if( numSmall )
+   {
+      const F32 extent = getMax( maxCenter.x - minCenter.x, maxCenter.y - minCenter.y );
+
+      mOrigin = minCenter;
+      mCellSize = getMax( cellSize, extent / F32( MaxCellsPerAxis - 1 ) );
+      mNumCellsX = getMin( U32( ( maxCenter.x - minCenter.x ) / mCellSize ) + 1, U32( MaxCellsPerAxis ) );
+      mNumCellsY = getMin( U32( ( maxCenter.y - minCenter.y ) / mCellSize ) + 1, U32( MaxCellsPerAxis ) );
+   }
+   else
+   {
+      mOrigin.set( 0.f, 0.f );
+      mCellSize = cellSize;
+      mNumCellsX = 1;
+      mNumCellsY = 1;
+   }
+
+   const U32 numCells = mNumCellsX * mNumCellsY;
+
+   // Counting sort the small objects by cell.
+
+   mCellStart.setSize( numCells + 1 );
+   dMemset( mCellStart.address(), 0, mCellStart.memSize() );
+
+   for( U32 i = 0; i < numGathered; ++ i )
+   {
+      if( mGatheredCells[ i ] == U32_MAX )
+         continue;
+
+      const Point3F center = mGathered[ i ].worldBox.getCenter();
+      const U32 cell = _getCellY( center.y ) * mNumCellsX + _getCellX( center.x );
+
+      mGatheredCells[ i ] = cell;
+      mCellStart[ cell + 1 ] ++;
+   }
+
+   mCellStart[ 0 ] = numLarge;
+   for( U32 i = 1; i <= numCells; ++ i )
+      mCellStart[ i ] += mCellStart[ i - 1 ];
+
+   mEntries.setSize( numGathered );
+
+   U32 largeIndex = 0;
+   for( U32 i = 0; i < numGathered; ++ i )
+   {
+      const U32 cell = mGatheredCells[ i ];
+      if( cell == U32_MAX )
+         mEntries[ largeIndex ++ ] = mGathered[ i ];
+      else
+         mEntries[ mCellStart[ cell ] ++ ] = mGathered[ i ];
+   }
+
+   // The scatter has advanced each start offset to the start
+   // of the next cell; shift them back.
+
+   for( U32 i = numCells; i > 0; -- i )
+      mCellStart[ i ] = mCellStart[ i - 1 ];
+   mCellStart[ 0 ] = numLarge;
+
+   mNumLarge = numLarge;
+   mIsValid = true;
+   mBuildTime = Sim::getCurrentTime();
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneScopeIndex::findObjects( const Box3F& box, FindCallback callback, void* key ) const
+{
+   PROFILE_SCOPE( SceneScopeIndex_findObjects );
+
+   AssertFatal( mIsValid, "SceneScopeIndex::findObjects - Index is out of date" );
+
+   const Entry* entries = mEntries.address();
+
+   // Test the objects outside of the grid.
+
+   for( U32 i = 0; i < mNumLarge; ++ i )
+   {
+      const Entry& entry = entries[ i ];
+      if( entry.object->isScopeable() &&
+          ( entry.worldBox.isOverlapped( box ) || entry.object->isGlobalBounds() ) )
+         callback( entry.object, key );
+   }
+
+   if( mEntries.size() == mNumLarge )
+      return;
+
+   // Objects in the grid are binned by their center and no larger
+   // than a cell, so anything overlapping the box has its center
+   // within half a cell of it.
+
+   const F32 halfCell = mCellSize * 0.5f;
+
+   if( box.maxExtents.x + halfCell < mOrigin.x ||
+       box.maxExtents.y + halfCell < mOrigin.y ||
+       box.minExtents.x - halfCell > mOrigin.x + mNumCellsX * mCellSize ||
+       box.minExtents.y - halfCell > mOrigin.y + mNumCellsY * mCellSize )
+      return;
+
+   const U32 minX = _getCellX( box.minExtents.x - halfCell );
+   const U32 maxX = _getCellX( box.maxExtents.x + halfCell );
+   const U32 minY = _getCellY( box.minExtents.y - halfCell );
+   const U32 maxY = _getCellY( box.maxExtents.y + halfCell );
+
+   // Cells in a row are adjacent in the array so walk each row's
+   // range as a single span.
+
+   for( U32 y = minY; y <= maxY; ++ y )
+   {
+      const U32 rowBase = y * mNumCellsX;
+      const U32 start = mCellStart[ rowBase + minX ];
+      const U32 end = mCellStart[ rowBase + maxX + 1 ];
+
+      for( U32 i = start; i < end; ++ i )
+      {
+         const Entry& entry = entries[ i ];
+         if( entry.worldBox.isOverlapped( box ) && entry.object->isScopeable() )
+            callback( entry.object, key );
+      }
+   }
+}
@@ -0,0 +1,136 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _SCENESCOPEINDEX_H_
+#define _SCENESCOPEINDEX_H_
+
+#ifndef _SCENECONTAINER_H_
+   #include "scene/sceneContainer.h"
+#endif
+
+#ifndef _MBOX_H_
+   #include "math/mBox.h"
+#endif
+
+#ifndef _TVECTOR_H_
+   #include "core/util/tVector.h"
+#endif
+
+
+class SceneObject;
+
+
+/// A flat snapshot of the scopeable objects in a scene, built once per tick and
+/// then shared by every client connection that scopes the scene in that tick.
+///
+/// The regular container query walks the container's index for every
+/// connection and then tests each object it returns.  With many clients, the
+/// bulk of that work is identical from one connection to the next.  The scope index instead packs the bounds of all
+/// candidate objects into a single array sorted by the cell of a coarse 2D grid
+/// so that each per-connection box query only walks a few contiguous spans.
+///
+/// Objects larger than a grid cell (and objects with global bounds) are kept in
+/// a separate list at the front of the array and tested by every query.
+///
+/// The index is invalidated whenever an object is added to, removed from, or
+/// moved in the scene and is never trusted across a change in sim time.
+class SceneScopeIndex
+{
+   public:
+
+      typedef SceneContainer::FindCallback FindCallback;
+
+      enum
+      {
+         /// Maximum number of grid cells along either axis.
+         MaxCellsPerAxis = 256
+      };
+
+   protected:
+
+      struct Entry
+      {
+         SceneObject* object;
+         Box3F worldBox;
+      };
+
+      /// All candidates; the large objects come first, then the grid
+      /// objects sorted by cell.
+      Vector< Entry > mEntries;
+
+      /// Scratch space for building #mEntries.
+      Vector< Entry > mGathered;
+      Vector< U32 > mGatheredCells;
+
+      /// Number of entries at the front of #mEntries that are not in the grid.
+      U32 mNumLarge;
+
+      /// Offset into #mEntries of the first object in each cell.  Has one
+      /// extra element at the end so that cell @c i spans
+      /// [ mCellStart[ i ], mCellStart[ i + 1 ] ).
+      Vector< U32 > mCellStart;
+
+      Point2F mOrigin;
+      F32 mCellSize;
+      U32 mNumCellsX;
+      U32 mNumCellsY;
+
+      bool mIsValid;
+      U32 mBuildTime;
+
+      /// Container query callback collecting the candidates.
+      static void _gatherCallback( SceneObject* object, void* key );
+
+      /// Clamp a world-space coordinate to a cell index.
+      U32 _getCellX( F32 x ) const;
+      U32 _getCellY( F32 y ) const;
+
+   public:
+
+      SceneScopeIndex();
+
+      /// Return true if the index reflects the current state of the scene.
+      bool isValid() const;
+
+      /// Mark the index as out of date.
+      void invalidate() { mIsValid = false; }
+
+      /// Rebuild the index from the current contents of @a container.
+      ///
+      /// @param container Container to snapshot.
+      /// @param cellSize Preferred size of a grid cell.  Should be in the order of
+      ///   the scoping distance.  Grows if the scene would otherwise need more than
+      ///   #MaxCellsPerAxis cells along an axis.
+      void build( SceneContainer* container, F32 cellSize );
+
+      /// Call @a callback for every scopeable object whose world box overlaps
+      /// @a box or that has global bounds.
+      ///
+      /// This yields the same objects as the container box query done in
+      /// SceneManager::scopeScene, minus the ones that aren't scopeable.
+      void findObjects( const Box3F& box, FindCallback callback, void* key = NULL ) const;
+
+      /// Return the number of objects in the index.
+      U32 getNumObjects() const { return mEntries.size(); }
+};
+
+#endif // !_SCENESCOPEINDEX_H_
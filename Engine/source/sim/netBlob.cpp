@@ -0,0 +1,531 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "sim/netBlob.h"
+
+#include "sim/netConnection.h"
+#include "core/stream/bitStream.h"
+#include "core/stream/fileStream.h"
+#include "core/crc.h"
+#include "core/util/safeDelete.h"
+#include "console/console.h"
+#include "zlib/zlib.h"
+
+//-----------------------------------------------------------------------------
+// NetBlob
+//-----------------------------------------------------------------------------
+
+Vector< StrongRefPtr<NetBlob> > NetBlob::smCache;
+
+NetBlob::NetBlob()
+   : mCRC(0),
+     mRawSize(0),
+     mRawCRC(0)
+{
+}
+
+NetBlob *NetBlob::create(const void *data, U32 size)
+{
+   if(size > MaxSize)
+      return NULL;
+
+   U32 rawCRC = CRC::calculateCRC(data, size);
+   for(S32 i = smCache.size() - 1; i >= 0; i--)
+   {
+      NetBlob *blob = smCache[i];
+      if(blob->mRawSize == size && blob->mRawCRC == rawCRC)
+         return blob;
+   }
+
+   NetBlob *blob = new NetBlob;
+   blob->mRawSize = size;
+   blob->mRawCRC = rawCRC;
+
+   uLongf compressedSize = compressBound(size);
+   blob->mData.setSize(compressedSize);
+   if(compress2(blob->mData.address(), &compressedSize, (const Bytef *) data, size, Z_BEST_COMPRESSION) != Z_OK ||
+      compressedSize > MaxSize)
+   {
+      delete blob;
+      return NULL;
+   }
+   blob->mData.setSize(compressedSize);
+   blob->mData.compact();
+   blob->mCRC = CRC::calculateCRC(blob->mData.address(), blob->mData.size());
+
+   if(smCache.size() == MaxCached)
+      smCache.pop_front();
+   smCache.push_back(blob);
+
+   return blob;
+}
+
+bool NetBlob::uncompress(const void *data, U32 size, void *out, U32 rawSize)
+{
+   uLongf outSize = rawSize;
+   return ::uncompress((Bytef *) out, &outSize, (const Bytef *) data, size) == Z_OK && outSize == rawSize;
+}
+
+//-----------------------------------------------------------------------------
+// Events
+//-----------------------------------------------------------------------------
+
+/// Tells the other side a blob is ready for it.
+class BlobOfferEvent : public NetEvent
+{
+public:
+   typedef NetEvent Parent;
+
+   U32 mType;
+   U32 mSequence;
+   U32 mCRC;
+   U32 mSize;
+   U32 mRawSize;
+
+   BlobOfferEvent(U32 type = 0, U32 sequence = 0, NetBlob *blob = NULL)
+   {
+      mType = type;
+      mSequence = sequence;
+      mCRC = blob ? blob->getCRC() : 0;
+      mSize = blob ? blob->getSize() : 0;
+      mRawSize = blob ? blob->getRawSize() : 0;
+   }
+
+   virtual void pack(NetConnection *, BitStream *bstream)
+   {
+      bstream->writeRangedU32(mType, 0, NetConnection::NumBlobTypes - 1);
+      bstream->write(mSequence);
+      bstream->write(mCRC);
+      bstream->write(mSize);
+      bstream->write(mRawSize);
+   }
+
+   virtual void write(NetConnection *connection, BitStream *bstream)
+   {
+      pack(connection, bstream);
+   }
+
+   virtual void unpack(NetConnection *, BitStream *bstream)
+   {
+      mType = bstream->readRangedU32(0, NetConnection::NumBlobTypes - 1);
+      bstream->read(&mSequence);
+      bstream->read(&mCRC);
+      bstream->read(&mSize);
+      bstream->read(&mRawSize);
+   }
+
+   virtual void process(NetConnection *connection)
+   {
+      connection->blobOffered(mType, mSequence, mCRC, mSize, mRawSize);
+   }
+
+   DECLARE_CONOBJECT(BlobOfferEvent);
+};
+
+IMPLEMENT_CO_NETEVENT_V1(BlobOfferEvent);
+
+ConsoleDocClass( BlobOfferEvent,
+				"@brief Used by NetConnection to offer a compressed blob of data, such as the datablocks, to the other side.\n\n"
+				"Not intended for game development, for editors or internal use only.\n\n "
+				"@internal");
+
+/// Asks for a blob that was offered, starting at some offset.
+class BlobRequestEvent : public NetEvent
+{
+public:
+   typedef NetEvent Parent;
+
+   U32 mCRC;
+   U32 mOffset;
+
+   BlobRequestEvent(U32 crc = 0, U32 offset = 0)
+   {
+      mCRC = crc;
+      mOffset = offset;
+   }
+
+   virtual void pack(NetConnection *, BitStream *bstream)
+   {
+      bstream->write(mCRC);
+      bstream->write(mOffset);
+   }
+
+   virtual void write(NetConnection *connection, BitStream *bstream)
+   {
+      pack(connection, bstream);
+   }
+
+   virtual void unpack(NetConnection *, BitStream *bstream)
+   {
+      bstream->read(&mCRC);
+      bstream->read(&mOffset);
+   }
+
+   virtual void process(NetConnection *connection)
+   {
+      connection->blobRequested(mCRC, mOffset);
+   }
+
+   DECLARE_CONOBJECT(BlobRequestEvent);
+};
+
+IMPLEMENT_CO_NETEVENT_V1(BlobRequestEvent);
+
+ConsoleDocClass( BlobRequestEvent,
+				"@brief Used by NetConnection to ask for a blob that was offered to it.\n\n"
+				"Not intended for game development, for editors or internal use only.\n\n "
+				"@internal");
+
+/// A piece of a blob.
+class BlobChunkEvent : public NetEvent
+{
+public:
+   typedef NetEvent Parent;
+
+   U32 mCRC;      ///< Blob the chunk is from.  Not sent.
+   U8 mData[NetConnection::BlobChunkSize];
+   U32 mLen;
+
+   BlobChunkEvent(U32 crc = 0, const U8 *data = NULL, U32 len = 0)
+   {
+      mCRC = crc;
+      if(data)
+         dMemcpy(mData, data, len);
+      mLen = len;
+   }
+
+   virtual void pack(NetConnection *, BitStream *bstream)
+   {
+      bstream->writeRangedU32(mLen, 1, NetConnection::BlobChunkSize);
+      bstream->write(mLen, mData);
+   }
+
+   virtual void write(NetConnection *connection, BitStream *bstream)
+   {
+      pack(connection, bstream);
+   }
+
+   virtual void unpack(NetConnection *, BitStream *bstream)
+   {
+      mLen = bstream->readRangedU32(1, NetConnection::BlobChunkSize);
+      bstream->read(mLen, mData);
+   }
+
+   virtual void process(NetConnection *connection)
+   {
+      connection->blobChunkReceived(mData, mLen);
+   }
+
+   virtual void notifyDelivered(NetConnection *connection, bool madeIt)
+   {
+      if(!connection->isRemoved())
+         connection->blobChunkDelivered(mCRC);
+   }
+
+   DECLARE_CONOBJECT(BlobChunkEvent);
+};
+
+IMPLEMENT_CO_NETEVENT_V1(BlobChunkEvent);
+
+ConsoleDocClass( BlobChunkEvent,
+				"@brief Used by NetConnection to send a piece of a blob.\n\n"
+				"Not intended for game development, for editors or internal use only.\n\n "
+				"@internal");
+
+//-----------------------------------------------------------------------------
+// Sending
+//-----------------------------------------------------------------------------
+
+bool NetConnection::smBlobTransfer = true;
+String NetConnection::smBlobCachePath("cache/net");
+
+void NetConnection::sendBlob(BlobType type, U32 sequence, NetBlob *blob)
+{
+   AssertFatal(mBlobTransfer, "NetConnection::sendBlob - blob transfers are not enabled on this connection.");
+
+   mBlobSend = blob;
+   mBlobSendType = type;
+   mBlobSendRequested = false;
+   mBlobSendOffset = 0;
+
+   // Chunks of an earlier blob that are still in flight don't count
+   // against the window of this one.
+   mBlobChunksInFlight = 0;
+
+   postNetEvent(new BlobOfferEvent(type, sequence, blob));
+   checkMaxRate();
+}
+
+void NetConnection::blobRequested(U32 crc, U32 offset)
+{
+   // Ignore requests for a blob that has been replaced since.
+   if(mBlobSend.isNull() || mBlobSend->getCRC() != crc || mBlobSendRequested)
+      return;
+
+   if(offset > mBlobSend->getSize())
+   {
+      setLastError("Invalid packet. (blob offset)");
+      return;
+   }
+
+   mBlobSendRequested = true;
+   mBlobSendOffset = offset;
+   if(offset == mBlobSend->getSize())
+   {
+      // They had it already.
+      endBlobSend();
+      return;
+   }
+
+   if(offset)
+      Con::printf("Resuming blob %08x at %d of %d bytes.", crc, offset, mBlobSend->getSize());
+   sendBlobChunks();
+}
+
+void NetConnection::sendBlobChunks()
+{
+   while(mBlobChunksInFlight < BlobChunkWindow && mBlobSendOffset < mBlobSend->getSize())
+   {
+      U32 len = getMin(U32(BlobChunkSize), mBlobSend->getSize() - mBlobSendOffset);
+      postNetEvent(new BlobChunkEvent(mBlobSend->getCRC(), mBlobSend->getData() + mBlobSendOffset, len));
+      mBlobSendOffset += len;
+      mBlobChunksInFlight++;
+   }
+}
+
+void NetConnection::blobChunkDelivered(U32 crc)
+{
+   if(mBlobSend.isNull() || mBlobSend->getCRC() != crc || !mBlobChunksInFlight)
+      return;
+
+   mBlobChunksInFlight--;
+   if(mBlobSendOffset < mBlobSend->getSize())
+      sendBlobChunks();
+   else if(!mBlobChunksInFlight)
+      endBlobSend();
+}
+
+void NetConnection::endBlobSend()
+{
+   mBlobSend = NULL;
+   mBlobSendRequested = false;
+   mBlobSendOffset = 0;
+   mBlobChunksInFlight = 0;
+   checkMaxRate();
+}
+
+//-----------------------------------------------------------------------------
+// Receiving
+//-----------------------------------------------------------------------------
+
+struct NetConnection::BlobDownload
+{
+   U32 type;
+   U32 sequence;
+   U32 crc;
+   U32 rawSize;
+   U32 size;
+   Vector<U8> data;
+
+   /// Partial download on disk, so an interrupted download can resume.
+   FileStream *partFile;
+
+   BlobDownload() : partFile(NULL) {}
+   ~BlobDownload() { delete partFile; }
+};
+
+/// Where a blob is cached, or partly downloaded to.
+static String getBlobCacheFile(U32 crc, bool partial)
+{
+   if(NetConnection::smBlobCachePath.isEmpty())
+      return String();
+   return String::ToString("%s/%08x.%s", NetConnection::smBlobCachePath.c_str(), crc, partial ? "part" : "blob");
+}
+
+/// Read up to maxSize bytes of a cache file.
+static bool readBlobCacheFile(const String &fileName, U32 maxSize, Vector<U8> &data)
+{
+   data.clear();
+   if(fileName.isEmpty() || !Torque::FS::IsFile(fileName))
+      return false;
+
+   FileStream *stream = FileStream::createAndOpen(fileName, Torque::FS::File::Read);
+   if(!stream)
+      return false;
+
+   U32 size = stream->getStreamSize();
+   bool ok = size <= maxSize;
+   if(ok)
+   {
+      data.setSize(size);
+      ok = stream->read(size, data.address());
+   }
+   delete stream;
+
+   if(!ok)
+      data.clear();
+   return ok;
+}
+
+void NetConnection::blobOffered(U32 type, U32 sequence, U32 crc, U32 size, U32 rawSize)
+{
+   if(!mBlobTransfer || !size || size > NetBlob::MaxSize || rawSize > NetBlob::MaxSize)
+   {
+      setLastError("Invalid packet. (unexpected blob)");
+      return;
+   }
+
+   // A new blob replaces one still coming in.
+   if(mBlobDownload)
+   {
+      delete mBlobDownload;
+      mBlobDownload = NULL;
+   }
+
+   BlobDownload *download = new BlobDownload;
+   download->type = type;
+   download->sequence = sequence;
+   download->crc = crc;
+   download->size = size;
+   download->rawSize = rawSize;
+   mBlobDownload = download;
+
+   // If we have it from an earlier connection, we're done already.
+   if(readBlobCacheFile(getBlobCacheFile(crc, false), size, download->data) &&
+      download->data.size() == size && CRC::calculateCRC(download->data.address(), size) == crc)
+   {
+      postNetEvent(new BlobRequestEvent(crc, size));
+      blobChunkReceived(NULL, 0);
+      return;
+   }
+
+   // Otherwise pick up where we left off, if we got part of it before.
+   String partName = getBlobCacheFile(crc, true);
+   readBlobCacheFile(partName, size, download->data);
+   if(partName.isNotEmpty())
+   {
+      download->partFile = FileStream::createAndOpen(partName, download->data.size() ? Torque::FS::File::WriteAppend : Torque::FS::File::Write);
+      if(!download->partFile)
+         download->data.clear();
+   }
+
+   postNetEvent(new BlobRequestEvent(crc, download->data.size()));
+   checkMaxRate();
+
+   // A partial download may have stopped on the last chunk.
+   if(download->data.size() == size)
+      blobChunkReceived(NULL, 0);
+}
+
+void NetConnection::blobChunkReceived(const U8 *data, U32 len)
+{
+   // Chunks of a blob we have from the cache are ignored.
+   BlobDownload *download = mBlobDownload;
+   if(!download)
+      return;
+
+   if(len)
+   {
+      U32 offset = download->data.size();
+      if(offset + len > download->size)
+      {
+         setLastError("Invalid packet. (blob chunk)");
+         return;
+      }
+      download->data.setSize(offset + len);
+      dMemcpy(download->data.address() + offset, data, len);
+      if(download->partFile)
+         download->partFile->write(len, data);
+
+      if(download->data.size() < download->size)
+         return;
+   }
+
+   // That's all of it.
+   if(CRC::calculateCRC(download->data.address(), download->size) != download->crc)
+   {
+      // Don't resume from a bad download next time.
+      if(download->partFile)
+      {
+         SAFE_DELETE(download->partFile);
+         Torque::FS::Remove(getBlobCacheFile(download->crc, true));
+      }
+      endBlobDownload();
+      setLastError("Invalid blob from server.");
+      return;
+   }
+
+   if(download->partFile)
+   {
+      SAFE_DELETE(download->partFile);
+      String blobName = getBlobCacheFile(download->crc, false);
+      if(Torque::FS::IsFile(blobName))
+         Torque::FS::Remove(blobName);
+      Torque::FS::Rename(getBlobCacheFile(download->crc, true), blobName);
+   }
+
+   U8 *raw = (U8 *) dMalloc(getMax(download->rawSize, U32(1)));
+   bool ok = NetBlob::uncompress(download->data.address(), download->size, raw, download->rawSize);
+   U32 type = download->type;
+   U32 sequence = download->sequence;
+   U32 rawSize = download->rawSize;
+   endBlobDownload();
+
+   if(ok)
+   {
+      BitStream stream(raw, rawSize);
+      onBlobReceived(type, sequence, &stream);
+   }
+   else
+      setLastError("Invalid blob from server.");
+   dFree(raw);
+}
+
+void NetConnection::endBlobDownload()
+{
+   SAFE_DELETE(mBlobDownload);
+   checkMaxRate();
+}
+
+//-----------------------------------------------------------------------------
+
+void NetConnection::cancelBlobTransfer(BlobType type)
+{
+   if(mBlobSend.isValid() && mBlobSendType == type)
+      endBlobSend();
+   if(mBlobDownload && mBlobDownload->type == type)
+      endBlobDownload();
+}
+
+void NetConnection::onBlobReceived(U32 type, U32 sequence, BitStream *stream)
+{
+   switch(type)
+   {
+      case BlobGhostAlways:
+         ghostReadAlwaysBlob(sequence, stream);
+         break;
+      default:
+         setLastError("Invalid packet. (unknown blob)");
+         break;
+   }
+}
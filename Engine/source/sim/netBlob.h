@@ -0,0 +1,84 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _NETBLOB_H_
+#define _NETBLOB_H_
+
+#ifndef _REFBASE_H_
+#include "core/util/refBase.h"
+#endif
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+/// A block of data compressed with zlib to be sent over a NetConnection
+/// in one piece.
+///
+/// Blobs are made on the server from what would otherwise be sent as many
+/// small events, such as all the datablocks of a mission.  They are
+/// identified by the CRC of the compressed data, which is what clients
+/// cache them under.
+///
+/// @see NetConnection::sendBlob()
+class NetBlob : public StrongRefBase
+{
+public:
+   enum Constants
+   {
+      MaxSize = 64 * 1024 * 1024,   ///< Largest blob accepted, compressed or not.
+      MaxCached = 4,                ///< Number of blobs create() keeps around.
+   };
+
+   /// Compress size bytes of data into a blob.
+   ///
+   /// The last few blobs made are kept, and if one of them holds the same
+   /// data it is returned instead of compressing it again.  Returns NULL
+   /// if the data is too large or doesn't compress.
+   static NetBlob *create(const void *data, U32 size);
+
+   /// Uncompress the data of a blob into out, which must hold rawSize bytes.
+   static bool uncompress(const void *data, U32 size, void *out, U32 rawSize);
+
+   /// CRC of the compressed data.
+   U32 getCRC() const { return mCRC; }
+
+   /// Size of the compressed data in bytes.
+   U32 getSize() const { return mData.size(); }
+
+   /// Size of the data before it was compressed.
+   U32 getRawSize() const { return mRawSize; }
+
+   const U8 *getData() const { return mData.address(); }
+
+protected:
+   NetBlob();
+
+   Vector<U8> mData;
+   U32 mCRC;
+   U32 mRawSize;
+   U32 mRawCRC;      ///< CRC of the uncompressed data, for the cache.
+
+   /// Blobs kept by create(), most recent last.
+   static Vector< StrongRefPtr<NetBlob> > smCache;
+};
+
+#endif // _NETBLOB_H_
@@ -26,12 +26,17 @@
 #include "sim/netConnection.h"
 #include "core/stream/bitStream.h"
 #include "core/stream/fileStream.h"
+#include "core/stream/stringCoder.h"
+#include "sim/netBlob.h"
+#include "core/mappedFile.h"
 #ifndef TORQUE_TGB_ONLY
 #include "scene/pathManager.h"
 #endif
 #include "console/consoleTypes.h"
 #include "sim/netInterface.h"
 #include "console/engineAPI.h"
+#include "platform/threads/threadPool.h"
+#include "platform/profiler.h"
 #include <stdarg.h>
 
 
@@ -217,6 +222,31 @@ static U32 gPacketUpdateDelayToServer = 32;
 static U32 gPacketRateToClient = 10;
 static U32 gPacketSize = 200;
 
+bool NetConnection::smParallelPacketWrite = false;
+String NetConnection::smStringDictionaryFile;
+
+const StringDictionary *NetConnection::loadStringDictionary()
+{
+   static StringDictionary *sDictionary = NULL;
+   static String sLoadedFile;
+
+   if(smStringDictionaryFile != sLoadedFile)
+   {
+      // Connections that are using the old one keep it, so it isn't freed.
+      sLoadedFile = smStringDictionaryFile;
+      sDictionary = NULL;
+      if(sLoadedFile.isNotEmpty())
+      {
+         sDictionary = StringDictionary::load(sLoadedFile);
+         if(!sDictionary)
+            Con::errorf("NetConnection - could not load string dictionary %s.", sLoadedFile.c_str());
+      }
+   }
+   return sDictionary;
+}
+bool NetConnection::smWritingInParallel = false;
+void *NetConnection::smPacketWriteMutex = NULL;
+
 void NetConnection::consoleInit()
 {
    Con::addVariable("$pref::Net::PacketRateToServer", TypeS32, &gPacketRateToServer,
@@ -278,6 +308,97 @@ void NetConnection::consoleInit()
 
       "@ingroup Networking");
 
+   Con::addVariable("$pref::Net::ParallelPacketWrite", TypeBool, &NetConnection::smParallelPacketWrite,
+      "@brief If true, the server builds the packets for its clients in parallel.\n\n"
+
+      "Each client's packet is built on a worker thread of the global thread pool while the "
+      "main thread waits.  Packets are still sent in the same order as they would be otherwise.  "
+      "Objects whose packUpdate() is not marked as thread-safe are packed one at a time.  The "
+      "default is false.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::BatchedIO", TypeBool, &Net::smBatchedIO,
+      "@brief If true, UDP packets are read and sent in batches where the platform supports it.\n\n"
+
+      "On Linux, all packets waiting on the port are read with a few recvmmsg() calls, and "
+      "outgoing packets are queued and sent with one sendmmsg() call after each simulation "
+      "update.  This cuts the number of system calls on busy servers.  Has no effect on other "
+      "platforms.  The default is true.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::IOThread", TypeBool, &Net::smIOThread,
+      "@brief If true, a separate thread reads and writes the UDP port.\n\n"
+
+      "Packets are read as soon as they arrive and queued for the main thread along with "
+      "their arrival time, so a long script or a mission load doesn't leave them sitting in "
+      "the socket or add to measured ping.  Outgoing packets are queued for the thread to "
+      "send.  Takes effect the next time the port is opened.  Not available on Windows.  "
+      "The default is false.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::GhostDeltaCompression", TypeBool, &NetConnection::smGhostDeltaCompression,
+      "@brief If true, connections ask to have ghost updates sent as deltas.\n\n"
+
+      "An update to a ghost the client already has is compared with the last update of that "
+      "ghost the client acknowledged, and only the bytes that changed are sent.  Both the "
+      "client and the server must have this set for it to be used, and it is never used on "
+      "local connections.  Takes effect on the next connection.  The default is false.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::StringDictionary", TypeRealString, &NetConnection::smStringDictionaryFile,
+      "@brief String dictionary to code the strings in packets with.\n\n"
+
+      "A file saved by trainStringDictionary().  Strings are only coded with it if the other end "
+      "of the connection has the same dictionary; otherwise the built-in Huffman table is used.  "
+      "Takes effect on the next connection.  The default is \"\", for no dictionary.\n\n"
+
+      "@see startStringCapture()\n"
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::BlobTransfer", TypeBool, &NetConnection::smBlobTransfer,
+      "@brief If true, connections ask to have datablocks and ghost always objects sent as one compressed blob.\n\n"
+
+      "The server packs the datablocks, and later the ghost always objects, into a blob compressed "
+      "with zlib and keeps the last few blobs it made so it doesn't compress the same data twice.  "
+      "Clients cache the blobs they get in $pref::Net::BlobCachePath and skip the transfer if they "
+      "already have the blob the server offers.  Both the client and the server must have this set "
+      "for it to be used, and it is never used on local connections.  Takes effect on the next "
+      "connection.  The default is true.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::BlobCachePath", TypeRealString, &NetConnection::smBlobCachePath,
+      "@brief Directory the client keeps blobs received from servers in.\n\n"
+
+      "Partly received blobs are kept here as well so an interrupted transfer can resume where it "
+      "stopped.  If empty, nothing is cached.  The default is \"cache/net\".\n\n"
+
+      "@see $pref::Net::BlobTransfer\n"
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::TransferPacketRate", TypeS32, &NetConnection::smTransferPacketRate,
+      "@brief Packet rate to the client while a file or blob is being transferred.\n\n"
+
+      "Used in place of $pref::Net::PacketRateToClient if it is higher.  Both sides must allow "
+      "it.  The default is 64.\n\n"
+
+      "@see $pref::Net::BlobTransfer\n"
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::TransferPacketSize", TypeS32, &NetConnection::smTransferPacketSize,
+      "@brief Packet size in bytes while a file or blob is being transferred.\n\n"
+
+      "Used in place of $pref::Net::PacketSize if it is larger.  Both sides must allow it.  It "
+      "is kept small enough that a whole chunk still fits in a packet.  The default is 1150 "
+      "bytes.\n\n"
+
+      "@see $pref::Net::BlobTransfer\n"
+      "@ingroup Networking");
+
    Con::addVariable("$Stats::netBitsSent", TypeS32, &gNetBitsSent,
       "@brief The number of bytes sent during the last packet send operation.\n\n"
 
@@ -318,6 +439,15 @@ void NetConnection::checkMaxRate()
       packetRateToClient = 128;
       packetSize = 1024;
    }
+   else if (isTransferringBlob() || isTransferringFile())
+   {
+      packetRateToClient = getMax( packetRateToClient, smTransferPacketRate );
+
+      // Events can run past the packet size, so leave room for a whole
+      // chunk before the real end of the packet.
+      const U32 maxChunkSize = getMax( U32( BlobChunkSize ), U32( FileChunkSize ) );
+      packetSize = getMin( getMax( packetSize, smTransferPacketSize ), U32( Net::MaxPacketDataSize - maxChunkSize - 64 ) );
+   }
 
    gPacketUpdateDelayToServer = 1024 / packetRateToServer;
    U32 toClientUpdateDelay = 1024 / packetRateToClient;
@@ -374,15 +504,16 @@ NetConnection::NetConnection()
    mSendDelayCredit = 0;
    mConnectionState = NotConnected;
 
-   mCurrentDownloadingFile = NULL;
-   mCurrentFileBuffer = NULL;
-
    mNextConnection = NULL;
    mPrevConnection = NULL;
 
    mNotifyQueueHead = NULL;
    mNotifyQueueTail = NULL;
 
+   mSendBuffer = NULL;
+   mSendStream = NULL;
+   mSendNotify = NULL;
+
    mCurRate.updateDelay = 102;
    mCurRate.packetSize = 200;
    mCurRate.changed = false;
@@ -410,12 +541,24 @@ NetConnection::NetConnection()
    mGhostingSequence = 0;
    mGhosting = false;
    mScoping = false;
+   mScopedForPacket = false;
    mGhostArray = NULL;
    mGhostRefs = NULL;
    mGhostLookupTable = NULL;
    mLocalGhosts = NULL;
+   mGhostDeltas = false;
+   mGhostDeltaBuffer = NULL;
+   mGhostDeltaHistory = NULL;
 
    mGhostsActive = 0;
+   mStringDictionary = NULL;
+
+   mBlobTransfer = false;
+   mBlobSendType = BlobDataBlocks;
+   mBlobSendRequested = false;
+   mBlobSendOffset = 0;
+   mBlobChunksInFlight = 0;
+   mBlobDownload = NULL;
 
    mMissionPathsSent = false;
    mDemoWriteStream = NULL;
@@ -425,8 +568,8 @@ NetConnection::NetConnection()
    mPingRetryCount = DefaultPingRetryCount;
    mLastPingSendTime = Platform::getVirtualMilliseconds();
 
-   mCurrentDownloadingFile = NULL;
-   mCurrentFileBuffer = NULL;
+   mFileChunksInFlight = 0;
+   mCurrentFileCRC = 0;
    mCurrentFileBufferSize = 0;
    mCurrentFileBufferOffset = 0;
    mNumDownloadedFiles = 0;
@@ -440,15 +583,22 @@ NetConnection::~NetConnection()
    AssertFatal(mNotifyQueueHead == NULL, "Uncleared notifies remain.");
    netAddressTableRemove();
 
-   dFree(mCurrentFileBuffer);
-   if(mCurrentDownloadingFile)
-      delete mCurrentDownloadingFile;
+   delete mBlobDownload;
 
+   if(mGhostDeltaHistory)
+   {
+      for(U32 i = 0; i < MaxGhostCount; i++)
+         ghostClearDeltaHistory(i);
+      delete[] mGhostDeltaHistory;
+   }
+   delete[] mGhostDeltaBuffer;
    delete[] mLocalGhosts;
    delete[] mGhostLookupTable;
    delete[] mGhostRefs;
    delete[] mGhostArray;
    delete mStringTable;
+   delete mSendStream;
+   delete [] mSendBuffer;
    if(mDemoWriteStream)
       delete mDemoWriteStream;
    if(mDemoReadStream)
@@ -482,7 +632,7 @@ bool NetConnection::checkTimeout(U32 time)
 
 void NetConnection::keepAlive()
 {
-   mLastPingSendTime = Platform::getVirtualMilliseconds();
+   mLastPingSendTime = Net::getPacketReceiveTime();
    mPingSendCount = 0;
 }
 
@@ -702,7 +852,8 @@ void NetConnection::handleNotify(bool recvd)
    if(recvd) 
    {
       // Running average of roundTrip time
-      U32 curTime = Platform::getVirtualMilliseconds();
+      // Go by when the packet arrived, not when we got around to it.
+      U32 curTime = Net::getPacketReceiveTime();
       mRoundTripTime = (mRoundTripTime + (curTime - note->sendTime)) * 0.5;
       packetReceived(note);
    }
@@ -726,6 +877,7 @@ void NetConnection::handlePacket(BitStream *bstream)
    // clear out any errors
 
    mErrorBuffer = String();
+   bstream->setStringCoder(mStringDictionary);
 
    if(bstream->readFlag())
    {
@@ -788,6 +940,18 @@ public:
 };
 
 void NetConnection::checkPacketSend(bool force)
+{
+   if(!beginPacketSend(force))
+      return;
+
+   DEBUG_LOG(("PKLOG %d START", getId()) );
+   writePacket(mSendStream, mSendNotify);
+   DEBUG_LOG(("PKLOG %d END - %d", getId(), mSendStream->getCurPos()) );
+
+   endPacketSend();
+}
+
+bool NetConnection::beginPacketSend(bool force)
 {
    U32 curTime = Platform::getVirtualMilliseconds();
    U32 delay = isConnectionToServer() ? gPacketUpdateDelayToServer : mCurRate.updateDelay;
@@ -795,7 +959,7 @@ void NetConnection::checkPacketSend(bool force)
    if(!force)
    {
       if(curTime < mLastUpdateTime + delay - mSendDelayCredit)
-         return;
+         return false;
 
       mSendDelayCredit = curTime - (mLastUpdateTime + delay - mSendDelayCredit);
       if(mSendDelayCredit > 1000)
@@ -805,9 +969,23 @@ void NetConnection::checkPacketSend(bool force)
          recordBlock(BlockTypeSendPacket, 0, 0);
    }
    if(windowFull())
-      return;
+      return false;
+
+   // Each connection builds its packets in its own buffer so that
+   // several packets can be in flight at once.
+
+   if(!mSendStream)
+   {
+      mSendBuffer = new U8[Net::MaxPacketDataSize];
+      mSendStream = new BitStream(NULL, 0);
+   }
+
+   U32 writeSize = mCurRate.packetSize ? mCurRate.packetSize : Net::MaxPacketDataSize;
+   mSendStream->setBuffer(mSendBuffer, writeSize, Net::MaxPacketDataSize);
+   mSendStream->setPosition(0);
+   mSendStream->setStringCoder(mStringDictionary);
 
-   BitStream *stream = BitStream::getPacketStream(mCurRate.packetSize);
+   BitStream *stream = mSendStream;
    buildSendPacketHeader(stream);
 
    mLastUpdateTime = curTime;
@@ -836,13 +1014,15 @@ void NetConnection::checkPacketSend(bool force)
       stream->writeInt(mMaxRate.packetSize, 12);
       mMaxRate.changed = false;
    }
-#ifdef TORQUE_DEBUG_NET
-   U32 start = stream->getCurPos();
-#endif
 
-   DEBUG_LOG(("PKLOG %d START", getId()) );
-   writePacket(stream, note);
-   DEBUG_LOG(("PKLOG %d END - %d", getId(), stream->getCurPos() - start) );
+   mSendNotify = note;
+   return true;
+}
+
+void NetConnection::endPacketSend()
+{
+   mSendNotify = NULL;
+
    if(mSimulatedPacketLoss && Platform::getRandom() < mSimulatedPacketLoss)
    {
       //Con::printf("NET  %d: SENDDROP - %d", getId(), mLastSendSeq);
@@ -850,10 +1030,70 @@ void NetConnection::checkPacketSend(bool force)
    }
    if(mSimulatedPing)
    {
-      Sim::postEvent(getId(), new NetDelayEvent(stream), Sim::getCurrentTime() + mSimulatedPing);
+      Sim::postEvent(getId(), new NetDelayEvent(mSendStream), Sim::getCurrentTime() + mSimulatedPing);
       return;
    }
-   sendPacket(stream);
+   sendPacket(mSendStream);
+}
+
+//----------------------------------------------------------------------
+
+void NetConnection::writePackets(U32 begin, U32 end, void *data)
+{
+   NetConnection **connections = (NetConnection **) data;
+   for(U32 i = begin; i < end; i++)
+      connections[i]->writePacket(connections[i]->mSendStream, connections[i]->mSendNotify);
+}
+
+void NetConnection::checkPacketSends(const Vector<NetConnection *> &connections, bool force)
+{
+   if(!smParallelPacketWrite || connections.size() < 2)
+   {
+      for(U32 i = 0; i < connections.size(); i++)
+         connections[i]->checkPacketSend(force);
+      return;
+   }
+
+   PROFILE_SCOPE(NetConnection_checkPacketSends);
+
+   // Everything that touches state shared between connections happens
+   // here, before the workers start: deciding which connections send and
+   // scoping, which links ghosts into the lists of the objects they
+   // reference.
+
+   Vector<NetConnection *> sending;
+   sending.reserve(connections.size());
+
+   for(U32 i = 0; i < connections.size(); i++)
+   {
+      NetConnection *conn = connections[i];
+      if(!conn->beginPacketSend(force))
+         continue;
+
+      if(conn->isGhostingFrom() && conn->mGhosting)
+         conn->ghostScopePacket();
+
+      sending.push_back(conn);
+   }
+
+   if(sending.empty())
+      return;
+
+   if(!smPacketWriteMutex)
+      smPacketWriteMutex = Mutex::createMutex();
+   BitStream::initHuffmanTables();
+
+   // Build the packets.  This thread pitches in as well, so all we
+   // wait on at the end are the packets still being written.
+
+   smWritingInParallel = true;
+   ThreadPool::GLOBAL().parallelFor(sending.size(), 1, &writePackets, sending.address());
+   smWritingInParallel = false;
+
+   // Send them in order.
+
+   for(U32 i = 0; i < sending.size(); i++)
+      sending[i]->endPacketSend();
 }
 
 Net::Error NetConnection::sendPacket(BitStream *stream)
@@ -917,6 +1157,12 @@ void NetConnection::writeDemoStartBlock(ResizeBitStream* stream)
 {
    ConnectionProtocol::writeDemoStartBlock(stream);
 
+   // The packets in the demo use the connection's string dictionary, so it
+   // has to be there on playback.
+   if(stream->writeFlag(mStringDictionary != NULL))
+      stream->write(mStringDictionary->getCRC());
+   stream->setStringCoder(mStringDictionary);
+
    stream->write(mRoundTripTime);
    stream->write(mPacketLoss);
 #ifndef TORQUE_TGB_ONLY
@@ -943,6 +1189,21 @@ bool NetConnection::readDemoStartBlock(BitStream* stream)
 {
    ConnectionProtocol::readDemoStartBlock(stream);
 
+   mStringDictionary = NULL;
+   if(stream->readFlag())
+   {
+      U32 crc = 0;
+      stream->read(&crc);
+      const StringDictionary *dict = loadStringDictionary();
+      if(!dict || dict->getCRC() != crc)
+      {
+         setLastError("Demo was recorded with a different string dictionary.");
+         return false;
+      }
+      mStringDictionary = dict;
+   }
+   stream->setStringCoder(mStringDictionary);
+
    stream->read(&mRoundTripTime);
    stream->read(&mPacketLoss);
 
@@ -43,12 +43,23 @@
 #include "sim/connectionStringTable.h"
 #endif
 
+#ifndef _PLATFORM_THREADS_MUTEX_H_
+#include "platform/threads/mutex.h"
+#endif
+
+#ifndef _REFBASE_H_
+#include "core/util/refBase.h"
+#endif
+
 class NetConnection;
 class NetObject;
 class BitStream;
 class ResizeBitStream;
 class Stream;
 class Point3F;
+class StringDictionary;
+class NetBlob;
+class MappedFile;
 
 struct GhostInfo;
 struct SubPacketRef; // defined in NetConnection subclass
@@ -427,6 +438,9 @@ public:
       GhostInfo *ghost;          ///< Reference to the GhostInfo we're from.
       GhostRef *nextRef;         ///< Next GhostRef in this packet.
       GhostRef *nextUpdateChain; ///< Next update we sent for this ghost.
+      U8 *payload;               ///< Bits written by packUpdate, kept as a delta base.  NULL if not kept.
+      U32 payloadBits;           ///< Size of payload in bits.
+      U32 seq;                   ///< Sequence number of the packet.
    };
 
    enum Constants
@@ -624,6 +638,13 @@ public:
 
    void checkPacketSend(bool force);
 
+   /// Call checkPacketSend() on each of the given connections.
+   ///
+   /// If #smParallelPacketWrite is set, the packets are built concurrently on the
+   /// global ThreadPool.  They are still sent on the calling thread and in the order
+   /// of @a connections.
+   static void checkPacketSends(const Vector<NetConnection *> &connections, bool force);
+
    bool missionPathsSent() const          { return mMissionPathsSent; }
    void setMissionPathsSent(const bool s) { mMissionPathsSent = s; }
 
@@ -683,6 +704,86 @@ public:
    PacketNotify *mNotifyQueueHead;  ///< Head of packet notify list.
    PacketNotify *mNotifyQueueTail;  ///< Tail of packet notify list.
 
+public:
+   /// @name String Dictionary
+   ///
+   /// Connections can code the strings in their packets with a StringDictionary
+   /// trained on the game's own traffic, in place of BitStream's built-in
+   /// Huffman table.  Both ends must have the same dictionary; GameConnection
+   /// checks that when connecting.
+   /// @{
+
+   /// File the dictionary is loaded from ($pref::Net::StringDictionary).
+   static String smStringDictionaryFile;
+
+   /// The dictionary in smStringDictionaryFile, loaded the first time it is
+   /// asked for after the file name changes.  NULL if there isn't one.
+   static const StringDictionary *loadStringDictionary();
+
+   /// Set the dictionary used for the strings in this connection's packets.
+   void setStringDictionary(const StringDictionary *dict) { mStringDictionary = dict; }
+   const StringDictionary *getStringDictionary() const { return mStringDictionary; }
+
+   /// @}
+
+protected:
+   const StringDictionary *mStringDictionary;
+
+public:
+   /// @name Parallel Packet Writing
+   /// @{
+
+   /// If true, packets to clients are written in parallel.
+   /// @see checkPacketSends
+   static bool smParallelPacketWrite;
+
+   /// Scoped lock around packet writing work that is not thread-safe.
+   ///
+   /// While packets are written in parallel, this serializes the work it guards
+   /// with any other such work on other connections.  Otherwise it does nothing.
+   class PacketWriteLock
+   {
+      MutexHandle mHandle;
+
+   public:
+      /// @param threadSafe If true, the guarded work is known to be thread-safe
+      ///   and no lock is taken.
+      PacketWriteLock(bool threadSafe = false)
+      {
+         if(!threadSafe && smWritingInParallel)
+            mHandle.lock(smPacketWriteMutex, true);
+      }
+   };
+
+protected:
+   /// True while checkPacketSends() has packets being written on worker threads.
+   static bool smWritingInParallel;
+
+   /// Mutex used by PacketWriteLock.
+   static void *smPacketWriteMutex;
+
+   /// Buffer and stream that outgoing packets are built in.
+   U8 *mSendBuffer;
+   BitStream *mSendStream;
+
+   /// Notify for the packet currently in #mSendStream.
+   PacketNotify *mSendNotify;
+
+   /// First half of checkPacketSend().
+   ///
+   /// @return False if no packet is due; otherwise the packet notify is
+   ///   queued and the packet header is written to #mSendStream.
+   bool beginPacketSend(bool force);
+
+   /// Last half of checkPacketSend(); sends the packet in #mSendStream.
+   void endPacketSend();
+
+   /// Write the packets of connections [begin, end) of the NetConnection
+   /// pointer array in @a data.  Run on the thread pool by checkPacketSends().
+   static void writePackets(U32 begin, U32 end, void *data);
+
+   /// @}
+
 protected:
    virtual void readPacket(BitStream *bstream);
    virtual void writePacket(BitStream *bstream, PacketNotify *note);
@@ -770,7 +871,7 @@ protected:
       EndGhosting,
       GhostAlwaysStarting,
       SendNextDownloadRequest,
-      FileDownloadSizeMessage,
+      FileDownloadSizeMessage,   ///< No longer sent; see FileDownloadStartEvent.
       NumConnectionMessages,
    };
    GhostInfo **mGhostArray;    ///< Linked list of ghostInfos ghosted by this side of the connection
@@ -797,12 +898,61 @@ protected:
    /// that the player is driving.
    SimObjectPtr<NetObject> mScopeObject;
 
+   /// Camera information from the last scope query.
+   CameraScopeQuery mScopeQuery;
+
+   /// Set if ghostScopePacket() already ran for the next ghost packet.
+   bool mScopedForPacket;
+
+   /// Run the scope query for the next ghost packet.
+   ///
+   /// Scoping links ghosts into the object's list of references, so when packets
+   /// are written in parallel, this is done for all connections up front.
+   void ghostScopePacket();
+
    void clearGhostInfo();
    bool validateGhostArray();
 
    void ghostPacketDropped(PacketNotify *notify);
    void ghostPacketReceived(PacketNotify *notify);
 
+   /// @name Ghost Delta Compression
+   ///
+   /// If enabled on a connection, the update of a ghost the client already has
+   /// is XORed with the last update of that ghost the client acknowledged, and
+   /// only the bytes that differ are sent.  The client keeps the updates it got
+   /// in recent packets so it has the same base.  If the delta doesn't come
+   /// out smaller, the update is sent as is.
+   /// @{
+
+   /// An update as written by packUpdate(), kept as a base for deltas.
+   struct GhostPayload
+   {
+      U32 seq;    ///< Sequence number of the packet the update came in.
+      U32 bits;   ///< Size of the update in bits.
+      U8 *data;
+   };
+
+   bool mGhostDeltas;                         ///< Are ghost updates delta compressed on this connection?
+   U8 *mGhostDeltaBuffer;                     ///< Scratch space for packing or rebuilding an update.
+   Vector<GhostPayload> *mGhostDeltaHistory;  ///< Updates received, per ghost index.  Client side only.
+
+   /// Write the update of a ghost, delta compressed if possible.
+   /// Returns the mask packUpdate() returned.
+   U32 ghostWriteUpdate(GhostInfo *info, U32 updateMask, BitStream *bstream, GhostRef *ref);
+
+   /// Read an update written by ghostWriteUpdate() into the ghost at index.
+   /// Returns false and sets the last error if the update was bad.
+   bool ghostReadUpdate(U32 index, BitStream *bstream, bool newGhost);
+
+   /// Forget the delta base of a ghost.
+   void ghostClearDeltaBase(GhostInfo *info);
+
+   /// Forget the updates received for a ghost index.
+   void ghostClearDeltaHistory(U32 index);
+
+   /// @}
+
    void ghostWritePacket(BitStream *bstream, PacketNotify *notify);
    void ghostReadPacket(BitStream *bstream);
    void freeGhostInfo(GhostInfo *);
@@ -824,9 +974,23 @@ public:
       GhostIdBitSize = 12,
       MaxGhostCount = 1 << GhostIdBitSize, //4096,
       GhostLookupTableSize = 1 << GhostIdBitSize, //4096
-      GhostIndexBitSize = 4 // number of bits GhostIdBitSize-3 fits into
+      GhostIndexBitSize = 4, // number of bits GhostIdBitSize-3 fits into
+      GhostDeltaAgeBitSize = 5,
+      MaxGhostDeltaAge = (1 << GhostDeltaAgeBitSize) - 1, ///< Most packets between a delta and its base.
+      GhostPayloadBitSize = 14 // number of bits the bit size of an update fits into
    };
 
+   /// If true, connections ask for delta compressed ghost updates.
+   /// Both sides must have it set for it to be used.
+   static bool smGhostDeltaCompression;
+
+   /// Turn delta compression of ghost updates on or off.  Must be set the
+   /// same on both sides before ghosting starts, usually while connecting.
+   void setGhostDeltaCompression(bool enable) { mGhostDeltas = enable; }
+
+   /// Are ghost updates delta compressed on this connection?
+   bool isGhostDeltaCompressed() const { return mGhostDeltas; }
+
    U32 getGhostsActive() { return mGhostsActive;};
 
    /// Are we ghosting to someone?
@@ -935,24 +1099,47 @@ public:
 public:
 //----------------------------------------------------------------
 /// @name File transfer
+///
+/// Files are memory mapped on both sides.  The server sends straight from
+/// its mapping, keeping a window of chunks in flight, and the client
+/// writes each chunk into a mapping of a .part file that is renamed once
+/// the whole file is in and its CRC matches.  Both sides use the
+/// $pref::Net::Transfer* packet rate and size while a file is moving.
 /// @{
 
+public:
+   enum FileTransferConstants
+   {
+      FileChunkSize = 256,    ///< Bytes of file data per FileChunkEvent.
+      FileChunkWindow = 64,   ///< Number of chunks kept in flight.
+   };
+
+   /// Packet rate and size used while a file or blob is being transferred.
+   static U32 smTransferPacketRate;
+   static U32 smTransferPacketSize;
+
 protected:
    /// List of files missing for this connection.
    ///
    /// The currently downloading file is always first in the list (ie, [0]).
    Vector<char *> mMissingFileList;
 
-   /// Stream for currently uploading file (if any).
-   Stream *mCurrentDownloadingFile;
+   /// Currently uploading file (if any).
+   StrongRefPtr<MappedFile> mCurrentDownloadingFile;
+
+   /// Number of chunks of the uploading file not yet delivered.
+   U32 mFileChunksInFlight;
+
+   /// Currently downloading file (if any), mapped from its .part file.
+   StrongRefPtr<MappedFile> mCurrentFileBuffer;
 
-   /// Storage for currently downloading file.
-   void *mCurrentFileBuffer;
+   /// CRC the downloading file must have.
+   U32 mCurrentFileCRC;
 
-   /// Size of currently downloading file in bytes.
+   /// Size of currently downloading or uploading file in bytes.
    U32 mCurrentFileBufferSize;
 
-   /// Our position in the currently downloading file in bytes.
+   /// Our position in the currently downloading or uploading file in bytes.
    U32 mCurrentFileBufferOffset;
 
    /// Number of files we have downloaded.
@@ -974,14 +1161,24 @@ public:
    /// Start sending the specified file over the link.
    bool startSendingFile(const char *fileName);
 
+   /// Called when we receive a FileDownloadStartEvent.  found is false if
+   /// the server doesn't have the file.
+   void fileDownloadStarted(bool found, U32 size, U32 crc);
+
    /// Called when we receive a FileChunkEvent.
    void chunkReceived(U8 *chunkData, U32 chunkLen);
 
    /// Get the next file...
    void sendNextFileDownloadRequest();
 
-   /// Post the next FileChunkEvent.
-   void sendFileChunk();
+   /// Post FileChunkEvents until the window is full.
+   void sendFileChunks();
+
+   /// Called when a FileChunkEvent of file has been delivered.
+   void fileChunkDelivered(MappedFile *file);
+
+   /// Is a file being sent or received?
+   bool isTransferringFile() const { return mCurrentDownloadingFile.isValid() || mCurrentFileBuffer.isValid(); }
 
    /// Called when we finish downloading file data.
    virtual void fileDownloadSegmentComplete();
@@ -993,6 +1190,103 @@ public:
    void loadNextGhostAlwaysObject(bool hadNewFiles);
 /// @}
 
+//----------------------------------------------------------------
+/// @name Blob Transfer
+///
+/// Bulk data, such as all the datablocks of a mission, can be sent as a
+/// single compressed NetBlob instead of an event per object.  The blob is
+/// offered to the other side by CRC.  If it has the blob cached from an
+/// earlier connection it says so and nothing more is sent; otherwise it
+/// asks for the blob from wherever an earlier, interrupted download left
+/// off.  Chunks are kept in flight with a larger window than file
+/// downloads, and both sides raise their packet rate and size to the
+/// $pref::Net::Transfer* settings while a transfer runs.
+/// @{
+
+public:
+   enum BlobConstants
+   {
+      BlobChunkSize = 256,    ///< Bytes of blob data per BlobChunkEvent.
+      BlobChunkWindow = 64,   ///< Number of chunks kept in flight.
+   };
+
+   /// What a blob holds, so the receiving side knows what to do with it.
+   enum BlobType
+   {
+      BlobDataBlocks,
+      BlobGhostAlways,
+      NumBlobTypes
+   };
+
+   /// If true, connections ask for datablocks and ghost always objects to
+   /// be sent as blobs.  Both sides must have it set for it to be used.
+   static bool smBlobTransfer;
+
+   /// Directory clients cache received blobs in ($pref::Net::BlobCachePath).
+   static String smBlobCachePath;
+
+
+   /// Turn blob transfers on or off.  Must be set the same on both sides,
+   /// usually while connecting.
+   void setBlobTransfer(bool enable) { mBlobTransfer = enable; }
+
+   /// Are datablocks and ghost always objects sent as blobs on this connection?
+   bool isBlobTransferEnabled() const { return mBlobTransfer; }
+
+   /// Is a blob being sent or received?
+   bool isTransferringBlob() const { return mBlobSend.isValid() || mBlobDownload != NULL; }
+
+   /// Offer blob to the other side.  Replaces any blob still being sent.
+   void sendBlob(BlobType type, U32 sequence, NetBlob *blob);
+
+   /// Called when a BlobOfferEvent is received.
+   void blobOffered(U32 type, U32 sequence, U32 crc, U32 size, U32 rawSize);
+
+   /// Called when a BlobRequestEvent is received.  offset is where to start
+   /// sending from; if it is the size of the blob, the other side already
+   /// has all of it.
+   void blobRequested(U32 crc, U32 offset);
+
+   /// Called when a BlobChunkEvent is received.
+   void blobChunkReceived(const U8 *data, U32 len);
+
+   /// Called when a BlobChunkEvent of the blob with the given CRC is delivered.
+   void blobChunkDelivered(U32 crc);
+
+protected:
+   struct BlobDownload;
+
+   bool mBlobTransfer;                 ///< Are blobs used on this connection?
+   StrongRefPtr<NetBlob> mBlobSend;    ///< Blob being sent, if any.
+   BlobType mBlobSendType;             ///< What the blob being sent holds.
+   bool mBlobSendRequested;            ///< Has the other side asked for the blob yet?
+   U32 mBlobSendOffset;                ///< Offset of the next chunk to send.
+   U32 mBlobChunksInFlight;            ///< Chunks sent but not yet delivered.
+   BlobDownload *mBlobDownload;        ///< Blob being received, if any.
+
+   /// Post chunks of the blob being sent until the window is full.
+   void sendBlobChunks();
+
+   /// Stop sending or receiving a blob and go back to the normal packet rate.
+   void endBlobSend();
+   void endBlobDownload();
+
+   /// Stop sending or receiving a blob of the given type, if one is.
+   void cancelBlobTransfer(BlobType type);
+
+   /// Called with the uncompressed contents of a blob once all of it is here.
+   virtual void onBlobReceived(U32 type, U32 sequence, BitStream *stream);
+
+   /// Pack the ghost always objects into a blob and send it.
+   ///
+   /// @return False if they don't fit in a blob, in which case nothing was
+   ///   sent and they have to go out as events.
+   bool ghostSendAlwaysBlob();
+
+   /// Read the ghost always objects out of a blob made by ghostSendAlwaysBlob().
+   void ghostReadAlwaysBlob(U32 sequence, BitStream *stream);
+/// @}
+
 //----------------------------------------------------------------
 /// @name Demo Recording
 /// @{
@@ -1069,6 +1363,18 @@ public:  // required for MSVC
 
    NetConnection::GhostRef *updateChain;  ///< List of references in NetConnections to us.
 
+   /// @name Delta Compression
+   ///
+   /// The last update of this ghost the client acknowledged, which later
+   /// updates are delta compressed against.
+   /// @{
+
+   U8 *deltaBase;                         ///< NULL if there isn't one yet.
+   U32 deltaBaseBits;
+   U32 deltaBaseSeq;                      ///< Sequence number of the packet it went out in.
+
+   /// @}
+
    GhostInfo *nextObjectRef;              ///< Next ghosted object.
    GhostInfo *prevObjectRef;              ///< Previous ghosted object.
    NetConnection *connection;             ///< Connection that we're ghosting over.
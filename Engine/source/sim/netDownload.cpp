@@ -25,7 +25,8 @@
 #include "console/simBase.h"
 #include "sim/netConnection.h"
 #include "core/stream/bitStream.h"
-#include "core/stream/fileStream.h"
+#include "core/mappedFile.h"
+#include "core/crc.h"
 #include "sim/netObject.h"
 
 class FileDownloadRequestEvent : public NetEvent
@@ -100,40 +101,103 @@ ConsoleDocClass( FileDownloadRequestEvent,
 				"Not intended for game development, for editors or internal use only.\n\n "
 				"@internal");
 
+/// Tells the client the size and CRC of the file it asked for, or that the
+/// server doesn't have it.
+class FileDownloadStartEvent : public NetEvent
+{
+public:
+   typedef NetEvent Parent;
+
+   bool found;
+   U32 size;
+   U32 crc;
+
+   FileDownloadStartEvent(bool found_ = false, U32 size_ = 0, U32 crc_ = 0)
+   {
+      found = found_;
+      size = size_;
+      crc = crc_;
+   }
+
+   virtual void pack(NetConnection *, BitStream *bstream)
+   {
+      if(bstream->writeFlag(found))
+      {
+         bstream->write(size);
+         bstream->write(crc);
+      }
+   }
+
+   virtual void write(NetConnection *connection, BitStream *bstream)
+   {
+      pack(connection, bstream);
+   }
+
+   virtual void unpack(NetConnection *, BitStream *bstream)
+   {
+      found = bstream->readFlag();
+      if(found)
+      {
+         bstream->read(&size);
+         bstream->read(&crc);
+      }
+   }
+
+   virtual void process(NetConnection *connection)
+   {
+      connection->fileDownloadStarted(found, size, crc);
+   }
+
+   DECLARE_CONOBJECT(FileDownloadStartEvent);
+};
+
+IMPLEMENT_CO_NETEVENT_V1(FileDownloadStartEvent);
+
+ConsoleDocClass( FileDownloadStartEvent,
+				"@brief Used by NetConnection to tell a client the size and CRC of a file it is about to download.\n\n"
+				"Not intended for game development, for editors or internal use only.\n\n "
+				"@internal");
+
 class FileChunkEvent : public NetEvent
 {
 public:
    typedef NetEvent Parent;
    enum
    {
-      ChunkSize = 63,
+      ChunkSize = NetConnection::FileChunkSize,
    };
 
+   /// File the chunk is sent from, on the server.  The chunk is written
+   /// straight out of its mapping.
+   StrongRefPtr<MappedFile> file;
+   U32 fileOffset;
+
+   /// Chunk data, on the client.
    U8 chunkData[ChunkSize];
    U32 chunkLen;
    
-   FileChunkEvent(U8 *data = NULL, U32 len = 0)
+   FileChunkEvent(MappedFile *file_ = NULL, U32 offset = 0, U32 len = 0)
    {
-      if(data)
-         dMemcpy(chunkData, data, len);
+      file = file_;
+      fileOffset = offset;
       chunkLen = len;
    }
    
    virtual void pack(NetConnection *, BitStream *bstream)
    {
-      bstream->writeRangedU32(chunkLen, 0, ChunkSize);
-      bstream->write(chunkLen, chunkData);
+      bstream->writeRangedU32(chunkLen, 1, ChunkSize);
+      bstream->write(chunkLen, file->getData() + fileOffset);
    }
    
    virtual void write(NetConnection *, BitStream *bstream)
    {
-      bstream->writeRangedU32(chunkLen, 0, ChunkSize);
+      bstream->writeRangedU32(chunkLen, 1, ChunkSize);
       bstream->write(chunkLen, chunkData);
    }
    
    virtual void unpack(NetConnection *, BitStream *bstream)
    {
-      chunkLen = bstream->readRangedU32(0, ChunkSize);
+      chunkLen = bstream->readRangedU32(1, ChunkSize);
       bstream->read(chunkLen, chunkData);
    }
    
@@ -145,7 +209,7 @@ public:
    virtual void notifyDelivered(NetConnection *nc, bool madeIt)
    {
       if(!nc->isRemoved())
-        nc->sendFileChunk();
+        nc->fileChunkDelivered(file);
    }
    
    DECLARE_CONOBJECT(FileChunkEvent);
@@ -158,23 +222,40 @@ ConsoleDocClass( FileChunkEvent,
 				"Not intended for game development, for editors or internal use only.\n\n "
 				"@internal");
 
-void NetConnection::sendFileChunk()
+U32 NetConnection::smTransferPacketRate = 64;
+U32 NetConnection::smTransferPacketSize = 1150;
+
+/// Where a file is kept while it downloads.
+static String getPartFileName(const char *fileName)
 {
-   U8 buffer[FileChunkEvent::ChunkSize];
-   U32 len = FileChunkEvent::ChunkSize;
-   if(len + mCurrentFileBufferOffset > mCurrentFileBufferSize)
-      len = mCurrentFileBufferSize - mCurrentFileBufferOffset;
+   return String(fileName) + ".part";
+}
 
-   if(!len)
+void NetConnection::sendFileChunks()
+{
+   while(mFileChunksInFlight < FileChunkWindow && mCurrentFileBufferOffset < mCurrentFileBufferSize)
    {
-      delete mCurrentDownloadingFile;
-      mCurrentDownloadingFile = NULL;
-      return;
+      U32 len = getMin(U32(FileChunkSize), mCurrentFileBufferSize - mCurrentFileBufferOffset);
+      postNetEvent(new FileChunkEvent(mCurrentDownloadingFile, mCurrentFileBufferOffset, len));
+      mCurrentFileBufferOffset += len;
+      mFileChunksInFlight++;
    }
+}
 
-   mCurrentFileBufferOffset += len;
-   mCurrentDownloadingFile->read(len, buffer);
-   postNetEvent(new FileChunkEvent(buffer, len));
+void NetConnection::fileChunkDelivered(MappedFile *file)
+{
+   // Chunks of a file we have stopped sending don't count.
+   if(file != mCurrentDownloadingFile || !mFileChunksInFlight)
+      return;
+
+   mFileChunksInFlight--;
+   if(mCurrentFileBufferOffset < mCurrentFileBufferSize)
+      sendFileChunks();
+   else if(!mFileChunksInFlight)
+   {
+      mCurrentDownloadingFile = NULL;
+      checkMaxRate();
+   }
 }
 
 bool NetConnection::startSendingFile(const char *fileName)
@@ -185,23 +266,28 @@ bool NetConnection::startSendingFile(const char *fileName)
       return false;
    }
 
-   mCurrentDownloadingFile = FileStream::createAndOpen( fileName, Torque::FS::File::Read );
-   if(!mCurrentDownloadingFile)
+   mCurrentDownloadingFile = MappedFile::openForRead(fileName);
+   mFileChunksInFlight = 0;
+   if(mCurrentDownloadingFile.isNull())
    {
-      // the server didn't have the file, so send a 0 byte chunk:
+      // the server didn't have the file, so tell the client
       Con::printf("No such file '%s'.", fileName);
-      postNetEvent(new FileChunkEvent(NULL, 0));
+      postNetEvent(new FileDownloadStartEvent(false));
+      checkMaxRate();
       return false;
    }
 
    Con::printf("Sending file '%s'.", fileName);
-   mCurrentFileBufferSize = mCurrentDownloadingFile->getStreamSize();
+   mCurrentFileBufferSize = mCurrentDownloadingFile->getSize();
    mCurrentFileBufferOffset = 0;
 
-   // always have 32 file chunks (64 bytes each) in transit
-   sendConnectionMessage(FileDownloadSizeMessage, mCurrentFileBufferSize);
-   for(U32 i = 0; i < 32; i++)
-      sendFileChunk();
+   U32 crc = CRC::calculateCRC(mCurrentDownloadingFile->getData(), mCurrentFileBufferSize);
+   postNetEvent(new FileDownloadStartEvent(true, mCurrentFileBufferSize, crc));
+   if(!mCurrentFileBufferSize)
+      mCurrentDownloadingFile = NULL;
+   else
+      sendFileChunks();
+   checkMaxRate();
    return true;
 }
 
@@ -224,50 +310,78 @@ void NetConnection::sendNextFileDownloadRequest()
    }
 }
 
-
-void NetConnection::chunkReceived(U8 *chunkData, U32 chunkLen)
+void NetConnection::fileDownloadStarted(bool found, U32 size, U32 crc)
 {
-   if(chunkLen == 0)
+   if(!mMissingFileList.size() || mCurrentFileBuffer.isValid())
+   {
+      setLastError("Invalid packet. (unexpected file)");
+      return;
+   }
+
+   if(!found)
    {
       // the server didn't have the file... apparently it's one we don't need...
-      dFree(mCurrentFileBuffer);
-      mCurrentFileBuffer = NULL;
       dFree(mMissingFileList[0]);
       mMissingFileList.pop_front();
       return;
    }
-   if(chunkLen + mCurrentFileBufferOffset > mCurrentFileBufferSize)
+
+   mCurrentFileBuffer = MappedFile::create(getPartFileName(mMissingFileList[0]), size);
+   if(mCurrentFileBuffer.isNull())
+   {
+      setLastError("Couldn't open file downloaded by server.");
+      return;
+   }
+   mCurrentFileBufferSize = size;
+   mCurrentFileBufferOffset = 0;
+   mCurrentFileCRC = crc;
+   checkMaxRate();
+
+   if(!size)
+      chunkReceived(NULL, 0);
+}
+
+void NetConnection::chunkReceived(U8 *chunkData, U32 chunkLen)
+{
+   if(mCurrentFileBuffer.isNull() || chunkLen + mCurrentFileBufferOffset > mCurrentFileBufferSize)
    {
       setLastError("Invalid file chunk from server.");
       return;
    }
-   dMemcpy(((U8 *) mCurrentFileBuffer) + mCurrentFileBufferOffset, chunkData, chunkLen);
+   dMemcpy(mCurrentFileBuffer->getData() + mCurrentFileBufferOffset, chunkData, chunkLen);
    mCurrentFileBufferOffset += chunkLen;
-   if(mCurrentFileBufferOffset == mCurrentFileBufferSize)
+   if(mCurrentFileBufferOffset < mCurrentFileBufferSize)
    {
-      // this file's done...
-      // save it to disk:
-      FileStream *stream;
+      Con::executef("onFileChunkReceived", mMissingFileList[0], Con::getIntArg(mCurrentFileBufferOffset), Con::getIntArg(mCurrentFileBufferSize));
+      return;
+   }
 
-      Con::printf("Saving file %s.", mMissingFileList[0]);
-      if((stream = FileStream::createAndOpen( mMissingFileList[0], Torque::FS::File::Write )) == NULL)
-      {
-         setLastError("Couldn't open file downloaded by server.");
-         return;
-      }
+   // this file's done...
+   String partName = getPartFileName(mMissingFileList[0]);
+   bool valid = CRC::calculateCRC(mCurrentFileBuffer->getData(), mCurrentFileBufferSize) == mCurrentFileCRC;
+   bool saved = mCurrentFileBuffer->close();
+   mCurrentFileBuffer = NULL;
+   checkMaxRate();
 
-      dFree(mMissingFileList[0]);
-      mMissingFileList.pop_front();
-      stream->write(mCurrentFileBufferSize, mCurrentFileBuffer);
-      delete stream;
-      mNumDownloadedFiles++;
-      dFree(mCurrentFileBuffer);
-      mCurrentFileBuffer = NULL;
-      sendNextFileDownloadRequest();
+   if(!valid || !saved)
+   {
+      Torque::FS::Remove(partName);
+      setLastError(valid ? "Couldn't save file downloaded by server." : "Invalid file from server.");
+      return;
    }
-   else
+
+   // save it under its real name
+   Con::printf("Saving file %s.", mMissingFileList[0]);
+   if(Torque::FS::IsFile(mMissingFileList[0]))
+      Torque::FS::Remove(mMissingFileList[0]);
+   if(!Torque::FS::Rename(partName, mMissingFileList[0]))
    {
-      Con::executef("onFileChunkReceived", mMissingFileList[0], Con::getIntArg(mCurrentFileBufferOffset), Con::getIntArg(mCurrentFileBufferSize));
+      setLastError("Couldn't open file downloaded by server.");
+      return;
    }
-}
 
+   dFree(mMissingFileList[0]);
+   mMissingFileList.pop_front();
+   mNumDownloadedFiles++;
+   sendNextFileDownloadRequest();
+}
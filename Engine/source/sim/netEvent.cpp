@@ -198,10 +198,14 @@ void NetConnection::eventWritePacket(BitStream *bstream, PacketNotify *notify)
 #ifdef TORQUE_NET_STATS
       U32 beginSize = bstream->getBitPosition();
 #endif
-      ev->mEvent->pack(this, bstream);
+      {
+         // Events make no promises about thread-safety.
+         PacketWriteLock lock;
+         ev->mEvent->pack(this, bstream);
 #ifdef TORQUE_NET_STATS
-      ev->mEvent->getClassRep()->updateNetStatPack(0, bstream->getBitPosition() - beginSize);
+         ev->mEvent->getClassRep()->updateNetStatPack(0, bstream->getBitPosition() - beginSize);
 #endif
+      }
       DEBUG_LOG(("PKLOG %d EVENT %d: %s", getId(), bstream->getBitPosition() - start, ev->mEvent->getDebugName()) );
 
 #ifdef TORQUE_DEBUG_NET
@@ -256,17 +260,25 @@ void NetConnection::eventWritePacket(BitStream *bstream, PacketNotify *notify)
 #ifdef TORQUE_NET_STATS
       U32 beginSize = bstream->getBitPosition();
 #endif
-      ev->mEvent->pack(this, bstream);
+      {
+         // Events make no promises about thread-safety.
+         PacketWriteLock lock;
+         ev->mEvent->pack(this, bstream);
 #ifdef TORQUE_NET_STATS
-      ev->mEvent->getClassRep()->updateNetStatPack(0, bstream->getBitPosition() - beginSize);
+         ev->mEvent->getClassRep()->updateNetStatPack(0, bstream->getBitPosition() - beginSize);
 #endif
+      }
       DEBUG_LOG(("PKLOG %d EVENT %d: %s", getId(), bstream->getBitPosition() - start, ev->mEvent->getDebugName()) );
 #ifdef TORQUE_DEBUG_NET
       bstream->writeInt(classId ^ DebugChecksum, 32);
 #endif
    }
-   for(NetEventNote *ev = packQueueHead; ev; ev = ev->mNextEvent)
-      ev->mEvent->notifySent(this);
+   if(packQueueHead)
+   {
+      PacketWriteLock lock;
+      for(NetEventNote *ev = packQueueHead; ev; ev = ev->mNextEvent)
+         ev->mEvent->notifySent(this);
+   }
 
    notify->eventList = packQueueHead;
    bstream->writeFlag(false);
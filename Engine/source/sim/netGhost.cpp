@@ -26,6 +26,7 @@
 #include "sim/netConnection.h"
 #include "core/stream/bitStream.h"
 #include "sim/netObject.h"
+#include "sim/netBlob.h"
 //#include "core/resManager.h"
 #include "console/console.h"
 #include "console/consoleTypes.h"
@@ -37,6 +38,90 @@ Signal<void()>    NetConnection::smGhostAlwaysDone;
 
 extern U32 gGhostUpdates;
 
+bool NetConnection::smGhostDeltaCompression = false;
+
+//-----------------------------------------------------------------------------
+// Ghost update deltas.
+//
+// A delta is the update XORed with the base update, sent a 32 bit word at a
+// time: a flag for whether the word changed, and for a word that did, a flag
+// per byte followed by the XORed byte if it changed.  Updates mostly change a
+// few fields at a time, so most words cost a single bit.  Past the end of the
+// base, the base is taken to be zero.
+
+/// Copy an update, clearing the unused bits of its last byte.
+static U8 *copyGhostPayload(const U8 *src, U32 bits)
+{
+   U32 bytes = (bits + 7) >> 3;
+   U8 *ret = (U8 *) dMalloc(getMax(bytes, U32(1)));
+   dMemcpy(ret, src, bytes);
+   if(bits & 7)
+      ret[bytes - 1] &= (1 << (bits & 7)) - 1;
+   return ret;
+}
+
+/// Write the delta from base to payload.  If stream is NULL, nothing is
+/// written.  Returns the size of the delta in bits.
+static U32 writeGhostDelta(BitStream *stream, const U8 *payload, U32 bits, const U8 *base, U32 baseBits)
+{
+   U32 bytes = (bits + 7) >> 3;
+   U32 baseBytes = (baseBits + 7) >> 3;
+   U32 size = 0;
+
+   for(U32 word = 0; word < bytes; word += 4)
+   {
+      U32 count = getMin(bytes - word, U32(4));
+      U8 diff[4];
+      bool changed = false;
+      for(U32 i = 0; i < count; i++)
+      {
+         U32 byte = word + i;
+         diff[i] = payload[byte] ^ (byte < baseBytes ? base[byte] : 0);
+         if(byte == bytes - 1 && (bits & 7))
+            diff[i] &= (1 << (bits & 7)) - 1;
+         changed |= diff[i] != 0;
+      }
+
+      size++;
+      if(stream)
+         stream->writeFlag(changed);
+      if(!changed)
+         continue;
+
+      for(U32 i = 0; i < count; i++)
+      {
+         U32 byteBits = getMin(bits - (word + i) * 8, U32(8));
+         size += 1 + (diff[i] ? byteBits : 0);
+         if(stream && stream->writeFlag(diff[i] != 0))
+            stream->writeInt(diff[i], byteBits);
+      }
+   }
+   return size;
+}
+
+/// Read a delta written by writeGhostDelta() and apply it to base.
+static void readGhostDelta(BitStream *stream, U8 *payload, U32 bits, const U8 *base, U32 baseBits)
+{
+   U32 bytes = (bits + 7) >> 3;
+   U32 baseBytes = (baseBits + 7) >> 3;
+
+   for(U32 word = 0; word < bytes; word += 4)
+   {
+      U32 count = getMin(bytes - word, U32(4));
+      bool changed = stream->readFlag();
+      for(U32 i = 0; i < count; i++)
+      {
+         U32 byte = word + i;
+         U8 value = byte < baseBytes ? base[byte] : 0;
+         if(changed && stream->readFlag())
+            value ^= stream->readInt(getMin(bits - byte * 8, U32(8)));
+         payload[byte] = value;
+      }
+   }
+   if(bits & 7)
+      payload[bytes - 1] &= (1 << (bits & 7)) - 1;
+}
+
 class GhostAlwaysObjectEvent : public NetEvent
 {
    SimObjectId objectId;
@@ -184,6 +269,9 @@ void NetConnection::setGhostFrom(bool ghostFrom)
          mGhostRefs[i].obj = NULL;
          mGhostRefs[i].index = i;
          mGhostRefs[i].updateMask = 0;
+         mGhostRefs[i].deltaBase = NULL;
+         mGhostRefs[i].deltaBaseBits = 0;
+         mGhostRefs[i].deltaBaseSeq = 0;
       }
       mGhostLookupTable = new GhostInfo *[GhostLookupTableSize];
       for(i = 0; i < GhostLookupTableSize; i++)
@@ -254,6 +342,7 @@ void NetConnection::ghostPacketDropped(PacketNotify *notify)
          packRef->ghost->flags &= ~GhostInfo::KillingGhost;
       }
 
+      dFree(packRef->payload);
       delete packRef;
       packRef = temp;
    }
@@ -280,6 +369,17 @@ void NetConnection::ghostPacketReceived(PacketNotify *notify)
 
       *walk = 0;
 
+      // the client has this update now, so later ones can be sent
+      // as deltas against it
+
+      if(packRef->payload)
+      {
+         ghostClearDeltaBase(packRef->ghost);
+         packRef->ghost->deltaBase = packRef->payload;
+         packRef->ghost->deltaBaseBits = packRef->payloadBits;
+         packRef->ghost->deltaBaseSeq = packRef->seq;
+      }
+
       // if this object was ghosting , it is now ghosted
 
       if(packRef->ghostInfoFlags & GhostInfo::Ghosting)
@@ -313,32 +413,9 @@ static S32 QSORT_CALLBACK UQECompare(const void *a,const void *b)
    return (ret < 0) ? -1 : ((ret > 0) ? 1 : 0);
 }
 
-void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
+void NetConnection::ghostScopePacket()
 {
-#ifdef    TORQUE_DEBUG_NET
-   bstream->writeInt(DebugChecksum, 32);
-#endif
-
-   notify->ghostList = NULL;
-
-   if(!isGhostingFrom())
-      return;
-
-   if(!bstream->writeFlag(mGhosting))
-      return;
-
-   // fill a packet (or two) with ghosting data
-
-   // first step is to check all our polled ghosts:
-
-   // 1. Scope query - find if any new objects have come into
-   //    scope and if any have gone out.
-   // 2. call scoped objects' priority functions if the flag set is nonzero
-   //    A removed ghost is assumed to have a high priority
-   // 3. call updates based on sorted priority until the packet is
-   //    full.  set flags to zero for all updated objects
-
-   CameraScopeQuery camInfo;
+   CameraScopeQuery &camInfo = mScopeQuery;
 
    camInfo.camera = NULL;
    camInfo.pos.set(0,0,0);
@@ -350,8 +427,6 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
 
    GhostInfo *walk;
 
-   // only need to worry about the ghosts that have update masks set...
-   S32 maxIndex = 0;
    S32 i;
    for(i = 0; i < mGhostZeroUpdateIndex; i++)
    {
@@ -378,6 +453,45 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
          detachObject(mGhostArray[i]);
    }
 
+   mScopedForPacket = true;
+}
+
+void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
+{
+#ifdef    TORQUE_DEBUG_NET
+   bstream->writeInt(DebugChecksum, 32);
+#endif
+
+   notify->ghostList = NULL;
+
+   if(!isGhostingFrom())
+      return;
+
+   if(!bstream->writeFlag(mGhosting))
+      return;
+
+   // fill a packet (or two) with ghosting data
+
+   // first step is to check all our polled ghosts:
+
+   // 1. Scope query - find if any new objects have come into
+   //    scope and if any have gone out.
+   // 2. call scoped objects' priority functions if the flag set is nonzero
+   //    A removed ghost is assumed to have a high priority
+   // 3. call updates based on sorted priority until the packet is
+   //    full.  set flags to zero for all updated objects
+
+   if(!mScopedForPacket)
+      ghostScopePacket();
+   mScopedForPacket = false;
+
+   CameraScopeQuery &camInfo = mScopeQuery;
+
+   GhostInfo *walk;
+
+   // only need to worry about the ghosts that have update masks set...
+   S32 maxIndex = 0;
+   S32 i;
    for(i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
    {
       walk = mGhostArray[i];
@@ -397,7 +511,10 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
          if(walk->flags & GhostInfo::KillGhost)
             walk->priority = 10000;
          else
+         {
+            PacketWriteLock lock(walk->obj->isThreadSafePack());
             walk->priority = walk->obj->getUpdatePriority(&camInfo, walk->updateMask, walk->updateSkipCount);
+         }
       }
       else
          walk->priority = 0;
@@ -440,6 +557,7 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
 
       upd->ghost = walk;
       upd->ghostInfoFlags = 0;
+      upd->payload = NULL;
 
       if(walk->flags & GhostInfo::KillGhost)
       {
@@ -480,9 +598,12 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
 #ifdef TORQUE_NET_STATS
          U32 beginSize = bstream->getBitPosition();
 #endif
-         U32 retMask = walk->obj->packUpdate(this, updateMask, bstream);
+         U32 retMask = ghostWriteUpdate(walk, updateMask, bstream, upd);
 #ifdef TORQUE_NET_STATS
-         walk->obj->getClassRep()->updateNetStatPack(updateMask, bstream->getBitPosition() - beginSize);
+         {
+            PacketWriteLock lock;
+            walk->obj->getClassRep()->updateNetStatPack(updateMask, bstream->getBitPosition() - beginSize);
+         }
 #endif
          DEBUG_LOG(("PKLOG %d GHOST %d: %s", getId(), bstream->getBitPosition() - 16 - startPos, walk->obj->getClassName()));
 
@@ -543,6 +664,7 @@ void NetConnection::ghostReadPacket(BitStream *bstream)
          AssertFatal(mLocalGhosts[index] != NULL, "Error, NULL ghost encountered.");
          mLocalGhosts[index]->deleteObject();
          mLocalGhosts[index] = NULL;
+         ghostClearDeltaHistory(index);
       }
       else
       {
@@ -586,7 +708,9 @@ void NetConnection::ghostReadPacket(BitStream *bstream)
 #ifdef TORQUE_NET_STATS
             U32 beginSize = bstream->getBitPosition();
 #endif
-            mLocalGhosts[index]->unpackUpdate(this, bstream);
+            ghostClearDeltaHistory(index);
+            if(!ghostReadUpdate(index, bstream, true))
+               return;
 #ifdef TORQUE_NET_STATS
             mLocalGhosts[index]->getClassRep()->updateNetStatUnpack(bstream->getBitPosition() - beginSize);
 #endif
@@ -635,7 +759,8 @@ void NetConnection::ghostReadPacket(BitStream *bstream)
 #ifdef TORQUE_NET_STATS
             U32 beginSize = bstream->getBitPosition();
 #endif
-            mLocalGhosts[index]->unpackUpdate(this, bstream);
+            if(!ghostReadUpdate(index, bstream, false))
+               return;
 #ifdef TORQUE_NET_STATS
             mLocalGhosts[index]->getClassRep()->updateNetStatUnpack(bstream->getBitPosition() - beginSize);
 #endif
@@ -713,11 +838,177 @@ void NetConnection::freeGhostInfo(GhostInfo *ghost)
       ghostPushToZero(ghost);
    }
    ghostPushZeroToFree(ghost);
+   ghostClearDeltaBase(ghost);
    AssertFatal(ghost->updateChain == NULL, "Ack!");
 }
 
 //-----------------------------------------------------------------------------
 
+U32 NetConnection::ghostWriteUpdate(GhostInfo *info, U32 updateMask, BitStream *bstream, GhostRef *ref)
+{
+   if(!mGhostDeltas)
+   {
+      PacketWriteLock lock(info->obj->isThreadSafePack());
+      return info->obj->packUpdate(this, updateMask, bstream);
+   }
+
+   if(!mGhostDeltaBuffer)
+      mGhostDeltaBuffer = new U8[Net::MaxPacketDataSize];
+
+   // Pack into the scratch buffer, then decide how to send it.
+   BitStream payload(mGhostDeltaBuffer, Net::MaxPacketDataSize);
+   payload.setCompressionPoint(bstream->getCompressionPoint());
+   payload.setStringCoder(bstream->getStringCoder());
+
+   U32 retMask;
+   {
+      PacketWriteLock lock(info->obj->isThreadSafePack());
+      retMask = info->obj->packUpdate(this, updateMask, &payload);
+   }
+   bstream->setCompressionPoint(payload.getCompressionPoint());
+
+   U32 bits = payload.getCurPos();
+   AssertFatal(bits < (1 << GhostPayloadBitSize), "NetConnection::ghostWriteUpdate - update too big.");
+
+   // Keep the update.  If the packet gets through, it becomes the base
+   // for later deltas.
+   ref->payload = copyGhostPayload(mGhostDeltaBuffer, bits);
+   ref->payloadBits = bits;
+   ref->seq = mLastSendSeq;
+
+   // New ghosts have nothing on the client to delta against.
+   if(ref->ghostInfoFlags & GhostInfo::Ghosting)
+   {
+      bstream->writeBits(bits, mGhostDeltaBuffer);
+      return retMask;
+   }
+
+   bool delta = false;
+   U32 age = mLastSendSeq - info->deltaBaseSeq;
+   if(info->deltaBase && age <= MaxGhostDeltaAge)
+   {
+      U32 deltaBits = GhostDeltaAgeBitSize + 1 + (bits != info->deltaBaseBits ? GhostPayloadBitSize : 0) +
+         writeGhostDelta(NULL, mGhostDeltaBuffer, bits, info->deltaBase, info->deltaBaseBits);
+      delta = deltaBits < bits;
+   }
+
+   if(bstream->writeFlag(delta))
+   {
+      bstream->writeInt(age, GhostDeltaAgeBitSize);
+      if(!bstream->writeFlag(bits == info->deltaBaseBits))
+         bstream->writeInt(bits, GhostPayloadBitSize);
+      writeGhostDelta(bstream, mGhostDeltaBuffer, bits, info->deltaBase, info->deltaBaseBits);
+   }
+   else
+      bstream->writeBits(bits, mGhostDeltaBuffer);
+
+   return retMask;
+}
+
+bool NetConnection::ghostReadUpdate(U32 index, BitStream *bstream, bool newGhost)
+{
+   NetObject *ghost = mLocalGhosts[index];
+   if(!mGhostDeltas)
+   {
+      ghost->unpackUpdate(this, bstream);
+      return true;
+   }
+
+   if(!mGhostDeltaBuffer)
+      mGhostDeltaBuffer = new U8[Net::MaxPacketDataSize];
+   if(!mGhostDeltaHistory)
+      mGhostDeltaHistory = new Vector<GhostPayload>[MaxGhostCount];
+
+   Vector<GhostPayload> &history = mGhostDeltaHistory[index];
+   U32 bits;
+
+   if(!newGhost && bstream->readFlag())
+   {
+      // The server only ever moves its base forward, so anything
+      // older than this one won't be needed again.
+      U32 baseSeq = mLastSeqRecvd - bstream->readInt(GhostDeltaAgeBitSize);
+      while(history.size() && history.first().seq < baseSeq)
+      {
+         dFree(history.first().data);
+         history.pop_front();
+      }
+      if(!history.size() || history.first().seq != baseSeq)
+      {
+         setLastError("Invalid packet. (missing ghost delta base)");
+         return false;
+      }
+
+      const GhostPayload &base = history.first();
+      bits = bstream->readFlag() ? base.bits : bstream->readInt(GhostPayloadBitSize);
+      if(bits > Net::MaxPacketDataSize * 8)
+      {
+         setLastError("Invalid packet. (ghost delta too big)");
+         return false;
+      }
+      readGhostDelta(bstream, mGhostDeltaBuffer, bits, base.data, base.bits);
+
+      BitStream payload(mGhostDeltaBuffer, (bits + 7) >> 3);
+      payload.setCompressionPoint(bstream->getCompressionPoint());
+      payload.setStringCoder(bstream->getStringCoder());
+      ghost->unpackUpdate(this, &payload);
+      bstream->setCompressionPoint(payload.getCompressionPoint());
+
+      if(payload.getCurPos() != bits)
+      {
+         setLastError("Invalid packet. (ghost delta size mismatch)");
+         return false;
+      }
+   }
+   else
+   {
+      // Unpack straight from the packet, then go back and copy
+      // out what was read to keep as a base.
+      U32 start = bstream->getCurPos();
+      ghost->unpackUpdate(this, bstream);
+      bits = bstream->getCurPos() - start;
+      if(bits > Net::MaxPacketDataSize * 8)
+      {
+         setLastError("Invalid packet. (ghost update too big)");
+         return false;
+      }
+      bstream->setCurPos(start);
+      bstream->readBits(bits, mGhostDeltaBuffer);
+   }
+
+   // The server won't use a base more than MaxGhostDeltaAge packets old.
+   while(history.size() && history.first().seq + MaxGhostDeltaAge < mLastSeqRecvd)
+   {
+      dFree(history.first().data);
+      history.pop_front();
+   }
+
+   GhostPayload entry;
+   entry.seq = mLastSeqRecvd;
+   entry.bits = bits;
+   entry.data = copyGhostPayload(mGhostDeltaBuffer, bits);
+   history.push_back(entry);
+   return true;
+}
+
+void NetConnection::ghostClearDeltaBase(GhostInfo *info)
+{
+   dFree(info->deltaBase);
+   info->deltaBase = NULL;
+}
+
+void NetConnection::ghostClearDeltaHistory(U32 index)
+{
+   if(!mGhostDeltaHistory)
+      return;
+
+   Vector<GhostPayload> &history = mGhostDeltaHistory[index];
+   for(S32 i = 0; i < history.size(); i++)
+      dFree(history[i].data);
+   history.clear();
+}
+
+//-----------------------------------------------------------------------------
+
 void NetConnection::objectLocalScopeAlways(NetObject *obj)
 {
    if(!isGhostingFrom())
@@ -831,7 +1122,6 @@ void NetConnection::objectInScope(NetObject *obj)
 void NetConnection::handleConnectionMessage(U32 message, U32 sequence, U32 ghostCount)
 {
    if((  message == SendNextDownloadRequest
-      || message == FileDownloadSizeMessage
       || message == GhostAlwaysStarting
       || message == GhostAlwaysDone
       || message == EndGhosting) && !isGhostingTo())
@@ -871,6 +1161,7 @@ void NetConnection::handleConnectionMessage(U32 message, U32 sequence, U32 ghost
          break;
       case EndGhosting:
          onEndGhosting();
+         cancelBlobTransfer(BlobGhostAlways);
          // just delete all the local ghosts,
          // and delete all the ghosts in the current save list
          for(i = 0; i < MaxGhostCount; i++)
@@ -880,6 +1171,7 @@ void NetConnection::handleConnectionMessage(U32 message, U32 sequence, U32 ghost
                mLocalGhosts[i]->deleteObject();
                mLocalGhosts[i] = NULL;
             }
+            ghostClearDeltaHistory(i);
          }
          while(mGhostAlwaysSaveList.size())
          {
@@ -893,11 +1185,6 @@ void NetConnection::handleConnectionMessage(U32 message, U32 sequence, U32 ghost
       case SendNextDownloadRequest:
          sendNextFileDownloadRequest();
          break;
-      case FileDownloadSizeMessage:
-         mCurrentFileBufferSize = sequence;
-         mCurrentFileBuffer = dRealloc(mCurrentFileBuffer, mCurrentFileBufferSize);
-         mCurrentFileBufferOffset = 0;
-         break;
    }
 }
 
@@ -1004,6 +1291,13 @@ void NetConnection::activateGhosting()
             pClient->setGhostAlwaysObject(pObject, mGhostArray[j]->index);
         }
     }
+    else if (isBlobTransferEnabled() && ghostSendAlwaysBlob())
+    {
+        // Sent the scope always objects as one blob.  The client acts as
+        // if it got GhostAlwaysDone once it has read them all.  If they
+        // didn't fit in a blob, they go out as events below.
+        return;
+    }
     else
     {
         // Iterate through the scope always objects...
@@ -1026,6 +1320,59 @@ void NetConnection::activateGhosting()
     sendConnectionMessage(GhostAlwaysDone, mGhostingSequence);   //AssertFatal(validateGhostArray(), "Invalid ghost array!");
 }
 
+bool NetConnection::ghostSendAlwaysBlob()
+{
+   ResizeBitStream stream(Net::MaxPacketDataSize);
+
+   for(S32 j = mGhostZeroUpdateIndex - 1; j >= 0; j--)
+   {
+      AssertFatal((mGhostArray[j]->flags & GhostInfo::ScopeAlways) != 0, "NetConnection::ghostSendAlwaysBlob:  Non-scope always in the scope always list.")
+
+      stream.writeFlag(true);
+      GhostAlwaysObjectEvent event(mGhostArray[j]->obj, mGhostArray[j]->index);
+      event.pack(this, &stream);
+      stream.validate();
+   }
+   stream.writeFlag(false);
+
+   NetBlob *blob = NetBlob::create(stream.getBuffer(), stream.getPosition());
+   if(!blob)
+   {
+      Con::warnf("NetConnection::ghostSendAlwaysBlob - ghost always objects too large for a blob, sending them as events.");
+      return false;
+   }
+
+   for(S32 j = mGhostZeroUpdateIndex - 1; j >= 0; j--)
+   {
+      mGhostArray[j]->updateMask = 0;
+      ghostPushToZero(mGhostArray[j]);
+      mGhostArray[j]->flags &= ~GhostInfo::NotYetGhosted;
+      mGhostArray[j]->flags |= GhostInfo::ScopedEvent;
+   }
+
+   sendBlob(BlobGhostAlways, mGhostingSequence, blob);
+   return true;
+}
+
+void NetConnection::ghostReadAlwaysBlob(U32 sequence, BitStream *stream)
+{
+   if(!isGhostingTo())
+   {
+      setLastError("Invalid packet. (not ghosting)");
+      return;
+   }
+
+   while(stream->readFlag())
+   {
+      GhostAlwaysObjectEvent event;
+      event.unpack(this, stream);
+      if(mErrorBuffer.isNotEmpty())
+         return;
+      event.process(this);
+   }
+   handleConnectionMessage(GhostAlwaysDone, sequence, 0);
+}
+
 void NetConnection::clearGhostInfo()
 {
    // gotta clear out the ghosts...
@@ -1054,6 +1401,7 @@ void NetConnection::resetGhosting()
 
    mGhosting = false;
    mScoping = false;
+   cancelBlobTransfer(BlobGhostAlways);
    sendConnectionMessage(EndGhosting, mGhostingSequence);
    mGhostingSequence++;
    clearGhostInfo();
@@ -1070,6 +1418,7 @@ void NetConnection::setGhostAlwaysObject(NetObject *object, U32 index)
    }
    object->mNetFlags = NetObject::IsGhost;
    object->mNetIndex = index;
+   ghostClearDeltaHistory(index);
 
    // while there's an object waiting...
    if ( isLocalConnection() ) 
@@ -1235,6 +1584,29 @@ void NetConnection::ghostWriteStartBlock(ResizeBitStream *stream)
 
    stream->writeFlag(false);
 
+   // the updates kept as delta bases go in too, or the first delta
+   // in the demo won't have anything to apply to.
+   if(stream->writeFlag(mGhostDeltas) && mGhostDeltaHistory)
+   {
+      for(U32 i = 0; i < MaxGhostCount; i++)
+      {
+         const Vector<GhostPayload> &history = mGhostDeltaHistory[i];
+         if(!history.size())
+            continue;
+         stream->writeFlag(true);
+         stream->writeInt(i, GhostIdBitSize);
+         stream->writeInt(history.size(), GhostDeltaAgeBitSize + 1);
+         for(S32 j = 0; j < history.size(); j++)
+         {
+            stream->write(history[j].seq);
+            stream->writeInt(history[j].bits, GhostPayloadBitSize);
+            stream->writeBits(history[j].bits, history[j].data);
+            stream->validate();
+         }
+      }
+   }
+   stream->writeFlag(false);
+
    // then, for each ghost written into the start block, write the full pack update
    // into the start block.  For demos to work properly, packUpdate must
    // be callable from client objects.
@@ -1271,6 +1643,27 @@ void NetConnection::ghostReadStartBlock(BitStream *stream)
       mLocalGhosts[index] = obj;
    }
 
+   // then the delta bases
+   mGhostDeltas = stream->readFlag();
+   while(stream->readFlag())
+   {
+      U32 index = stream->readInt(GhostIdBitSize);
+      U32 count = stream->readInt(GhostDeltaAgeBitSize + 1);
+      if(!mGhostDeltaHistory)
+         mGhostDeltaHistory = new Vector<GhostPayload>[MaxGhostCount];
+      ghostClearDeltaHistory(index);
+      for(U32 i = 0; i < count; i++)
+      {
+         GhostPayload entry;
+         stream->read(&entry.seq);
+         entry.bits = getMin(U32(stream->readInt(GhostPayloadBitSize)), U32(Net::MaxPacketDataSize * 8));
+         U8 buffer[Net::MaxPacketDataSize];
+         stream->readBits(entry.bits, buffer);
+         entry.data = copyGhostPayload(buffer, entry.bits);
+         mGhostDeltaHistory[index].push_back(entry);
+      }
+   }
+
    // now, all the ghosts are in the mLocalGhosts, so we loop
    // through all non-null mLocalGhosts, unpacking the objects
    // as we go:
@@ -434,12 +434,15 @@ void NetInterface::processClient()
 void NetInterface::processServer()
 {
    NetObject::collapseDirtyList(); // collapse all the mask bits...
+
+   Vector<NetConnection *> clients;
    for(NetConnection *walk = NetConnection::getConnectionList();
       walk; walk = walk->getNext())
    {
       if(!walk->isConnectionToServer() && (walk->isLocalConnection() || walk->isNetworkConnection()))
-         walk->checkPacketSend(false);
+         clients.push_back(walk);
    }
+   NetConnection::checkPacketSends(clients, false);
 }
 
 void NetInterface::startConnection(NetConnection *conn)
@@ -269,6 +269,7 @@ protected:
       ScopeAlways       =  BIT(6),  ///< Object always ghosts to clients.
       ScopeLocal        =  BIT(7),  ///< Ghost only to local client.
       Ghostable         =  BIT(8),  ///< Set if this object CAN ghost.
+      ThreadSafePack    =  BIT(9),  ///< packUpdate() may run on a worker thread.  @see packUpdate
 
       MaxNetFlagBit     =  15
    };
@@ -334,6 +335,22 @@ public:
 
    /// Instructs this object to pack its state for transfer over the network.
    ///
+   /// When $pref::Net::ParallelPacketWrite is enabled, packets for different
+   /// connections are written concurrently on worker threads while the main
+   /// thread waits.  Objects that set the ThreadSafePack net flag have their
+   /// packUpdate() and getUpdatePriority() called concurrently for different
+   /// connections, so these may only:
+   ///
+   /// - read the state of this and other objects, but not modify it (no
+   ///   setMaskBits(), no lazily computed caches),
+   /// - use the connection they are passed (ghost indices, string handles),
+   /// - write to @a stream.
+   ///
+   /// In particular, they must not call into the console or create SimObjects.
+   /// Subclasses inherit the flag and must either uphold this contract or
+   /// clear the flag in their constructor.  Objects without the flag are still
+   /// packed on the worker threads but one at a time.
+   ///
    /// @param   conn    Net connection being used
    /// @param   mask    Mask indicating fields to transmit.
    /// @param   stream  Bitstream to pack data to
@@ -373,6 +390,7 @@ public:
    bool isScopeable() const;     ///< Is this object subject to scoping?
    bool isGhostable() const;     ///< Is this object ghostable?
    bool isGhostAlways() const;   ///< Should this object always be ghosted?
+   bool isThreadSafePack() const; ///< May packUpdate() run on a worker thread?
 
 
    /// @name Short-Circuited Networking
@@ -429,6 +447,11 @@ inline bool NetObject::isScopeLocal() const
    return mNetFlags.test(ScopeLocal);
 }
 
+inline bool NetObject::isThreadSafePack() const
+{
+   return mNetFlags.test(ThreadSafePack);
+}
+
 inline bool NetObject::isScopeable() const
 {
    return mNetFlags.test(Ghostable) && !mNetFlags.test(ScopeAlways);
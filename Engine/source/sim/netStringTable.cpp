@@ -25,6 +25,7 @@
 #include "core/stringTable.h"
 #include "console/engineAPI.h"
 #include "sim/netStringTable.h"
+#include "platform/threads/mutex.h"
 
 
 NetStringTable *gNetStringTable = NULL;
@@ -46,28 +47,39 @@ NetStringTable::NetStringTable()
    for(U32 j = 0; j < HashTableSize; j++)
       hashTable[j] = 0;
    allocator = new DataChunker(DataChunkerSize);
+   mutex = Mutex::createMutex();
 }
 
 NetStringTable::~NetStringTable()
 {
+   Mutex::destroyMutex(mutex);
    delete allocator;
    dFree( table );
 }
 
 void NetStringTable::incStringRef(U32 id)
 {
+   MutexHandle lock;
+   lock.lock(mutex, true);
+
    AssertFatal(table[id].refCount != 0 || table[id].scriptRefCount != 0 , "Cannot inc ref count from zero.");
    table[id].refCount++;
 }
 
 void NetStringTable::incStringRefScript(U32 id)
 {
+   MutexHandle lock;
+   lock.lock(mutex, true);
+
    AssertFatal(table[id].refCount != 0 || table[id].scriptRefCount != 0 , "Cannot inc ref count from zero.");
    table[id].scriptRefCount++;
 }
 
 U32 NetStringTable::addString(const char *string)
 {
+   MutexHandle lock;
+   lock.lock(mutex, true);
+
    U32 hash = _StringTable::hashString(string);
    U32 bucket = hash % HashTableSize;
    for(U32 walk = hashTable[bucket];walk; walk = table[walk].next)
@@ -114,6 +126,9 @@ U32 GameAddTaggedString(const char *string)
 
 const char *NetStringTable::lookupString(U32 id)
 {
+   MutexHandle lock;
+   lock.lock(mutex, true);
+
    if(table[id].refCount == 0 && table[id].scriptRefCount == 0)
       return NULL;
    return table[id].string;
@@ -121,6 +136,9 @@ const char *NetStringTable::lookupString(U32 id)
 
 void NetStringTable::removeString(U32 id, bool script)
 {
+   MutexHandle lock;
+   lock.lock(mutex, true);
+
    if(!script)
    {
       AssertFatal(table[id].refCount != 0, "Error, ref count is already 0!!");
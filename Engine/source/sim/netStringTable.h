@@ -69,6 +69,10 @@ class NetStringTable
    U32 hashTable[HashTableSize];
    DataChunker *allocator;
 
+   /// Guards the table as handles may be copied while packets are
+   /// written on worker threads.
+   void *mutex;
+
     NetStringTable();
    ~NetStringTable();
 
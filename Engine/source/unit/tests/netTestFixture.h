@@ -0,0 +1,156 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#ifndef _UNIT_NETTESTFIXTURE_H_
+#define _UNIT_NETTESTFIXTURE_H_
+
+#ifndef _NETCONNECTION_H_
+#include "sim/netConnection.h"
+#endif
+#ifndef _GAMEBASE_H_
+#include "T3D/gameBase/gameBase.h"
+#endif
+#ifndef _BITSTREAM_H_
+#include "core/stream/bitStream.h"
+#endif
+#ifndef _CRC_H_
+#include "core/crc.h"
+#endif
+
+
+namespace UnitTesting
+{
+   /// Ghostable object with a small box that can also serve as the camera of
+   /// a NetTestConnection.  Doesn't declare its own class so that it goes
+   /// over the wire as a plain GameBase.
+   class NetTestObject : public GameBase
+   {
+      public:
+
+         typedef GameBase Parent;
+
+         /// Scoping distance when used as a camera.
+         F32 mVisibleDistance;
+
+         NetTestObject( bool threadSafePack = false )
+            : mVisibleDistance( 0.f )
+         {
+            mObjBox.set( Point3F( -1.f, -1.f, -1.f ), Point3F( 1.f, 1.f, 1.f ) );
+            if( threadSafePack )
+               mNetFlags.set( ThreadSafePack );
+         }
+
+         bool onAdd()
+         {
+            if( !Parent::onAdd() )
+               return false;
+
+            addToScene();
+            return true;
+         }
+
+         void onRemove()
+         {
+            removeFromScene();
+            Parent::onRemove();
+         }
+
+         void onCameraScopeQuery( NetConnection* connection, CameraScopeQuery* query )
+         {
+            query->camera = this;
+            query->pos = getPosition();
+            query->visibleDistance = mVisibleDistance;
+
+            Parent::onCameraScopeQuery( connection, query );
+         }
+   };
+
+   /// Server-side connection that is never connected to anything.  Packets
+   /// are either written into the void with writeGhostPacket() or, with
+   /// dropPackets set, built by the regular send path and left in the send
+   /// buffer for inspection.  Either way they are acknowledged by hand.
+   class NetTestConnection : public NetConnection
+   {
+      public:
+
+         typedef NetConnection Parent;
+
+         enum { PacketSize = 1500 };
+
+         void startGhosting( bool dropPackets = false )
+         {
+            setGhostFrom( true );
+            activateGhosting();
+            mGhosting = true;
+
+            if( dropPackets )
+               setSimulatedNetParams( 1.f, 0 );
+         }
+
+         /// Write and acknowledge a ghost packet outside of the send path.
+         void writeGhostPacket()
+         {
+            U8 buffer[ PacketSize ];
+            BitStream stream( buffer, sizeof( buffer ) );
+
+            PacketNotify* notify = allocNotify();
+            ghostWritePacket( &stream, notify );
+            ghostPacketReceived( notify );
+            delete notify;
+         }
+
+         /// CRC of the packet that was last built by the send path.
+         U32 getPacketCRC()
+         {
+            return CRC::calculateCRC( mSendStream->getBuffer(), mSendStream->getPosition() );
+         }
+
+         /// Pretend the other side received everything sent so far.
+         void ackAll()
+         {
+            while( mNotifyQueueHead )
+               handleNotify( true );
+            mHighestAckedSeq = mLastSendSeq;
+         }
+
+         /// Collect the IDs of the objects currently in scope.
+         void getScopedObjects( Vector< SimObjectId >& ids )
+         {
+            ids.clear();
+            for( S32 i = 0; i < mGhostFreeIndex; ++ i )
+            {
+               GhostInfo* info = mGhostArray[ i ];
+               if( info->obj && ( info->flags & GhostInfo::InScope ) )
+                  ids.push_back( info->obj->getId() );
+            }
+            dQsort( ids.address(), ids.size(), sizeof( SimObjectId ), _compareIds );
+         }
+
+         static S32 QSORT_CALLBACK _compareIds( const void* a, const void* b )
+         {
+            return S32( *( const SimObjectId* ) a ) - S32( *( const SimObjectId* ) b );
+         }
+   };
+}
+
+#endif // !_UNIT_NETTESTFIXTURE_H_
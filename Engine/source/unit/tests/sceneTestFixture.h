@@ -0,0 +1,71 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#ifndef _UNIT_SCENETESTFIXTURE_H_
+#define _UNIT_SCENETESTFIXTURE_H_
+
+#ifndef _SCENEOBJECT_H_
+#include "scene/sceneObject.h"
+#endif
+#ifndef _COLLISION_H_
+#include "collision/collision.h"
+#endif
+
+
+namespace UnitTesting
+{
+   /// Box centered on its origin that the container can find and cast rays
+   /// against.  castRay() only reads the object, so it is safe to call in
+   /// parallel.
+   class SceneTestBox : public SceneObject
+   {
+      public:
+
+         typedef SceneObject Parent;
+
+         SceneTestBox( const Point3F& halfSize, U32 typeMask = StaticShapeObjectType )
+         {
+            mTypeMask |= typeMask;
+            mObjBox.set( -halfSize, halfSize );
+            resetWorldBox();
+         }
+
+         /// Have the container keep the past positions of the box.
+         void setKeepHistory( bool keepHistory ) { mKeepHistory = keepHistory; }
+
+         bool castRay( const Point3F& start, const Point3F& end, RayInfo* info )
+         {
+            F32 t;
+            Point3F normal;
+            if( !mObjBox.collideLine( start, end, &t, &normal ) )
+               return false;
+
+            info->t = t;
+            info->normal = normal;
+            info->object = this;
+            return true;
+         }
+   };
+}
+
+#endif // !_UNIT_SCENETESTFIXTURE_H_
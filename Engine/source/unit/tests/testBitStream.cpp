@@ -0,0 +1,463 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/stream/bitStream.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+namespace {
+
+   /// The bit by bit BitStream primitives as they were before BitStream moved
+   /// whole words.  Used as the reference the word based code has to match.
+   class ReferenceBitStream
+   {
+      public:
+
+         U8* mData;
+         S32 mBitNum;
+         S32 mBufSize;
+
+         ReferenceBitStream( void* data, S32 size )
+            : mData( ( U8* ) data ), mBitNum( 0 ), mBufSize( size ) {}
+
+         virtual ~ReferenceBitStream() {}
+
+         virtual void writeBits( S32 bitCount, const void* bitPtr )
+         {
+            const U8* ptr = ( const U8* ) bitPtr;
+            for( S32 srcBitNum = 0; srcBitNum < bitCount; srcBitNum ++ )
+            {
+               if( ( *( ptr + ( srcBitNum >> 3 ) ) & ( 1 << ( srcBitNum & 0x7 ) ) ) != 0 )
+                  *( mData + ( mBitNum >> 3 ) ) |= ( 1 << ( mBitNum & 0x7 ) );
+               else
+                  *( mData + ( mBitNum >> 3 ) ) &= ~( 1 << ( mBitNum & 0x7 ) );
+               mBitNum ++;
+            }
+         }
+
+         virtual void readBits( S32 bitCount, void* bitPtr )
+         {
+            if( !bitCount )
+               return;
+
+            U8* stPtr = mData + ( mBitNum >> 3 );
+            S32 byteCount = ( bitCount + 7 ) >> 3;
+            U8* ptr = ( U8* ) bitPtr;
+            S32 downShift = mBitNum & 0x7;
+            S32 upShift = 8 - downShift;
+
+            U8 curB = *stPtr;
+            const U8* stEnd = mData + mBufSize;
+            while( byteCount -- )
+            {
+               stPtr ++;
+               U8 nextB = stPtr < stEnd ? *stPtr : 0;
+               *ptr ++ = ( curB >> downShift ) | ( nextB << upShift );
+               curB = nextB;
+            }
+
+            mBitNum += bitCount;
+         }
+
+         virtual bool writeFlag( bool val )
+         {
+            if( val )
+               *( mData + ( mBitNum >> 3 ) ) |= ( 1 << ( mBitNum & 0x7 ) );
+            else
+               *( mData + ( mBitNum >> 3 ) ) &= ~( 1 << ( mBitNum & 0x7 ) );
+            mBitNum ++;
+            return val;
+         }
+
+         virtual bool readFlag()
+         {
+            bool ret = ( *( mData + ( mBitNum >> 3 ) ) & ( 1 << ( mBitNum & 0x7 ) ) ) != 0;
+            mBitNum ++;
+            return ret;
+         }
+
+         void writeInt( S32 val, S32 bitCount )
+         {
+            val = convertHostToLEndian( val );
+            writeBits( bitCount, &val );
+         }
+
+         S32 readInt( S32 bitCount )
+         {
+            S32 ret = 0;
+            readBits( bitCount, &ret );
+            ret = convertLEndianToHost( ret );
+            if( bitCount == 32 )
+               return ret;
+            return ret & ( ( 1 << bitCount ) - 1 );
+         }
+
+         void setCurPos( U32 pos ) { mBitNum = pos; }
+         S32 getCurPos() const { return mBitNum; }
+   };
+
+   enum OpType
+   {
+      OpFlag,
+      OpInt,
+      OpBits,
+      OpSeek,
+      NumOpTypes
+   };
+
+   struct Op
+   {
+      OpType type;
+      S32 bitCount;
+      S32 value;
+      U8 bits[ 12 ];
+   };
+}
+
+//-----------------------------------------------------------------------------
+// Runs random sequences of writes and reads through BitStream and through
+// the old bit by bit code on buffers of random size, and checks that every
+// byte of the two buffers and every value read back is the same.
+//
+// The buffers start out with random contents so that bits outside the ones
+// written must survive, and streams are rewound to random places now and
+// then to overwrite data in the middle of the buffer.  Small buffers make
+// sure the byte loops at the end of the buffer are covered too.
+
+CreateUnitTest( TestBitStreamFuzz, "Core/BitStream/Fuzz" )
+{
+   enum
+   {
+      NumRounds = 2000,
+      MaxBufferSize = 96,
+      MaxOps = 64
+   };
+
+   void makeOp( MRandomLCG& random, Op& op, S32 bitsLeft, S32 curPos )
+   {
+      op.type = OpType( random.randI( 0, NumOpTypes - 1 ) );
+      switch( op.type )
+      {
+         case OpFlag:
+            op.bitCount = 1;
+            op.value = random.randI( 0, 1 );
+            break;
+
+         case OpInt:
+            op.bitCount = random.randI( 0, 32 );
+            op.value = S32( random.randI() ^ ( random.randI() << 16 ) );
+            break;
+
+         case OpBits:
+            op.bitCount = random.randI( 0, sizeof( op.bits ) * 8 );
+            for( U32 i = 0; i < sizeof( op.bits ); i ++ )
+               op.bits[ i ] = U8( random.randI() );
+            break;
+
+         default:
+            op.bitCount = 0;
+            op.value = curPos ? random.randI( 0, curPos - 1 ) : 0;
+            break;
+      }
+
+      if( op.bitCount > bitsLeft )
+      {
+         op.type = OpSeek;
+         op.bitCount = 0;
+         op.value = curPos ? random.randI( 0, curPos - 1 ) : 0;
+      }
+   }
+
+   void run()
+   {
+      MRandomLCG random( 3 );
+      U8 buffer[ MaxBufferSize ];
+      U8 refBuffer[ MaxBufferSize ];
+      Op ops[ MaxOps ];
+
+      for( U32 round = 0; round < NumRounds; round ++ )
+      {
+         S32 size = random.randI( 1, MaxBufferSize );
+         for( S32 i = 0; i < size; i ++ )
+            buffer[ i ] = refBuffer[ i ] = U8( random.randI() );
+
+         BitStream stream( buffer, size );
+         ReferenceBitStream ref( refBuffer, size );
+
+         // Write.
+
+         S32 numOps = random.randI( 1, MaxOps );
+         for( S32 i = 0; i < numOps; i ++ )
+         {
+            Op& op = ops[ i ];
+            makeOp( random, op, size * 8 - ref.getCurPos(), ref.getCurPos() );
+
+            switch( op.type )
+            {
+               case OpFlag:
+                  stream.writeFlag( op.value != 0 );
+                  ref.writeFlag( op.value != 0 );
+                  break;
+
+               case OpInt:
+                  stream.writeInt( op.value, op.bitCount );
+                  ref.writeInt( op.value, op.bitCount );
+                  break;
+
+               case OpBits:
+                  stream.writeBits( op.bitCount, op.bits );
+                  ref.writeBits( op.bitCount, op.bits );
+                  break;
+
+               default:
+                  stream.setCurPos( op.value );
+                  ref.setCurPos( op.value );
+                  break;
+            }
+
+            if( stream.getCurPos() != ref.getCurPos() )
+               break;
+         }
+
+         test( stream.isValid(), "Write failed" );
+         test( stream.getCurPos() == ref.getCurPos(), "Write position differs from the reference" );
+         test( dMemcmp( buffer, refBuffer, size ) == 0, "Written bytes differ from the reference" );
+
+         // Read back the same sequence from the start.
+
+         stream.setCurPos( 0 );
+         ref.setCurPos( 0 );
+
+         bool matched = true;
+         for( S32 i = 0; i < numOps && matched; i ++ )
+         {
+            const Op& op = ops[ i ];
+            switch( op.type )
+            {
+               case OpFlag:
+                  matched = stream.readFlag() == ref.readFlag();
+                  break;
+
+               case OpInt:
+                  matched = stream.readInt( op.bitCount ) == ref.readInt( op.bitCount );
+                  break;
+
+               case OpBits:
+               {
+                  // The last byte also carries the bits that follow, so
+                  // compare whole bytes.
+                  U8 bits[ sizeof( op.bits ) ];
+                  U8 refBits[ sizeof( op.bits ) ];
+                  dMemset( bits, 0xCD, sizeof( bits ) );
+                  dMemset( refBits, 0xCD, sizeof( refBits ) );
+                  stream.readBits( op.bitCount, bits );
+                  ref.readBits( op.bitCount, refBits );
+                  matched = dMemcmp( bits, refBits, sizeof( bits ) ) == 0;
+                  break;
+               }
+
+               default:
+                  stream.setCurPos( op.value );
+                  ref.setCurPos( op.value );
+                  break;
+            }
+
+            matched = matched && stream.getCurPos() == ref.getCurPos();
+         }
+
+         test( matched, "Read back values differ from the reference" );
+         test( stream.isValid(), "Read failed" );
+      }
+   }
+};
+
+//-----------------------------------------------------------------------------
+// InfiniteBitStream grows when a write runs out of room instead of before
+// every write.  Check that it still takes everything and keeps it intact.
+
+CreateUnitTest( TestBitStreamInfinite, "Core/BitStream/Infinite" )
+{
+   void run()
+   {
+      enum { NumValues = 4000 };
+
+      InfiniteBitStream stream;
+
+      for( U32 i = 0; i < NumValues; i ++ )
+      {
+         stream.writeFlag( i & 1 );
+         stream.writeInt( i, 13 );
+         U8 bytes[ 5 ] = { U8( i ), U8( i >> 8 ), 1, 2, 3 };
+         stream.writeBits( 37, bytes );
+      }
+
+      test( stream.isValid(), "Write failed" );
+
+      stream.setPosition( 0 );
+      bool matched = true;
+      for( U32 i = 0; i < NumValues && matched; i ++ )
+      {
+         matched = stream.readFlag() == ( ( i & 1 ) != 0 );
+         matched = matched && stream.readInt( 13 ) == S32( i & 0x1FFF );
+
+         U8 bytes[ 5 ];
+         stream.readBits( 37, bytes );
+         matched = matched && bytes[ 0 ] == U8( i ) && bytes[ 1 ] == U8( i >> 8 );
+         matched = matched && bytes[ 2 ] == 1 && bytes[ 3 ] == 2 && ( bytes[ 4 ] & 0x1F ) == 3;
+      }
+
+      test( matched, "Read back values differ from the ones written" );
+   }
+};
+
+//-----------------------------------------------------------------------------
+// Times packing updates shaped like Player::packUpdate (masks, state, a
+// compressed position, velocity, rotation, head and energy) into packet
+// sized streams.  The same updates are packed with the old bit by bit code
+// for comparison, and the two must come out byte for byte the same.
+
+namespace {
+
+   /// Random field values, made up front so the timing is all packing.
+   struct PlayerUpdateValues
+   {
+      enum { NumValues = 4096 };
+
+      U32 mValues[ NumValues ];
+      U32 mNext;
+
+      PlayerUpdateValues()
+         : mNext( 0 )
+      {
+         MRandomLCG random( 13 );
+         for( U32 i = 0; i < NumValues; i ++ )
+            mValues[ i ] = random.randI();
+      }
+
+      U32 next( U32 bitCount ) { return mValues[ ( mNext ++ ) & ( NumValues - 1 ) ] & ( ( 1 << bitCount ) - 1 ); }
+   };
+
+   template< class T >
+   void packPlayerUpdate( T& stream, PlayerUpdateValues& values )
+   {
+      // Impact and action animation flags.
+      if( stream.writeFlag( values.next( 2 ) == 0 ) )
+         stream.writeInt( values.next( 2 ), 2 );
+      if( stream.writeFlag( values.next( 1 ) != 0 ) )
+      {
+         stream.writeInt( values.next( 8 ), 8 );
+         stream.writeFlag( false );
+         stream.writeFlag( true );
+         stream.writeFlag( false );
+      }
+      stream.writeFlag( false );
+
+      // Not the control object.
+      stream.writeFlag( false );
+
+      // Move mask.
+      if( stream.writeFlag( true ) )
+      {
+         stream.writeFlag( values.next( 1 ) != 0 );
+         stream.writeInt( values.next( 3 ), 3 );
+         stream.writeFlag( false );
+
+         // writeCompressedPoint with a mid range offset.
+         stream.writeInt( 1, 2 );
+         for( U32 i = 0; i < 3; i ++ )
+            stream.writeInt( values.next( 16 ), 16 );
+
+         // Velocity as a normal vector and a length.
+         if( stream.writeFlag( true ) )
+         {
+            stream.writeInt( values.next( 11 ), 11 );
+            stream.writeInt( values.next( 10 ), 10 );
+            stream.writeInt( values.next( 13 ), 13 );
+         }
+
+         // Rotation, head and move.
+         stream.writeInt( values.next( 7 ), 7 );
+         stream.writeInt( values.next( 6 ), 6 );
+         stream.writeInt( values.next( 6 ), 6 );
+         for( U32 i = 0; i < 3; i ++ )
+            if( stream.writeFlag( values.next( 1 ) != 0 ) )
+               stream.writeInt( values.next( 6 ), 6 );
+         stream.writeFlag( true );
+      }
+
+      // Energy.
+      stream.writeInt( values.next( 5 ), 5 );
+   }
+}
+
+CreateUnitTest( TestBitStreamPackUpdatePerformance, "Core/BitStream/PackUpdatePerformance" )
+{
+   enum
+   {
+      PacketSize = 1500,
+      NumPackets = 4000
+   };
+
+   template< class T >
+   U32 packPackets( U8* buffer, U32& numUpdates )
+   {
+      // Leave room for the largest update at the end of the packet.
+      const S32 maxPos = ( PacketSize - 32 ) * 8;
+
+      PlayerUpdateValues values;
+      numUpdates = 0;
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 packet = 0; packet < NumPackets; packet ++ )
+      {
+         T stream( buffer, PacketSize );
+         while( stream.getCurPos() < maxPos )
+         {
+            packPlayerUpdate( stream, values );
+            numUpdates ++;
+         }
+      }
+      return getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+   }
+
+   void run()
+   {
+      U8 buffer[ PacketSize ];
+      U8 refBuffer[ PacketSize ];
+      dMemset( buffer, 0, sizeof( buffer ) );
+      dMemset( refBuffer, 0, sizeof( refBuffer ) );
+
+      U32 numUpdates;
+      U32 refNumUpdates;
+      U32 refTime = packPackets< ReferenceBitStream >( refBuffer, refNumUpdates );
+      U32 time = packPackets< BitStream >( buffer, numUpdates );
+
+      test( numUpdates == refNumUpdates && dMemcmp( buffer, refBuffer, PacketSize ) == 0,
+         "Packed updates differ from the reference" );
+
+      UnitPrint( avar( "Bit by bit: %.1f ns/update", F64( refTime ) * 1000000.0 / F64( refNumUpdates ) ) );
+      UnitPrint( avar( "Word based: %.1f ns/update", F64( time ) * 1000000.0 / F64( numUpdates ) ) );
+   }
+};
@@ -0,0 +1,72 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "platform/platform.h"
+#include "console/console.h"
+#include "core/strings/stringFunctions.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Checks that call sites notice when what they call changes underneath them.
+//
+// Each helper below calls through one and the same call site, so the second
+// call hits the cached lookup unless the change flushed it.
+
+CreateUnitTest( TestCallSiteCache, "Console/CallSiteCache" )
+{
+   void run()
+   {
+      Con::evaluate(
+         "function _utCallSiteFn() { return \"base\"; }"
+         "function _utCallSiteCallFn() { return _utCallSiteFn(); }"
+         "function _utCallSiteA::get( %this ) { return \"A\"; }"
+         "function _utCallSiteB::get( %this ) { return \"B\"; }"
+         "function _utCallSiteCallGet( %obj ) { return %obj.get(); }"
+         "package _utCallSitePackage {"
+         "   function _utCallSiteFn() { return \"package\"; }"
+         "};" );
+
+      // Package activation and deactivation.
+      test( !dStrcmp( Con::executef( "_utCallSiteCallFn" ), "base" ), "Wrong function before activating package" );
+      Con::evaluate( "activatePackage( _utCallSitePackage );" );
+      test( !dStrcmp( Con::executef( "_utCallSiteCallFn" ), "package" ), "Call site missed package activation" );
+      Con::evaluate( "deactivatePackage( _utCallSitePackage );" );
+      test( !dStrcmp( Con::executef( "_utCallSiteCallFn" ), "base" ), "Call site missed package deactivation" );
+
+      // Redefinition.
+      Con::evaluate( "function _utCallSiteFn() { return \"redefined\"; }" );
+      test( !dStrcmp( Con::executef( "_utCallSiteCallFn" ), "redefined" ), "Call site missed function redefinition" );
+
+      // Method calls on objects of different namespaces from one site.
+      Con::evaluate(
+         "new ScriptObject( _utCallSiteObjA ) { class = \"_utCallSiteA\"; };"
+         "new ScriptObject( _utCallSiteObjB ) { class = \"_utCallSiteB\"; };" );
+      test( !dStrcmp( Con::executef( "_utCallSiteCallGet", "_utCallSiteObjA" ), "A" ), "Wrong method for first object" );
+      test( !dStrcmp( Con::executef( "_utCallSiteCallGet", "_utCallSiteObjB" ), "B" ), "Call site reused method of another namespace" );
+      test( !dStrcmp( Con::executef( "_utCallSiteCallGet", "_utCallSiteObjA" ), "A" ), "Call site did not switch back" );
+
+      Con::evaluate( "_utCallSiteObjA.delete(); _utCallSiteObjB.delete();" );
+   }
+};
@@ -0,0 +1,208 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/util/tVector.h"
+#include "scene/culling/sceneCullingBoxBatch.h"
+#include "math/mPlaneSet.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Tests batches of boxes against sets of planes and checks that every box
+// gets the same answer as PlaneF::whichSide() and PlaneSet give it on its
+// own.  Some boxes are flat or placed right on a plane to hit the edge cases
+// of the side tests.  The time the one-at-a-time tests and the batched tests
+// take is printed.
+
+CreateUnitTest( TestCullingBoxBatch, "Scene/CullingBoxBatch" )
+{
+   enum
+   {
+      NumBoxes = 20000,
+      NumPlaneSets = 16,
+      NumPlanes = 6,
+      NumTimingRounds = 20,
+   };
+
+   Vector< Box3F > mBoxes;
+   Vector< PlaneF > mPlanes;
+
+   Point3F randomPoint( MRandomLCG& random, F32 range )
+   {
+      return Point3F( random.randF( -range, range ), random.randF( -range, range ), random.randF( -range, range ) );
+   }
+
+   void populate()
+   {
+      MRandomLCG random( 11 );
+
+      for( U32 i = 0; i < NumPlaneSets * NumPlanes; ++ i )
+      {
+         Point3F normal = randomPoint( random, 1.f );
+         if( i % 7 == 0 )
+            normal.set( 0.f, 0.f, 1.f );
+         normal.normalizeSafe();
+         mPlanes.push_back( PlaneF( randomPoint( random, 50.f ), normal ) );
+      }
+
+      for( U32 i = 0; i < NumBoxes; ++ i )
+      {
+         Point3F center = randomPoint( random, 200.f );
+         Point3F halfSize( random.randF( 0.f, 20.f ), random.randF( 0.f, 20.f ), random.randF( 0.f, 20.f ) );
+
+         switch( i % 4 )
+         {
+            case 0:
+               // Flat box.
+               halfSize.z = 0.f;
+               break;
+
+            case 1:
+            {
+               // Box touching a plane within the side tests' tolerance.
+               const PlaneF& plane = mPlanes[ random.randI( 0, mPlanes.size() - 1 ) ];
+               halfSize.set( 0.f, 0.f, 0.f );
+               center = plane.project( center ) + plane * random.randF( -0.01f, 0.01f );
+               break;
+            }
+         }
+
+         mBoxes.push_back( Box3F( center - halfSize, center + halfSize ) );
+      }
+   }
+
+   void fill( SceneCullingBoxBatch& batch, U32 first, U32& lanes )
+   {
+      batch.clear();
+      lanes = 0;
+      for( U32 i = 0; i < SceneCullingBoxBatch::Size && first + i < mBoxes.size(); ++ i )
+      {
+         batch.set( i, mBoxes[ first + i ] );
+         lanes |= U32( 1 ) << i;
+      }
+   }
+
+   void testResults()
+   {
+      bool sameSides = true;
+      bool sameOutside = true;
+      bool sameContained = true;
+
+      for( U32 first = 0; first < mBoxes.size(); first += SceneCullingBoxBatch::Size )
+      {
+         SceneCullingBoxBatch batch;
+         U32 lanes;
+         fill( batch, first, lanes );
+
+         for( U32 n = 0; n < NumPlaneSets; ++ n )
+         {
+            const PlaneF* planes = &mPlanes[ n * NumPlanes ];
+            PlaneSetF planeSet( planes, NumPlanes );
+
+            const U32 outside = batch.testOutside( planes, NumPlanes, lanes );
+            const U32 contained = batch.testContained( planes, NumPlanes, lanes );
+
+            for( U32 i = 0; i < SceneCullingBoxBatch::Size; ++ i )
+            {
+               const U32 bit = U32( 1 ) << i;
+               if( !( lanes & bit ) )
+               {
+                  sameOutside &= !( outside & bit );
+                  sameContained &= !( contained & bit );
+                  continue;
+               }
+
+               const Box3F& box = mBoxes[ first + i ];
+
+               const bool isOutside = ( planeSet.testPotentialIntersection( box ) == GeometryOutside );
+               sameOutside &= ( isOutside == ( ( outside & bit ) != 0 ) );
+               sameContained &= ( planeSet.isContained( box ) == ( ( contained & bit ) != 0 ) );
+
+               for( U32 p = 0; p < NumPlanes; ++ p )
+               {
+                  const PlaneF::Side side = planes[ p ].whichSide( box );
+                  sameSides &= ( ( side == PlaneF::Back ) == ( ( batch.testBack( planes[ p ], lanes ) & bit ) != 0 ) );
+                  sameSides &= ( ( side == PlaneF::Front ) == ( ( batch.testFront( planes[ p ], lanes ) & bit ) != 0 ) );
+               }
+            }
+         }
+      }
+
+      test( sameSides, "Batched plane sides differ from PlaneF::whichSide" );
+      test( sameOutside, "Batched outside tests differ from PlaneSet::testPotentialIntersection" );
+      test( sameContained, "Batched containment tests differ from PlaneSet::isContained" );
+   }
+
+   void testTiming()
+   {
+      U32 numOutside = 0;
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 round = 0; round < NumTimingRounds; ++ round )
+         for( U32 n = 0; n < NumPlaneSets; ++ n )
+         {
+            PlaneSetF planeSet( &mPlanes[ n * NumPlanes ], NumPlanes );
+            for( U32 i = 0; i < mBoxes.size(); ++ i )
+               if( planeSet.testPotentialIntersection( mBoxes[ i ] ) == GeometryOutside )
+                  numOutside ++;
+         }
+      U32 singleTime = Platform::getRealMilliseconds() - start;
+
+      Vector< SceneCullingBoxBatch > batches;
+      Vector< U32 > batchLanes;
+      for( U32 first = 0; first < mBoxes.size(); first += SceneCullingBoxBatch::Size )
+      {
+         batches.increment();
+         batchLanes.increment();
+         fill( batches.last(), first, batchLanes.last() );
+      }
+
+      U32 numBatchedOutside = 0;
+      start = Platform::getRealMilliseconds();
+      for( U32 round = 0; round < NumTimingRounds; ++ round )
+         for( U32 n = 0; n < NumPlaneSets; ++ n )
+         {
+            const PlaneF* planes = &mPlanes[ n * NumPlanes ];
+            for( U32 i = 0; i < batches.size(); ++ i )
+            {
+               U32 outside = batches[ i ].testOutside( planes, NumPlanes, batchLanes[ i ] );
+               for( ; outside; outside &= outside - 1 )
+                  numBatchedOutside ++;
+            }
+         }
+      U32 batchedTime = Platform::getRealMilliseconds() - start;
+
+      test( numOutside == numBatchedOutside, "Batched tests culled a different number of boxes" );
+
+      UnitPrint( avar( "%d box tests: one at a time %d ms, batched %d ms",
+         U32( NumTimingRounds * NumPlaneSets ) * mBoxes.size(), singleTime, batchedTime ) );
+   }
+
+   void run()
+   {
+      populate();
+      testResults();
+      testTiming();
+   }
+};
@@ -0,0 +1,194 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/frameAllocator.h"
+#include "platform/threads/threadPool.h"
+#include "platform/threads/thread.h"
+#include "core/util/tVector.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Checks that ThreadPool work items can use FrameTemp on their own thread's
+// arena without disturbing the main thread's.
+
+CreateUnitTest( TestFrameAllocatorThreads, "Core/FrameAllocator/Threads" )
+{
+   enum
+   {
+      NumItems = 256,
+      NumValues = 4096
+   };
+
+   static Vector< U32 > results;
+
+   struct TestItem : public ThreadPool::WorkItem
+   {
+      U32 mIndex;
+
+      TestItem( U32 index )
+         : mIndex( index ) {}
+
+   protected:
+      virtual void execute()
+      {
+         if( !FrameAllocator::hasThreadArena() )
+            return;
+
+         U32 waterMark = FrameAllocator::getWaterMark();
+         U32 sum = 0;
+         {
+            FrameTemp< U32 > values( NumValues );
+            for( U32 i = 0; i < NumValues; i ++ )
+               values[ i ] = mIndex + i;
+
+            // Give other workers a chance to scribble over us if the
+            // arenas were shared.
+            Platform::sleep( 0 );
+
+            for( U32 i = 0; i < NumValues; i ++ )
+               sum += values[ i ] - i;
+         }
+
+         if( FrameAllocator::getWaterMark() == waterMark )
+            results[ mIndex ] = sum / NumValues;
+      }
+   };
+
+   void run()
+   {
+      FrameAllocatorMarker marker;
+      U32* mainValues = marker.alloc< U32 >( NumValues );
+      for( U32 i = 0; i < NumValues; i ++ )
+         mainValues[ i ] = i;
+      U32 mainWaterMark = FrameAllocator::getWaterMark();
+
+      results.setSize( NumItems );
+      for( U32 i = 0; i < NumItems; i ++ )
+         results[ i ] = U32( -1 );
+
+      ThreadPool* pool = &ThreadPool::GLOBAL();
+      for( U32 i = 0; i < NumItems; i ++ )
+      {
+         ThreadSafeRef< TestItem > item( new TestItem( i ) );
+         pool->queueWorkItem( item );
+      }
+      pool->flushWorkItems();
+
+      bool allOk = true;
+      for( U32 i = 0; i < NumItems; i ++ )
+         allOk &= results[ i ] == i;
+      test( allOk, "Work item frame allocations were corrupted or not released" );
+
+      bool mainOk = FrameAllocator::getWaterMark() == mainWaterMark;
+      for( U32 i = 0; i < NumValues; i ++ )
+         mainOk &= mainValues[ i ] == i;
+      test( mainOk, "Work items disturbed the main thread's frame arena" );
+      test( FrameAllocator::getMaxWaterMark() >= mainWaterMark, "Main thread's peak usage not tracked" );
+
+      FrameAllocator::dumpArenaUsage();
+      results.clear();
+   }
+};
+
+Vector< U32 > TestFrameAllocatorThreads::results( __FILE__, __LINE__ );
+
+//-----------------------------------------------------------------------------
+// Checks that threads which never set up an arena get one on first use and
+// that FrameTemps too large for the arena fall back to the heap.
+
+CreateUnitTest( TestFrameAllocatorFallback, "Core/FrameAllocator/Fallback" )
+{
+   enum
+   {
+      NumValues = 4096,
+      LargeSize = TORQUE_THREAD_FRAME_SIZE * 4
+   };
+
+   static bool checkTemps()
+   {
+      const U32 waterMark = FrameAllocator::getWaterMark();
+      bool ok = true;
+      {
+         FrameTemp< U32 > values( NumValues );
+         for( U32 i = 0; i < NumValues; i ++ )
+            values[ i ] = i;
+
+         // Larger than the whole arena; must not disturb the values above.
+         FrameTemp< U8 > large( LargeSize );
+         dMemset( ~large, 0xFF, LargeSize );
+         ok &= FrameAllocator::getWaterMark() > waterMark;
+
+         for( U32 i = 0; i < NumValues; i ++ )
+            ok &= values[ i ] == i;
+      }
+      return ok && FrameAllocator::getWaterMark() == waterMark;
+   }
+
+   struct TestThread : public Thread
+   {
+      bool mHadArena;
+      bool mOk;
+
+      TestThread()
+         : mHadArena( true ), mOk( false ) {}
+
+      virtual void run( void* )
+      {
+         mHadArena = FrameAllocator::hasThreadArena();
+         mOk = checkTemps();
+      }
+   };
+
+   struct TestItem : public ThreadPool::WorkItem
+   {
+      bool& mOk;
+
+      TestItem( bool& ok )
+         : mOk( ok ) {}
+
+   protected:
+      virtual void execute()
+      {
+         mOk = checkTemps();
+      }
+   };
+
+   void run()
+   {
+      TestThread thread;
+      thread.start();
+      thread.join();
+      test( !thread.mHadArena, "Plain thread started out with a frame arena" );
+      test( thread.mOk, "FrameTemp failed on a thread without its own arena" );
+
+      bool itemOk = false;
+      ThreadSafeRef< TestItem > item( new TestItem( itemOk ) );
+      ThreadPool::GLOBAL().queueWorkItem( item );
+      ThreadPool::GLOBAL().flushWorkItems();
+      test( itemOk, "FrameTemp larger than a worker arena failed" );
+
+      test( checkTemps(), "FrameTemp failed on the main thread" );
+   }
+};
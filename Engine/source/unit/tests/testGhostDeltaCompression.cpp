@@ -0,0 +1,300 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "sim/netConnection.h"
+#include "sim/netObject.h"
+#include "core/stream/bitStream.h"
+#include "math/mathIO.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Plays the same scripted session with ghost delta compression off and on and
+// compares the bandwidth used.
+//
+// A server connection ghosts a set of moving objects to a client connection
+// through a local connection pair.  About one packet in ten is dropped, and
+// objects drop out of scope and come back now and then so ghosts get killed
+// and ghosted again.  At the end, every client object must match its server
+// object and the connections must not have reported any errors.
+
+class GhostDeltaTestObject : public NetObject
+{
+   public:
+
+      typedef NetObject Parent;
+
+      enum
+      {
+         MoveMask = BIT( 0 ),
+         StateMask = BIT( 1 ),
+      };
+
+      Point3F mPos;
+      Point3F mVel;
+      F32 mYaw;
+      U32 mHealth;
+
+      /// Whether the object is in scope.
+      bool mVisible;
+
+      /// Objects the camera scopes.
+      static Vector< GhostDeltaTestObject* > smScoped;
+
+      GhostDeltaTestObject()
+         : mPos( 0.f, 0.f, 0.f ),
+           mVel( 0.f, 0.f, 0.f ),
+           mYaw( 0.f ),
+           mHealth( 100 ),
+           mVisible( true )
+      {
+         mNetFlags.set( Ghostable );
+      }
+
+      U32 packUpdate( NetConnection* connection, U32 mask, BitStream* stream )
+      {
+         if( stream->writeFlag( mask & MoveMask ) )
+         {
+            mathWrite( *stream, mPos );
+            mathWrite( *stream, mVel );
+            stream->write( mYaw );
+         }
+         if( stream->writeFlag( mask & StateMask ) )
+            stream->writeInt( mHealth, 8 );
+         return 0;
+      }
+
+      void unpackUpdate( NetConnection* connection, BitStream* stream )
+      {
+         if( stream->readFlag() )
+         {
+            mathRead( *stream, &mPos );
+            mathRead( *stream, &mVel );
+            stream->read( &mYaw );
+         }
+         if( stream->readFlag() )
+            mHealth = stream->readInt( 8 );
+      }
+
+      void onCameraScopeQuery( NetConnection* connection, CameraScopeQuery* query )
+      {
+         for( U32 i = 0; i < smScoped.size(); ++ i )
+            if( smScoped[ i ]->mVisible )
+               connection->objectInScope( smScoped[ i ] );
+      }
+
+      DECLARE_CONOBJECT( GhostDeltaTestObject );
+};
+
+IMPLEMENT_CO_NETOBJECT_V1( GhostDeltaTestObject );
+
+ConsoleDocClass( GhostDeltaTestObject,
+   "@brief Object used by the ghost delta compression unit test.\n\n"
+   "@internal" );
+
+Vector< GhostDeltaTestObject* > GhostDeltaTestObject::smScoped;
+
+namespace {
+
+   class GhostDeltaTestConnection : public NetConnection
+   {
+      public:
+
+         typedef NetConnection Parent;
+
+         U32 mBytesSent;
+         F32 mPacketLoss;
+         MRandomLCG mRandom;
+         String mError;
+
+         GhostDeltaTestConnection( U32 seed )
+            : mBytesSent( 0 ),
+              mPacketLoss( 0.f ),
+              mRandom( seed )
+         {
+         }
+
+         /// Count the bytes sent and drop some of the packets.
+         Net::Error sendPacket( BitStream* stream )
+         {
+            mBytesSent += stream->getPosition();
+            if( mRandom.randF() < mPacketLoss )
+               return Net::NoError;
+            return Parent::sendPacket( stream );
+         }
+
+         void handleConnectionMessage( U32 message, U32 sequence, U32 ghostCount ) {}
+
+         void connectionError( const char* errorString )
+         {
+            if( mError.isEmpty() )
+               mError = errorString;
+         }
+
+         void startGhostingTo( GhostDeltaTestConnection* client, NetObject* camera, bool deltas )
+         {
+            setSequence( 0 );
+            client->setSequence( 0 );
+            setRemoteConnectionObject( client );
+            client->setRemoteConnectionObject( this );
+            checkMaxRate();
+            client->checkMaxRate();
+
+            setGhostDeltaCompression( deltas );
+            client->setGhostDeltaCompression( deltas );
+            client->setGhostTo( true );
+
+            setGhostFrom( true );
+            setScopeObject( camera );
+            activateGhosting();
+            mGhosting = true;
+         }
+   };
+}
+
+CreateUnitTest( TestGhostDeltaCompression, "Sim/GhostDeltaCompression" )
+{
+   enum
+   {
+      NumObjects = 24,
+      NumTicks = 640,
+      NumSettleTicks = 64,
+      PacketsPerSecond = 32,
+   };
+
+   Vector< GhostDeltaTestObject* > mObjects;
+
+   void step( MRandomLCG& random, bool moving )
+   {
+      for( U32 i = 0; i < mObjects.size(); ++ i )
+      {
+         GhostDeltaTestObject* object = mObjects[ i ];
+         if( moving )
+         {
+            object->mPos += object->mVel * ( 1.f / PacketsPerSecond );
+            object->setMaskBits( GhostDeltaTestObject::MoveMask );
+
+            if( random.randI( 0, 15 ) == 0 )
+            {
+               object->mVel.set( random.randF( -5.f, 5.f ), random.randF( -5.f, 5.f ), 0.f );
+               object->mYaw = random.randF( 0.f, M_2PI_F );
+            }
+            if( random.randI( 0, 63 ) == 0 )
+            {
+               object->mHealth = random.randI( 0, 100 );
+               object->setMaskBits( GhostDeltaTestObject::StateMask );
+            }
+            if( random.randI( 0, 127 ) == 0 )
+               object->mVisible = !object->mVisible;
+         }
+         else
+            object->mVisible = true;
+      }
+   }
+
+   /// Play the session and return the bytes sent by the server.
+   U32 runSession( bool deltas )
+   {
+      MRandomLCG random( 11 );
+      for( U32 i = 0; i < NumObjects; ++ i )
+      {
+         GhostDeltaTestObject* object = new GhostDeltaTestObject;
+         object->mPos.set( random.randF( 0.f, 100.f ), random.randF( 0.f, 100.f ), 0.f );
+         object->mVel.set( random.randF( -5.f, 5.f ), random.randF( -5.f, 5.f ), 0.f );
+         object->registerObject();
+         mObjects.push_back( object );
+      }
+      GhostDeltaTestObject::smScoped = mObjects;
+
+      GhostDeltaTestObject* camera = new GhostDeltaTestObject;
+      camera->registerObject();
+
+      GhostDeltaTestConnection* server = new GhostDeltaTestConnection( 3 );
+      GhostDeltaTestConnection* client = new GhostDeltaTestConnection( 5 );
+      server->registerObject();
+      client->registerObject();
+      server->startGhostingTo( client, camera, deltas );
+
+      server->mPacketLoss = 0.1f;
+      client->mPacketLoss = 0.1f;
+
+      for( U32 tick = 0; tick < NumTicks; ++ tick )
+      {
+         step( random, true );
+         NetObject::collapseDirtyList();
+         server->checkPacketSend( true );
+         client->checkPacketSend( true );
+      }
+      U32 bytes = server->mBytesSent;
+
+      // Let everything get through.
+      server->mPacketLoss = 0.f;
+      client->mPacketLoss = 0.f;
+      for( U32 tick = 0; tick < NumSettleTicks; ++ tick )
+      {
+         step( random, false );
+         NetObject::collapseDirtyList();
+         server->checkPacketSend( true );
+         client->checkPacketSend( true );
+      }
+
+      bool match = true;
+      for( U32 i = 0; i < mObjects.size(); ++ i )
+      {
+         GhostDeltaTestObject* object = mObjects[ i ];
+         GhostDeltaTestObject* ghost = dynamic_cast< GhostDeltaTestObject* >( object->getClientObject() );
+         if( !ghost || ghost->mPos != object->mPos || ghost->mVel != object->mVel ||
+             ghost->mYaw != object->mYaw || ghost->mHealth != object->mHealth )
+            match = false;
+      }
+
+      test( match, avar( "Client objects don't match the server (deltas %s)", deltas ? "on" : "off" ) );
+      test( server->mError.isEmpty() && client->mError.isEmpty(),
+         avar( "Connection error (deltas %s): %s%s", deltas ? "on" : "off", server->mError.c_str(), client->mError.c_str() ) );
+
+      client->deleteObject();
+      server->deleteObject();
+      camera->deleteObject();
+      for( U32 i = 0; i < mObjects.size(); ++ i )
+         mObjects[ i ]->deleteObject();
+      mObjects.clear();
+      GhostDeltaTestObject::smScoped.clear();
+
+      return bytes;
+   }
+
+   void run()
+   {
+      U32 fullBytes = runSession( false );
+      U32 deltaBytes = runSession( true );
+
+      F32 seconds = F32( NumTicks ) / PacketsPerSecond;
+      UnitPrint( avar( "%i objects, %i packets/sec, 10%% packet loss", NumObjects, PacketsPerSecond ) );
+      UnitPrint( avar( "Full updates:  %.0f bytes/sec", fullBytes / seconds ) );
+      UnitPrint( avar( "Delta updates: %.0f bytes/sec", deltaBytes / seconds ) );
+
+      test( deltaBytes < fullBytes, "Delta compressed updates used more bandwidth" );
+   }
+};
@@ -0,0 +1,280 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "T3D/gameBase/gameConnection.h"
+#include "T3D/gameBase/moveList.h"
+#include "T3D/gameBase/processList.h"
+#include "scene/sceneContainer.h"
+#include "core/stream/bitStream.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+#include "unit/tests/sceneTestFixture.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Replays a client shooting at a strafing target over a link with latency,
+// and checks that rewound queries hit what the client aimed at.
+//
+// The target follows a recorded list of strafe moves on the server.  Each
+// tick the client aims at the target where it last heard it was and sends
+// that as a move through the move lists of a pair of GameConnections.  The
+// server tests each shot against the target as of the tick the client had
+// heard about, the way Projectile does with lag compensation on, and also
+// against where it is now.
+//
+// Then the cost of recording the history of a big batch of objects every
+// tick is printed.
+
+namespace {
+
+   /// Packet on its way between the two move lists.
+   struct LagCompensationTestPacket
+   {
+      U32 mArrival;
+
+      /// Server tick the sender had heard about; stands in for the tick
+      /// GameConnection takes from the packet acks.
+      U32 mTick;
+
+      U32 mSize;
+      U8 mData[ 512 ];
+   };
+}
+
+CreateUnitTest( TestLagCompensation, "Scene/LagCompensation" )
+{
+   enum
+   {
+      Latency = 5,         ///< Ticks each way.
+      NumTicks = 300,
+      NumBenchObjects = 256,
+      NumBenchTicks = 2000,
+   };
+
+   typedef LagCompensationTestPacket Packet;
+
+   Vector< Packet* > mToServer;
+   Vector< Packet* > mToClient;
+
+   void send( Vector< Packet* >& queue, BitStream& stream, U32 arrival, U32 tick )
+   {
+      Packet* packet = new Packet;
+      packet->mArrival = arrival;
+      packet->mTick = tick;
+      packet->mSize = stream.getPosition();
+      dMemcpy( packet->mData, stream.getBuffer(), packet->mSize );
+      queue.push_back( packet );
+   }
+
+   Packet* receive( Vector< Packet* >& queue, U32 time )
+   {
+      if( queue.empty() || queue.first()->mArrival > time )
+         return NULL;
+
+      Packet* packet = queue.first();
+      queue.pop_front();
+      return packet;
+   }
+
+   void testReplay()
+   {
+      SceneContainer container;
+
+      // Player sized box that takes part in the container's history.
+      SceneTestBox* target = new SceneTestBox( Point3F( 0.5f, 0.5f, 1.f ), PlayerObjectType );
+      target->setKeepHistory( true );
+      MatrixF xform( true );
+      xform.setPosition( Point3F( 0.f, 10.f, 0.f ) );
+      target->setTransform( xform );
+      container.addObject( target );
+
+      // Record the target's moves: strafe one way or the other at a
+      // run for a while, then switch.
+      Vector< Move > targetMoves;
+      MRandomLCG random( 11 );
+      F32 strafe = 1.f;
+      for( U32 i = 0; i < NumTicks; ++ i )
+      {
+         if( random.randI( 0, 15 ) == 0 )
+            strafe = -strafe;
+         Move move = NullMove;
+         move.x = strafe;
+         targetMoves.push_back( move );
+      }
+
+      GameConnection* server = new GameConnection;
+      GameConnection* client = new GameConnection;
+      server->registerObject();
+      client->registerObject();
+      client->setIsConnectionToServer();
+
+      Vector< Point3F > positions;
+      positions.push_back( xform.getPosition() );
+
+      const Point3F shooter( 0.f, 0.f, 0.f );
+      const F32 speed = 8.f;
+      U32 heardTick = 0;
+      U32 shots = 0;
+      U32 rewoundHits = 0;
+      U32 presentHits = 0;
+
+      for( U32 time = 0; time < NumTicks; ++ time )
+      {
+         // Server tick: read the moves that have arrived and process them.
+         server->mMoveList->advanceMove();
+         while( Packet* packet = receive( mToServer, time ) )
+         {
+            BitStream stream( packet->mData, packet->mSize );
+            server->mMoveList->serverReadMovePacket( &stream );
+            server->mMoveList->setClientViewTick( packet->mTick );
+            delete packet;
+         }
+
+         Move* moves;
+         U32 numMoves;
+         server->mMoveList->getMoves( &moves, &numMoves );
+         for( U32 i = 0; i < numMoves; ++ i )
+         {
+            if( !moves[ i ].trigger[ 0 ] )
+               continue;
+
+            Point3F end = shooter + Point3F( mSin( moves[ i ].yaw ), mCos( moves[ i ].yaw ), 0.f ) * 100.f;
+            RayInfo info;
+
+            shots ++;
+            if( container.castRayRewound( server->getClientViewTick(), shooter, end, PlayerObjectType, &info ) )
+               rewoundHits ++;
+            if( container.castRay( shooter, end, PlayerObjectType, &info ) )
+               presentHits ++;
+         }
+         server->mMoveList->clearMoves( numMoves );
+
+         xform.setPosition( positions.last() + Point3F( targetMoves[ time ].x * speed * TickSec, 0.f, 0.f ) );
+         target->setTransform( xform );
+         container.updateObject( target );
+         positions.push_back( xform.getPosition() );
+         container.recordHistory( time + 1 );
+
+         {
+            U8 buffer[ 512 ];
+            BitStream stream( buffer, sizeof( buffer ) );
+            server->mMoveList->serverWriteMovePacket( &stream );
+            send( mToClient, stream, time + Latency, time + 1 );
+         }
+
+         // Client tick: take in what the server said, then aim at where it
+         // says the target is.
+         while( Packet* packet = receive( mToClient, time ) )
+         {
+            BitStream stream( packet->mData, packet->mSize );
+            client->mMoveList->clientReadMovePacket( &stream );
+            heardTick = packet->mTick;
+            delete packet;
+         }
+
+         if( heardTick )
+         {
+            Point3F aim = positions[ heardTick ] - shooter;
+            Move move = NullMove;
+            move.yaw = mAtan2( aim.x, aim.y );
+            move.trigger[ 0 ] = true;
+            move.clamp();
+            client->mMoveList->pushMove( move );
+         }
+
+         {
+            U8 buffer[ 512 ];
+            BitStream stream( buffer, sizeof( buffer ) );
+            client->mMoveList->clientWriteMovePacket( &stream );
+            send( mToServer, stream, time + Latency, heardTick );
+         }
+      }
+
+      UnitPrint( avar( "%d shots with %d ms round trip: %d hits rewound, %d hits against the present",
+         shots, U32( Latency * 2 * TickMs ), rewoundHits, presentHits ) );
+
+      test( shots > NumTicks / 2, "The server didn't get the client's moves" );
+      test( rewoundHits == shots, "Rewound shots missed what the client aimed at" );
+      test( presentHits < shots / 2, "The target didn't move enough to need rewinding" );
+
+      // Rewinding past the history gets the oldest tick kept.
+      MatrixF worldToObj;
+      Box3F worldBox;
+      test( container.getHistoryState( target, 0, &worldToObj, &worldBox ), "Target has no history" );
+      test( container.getOldestHistoryTick() == NumTicks - SceneContainer::HistoryLength + 1, "Wrong oldest tick" );
+      test( worldBox.getCenter().equal( positions[ container.getOldestHistoryTick() ] ), "Wrong state before the history" );
+
+      for( U32 i = 0; i < mToServer.size(); ++ i )
+         delete mToServer[ i ];
+      for( U32 i = 0; i < mToClient.size(); ++ i )
+         delete mToClient[ i ];
+      mToServer.clear();
+      mToClient.clear();
+
+      client->deleteObject();
+      server->deleteObject();
+
+      container.removeObject( target );
+      test( !container.getHistoryState( target, 0, &worldToObj, &worldBox ), "History kept after removal" );
+      delete target;
+   }
+
+   void testRecordCost()
+   {
+      SceneContainer container;
+      Vector< SceneTestBox* > targets;
+
+      MRandomLCG random( 5 );
+      for( U32 i = 0; i < NumBenchObjects; ++ i )
+      {
+         SceneTestBox* target = new SceneTestBox( Point3F( 0.5f, 0.5f, 1.f ), PlayerObjectType );
+         target->setKeepHistory( true );
+         MatrixF xform( true );
+         xform.setPosition( Point3F( random.randF( -512.f, 512.f ), random.randF( -512.f, 512.f ), 0.f ) );
+         target->setTransform( xform );
+         container.addObject( target );
+         targets.push_back( target );
+      }
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 1; i <= NumBenchTicks; ++ i )
+         container.recordHistory( i );
+      U32 elapsed = getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+
+      UnitPrint( avar( "Recording %d objects: %.2f us per tick", U32( NumBenchObjects ),
+         F32( elapsed ) * 1000.f / F32( NumBenchTicks ) ) );
+
+      for( U32 i = 0; i < targets.size(); ++ i )
+      {
+         container.removeObject( targets[ i ] );
+         delete targets[ i ];
+      }
+   }
+
+   void run()
+   {
+      testReplay();
+      testRecordCost();
+   }
+};
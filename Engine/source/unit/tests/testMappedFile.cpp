@@ -0,0 +1,85 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/mappedFile.h"
+#include "core/crc.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Writes a file through a MappedFile, as a file download does, and reads it
+// back through another one.
+
+CreateUnitTest( TestMappedFile, "Core/MappedFile" )
+{
+   enum
+   {
+      FileSize = 300 * 1024 + 17,
+   };
+
+   void run()
+   {
+      Torque::Path path( String::ToString( "%s/mappedFileTest.tmp", Platform::getTemporaryDirectory() ) );
+
+      // Leave something bigger there first, which create() must get rid of.
+      StrongRefPtr< MappedFile > file = MappedFile::create( path, FileSize * 2 );
+      test( file.isValid(), "Couldn't create the file" );
+      if( file.isNull() )
+         return;
+      dMemset( file->getData(), 0xFF, FileSize * 2 );
+      file->close();
+
+      file = MappedFile::create( path, FileSize );
+      test( file.isValid() && file->getSize() == FileSize, "Couldn't create the file again" );
+      if( file.isNull() )
+         return;
+
+      UnitPrint( file->isMapped() ? "File is mapped" : "File is not mapped" );
+
+      // Fill it front to back, as a download does.
+      MRandomLCG random( 3 );
+      U8* data = file->getData();
+      for( U32 i = 0; i < FileSize; ++ i )
+         data[ i ] = random.randI( 0, 255 );
+      U32 crc = CRC::calculateCRC( data, FileSize );
+      test( file->close(), "Couldn't write the file" );
+      test( file->getData() == NULL, "Data still there after close" );
+
+      file = MappedFile::openForRead( path );
+      test( file.isValid() && file->getSize() == FileSize, "Couldn't read the file back" );
+      if( file.isValid() )
+         test( CRC::calculateCRC( file->getData(), file->getSize() ) == crc, "File changed on the way to the disk" );
+      file = NULL;
+
+      // Empty files need no mapping.
+      file = MappedFile::create( path, 0 );
+      test( file.isValid() && file->close(), "Couldn't write an empty file" );
+      file = MappedFile::openForRead( path );
+      test( file.isValid() && file->getSize() == 0, "Couldn't read an empty file" );
+      file = NULL;
+
+      Torque::FS::Remove( path );
+   }
+};
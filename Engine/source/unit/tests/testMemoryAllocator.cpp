@@ -0,0 +1,163 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "platform/threads/threadPool.h"
+#include "core/util/tVector.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Allocates, resizes and frees blocks of assorted sizes from several
+// ThreadPool workers at once, handing blocks between threads, and checks
+// that nothing gets overwritten along the way.  This only reaches the size
+// class allocator in builds that leave TORQUE_DISABLE_MEMORY_MANAGER undefined.
+
+CreateUnitTest( TestMemoryAllocatorThreads, "Platform/Memory/Threads" )
+{
+   enum
+   {
+      NumItems = 16,
+      NumBlocks = 256,
+      NumRounds = 200,
+      MaxBlockSize = 12000
+   };
+
+   struct Block
+   {
+      U8* mMemory;
+      U32 mSize;
+      U8 mFill;
+   };
+
+   // Blocks left over by each item, freed on the main thread so frees also
+   // happen on a different thread than the matching allocs.
+   static Vector< Block > handOff[ NumItems ];
+   static U32 failures;
+
+   static bool checkBlock( const Block& block )
+   {
+      for( U32 i = 0; i < block.mSize; i ++ )
+         if( block.mMemory[ i ] != block.mFill )
+            return false;
+      return true;
+   }
+
+   struct TestItem : public ThreadPool::WorkItem
+   {
+      U32 mIndex;
+
+      TestItem( U32 index )
+         : mIndex( index ) {}
+
+   protected:
+      virtual void execute()
+      {
+         Vector< Block > blocks;
+         U32 seed = mIndex * 2654435761U + 1;
+
+         for( U32 round = 0; round < NumRounds; round ++ )
+         {
+            for( U32 i = 0; i < NumBlocks / 8; i ++ )
+            {
+               seed = seed * 1103515245 + 12345;
+
+               Block block;
+               block.mSize = 1 + ( seed >> 8 ) % MaxBlockSize;
+               block.mFill = U8( seed >> 24 );
+               block.mMemory = ( U8* ) dMalloc( block.mSize );
+               dMemset( block.mMemory, block.mFill, block.mSize );
+               blocks.push_back( block );
+            }
+
+            while( blocks.size() > NumBlocks )
+            {
+               seed = seed * 1103515245 + 12345;
+               U32 index = ( seed >> 8 ) % blocks.size();
+               Block& block = blocks[ index ];
+
+               if( !checkBlock( block ) )
+                  dFetchAndAdd( failures, 1 );
+
+               if( seed & 1 )
+               {
+                  // Resize, keeping the contents.
+                  block.mSize = 1 + ( seed >> 4 ) % MaxBlockSize;
+                  block.mMemory = ( U8* ) dRealloc( block.mMemory, block.mSize );
+                  dMemset( block.mMemory, block.mFill, block.mSize );
+                  if( index & 1 )
+                     continue;
+               }
+
+               dFree( block.mMemory );
+               blocks.erase_fast( index );
+            }
+         }
+
+         handOff[ mIndex ] = blocks;
+      }
+   };
+
+   void run()
+   {
+      failures = 0;
+      ThreadPool* pool = &ThreadPool::GLOBAL();
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 pass = 0; pass < 2; pass ++ )
+      {
+         // Free what the previous pass left behind from this thread.
+         for( U32 i = 0; i < NumItems; i ++ )
+         {
+            for( U32 n = 0; n < handOff[ i ].size(); n ++ )
+            {
+               if( !checkBlock( handOff[ i ][ n ] ) )
+                  failures ++;
+               dFree( handOff[ i ][ n ].mMemory );
+            }
+            handOff[ i ].clear();
+         }
+
+         for( U32 i = 0; i < NumItems; i ++ )
+         {
+            ThreadSafeRef< TestItem > item( new TestItem( i ) );
+            pool->queueWorkItem( item );
+         }
+         pool->flushWorkItems();
+      }
+      U32 elapsed = Platform::getRealMilliseconds() - start;
+
+      for( U32 i = 0; i < NumItems; i ++ )
+      {
+         for( U32 n = 0; n < handOff[ i ].size(); n ++ )
+            dFree( handOff[ i ][ n ].mMemory );
+         handOff[ i ].clear();
+      }
+
+      test( failures == 0, "Memory blocks were overwritten" );
+      UnitPrint( avar( "%d threaded alloc rounds in %dms", NumItems * 2 * NumRounds, elapsed ) );
+   }
+};
+
+Vector< TestMemoryAllocatorThreads::Block > TestMemoryAllocatorThreads::handOff[ TestMemoryAllocatorThreads::NumItems ];
+U32 TestMemoryAllocatorThreads::failures;
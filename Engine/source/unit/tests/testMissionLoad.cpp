@@ -0,0 +1,349 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "T3D/gameBase/gameConnection.h"
+#include "console/simDatablock.h"
+#include "sim/netObject.h"
+#include "core/stream/bitStream.h"
+#include "math/mathIO.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Times how long a client takes from the start of the datablock download to
+// being ready for normal ghosts, with blob transfers off and on.
+//
+// A server and a client GameConnection talk through a simulated link with
+// some latency, on the virtual clock, at the default packet rates.  The
+// server sends its datablocks, which include a batch of test datablocks, and
+// then its ghost always objects, which include a batch of test objects.  The
+// connect to play time and the bytes the server sent are printed for each
+// mode.
+
+class MissionLoadTestData : public SimDataBlock
+{
+   public:
+
+      typedef SimDataBlock Parent;
+
+      String mShapeFile;
+      F32 mMass;
+      F32 mDrag;
+      Point3F mBoxSize;
+      U32 mFlags;
+
+      MissionLoadTestData()
+         : mMass( 1.f ),
+           mDrag( 0.f ),
+           mBoxSize( 1.f, 1.f, 1.f ),
+           mFlags( 0 )
+      {
+      }
+
+      void packData( BitStream* stream )
+      {
+         Parent::packData( stream );
+         stream->writeString( mShapeFile );
+         stream->write( mMass );
+         stream->write( mDrag );
+         mathWrite( *stream, mBoxSize );
+         stream->write( mFlags );
+      }
+
+      void unpackData( BitStream* stream )
+      {
+         Parent::unpackData( stream );
+         mShapeFile = stream->readSTString();
+         stream->read( &mMass );
+         stream->read( &mDrag );
+         mathRead( *stream, &mBoxSize );
+         stream->read( &mFlags );
+      }
+
+      DECLARE_CONOBJECT( MissionLoadTestData );
+};
+
+IMPLEMENT_CO_DATABLOCK_V1( MissionLoadTestData );
+
+ConsoleDocClass( MissionLoadTestData,
+   "@brief Datablock used by the mission load unit test.\n\n"
+   "@internal" );
+
+class MissionLoadTestObject : public NetObject
+{
+   public:
+
+      typedef NetObject Parent;
+
+      MatrixF mTransform;
+      Point3F mScale;
+      String mMaterial;
+
+      MissionLoadTestObject()
+         : mTransform( true ),
+           mScale( 1.f, 1.f, 1.f )
+      {
+         mNetFlags.set( Ghostable | ScopeAlways );
+      }
+
+      U32 packUpdate( NetConnection* connection, U32 mask, BitStream* stream )
+      {
+         mathWrite( *stream, mTransform );
+         mathWrite( *stream, mScale );
+         stream->writeString( mMaterial );
+         return 0;
+      }
+
+      void unpackUpdate( NetConnection* connection, BitStream* stream )
+      {
+         mathRead( *stream, &mTransform );
+         mathRead( *stream, &mScale );
+         mMaterial = stream->readSTString();
+      }
+
+      DECLARE_CONOBJECT( MissionLoadTestObject );
+};
+
+IMPLEMENT_CO_NETOBJECT_V1( MissionLoadTestObject );
+
+ConsoleDocClass( MissionLoadTestObject,
+   "@brief Object used by the mission load unit test.\n\n"
+   "@internal" );
+
+namespace {
+
+   class MissionLoadTestConnection : public GameConnection
+   {
+      public:
+
+         typedef GameConnection Parent;
+
+         struct Packet
+         {
+            U32 mTime;
+            U32 mSize;
+            U8 mData[ Net::MaxPacketDataSize ];
+         };
+
+         MissionLoadTestConnection* mPeer;
+         Vector< Packet* > mInFlight;
+         U32 mLatency;
+         U32 mBytesSent;
+         String mError;
+
+         /// Times the server got to each stage, or 0.
+         U32 mDataBlocksDoneTime;
+         U32 mReadyTime;
+
+         MissionLoadTestConnection( U32 latency )
+            : mPeer( NULL ),
+              mLatency( latency ),
+              mBytesSent( 0 ),
+              mDataBlocksDoneTime( 0 ),
+              mReadyTime( 0 )
+         {
+         }
+
+         ~MissionLoadTestConnection()
+         {
+            for( U32 i = 0; i < mInFlight.size(); ++ i )
+               delete mInFlight[ i ];
+         }
+
+         /// Hold on to the packet until the link latency has passed.
+         Net::Error sendPacket( BitStream* stream )
+         {
+            Packet* packet = new Packet;
+            packet->mTime = Platform::getVirtualMilliseconds() + mLatency;
+            packet->mSize = stream->getPosition();
+            dMemcpy( packet->mData, stream->getBuffer(), packet->mSize );
+            mInFlight.push_back( packet );
+            mBytesSent += packet->mSize;
+            return Net::NoError;
+         }
+
+         /// Hand the packets that have arrived to the other side.
+         void deliverPackets()
+         {
+            U32 time = Platform::getVirtualMilliseconds();
+            while( mInFlight.size() && mInFlight[ 0 ]->mTime <= time )
+            {
+               Packet* packet = mInFlight[ 0 ];
+               mInFlight.pop_front();
+
+               BitStream stream( packet->mData, packet->mSize );
+               mPeer->processRawPacket( &stream );
+               delete packet;
+            }
+         }
+
+         void handleConnectionMessage( U32 message, U32 sequence, U32 ghostCount )
+         {
+            Parent::handleConnectionMessage( message, sequence, ghostCount );
+            if( isConnectionToServer() )
+               return;
+
+            if( message == DataBlocksDownloadDone && !mDataBlocksDoneTime )
+            {
+               mDataBlocksDoneTime = Platform::getVirtualMilliseconds();
+               activateGhosting();
+            }
+            else if( message == ReadyForNormalGhosts && !mReadyTime )
+               mReadyTime = Platform::getVirtualMilliseconds();
+         }
+
+         void connectionError( const char* errorString )
+         {
+            if( mError.isEmpty() )
+               mError = errorString;
+         }
+   };
+}
+
+CreateUnitTest( TestMissionLoad, "Sim/MissionLoad" )
+{
+   enum
+   {
+      NumDataBlocks = 128,
+      NumObjects = 64,
+      Latency = 60,
+      TickMS = 8,
+      MaxTime = 600000,
+   };
+
+   Vector< SimObject* > mObjects;
+
+   void createMission()
+   {
+      static const char* const sShapes[] = { "art/shapes/actors/Soldier/soldier_rigged.dae", "art/shapes/weapons/Lurker/TP_Lurker.dae", "art/shapes/rocks/boulder.dts", "art/shapes/trees/defaulttree/defaulttree.dae" };
+      static const char* const sMaterials[] = { "DefaultDecalRoadMaterial", "Grid512_Grey_Mat", "TerrainFX_grass1", "rock_boulder" };
+
+      MRandomLCG random( 7 );
+      for( U32 i = 0; i < NumDataBlocks; ++ i )
+      {
+         MissionLoadTestData* data = new MissionLoadTestData;
+         data->mShapeFile = sShapes[ random.randI( 0, 3 ) ];
+         data->mMass = random.randF( 1.f, 500.f );
+         data->mDrag = random.randF( 0.f, 1.f );
+         data->mBoxSize.set( random.randF( 0.5f, 4.f ), random.randF( 0.5f, 4.f ), random.randF( 0.5f, 4.f ) );
+         data->mFlags = random.randI( 0, 255 );
+         data->assignId();
+         if( data->registerObject() )
+            mObjects.push_back( data );
+         else
+            delete data;
+      }
+
+      for( U32 i = 0; i < NumObjects; ++ i )
+      {
+         MissionLoadTestObject* object = new MissionLoadTestObject;
+         object->mTransform.setPosition( Point3F( random.randF( -512.f, 512.f ), random.randF( -512.f, 512.f ), random.randF( 0.f, 64.f ) ) );
+         object->mMaterial = sMaterials[ random.randI( 0, 3 ) ];
+         object->registerObject();
+         mObjects.push_back( object );
+      }
+   }
+
+   void deleteMission()
+   {
+      for( U32 i = 0; i < mObjects.size(); ++ i )
+         mObjects[ i ]->deleteObject();
+      mObjects.clear();
+   }
+
+   /// Connect a client and return the virtual milliseconds until it is
+   /// ready for normal ghosts.
+   U32 connect( bool blobs, U32& bytes )
+   {
+      MissionLoadTestConnection* server = new MissionLoadTestConnection( Latency );
+      MissionLoadTestConnection* client = new MissionLoadTestConnection( Latency );
+      server->mPeer = client;
+      client->mPeer = server;
+      server->registerObject();
+      client->registerObject();
+
+      client->setIsConnectionToServer();
+      server->setProtocolVersion( GameConnection::CurrentProtocolVersion );
+      client->setProtocolVersion( GameConnection::CurrentProtocolVersion );
+      server->setBlobTransfer( blobs );
+      client->setBlobTransfer( blobs );
+      server->setSequence( 0 );
+      client->setSequence( 0 );
+      server->checkMaxRate();
+      client->checkMaxRate();
+
+      client->setGhostTo( true );
+      server->setGhostFrom( true );
+
+      U32 start = Platform::getVirtualMilliseconds();
+      Con::executef( server, "transmitDataBlocks", "1" );
+
+      while( !server->mReadyTime && server->mError.isEmpty() && client->mError.isEmpty() &&
+             Platform::getVirtualMilliseconds() - start < MaxTime )
+      {
+         Platform::advanceTime( TickMS );
+         server->deliverPackets();
+         client->deliverPackets();
+         server->checkPacketSend( false );
+         client->checkPacketSend( false );
+      }
+
+      test( server->mReadyTime != 0, avar( "Client never got ready (blobs %s)", blobs ? "on" : "off" ) );
+      test( server->mError.isEmpty() && client->mError.isEmpty(),
+         avar( "Connection error (blobs %s): %s%s", blobs ? "on" : "off", server->mError.c_str(), client->mError.c_str() ) );
+
+      U32 time = server->mReadyTime ? server->mReadyTime - start : MaxTime;
+      bytes = server->mBytesSent;
+      if( server->mDataBlocksDoneTime )
+         UnitPrint( avar( "Blobs %s: datablocks in %d ms, ghost always objects in %d ms, %d bytes",
+            blobs ? "on " : "off", server->mDataBlocksDoneTime - start, server->mReadyTime - server->mDataBlocksDoneTime, bytes ) );
+
+      client->deleteObject();
+      server->deleteObject();
+      return time;
+   }
+
+   void run()
+   {
+      // Keep the blobs off the disk.
+      String cachePath = NetConnection::smBlobCachePath;
+      NetConnection::smBlobCachePath = String();
+
+      createMission();
+
+      U32 eventBytes, blobBytes;
+      U32 eventTime = connect( false, eventBytes );
+      U32 blobTime = connect( true, blobBytes );
+
+      deleteMission();
+      NetConnection::smBlobCachePath = cachePath;
+
+      UnitPrint( avar( "%d ms one way latency", U32( Latency ) ) );
+      UnitPrint( avar( "Events: %d ms to play", eventTime ) );
+      UnitPrint( avar( "Blobs:  %d ms to play", blobTime ) );
+
+      test( blobTime < eventTime, "Blob transfer was slower than events" );
+   }
+};
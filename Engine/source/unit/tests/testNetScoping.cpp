@@ -0,0 +1,193 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneManager.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+#include "unit/tests/netTestFixture.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Times the scoping pass of a headless server with many client connections.
+//
+// A grid of ghostable objects is added to the server scene and a number of fake
+// connections, each with its own camera, write ghost packets against it.  The
+// connections are never connected to anything; every packet is acknowledged
+// right after it is written.  Each tick, a few objects move so the shared scope
+// index has to be rebuilt just like it would on a live server.
+//
+// The scoping results are compared with and without the scope index and the
+// time per tick is printed for both.
+
+CreateUnitTest( TestNetScoping, "Sim/NetScoping" )
+{
+   enum
+   {
+      NumObjects = 4096,
+      NumConnections = 64,
+      NumTicks = 32,
+      NumMovesPerTick = 16,
+      WorldSize = 4096,
+      ScopeDistance = 400,
+   };
+
+   Vector< NetTestObject* > mObjects;
+   Vector< NetTestConnection* > mConnections;
+   Vector< NetTestObject* > mCameras;
+
+   NetTestObject* createObject( const Point3F& pos )
+   {
+      NetTestObject* object = new NetTestObject;
+      object->setPosition( pos );
+      object->registerObject();
+      return object;
+   }
+
+   void createConnections()
+   {
+      for( U32 i = 0; i < NumConnections; ++ i )
+      {
+         NetTestConnection* connection = new NetTestConnection;
+         connection->registerObject();
+         connection->startGhosting();
+         connection->setScopeObject( mCameras[ i ] );
+         mConnections.push_back( connection );
+      }
+   }
+
+   void deleteConnections()
+   {
+      for( U32 i = 0; i < mConnections.size(); ++ i )
+         mConnections[ i ]->deleteObject();
+      mConnections.clear();
+   }
+
+   /// Run all connections for a number of ticks and return the time it took.
+   U32 runTicks( bool useScopeIndex )
+   {
+      SceneManager::smUseScopeIndex = useScopeIndex;
+
+      MRandomLCG random( 2 );
+      U32 start = Platform::getRealMilliseconds();
+
+      for( U32 tick = 0; tick < NumTicks; ++ tick )
+      {
+         for( U32 i = 0; i < NumMovesPerTick; ++ i )
+         {
+            NetTestObject* object = mObjects[ random.randI( 0, NumObjects - 1 ) ];
+            Point3F pos = object->getPosition();
+            pos.z = random.randF( 0.f, 10.f );
+            object->setPosition( pos );
+         }
+
+         for( U32 i = 0; i < mConnections.size(); ++ i )
+            mConnections[ i ]->writeGhostPacket();
+      }
+
+      return Platform::getRealMilliseconds() - start;
+   }
+
+   void run()
+   {
+      const bool savedUseScopeIndex = SceneManager::smUseScopeIndex;
+
+      // Lay out the objects on a jittered grid.
+
+      MRandomLCG random( 3 );
+      const U32 gridSize = U32( mSqrt( F32( NumObjects ) ) );
+      const F32 spacing = WorldSize / F32( gridSize );
+
+      for( U32 i = 0; i < NumObjects; ++ i )
+         mObjects.push_back( createObject( Point3F( ( F32( i % gridSize ) + random.randF() ) * spacing,
+                                                    ( F32( i / gridSize ) + random.randF() ) * spacing,
+                                                    0.f ) ) );
+
+      for( U32 i = 0; i < NumConnections; ++ i )
+      {
+         NetTestObject* camera = createObject( Point3F( random.randF( 0.f, WorldSize ), random.randF( 0.f, WorldSize ), 10.f ) );
+         camera->mVisibleDistance = ScopeDistance;
+         mCameras.push_back( camera );
+      }
+
+      // Scope with the container and with the index from the same
+      // camera positions and compare the results.
+
+      Vector< Vector< SimObjectId > > expected;
+      expected.setSize( NumConnections );
+
+      createConnections();
+      SceneManager::smUseScopeIndex = false;
+      for( U32 i = 0; i < NumConnections; ++ i )
+      {
+         mConnections[ i ]->writeGhostPacket();
+         mConnections[ i ]->getScopedObjects( expected[ i ] );
+      }
+      deleteConnections();
+
+      createConnections();
+      SceneManager::smUseScopeIndex = true;
+      bool allMatch = true;
+      U32 numScoped = 0;
+      for( U32 i = 0; i < NumConnections; ++ i )
+      {
+         Vector< SimObjectId > ids;
+         mConnections[ i ]->writeGhostPacket();
+         mConnections[ i ]->getScopedObjects( ids );
+
+         numScoped += ids.size();
+         if( ids.size() != expected[ i ].size() ||
+             dMemcmp( ids.address(), expected[ i ].address(), ids.memSize() ) != 0 )
+            allMatch = false;
+      }
+      deleteConnections();
+
+      test( numScoped > 0, "No objects were scoped" );
+      test( allMatch, "Scope index gave different results than the container" );
+
+      // Time both paths.
+
+      createConnections();
+      U32 containerTime = runTicks( false );
+      deleteConnections();
+
+      createConnections();
+      U32 indexTime = runTicks( true );
+      deleteConnections();
+
+      UnitPrint( avar( "%i objects, %i connections, %i ticks; %.1f objects in scope per connection",
+         NumObjects, NumConnections, NumTicks, F32( numScoped ) / F32( NumConnections ) ) );
+      UnitPrint( avar( "Container scoping:   %.2f ms/tick", F32( containerTime ) / F32( NumTicks ) ) );
+      UnitPrint( avar( "Scope index scoping: %.2f ms/tick", F32( indexTime ) / F32( NumTicks ) ) );
+
+      for( U32 i = 0; i < mObjects.size(); ++ i )
+         mObjects[ i ]->deleteObject();
+      for( U32 i = 0; i < mCameras.size(); ++ i )
+         mCameras[ i ]->deleteObject();
+      mObjects.clear();
+      mCameras.clear();
+
+      SceneManager::smUseScopeIndex = savedUseScopeIndex;
+   }
+};
+
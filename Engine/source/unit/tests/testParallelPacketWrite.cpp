@@ -0,0 +1,247 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "T3D/item.h"
+#include "T3D/projectile.h"
+#include "scene/sceneManager.h"
+#include "math/mRandom.h"
+#include "platform/threads/threadPool.h"
+#include "unit/test.h"
+#include "unit/tests/netTestFixture.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Checks that packets built on the thread pool match the ones built serially.
+//
+// Two identical sets of fake connections ghost the same objects, one with
+// $pref::Net::ParallelPacketWrite off and one with it on.  The connections
+// drop every packet they send (simulated packet loss of 100%) so the packet
+// can be read back from the send buffer, and then acknowledge it by hand.
+//
+// This is done twice: once with test objects of which half are flagged
+// ThreadSafePack and the other half have to be packed under the lock, and
+// once with real Items and Projectiles, which get the flag from ShapeBase
+// and Projectile.  Every projectile is fired from an item so its initial
+// update refers to another ghost.
+//
+// Every packet of the two runs must be byte for byte the same.  The time
+// per round is printed for both.
+
+CreateUnitTest( TestParallelPacketWrite, "Sim/ParallelPacketWrite" )
+{
+   enum
+   {
+      NumObjects = 2048,
+      NumConnections = 32,
+      NumRounds = 24,
+      NumMovesPerRound = 64,
+      WorldSize = 2048,
+      ScopeDistance = 500,
+   };
+
+   Vector< GameBase* > mObjects;
+   Vector< NetTestObject* > mCameras;
+
+   static Point3F randomPosition( MRandomLCG& random, F32 z )
+   {
+      return Point3F( random.randF( 0.f, WorldSize ), random.randF( 0.f, WorldSize ), z );
+   }
+
+   NetTestObject* createObject( const Point3F& pos, bool threadSafe )
+   {
+      NetTestObject* object = new NetTestObject( threadSafe );
+      object->setPosition( pos );
+      object->registerObject();
+      return object;
+   }
+
+   /// Write a number of packets on fresh connections and collect their CRCs.
+   U32 runRounds( bool parallel, Vector< U32 >& crcs )
+   {
+      NetConnection::smParallelPacketWrite = parallel;
+
+      Vector< NetConnection* > connections;
+      for( U32 i = 0; i < NumConnections; ++ i )
+      {
+         NetTestConnection* connection = new NetTestConnection;
+         connection->registerObject();
+         connection->startGhosting( true );
+         connection->setScopeObject( mCameras[ i ] );
+         connections.push_back( connection );
+      }
+
+      MRandomLCG random( 5 );
+      U32 time = 0;
+      crcs.clear();
+
+      for( U32 round = 0; round < NumRounds; ++ round )
+      {
+         for( U32 i = 0; i < NumMovesPerRound; ++ i )
+         {
+            GameBase* object = mObjects[ random.randI( 0, mObjects.size() - 1 ) ];
+            F32 scale = random.randF( 0.5f, 2.f );
+            object->setScale( VectorF( scale, scale, scale ) );
+
+            Point3F pos = object->getPosition();
+            pos.z = random.randF( 0.f, 10.f );
+            object->setPosition( pos );
+         }
+
+         NetObject::collapseDirtyList();
+
+         U32 start = Platform::getRealMilliseconds();
+         NetConnection::checkPacketSends( connections, true );
+         time += Platform::getRealMilliseconds() - start;
+
+         for( U32 i = 0; i < connections.size(); ++ i )
+         {
+            NetTestConnection* connection = static_cast< NetTestConnection* >( connections[ i ] );
+            crcs.push_back( connection->getPacketCRC() );
+            connection->ackAll();
+         }
+      }
+
+      for( U32 i = 0; i < connections.size(); ++ i )
+         connections[ i ]->deleteObject();
+
+      return time;
+   }
+
+   /// Ghost #mObjects serially and in parallel and compare the packets.
+   void compareRuns( const char* label )
+   {
+      Vector< U32 > serialCRCs;
+      Vector< U32 > parallelCRCs;
+
+      U32 serialTime = runRounds( false, serialCRCs );
+      U32 parallelTime = runRounds( true, parallelCRCs );
+
+      test( serialCRCs.size() == NumConnections * NumRounds,
+            avar( "%s: Not every connection wrote a packet each round", label ) );
+      test( serialCRCs.size() == parallelCRCs.size() &&
+            dMemcmp( serialCRCs.address(), parallelCRCs.address(), serialCRCs.memSize() ) == 0,
+            avar( "%s: Packets written in parallel differ from the serial ones", label ) );
+
+      UnitPrint( avar( "%s: %i objects, %i connections, %i thread pool threads",
+         label, mObjects.size(), NumConnections, ThreadPool::GLOBAL().getNumThreads() ) );
+      UnitPrint( avar( "%s: Serial packet writes:   %.2f ms/round", label, F32( serialTime ) / F32( NumRounds ) ) );
+      UnitPrint( avar( "%s: Parallel packet writes: %.2f ms/round", label, F32( parallelTime ) / F32( NumRounds ) ) );
+   }
+
+   void deleteObjects()
+   {
+      for( U32 i = 0; i < mObjects.size(); ++ i )
+         mObjects[ i ]->deleteObject();
+      mObjects.clear();
+   }
+
+   void testTestObjects()
+   {
+      MRandomLCG random( 7 );
+      for( U32 i = 0; i < NumObjects; ++ i )
+         mObjects.push_back( createObject( randomPosition( random, 0.f ), i & 1 ) );
+
+      compareRuns( "Test objects" );
+      deleteObjects();
+   }
+
+   void testShapes()
+   {
+      String error;
+
+      ItemData* itemData = new ItemData;
+      ProjectileData* projectileData = new ProjectileData;
+      bool dataOk = itemData->registerObject() && itemData->preload( true, error ) &&
+                    projectileData->registerObject() && projectileData->preload( true, error );
+      test( dataOk, "Could not set up the item and projectile datablocks" );
+
+      if( dataOk )
+      {
+         MRandomLCG random( 11 );
+         Vector< Item* > items;
+         for( U32 i = 0; i < NumObjects / 2; ++ i )
+         {
+            Item* item = new Item;
+            item->setDataBlock( itemData );
+            item->setPosition( randomPosition( random, 0.f ) );
+            if( item->registerObject() )
+               items.push_back( item );
+            else
+               delete item;
+         }
+
+         for( U32 i = 0; i < items.size(); ++ i )
+            mObjects.push_back( items[ i ] );
+
+         for( U32 i = 0; i < NumObjects / 2 && !items.empty(); ++ i )
+         {
+            Item* source = items[ random.randI( 0, items.size() - 1 ) ];
+
+            Projectile* projectile = new Projectile;
+            projectile->setDataBlock( projectileData );
+            projectile->setDataField( StringTable->insert( "sourceObject" ), NULL, avar( "%i", source->getId() ) );
+            projectile->setDataField( StringTable->insert( "initialPosition" ), NULL,
+               avar( "%g %g 1", source->getPosition().x, source->getPosition().y ) );
+            projectile->setDataField( StringTable->insert( "initialVelocity" ), NULL,
+               avar( "%g %g 0", random.randF( -10.f, 10.f ), random.randF( -10.f, 10.f ) ) );
+            if( projectile->registerObject() )
+               mObjects.push_back( projectile );
+            else
+               delete projectile;
+         }
+
+         test( mObjects.size() == NumObjects, "Could not add all items and projectiles" );
+         test( items.empty() || ( items[ 0 ]->isThreadSafePack() && mObjects.last()->isThreadSafePack() ),
+               "Items and projectiles should be ThreadSafePack" );
+
+         compareRuns( "Items and projectiles" );
+         deleteObjects();
+      }
+
+      itemData->deleteObject();
+      projectileData->deleteObject();
+   }
+
+   void run()
+   {
+      const bool savedParallel = NetConnection::smParallelPacketWrite;
+
+      MRandomLCG random( 3 );
+      for( U32 i = 0; i < NumConnections; ++ i )
+      {
+         NetTestObject* camera = createObject( randomPosition( random, 10.f ), true );
+         camera->mVisibleDistance = ScopeDistance;
+         mCameras.push_back( camera );
+      }
+
+      testTestObjects();
+      testShapes();
+
+      for( U32 i = 0; i < mCameras.size(); ++ i )
+         mCameras[ i ]->deleteObject();
+      mCameras.clear();
+
+      NetConnection::smParallelPacketWrite = savedParallel;
+   }
+};
@@ -0,0 +1,234 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneContainer.h"
+#include "scene/sceneContainerBinGrid.h"
+#include "math/mRandom.h"
+#include "platform/threads/threadPool.h"
+#include "unit/test.h"
+#include "unit/tests/sceneTestFixture.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Checks that container queries run on the thread pool, each with a
+// SceneQueryContext of its own, find the same objects and hits as the same
+// queries run one after the other on the main thread.
+//
+// The queries run against the AABB tree and against the bin grid, which
+// keeps the objects it has returned in the visited set of the context.  The
+// time of the serial and the parallel runs is printed for both.
+
+namespace {
+
+   /// Queries to run and what they found.
+   struct ParallelQueryBatch
+   {
+      SceneContainer* container;
+      Vector< Box3F > boxes;
+      Vector< Point3F > starts;
+      Vector< Point3F > ends;
+
+      Vector< Vector< SceneObject* > > found;
+      Vector< RayInfo > hits;
+
+      ParallelQueryBatch() : container( NULL ) {}
+   };
+
+   /// Run queries [begin, end) of the ParallelQueryBatch in @a data on a
+   /// context of their own.
+   void runParallelQueries( U32 begin, U32 end, void* data )
+   {
+      ParallelQueryBatch* batch = reinterpret_cast< ParallelQueryBatch* >( data );
+      SceneQueryContext context;
+      for( U32 i = begin; i < end; ++ i )
+      {
+         batch->found[ i ].clear();
+         batch->container->findObjectList( context, batch->boxes[ i ], StaticShapeObjectType, &batch->found[ i ] );
+
+         RayInfo& info = batch->hits[ i ];
+         info.object = NULL;
+         batch->container->castRay( context, batch->starts[ i ], batch->ends[ i ], StaticShapeObjectType, &info );
+      }
+   }
+
+   /// Key of the callback that casts rays from inside a box query.
+   struct ParallelQueryNestedInfo
+   {
+      SceneContainer* container;
+      U32 numHits;
+   };
+}
+
+CreateUnitTest( TestParallelSceneQueries, "Scene/ParallelQueries" )
+{
+   enum
+   {
+      NumObjects = 10000,
+      NumQueries = 4000,
+      MapSize = 4096,
+      QueryChunkSize = 16,
+   };
+
+   typedef SceneTestBox TestObject;
+
+   SceneContainer mContainer;
+   Vector< TestObject* > mObjects;
+
+   Point3F randomPoint( MRandomLCG& random, F32 height )
+   {
+      const F32 halfMap = F32( MapSize ) / 2.f;
+      return Point3F( random.randF( -halfMap, halfMap ), random.randF( -halfMap, halfMap ), random.randF( 0.f, height ) );
+   }
+
+   void populate( ParallelQueryBatch* batch )
+   {
+      MRandomLCG random( 31 );
+
+      for( U32 i = 0; i < NumObjects; ++ i )
+      {
+         Point3F halfSize( random.randF( 0.25f, 8.f ), random.randF( 0.25f, 8.f ), random.randF( 0.5f, 4.f ) );
+         TestObject* object = new TestObject( halfSize );
+
+         MatrixF xform( true );
+         xform.setPosition( randomPoint( random, 20.f ) );
+         object->setTransform( xform );
+
+         mContainer.addObject( object );
+         mObjects.push_back( object );
+      }
+
+      for( U32 i = 0; i < NumQueries; ++ i )
+      {
+         Point3F center = randomPoint( random, 20.f );
+         Point3F extent( random.randF( 5.f, 60.f ), random.randF( 5.f, 60.f ), random.randF( 5.f, 30.f ) );
+         batch->boxes.push_back( Box3F( center - extent, center + extent ) );
+
+         Point3F start = randomPoint( random, 20.f );
+         batch->starts.push_back( start );
+         batch->ends.push_back( start + Point3F( random.randF( -300.f, 300.f ), random.randF( -300.f, 300.f ), random.randF( -10.f, 10.f ) ) );
+      }
+
+      batch->container = &mContainer;
+      batch->found.setSize( NumQueries );
+      batch->hits.setSize( NumQueries );
+   }
+
+   static S32 QSORT_CALLBACK comparePointers( const void* a, const void* b )
+   {
+      const SceneObject* objA = *reinterpret_cast< SceneObject* const* >( a );
+      const SceneObject* objB = *reinterpret_cast< SceneObject* const* >( b );
+      return objA < objB ? -1 : objA > objB ? 1 : 0;
+   }
+
+   /// Run the queries of the batch serially and then in parallel and
+   /// compare the results.
+   void runQueries( ParallelQueryBatch* batch, const char* name )
+   {
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < NumQueries; ++ i )
+      {
+         batch->found[ i ].clear();
+         mContainer.findObjectList( batch->boxes[ i ], StaticShapeObjectType, &batch->found[ i ] );
+
+         batch->hits[ i ].object = NULL;
+         mContainer.castRay( batch->starts[ i ], batch->ends[ i ], StaticShapeObjectType, &batch->hits[ i ] );
+      }
+      U32 serialTime = Platform::getRealMilliseconds() - start;
+
+      Vector< Vector< SceneObject* > > serialFound = batch->found;
+      Vector< RayInfo > serialHits = batch->hits;
+
+      mContainer.setReadOnly( true );
+
+      start = Platform::getRealMilliseconds();
+
+      ThreadPool& pool = ThreadPool::GLOBAL();
+      pool.parallelFor( NumQueries, QueryChunkSize, &runParallelQueries, batch );
+
+      U32 parallelTime = Platform::getRealMilliseconds() - start;
+
+      mContainer.setReadOnly( false );
+
+      UnitPrint( avar( "%s: %d box queries and rays serially in %d ms, on %d threads in %d ms", name,
+         U32( NumQueries ), serialTime, pool.getNumThreads() + 1, parallelTime ) );
+
+      bool sameFound = true;
+      bool sameHits = true;
+      for( U32 i = 0; i < NumQueries; ++ i )
+      {
+         Vector< SceneObject* >& serial = serialFound[ i ];
+         Vector< SceneObject* >& parallel = batch->found[ i ];
+         dQsort( serial.address(), serial.size(), sizeof( SceneObject* ), comparePointers );
+         dQsort( parallel.address(), parallel.size(), sizeof( SceneObject* ), comparePointers );
+         if( serial.size() != parallel.size() ||
+             dMemcmp( serial.address(), parallel.address(), serial.memSize() ) != 0 )
+            sameFound = false;
+
+         if( serialHits[ i ].object != batch->hits[ i ].object ||
+             ( serialHits[ i ].object && !mIsEqual( serialHits[ i ].t, batch->hits[ i ].t ) ) )
+            sameHits = false;
+      }
+
+      test( sameFound, avar( "%s: Parallel box queries found different objects", name ) );
+      test( sameHits, avar( "%s: Parallel rays hit different objects", name ) );
+   }
+
+   static void nestedCallback( SceneObject* object, void* key )
+   {
+      ParallelQueryNestedInfo* info = reinterpret_cast< ParallelQueryNestedInfo* >( key );
+
+      const Box3F& box = object->getWorldBox();
+      RayInfo ri;
+      if( info->container->castRay( box.minExtents - Point3F( 1.f, 1.f, 1.f ), box.getCenter(), StaticShapeObjectType, &ri ) )
+         info->numHits ++;
+   }
+
+   void run()
+   {
+      ParallelQueryBatch batch;
+      populate( &batch );
+
+      runQueries( &batch, "Tree" );
+
+      mContainer.setIndex( new SceneContainerBinGrid );
+      runQueries( &batch, "Grid" );
+
+      // Queries without a context can nest, since each takes a context of
+      // its own.  A ray cast at each object found must hit something.
+      ParallelQueryNestedInfo info;
+      info.container = &mContainer;
+      info.numHits = 0;
+      Vector< SceneObject* > found;
+      mContainer.findObjectList( batch.boxes[ 0 ], StaticShapeObjectType, &found );
+      mContainer.findObjects( batch.boxes[ 0 ], StaticShapeObjectType, nestedCallback, &info );
+      test( info.numHits == found.size(), "Rays cast from inside a box query missed" );
+
+      for( U32 i = 0; i < mObjects.size(); ++ i )
+      {
+         mContainer.removeObject( mObjects[ i ] );
+         delete mObjects[ i ];
+      }
+      mObjects.clear();
+   }
+};
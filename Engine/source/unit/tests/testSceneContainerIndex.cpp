@@ -0,0 +1,307 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneContainer.h"
+#include "scene/sceneContainerAABBTree.h"
+#include "scene/sceneContainerBinGrid.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+#include "unit/tests/sceneTestFixture.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Fills a container with a large, dense map and runs the same box queries
+// and ray casts against it with the AABB tree and with the bin grid.  Both
+// must find the same objects.  The time each index takes for the queries and
+// for moving a share of the objects around is printed.
+//
+// Batches of rays are also cast one at a time and all at once, which must
+// give the same hits, and the rays per second of each are printed.
+
+namespace {
+
+   struct ContainerIndexTestRay
+   {
+      Point3F mStart;
+      Point3F mEnd;
+   };
+
+   struct ContainerIndexTestResult
+   {
+      Vector< Vector< SceneObject* > > mFound;
+      Vector< SceneObject* > mHit;
+      Vector< F32 > mT;
+   };
+}
+
+CreateUnitTest( TestSceneContainerIndex, "Scene/ContainerIndex" )
+{
+   enum
+   {
+      NumObjects = 20000,
+      NumLargeObjects = 200,
+      NumQueries = 2000,
+      NumMoveTicks = 100,
+      NumBatchRays = 4096,
+      NumPellets = 16,
+      MapSize = 8192,
+   };
+
+   typedef SceneTestBox TestObject;
+   typedef ContainerIndexTestRay Ray;
+   typedef ContainerIndexTestResult Result;
+
+   SceneContainer mContainer;
+   Vector< TestObject* > mObjects;
+   Vector< Box3F > mBoxes;
+   Vector< Ray > mRays;
+
+   Point3F randomPoint( MRandomLCG& random, F32 height )
+   {
+      const F32 halfMap = F32( MapSize ) / 2.f;
+      return Point3F( random.randF( -halfMap, halfMap ), random.randF( -halfMap, halfMap ), random.randF( 0.f, height ) );
+   }
+
+   void place( TestObject* object, const Point3F& position )
+   {
+      MatrixF xform( true );
+      xform.setPosition( position );
+      object->setTransform( xform );
+   }
+
+   void populate()
+   {
+      MRandomLCG random( 21 );
+
+      for( U32 i = 0; i < NumObjects; ++ i )
+      {
+         Point3F halfSize;
+         if( i < NumLargeObjects )
+            halfSize.set( random.randF( 50.f, 300.f ), random.randF( 50.f, 300.f ), random.randF( 10.f, 50.f ) );
+         else
+            halfSize.set( random.randF( 0.25f, 4.f ), random.randF( 0.25f, 4.f ), random.randF( 0.5f, 4.f ) );
+
+         TestObject* object = new TestObject( halfSize );
+         place( object, randomPoint( random, 20.f ) );
+         mContainer.addObject( object );
+         mObjects.push_back( object );
+      }
+
+      for( U32 i = 0; i < NumQueries; ++ i )
+      {
+         Point3F center = randomPoint( random, 20.f );
+         Point3F extent( random.randF( 5.f, 100.f ), random.randF( 5.f, 100.f ), random.randF( 5.f, 50.f ) );
+         mBoxes.push_back( Box3F( center - extent, center + extent ) );
+
+         Ray ray;
+         ray.mStart = randomPoint( random, 20.f );
+         ray.mEnd = ray.mStart + Point3F( random.randF( -500.f, 500.f ), random.randF( -500.f, 500.f ), random.randF( -10.f, 10.f ) );
+         mRays.push_back( ray );
+      }
+   }
+
+   void runQueries( Result& result, const char* name )
+   {
+      result.mFound.setSize( mBoxes.size() );
+      result.mHit.clear();
+      result.mT.clear();
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < mBoxes.size(); ++ i )
+      {
+         result.mFound[ i ].clear();
+         mContainer.findObjectList( mBoxes[ i ], StaticShapeObjectType, &result.mFound[ i ] );
+      }
+      U32 boxTime = Platform::getRealMilliseconds() - start;
+
+      start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < mRays.size(); ++ i )
+      {
+         RayInfo info;
+         if( mContainer.castRay( mRays[ i ].mStart, mRays[ i ].mEnd, StaticShapeObjectType, &info ) )
+         {
+            result.mHit.push_back( info.object );
+            result.mT.push_back( info.t );
+         }
+         else
+         {
+            result.mHit.push_back( NULL );
+            result.mT.push_back( 2.f );
+         }
+      }
+      U32 rayTime = Platform::getRealMilliseconds() - start;
+
+      UnitPrint( avar( "%s: %d box queries in %d ms, %d rays in %d ms", name,
+         mBoxes.size(), boxTime, mRays.size(), rayTime ) );
+
+      for( U32 i = 0; i < result.mFound.size(); ++ i )
+         dQsort( result.mFound[ i ].address(), result.mFound[ i ].size(), sizeof( SceneObject* ), comparePointers );
+   }
+
+   static S32 QSORT_CALLBACK comparePointers( const void* a, const void* b )
+   {
+      const SceneObject* objA = *reinterpret_cast< SceneObject* const* >( a );
+      const SceneObject* objB = *reinterpret_cast< SceneObject* const* >( b );
+      return objA < objB ? -1 : objA > objB ? 1 : 0;
+   }
+
+   void compare( const Result& tree, const Result& grid )
+   {
+      bool sameFound = true;
+      for( U32 i = 0; i < tree.mFound.size() && sameFound; ++ i )
+      {
+         sameFound = tree.mFound[ i ].size() == grid.mFound[ i ].size();
+         for( U32 j = 0; j < tree.mFound[ i ].size() && sameFound; ++ j )
+            sameFound = tree.mFound[ i ][ j ] == grid.mFound[ i ][ j ];
+      }
+      test( sameFound, "Box queries found different objects" );
+
+      bool sameHits = true;
+      for( U32 i = 0; i < tree.mHit.size() && sameHits; ++ i )
+         sameHits = tree.mHit[ i ] == grid.mHit[ i ] && mIsEqual( tree.mT[ i ], grid.mT[ i ] );
+      test( sameHits, "Rays hit different objects" );
+   }
+
+   U32 move( U32 seed )
+   {
+      // Push a tenth of the objects around a little each tick, the way
+      // players and vehicles move.
+      MRandomLCG random( seed );
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 tick = 0; tick < NumMoveTicks; ++ tick )
+      {
+         for( U32 i = NumLargeObjects; i < mObjects.size(); i += 10 )
+         {
+            TestObject* object = mObjects[ i ];
+            Point3F step( random.randF( -0.5f, 0.5f ), random.randF( -0.5f, 0.5f ), 0.f );
+            place( object, object->getPosition() + step );
+            mContainer.updateObject( object );
+         }
+      }
+      return Platform::getRealMilliseconds() - start;
+   }
+
+   void testBatchedRays( const char* name )
+   {
+      // Half the rays are shotgun blasts of pellets spreading out from one
+      // muzzle, the rest line of sight checks between random spots.
+      MRandomLCG random( 17 );
+      Vector< Point3F > starts;
+      Vector< Point3F > ends;
+      while( starts.size() < NumBatchRays / 2 )
+      {
+         Point3F muzzle = randomPoint( random, 10.f );
+         Point3F aim( random.randF( -1.f, 1.f ), random.randF( -1.f, 1.f ), random.randF( -0.1f, 0.1f ) );
+         aim.normalizeSafe();
+         for( U32 i = 0; i < NumPellets; ++ i )
+         {
+            Point3F spread( random.randF( -0.05f, 0.05f ), random.randF( -0.05f, 0.05f ), random.randF( -0.05f, 0.05f ) );
+            starts.push_back( muzzle );
+            ends.push_back( muzzle + ( aim + spread ) * 200.f );
+         }
+      }
+      while( starts.size() < NumBatchRays )
+      {
+         Point3F from = randomPoint( random, 10.f );
+         starts.push_back( from );
+         ends.push_back( from + Point3F( random.randF( -300.f, 300.f ), random.randF( -300.f, 300.f ), random.randF( -5.f, 5.f ) ) );
+      }
+
+      Vector< RayInfo > single;
+      single.setSize( NumBatchRays );
+      U32 start = Platform::getRealMilliseconds();
+      U32 singleHits = 0;
+      for( U32 i = 0; i < NumBatchRays; ++ i )
+      {
+         single[ i ].object = NULL;
+         if( mContainer.castRay( starts[ i ], ends[ i ], StaticShapeObjectType, &single[ i ] ) )
+            singleHits ++;
+      }
+      U32 singleTime = getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+
+      Vector< RayInfo > batched;
+      batched.setSize( NumBatchRays );
+      start = Platform::getRealMilliseconds();
+      U32 batchedHits = mContainer.castRays( NumBatchRays, starts.address(), ends.address(), StaticShapeObjectType, batched.address() );
+      U32 batchedTime = getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+
+      UnitPrint( avar( "%s: castRay %.0f rays/s, castRays %.0f rays/s", name,
+         F32( NumBatchRays ) * 1000.f / F32( singleTime ), F32( NumBatchRays ) * 1000.f / F32( batchedTime ) ) );
+
+      bool same = singleHits == batchedHits;
+      for( U32 i = 0; i < NumBatchRays && same; ++ i )
+      {
+         same = single[ i ].object == batched[ i ].object;
+         if( same && single[ i ].object )
+            same = mIsEqual( single[ i ].t, batched[ i ].t ) && single[ i ].normal.equal( batched[ i ].normal );
+      }
+      test( same, avar( "%s: castRays and castRay disagree", name ) );
+   }
+
+   void run()
+   {
+      populate();
+
+      SceneContainerAABBTree* tree = dynamic_cast< SceneContainerAABBTree* >( mContainer.getIndex() );
+      test( tree != NULL, "Containers don't start out with a tree" );
+      if( tree )
+         UnitPrint( avar( "%d objects in a tree of height %d", mObjects.size(), tree->getHeight() ) );
+
+      Result treeResult;
+      Result gridResult;
+
+      runQueries( treeResult, "Tree" );
+      testBatchedRays( "Tree" );
+      U32 treeMoveTime = move( 1 );
+
+      mContainer.setIndex( new SceneContainerBinGrid );
+      U32 gridMoveTime = move( 2 );
+      runQueries( gridResult, "Grid" );
+      testBatchedRays( "Grid" );
+
+      mContainer.setIndex( new SceneContainerAABBTree );
+      runQueries( treeResult, "Tree after moves" );
+      compare( treeResult, gridResult );
+
+      UnitPrint( avar( "Moving %d objects for %d ticks: tree %d ms, grid %d ms",
+         ( mObjects.size() - NumLargeObjects ) / 10, U32( NumMoveTicks ), treeMoveTime, gridMoveTime ) );
+
+      // Objects moved while in the tree must be found where they are now.
+      move( 3 );
+      Result movedTree;
+      runQueries( movedTree, "Tree after refits" );
+      mContainer.setIndex( new SceneContainerBinGrid );
+      Result movedGrid;
+      runQueries( movedGrid, "Grid after refits" );
+      compare( movedTree, movedGrid );
+
+      for( U32 i = 0; i < mObjects.size(); ++ i )
+      {
+         mContainer.removeObject( mObjects[ i ] );
+         delete mObjects[ i ];
+      }
+      mObjects.clear();
+   }
+};
@@ -0,0 +1,263 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/util/tVector.h"
+#include "scene/culling/sceneOcclusionBuffer.h"
+#include "math/util/frustum.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Rasterizes occluders into a SceneOcclusionBuffer and checks which boxes it
+// finds to be hidden.  Besides a few boxes placed around a wall, random
+// boxes are tested behind random occluder triangles, and every box the
+// buffer finds occluded is checked by casting rays from the camera to
+// points of the box that are in view; all of them must hit an occluder to
+// within a pixel.
+// Rasterizing on the thread pool must give the same buffer as rasterizing
+// on the main thread.
+
+CreateUnitTest( TestSceneOcclusionBuffer, "Scene/OcclusionBuffer" )
+{
+   enum
+   {
+      NumCameras = 8,
+      NumOccluders = 12,
+      NumBoxes = 400,
+      NumSamplesPerBox = 32,
+   };
+
+   Frustum mFrustum;
+
+   void setCamera( const MatrixF& transform )
+   {
+      // Same aspect ratio as the buffer.
+      mFrustum.set( false, -0.1f, 0.1f, 0.05f, -0.05f, 0.1f, 1000.f, transform );
+   }
+
+   void addQuad( SceneOcclusionBuffer& buffer, F32 y, F32 minX, F32 maxX, F32 minZ, F32 maxZ )
+   {
+      const Point3F points[ 4 ] =
+      {
+         Point3F( minX, y, minZ ),
+         Point3F( maxX, y, minZ ),
+         Point3F( maxX, y, maxZ ),
+         Point3F( minX, y, maxZ )
+      };
+
+      buffer.addPolygon( points, 4 );
+   }
+
+   void testWall()
+   {
+      setCamera( MatrixF( true ) );
+
+      SceneOcclusionBuffer buffer( mFrustum );
+      addQuad( buffer, 10.f, -5.f, 5.f, -2.f, 2.f );
+      buffer.rasterize();
+
+      test( buffer.isOccluded( Box3F( Point3F( -1.f, 20.f, -1.f ), Point3F( 1.f, 21.f, 1.f ) ) ),
+         "Box behind the wall should be occluded" );
+      test( !buffer.isOccluded( Box3F( Point3F( -1.f, 5.f, -1.f ), Point3F( 1.f, 6.f, 1.f ) ) ),
+         "Box in front of the wall should not be occluded" );
+      test( !buffer.isOccluded( Box3F( Point3F( -1.f, 9.f, -1.f ), Point3F( 1.f, 11.f, 1.f ) ) ),
+         "Box reaching through the wall should not be occluded" );
+      test( !buffer.isOccluded( Box3F( Point3F( 8.f, 20.f, -1.f ), Point3F( 12.f, 21.f, 1.f ) ) ),
+         "Box sticking out from behind the wall should not be occluded" );
+      test( !buffer.isOccluded( Box3F( Point3F( -1.f, 0.f, -1.f ), Point3F( 1.f, 30.f, 1.f ) ) ),
+         "Box reaching the near plane should not be occluded" );
+   }
+
+   /// Return true if the segment from @a start to @a end passes through the
+   /// triangle @a a, @a b, @a c.
+   static bool segmentHitsTriangle( const Point3F& start, const Point3F& end,
+                                    const Point3F& a, const Point3F& b, const Point3F& c )
+   {
+      const Point3F dir = end - start;
+      const Point3F edge1 = b - a;
+      const Point3F edge2 = c - a;
+
+      const Point3F p = mCross( dir, edge2 );
+      const F32 det = mDot( edge1, p );
+      if( mFabs( det ) < 1e-12f )
+         return false;
+
+      const F32 invDet = 1.f / det;
+      const Point3F s = start - a;
+      const F32 u = mDot( s, p ) * invDet;
+      if( u < 0.f || u > 1.f )
+         return false;
+
+      const Point3F q = mCross( s, edge1 );
+      const F32 v = mDot( dir, q ) * invDet;
+      if( v < 0.f || u + v > 1.f )
+         return false;
+
+      const F32 t = mDot( edge2, q ) * invDet;
+      return ( t > 0.f && t < 1.f );
+   }
+
+   /// Return true if the ray from the camera to @a point, or to a point
+   /// a pixel away from it on screen, hits one of the occluder triangles.
+   /// The buffer only resolves occluders to a pixel, so points in cracks
+   /// between occluders that are thinner than that may be found hidden.
+   bool isNearlyHidden( const Point3F& point, const Vector< Point3F >& triangles )
+   {
+      const MatrixF& transform = mFrustum.getTransform();
+      const Point3F& position = mFrustum.getPosition();
+
+      const F32 nearWidth = mFrustum.getNearRight() - mFrustum.getNearLeft();
+      const F32 depth = mDot( point - position, transform.getForwardVector() );
+      const F32 pixelSize = depth * nearWidth / mFrustum.getNearDist() / F32( SceneOcclusionBuffer::Width );
+
+      const Point3F right = transform.getRightVector() * pixelSize;
+      const Point3F up = transform.getUpVector() * pixelSize;
+
+      const Point3F targets[ 5 ] = { point, point + right, point - right, point + up, point - up };
+
+      for( U32 i = 0; i < 5; ++ i )
+         for( U32 t = 0; t < triangles.size(); t += 3 )
+            if( segmentHitsTriangle( position, targets[ i ], triangles[ t ], triangles[ t + 1 ], triangles[ t + 2 ] ) )
+               return true;
+
+      return false;
+   }
+
+   void testRandom()
+   {
+      MRandomLCG random( 3 );
+
+      U32 numOccluded = 0;
+      U32 numVisibleSamples = 0;
+
+      for( U32 camera = 0; camera < NumCameras; ++ camera )
+      {
+         MatrixF transform;
+         transform.set( EulerF( random.randF( -0.5f, 0.5f ), 0.f, random.randF( 0.f, M_2PI_F ) ),
+                        Point3F( random.randF( -100.f, 100.f ), random.randF( -100.f, 100.f ), random.randF( 0.f, 50.f ) ) );
+         setCamera( transform );
+
+         // Occluder triangles in front of the camera.
+
+         Vector< Point3F > triangles;
+         for( U32 i = 0; i < NumOccluders * 3; ++ i )
+         {
+            Point3F point( random.randF( -15.f, 15.f ), random.randF( 5.f, 30.f ), random.randF( -8.f, 8.f ) );
+            transform.mulP( point );
+            triangles.push_back( point );
+         }
+
+         SceneOcclusionBuffer buffer( mFrustum );
+         buffer.addTriangles( triangles.address(), NumOccluders );
+         buffer.rasterize();
+
+         for( U32 n = 0; n < NumBoxes; ++ n )
+         {
+            const Point3F center( random.randF( -40.f, 40.f ), random.randF( 5.f, 80.f ), random.randF( -20.f, 20.f ) );
+            const Point3F halfSize( random.randF( 0.1f, 3.f ), random.randF( 0.1f, 3.f ), random.randF( 0.1f, 3.f ) );
+
+            // Keep the box axis-aligned in world space.
+
+            Point3F worldCenter;
+            transform.mulP( center, &worldCenter );
+            const Box3F box( worldCenter - halfSize, worldCenter + halfSize );
+
+            if( !buffer.isOccluded( box ) )
+               continue;
+
+            numOccluded ++;
+
+            for( U32 i = 0; i < NumSamplesPerBox; ++ i )
+            {
+               Point3F sample;
+               if( i < 8 )
+                  sample = box.computeVertex( i );
+               else
+                  sample.set( random.randF( box.minExtents.x, box.maxExtents.x ),
+                              random.randF( box.minExtents.y, box.maxExtents.y ),
+                              random.randF( box.minExtents.z, box.maxExtents.z ) );
+
+               // Only points in view need to be hidden.
+
+               if( mFrustum.isCulled( Box3F( sample, sample ) ) )
+                  continue;
+
+               numVisibleSamples ++;
+
+               test( isNearlyHidden( sample, triangles ),
+                  "Point of a box found to be occluded is not hidden behind an occluder" );
+            }
+         }
+      }
+
+      test( numOccluded > 0 && numVisibleSamples > 0, "No boxes were found to be occluded" );
+      UnitPrint( avar( "%d of %d boxes occluded", numOccluded, U32( NumCameras * NumBoxes ) ) );
+   }
+
+   void testWorker()
+   {
+      MatrixF transform;
+      transform.set( EulerF( 0.2f, 0.f, 1.f ), Point3F( 10.f, -20.f, 5.f ) );
+      setCamera( transform );
+
+      ThreadSafeRef< SceneOcclusionBuffer > mainBuffer( new SceneOcclusionBuffer( mFrustum ) );
+      ThreadSafeRef< SceneOcclusionBuffer > workerBuffer( new SceneOcclusionBuffer( mFrustum ) );
+
+      MRandomLCG random( 7 );
+      for( U32 i = 0; i < NumOccluders; ++ i )
+      {
+         Point3F points[ 3 ];
+         for( U32 n = 0; n < 3; ++ n )
+         {
+            points[ n ].set( random.randF( -15.f, 15.f ), random.randF( -5.f, 30.f ), random.randF( -8.f, 8.f ) );
+            transform.mulP( points[ n ] );
+         }
+
+         mainBuffer->addTriangles( points, 1 );
+         workerBuffer->addTriangles( points, 1 );
+      }
+
+      mainBuffer->rasterize();
+
+      workerBuffer->beginRasterize();
+      test( !workerBuffer->isOpen(), "Buffer should not take occluders once rasterization is queued" );
+      workerBuffer->finishRasterize();
+      test( workerBuffer->isRasterized(), "Buffer should be rasterized after finishRasterize()" );
+
+      bool same = true;
+      for( U32 y = 0; y < SceneOcclusionBuffer::Height; ++ y )
+         for( U32 x = 0; x < SceneOcclusionBuffer::Width; ++ x )
+            same &= ( mainBuffer->getDepth( x, y ) == workerBuffer->getDepth( x, y ) );
+
+      test( same, "Buffer rasterized on the thread pool differs" );
+   }
+
+   void run()
+   {
+      testWall();
+      testRandom();
+      testWorker();
+   }
+};
@@ -0,0 +1,89 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "console/console.h"
+#include "core/strings/stringFunctions.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Times script-to-script calls with numeric arguments and return values.
+//
+// The "typed" loop passes numbers straight through the interpreter stack. The
+// "string" loop forces every argument and return value through a string, the
+// way every call went before the stack carried typed values, so the two
+// numbers printed are a before/after comparison on the same build.
+
+CreateUnitTest( TestScriptCallPerformance, "Console/ScriptCallPerformance" )
+{
+   enum
+   {
+      CallsPerLoop = 1000,
+      LoopCount = 200
+   };
+
+   F64 timeLoop( const char* function )
+   {
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < LoopCount; i ++ )
+         Con::executef( function, Con::getIntArg( CallsPerLoop ) );
+      U32 elapsed = getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+
+      return F64( CallsPerLoop * LoopCount ) * 1000.0 / F64( elapsed );
+   }
+
+   void run()
+   {
+      Con::evaluate(
+         "function _utScriptCallAdd( %a, %b ) { return %a + %b; }"
+         "function _utScriptCallId( %obj ) { return %obj; }"
+         "function _utScriptCallTyped( %count )"
+         "{"
+         "   %sum = 0;"
+         "   for( %i = 0; %i < %count; %i ++ )"
+         "      %sum += _utScriptCallAdd( %i, 0.5 );"
+         "   return %sum;"
+         "}"
+         "function _utScriptCallString( %count )"
+         "{"
+         "   %sum = 0;"
+         "   for( %i = 0; %i < %count; %i ++ )"
+         "      %sum += _utScriptCallAdd( %i @ \"\", 0.5 @ \"\" ) @ \"\";"
+         "   return %sum;"
+         "}" );
+
+      // Both paths must agree, and numbers must still read back as strings.
+      test( !dStrcmp( Con::evaluate( "return _utScriptCallAdd( 2, 0.5 );" ), "2.5" ), "Typed return value formatted incorrectly" );
+      test( !dStrcmp( Con::evaluate( "return _utScriptCallId( 1 + 2 );" ), "3" ), "Typed argument formatted incorrectly" );
+      test( !dStrcmp( Con::evaluate( "return strlen( 10 * 10 );" ), "3" ), "Typed argument not formatted for engine function" );
+      test( !dStrcmp( Con::executef( "_utScriptCallTyped", "1000" ), "500000" ), "Typed call loop gave the wrong result" );
+      test( !dStrcmp( Con::executef( "_utScriptCallString", "1000" ), "500000" ), "String call loop gave the wrong result" );
+
+      F64 stringRate = timeLoop( "_utScriptCallString" );
+      F64 typedRate = timeLoop( "_utScriptCallTyped" );
+
+      UnitPrint( avar( "String arguments: %.0f calls/sec", stringRate ) );
+      UnitPrint( avar( "Typed arguments:  %.0f calls/sec", typedRate ) );
+   }
+};
@@ -0,0 +1,176 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "platform/threads/threadPool.h"
+#include "console/console.h"
+#include "console/compiler.h"
+#include "core/volume.h"
+#include "core/strings/stringFunctions.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Compiles the game's scripts once on the main thread and once on ThreadPool
+// workers and checks that both produce the same DSOs.  The times printed
+// compare a cold serial compile with a cold parallel one.
+
+CreateUnitTest( TestScriptCompileParallel, "Console/ScriptCompile/Parallel" )
+{
+   enum
+   {
+      MaxScripts = 128
+   };
+
+   struct CompileEntry
+   {
+      const char* mScript;
+      StringTableEntry mFileName;
+      String mDSOName;
+      bool mResult;
+      bool mOnWorker;
+      Vector< Compiler::Diagnostic > mDiagnostics;
+   };
+
+   static void compileEntries( U32 begin, U32 end, void* data )
+   {
+      Vector< CompileEntry >& entries = *static_cast< Vector< CompileEntry >* >( data );
+      for( U32 i = begin; i < end; i ++ )
+      {
+         CodeBlock* code = new CodeBlock();
+         entries[ i ].mResult = code->compile( entries[ i ].mDSOName, entries[ i ].mFileName, entries[ i ].mScript );
+         entries[ i ].mOnWorker = !Con::isMainThread();
+         delete code;
+
+         Compiler::takeDiagnostics( entries[ i ].mDiagnostics );
+      }
+
+      if( !Con::isMainThread() )
+         Compiler::freeThreadState();
+   }
+
+   String getDSOName( U32 index, const char* kind )
+   {
+      return String::ToString( "%s/_utScriptCompile%i.%s.dso", Platform::getCurrentDirectory(), index, kind );
+   }
+
+   bool sameFile( const String& a, const String& b )
+   {
+      void* dataA = NULL;
+      void* dataB = NULL;
+      U32 sizeA = 0;
+      U32 sizeB = 0;
+      Torque::FS::ReadFile( a, dataA, sizeA );
+      Torque::FS::ReadFile( b, dataB, sizeB );
+
+      bool same = dataA && dataB && sizeA == sizeB && dMemcmp( dataA, dataB, sizeA ) == 0;
+      delete [] static_cast< char* >( dataA );
+      delete [] static_cast< char* >( dataB );
+      return same;
+   }
+
+   void run()
+   {
+      Vector< String > fileNames;
+      Torque::FS::FindByPattern( Torque::Path( Platform::getMainDotCsDir() ), "*.cs", true, fileNames );
+
+      Vector< char* > scripts;
+      Vector< StringTableEntry > names;
+      for( U32 i = 0; i < fileNames.size() && scripts.size() < MaxScripts; i ++ )
+      {
+         void* data = NULL;
+         U32 size = 0;
+         if( !Torque::FS::ReadFile( fileNames[ i ], data, size, true ) || !data )
+            continue;
+
+         scripts.push_back( static_cast< char* >( data ) );
+         names.push_back( StringTable->insert( fileNames[ i ] ) );
+      }
+
+      // Always have a script with a syntax error and one with a compiler
+      // warning in the mix.  They have to behave on a worker just like they
+      // do on the main thread.
+      const char* badScript = "function _utScriptCompileBad( %a ) { return %a +; }";
+      const char* warnScript = "function _utScriptCompileWarn() { break; }";
+
+      U32 serialStart = Platform::getRealMilliseconds();
+      Vector< bool > serialResults;
+      for( U32 i = 0; i < scripts.size(); i ++ )
+      {
+         CodeBlock* code = new CodeBlock();
+         serialResults.push_back( code->compile( getDSOName( i, "serial" ), names[ i ], scripts[ i ] ) );
+         delete code;
+      }
+      U32 serialTime = Platform::getRealMilliseconds() - serialStart;
+
+      Vector< CompileEntry > entries;
+      for( U32 i = 0; i < scripts.size() + 2; i ++ )
+      {
+         entries.increment();
+         CompileEntry& entry = entries.last();
+         entry.mScript = i < scripts.size() ? scripts[ i ] : ( i == scripts.size() ? badScript : warnScript );
+         entry.mFileName = i < scripts.size() ? names[ i ] : StringTable->insert( avar( "_utScriptCompile%i.cs", i ) );
+         entry.mDSOName = getDSOName( i, "parallel" );
+         entry.mResult = false;
+         entry.mOnWorker = false;
+      }
+
+      U32 parallelStart = Platform::getRealMilliseconds();
+      ThreadPool::GLOBAL().parallelFor( entries.size(), 1, &compileEntries, &entries );
+      U32 parallelTime = Platform::getRealMilliseconds() - parallelStart;
+
+      bool allMatch = true;
+      for( U32 i = 0; i < scripts.size(); i ++ )
+      {
+         allMatch &= entries[ i ].mResult == serialResults[ i ];
+         if( serialResults[ i ] )
+            allMatch &= sameFile( getDSOName( i, "serial" ), getDSOName( i, "parallel" ) );
+      }
+      test( allMatch, "Scripts compiled on workers differ from scripts compiled on the main thread" );
+      test( !entries[ scripts.size() ].mResult, "Syntax error not reported by a parallel compile" );
+
+      // Warnings are printed straight away on the main thread but have to be
+      // held back on workers.
+      const CompileEntry& warnEntry = entries.last();
+      test( warnEntry.mResult, "Script with a warning failed to compile" );
+      if( warnEntry.mOnWorker )
+         test( warnEntry.mDiagnostics.size() == 1 && dStrstr( warnEntry.mDiagnostics[ 0 ].message.c_str(), "break outside of loop" ),
+            "Compiler warning on a worker was not held back" );
+      else
+         test( warnEntry.mDiagnostics.empty(), "Compiler warning on the main thread was held back" );
+
+      // The main thread's compiler state must not have been disturbed.
+      test( !dStrcmp( Con::evaluate( "return 1 + 2;" ), "3" ), "Main thread compile broken after parallel compiles" );
+
+      UnitPrint( avar( "Compiled %i scripts: %i ms serial, %i ms on the thread pool",
+         scripts.size(), serialTime, parallelTime ) );
+
+      for( U32 i = 0; i < entries.size(); i ++ )
+      {
+         dFileDelete( getDSOName( i, "serial" ) );
+         dFileDelete( getDSOName( i, "parallel" ) );
+      }
+      for( U32 i = 0; i < scripts.size(); i ++ )
+         delete [] scripts[ i ];
+   }
+};
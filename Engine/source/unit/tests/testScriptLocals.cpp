@@ -0,0 +1,101 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "platform/platform.h"
+#include "console/console.h"
+#include "console/consoleInternal.h"
+#include "core/strings/stringFunctions.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+extern ExprEvalState gEvalState;
+
+//-----------------------------------------------------------------------------
+// Hooks into the frame of the calling script function.
+
+ConsoleFunction( _utLocalsFrameExport, const char*, 2, 2, "( pattern )" )
+{
+   Vector< String > names;
+   Vector< String > values;
+   gEvalState.getCurrentFrame().exportVariables( argv[ 1 ], &names, &values );
+
+   String result;
+   for( U32 i = 0; i < names.size(); ++ i )
+      result += String::ToString( "%s%s=%s", i ? " " : "", names[ i ].c_str(), values[ i ].c_str() );
+
+   char* ret = Con::getReturnBuffer( result.length() + 1 );
+   dStrcpy( ret, result.c_str() );
+   return ret;
+}
+
+ConsoleFunction( _utLocalsFrameDelete, void, 2, 2, "( pattern )" )
+{
+   gEvalState.getCurrentFrame().deleteVariables( argv[ 1 ] );
+}
+
+ConsoleFunction( _utLocalsFrameComplete, const char*, 2, 2, "( prefix )" )
+{
+   const char* match = gEvalState.getCurrentFrame().tabComplete( argv[ 1 ], dStrlen( argv[ 1 ] ), true );
+   return match ? match : "";
+}
+
+//-----------------------------------------------------------------------------
+// Locals of script functions live in frame slots; make sure everything that
+// still goes by name (eval, isDefined, array access) sees the same variables.
+
+CreateUnitTest( TestScriptLocals, "Console/ScriptLocals" )
+{
+   void run()
+   {
+      Con::evaluate(
+         "function _utLocalsEval() { %a = 1; eval( \"%a++; %b = 5;\" ); return %a SPC %b; }"
+         "function _utLocalsDefined() { %r = isDefined( \"%x\" ); %x = \"\"; return %r SPC isDefined( \"%x\" ); }"
+         "function _utLocalsArray() { %v0 = \"plain\"; %w[ 1 ] = \"array\"; return %v[ 0 ] SPC %w1; }"
+         "function _utLocalsDupArg( %a, %a ) { return %a; }"
+         "function _utLocalsRecurse( %n ) { if( %n <= 1 ) return 1; %m = _utLocalsRecurse( %n - 1 ); return %n * %m; }"
+         "function _utLocalsForeach( %s ) { foreach$( %w in %s ) %r = %r @ %w; return %r; }"
+         "function _utLocalsExport( %a, %a ) { %count = 3; if( %unset ) %count = 0; %h[ 0 ] = \"x\"; return _utLocalsFrameExport( \"%*\" ); }"
+         "function _utLocalsComplete() { %counter = 1; %hashed[ 0 ] = 2; return _utLocalsFrameComplete( \"%cou\" ) SPC _utLocalsFrameComplete( \"%has\" ); }"
+         "function _utLocalsDelete() { %keep = 1; %drop = 2; _utLocalsFrameDelete( \"%dr*\" ); return %keep SPC isDefined( \"%drop\" ); }"
+         "function _utLocalsLoop( %count ) { %sum = 0; for( %i = 0; %i < %count; %i ++ ) %sum += %i; return %sum; }" );
+
+      test( !dStrcmp( Con::executef( "_utLocalsEval" ), "2 5" ), "eval did not see the frame's locals" );
+      test( !dStrcmp( Con::executef( "_utLocalsDefined" ), "0 1" ), "isDefined wrong for a local" );
+      test( !dStrcmp( Con::executef( "_utLocalsArray" ), "plain array" ), "Array access does not alias plain locals" );
+      test( !dStrcmp( Con::executef( "_utLocalsDupArg", "1", "2" ), "2" ), "Repeated argument name should refer to the last argument" );
+      test( !dStrcmp( Con::executef( "_utLocalsRecurse", "5" ), "120" ), "Recursive calls clobbered locals" );
+      test( !dStrcmp( Con::executef( "_utLocalsForeach", "a b c" ), "abc" ), "foreach$ variable not a local" );
+      test( !dStrcmp( Con::executef( "_utLocalsExport", "1", "2" ), "%a=2 %count=3 %h0=x" ), "Exporting a frame missed or misreported its locals" );
+      test( !dStrcmp( Con::executef( "_utLocalsComplete" ), "%counter %hashed0" ), "Tab completion did not see the frame's locals" );
+      test( !dStrcmp( Con::executef( "_utLocalsDelete" ), "1 0" ), "deleteVariables did not clear a local" );
+
+      test( !dStrcmp( Con::executef( "_utLocalsLoop", "1000" ), "499500" ), "Loop gave the wrong result" );
+
+      U32 start = Platform::getRealMilliseconds();
+      Con::executef( "_utLocalsLoop", "1000000" );
+      U32 elapsed = Platform::getRealMilliseconds() - start;
+
+      UnitPrint( avar( "1000000 loop iterations over locals: %i ms", elapsed ) );
+   }
+};
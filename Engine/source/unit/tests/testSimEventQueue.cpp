@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "console/simBase.h"
+#include "console/simEvents.h"
+#include "core/util/tVector.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Checks the ordering rules of the Sim event queue and times posting and
+// cancelling a large number of events.
+
+namespace
+{
+   class TestSimEvent : public SimEvent
+   {
+   public:
+      Vector< U32 >* mLog;
+      U32 mTag;
+
+      TestSimEvent( Vector< U32 >* log, U32 tag )
+         : mLog( log ), mTag( tag ) {}
+
+      virtual void process( SimObject* object )
+      {
+         mLog->push_back( mTag );
+      }
+   };
+}
+
+CreateUnitTest( TestSimEventQueueOrder, "Console/SimEventQueue/Order" )
+{
+   void run()
+   {
+      SimObject* object = new SimObject;
+      object->registerObject();
+
+      Vector< U32 > log;
+      const SimTime now = Sim::getCurrentTime();
+
+      // Events due at the same time must run in posting order.
+      for( U32 i = 0; i < 100; i ++ )
+         Sim::postEvent( object, new TestSimEvent( &log, i ), i & 1 ? -1 : now );
+
+      // Later events must run after earlier ones regardless of posting order.
+      Sim::postEvent( object, new TestSimEvent( &log, 1002 ), now + 2 );
+      Sim::postEvent( object, new TestSimEvent( &log, 1001 ), now + 1 );
+      U32 cancelled = Sim::postEvent( object, new TestSimEvent( &log, 9999 ), now + 1 );
+
+      test( Sim::isEventPending( cancelled ), "Posted event should be pending" );
+      test( Sim::getEventTimeLeft( cancelled ) == 1, "Wrong time left on posted event" );
+      Sim::cancelEvent( cancelled );
+      test( !Sim::isEventPending( cancelled ), "Cancelled event should not be pending" );
+
+      Sim::advanceToTime( now );
+      test( log.size() == 100, "Wrong number of events run for the current time" );
+      bool inOrder = true;
+      for( U32 i = 0; i < log.size(); i ++ )
+         inOrder &= log[ i ] == i;
+      test( inOrder, "Events due at the same time ran out of posting order" );
+
+      Sim::advanceToTime( now + 2 );
+      test( log.size() == 102 && log[ 100 ] == 1001 && log[ 101 ] == 1002, "Later events ran in the wrong order" );
+
+      U32 pending = Sim::postEvent( object, new TestSimEvent( &log, 0 ), Sim::getCurrentTime() + 10 );
+      object->deleteObject();
+      test( !Sim::isEventPending( pending ), "Deleting an object should cancel its events" );
+   }
+};
+
+CreateUnitTest( TestSimEventQueueStress, "Console/SimEventQueue/Stress" )
+{
+   enum
+   {
+      EventCount = 1000000
+   };
+
+   void run()
+   {
+      // Not registered; events only need a destination to post against.
+      SimObject* objects[ 2 ];
+      objects[ 0 ] = new SimObject;
+      objects[ 1 ] = new SimObject;
+
+      Vector< U32 > log;
+      Vector< U32 > ids;
+      ids.setSize( EventCount );
+
+      const SimTime now = Sim::getCurrentTime();
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < EventCount; i ++ )
+         ids[ i ] = Sim::postEvent( objects[ i & 1 ], new TestSimEvent( &log, i ), now + 1 + ( ( i * 7919 ) % 10000 ) );
+      U32 postTime = Platform::getRealMilliseconds() - start;
+
+      // Cancel every event on the first object individually, in an order
+      // unrelated to their due times.
+      start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < EventCount; i += 2 )
+         Sim::cancelEvent( ids[ ( i * 3 ) % EventCount & ~1 ] );
+      U32 cancelTime = Platform::getRealMilliseconds() - start;
+
+      bool allCancelled = true;
+      for( U32 i = 0; i < EventCount; i += 2 )
+         allCancelled &= !Sim::isEventPending( ids[ i ] );
+      test( allCancelled, "Cancelled events are still pending" );
+      test( Sim::isEventPending( ids[ 1 ] ), "Event on another object was cancelled" );
+
+      start = Platform::getRealMilliseconds();
+      Sim::cancelPendingEvents( objects[ 1 ] );
+      U32 cancelObjectTime = Platform::getRealMilliseconds() - start;
+
+      test( !Sim::isEventPending( ids[ EventCount - 1 ] ), "cancelPendingEvents left an event behind" );
+
+      Sim::advanceToTime( now + 10000 );
+      test( log.empty(), "Cancelled events were processed" );
+
+      UnitPrint( avar( "Posted %d events in %dms", EventCount, postTime ) );
+      UnitPrint( avar( "Cancelled %d events by id in %dms", EventCount / 2, cancelTime ) );
+      UnitPrint( avar( "Cancelled %d events by object in %dms", EventCount / 2, cancelObjectTime ) );
+
+      delete objects[ 0 ];
+      delete objects[ 1 ];
+   }
+};
@@ -0,0 +1,143 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "platform/platform.h"
+#include "console/simDictionary.h"
+#include "console/simObject.h"
+#include "console/sim.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Measures SimIdDictionary::find() throughput at different object counts.
+//
+// The dictionary keeps the id of every entry in the table itself, so a
+// single unregistered object re-id'd before each insert stands in for the
+// whole population.
+
+CreateUnitTest( TestSimIdDictionary, "Console/SimIdDictionary" )
+{
+   enum
+   {
+      FirstId = 5000,
+      QueryCount = 1 << 16,
+      FindCount = 4000000
+   };
+
+   SimObject* mObject;
+   Vector< S32 > mQueries;
+
+   void fill( SimIdDictionary& dict, U32 count )
+   {
+      for( U32 i = 0; i < count; i ++ )
+      {
+         mObject->setId( FirstId + i );
+         dict.insert( mObject );
+      }
+   }
+
+   void testFind( U32 count )
+   {
+      SimIdDictionary dict;
+      fill( dict, count );
+
+      test( dict.size() == count, "Wrong object count" );
+      test( dict.find( FirstId ) == mObject, "First id not found" );
+      test( dict.find( FirstId + count - 1 ) == mObject, "Last id not found" );
+      test( dict.find( FirstId + count ) == NULL, "Found an id that was never inserted" );
+      test( dict.find( 0 ) == NULL, "Found id 0" );
+
+      MRandomLCG rand( 1 );
+      for( U32 i = 0; i < QueryCount; i ++ )
+         mQueries[ i ] = FirstId + rand.randI( 0, count - 1 );
+
+      U32 found = 0;
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < FindCount; i ++ )
+         found += dict.find( mQueries[ i & ( QueryCount - 1 ) ] ) != NULL;
+      U32 elapsed = getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+
+      test( found == FindCount, "Lookup of an inserted id failed" );
+      UnitPrint( avar( "%7i objects: %.1f million finds/sec", count, F64( FindCount ) / F64( elapsed ) / 1000.0 ) );
+   }
+
+   void testRemove()
+   {
+      SimIdDictionary dict;
+      fill( dict, 10000 );
+
+      // Remove every other object, then churn through more ids than the
+      // table holds so it has to rebuild over its removed slots.
+      for( U32 i = 0; i < 10000; i += 2 )
+      {
+         mObject->setId( FirstId + i );
+         dict.remove( mObject );
+      }
+      for( U32 i = 0; i < 100000; i ++ )
+      {
+         mObject->setId( FirstId + 20000 + i );
+         dict.insert( mObject );
+         dict.remove( mObject );
+      }
+
+      test( dict.size() == 5000, "Wrong object count after removal" );
+      test( dict.find( FirstId ) == NULL, "Found a removed id" );
+      test( dict.find( FirstId + 1 ) == mObject, "Lost an id after rebuilding" );
+      test( dict.find( FirstId + 9999 ) == mObject, "Lost an id after rebuilding" );
+   }
+
+   void testExtremeIds()
+   {
+      // The root group's id is all bits set; it must be stored like any other.
+      SimIdDictionary dict;
+      fill( dict, 100 );
+
+      mObject->setId( RootGroupId );
+      dict.insert( mObject );
+      test( dict.find( RootGroupId ) == mObject, "Root group id not found" );
+      test( dict.size() == 101, "Wrong object count with root group id" );
+
+      dict.remove( mObject );
+      test( dict.find( RootGroupId ) == NULL, "Found the root group id after removing it" );
+
+      dict.insert( mObject );
+      test( dict.find( RootGroupId ) == mObject, "Root group id not found after reinserting it" );
+      test( dict.find( FirstId + 99 ) == mObject, "Lost an id next to the root group id" );
+   }
+
+   void run()
+   {
+      mObject = new SimObject;
+      mQueries.setSize( QueryCount );
+
+      testExtremeIds();
+      testRemove();
+      testFind( 10000 );
+      testFind( 100000 );
+      testFind( 1000000 );
+
+      delete mObject;
+   }
+};
@@ -0,0 +1,164 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/stream/stringCoder.h"
+#include "core/stream/bitStream.h"
+#include "core/stream/memStream.h"
+#include "core/strings/stringFunctions.h"
+#include "math/mRandom.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+//-----------------------------------------------------------------------------
+// Trains a StringDictionary on made up mission load traffic and checks that
+// strings survive a trip through it.
+//
+// The strings look like what a server sends while a mission loads: datablock
+// names, shape and texture paths, commandToClient tags and chat.  The
+// dictionary is trained on one batch and measured on another, and the sizes
+// with the built-in Huffman table and with the dictionary are printed.
+
+CreateUnitTest( TestStringDictionary, "Core/StringDictionary" )
+{
+   MRandomLCG mRandom;
+
+   String pick( const char* const* list, U32 count )
+   {
+      return list[ mRandom.randI( 0, count - 1 ) ];
+   }
+
+   String makeString()
+   {
+      static const char* const sKinds[] = { "Player", "Vehicle", "Weapon", "Ammo", "Item", "Explosion", "Debris", "Projectile", "Particle", "Emitter" };
+      static const char* const sNames[] = { "Default", "Heavy", "Light", "Rocket", "Lurker", "Ryder", "Cheetah", "Soldier", "Grenade", "Health" };
+      static const char* const sDirs[] = { "art/shapes/actors/", "art/shapes/weapons/", "art/shapes/items/", "art/particles/", "art/decals/" };
+      static const char* const sExts[] = { ".dts", ".dae", ".png", ".dds", ".jpg" };
+      static const char* const sCommands[] = { "ServerMessage", "ChatMessage", "MissionStartPhase1", "MissionStartPhase2", "SyncClock", "SetLoadingText" };
+      static const char* const sChat[] = { "gg", "nice shot", "where are you", "follow me", "need health", "on my way" };
+
+      #define PICK( list ) pick( list, sizeof( list ) / sizeof( list[ 0 ] ) )
+
+      switch( mRandom.randI( 0, 4 ) )
+      {
+         case 0:
+            return PICK( sNames ) + PICK( sKinds ) + "Data";
+         case 1:
+            return PICK( sDirs ) + PICK( sNames ) + "/" + PICK( sNames ) + PICK( sExts );
+         case 2:
+            return PICK( sCommands );
+         case 3:
+            return String::ToString( "%s: %s", PICK( sNames ).c_str(), PICK( sChat ).c_str() );
+         default:
+            return String::ToString( "%s%s%d", PICK( sNames ).c_str(), PICK( sKinds ).c_str(), mRandom.randI( 0, 999 ) );
+      }
+
+      #undef PICK
+   }
+
+   /// Bits it takes to write string with coder.
+   U32 getBits( const StringCoder* coder, const char* string )
+   {
+      U8 buffer[ 512 ];
+      BitStream stream( buffer, sizeof( buffer ) );
+      stream.setStringCoder( coder );
+      stream.writeString( string );
+      return stream.getCurPos();
+   }
+
+   bool roundTrip( const StringCoder* coder, const char* string, S32 maxLen = 255 )
+   {
+      U8 buffer[ 512 ];
+      BitStream stream( buffer, sizeof( buffer ) );
+      stream.setStringCoder( coder );
+      stream.writeString( string, maxLen );
+      stream.writeInt( 0x5A, 8 );
+      U32 written = stream.getCurPos();
+
+      char result[ 256 ];
+      stream.setPosition( 0 );
+      stream.setStringCoder( coder );
+      stream.readString( result );
+
+      return dStrncmp( result, string, maxLen ) == 0 &&
+             dStrlen( result ) == getMin( dStrlen( string ), dsize_t( maxLen ) ) &&
+             stream.readInt( 8 ) == 0x5A &&
+             stream.getCurPos() == written;
+   }
+
+   void run()
+   {
+      Map< String, U32 > training;
+      for( U32 i = 0; i < 20000; ++ i )
+         training[ makeString() ] ++;
+
+      StringDictionary* dict = StringDictionary::train( training );
+      test( dict->getNumWords() > 0, "No words in the trained dictionary" );
+
+      // Save and load it again.
+      MemStream file( 64 * 1024 );
+      test( dict->write( file ), "Failed to write the dictionary" );
+      file.setPosition( 0 );
+      StringDictionary loaded;
+      test( loaded.read( file ), "Failed to read the dictionary back" );
+      test( loaded.getCRC() == dict->getCRC(), "Dictionary changed when saved and loaded" );
+
+      // Measure on strings it wasn't trained on.
+      U64 rawBits = 0;
+      U64 huffBits = 0;
+      U64 dictBits = 0;
+      bool ok = true;
+      for( U32 i = 0; i < 5000; ++ i )
+      {
+         String string = makeString();
+         rawBits += ( string.length() + 1 ) * 8;
+         huffBits += getBits( NULL, string );
+         dictBits += getBits( &loaded, string );
+         ok &= roundTrip( &loaded, string );
+      }
+      test( ok, "Strings came back wrong" );
+
+      // Strings that have nothing to do with the training.
+      ok = roundTrip( &loaded, "" );
+      ok &= roundTrip( &loaded, "DefaultPlayerData", 7 );
+      for( U32 i = 0; i < 1000; ++ i )
+      {
+         char string[ 256 ];
+         U32 len = mRandom.randI( 0, 255 );
+         for( U32 j = 0; j < len; ++ j )
+            string[ j ] = mRandom.randI( 1, 255 );
+         string[ len ] = '\0';
+         ok &= roundTrip( &loaded, string );
+      }
+      test( ok, "Random strings came back wrong" );
+
+      test( dictBits < huffBits, "Dictionary did worse than the built-in Huffman table" );
+
+      UnitPrint( avar( "%d words", loaded.getNumWords() ) );
+      UnitPrint( avar( "Plain:      %d bytes", U32( rawBits / 8 ) ) );
+      UnitPrint( avar( "Huffman:    %d bytes (%.1f%%)", U32( huffBits / 8 ), 100.0 * F64( huffBits ) / F64( rawBits ) ) );
+      UnitPrint( avar( "Dictionary: %d bytes (%.1f%%)", U32( dictBits / 8 ), 100.0 * F64( dictBits ) / F64( rawBits ) ) );
+
+      delete dict;
+   }
+};
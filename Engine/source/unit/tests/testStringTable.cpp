@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/stringTable.h"
+#include "core/volume.h"
+#include "core/util/tVector.h"
+#include "core/strings/stringFunctions.h"
+#include "unit/test.h"
+
+using namespace UnitTesting;
+
+namespace
+{
+   /// A private table, so tests start empty and don't fill the global one.
+   class TestStringTable : public _StringTable
+   {
+   public:
+      TestStringTable() {}
+      ~TestStringTable() {}
+   };
+}
+
+//-----------------------------------------------------------------------------
+
+CreateUnitTest( TestStringTableBasics, "Core/StringTable/Basics" )
+{
+   void run()
+   {
+      TestStringTable table;
+
+      StringTableEntry foo = table.insert( "Foo" );
+      StringTableEntry fooSens = table.insert( "foo", true );
+
+      test( !dStrcmp( foo, "Foo" ), "Inserted string changed" );
+      test( table.insert( "FOO" ) == foo, "Case insensitive insert should find the first match" );
+      test( fooSens != foo && !dStrcmp( fooSens, "foo" ), "Case sensitive insert should add a new entry" );
+      test( table.insert( "foo", true ) == fooSens, "Case sensitive insert should find the exact match" );
+      test( table.lookup( "fOO" ) == foo, "Case insensitive lookup should find the first match" );
+      test( table.lookup( "fOO", true ) == NULL, "Case sensitive lookup found the wrong case" );
+      test( table.lookupn( "FooBar", 3 ) == foo, "lookupn ignored the length" );
+      test( table.insertn( "fooBar", 3, true ) == fooSens, "insertn ignored the length" );
+      test( table.insert( NULL ) == table.insert( "" ), "NULL should insert as the empty string" );
+
+      // Entries must stay put while the table grows.
+      enum { Count = 100000 };
+      Vector< StringTableEntry > entries;
+      char buffer[ 64 ];
+      for( U32 i = 0; i < Count; i ++ )
+      {
+         dSprintf( buffer, sizeof( buffer ), "entry%d", i );
+         entries.push_back( table.insert( buffer ) );
+      }
+
+      bool stable = table.insert( "foo" ) == foo && table.insert( "foo", true ) == fooSens;
+      for( U32 i = 0; i < Count; i ++ )
+      {
+         dSprintf( buffer, sizeof( buffer ), "ENTRY%d", i );
+         stable &= table.lookup( buffer ) == entries[ i ];
+      }
+      test( stable, "Entries moved or went missing as the table grew" );
+   }
+};
+
+//-----------------------------------------------------------------------------
+// Times inserts and lookups of the identifiers found in the game's scripts.
+
+CreateUnitTest( TestStringTablePerformance, "Core/StringTable/Performance" )
+{
+   enum
+   {
+      LookupPasses = 20
+   };
+
+   struct Token
+   {
+      const char* mString;
+      U32 mLength;
+   };
+
+   static bool isIdentStart( char c )
+   {
+      return dIsalpha( c ) || c == '_';
+   }
+
+   static bool isIdentChar( char c )
+   {
+      return dIsalnum( c ) || c == '_';
+   }
+
+   void run()
+   {
+      Vector< String > fileNames;
+      Torque::FS::FindByPattern( Torque::Path( Platform::getMainDotCsDir() ), "*.cs", true, fileNames );
+
+      Vector< char* > buffers;
+      Vector< Token > tokens;
+      for( U32 i = 0; i < fileNames.size(); i ++ )
+      {
+         void* data = NULL;
+         U32 size = 0;
+         if( !Torque::FS::ReadFile( fileNames[ i ], data, size, true ) || !data )
+            continue;
+
+         char* text = ( char* ) data;
+         buffers.push_back( text );
+
+         for( char* c = text; *c; )
+         {
+            if( !isIdentStart( *c ) )
+            {
+               c ++;
+               continue;
+            }
+
+            Token token;
+            token.mString = c;
+            while( isIdentChar( *c ) )
+               c ++;
+            token.mLength = c - token.mString;
+            tokens.push_back( token );
+         }
+      }
+
+      if( tokens.empty() )
+      {
+         UnitPrint( "No script identifiers found; skipping timings." );
+         return;
+      }
+
+      TestStringTable table;
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < tokens.size(); i ++ )
+         table.insertn( tokens[ i ].mString, tokens[ i ].mLength );
+      U32 insertTime = Platform::getRealMilliseconds() - start;
+
+      U32 found = 0;
+      start = Platform::getRealMilliseconds();
+      for( U32 pass = 0; pass < LookupPasses; pass ++ )
+         for( U32 i = 0; i < tokens.size(); i ++ )
+            found += table.lookupn( tokens[ i ].mString, tokens[ i ].mLength ) != NULL;
+      U32 lookupTime = Platform::getRealMilliseconds() - start;
+
+      test( found == tokens.size() * LookupPasses, "Inserted identifiers not found" );
+
+      start = Platform::getRealMilliseconds();
+      for( U32 pass = 0; pass < LookupPasses; pass ++ )
+         for( U32 i = 0; i < tokens.size(); i ++ )
+            table.insertn( tokens[ i ].mString, tokens[ i ].mLength, true );
+      U32 caseSensTime = Platform::getRealMilliseconds() - start;
+
+      UnitPrint( avar( "%d identifiers from %d scripts", tokens.size(), buffers.size() ) );
+      UnitPrint( avar( "First insert: %dms", insertTime ) );
+      UnitPrint( avar( "%d lookups: %dms", tokens.size() * LookupPasses, lookupTime ) );
+      UnitPrint( avar( "%d case sensitive inserts: %dms", tokens.size() * LookupPasses, caseSensTime ) );
+
+      for( U32 i = 0; i < buffers.size(); i ++ )
+         delete [] buffers[ i ];
+   }
+};
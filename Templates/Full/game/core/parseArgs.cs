@@ -309,6 +309,11 @@ function defaultParseArgs()
             $compileTools = true;
             $argUsed[$i]++;
 
+         //-------------------
+         case "-precompile":
+            $precompileScripts = true;
+            $argUsed[$i]++;
+
          //-------------------
          case "-genScript":
             $genScript = true;
@@ -158,6 +158,14 @@ if($compileTools)
    quit();
 }
 
+if($precompileScripts)
+{
+   // Bring every DSO up to date on worker threads before the execs below
+   // compile them one at a time.
+   echo(" --- Compiling scripts in parallel ---");
+   echo(" --- Compiled " @ precompileScripts() @ " scripts ---");
+}
+
 package Help {
    function onExit() {
       // Override onExit when displaying help
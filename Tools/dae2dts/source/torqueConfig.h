@@ -125,6 +125,17 @@
 /// memory corruption issues quickly.
 //#define TORQUE_DEBUG_GUARD
 
+/// Define me if you want the memory manager to serve every block from its
+/// tree allocator.
+///
+/// Only matters once TORQUE_DISABLE_MEMORY_MANAGER above is removed; this
+/// config leaves the memory manager off and uses the CRT heap. With the
+/// manager on, blocks of up to 8K come from size classes cached per thread,
+/// which avoids serializing allocations from different threads. This is
+/// always off when TORQUE_DEBUG_GUARD is defined, as guard checks and leak
+/// tracking need the tree allocator.
+//#define TORQUE_MEMORY_TREE_ALLOCATOR
+
 /// Define me if you want to enable instanced-static behavior
 //#define TORQUE_ENABLE_THREAD_STATICS
 